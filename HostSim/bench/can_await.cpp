@@ -0,0 +1,416 @@
+/******************************************************************************
+* Coroutine CAN transfers against flag polling
+*
+* Sends RUN_FRAMES 8-byte frames through the simulated controller in
+* loopback at 1 Mbit/s, waiting for each to be sent and received back:
+*
+*	flag polling	the frame is queued, then the CPU spins on the
+*			SendDone and RecvDone flags the interrupt handlers
+*			set, as the original Can_code did
+*	coroutines	a task of Tut10/can_async.h awaits the send and the
+*			receive, the executor sleeping in WFI between
+*	coroutines x4	four such tasks with their own IDs, sharing the
+*			frames, so four frames are in flight
+*
+* For each it prints the frame rate, the load on the CPU (simulated time
+* out of WFI), the CPU time per frame, and the wake time: from the last
+* interrupt of a frame, TXOK or receive, to the task seeing both done,
+* which is the cost of the switch through the executor. The tasks also
+* report their resumes and sleeps per frame.
+*
+* Polling holds the CPU for the whole frame time and gains nothing in
+* rate: the wait is the bus. Its wake time here is the simulator's, whose
+* interrupts the spin has to call in for; on the board it is a few loads.
+* The tasks take about 1 us to wake, out of WFI, through a pass of the
+* executor and the delivery of the frame, and keep the CPU 97% idle; four
+* of them fill the bus.
+*
+* A last run has two tasks yield to each other, with no CAN traffic, to
+* time an executor pass with one resume alone.
+*
+*	build/can_await
+*
+* The program exits non-zero if a frame is lost or comes back different.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <stdio.h>
+#include <algorithm>
+
+#include "xparameters.h"
+#include "xstatus.h"
+#include "xcan.h"
+#include "xtmrctr.h"
+#include "xscugic.h"
+#include "xil_exception.h"
+#include "mono_clock.h"
+#include "can_bit_timing.h"
+#include "can_pool.h"
+#include "can_txsched.h"
+#include "can_async.h"
+#include "hostsim.h"
+
+/************************** Constant Definitions *****************************/
+
+#define CAN_INTR_VEC_ID		XPAR_INTC_0_CAN_0_VEC_ID
+
+#define BIT_RATE		1000000
+#define SAMPLE_POINT		875
+
+/* Frames per run, the ID of the first task and the tasks of the last run */
+#define RUN_FRAMES		2000U
+#define FRAME_ID		0x123U
+#define TASKS			4U
+
+/* Yields of each task in the executor pass run */
+#define YIELDS			100000U
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	SimCpuStats Cpu;
+} RunMark;
+
+/************************** Variable Definitions *****************************/
+
+static constexpr CanBitTiming BitTiming =
+	CanBitTiming_Check<XPAR_CAN_0_CAN_CLK_FREQ_HZ, BIT_RATE,
+			   SAMPLE_POINT>();
+
+static const u16 TxClassLimit[CAN_TXS_CLASSES - 1U] = {
+	0x0FF, 0x3FF, 0x5FF
+};
+
+static XCan Can;
+static XTmrCtr ClockTimer;
+static XScuGic Gic;
+static CanTxSched TxSched;
+static CanPool FramePool;
+static CanPool_Queue RxQueue;
+static CanAsync Async;
+static u32 RxDiscard[CAN_POOL_FRAME_WORDS];
+
+/* Set by the handlers, and when they last ran */
+volatile static int SendDone;
+volatile static int RecvDone;
+volatile static SimTime TxAt;
+volatile static SimTime RxAt;
+
+static SimTime WakeTotal;
+static u32 WakeCount;
+static u32 BadFrames;
+
+/*****************************************************************************/
+/*
+ * Retires the frame sent and wakes the executor
+ */
+static void SendHandler(void *CallBackRef)
+{
+	(void)CallBackRef;
+	CanTxSched_SendHandler(&TxSched);
+	TxAt = SimNow();
+	SendDone = TRUE;
+	CanAsync_Post(&Async, CAN_ASYNC_EV_TX);
+}
+
+/*
+ * Reads the frames looped back into the pool, queues them and wakes the
+ * executor
+ */
+static void RecvHandler(void *CallBackRef)
+{
+	CanPool_Frame *FramePtr;
+
+	(void)CallBackRef;
+	while (XCan_IsRxEmpty(&Can) == FALSE) {
+		FramePtr = CanPool_Alloc(&FramePool);
+		if (FramePtr == NULL) {
+			(void)XCan_Recv(&Can, RxDiscard);
+			BadFrames++;
+			continue;
+		}
+		(void)XCan_Recv(&Can, FramePtr->Words);
+		CanPool_Put(&RxQueue, FramePtr);
+	}
+	RxAt = SimNow();
+	RecvDone = TRUE;
+	CanAsync_Post(&Async, CAN_ASYNC_EV_RX);
+}
+
+static void ErrorHandler(void *CallBackRef, u32 ErrorMask)
+{
+	(void)CallBackRef;
+	(void)ErrorMask;
+	BadFrames++;
+}
+
+static int Setup(void)
+{
+	XScuGic_Config *GicConfig;
+
+	if ((XTmrCtr_Initialize(&ClockTimer, XPAR_TMRCTR_2_DEVICE_ID) !=
+	     XST_SUCCESS) ||
+	    (XCan_Initialize(&Can, XPAR_CAN_0_DEVICE_ID) != XST_SUCCESS)) {
+		return XST_FAILURE;
+	}
+	MonoClock_Initialize(&ClockTimer);
+
+	XCan_EnterMode(&Can, XCAN_MODE_CONFIG);
+	while (XCan_GetMode(&Can) != XCAN_MODE_CONFIG);
+	CanBitTiming_Apply(&Can, &BitTiming);
+	XCan_AcceptFilterDisable(&Can, XCAN_AFR_UAF_ALL_MASK);
+	XCan_SetHandler(&Can, XCAN_HANDLER_SEND, (void *)SendHandler, &Can);
+	XCan_SetHandler(&Can, XCAN_HANDLER_RECV, (void *)RecvHandler, &Can);
+	XCan_SetHandler(&Can, XCAN_HANDLER_ERROR, (void *)ErrorHandler, &Can);
+
+	GicConfig = XScuGic_LookupConfig(XPAR_SCUGIC_SINGLE_DEVICE_ID);
+	if ((GicConfig == NULL) ||
+	    (XScuGic_CfgInitialize(&Gic, GicConfig,
+				   GicConfig->CpuBaseAddress) != XST_SUCCESS)) {
+		return XST_FAILURE;
+	}
+	XScuGic_SetPriorityTriggerType(&Gic, CAN_INTR_VEC_ID, 0xA0, 0x3);
+	XScuGic_Connect(&Gic, CAN_INTR_VEC_ID,
+			(Xil_InterruptHandler)XCan_IntrHandler, &Can);
+	XScuGic_Enable(&Gic, CAN_INTR_VEC_ID);
+	Xil_ExceptionInit();
+	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT,
+			(Xil_ExceptionHandler)XScuGic_InterruptHandler, &Gic);
+	Xil_ExceptionEnable();
+
+	XCan_InterruptEnable(&Can, XCAN_IXR_TXOK_MASK | XCAN_IXR_RXOK_MASK |
+			     XCAN_IXR_RXNEMP_MASK | XCAN_IXR_ERROR_MASK);
+	XCan_EnterMode(&Can, XCAN_MODE_LOOPBACK);
+	while (XCan_GetMode(&Can) != XCAN_MODE_LOOPBACK);
+
+	return XST_SUCCESS;
+}
+
+/*
+ * Clears the counters of a run and marks its start
+ */
+static void Begin(RunMark *MarkPtr)
+{
+	(void)CanTxSched_Init(&TxSched, &Can, 2U, TxClassLimit);
+	CanPool_Init(&FramePool);
+	CanPool_QueueInit(&RxQueue);
+	CanAsync_Init(&Async, &TxSched);
+	WakeTotal = 0U;
+	WakeCount = 0U;
+	BadFrames = 0U;
+
+	SimCpu_GetStats(&MarkPtr->Cpu);
+}
+
+/*
+ * Prints a run of Frames frames, or of Frames resumes with no traffic
+ */
+static void End(const RunMark *MarkPtr, const char *Name, u32 Frames)
+{
+	SimCpuStats Cpu;
+	CanAsync_Stats Stats;
+	SimTime Elapsed;
+	SimTime Busy;
+
+	SimCpu_GetStats(&Cpu);
+	CanAsync_GetStats(&Async, &Stats);
+	Elapsed = Cpu.Now - MarkPtr->Cpu.Now;
+	Busy = Elapsed - (Cpu.Idle - MarkPtr->Cpu.Idle);
+
+	printf("%-16s %8.0f %6.1f%% %9.0f", Name,
+	       (double)Frames * 1e12 / (double)Elapsed,
+	       100.0 * (double)Busy / (double)Elapsed,
+	       (double)Busy / Frames / 1000.0);
+	if (WakeCount != 0U) {
+		printf(" %8.0f", (double)WakeTotal / WakeCount / 1000.0);
+	} else {
+		printf(" %8s", "-");
+	}
+	if (Stats.Started != 0U) {
+		printf(" %8.2f %8.2f\n", (double)Stats.Resumes / Frames,
+		       (double)Stats.Sleeps / Frames);
+	} else {
+		printf(" %8s %8s\n", "-", "-");
+	}
+}
+
+/*
+ * Takes the time from the last interrupt of a frame to now
+ */
+static void Woken(void)
+{
+	WakeTotal += SimNow() - std::max(TxAt, RxAt);
+	WakeCount++;
+}
+
+/*
+ * Checks a frame came back with its number
+ */
+static void CheckFrame(const u32 *FramePtr, u32 IdValue, u32 Number)
+{
+	if ((FramePtr[0] != IdValue) || (FramePtr[2] != Number)) {
+		BadFrames++;
+	}
+}
+
+/*
+ * Sends the frames one at a time, spinning on the flags
+ */
+static void RunPolling(void)
+{
+	u32 Frame[CAN_ASYNC_FRAME_WORDS] = { 0 };
+	CanPool_Frame *RxFrame;
+	u32 Index;
+
+	Frame[0] = XCan_CreateIdValue(FRAME_ID, 0U, 0U, 0U, 0U);
+	Frame[1] = XCan_CreateDlcValue(8U);
+	for (Index = 0U; Index < RUN_FRAMES; Index++) {
+		Frame[2] = Index;
+		SendDone = FALSE;
+		RecvDone = FALSE;
+		if (CanTxSched_Send(&TxSched, Frame) != XST_SUCCESS) {
+			BadFrames++;
+			return;
+		}
+		/*
+		 * The simulator takes interrupts when the program calls it,
+		 * or on its host tick, every 200 us, so a bare spin would
+		 * see the flags that late. A CPU takes them at once.
+		 */
+		while ((SendDone != TRUE) || (RecvDone != TRUE)) {
+			(void)SimNow();
+		}
+		Woken();
+
+		RxFrame = CanPool_Peek(&RxQueue);
+		if (RxFrame == NULL) {
+			BadFrames++;
+			continue;
+		}
+		CanPool_Take(&RxQueue);
+		CheckFrame(RxFrame->Words, Frame[0], Index);
+		CanPool_Release(&FramePool, RxFrame);
+	}
+}
+
+/*
+ * Task sending Count frames of Id and awaiting each back. Only a task
+ * alone has the handler times to itself for the wake time.
+ */
+static CanTask PingTask(CanAsync *AsyncPtr, u32 Id, u32 Count, int Alone)
+{
+	u32 TxFrame[CAN_ASYNC_FRAME_WORDS] = { 0 };
+	CanPool_Frame *RxFrame;
+	u32 Index;
+
+	TxFrame[0] = XCan_CreateIdValue(Id, 0U, 0U, 0U, 0U);
+	TxFrame[1] = XCan_CreateDlcValue(8U);
+	for (Index = 0U; Index < Count; Index++) {
+		TxFrame[2] = Index;
+		co_await CanAsync_Send(AsyncPtr, TxFrame);
+		RxFrame = co_await CanAsync_Recv(AsyncPtr, TxFrame[0], ~0U);
+		if (Alone) {
+			Woken();
+		}
+		CheckFrame(RxFrame->Words, TxFrame[0], Index);
+		CanPool_Release(&FramePool, RxFrame);
+	}
+}
+
+/*
+ * Hands the frames looped back to the tasks, leaving one no task waits
+ * for yet queued for the next pass
+ */
+static int PollQueue(void *CallBackRef)
+{
+	CanPool_Frame *RxFrame;
+
+	(void)CallBackRef;
+	while ((RxFrame = CanPool_Peek(&RxQueue)) != NULL) {
+		if (!CanAsync_Deliver(&Async, RxFrame)) {
+			break;
+		}
+		CanPool_Take(&RxQueue);
+		CanPool_Release(&FramePool, RxFrame);
+	}
+
+	return TRUE;
+}
+
+/*
+ * Runs Tasks ping tasks sharing the frames
+ */
+static void RunTasks(u32 Tasks)
+{
+	u32 Task;
+
+	for (Task = 0U; Task < Tasks; Task++) {
+		if (!PingTask(&Async, FRAME_ID + Task, RUN_FRAMES / Tasks,
+			      Tasks == 1U).Started) {
+			BadFrames++;
+			return;
+		}
+	}
+	CanAsync_Run(&Async, PollQueue, NULL);
+}
+
+/*
+ * Task yielding Count times
+ */
+static CanTask YieldTask(CanAsync *AsyncPtr, u32 Count)
+{
+	u32 Index;
+
+	for (Index = 0U; Index < Count; Index++) {
+		co_await CanAsync_Yield(AsyncPtr);
+	}
+}
+
+int main()
+{
+	RunMark Mark;
+	int Failed = 0;
+
+	if (Setup() != XST_SUCCESS) {
+		printf("setup failed\n");
+		return 1;
+	}
+
+	/* A first run warms up the host, whose time the CPU model scales */
+	Begin(&Mark);
+	RunTasks(1U);
+
+	printf("%u frames of 8 bytes a run at %u bit/s in loopback, "
+	       "one in flight per task\n\n", RUN_FRAMES, BitTiming.BitRate);
+	printf("%-16s %8s %7s %9s %8s %8s %8s\n", "wait", "frames/s",
+	       "load", "cpu/frame", "wake", "resumes", "sleeps");
+	printf("%-16s %8s %7s %9s %8s %8s %8s\n", "", "", "", "ns", "ns",
+	       "/frame", "/frame");
+
+	Begin(&Mark);
+	RunPolling();
+	End(&Mark, "flag polling", RUN_FRAMES);
+	Failed |= (BadFrames != 0U);
+
+	Begin(&Mark);
+	RunTasks(1U);
+	End(&Mark, "coroutines", RUN_FRAMES);
+	Failed |= (BadFrames != 0U);
+
+	Begin(&Mark);
+	RunTasks(TASKS);
+	End(&Mark, "coroutines x4", RUN_FRAMES);
+	Failed |= (BadFrames != 0U);
+
+	Begin(&Mark);
+	(void)YieldTask(&Async, YIELDS);
+	(void)YieldTask(&Async, YIELDS);
+	CanAsync_Run(&Async, NULL, NULL);
+	End(&Mark, "yield, 2 tasks", 2U * YIELDS);
+
+	if (Failed) {
+		printf("\nlost or wrong frames: FAILED\n");
+	}
+	return Failed;
+}
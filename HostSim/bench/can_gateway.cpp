@@ -0,0 +1,440 @@
+/******************************************************************************
+* CAN gateway between the two simulated controllers, Tut10/can_gateway.h
+*
+* CAN0 and CAN1 run in normal mode at 1 Mbit/s, each on its own simulated
+* bus, with these routes:
+*
+*	0	CAN0 0x100-0x1FF	to CAN1 as 0x500-0x5FF
+*	1	CAN0 0x0F0-0x0FF	to CAN1 as is
+*	2	CAN0 0x0F0-0x0FF	to CAN1 as 0x6F0-0x6FF
+*	3	CAN1 0x18DA0000-0x18DAFFFF (29-bit)	to CAN0 as is
+*
+* so a frame of 0x0F0-0x0FF goes out twice. Other nodes send 8-byte
+* frames on both buses, some of IDs no route takes, for RUN_MS: in the
+* light run about half of each bus, in the overloaded one more than
+* CAN1 can carry with the frames forwarded to it.
+*
+* A monitor on each bus checks that every frame the gateway sends carries
+* the ID of its route and the payload it came in with, which names the ID
+* and the bus it was first sent with. For each route it prints the frames
+* forwarded and sent, the frames dropped, and the latency from the read in
+* the receive interrupt handler to the TXOK on the other bus, which
+* includes the frame's own time on the wire, about 111 us for 8 bytes.
+* Each run also prints the load the gateway puts on the CPU.
+*
+*	build/can_gateway
+*
+* The program exits non-zero if a frame goes out wrong or the frames on
+* the buses do not add up with the route statistics.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <stdio.h>
+#include <algorithm>
+
+#include "xparameters.h"
+#include "xstatus.h"
+#include "xcan.h"
+#include "xtmrctr.h"
+#include "xscugic.h"
+#include "xil_exception.h"
+#include "xpseudo_asm.h"
+#include "sleep.h"
+#include "mono_clock.h"
+#include "timestamp.h"
+#include "can_bit_timing.h"
+#include "can_pool.h"
+#include "can_gateway.h"
+#include "hostsim.h"
+
+/************************** Constant Definitions *****************************/
+
+#define BIT_RATE		1000000
+#define SAMPLE_POINT		875
+
+#define PORTS			2U
+#define ROUTES			4U
+#define RUN_MS			200U
+
+/* Time the buses take to drain after a run */
+#define DRAIN_US		20000U
+
+/* Second data word of the frames of the other nodes, with the bus */
+#define ORIGIN_TAG		0x5A5A0000U
+
+/* Standard IDs sent on CAN0, cycled through, and the extended on CAN1 */
+#define BUS0_IDS		8U
+#define BUS1_IDS		4U
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	const char *Name;
+	u32 Bus0GapUs;			/**< Between frames sent on CAN0 */
+	u32 Bus1GapUs;			/**< Between frames sent on CAN1 */
+} RunLoad;
+
+/************************** Variable Definitions *****************************/
+
+static constexpr CanBitTiming BitTiming =
+	CanBitTiming_Check<XPAR_CAN_0_CAN_CLK_FREQ_HZ, BIT_RATE,
+			   SAMPLE_POINT>();
+
+static const u32 CanDeviceId[PORTS] = {
+	XPAR_CAN_0_DEVICE_ID, XPAR_CAN_1_DEVICE_ID
+};
+static const u32 CanIntrId[PORTS] = {
+	XPAR_FABRIC_CAN_0_VEC_ID, XPAR_FABRIC_CAN_1_VEC_ID
+};
+static const UINTPTR CanBase[PORTS] = {
+	XPAR_CAN_0_BASEADDR, XPAR_CAN_1_BASEADDR
+};
+
+static const CanGateway_Route Routes[ROUTES] = {
+	{ 0, 1, FALSE, 0x100U, 0x1FFU, 0x500U },
+	{ 0, 1, FALSE, 0x0F0U, 0x0FFU, CAN_GW_KEEP_ID },
+	{ 0, 1, FALSE, 0x0F0U, 0x0FFU, 0x6F0U },
+	{ 1, 0, TRUE, 0x18DA0000U, 0x18DAFFFFU, CAN_GW_KEEP_ID },
+};
+
+/* Two of the CAN0 IDs and one of the CAN1 IDs are not routed */
+static const u32 Bus0Id[BUS0_IDS] = {
+	0x100U, 0x0F3U, 0x1A5U, 0x080U, 0x1FFU, 0x0F0U, 0x300U, 0x123U
+};
+static const u32 Bus1Id[BUS1_IDS] = {
+	0x18DA00F1U, 0x18DAF100U, 0x0CF00400U, 0x18DA1234U
+};
+
+static const RunLoad Loads[] = {
+	{ "light", 400U, 500U },
+	{ "overloaded", 250U, 250U },
+};
+
+static XCan Can[PORTS];
+static XCan *CanPtrs[PORTS] = { &Can[0], &Can[1] };
+static XTmrCtr ClockTimer;
+static XScuGic Gic;
+static CanPool Pool;
+static CanGateway Gateway;
+
+/* Frames the monitors saw the gateway send, per route, and bad ones */
+static u32 Seen[ROUTES];
+static u32 BadFrames;
+static u32 BusErrors;
+
+/*****************************************************************************/
+/*
+ * Returns the ID a frame sent by the other nodes, with this ID register,
+ * has on the route, or ~0 if the route does not take it
+ */
+static u32 RoutedIdValue(const CanGateway_Route *RoutePtr, u32 IdValue)
+{
+	u32 Extended = (IdValue & XCAN_IDR_IDE_MASK) != 0U;
+	u32 Id = (IdValue & XCAN_IDR_ID1_MASK) >> XCAN_IDR_ID1_SHIFT;
+
+	if (Extended) {
+		Id = (Id << 18) |
+		     ((IdValue & XCAN_IDR_ID2_MASK) >> XCAN_IDR_ID2_SHIFT);
+	}
+	if ((RoutePtr->Extended != Extended) || (Id < RoutePtr->FirstId) ||
+	    (Id > RoutePtr->LastId)) {
+		return ~0U;
+	}
+	if (RoutePtr->NewFirstId == CAN_GW_KEEP_ID) {
+		return IdValue;
+	}
+
+	return XCan_CreateIdValue(Id - RoutePtr->FirstId +
+				  RoutePtr->NewFirstId, 0U, 0U, 0U, 0U);
+}
+
+/*
+ * Checks a frame on a bus. Frames sent by the other nodes carry their ID
+ * register and their bus in the data words; those still on their own bus
+ * are let through, the others were sent by the gateway and must match a
+ * route from their bus to this one.
+ */
+static void Monitor(void *CallBackRef, SimTime At, const u32 *FramePtr)
+{
+	u32 Bus = (u32)(UINTPTR)CallBackRef;
+	u32 Route;
+
+	(void)At;
+	if (FramePtr[3] == (ORIGIN_TAG | Bus)) {
+		return;
+	}
+	for (Route = 0U; Route < ROUTES; Route++) {
+		if ((Routes[Route].Dest == Bus) &&
+		    (FramePtr[3] == (ORIGIN_TAG | Routes[Route].Source)) &&
+		    (RoutedIdValue(&Routes[Route], FramePtr[2]) ==
+		     FramePtr[0])) {
+			Seen[Route]++;
+			return;
+		}
+	}
+	BadFrames++;
+}
+
+static void ErrorHandler(void *CallBackRef, u32 ErrorMask)
+{
+	(void)CallBackRef;
+	(void)ErrorMask;
+	BusErrors++;
+}
+
+static int Setup(void)
+{
+	XScuGic_Config *GicConfig;
+	u32 Port;
+
+	if (XTmrCtr_Initialize(&ClockTimer, XPAR_TMRCTR_2_DEVICE_ID) !=
+	    XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+	MonoClock_Initialize(&ClockTimer);
+
+	GicConfig = XScuGic_LookupConfig(XPAR_SCUGIC_SINGLE_DEVICE_ID);
+	if ((GicConfig == NULL) ||
+	    (XScuGic_CfgInitialize(&Gic, GicConfig,
+				   GicConfig->CpuBaseAddress) != XST_SUCCESS)) {
+		return XST_FAILURE;
+	}
+
+	CanPool_Init(&Pool);
+	if (CanGateway_Init(&Gateway, &Pool, CanPtrs, PORTS) != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	for (Port = 0U; Port < PORTS; Port++) {
+		if (XCan_Initialize(&Can[Port], CanDeviceId[Port]) !=
+		    XST_SUCCESS) {
+			return XST_FAILURE;
+		}
+		XCan_EnterMode(&Can[Port], XCAN_MODE_CONFIG);
+		while (XCan_GetMode(&Can[Port]) != XCAN_MODE_CONFIG);
+		CanBitTiming_Apply(&Can[Port], &BitTiming);
+		XCan_AcceptFilterDisable(&Can[Port], XCAN_AFR_UAF_ALL_MASK);
+		XCan_SetHandler(&Can[Port], XCAN_HANDLER_SEND,
+				(void *)CanGateway_SendHandler,
+				&Gateway.Port[Port]);
+		XCan_SetHandler(&Can[Port], XCAN_HANDLER_RECV,
+				(void *)CanGateway_RecvHandler,
+				&Gateway.Port[Port]);
+		XCan_SetHandler(&Can[Port], XCAN_HANDLER_ERROR,
+				(void *)ErrorHandler, &Can[Port]);
+
+		/* One priority for both, see can_gateway.h */
+		XScuGic_SetPriorityTriggerType(&Gic, CanIntrId[Port], 0xA0,
+					       0x3);
+		XScuGic_Connect(&Gic, CanIntrId[Port],
+				(Xil_InterruptHandler)XCan_IntrHandler,
+				&Can[Port]);
+		XScuGic_Enable(&Gic, CanIntrId[Port]);
+
+		SimCan_SetMonitor(CanBase[Port], Monitor,
+				  (void *)(UINTPTR)Port);
+	}
+
+	Xil_ExceptionInit();
+	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT,
+			(Xil_ExceptionHandler)XScuGic_InterruptHandler, &Gic);
+	Xil_ExceptionEnable();
+
+	for (Port = 0U; Port < PORTS; Port++) {
+		XCan_InterruptEnable(&Can[Port], XCAN_IXR_TXOK_MASK |
+				     XCAN_IXR_RXOK_MASK |
+				     XCAN_IXR_RXNEMP_MASK |
+				     XCAN_IXR_ERROR_MASK);
+		XCan_EnterMode(&Can[Port], XCAN_MODE_NORMAL);
+		while (XCan_GetMode(&Can[Port]) != XCAN_MODE_NORMAL);
+	}
+
+	return XST_SUCCESS;
+}
+
+/*
+ * Has the other nodes of a bus send a frame of IdValue every GapUs from
+ * Start until End, tagged with its ID register and the bus. Returns the
+ * time of the last.
+ */
+static SimTime Inject(u32 Bus, const u32 *IdValue, u32 Ids, u32 GapUs,
+		      SimTime Start, SimTime End)
+{
+	u32 Frame[XCAN_MAX_FRAME_SIZE / sizeof(u32)];
+	SimTime At;
+	SimTime Last = Start;
+	u32 Index = 0U;
+
+	Frame[1] = XCan_CreateDlcValue(8U);
+	for (At = Start; At < End; At += SIM_US(GapUs)) {
+		Frame[0] = IdValue[Index % Ids];
+		Frame[2] = Frame[0];
+		Frame[3] = ORIGIN_TAG | Bus;
+		SimCan_InjectFrame(CanBase[Bus], At, Frame);
+		Last = At;
+		Index++;
+	}
+
+	return Last;
+}
+
+/*
+ * Returns TRUE while the gateway has frames to send
+ */
+static int Forwarding(void)
+{
+	u32 Port;
+
+	for (Port = 0U; Port < PORTS; Port++) {
+		if (Gateway.Port[Port].TxDone != Gateway.Port[Port].TxHead) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/*
+ * Runs one load through the gateway and prints its routes. Returns
+ * non-zero if the frames do not add up.
+ */
+static int Run(const RunLoad *LoadPtr)
+{
+	u32 Bus0[BUS0_IDS];
+	u32 Bus1[BUS1_IDS];
+	CanGateway_RouteStats Stats;
+	CanGateway_PortStats PortStats;
+	CanPool_Stats PoolStats;
+	SimCpuStats Begin;
+	SimCpuStats End;
+	SimTime Start;
+	SimTime Last;
+	SimTime Elapsed;
+	u32 Route;
+	u32 Port;
+	u32 Index;
+	u32 Forwarded = 0U;
+	int Failed = 0;
+
+	for (Index = 0U; Index < BUS0_IDS; Index++) {
+		Bus0[Index] = XCan_CreateIdValue(Bus0Id[Index], 0U, 0U, 0U,
+						 0U);
+	}
+	for (Index = 0U; Index < BUS1_IDS; Index++) {
+		Bus1[Index] = XCan_CreateIdValue(Bus1Id[Index] >> 18, 1U, 1U,
+						 Bus1Id[Index] & 0x3FFFFU,
+						 0U);
+	}
+
+	(void)CanGateway_Init(&Gateway, &Pool, CanPtrs, PORTS);
+	for (Route = 0U; Route < ROUTES; Route++) {
+		if (CanGateway_AddRoute(&Gateway, &Routes[Route]) !=
+		    XST_SUCCESS) {
+			return 1;
+		}
+		Seen[Route] = 0U;
+	}
+	CanPool_ClearStats(&Pool);
+	BadFrames = 0U;
+
+	Start = SimNow() + SIM_MS(1);
+	Last = Inject(0U, Bus0, BUS0_IDS, LoadPtr->Bus0GapUs, Start,
+		      Start + SIM_MS(RUN_MS));
+	Last = std::max(Last, Inject(1U, Bus1, BUS1_IDS, LoadPtr->Bus1GapUs,
+				     Start, Start + SIM_MS(RUN_MS)));
+
+	/*
+	 * Sleep until the last frame is due and while the gateway sends,
+	 * checking with interrupts masked so that the last TXOK is not taken
+	 * between the check and the WFI, then let the buses drain: the other
+	 * nodes may still have frames queued behind the load.
+	 */
+	SimCpu_GetStats(&Begin);
+	for (;;) {
+		Xil_ExceptionDisable();
+		if ((SimNow() > Last) && !Forwarding()) {
+			Xil_ExceptionEnable();
+			break;
+		}
+		wfi();
+		Xil_ExceptionEnable();
+	}
+	SimCpu_GetStats(&End);
+	Elapsed = End.Now - Begin.Now;
+	usleep(DRAIN_US);
+
+	printf("%s: a frame every %u us on CAN0, %u us on CAN1\n",
+	       LoadPtr->Name, LoadPtr->Bus0GapUs, LoadPtr->Bus1GapUs);
+	for (Route = 0U; Route < ROUTES; Route++) {
+		CanGateway_GetRouteStats(&Gateway, Route, &Stats);
+		printf("%5u %9u %8u %8u %8u", Route, Stats.Forwarded,
+		       Stats.Sent, Stats.NoFrame, Stats.NoRoom);
+		if (Stats.Sent != 0U) {
+			printf(" %8.1f %8.1f %8.1f\n",
+			       Timestamp_TicksToNs(Stats.MinLatency) / 1e3,
+			       Timestamp_TicksToNs((u32)(Stats.TotalLatency /
+							 Stats.Sent)) / 1e3,
+			       Timestamp_TicksToNs(Stats.MaxLatency) / 1e3);
+		} else {
+			printf("\n");
+		}
+		if ((Stats.Sent != Stats.Forwarded) ||
+		    (Seen[Route] != Stats.Sent)) {
+			Failed = 1;
+		}
+		Forwarded += Stats.Sent;
+	}
+	for (Port = 0U; Port < PORTS; Port++) {
+		CanGateway_GetPortStats(&Gateway, Port, &PortStats);
+		printf("  CAN%u: %u received, %u unrouted, "
+		       "%u of %u queued at most\n", Port, PortStats.Received,
+		       PortStats.Unrouted, PortStats.TxHighWatermark,
+		       CAN_GW_TX_SIZE);
+	}
+	CanPool_GetStats(&Pool, &PoolStats);
+	printf("  pool: %u of %u frames at most, %u in use after\n",
+	       PoolStats.HighWatermark, CAN_POOL_FRAMES, PoolStats.InUse);
+	printf("  CPU: %.2f%% load, %.1f us per frame sent\n",
+	       100.0 * (double)(Elapsed - (End.Idle - Begin.Idle)) / Elapsed,
+	       (Forwarded != 0U) ?
+	       (double)(Elapsed - (End.Idle - Begin.Idle)) / Forwarded / 1e6 :
+	       0.0);
+	if ((BadFrames != 0U) || (PoolStats.InUse != 0U)) {
+		Failed = 1;
+	}
+
+	return Failed;
+}
+
+int main()
+{
+	int Failed = 0;
+	u32 Index;
+
+	if (Setup() != XST_SUCCESS) {
+		printf("setup failed\n");
+		return 1;
+	}
+
+	printf("%u ms at %u bit/s on each bus, latency from the receive "
+	       "interrupt to the TXOK\n\n", RUN_MS, BitTiming.BitRate);
+	for (Index = 0U; Index < sizeof(Loads) / sizeof(Loads[0]); Index++) {
+		printf("%5s %9s %8s %8s %8s %8s %8s %8s\n", "route",
+		       "forwarded", "sent", "no frame", "no room", "min",
+		       "mean", "max");
+		printf("%5s %9s %8s %8s %8s %8s %8s %8s\n", "", "", "", "",
+		       "", "us", "us", "us");
+		if (Run(&Loads[Index])) {
+			printf("  frames lost or sent wrong: FAILED\n");
+			Failed = 1;
+		}
+		printf("\n");
+	}
+	if (BusErrors != 0U) {
+		printf("%u bus errors: FAILED\n", BusErrors);
+		Failed = 1;
+	}
+
+	return Failed;
+}
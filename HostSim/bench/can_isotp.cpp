@@ -0,0 +1,554 @@
+/******************************************************************************
+* ISO-TP throughput against the flow control of the receiver,
+* Tut10/can_isotp.h
+*
+* CAN0 runs in loopback mode at 1 Mbit/s, so every frame it sends comes
+* back to it, and one ISO-TP engine holds both ends of each connection n:
+* a tester session sending on 0x7E0 + n and receiving on 0x7E8 + n, and an
+* ECU session the other way round. Frames take the path they take in
+* Can_code: the receive interrupt handler reads them into a can_ring.h
+* ring, the task dispatches them with can_dispatch.h to CanIsoTp_Frame,
+* and frames are sent through can_txsched.h. While a separation time
+* runs, the task sleeps on a one-shot timer of a timer_wheel.h wheel of
+* 100 us ticks on AXI Timer 0.
+*
+* First one 4095-byte message goes from the tester to the ECU under each
+* block size and STmin the ECU asks for, and the time from CanIsoTp_Send
+* to the message reassembled gives the throughput, against the time of
+* the frames alone on the wire. Single Frames with a DLC above 8 are
+* handed to a session, which must deliver only the one whose SF_DL fits
+* in the 8 bytes they carry. Then every session of CONNECTIONS
+* connections sends one at once, both ways.
+*
+*	build/can_isotp
+*
+* The program exits non-zero if a message is lost, arrives corrupted or
+* a transfer fails.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "xparameters.h"
+#include "xstatus.h"
+#include "xcan.h"
+#include "xtmrctr.h"
+#include "xscugic.h"
+#include "xil_exception.h"
+#include "xpseudo_asm.h"
+#include "mono_clock.h"
+#include "timestamp.h"
+#include "timer_wheel.h"
+#include "can_bit_timing.h"
+#include "can_ring.h"
+#include "can_dispatch.h"
+#include "can_txsched.h"
+#include "can_isotp.h"
+#include "hostsim.h"
+
+/************************** Constant Definitions *****************************/
+
+#define BIT_RATE		1000000
+#define SAMPLE_POINT		875
+
+#define CONNECTIONS		4U
+#define SESSIONS		(2U * CONNECTIONS)
+#define TESTER_ID		0x7E0U
+#define ECU_ID			0x7E8U
+#define MESSAGE_LENGTH		CAN_ISOTP_MAX_LENGTH
+
+#define WHEEL_TICK_US		100U
+#define TX_FIFO_LIMIT		2U
+
+/* Frames left queued before a Consecutive Frame, about one block */
+#define TX_QUEUE_LIMIT		8U
+
+/*
+ * Bits of a standard 8-byte frame without stuff bits and with the
+ * interframe space, for the least time of the frames on the wire
+ */
+#define FRAME_BITS		111U
+
+/* Session n of a connection: the tester 2n, the ECU 2n + 1 */
+#define TESTER(Connection)	(2U * (Connection))
+#define ECU(Connection)		(2U * (Connection) + 1U)
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u8 BlockSize;
+	u8 STmin;
+} FlowSetting;
+
+/************************** Variable Definitions *****************************/
+
+static constexpr CanBitTiming BitTiming =
+	CanBitTiming_Check<XPAR_CAN_0_CAN_CLK_FREQ_HZ, BIT_RATE,
+			   SAMPLE_POINT>();
+
+static const u16 TxClassLimit[CAN_TXS_CLASSES - 1U] = {
+	0x0FF, 0x3FF, 0x5FF
+};
+
+/* Single Frames handed straight to an ECU session, malformed but one */
+typedef struct {
+	u8 Dlc;
+	u8 Pci;
+	u32 Delivered;		/* Bytes the session must deliver, 0 none */
+} SingleFrame;
+
+/* Block size and STmin the ECU asks for, in turn */
+static const FlowSetting Settings[] = {
+	{ 0, 0x00 }, { 32, 0x00 }, { 8, 0x00 }, { 2, 0x00 }, { 1, 0x00 },
+	{ 0, 0xF1 }, { 0, 0xF5 }, { 0, 0x01 }, { 8, 0x01 }, { 0, 0x05 },
+};
+
+/*
+ * DLC 9 to 15 mean 8 bytes on classic CAN, which hold SF_DL 7 at most:
+ * a longer SF_DL would reach past the payload
+ */
+static const SingleFrame SingleFrames[] = {
+	{ 15, 0x0F, 0 }, { 15, 0x08, 0 }, { 9, 0x0C, 0 }, { 3, 0x05, 0 },
+	{ 15, 0x07, 7 },
+};
+
+static XCan Can;
+static XTmrCtr ClockTimer;
+static XTmrCtr WheelTimer;
+static XScuGic Gic;
+static CanRing Ring;
+static CanDispatch Dispatch;
+static CanTxSched TxSched;
+static CanIsoTp IsoTp;
+static TimerWheel Wheel;
+static TimerWheel_Timer WakeTimer;
+
+static u8 Message[SESSIONS][MESSAGE_LENGTH];
+static u8 RxBuffer[SESSIONS][MESSAGE_LENGTH];
+static u32 RxDiscard[CAN_RING_FRAME_WORDS];
+
+/* Messages still to arrive, and the timestamp the last did */
+static u32 Pending;
+static u32 Arrived[SESSIONS];
+static u32 Corrupted;
+static u32 SendFailures;
+static u32 BusErrors;
+
+/* Bytes the last Single Frame delivered */
+static u32 SingleLength;
+
+/*****************************************************************************/
+
+static void RecvHandler(void *CallBackRef)
+{
+	XCan *CanPtr = (XCan *)CallBackRef;
+	u32 *FramePtr;
+
+	while (XCan_IsRxEmpty(CanPtr) == FALSE) {
+		FramePtr = CanRing_Reserve(&Ring);
+		if (FramePtr == NULL) {
+			(void)XCan_Recv(CanPtr, RxDiscard);
+			continue;
+		}
+		(void)XCan_Recv(CanPtr, FramePtr);
+		CanRing_Commit(&Ring);
+	}
+}
+
+static void SendHandler(void *CallBackRef)
+{
+	CanTxSched_SendHandler((CanTxSched *)CallBackRef);
+}
+
+static void ErrorHandler(void *CallBackRef, u32 ErrorMask)
+{
+	(void)CallBackRef;
+	(void)ErrorMask;
+	BusErrors++;
+}
+
+/* The wheel timer only wakes the task */
+static void WakeHandler(void *CallBackRef)
+{
+	(void)CallBackRef;
+}
+
+/*
+ * A message came in: it must be the one its peer session sent
+ */
+static void MessageHandler(void *CallBackRef, u32 SessionIndex, u8 *DataPtr,
+			   u32 Length)
+{
+	(void)CallBackRef;
+	if ((Length != MESSAGE_LENGTH) ||
+	    (memcmp(DataPtr, Message[SessionIndex ^ 1U], Length) != 0)) {
+		Corrupted++;
+	}
+	Arrived[SessionIndex] = Timestamp_Now();
+	Pending--;
+}
+
+static void SingleHandler(void *CallBackRef, u32 SessionIndex, u8 *DataPtr,
+			  u32 Length)
+{
+	(void)CallBackRef;
+	(void)SessionIndex;
+	(void)DataPtr;
+	SingleLength = Length;
+}
+
+static void SentHandler(void *CallBackRef, u32 SessionIndex, int Status)
+{
+	(void)CallBackRef;
+	(void)SessionIndex;
+	if (Status != XST_SUCCESS) {
+		SendFailures++;
+		Pending--;
+	}
+}
+
+static int Setup(void)
+{
+	XScuGic_Config *GicConfig;
+	u32 Session;
+	u32 Index;
+
+	if ((XTmrCtr_Initialize(&ClockTimer, XPAR_TMRCTR_2_DEVICE_ID) !=
+	     XST_SUCCESS) ||
+	    (XTmrCtr_Initialize(&WheelTimer, XPAR_TMRCTR_0_DEVICE_ID) !=
+	     XST_SUCCESS) ||
+	    (XCan_Initialize(&Can, XPAR_CAN_0_DEVICE_ID) != XST_SUCCESS)) {
+		return XST_FAILURE;
+	}
+	MonoClock_Initialize(&ClockTimer);
+	if (TimerWheel_Initialize(&Wheel, &WheelTimer, 0, WHEEL_TICK_US,
+				  TIMER_WHEEL_TICKLESS) != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+	TimerWheel_InitTimer(&WakeTimer, WakeHandler, NULL);
+
+	XCan_EnterMode(&Can, XCAN_MODE_CONFIG);
+	while (XCan_GetMode(&Can) != XCAN_MODE_CONFIG);
+	CanBitTiming_Apply(&Can, &BitTiming);
+	XCan_AcceptFilterDisable(&Can, XCAN_AFR_UAF_ALL_MASK);
+	XCan_SetHandler(&Can, XCAN_HANDLER_SEND, (void *)SendHandler,
+			&TxSched);
+	XCan_SetHandler(&Can, XCAN_HANDLER_RECV, (void *)RecvHandler, &Can);
+	XCan_SetHandler(&Can, XCAN_HANDLER_ERROR, (void *)ErrorHandler, &Can);
+	CanRing_Init(&Ring);
+	if (CanTxSched_Init(&TxSched, &Can, TX_FIFO_LIMIT, TxClassLimit) !=
+	    XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	/* The sessions are the same ones every run, see StartSessions */
+	CanDispatch_Initialize(&Dispatch);
+	for (Session = 0U; Session < SESSIONS; Session++) {
+		if (CanDispatch_Register(&Dispatch, ((Session & 1U) ?
+					  TESTER_ID : ECU_ID) + Session / 2U,
+					 FALSE, CanIsoTp_Frame,
+					 &IsoTp.Session[Session]) !=
+		    XST_SUCCESS) {
+			return XST_FAILURE;
+		}
+		for (Index = 0U; Index < MESSAGE_LENGTH; Index++) {
+			Message[Session][Index] = (u8)((Index * 131U) ^
+						       (Index >> 8) ^
+						       (Session * 0x5BU));
+		}
+	}
+
+	GicConfig = XScuGic_LookupConfig(XPAR_SCUGIC_SINGLE_DEVICE_ID);
+	if ((GicConfig == NULL) ||
+	    (XScuGic_CfgInitialize(&Gic, GicConfig,
+				   GicConfig->CpuBaseAddress) != XST_SUCCESS)) {
+		return XST_FAILURE;
+	}
+	XScuGic_SetPriorityTriggerType(&Gic, XPAR_FABRIC_CAN_0_VEC_ID, 0xA0,
+				       0x3);
+	XScuGic_SetPriorityTriggerType(&Gic, XPAR_FABRIC_TMRCTR_0_VEC_ID,
+				       0xA0, 0x3);
+	XScuGic_Connect(&Gic, XPAR_FABRIC_CAN_0_VEC_ID,
+			(Xil_InterruptHandler)XCan_IntrHandler, &Can);
+	XScuGic_Connect(&Gic, XPAR_FABRIC_TMRCTR_0_VEC_ID,
+			(Xil_InterruptHandler)XTmrCtr_InterruptHandler,
+			&WheelTimer);
+	XScuGic_Enable(&Gic, XPAR_FABRIC_CAN_0_VEC_ID);
+	XScuGic_Enable(&Gic, XPAR_FABRIC_TMRCTR_0_VEC_ID);
+	Xil_ExceptionInit();
+	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT,
+			(Xil_ExceptionHandler)XScuGic_InterruptHandler, &Gic);
+	Xil_ExceptionEnable();
+	TimerWheel_Start(&Wheel);
+
+	XCan_InterruptEnable(&Can, XCAN_IXR_TXOK_MASK | XCAN_IXR_RXOK_MASK |
+			     XCAN_IXR_RXNEMP_MASK | XCAN_IXR_ERROR_MASK);
+	XCan_EnterMode(&Can, XCAN_MODE_LOOPBACK);
+	while (XCan_GetMode(&Can) != XCAN_MODE_LOOPBACK);
+
+	return XST_SUCCESS;
+}
+
+/*
+ * Sets up the sessions afresh, the ECUs asking for BlockSize and STmin
+ */
+static int StartSessions(u8 BlockSize, u8 STmin)
+{
+	CanIsoTp_Config Config;
+	u32 Connection;
+
+	CanIsoTp_Init(&IsoTp, (CanIsoTp_SendFn)CanTxSched_Send, &TxSched);
+	CanIsoTp_SetQueueLimit(&IsoTp, (CanIsoTp_PendingFn)CanTxSched_Pending,
+			       TX_QUEUE_LIMIT);
+	(void)CanIsoTp_SetHandler(&IsoTp, CAN_ISOTP_HANDLER_RECV,
+				  (void *)MessageHandler, NULL);
+	(void)CanIsoTp_SetHandler(&IsoTp, CAN_ISOTP_HANDLER_SEND,
+				  (void *)SentHandler, NULL);
+	for (Connection = 0U; Connection < CONNECTIONS; Connection++) {
+		Config = { TESTER_ID + Connection, ECU_ID + Connection, FALSE,
+			   0, 0 };
+		if (CanIsoTp_AddSession(&IsoTp, &Config,
+					RxBuffer[TESTER(Connection)],
+					MESSAGE_LENGTH) != XST_SUCCESS) {
+			return XST_FAILURE;
+		}
+		Config = { ECU_ID + Connection, TESTER_ID + Connection, FALSE,
+			   BlockSize, STmin };
+		if (CanIsoTp_AddSession(&IsoTp, &Config,
+					RxBuffer[ECU(Connection)],
+					MESSAGE_LENGTH) != XST_SUCCESS) {
+			return XST_FAILURE;
+		}
+	}
+	Corrupted = 0U;
+	SendFailures = 0U;
+
+	return XST_SUCCESS;
+}
+
+/*
+ * Runs the engine until no message is pending: dispatches the frames
+ * received, polls, and sleeps until the next interrupt, with the wheel
+ * timer armed for the time the engine waits for. Interrupts are masked
+ * from the last check to the WFI, so a frame that comes in between
+ * still wakes it.
+ */
+static void Transfer(void)
+{
+	u32 *FramePtr;
+	u32 Wait;
+	u32 Ticks;
+
+	while (Pending != 0U) {
+		while ((FramePtr = CanRing_Peek(&Ring)) != NULL) {
+			CanDispatch_Frame(&Dispatch, FramePtr);
+			CanRing_Release(&Ring);
+		}
+		Wait = CanIsoTp_Poll(&IsoTp);
+		if (Pending == 0U) {
+			break;
+		}
+		if ((Wait != 0U) && (Wait != CAN_ISOTP_IDLE)) {
+			Ticks = (u32)((Timestamp_TicksToNs(Wait) +
+				       WHEEL_TICK_US * 1000U - 1U) /
+				      (WHEEL_TICK_US * 1000U));
+			TimerWheel_Arm(&Wheel, &WakeTimer, Ticks, 0U);
+		}
+
+		Xil_ExceptionDisable();
+		if ((CanRing_Peek(&Ring) == NULL) &&
+		    ((Wait == 0U) || (Wait == CAN_ISOTP_IDLE) ||
+		     TimerWheel_IsArmed(&WakeTimer))) {
+			wfi();
+		}
+		Xil_ExceptionEnable();
+	}
+	(void)TimerWheel_Cancel(&Wheel, &WakeTimer);
+}
+
+/*
+ * Returns the time, in us, the frames of a message take on the wire
+ */
+static double WireUs(void)
+{
+	u32 Frames = 1U + (MESSAGE_LENGTH - 6U + 7U - 1U) / 7U;
+
+	return (double)Frames * FRAME_BITS * 1e6 / BIT_RATE;
+}
+
+/*
+ * Sends one message from the tester to the ECU of connection 0 under a
+ * flow control setting and prints its throughput. Returns non-zero if it
+ * did not arrive intact.
+ */
+static int RunSetting(const FlowSetting *SettingPtr, double *FirstPtr)
+{
+	CanIsoTp_Stats Stats;
+	u32 Start;
+	double Us;
+	double Rate;
+
+	if (StartSessions(SettingPtr->BlockSize, SettingPtr->STmin) !=
+	    XST_SUCCESS) {
+		return 1;
+	}
+	Pending = 1U;
+	Start = Timestamp_Now();
+	if (CanIsoTp_Send(&IsoTp, TESTER(0), Message[TESTER(0)],
+			  MESSAGE_LENGTH) != XST_SUCCESS) {
+		return 1;
+	}
+	Transfer();
+
+	Us = Timestamp_TicksToNs(Arrived[ECU(0)] - Start) / 1e3;
+	Rate = MESSAGE_LENGTH * 1e6 / Us;
+	if (*FirstPtr == 0.0) {
+		*FirstPtr = Rate;
+	}
+	CanIsoTp_GetStats(&IsoTp, ECU(0), &Stats);
+	printf("%4u %4u us %9.2f %5u %10.0f %6.1f%%\n",
+	       SettingPtr->BlockSize, CanIsoTp_STminUs(SettingPtr->STmin),
+	       Us / 1e3, Stats.FlowControls, Rate, 100.0 * Rate / *FirstPtr);
+
+	return (Corrupted != 0U) || (SendFailures != 0U) ||
+	       (Stats.Received != 1U);
+}
+
+/*
+ * Hands the Single Frames of SingleFrames to the ECU of connection 0 as
+ * if they had come from its ID. Returns non-zero unless it delivers
+ * just the well-formed ones, whole.
+ */
+static int RunSingleFrames(void)
+{
+	u32 Frame[CAN_RING_FRAME_WORDS];
+	u8 Data[8];
+	u32 Index;
+	int Failed = 0;
+
+	if (StartSessions(0, 0x00) != XST_SUCCESS) {
+		return 1;
+	}
+	(void)CanIsoTp_SetHandler(&IsoTp, CAN_ISOTP_HANDLER_RECV,
+				  (void *)SingleHandler, NULL);
+	for (Index = 0U; Index < sizeof(SingleFrames) /
+				 sizeof(SingleFrames[0]); Index++) {
+		const SingleFrame *CasePtr = &SingleFrames[Index];
+
+		memset(Frame, 0xA5, sizeof(Frame));
+		Data[0] = CasePtr->Pci;
+		memcpy(&Data[1], Message[TESTER(0)], sizeof(Data) - 1U);
+		Frame[0] = XCan_CreateIdValue(TESTER_ID, 0U, 0U, 0U, 0U);
+		Frame[1] = XCan_CreateDlcValue((u32)CasePtr->Dlc);
+		memcpy(&Frame[2], Data, sizeof(Data));
+
+		SingleLength = 0U;
+		CanIsoTp_Frame(&IsoTp.Session[ECU(0)], Frame);
+		printf("  DLC %2u SF_DL %2u: delivered %u bytes\n",
+		       CasePtr->Dlc, CasePtr->Pci & 0x0FU, SingleLength);
+		if ((SingleLength != CasePtr->Delivered) ||
+		    (memcmp(RxBuffer[ECU(0)], Message[TESTER(0)],
+			    SingleLength) != 0)) {
+			printf("  expected %u bytes: FAILED\n",
+			       CasePtr->Delivered);
+			Failed = 1;
+		}
+	}
+
+	return Failed;
+}
+
+/*
+ * Has every session of every connection send a message at once, the
+ * ECUs asking for blocks of 8. All the IDs are above the last class
+ * limit, so the frames share one FIFO class of the send queue, and the
+ * engine takes turns between the sessions: the messages finish close
+ * together at the end of the run, not one after the other. Returns
+ * non-zero unless all arrive intact.
+ */
+static int RunConcurrent(void)
+{
+	CanIsoTp_Stats Stats;
+	u32 Start;
+	u32 Last = 0U;
+	u32 Session;
+	u32 Frames = 0U;
+	double Us;
+
+	if (StartSessions(8, 0x00) != XST_SUCCESS) {
+		return 1;
+	}
+	Pending = SESSIONS;
+	Start = Timestamp_Now();
+	for (Session = 0U; Session < SESSIONS; Session++) {
+		if (CanIsoTp_Send(&IsoTp, Session, Message[Session],
+				  MESSAGE_LENGTH) != XST_SUCCESS) {
+			return 1;
+		}
+	}
+	Transfer();
+
+	for (Session = 0U; Session < SESSIONS; Session++) {
+		CanIsoTp_GetStats(&IsoTp, Session, &Stats);
+		printf("  %s %u: received in %7.2f ms, %u flow controls, "
+		       "%u frames refused\n", (Session & 1U) ? "ECU   " :
+		       "tester", Session / 2U,
+		       Timestamp_TicksToNs(Arrived[Session] - Start) / 1e6,
+		       Stats.FlowControls, Stats.Refused);
+		if ((s32)(Arrived[Session] - Last) > 0) {
+			Last = Arrived[Session];
+		}
+		Frames += Stats.Received;
+	}
+	Us = Timestamp_TicksToNs(Last - Start) / 1e3;
+	printf("  %u messages of %u bytes in %.2f ms: %.0f bytes/s in all\n",
+	       Frames, MESSAGE_LENGTH, Us / 1e3,
+	       SESSIONS * MESSAGE_LENGTH * 1e6 / Us);
+
+	return (Corrupted != 0U) || (SendFailures != 0U) ||
+	       (Frames != SESSIONS);
+}
+
+int main()
+{
+	double First = 0.0;
+	int Failed = 0;
+	u32 Index;
+
+	if (Setup() != XST_SUCCESS) {
+		printf("setup failed\n");
+		return 1;
+	}
+
+	printf("%u-byte messages at %u bit/s, %.2f ms of frames on the "
+	       "wire, %.0f bytes/s\n\n", MESSAGE_LENGTH, BitTiming.BitRate,
+	       WireUs() / 1e3, MESSAGE_LENGTH * 1e6 / WireUs());
+	printf("  BS    STmin   time ms   FCs    bytes/s  of BS 0\n");
+	for (Index = 0U; Index < sizeof(Settings) / sizeof(Settings[0]);
+	     Index++) {
+		if (RunSetting(&Settings[Index], &First)) {
+			printf("  message lost or corrupted: FAILED\n");
+			Failed = 1;
+		}
+	}
+
+	printf("\nSingle Frames of a DLC above 8\n");
+	if (RunSingleFrames()) {
+		Failed = 1;
+	}
+
+	printf("\n%u connections sending both ways at once, BS 8, STmin 0\n",
+	       CONNECTIONS);
+	if (RunConcurrent()) {
+		printf("  messages lost or corrupted: FAILED\n");
+		Failed = 1;
+	}
+	if (BusErrors != 0U) {
+		printf("%u bus errors: FAILED\n", BusErrors);
+		Failed = 1;
+	}
+
+	return Failed;
+}
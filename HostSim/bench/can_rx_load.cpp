@@ -0,0 +1,322 @@
+/******************************************************************************
+* CAN receive CPU load and latency against the offered frame rate
+*
+* Feeds the simulated controller, in normal mode at 1 Mbit/s, a steady
+* stream of 4-byte frames from another node at rates up to near the
+* capacity of the bus, and receives them the way Can_code does: drained by
+* the receive interrupt, and with Tut10/can_rx_poll.h by a timer tick once
+* the rate passes the switch point. For each receive configuration and
+* rate it prints
+*
+*	cpu/frame	simulated CPU time out of WFI per frame received,
+*			handlers and interrupt entry included
+*	load		that time over the length of the stream
+*	irqs/frame	CAN and timer interrupts taken per frame
+*	latency		end of the frame on the wire to its read from the
+*			RX FIFO: mean, 99th percentile and maximum
+*
+* Interrupt only receive costs the same per frame at every rate, and two
+* interrupts: XCan_IntrHandler acknowledges RXNEMP before it reads the
+* FIFO, which raises it again for the frame still there, so a second,
+* empty interrupt follows. Polling costs about one tick per period
+* whatever the rate, so it wins above the switch point, and the latency it
+* adds is bounded by the period.
+*
+*	build/can_rx_load
+*
+* The program exits non-zero if a frame is lost, repeated or overflows the
+* RX FIFO.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <stdio.h>
+#include <algorithm>
+
+#include "xparameters.h"
+#include "xstatus.h"
+#include "xcan.h"
+#include "xtmrctr.h"
+#include "xscugic.h"
+#include "xil_exception.h"
+#include "xpseudo_asm.h"
+#include "mono_clock.h"
+#include "can_bit_timing.h"
+#include "can_rx_poll.h"
+#include "hostsim.h"
+
+/************************** Constant Definitions *****************************/
+
+#define CAN_BASEADDR		XPAR_CAN_0_BASEADDR
+#define CAN_INTR_VEC_ID		XPAR_INTC_0_CAN_0_VEC_ID
+#define POLL_TIMER_INTR_VEC_ID	XPAR_FABRIC_TMRCTR_0_VEC_ID
+#define POLL_TIMER_COUNTER	0
+
+#define BIT_RATE		1000000
+#define SAMPLE_POINT		875
+
+/* Frames per run, the ID and the payload, which carries the frame number */
+#define RUN_FRAMES		2000U
+#define FRAME_ID		0x123U
+#define FRAME_DLC		4U
+
+/* Bits of a 4-byte standard frame before stuffing, with the gap */
+#define FRAME_BITS		(47U + 8U * FRAME_DLC)
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	const char *Name;
+	CanRxPoll_Config Config;
+} RxMode;
+
+/************************** Variable Definitions *****************************/
+
+static constexpr CanBitTiming BitTiming =
+	CanBitTiming_Check<XPAR_CAN_0_CAN_CLK_FREQ_HZ, BIT_RATE,
+			   SAMPLE_POINT>();
+
+static XCan Can;
+static XTmrCtr ClockTimer;
+static XTmrCtr PollTimer;
+static XScuGic Gic;
+static CanRxPoll RxPoll;
+
+/* When each frame of the run was offered, and its latency once read */
+static SimTime OfferedAt[RUN_FRAMES];
+static SimTime Latency[RUN_FRAMES];
+static u32 Seen[RUN_FRAMES];
+static volatile u32 Received;
+static u32 BadFrames;
+
+static const RxMode Modes[] = {
+	{ "interrupt only",	{ 0U, 1000U, 16U } },
+	{ "hybrid 1 ms",	{ 2000U, 1000U, 16U } },
+	{ "hybrid 250 us",	{ 2000U, 250U, 16U } },
+};
+
+static const u32 Rates[] = { 500, 1000, 2000, 4000, 6000, 8000, 10000 };
+
+/*****************************************************************************/
+/*
+ * Reads up to Budget frames, checking each and taking its latency
+ */
+static u32 ReceiveFrames(u32 Budget)
+{
+	u32 Frame[XCAN_MAX_FRAME_SIZE / sizeof(u32)];
+	u32 Frames = 0U;
+	u32 Number;
+
+	while ((Frames < Budget) && (XCan_IsRxEmpty(&Can) == FALSE)) {
+		Frames++;
+		(void)XCan_Recv(&Can, Frame);
+		Number = Frame[2];
+		if ((Number >= RUN_FRAMES) || Seen[Number]) {
+			BadFrames++;
+			continue;
+		}
+		Seen[Number] = 1U;
+		Latency[Number] = SimNow() - OfferedAt[Number];
+		Received = Received + 1U;
+	}
+
+	return Frames;
+}
+
+static void RecvHandler(void *CallBackRef)
+{
+	(void)CallBackRef;
+	CanRxPoll_Received(&RxPoll, ReceiveFrames(~0U));
+}
+
+static void PollTimerHandler(void *CallBackRef, u8 TmrCtrNumber)
+{
+	(void)CallBackRef;
+	(void)TmrCtrNumber;
+
+	if (RxPoll.Mode == CAN_RX_POLL) {
+		CanRxPoll_Polled(&RxPoll, ReceiveFrames(RxPoll.Config.Budget));
+	}
+}
+
+static void ErrorHandler(void *CallBackRef, u32 ErrorMask)
+{
+	(void)CallBackRef;
+	(void)ErrorMask;
+	BadFrames++;
+}
+
+static int Setup(void)
+{
+	XScuGic_Config *GicConfig;
+
+	if ((XTmrCtr_Initialize(&ClockTimer, XPAR_TMRCTR_2_DEVICE_ID) !=
+	     XST_SUCCESS) ||
+	    (XTmrCtr_Initialize(&PollTimer, XPAR_TMRCTR_0_DEVICE_ID) !=
+	     XST_SUCCESS) ||
+	    (XCan_Initialize(&Can, XPAR_CAN_0_DEVICE_ID) != XST_SUCCESS)) {
+		return XST_FAILURE;
+	}
+	MonoClock_Initialize(&ClockTimer);
+
+	XCan_EnterMode(&Can, XCAN_MODE_CONFIG);
+	while (XCan_GetMode(&Can) != XCAN_MODE_CONFIG);
+	CanBitTiming_Apply(&Can, &BitTiming);
+	XCan_AcceptFilterDisable(&Can, XCAN_AFR_UAF_ALL_MASK);
+	XCan_SetHandler(&Can, XCAN_HANDLER_RECV, (void *)RecvHandler, &Can);
+	XCan_SetHandler(&Can, XCAN_HANDLER_ERROR, (void *)ErrorHandler, &Can);
+	XTmrCtr_SetHandler(&PollTimer, PollTimerHandler, &Can);
+
+	GicConfig = XScuGic_LookupConfig(XPAR_SCUGIC_SINGLE_DEVICE_ID);
+	if ((GicConfig == NULL) ||
+	    (XScuGic_CfgInitialize(&Gic, GicConfig,
+				   GicConfig->CpuBaseAddress) != XST_SUCCESS)) {
+		return XST_FAILURE;
+	}
+	XScuGic_SetPriorityTriggerType(&Gic, CAN_INTR_VEC_ID, 0xA0, 0x3);
+	XScuGic_SetPriorityTriggerType(&Gic, POLL_TIMER_INTR_VEC_ID, 0xA0,
+				       0x3);
+	XScuGic_Connect(&Gic, CAN_INTR_VEC_ID,
+			(Xil_InterruptHandler)XCan_IntrHandler, &Can);
+	XScuGic_Connect(&Gic, POLL_TIMER_INTR_VEC_ID,
+			(Xil_InterruptHandler)XTmrCtr_InterruptHandler,
+			&PollTimer);
+	XScuGic_Enable(&Gic, CAN_INTR_VEC_ID);
+	XScuGic_Enable(&Gic, POLL_TIMER_INTR_VEC_ID);
+	Xil_ExceptionInit();
+	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT,
+			(Xil_ExceptionHandler)XScuGic_InterruptHandler, &Gic);
+	Xil_ExceptionEnable();
+
+	XCan_InterruptEnable(&Can, XCAN_IXR_RXOK_MASK | XCAN_IXR_RXNEMP_MASK |
+			     XCAN_IXR_ERROR_MASK | XCAN_IXR_RXOFLW_MASK);
+	XCan_EnterMode(&Can, XCAN_MODE_NORMAL);
+	while (XCan_GetMode(&Can) != XCAN_MODE_NORMAL);
+
+	return XST_SUCCESS;
+}
+
+static u64 IrqCount(u32 IntrId)
+{
+	SimIrqStats Stats;
+
+	SimIrq_GetStats(IntrId, &Stats);
+	return Stats.Count;
+}
+
+/*
+ * Offers RUN_FRAMES frames at Rate and receives them in Mode, printing the
+ * results if Print. Returns non-zero on a lost, repeated or overflowed
+ * frame.
+ */
+static int Run(const RxMode *ModePtr, u32 Rate, int Print)
+{
+	u32 Frame[XCAN_MAX_FRAME_SIZE / sizeof(u32)] = { 0 };
+	SimTime Wire = SIM_US(FRAME_BITS) / (BIT_RATE / 1000000U);
+	SimCpuStats Before;
+	SimCpuStats After;
+	SimCanStats CanBefore;
+	SimCanStats CanAfter;
+	CanRxPoll_Stats Stats;
+	SimTime Start;
+	SimTime Busy;
+	SimTime Total = 0U;
+	u64 Irqs;
+	u32 Index;
+
+	if (CanRxPoll_Init(&RxPoll, &Can, &PollTimer, POLL_TIMER_COUNTER,
+			   &ModePtr->Config) != XST_SUCCESS) {
+		return 1;
+	}
+	std::fill(Seen, Seen + RUN_FRAMES, 0U);
+	Received = 0U;
+	BadFrames = 0U;
+
+	Frame[0] = XCan_CreateIdValue(FRAME_ID, 0U, 0U, 0U, 0U);
+	Frame[1] = XCan_CreateDlcValue(FRAME_DLC);
+	Start = SimNow() + SIM_MS(1);
+	for (Index = 0U; Index < RUN_FRAMES; Index++) {
+		OfferedAt[Index] = Start + SIM_MS(1000) * Index / Rate;
+		Frame[2] = Index;
+		SimCan_InjectFrame(CAN_BASEADDR, OfferedAt[Index], Frame);
+	}
+
+	Irqs = IrqCount(CAN_INTR_VEC_ID) + IrqCount(POLL_TIMER_INTR_VEC_ID);
+	SimCan_GetStats(CAN_BASEADDR, &CanBefore);
+	SimCpu_GetStats(&Before);
+	while (Received + BadFrames < RUN_FRAMES) {
+		wfi();
+	}
+	SimCpu_GetStats(&After);
+	SimCan_GetStats(CAN_BASEADDR, &CanAfter);
+	Irqs = IrqCount(CAN_INTR_VEC_ID) + IrqCount(POLL_TIMER_INTR_VEC_ID) -
+	       Irqs;
+
+	/* Let a polling tail return to interrupts before the next run */
+	while (RxPoll.Mode != CAN_RX_IRQ) {
+		wfi();
+	}
+	CanRxPoll_GetStats(&RxPoll, &Stats);
+
+	/* The wire time is the same in every mode, leave the receive part */
+	for (Index = 0U; Index < RUN_FRAMES; Index++) {
+		Latency[Index] -= std::min(Latency[Index], Wire);
+		Total += Latency[Index];
+	}
+	std::sort(Latency, Latency + RUN_FRAMES);
+
+	Busy = (After.Now - Before.Now) - (After.Idle - Before.Idle);
+	if (Print) {
+		printf("%-14s %6u %9.2f %6.2f%% %8.2f %8.1f %8.1f %8.1f %6u\n",
+		       ModePtr->Name, Rate,
+		       (double)Busy / RUN_FRAMES / 1000.0,
+		       100.0 * (double)Busy / (double)(After.Now - Start),
+		       (double)Irqs / RUN_FRAMES,
+		       (double)Total / RUN_FRAMES / 1e6,
+		       (double)Latency[RUN_FRAMES * 99U / 100U] / 1e6,
+		       (double)Latency[RUN_FRAMES - 1U] / 1e6,
+		       Stats.Switches);
+	}
+
+	return (BadFrames != 0U) ||
+	       (CanAfter.RxOverflows != CanBefore.RxOverflows);
+}
+
+int main()
+{
+	int Failed = 0;
+	int Bad;
+	u32 Mode;
+	u32 Rate;
+
+	if (Setup() != XST_SUCCESS) {
+		printf("setup failed\n");
+		return 1;
+	}
+
+	/* A first run warms up the host, whose time the CPU model scales */
+	Failed |= Run(&Modes[0], Rates[0], FALSE);
+
+	printf("%u frames of %u bytes a run at %u bit/s, latency after the "
+	       "wire time\n\n", RUN_FRAMES, FRAME_DLC, BitTiming.BitRate);
+	printf("%-14s %6s %9s %7s %8s %8s %8s %8s %6s\n", "receive", "fps",
+	       "cpu/frame", "load", "irqs/fr", "mean", "p99", "max",
+	       "switch");
+	printf("%-14s %6s %9s %7s %8s %8s %8s %8s %6s\n", "", "", "ns", "",
+	       "", "us", "us", "us", "");
+
+	for (Mode = 0U; Mode < sizeof(Modes) / sizeof(Modes[0]); Mode++) {
+		for (Rate = 0U; Rate < sizeof(Rates) / sizeof(Rates[0]);
+		     Rate++) {
+			Bad = Run(&Modes[Mode], Rates[Rate], TRUE);
+			if (Bad) {
+				printf("  lost, repeated or overflowed "
+				       "frames: FAILED\n");
+			}
+			Failed |= Bad;
+		}
+		printf("\n");
+	}
+
+	return Failed;
+}
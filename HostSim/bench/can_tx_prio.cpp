@@ -0,0 +1,359 @@
+/******************************************************************************
+* CAN transmit queueing delay per priority class, FIFO order against
+* Tut10/can_txsched.h
+*
+* A 1 ms AXI Timer tick produces a mixed load on the simulated controller,
+* in loopback at 1 Mbit/s, about 70% of the bus:
+*
+*	urgent		ID 0x080 every tick			class 0
+*	periodic	ID 0x200 every other tick		class 2
+*	bulk		40 frames of ID 0x600 every 10 ticks	class 3
+*
+* all 8 bytes, the payload carrying the frame number. The same load is
+* sent through can_txq.h, in submission order, with the TX FIFO filled as
+* deep as it goes and only two frames deep, and through the priority
+* scheduler. For each kind of frame it prints the delay from the enqueue
+* to the frame coming back from the loopback: mean, 99th percentile and
+* maximum.
+*
+* In submission order an urgent frame produced behind a bulk burst waits
+* for the whole burst, about 5 ms, however shallow the TX FIFO. The
+* scheduler sends it through the TXHPB, after the frame on the wire.
+*
+*	build/can_tx_prio
+*
+* The program exits non-zero if a frame is lost or repeated.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <stdio.h>
+#include <algorithm>
+
+#include "xparameters.h"
+#include "xstatus.h"
+#include "xcan.h"
+#include "xtmrctr.h"
+#include "xscugic.h"
+#include "xil_exception.h"
+#include "xpseudo_asm.h"
+#include "mono_clock.h"
+#include "can_bit_timing.h"
+#include "can_txq.h"
+#include "can_txsched.h"
+#include "hostsim.h"
+
+/************************** Constant Definitions *****************************/
+
+#define CAN_INTR_VEC_ID		XPAR_INTC_0_CAN_0_VEC_ID
+#define TICK_TIMER_INTR_VEC_ID	XPAR_FABRIC_TMRCTR_0_VEC_ID
+#define TICK_TIMER_COUNTER	0
+
+#define BIT_RATE		1000000
+#define SAMPLE_POINT		875
+
+/* The load, in ticks of TICK_US */
+#define TICK_US			1000U
+#define RUN_TICKS		1000U
+#define PERIODIC_TICKS		2U
+#define BULK_TICKS		10U
+#define BULK_FRAMES		40U
+
+#define RUN_FRAMES		(RUN_TICKS + RUN_TICKS / PERIODIC_TICKS + \
+				 RUN_TICKS / BULK_TICKS * BULK_FRAMES)
+
+/* Clocks the counter takes to reload in generate mode */
+#define TICK_RELOAD_CLOCKS	2U
+
+/**************************** Type Definitions *******************************/
+
+typedef enum {
+	KIND_URGENT,
+	KIND_PERIODIC,
+	KIND_BULK,
+	KINDS
+} FrameKind;
+
+typedef enum {
+	TX_FIFO_DEEP,
+	TX_FIFO_SHALLOW,
+	TX_PRIORITY
+} TxMode;
+
+/************************** Variable Definitions *****************************/
+
+static constexpr CanBitTiming BitTiming =
+	CanBitTiming_Check<XPAR_CAN_0_CAN_CLK_FREQ_HZ, BIT_RATE,
+			   SAMPLE_POINT>();
+
+static XCan Can;
+static XTmrCtr ClockTimer;
+static XTmrCtr TickTimer;
+static XScuGic Gic;
+static CanTxQueue TxQueue;
+static CanTxSched TxSched;
+static TxMode Mode;
+
+static const u16 TxClassLimit[CAN_TXS_CLASSES - 1U] = {
+	0x0FF, 0x3FF, 0x5FF
+};
+
+static const u32 KindId[KINDS] = { 0x080, 0x200, 0x600 };
+static const char *const KindName[KINDS] = { "urgent", "periodic", "bulk" };
+
+static const char *const ModeName[] = {
+	"fifo order, 64", "fifo order, 2", "priority"
+};
+
+/* When each frame of the run was enqueued, its kind and its delay */
+static SimTime SentAt[RUN_FRAMES];
+static u8 Kind[RUN_FRAMES];
+static u32 Seen[RUN_FRAMES];
+static SimTime Delay[KINDS][RUN_FRAMES];
+static u32 Delays[KINDS];
+static u32 Produced;
+static u32 Rejected;
+static volatile u32 Received;
+static volatile u32 Ticks;
+static u32 BadFrames;
+
+/*****************************************************************************/
+/*
+ * Reads the frames looped back, checking each and taking its delay
+ */
+static void RecvHandler(void *CallBackRef)
+{
+	u32 Frame[XCAN_MAX_FRAME_SIZE / sizeof(u32)];
+	u32 Number;
+	u32 Index;
+
+	(void)CallBackRef;
+	while (XCan_IsRxEmpty(&Can) == FALSE) {
+		(void)XCan_Recv(&Can, Frame);
+		Number = Frame[2];
+		if ((Number >= Produced) || Seen[Number]) {
+			BadFrames++;
+			continue;
+		}
+		Seen[Number] = 1U;
+		Index = Kind[Number];
+		Delay[Index][Delays[Index]++] = SimNow() - SentAt[Number];
+		Received = Received + 1U;
+	}
+}
+
+static void SendHandler(void *CallBackRef)
+{
+	(void)CallBackRef;
+	if (Mode == TX_PRIORITY) {
+		CanTxSched_SendHandler(&TxSched);
+	} else {
+		CanTxQueue_SendHandler(&TxQueue);
+	}
+}
+
+static void ErrorHandler(void *CallBackRef, u32 ErrorMask)
+{
+	(void)CallBackRef;
+	(void)ErrorMask;
+	BadFrames++;
+}
+
+static void TickHandler(void *CallBackRef, u8 TmrCtrNumber)
+{
+	(void)CallBackRef;
+	(void)TmrCtrNumber;
+	Ticks = Ticks + 1U;
+}
+
+static int Setup(void)
+{
+	XScuGic_Config *GicConfig;
+
+	if ((XTmrCtr_Initialize(&ClockTimer, XPAR_TMRCTR_2_DEVICE_ID) !=
+	     XST_SUCCESS) ||
+	    (XTmrCtr_Initialize(&TickTimer, XPAR_TMRCTR_0_DEVICE_ID) !=
+	     XST_SUCCESS) ||
+	    (XCan_Initialize(&Can, XPAR_CAN_0_DEVICE_ID) != XST_SUCCESS)) {
+		return XST_FAILURE;
+	}
+	MonoClock_Initialize(&ClockTimer);
+
+	XCan_EnterMode(&Can, XCAN_MODE_CONFIG);
+	while (XCan_GetMode(&Can) != XCAN_MODE_CONFIG);
+	CanBitTiming_Apply(&Can, &BitTiming);
+	XCan_AcceptFilterDisable(&Can, XCAN_AFR_UAF_ALL_MASK);
+	XCan_SetHandler(&Can, XCAN_HANDLER_SEND, (void *)SendHandler, &Can);
+	XCan_SetHandler(&Can, XCAN_HANDLER_RECV, (void *)RecvHandler, &Can);
+	XCan_SetHandler(&Can, XCAN_HANDLER_ERROR, (void *)ErrorHandler, &Can);
+
+	XTmrCtr_SetHandler(&TickTimer, TickHandler, &TickTimer);
+	XTmrCtr_SetOptions(&TickTimer, TICK_TIMER_COUNTER,
+			   XTC_INT_MODE_OPTION | XTC_AUTO_RELOAD_OPTION |
+			   XTC_DOWN_COUNT_OPTION);
+	XTmrCtr_SetResetValue(&TickTimer, TICK_TIMER_COUNTER,
+			      (u32)((u64)TickTimer.Config.SysClockFreqHz *
+				    TICK_US / 1000000U) - TICK_RELOAD_CLOCKS);
+
+	GicConfig = XScuGic_LookupConfig(XPAR_SCUGIC_SINGLE_DEVICE_ID);
+	if ((GicConfig == NULL) ||
+	    (XScuGic_CfgInitialize(&Gic, GicConfig,
+				   GicConfig->CpuBaseAddress) != XST_SUCCESS)) {
+		return XST_FAILURE;
+	}
+	XScuGic_SetPriorityTriggerType(&Gic, CAN_INTR_VEC_ID, 0xA0, 0x3);
+	XScuGic_SetPriorityTriggerType(&Gic, TICK_TIMER_INTR_VEC_ID, 0xA0,
+				       0x3);
+	XScuGic_Connect(&Gic, CAN_INTR_VEC_ID,
+			(Xil_InterruptHandler)XCan_IntrHandler, &Can);
+	XScuGic_Connect(&Gic, TICK_TIMER_INTR_VEC_ID,
+			(Xil_InterruptHandler)XTmrCtr_InterruptHandler,
+			&TickTimer);
+	XScuGic_Enable(&Gic, CAN_INTR_VEC_ID);
+	XScuGic_Enable(&Gic, TICK_TIMER_INTR_VEC_ID);
+	Xil_ExceptionInit();
+	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT,
+			(Xil_ExceptionHandler)XScuGic_InterruptHandler, &Gic);
+	Xil_ExceptionEnable();
+
+	XCan_InterruptEnable(&Can, XCAN_IXR_TXOK_MASK | XCAN_IXR_RXOK_MASK |
+			     XCAN_IXR_RXNEMP_MASK | XCAN_IXR_ERROR_MASK);
+	XCan_EnterMode(&Can, XCAN_MODE_LOOPBACK);
+	while (XCan_GetMode(&Can) != XCAN_MODE_LOOPBACK);
+
+	return XST_SUCCESS;
+}
+
+/*
+ * Enqueues one frame of Which, numbered in its payload
+ */
+static void Produce(FrameKind Which)
+{
+	u32 Frame[XCAN_MAX_FRAME_SIZE / sizeof(u32)] = { 0 };
+	int Status;
+
+	Frame[0] = XCan_CreateIdValue(KindId[Which], 0U, 0U, 0U, 0U);
+	Frame[1] = XCan_CreateDlcValue(8U);
+	Frame[2] = Produced;
+	Frame[3] = Which;
+
+	Kind[Produced] = (u8)Which;
+	SentAt[Produced] = SimNow();
+	Produced++;
+
+	if (Mode == TX_PRIORITY) {
+		Status = CanTxSched_Send(&TxSched, Frame);
+	} else {
+		Status = CanTxQueue_Send(&TxQueue, Frame);
+	}
+	if (Status != XST_SUCCESS) {
+		Seen[Produced - 1U] = 1U;
+		Rejected++;
+	}
+}
+
+/*
+ * Sends the load for RUN_TICKS ticks in TxMode Which and prints the delay
+ * of each kind of frame. Returns non-zero on a lost or repeated frame.
+ */
+static int Run(TxMode Which)
+{
+	SimTime Start;
+	u32 Tick = 0U;
+	u32 Index;
+	u32 Count;
+	u32 Frame;
+	SimTime Total;
+
+	Mode = Which;
+	if (Which == TX_PRIORITY) {
+		(void)CanTxSched_Init(&TxSched, &Can, 2U, TxClassLimit);
+	} else {
+		CanTxQueue_Init(&TxQueue, &Can, (Which == TX_FIFO_DEEP) ?
+				XPAR_CAN_0_CAN_TX_DPTH : 2U);
+	}
+	std::fill(Seen, Seen + RUN_FRAMES, 0U);
+	std::fill(Delays, Delays + KINDS, 0U);
+	Produced = 0U;
+	Rejected = 0U;
+	Received = 0U;
+	BadFrames = 0U;
+	Ticks = 0U;
+
+	Start = SimNow();
+	XTmrCtr_Start(&TickTimer, TICK_TIMER_COUNTER);
+	while (Tick < RUN_TICKS) {
+		while (Tick == Ticks) {
+			wfi();
+		}
+		Tick++;
+
+		/* Bulk first, so the urgent frame of the tick is behind it */
+		if (Tick % BULK_TICKS == 0U) {
+			for (Frame = 0U; Frame < BULK_FRAMES; Frame++) {
+				Produce(KIND_BULK);
+			}
+		}
+		if (Tick % PERIODIC_TICKS == 0U) {
+			Produce(KIND_PERIODIC);
+		}
+		Produce(KIND_URGENT);
+	}
+	XTmrCtr_Stop(&TickTimer, TICK_TIMER_COUNTER);
+
+	while ((Received + Rejected + BadFrames < Produced) &&
+	       (SimNow() - Start < SIM_MS(2 * RUN_TICKS))) {
+		wfi();
+	}
+
+	for (Index = 0U; Index < KINDS; Index++) {
+		Count = Delays[Index];
+		if (Count == 0U) {
+			continue;
+		}
+		Total = 0U;
+		for (Frame = 0U; Frame < Count; Frame++) {
+			Total += Delay[Index][Frame];
+		}
+		std::sort(Delay[Index], Delay[Index] + Count);
+		printf("%-16s %-9s %6u %8.1f %8.1f %8.1f\n",
+		       (Index == 0U) ? ModeName[Which] : "", KindName[Index],
+		       Count, (double)Total / Count / 1e6,
+		       (double)Delay[Index][Count * 99U / 100U] / 1e6,
+		       (double)Delay[Index][Count - 1U] / 1e6);
+	}
+	if (Rejected != 0U) {
+		printf("%-16s %u sends rejected\n", "", Rejected);
+	}
+
+	return (BadFrames != 0U) || (Received + Rejected != Produced);
+}
+
+int main()
+{
+	int Failed = 0;
+	int Bad;
+	u32 Which;
+
+	if (Setup() != XST_SUCCESS) {
+		printf("setup failed\n");
+		return 1;
+	}
+
+	printf("%u ticks of %u us at %u bit/s, delay from the enqueue to the "
+	       "loopback\n\n", RUN_TICKS, TICK_US, BitTiming.BitRate);
+	printf("%-16s %-9s %6s %8s %8s %8s\n", "transmit", "frames", "count",
+	       "mean", "p99", "max");
+	printf("%-16s %-9s %6s %8s %8s %8s\n", "", "", "", "us", "us", "us");
+
+	for (Which = TX_FIFO_DEEP; Which <= TX_PRIORITY; Which++) {
+		Bad = Run((TxMode)Which);
+		if (Bad) {
+			printf("  lost or repeated frames: FAILED\n");
+		}
+		Failed |= Bad;
+		printf("\n");
+	}
+
+	return Failed;
+}
@@ -0,0 +1,409 @@
+/******************************************************************************
+* Payload rate of CAN FD against classic CAN, Tut10/canfd_bit_timing.h
+*
+* The AXI CAN (CAN0) and the AXI CAN FD controller each run in loopback
+* mode, interrupt driven: the send handler keeps the TX FIFO or every TX
+* buffer filled, the receive handler drains the RX FIFO and checks each
+* frame. A run sends RUN_FRAMES frames of one format back to back, their
+* data pseudo-random so that they carry a realistic number of stuff bits,
+* and the time from the first send to the last frame received gives the
+* payload rate:
+*
+*	CAN		8 bytes at 1 Mbit/s
+*	CAN FD		8 and 64 bytes at 1 Mbit/s, without the bit rate
+*			switch
+*	CAN FD BRS	8 and 64 bytes, the data phase at 2, 5 and 8 Mbit/s
+*
+* The arbitration phase of every frame runs at the 1 Mbit/s of the bus,
+* so the gain of CAN FD grows with the payload and the data phase rate:
+* a 64-byte frame at 1 Mbit/s only spreads the header over eight times
+* the data, with the bit rate switch the data also goes faster.
+*
+*	build/canfd_rate
+*
+* The program exits non-zero if a frame is lost or arrives corrupted.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "xparameters.h"
+#include "xstatus.h"
+#include "xcan.h"
+#include "xcanfd.h"
+#include "xscugic.h"
+#include "xil_exception.h"
+#include "xpseudo_asm.h"
+#include "can_bit_timing.h"
+#include "canfd_bit_timing.h"
+#include "hostsim.h"
+
+/************************** Constant Definitions *****************************/
+
+#define BIT_RATE		1000000
+#define SAMPLE_POINT		875
+#define DATA_SAMPLE_POINT	750
+
+#define RUN_FRAMES		500U
+#define FRAME_ID		0x123U
+
+#define CAN_FRAME_WORDS		(XCAN_MAX_FRAME_SIZE / sizeof(u32))
+#define CANFD_FRAME_WORDS	(XCANFD_MAX_FRAME_SIZE / sizeof(u32))
+
+/* Data phase settings of a run, indexes into FdTiming */
+#define DATA_NONE		0U	/* Without the bit rate switch */
+#define DATA_2M			0U
+#define DATA_5M			1U
+#define DATA_8M			2U
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	const char *Name;
+	u32 Fd;			/* Sent by the CAN FD controller */
+	u32 Edl;		/* CAN FD frame */
+	u32 Brs;		/* With the bit rate switch */
+	u32 Timing;		/* FdTiming index */
+	u32 Length;		/* Payload bytes */
+} RunFormat;
+
+/************************** Variable Definitions *****************************/
+
+static constexpr CanBitTiming BitTiming =
+	CanBitTiming_Check<XPAR_CAN_0_CAN_CLK_FREQ_HZ, BIT_RATE,
+			   SAMPLE_POINT>();
+
+static constexpr CanFdBitTiming FdTiming[] = {
+	CanFdBitTiming_Check<XPAR_CANFD_0_CAN_CLK_FREQ_HZ, BIT_RATE,
+			     SAMPLE_POINT, 2000000, DATA_SAMPLE_POINT>(),
+	CanFdBitTiming_Check<XPAR_CANFD_0_CAN_CLK_FREQ_HZ, BIT_RATE,
+			     SAMPLE_POINT, 5000000, DATA_SAMPLE_POINT>(),
+	CanFdBitTiming_Check<XPAR_CANFD_0_CAN_CLK_FREQ_HZ, BIT_RATE,
+			     SAMPLE_POINT, 8000000, DATA_SAMPLE_POINT>(),
+};
+
+static const RunFormat Formats[] = {
+	{ "CAN",		FALSE, FALSE, FALSE, DATA_NONE, 8U },
+	{ "CAN on CAN FD",	TRUE,  FALSE, FALSE, DATA_NONE, 8U },
+	{ "CAN FD",		TRUE,  TRUE,  FALSE, DATA_NONE, 8U },
+	{ "CAN FD",		TRUE,  TRUE,  FALSE, DATA_NONE, 64U },
+	{ "CAN FD BRS",		TRUE,  TRUE,  TRUE,  DATA_2M,   8U },
+	{ "CAN FD BRS",		TRUE,  TRUE,  TRUE,  DATA_5M,   8U },
+	{ "CAN FD BRS",		TRUE,  TRUE,  TRUE,  DATA_2M,   64U },
+	{ "CAN FD BRS",		TRUE,  TRUE,  TRUE,  DATA_5M,   64U },
+	{ "CAN FD BRS",		TRUE,  TRUE,  TRUE,  DATA_8M,   64U },
+};
+
+static XCan Can;
+static XCanFd CanFd;
+static XScuGic Gic;
+
+/* The run in progress */
+static const RunFormat *Run;
+static u32 Sent;
+static volatile u32 Received;
+static volatile u32 BadFrames;
+static volatile u32 BusErrors;
+static SimTime LastAt;
+
+/*****************************************************************************/
+/*
+ * Data byte Index of frame Number, an LCG of both
+ */
+static u8 Pattern(u32 Number, u32 Index)
+{
+	return (u8)(((Number * 2654435761U) ^ (Index * 40503U)) >> 13);
+}
+
+/*
+ * Fills Frame with frame Number of the run, in the register layout both
+ * drivers take: ID, DLC, data bytes in memory order
+ */
+static void MakeFrame(u32 Number, u32 *Frame)
+{
+	u8 *DataPtr = (u8 *)&Frame[2];
+	u32 Dlc = Run->Edl ? XCanFd_GetLen2Dlc((int)Run->Length) :
+			     Run->Length;
+	u32 Index;
+
+	memset(Frame, 0, CANFD_FRAME_WORDS * sizeof(u32));
+	Frame[0] = XCanFd_CreateIdValue(FRAME_ID, 0U, 0U, 0U, 0U);
+	if (!Run->Edl) {
+		Frame[1] = XCanFd_CreateDlcValue(Dlc);
+	} else if (Run->Brs) {
+		Frame[1] = XCanFd_Create_CanFD_Dlc_BrsValue(Dlc);
+	} else {
+		Frame[1] = XCanFd_Create_CanFD_DlcValue(Dlc);
+	}
+	for (Index = 0U; Index < Run->Length; Index++) {
+		DataPtr[Index] = Pattern(Number, Index);
+	}
+}
+
+/*
+ * Checks a frame received against the next one sent: loopback keeps the
+ * order
+ */
+static void CheckFrame(const u32 *Frame, u32 Length)
+{
+	const u8 *DataPtr = (const u8 *)&Frame[2];
+	u32 Index;
+
+	if ((Received >= RUN_FRAMES) || (Length != Run->Length) ||
+	    (Frame[0] != XCanFd_CreateIdValue(FRAME_ID, 0U, 0U, 0U, 0U))) {
+		BadFrames = BadFrames + 1U;
+		return;
+	}
+	for (Index = 0U; Index < Length; Index++) {
+		if (DataPtr[Index] != Pattern(Received, Index)) {
+			BadFrames = BadFrames + 1U;
+			return;
+		}
+	}
+	Received = Received + 1U;
+	LastAt = SimNow();
+}
+
+/*****************************************************************************/
+/*
+ * Classic controller: the TX FIFO kept full, the RX FIFO drained
+ */
+static void CanFill(void)
+{
+	u32 Frame[CANFD_FRAME_WORDS];
+
+	while ((Sent < RUN_FRAMES) && !XCan_IsTxFifoFull(&Can)) {
+		MakeFrame(Sent, Frame);
+		if (XCan_Send(&Can, Frame) != XST_SUCCESS) {
+			break;
+		}
+		Sent++;
+	}
+}
+
+static void CanSendHandler(void *CallBackRef)
+{
+	(void)CallBackRef;
+	CanFill();
+}
+
+static void CanRecvHandler(void *CallBackRef)
+{
+	u32 Frame[CAN_FRAME_WORDS];
+
+	(void)CallBackRef;
+	while (XCan_IsRxEmpty(&Can) == FALSE) {
+		(void)XCan_Recv(&Can, Frame);
+		CheckFrame(Frame, (Frame[1] & XCAN_DLCR_DLC_MASK) >>
+				  XCAN_DLCR_DLC_SHIFT);
+	}
+}
+
+/*
+ * CAN FD controller: every free TX buffer filled, RX FIFO 0 drained
+ */
+static void CanFdFill(void)
+{
+	u32 Frame[CANFD_FRAME_WORDS];
+	u32 Buffer;
+
+	while (Sent < RUN_FRAMES) {
+		MakeFrame(Sent, Frame);
+		if (XCanFd_Send(&CanFd, Frame, &Buffer) != XST_SUCCESS) {
+			break;
+		}
+		Sent++;
+	}
+}
+
+static void CanFdSendHandler(void *CallBackRef)
+{
+	(void)CallBackRef;
+	CanFdFill();
+}
+
+static void CanFdRecvHandler(void *CallBackRef)
+{
+	u32 Frame[CANFD_FRAME_WORDS];
+
+	(void)CallBackRef;
+	while (XCanFd_GetRxFillLevel(&CanFd) != 0U) {
+		(void)XCanFd_Recv(&CanFd, Frame);
+		CheckFrame(Frame, (u32)XCanFd_GetDlc2len(Frame[1] &
+							XCANFD_DLCR_DLC_MASK,
+							Frame[1] &
+							XCANFD_DLCR_EDL_MASK));
+	}
+}
+
+static void ErrorHandler(void *CallBackRef, u32 ErrorMask)
+{
+	(void)CallBackRef;
+	(void)ErrorMask;
+	BusErrors = BusErrors + 1U;
+}
+
+/*****************************************************************************/
+
+static int Setup(void)
+{
+	XScuGic_Config *GicConfig;
+	XCanFd_Config *FdConfig;
+
+	FdConfig = XCanFd_LookupConfig(XPAR_CANFD_0_DEVICE_ID);
+	if ((XCan_Initialize(&Can, XPAR_CAN_0_DEVICE_ID) != XST_SUCCESS) ||
+	    (FdConfig == NULL) ||
+	    (XCanFd_CfgInitialize(&CanFd, FdConfig, FdConfig->BaseAddress) !=
+	     XST_SUCCESS)) {
+		return XST_FAILURE;
+	}
+
+	XCan_EnterMode(&Can, XCAN_MODE_CONFIG);
+	while (XCan_GetMode(&Can) != XCAN_MODE_CONFIG);
+	CanBitTiming_Apply(&Can, &BitTiming);
+	XCan_AcceptFilterDisable(&Can, XCAN_AFR_UAF_ALL_MASK);
+	XCan_SetHandler(&Can, XCAN_HANDLER_SEND, (void *)CanSendHandler, &Can);
+	XCan_SetHandler(&Can, XCAN_HANDLER_RECV, (void *)CanRecvHandler, &Can);
+	XCan_SetHandler(&Can, XCAN_HANDLER_ERROR, (void *)ErrorHandler, &Can);
+
+	XCanFd_SetHandler(&CanFd, XCANFD_HANDLER_SEND,
+			  (void *)CanFdSendHandler, &CanFd);
+	XCanFd_SetHandler(&CanFd, XCANFD_HANDLER_RECV,
+			  (void *)CanFdRecvHandler, &CanFd);
+	XCanFd_SetHandler(&CanFd, XCANFD_HANDLER_ERROR,
+			  (void *)ErrorHandler, &CanFd);
+
+	GicConfig = XScuGic_LookupConfig(XPAR_SCUGIC_SINGLE_DEVICE_ID);
+	if ((GicConfig == NULL) ||
+	    (XScuGic_CfgInitialize(&Gic, GicConfig,
+				   GicConfig->CpuBaseAddress) != XST_SUCCESS)) {
+		return XST_FAILURE;
+	}
+	XScuGic_SetPriorityTriggerType(&Gic, XPAR_FABRIC_CAN_0_VEC_ID, 0xA0,
+				       0x3);
+	XScuGic_SetPriorityTriggerType(&Gic, XPAR_FABRIC_CANFD_0_VEC_ID, 0xA0,
+				       0x3);
+	XScuGic_Connect(&Gic, XPAR_FABRIC_CAN_0_VEC_ID,
+			(Xil_InterruptHandler)XCan_IntrHandler, &Can);
+	XScuGic_Connect(&Gic, XPAR_FABRIC_CANFD_0_VEC_ID,
+			(Xil_InterruptHandler)XCanFd_IntrHandler, &CanFd);
+	XScuGic_Enable(&Gic, XPAR_FABRIC_CAN_0_VEC_ID);
+	XScuGic_Enable(&Gic, XPAR_FABRIC_CANFD_0_VEC_ID);
+	Xil_ExceptionInit();
+	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT,
+			(Xil_ExceptionHandler)XScuGic_InterruptHandler, &Gic);
+	Xil_ExceptionEnable();
+
+	XCan_InterruptEnable(&Can, XCAN_IXR_TXOK_MASK | XCAN_IXR_RXNEMP_MASK |
+			     XCAN_IXR_ERROR_MASK);
+	XCan_EnterMode(&Can, XCAN_MODE_LOOPBACK);
+	while (XCan_GetMode(&Can) != XCAN_MODE_LOOPBACK);
+	XCanFd_InterruptEnable(&CanFd, XCANFD_IXR_TXOK_MASK |
+			       XCANFD_IXR_RXOK_MASK | XCANFD_IXR_ERROR_MASK);
+
+	return XST_SUCCESS;
+}
+
+/*
+ * Puts the CAN FD controller in loopback mode with the bit timing of a run
+ */
+static void ConfigureFd(const RunFormat *FormatPtr)
+{
+	XCanFd_EnterMode(&CanFd, XCANFD_MODE_CONFIG);
+	while (XCanFd_GetMode(&CanFd) != XCANFD_MODE_CONFIG);
+	CanFdBitTiming_Apply(&CanFd, &FdTiming[FormatPtr->Timing]);
+	XCanFd_SetBitRateSwitch_EnableNominal(&CanFd);
+	XCanFd_EnterMode(&CanFd, XCANFD_MODE_LOOPBACK);
+	while (XCanFd_GetMode(&CanFd) != XCANFD_MODE_LOOPBACK);
+}
+
+/*
+ * Sends the frames of one run and returns its payload rate in bytes/s, 0
+ * if a frame went missing or arrived corrupted
+ */
+static double RunOne(const RunFormat *FormatPtr)
+{
+	SimTime Start;
+	double Us;
+
+	if (FormatPtr->Fd) {
+		ConfigureFd(FormatPtr);
+	}
+	Run = FormatPtr;
+	Sent = 0U;
+	Received = 0U;
+	BadFrames = 0U;
+
+	Start = SimNow();
+	Xil_ExceptionDisable();
+	if (FormatPtr->Fd) {
+		CanFdFill();
+	} else {
+		CanFill();
+	}
+	Xil_ExceptionEnable();
+	while ((Received != RUN_FRAMES) && (BadFrames == 0U)) {
+		Xil_ExceptionDisable();
+		if ((Received != RUN_FRAMES) && (BadFrames == 0U)) {
+			wfi();
+		}
+		Xil_ExceptionEnable();
+	}
+	if (BadFrames != 0U) {
+		return 0.0;
+	}
+
+	Us = (double)(LastAt - Start) / 1e6;
+	return RUN_FRAMES * FormatPtr->Length * 1e6 / Us;
+}
+
+int main()
+{
+	double Base = 0.0;
+	double Rate;
+	int Failed = 0;
+	u32 Index;
+	const RunFormat *FormatPtr;
+	char DataRate[16];
+
+	if (Setup() != XST_SUCCESS) {
+		printf("setup failed\n");
+		return 1;
+	}
+
+	printf("%u frames of each format, arbitration phase at %u bit/s\n\n",
+	       RUN_FRAMES, BitTiming.BitRate);
+	printf("  format          payload  data bit/s  us/frame    "
+	       "bytes/s  of CAN\n");
+	for (Index = 0U; Index < sizeof(Formats) / sizeof(Formats[0]);
+	     Index++) {
+		FormatPtr = &Formats[Index];
+		Rate = RunOne(FormatPtr);
+		if (Rate == 0.0) {
+			printf("  %-14s %4u B: frames lost or corrupted: "
+			       "FAILED\n", FormatPtr->Name, FormatPtr->Length);
+			Failed = 1;
+			continue;
+		}
+		if (Base == 0.0) {
+			Base = Rate;
+		}
+		if (FormatPtr->Brs) {
+			snprintf(DataRate, sizeof(DataRate), "%u",
+				 FdTiming[FormatPtr->Timing].Data.BitRate);
+		} else {
+			snprintf(DataRate, sizeof(DataRate), "-");
+		}
+		printf("  %-14s %6u B  %10s  %8.1f  %9.0f  %5.2fx\n",
+		       FormatPtr->Name, FormatPtr->Length, DataRate,
+		       FormatPtr->Length * 1e6 / Rate, Rate, Rate / Base);
+	}
+	if (BusErrors != 0U) {
+		printf("%u bus errors: FAILED\n", BusErrors);
+		Failed = 1;
+	}
+
+	return Failed;
+}
@@ -0,0 +1,166 @@
+/******************************************************************************
+* Cost and consistency of the 64-bit cascaded clock read
+*
+* Runs Tut10/mono_clock.h on the simulated cascade timer and checks:
+*
+*	- a MonoClock_Now costs three AXI reads away from a carry and at
+*	  most five across one (SimBus_GetStats)
+*	- reads are monotonic through many low word wraps, while a plain
+*	  low then high read of the same counter tears at the carry
+*	- Timestamp_Now runs on the same timebase, as the low word
+*	- the tick and time conversions round trip
+*
+*	build/clock_read
+*
+* The program exits non-zero if a check fails.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <stdio.h>
+
+#include "xparameters.h"
+#include "xtmrctr.h"
+#include "mono_clock.h"
+#include "timestamp.h"
+#include "hostsim.h"
+
+/************************** Constant Definitions *****************************/
+
+#define CLOCK_TIMER_DEVICE_ID	XPAR_TMRCTR_2_DEVICE_ID
+#define CLOCK_BASEADDR		XPAR_TMRCTR_2_BASEADDR
+
+/* Reads per measurement and low word wraps to run through */
+#define STEADY_READS		100000U
+#define WRAPS			64U
+
+/* Low word value to restart from, just short of a wrap */
+#define NEAR_WRAP		0xFFFFFF00U
+
+/************************** Variable Definitions *****************************/
+
+static XTmrCtr ClockTimer;
+
+/*****************************************************************************/
+/*
+ * Restarts the cascade at the given 64-bit value
+ */
+static void SetClock(u64 Value)
+{
+	XTmrCtr_WriteReg(CLOCK_BASEADDR, 0, XTC_TLR_OFFSET, (u32)Value);
+	XTmrCtr_WriteReg(CLOCK_BASEADDR, 1, XTC_TLR_OFFSET, (u32)(Value >> 32));
+	XTmrCtr_WriteReg(CLOCK_BASEADDR, 0, XTC_TCSR_OFFSET,
+			 XTC_CSR_CASC_MASK | XTC_CSR_LOAD_MASK);
+	XTmrCtr_WriteReg(CLOCK_BASEADDR, 0, XTC_TCSR_OFFSET,
+			 XTC_CSR_CASC_MASK | XTC_CSR_ENABLE_TMR_MASK);
+}
+
+/* Low word first, no retry: what a naive 64-bit read does */
+static u64 PlainRead(void)
+{
+	u32 Low = Xil_In32(MonoClock_LowAddr);
+	u32 High = Xil_In32(MonoClock_HighAddr);
+
+	return ((u64)High << 32) | Low;
+}
+
+static u64 BusReads(void)
+{
+	SimBusStats Stats;
+
+	SimBus_GetStats(CLOCK_BASEADDR, &Stats);
+	return Stats.Reads;
+}
+
+/*
+ * Reads through WRAPS carries of the low word with Read, restarting just
+ * short of each, and returns the reads that went backwards or jumped by
+ * more than a wrap. *MaxReadsPtr gets the most bus reads of one call.
+ */
+static u32 RunThroughWraps(u64 (*Read)(void), u64 *MaxReadsPtr)
+{
+	u32 Bad = 0;
+	u32 Wrap;
+
+	*MaxReadsPtr = 0;
+	for (Wrap = 0; Wrap < WRAPS; Wrap++) {
+		u64 Start = ((u64)(Wrap + 1U) << 32) | NEAR_WRAP;
+		u64 Last;
+
+		SetClock(Start);
+		Last = Read();
+		while ((Last >> 32) == (Wrap + 1U)) {
+			u64 Before = BusReads();
+			u64 Now = Read();
+			u64 Reads = BusReads() - Before;
+
+			if ((Now < Last) || ((Now - Last) > 0x10000U)) {
+				Bad++;
+			}
+			if (Reads > *MaxReadsPtr) {
+				*MaxReadsPtr = Reads;
+			}
+			Last = Now;
+		}
+	}
+
+	return Bad;
+}
+
+int main()
+{
+	u64 Before;
+	u64 Reads;
+	u64 MaxReads;
+	u64 First;
+	u64 Second;
+	u32 Stamp;
+	u32 Torn;
+	u32 Plain;
+	u32 Index;
+	int Failed = 0;
+	int Ok;
+
+	XTmrCtr_Initialize(&ClockTimer, CLOCK_TIMER_DEVICE_ID);
+	MonoClock_Initialize(&ClockTimer);
+
+	Before = BusReads();
+	for (Index = 0; Index < STEADY_READS; Index++) {
+		(void)MonoClock_Now();
+	}
+	Reads = BusReads() - Before;
+	Ok = (Reads == 3ULL * STEADY_READS);
+	printf("%-34s %10.2f  %s\n", "AXI reads per MonoClock_Now",
+	       (double)Reads / STEADY_READS, Ok ? "ok" : "FAILED");
+	Failed |= !Ok;
+
+	Torn = RunThroughWraps(MonoClock_Now, &MaxReads);
+	Ok = (Torn == 0U) && (MaxReads <= 5U);
+	printf("%-34s %10u  %s\n", "torn reads across wraps", Torn,
+	       Ok ? "ok" : "FAILED");
+	printf("%-34s %10llu  %s\n", "most AXI reads at a carry",
+	       (unsigned long long)MaxReads, Ok ? "ok" : "FAILED");
+	Failed |= !Ok;
+
+	Plain = RunThroughWraps(PlainRead, &MaxReads);
+	printf("%-34s %10u  (for comparison)\n", "torn plain low/high reads", Plain);
+
+	First = MonoClock_Now();
+	Stamp = Timestamp_Now();
+	Second = MonoClock_Now();
+	Ok = ((u32)(Stamp - (u32)First) <= (u32)(Second - First));
+	printf("%-34s %10s  %s\n", "Timestamp_Now on the same clock", "",
+	       Ok ? "ok" : "FAILED");
+	Failed |= !Ok;
+
+	Ok = (MonoClock_TicksToNs(123456789ULL) == 1234567890ULL) &&
+	     (MonoClock_NsToTicks(1234567890ULL) == 123456789ULL) &&
+	     (MonoClock_TicksToUs(123456789ULL) == 1234567ULL) &&
+	     (MonoClock_UsToTicks(1234567ULL) == 123456700ULL) &&
+	     (MonoClock_TicksToNs(0xFFFFFFFFFFFULL) == 0x9FFFFFFFFFF6ULL);
+	printf("%-34s %10s  %s\n", "tick conversions", "",
+	       Ok ? "ok" : "FAILED");
+	Failed |= !Ok;
+
+	return Failed;
+}
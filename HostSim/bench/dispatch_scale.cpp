@@ -0,0 +1,225 @@
+/******************************************************************************
+* CAN ID dispatch cost against the number of registered IDs
+*
+* Registers 1 to CAN_DISPATCH_MAX_IDS identifiers with Tut10/can_dispatch.h,
+* half standard and half extended, and times a stream of frames of those
+* IDs through CanDispatch_Frame and through the compare chain it replaces
+* (a linear search, as RecvHandler did for its one ID). The times are host
+* nanoseconds per frame; what matters is that the table stays flat while
+* the chain grows with the IDs.
+*
+* For each set the acceptance filters are computed as for the controller
+* and applied to random traffic of unregistered IDs, to show how much of
+* it the hardware would drop before it raised an interrupt.
+*
+*	build/dispatch_scale
+*
+* The program exits non-zero if a frame reaches the wrong handler.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <stdio.h>
+#include <chrono>
+
+#include "xstatus.h"
+#include "can_dispatch.h"
+
+/************************** Constant Definitions *****************************/
+
+#define STREAM_FRAMES		4096U
+#define STREAM_PASSES		200U
+#define NOISE_FRAMES		100000U
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 Key;
+	CanDispatch_Handler Handler;
+	void *CallBackRef;
+} ChainEntry;
+
+/************************** Variable Definitions *****************************/
+
+static CanDispatch Dispatch;
+static ChainEntry Chain[CAN_DISPATCH_MAX_IDS];
+static u32 Stream[STREAM_FRAMES][4];
+static u32 Expected[STREAM_FRAMES];
+static u32 Hits[CAN_DISPATCH_MAX_IDS];
+static u32 RandomState = 0x12345678U;
+
+static const u32 IdCounts[] = { 1, 4, 16, 64, 128, 256, 512 };
+
+/*****************************************************************************/
+
+static u32 Random(void)
+{
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+	return RandomState;
+}
+
+static void CountFrame(void *CallBackRef, const u32 *FramePtr)
+{
+	(void)FramePtr;
+	Hits[(u32)(UINTPTR)CallBackRef]++;
+}
+
+/*
+ * ID number Index of a set: standard IDs spread over 0x100..0x6FF,
+ * extended ones J1939 style, source addresses under a few PGNs
+ */
+static u32 MakeKey(u32 Index, u32 *IdPtr, u32 *ExtendedPtr)
+{
+	u32 Id;
+
+	if ((Index & 1U) == 0U) {
+		Id = 0x100U + (Index / 2U) * 5U;
+		*IdPtr = Id;
+		*ExtendedPtr = FALSE;
+		return XCan_CreateIdValue(Id, 0U, 0U, 0U, 0U);
+	}
+
+	Id = 0x18FE0000U | (((Index / 2U) % 16U) << 8) | ((Index / 2U) / 16U);
+	*IdPtr = Id;
+	*ExtendedPtr = TRUE;
+	return XCan_CreateIdValue(Id >> 18, 1U, 1U, Id, 0U);
+}
+
+static void ChainFrame(u32 Entries, const u32 *FramePtr)
+{
+	u32 Key = FramePtr[0] & ((FramePtr[0] & XCAN_IDR_IDE_MASK) ?
+				 CAN_DISPATCH_EXTENDED_KEY :
+				 CAN_DISPATCH_STANDARD_KEY);
+	u32 Index;
+
+	for (Index = 0; Index < Entries; Index++) {
+		if (Chain[Index].Key == Key) {
+			Chain[Index].Handler(Chain[Index].CallBackRef, FramePtr);
+			return;
+		}
+	}
+}
+
+static double NsPerFrame(std::chrono::steady_clock::time_point Start)
+{
+	std::chrono::duration<double, std::nano> Elapsed =
+		std::chrono::steady_clock::now() - Start;
+
+	return Elapsed.count() / ((double)STREAM_FRAMES * STREAM_PASSES);
+}
+
+/* Fraction of random unregistered traffic the filters let through */
+static double FilterPassRate(void)
+{
+	u32 Passed = 0;
+	u32 Tried = 0;
+
+	while (Tried < NOISE_FRAMES) {
+		u32 Id = Random();
+		u32 Idr = (Id & 1U) ?
+			  XCan_CreateIdValue((Id >> 1) & 0x7FFU, 0U, 0U, 0U, 0U) :
+			  XCan_CreateIdValue((Id >> 19) & 0x7FFU, 1U, 1U,
+					     Id >> 1, 0U);
+		u32 Filter;
+
+		if (CanDispatch_Lookup(&Dispatch, Idr) != NULL) {
+			continue;
+		}
+		Tried++;
+		for (Filter = 0; Filter < Dispatch.NumFilters; Filter++) {
+			if ((Idr & Dispatch.FilterMask[Filter]) ==
+			    (Dispatch.FilterId[Filter] &
+			     Dispatch.FilterMask[Filter])) {
+				Passed++;
+				break;
+			}
+		}
+	}
+
+	return (double)Passed / NOISE_FRAMES;
+}
+
+int main()
+{
+	int Failed = 0;
+
+	printf("%6s %12s %12s %9s %10s\n", "IDs", "table ns", "chain ns",
+	       "rehashes", "noise in");
+
+	for (u32 Count : IdCounts) {
+		u32 Index;
+		u32 Pass;
+		double TableNs;
+		double ChainNs;
+
+		CanDispatch_Initialize(&Dispatch);
+		for (Index = 0; Index < Count; Index++) {
+			u32 Id;
+			u32 Extended;
+			u32 Key = MakeKey(Index, &Id, &Extended);
+
+			if (CanDispatch_Register(&Dispatch, Id, Extended,
+						 CountFrame,
+						 (void *)(UINTPTR)Index) !=
+			    XST_SUCCESS) {
+				printf("registering ID %u of %u failed\n",
+				       Index, Count);
+				return 1;
+			}
+			Chain[Index].Key = Key & CAN_DISPATCH_EXTENDED_KEY;
+			Chain[Index].Handler = CountFrame;
+			Chain[Index].CallBackRef = (void *)(UINTPTR)Index;
+		}
+		CanDispatch_ComputeFilters(&Dispatch, CAN_DISPATCH_MAX_FILTERS);
+
+		for (Index = 0; Index < STREAM_FRAMES; Index++) {
+			u32 Id;
+			u32 Extended;
+
+			Expected[Index] = Random() % Count;
+			Stream[Index][0] = MakeKey(Expected[Index], &Id,
+						   &Extended);
+			Stream[Index][1] = XCan_CreateDlcValue(8U);
+		}
+
+		/* Every frame reaches its own handler */
+		for (Index = 0; Index < Count; Index++) {
+			Hits[Index] = 0U;
+		}
+		for (Index = 0; Index < STREAM_FRAMES; Index++) {
+			u32 Before = Hits[Expected[Index]];
+
+			CanDispatch_Frame(&Dispatch, Stream[Index]);
+			if (Hits[Expected[Index]] != Before + 1U) {
+				Failed = 1;
+			}
+		}
+
+		auto Start = std::chrono::steady_clock::now();
+		for (Pass = 0; Pass < STREAM_PASSES; Pass++) {
+			for (Index = 0; Index < STREAM_FRAMES; Index++) {
+				CanDispatch_Frame(&Dispatch, Stream[Index]);
+			}
+		}
+		TableNs = NsPerFrame(Start);
+
+		Start = std::chrono::steady_clock::now();
+		for (Pass = 0; Pass < STREAM_PASSES; Pass++) {
+			for (Index = 0; Index < STREAM_FRAMES; Index++) {
+				ChainFrame(Count, Stream[Index]);
+			}
+		}
+		ChainNs = NsPerFrame(Start);
+
+		printf("%6u %12.1f %12.1f %9u %9.4f%%\n", Count, TableNs,
+		       ChainNs, Dispatch.Stats.Rehashes,
+		       100.0 * FilterPassRate());
+	}
+
+	if (Failed) {
+		printf("FAILED: frames reached the wrong handler\n");
+	}
+	return Failed;
+}
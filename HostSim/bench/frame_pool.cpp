@@ -0,0 +1,265 @@
+/******************************************************************************
+* Reference-counted frame pool against copying frames to each consumer
+*
+* Times, in host nanoseconds per frame, Tut10/can_pool.h handing each
+* received frame to 1 to 8 consumers by reference, against the copy of
+* the frame into a buffer of each consumer it replaces. Each consumer
+* reads the frame once. A classic CAN frame is only 16 bytes and the host
+* makes every atomic read-modify-write a locked, fenced instruction, so
+* here the copies win, by some 40 ns and 15 ns per extra consumer: the
+* pool is not for speed on a frame of this size but so that a frame is
+* never overwritten while a task still holds it, with no buffer of its
+* own per consumer. A Cortex-A9 does each count with an LDREX/STREX pair
+* of a few cycles.
+*
+* Then consumers hold each frame for a window of later frames, as a slow
+* task would, to show the occupancy reaching the pool size and the
+* allocations refused beyond it.
+*
+* Last, two host threads allocate and release against each other, which
+* interleaves the compare-and-swaps far more often than an interrupt
+* handler preempting a task does, and the free list is checked to still
+* hold every frame once.
+*
+*	build/frame_pool
+*
+* The program exits non-zero if a frame is lost or handed out twice.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+#include "can_pool.h"
+
+/************************** Constant Definitions *****************************/
+
+#define STREAM_FRAMES		1000000U
+#define MAX_CONSUMERS		8U
+
+/* Allocations of each thread of the stress run, and frames each holds */
+#define STRESS_FRAMES		2000000U
+#define STRESS_HOLD		16U
+
+/************************** Variable Definitions *****************************/
+
+static CanPool Pool;
+static u32 Buffer[MAX_CONSUMERS][CAN_POOL_FRAME_WORDS];
+static volatile u32 Sink;
+
+static const u32 ConsumerCounts[] = { 1, 2, 4, 8 };
+static const u32 HoldWindows[] = { 16, 48, 63, 64, 96 };
+
+/*****************************************************************************/
+
+static double NsPerFrame(std::chrono::steady_clock::time_point Start)
+{
+	std::chrono::duration<double, std::nano> Elapsed =
+		std::chrono::steady_clock::now() - Start;
+
+	return Elapsed.count() / STREAM_FRAMES;
+}
+
+/*
+ * Stands in for the receive handler filling a frame from the FIFO
+ */
+static void Fill(u32 *WordsPtr, u32 Number)
+{
+	WordsPtr[0] = 0x24600000U;
+	WordsPtr[1] = 0x80000000U;
+	WordsPtr[2] = Number;
+	WordsPtr[3] = ~Number;
+}
+
+/*
+ * Each consumer gets its own copy of the frame
+ */
+static double RunCopy(u32 Consumers)
+{
+	u32 Frame[CAN_POOL_FRAME_WORDS];
+	u32 Index;
+	u32 Consumer;
+	u32 Sum = 0U;
+	auto Start = std::chrono::steady_clock::now();
+
+	for (Index = 0U; Index < STREAM_FRAMES; Index++) {
+		Fill(Frame, Index);
+		for (Consumer = 0U; Consumer < Consumers; Consumer++) {
+			memcpy(Buffer[Consumer], Frame, sizeof(Frame));
+		}
+		for (Consumer = 0U; Consumer < Consumers; Consumer++) {
+			Sum += Buffer[Consumer][2];
+		}
+	}
+	Sink = Sum;
+
+	return NsPerFrame(Start);
+}
+
+/*
+ * Each consumer gets a reference to the one pool frame, the first the
+ * reference of the allocation
+ */
+static double RunRefs(u32 Consumers)
+{
+	CanPool_Frame *Held[MAX_CONSUMERS];
+	CanPool_Frame *FramePtr;
+	u32 Index;
+	u32 Consumer;
+	u32 Sum = 0U;
+	auto Start = std::chrono::steady_clock::now();
+
+	for (Index = 0U; Index < STREAM_FRAMES; Index++) {
+		FramePtr = CanPool_Alloc(&Pool);
+		Fill(FramePtr->Words, Index);
+		Held[0] = FramePtr;
+		for (Consumer = 1U; Consumer < Consumers; Consumer++) {
+			CanPool_Ref(FramePtr);
+			Held[Consumer] = FramePtr;
+		}
+		for (Consumer = 0U; Consumer < Consumers; Consumer++) {
+			Sum += Held[Consumer]->Words[2];
+			CanPool_Release(&Pool, Held[Consumer]);
+		}
+	}
+	Sink = Sum;
+
+	return NsPerFrame(Start);
+}
+
+/*
+ * Holds each frame until Window frames later
+ */
+static void RunHold(u32 Window)
+{
+	static CanPool_Frame *Held[256];
+	CanPool_Stats Stats;
+	u32 Index;
+	u32 Slot;
+
+	CanPool_Init(&Pool);
+	memset(Held, 0, sizeof(Held));
+	for (Index = 0U; Index < 100000U; Index++) {
+		Slot = Index % Window;
+		if (Held[Slot] != NULL) {
+			CanPool_Release(&Pool, Held[Slot]);
+		}
+		Held[Slot] = CanPool_Alloc(&Pool);
+	}
+	CanPool_GetStats(&Pool, &Stats);
+	printf("%8u %10u %10u %10u\n", Window, Stats.HighWatermark,
+	       Stats.Allocs, Stats.Exhausted);
+
+	for (Slot = 0U; Slot < Window; Slot++) {
+		if (Held[Slot] != NULL) {
+			CanPool_Release(&Pool, Held[Slot]);
+		}
+	}
+}
+
+/*
+ * Allocates and releases STRESS_FRAMES frames, holding STRESS_HOLD
+ */
+static void Stress(void)
+{
+	CanPool_Frame *Held[STRESS_HOLD] = { NULL };
+	u32 Index;
+	u32 Slot;
+
+	for (Index = 0U; Index < STRESS_FRAMES; Index++) {
+		Slot = Index % STRESS_HOLD;
+		if (Held[Slot] != NULL) {
+			if (Held[Slot]->Refs.load() != 1U) {
+				Sink = 1U;
+			}
+			CanPool_Release(&Pool, Held[Slot]);
+		}
+		Held[Slot] = CanPool_Alloc(&Pool);
+	}
+	for (Slot = 0U; Slot < STRESS_HOLD; Slot++) {
+		if (Held[Slot] != NULL) {
+			CanPool_Release(&Pool, Held[Slot]);
+		}
+	}
+}
+
+/*
+ * Takes every frame, checking each comes once, and gives them back
+ */
+static int CheckFreeList(void)
+{
+	static CanPool_Frame *Taken[CAN_POOL_FRAMES];
+	u8 Seen[CAN_POOL_FRAMES] = { 0 };
+	CanPool_Stats Stats;
+	u32 Count = 0U;
+	u32 Index;
+	int Ok = TRUE;
+
+	CanPool_GetStats(&Pool, &Stats);
+	if (Stats.InUse != 0U) {
+		Ok = FALSE;
+	}
+	while (Count < CAN_POOL_FRAMES) {
+		Taken[Count] = CanPool_Alloc(&Pool);
+		if (Taken[Count] == NULL) {
+			break;
+		}
+		Index = (u32)(Taken[Count] - Pool.Frame);
+		if (Seen[Index]) {
+			Ok = FALSE;
+		}
+		Seen[Index] = 1U;
+		Count++;
+	}
+	if ((Count != CAN_POOL_FRAMES) || (CanPool_Alloc(&Pool) != NULL)) {
+		Ok = FALSE;
+	}
+	for (Index = 0U; Index < Count; Index++) {
+		CanPool_Release(&Pool, Taken[Index]);
+	}
+
+	return Ok;
+}
+
+int main(void)
+{
+	CanPool_Stats Stats;
+	u32 Index;
+	int Ok;
+
+	CanPool_Init(&Pool);
+	printf("%u frames of %u bytes, host ns per frame\n\n",
+	       STREAM_FRAMES, (u32)sizeof(Buffer[0]));
+	printf("consumers       copy references\n");
+	for (Index = 0U; Index < sizeof(ConsumerCounts) / sizeof(u32);
+	     Index++) {
+		printf("%9u %10.1f %10.1f\n", ConsumerCounts[Index],
+		       RunCopy(ConsumerCounts[Index]),
+		       RunRefs(ConsumerCounts[Index]));
+	}
+	Ok = CheckFreeList();
+
+	printf("\nframes held for a window, pool of %u\n\n", CAN_POOL_FRAMES);
+	printf("  window  high mark     allocs  exhausted\n");
+	for (Index = 0U; Index < sizeof(HoldWindows) / sizeof(u32); Index++) {
+		RunHold(HoldWindows[Index]);
+		Ok = Ok && CheckFreeList();
+	}
+
+	CanPool_Init(&Pool);
+	Sink = 0U;
+	std::thread Other(Stress);
+	Stress();
+	Other.join();
+	CanPool_GetStats(&Pool, &Stats);
+	Ok = Ok && (Sink == 0U) && CheckFreeList();
+	printf("\n2 threads, %u allocations each: high mark %u, "
+	       "%u exhausted, free list %s\n", STRESS_FRAMES,
+	       Stats.HighWatermark, Stats.Exhausted,
+	       Ok ? "intact" : "BROKEN");
+
+	return Ok ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+/******************************************************************************
+* Typed AXI Timer register access against raw constants
+*
+* Runs each timer programming sequence of the tutorials twice on the
+* simulated timer, once as the original raw pointer stores of magic
+* constants and once through Tut10/axi_timer_regs.h, and checks that the
+* typed form costs no more:
+*
+*	- the values stored are the same, at compile time (static_assert)
+*	- it makes no more AXI transactions (SimBus_GetStats)
+*	- its code is no larger: each form lives in its own section and is
+*	  measured with the linker __start_/__stop_ symbols
+*
+* It also checks that Modify<> leaves a pending T0INT, which is
+* write-one-to-clear, alone unless it names it.
+*
+*	build/regs_check
+*
+* The program exits non-zero if a check fails.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <stdio.h>
+
+#include "xparameters.h"
+#include "axi_timer_regs.h"
+#include "hostsim.h"
+
+/************************** Constant Definitions *****************************/
+
+#define TIMER_BASEADDR		XPAR_TMRCTR_0_BASEADDR
+#define TIMER_LOAD_VALUE	0xFFFF0000U
+
+/**************************** Type Definitions *******************************/
+
+using Timer0 = AxiTimer_Counter<TIMER_BASEADDR, 0>;
+
+typedef void (*SequenceFunc)(void);
+
+typedef struct {
+	const char *Name;
+	SequenceFunc Legacy;
+	SequenceFunc Typed;
+} Sequence;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+#define LEGACY	__attribute__((noinline, section("regs_legacy")))
+#define TYPED	__attribute__((noinline, section("regs_typed")))
+
+/************************** Variable Definitions *****************************/
+
+/* The typed values are the constants the tutorials wrote */
+static_assert((TCSR_GENT | TCSR_LOAD).Bits == 0x0024U, "Tut9/Q2.cpp");
+static_assert((TCSR_UDT | TCSR_GENT | TCSR_ARHT | TCSR_LOAD | TCSR_ENT).Bits ==
+	      0x00B6U, "Tut8/q2.cpp");
+static_assert((TCSR_ENT | TCSR_ENIT | TCSR_LOAD | TCSR_ARHT | TCSR_GENT).Bits ==
+	      0x00F4U, "Tut10/intrrupt.cpp, load");
+static_assert((TCSR_ENT | TCSR_ENIT | TCSR_ARHT | TCSR_GENT).Bits == 0x00D4U,
+	      "Tut10/intrrupt.cpp, run");
+
+/* Section bounds, provided by the linker */
+extern const char __start_regs_legacy[], __stop_regs_legacy[];
+extern const char __start_regs_typed[], __stop_regs_typed[];
+
+/*****************************************************************************/
+/*
+ * Tut9/Q2.cpp: GENERATEOUT on and load
+ */
+LEGACY static void Q2_Legacy(void)
+{
+	volatile u32 *TmrCtr_Ptr = (volatile u32 *)TIMER_BASEADDR;
+
+	*(TmrCtr_Ptr + 0) = 0x0024;
+}
+
+TYPED static void Q2_Typed(void)
+{
+	Timer0::TCSR::Write<TCSR_GENT | TCSR_LOAD>();
+}
+
+/*
+ * Tut8/q2.cpp: count down with auto reload, GENERATEOUT on, load, run
+ */
+LEGACY static void Q2Tut8_Legacy(void)
+{
+	volatile u32 *TmrCtr_Ptr = (volatile u32 *)TIMER_BASEADDR;
+
+	*(TmrCtr_Ptr + 0) = 0x000B6;
+}
+
+TYPED static void Q2Tut8_Typed(void)
+{
+	Timer0::TCSR::Write<TCSR_UDT | TCSR_GENT | TCSR_ARHT | TCSR_LOAD |
+			    TCSR_ENT>();
+}
+
+/*
+ * Tut10/intrrupt.cpp: reset value, load with interrupts and auto reload,
+ * then run
+ */
+LEGACY static void Intrrupt_Legacy(void)
+{
+	volatile u32 *timer_ptr = (volatile u32 *)TIMER_BASEADDR;
+
+	*(timer_ptr + 1) = TIMER_LOAD_VALUE;
+	*(timer_ptr + 0) = 0x00F4;
+	*(timer_ptr + 0) = 0x00D4;
+}
+
+TYPED static void Intrrupt_Typed(void)
+{
+	Timer0::TLR::Write(TLR_VALUE(TIMER_LOAD_VALUE));
+	Timer0::TCSR::Write<TCSR_ENT | TCSR_ENIT | TCSR_LOAD | TCSR_ARHT |
+			    TCSR_GENT>();
+	Timer0::TCSR::Write<TCSR_ENT | TCSR_ENIT | TCSR_ARHT | TCSR_GENT>();
+}
+
+/*
+ * Clear LOAD and set ENT in a running configuration, as the driver does
+ * it: one read-modify-write per field
+ */
+LEGACY static void Start_Legacy(void)
+{
+	volatile u32 *TmrCtr_Ptr = (volatile u32 *)TIMER_BASEADDR;
+
+	*TmrCtr_Ptr = *TmrCtr_Ptr & ~XTC_CSR_LOAD_MASK;
+	*TmrCtr_Ptr = *TmrCtr_Ptr | XTC_CSR_ENABLE_TMR_MASK;
+}
+
+TYPED static void Start_Typed(void)
+{
+	Timer0::TCSR::Modify<~TCSR_LOAD | TCSR_ENT>();
+}
+
+static const Sequence Sequences[] = {
+	{ "Tut9/Q2.cpp TCSR0", Q2_Legacy, Q2_Typed },
+	{ "Tut8/q2.cpp TCSR0", Q2Tut8_Legacy, Q2Tut8_Typed },
+	{ "intrrupt.cpp setup", Intrrupt_Legacy, Intrrupt_Typed },
+	{ "load then start", Start_Legacy, Start_Typed },
+};
+
+/*****************************************************************************/
+/*
+ * Runs one sequence and returns its AXI transactions and the TCSR0 and
+ * TLR0 values it leaves
+ */
+static u64 RunSequence(SequenceFunc Func, u32 *TcsrPtr, u32 *TlrPtr)
+{
+	SimBusStats Before;
+	SimBusStats After;
+
+	/* Same starting point for both forms */
+	Timer0::TLR::Write(TLR_VALUE(0U));
+	Timer0::TCSR::Write<TCSR_LOAD>();
+	Timer0::TCSR::Write<~TCSR_LOAD>();
+
+	SimBus_GetStats(TIMER_BASEADDR, &Before);
+	Func();
+	SimBus_GetStats(TIMER_BASEADDR, &After);
+
+	*TcsrPtr = Timer0::TCSR::Read() & ~TCSR_T0INT.Bits;
+	*TlrPtr = Timer0::TLR::Read();
+
+	return (After.Reads - Before.Reads) + (After.Writes - Before.Writes);
+}
+
+/*
+ * Lets the counter reach its terminal count, then changes other TCSR
+ * fields with Modify<>. Returns non-zero unless T0INT is still pending
+ * after that and cleared by a Modify<> that names it.
+ */
+static int CheckModifyW1c(void)
+{
+	bool Raised;
+	bool Kept;
+	bool Cleared;
+
+	Timer0::TLR::Write(TLR_VALUE(0xFFFFFF00U));
+	Timer0::TCSR::Write<TCSR_LOAD>();
+	Timer0::TCSR::Write<TCSR_ENT>();
+	SimCpu_Burn(1000U);
+	Raised = Timer0::TCSR::Test<TCSR_T0INT>();
+
+	Timer0::TCSR::Modify<~TCSR_ENT | TCSR_GENT>();
+	Kept = Timer0::TCSR::Test<TCSR_T0INT>();
+
+	Timer0::TCSR::Modify<TCSR_T0INT>();
+	Cleared = !Timer0::TCSR::Test<TCSR_T0INT>();
+
+	printf("%-22s %10s %10s  %s\n", "T0INT across Modify<>",
+	       Raised ? "pending" : "none", Kept ? "kept" : "lost",
+	       (Raised && Kept && Cleared) ? "ok" : "FAILED");
+
+	return !(Raised && Kept && Cleared);
+}
+
+int main()
+{
+	long LegacySize = __stop_regs_legacy - __start_regs_legacy;
+	long TypedSize = __stop_regs_typed - __start_regs_typed;
+	int Failed = 0;
+
+	printf("%-22s %10s %10s  %s\n", "sequence", "legacy", "typed",
+	       "AXI transactions");
+
+	for (const Sequence &Seq : Sequences) {
+		u32 LegacyTcsr, LegacyTlr;
+		u32 TypedTcsr, TypedTlr;
+		u64 Legacy = RunSequence(Seq.Legacy, &LegacyTcsr, &LegacyTlr);
+		u64 Typed = RunSequence(Seq.Typed, &TypedTcsr, &TypedTlr);
+		int Ok = (Typed <= Legacy) && (TypedTcsr == LegacyTcsr) &&
+			 (TypedTlr == LegacyTlr);
+
+		printf("%-22s %10llu %10llu  %s\n", Seq.Name,
+		       (unsigned long long)Legacy, (unsigned long long)Typed,
+		       Ok ? "ok" : "FAILED");
+		Failed |= !Ok;
+	}
+
+	printf("%-22s %10ld %10ld  %s\n", "code bytes", LegacySize, TypedSize,
+	       (TypedSize <= LegacySize) ? "ok" : "FAILED");
+	Failed |= (TypedSize > LegacySize);
+
+	Failed |= CheckModifyW1c();
+
+	return Failed;
+}
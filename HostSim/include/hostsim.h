@@ -0,0 +1,136 @@
+/******************************************************************************
+* Host-side peripheral simulator
+*
+* The simulator stands in for the standalone BSP and the XGpio, XTmrCtr,
+* XCan, XCanFd and XScuGic drivers so that the tutorial applications build
+* and run unchanged on a Linux host. The peripherals are register-level
+* models mapped at their xparameters.h base addresses; simulated interrupts
+* are routed through a GIC model into the handlers registered with
+* Xil_ExceptionRegisterHandler and XScuGic_Connect.
+*
+* Simulated time is kept in picoseconds. It advances with the host time the
+* application spends executing (scaled by HOSTSIM_CPU_SCALE), with the
+* modelled cost of every AXI register access, and by skipping ahead to the
+* next peripheral event whenever the CPU waits for an interrupt.
+*
+* The environment variables below tune a run without touching the
+* application:
+*
+*	HOSTSIM_CPU_SCALE	ratio of simulated to host execution time
+*				(default 1.0)
+*	HOSTSIM_STOP_AFTER_MS	end the run after this much simulated time
+*	HOSTSIM_REPORT		print the statistics report at exit when set
+*	HOSTSIM_SWITCH_MS	step the switches on GPIO channel 2 through
+*				0 to 7, one position every this many ms
+*	HOSTSIM_SWITCH_BOUNCE_US	contact bounce after each switch flip,
+*				in microseconds (default none)
+*	HOSTSIM_LOAD		file@address[,file@address...]: map files
+*				into memory before main(), as XSDB
+*				"dow -data" loads them into DDR; the address
+*				must be page aligned
+*	HOSTSIM_CAN_FAULT	at_ms:length_ms: bit errors on every frame
+*				the first CAN controller transmits for
+*				length_ms from at_ms, see SimCan_InjectFault
+*
+* This header is for benchmark and regression programs only; the tutorial
+* applications never include it.
+******************************************************************************/
+
+#ifndef HOSTSIM_H		/* prevent circular inclusions */
+#define HOSTSIM_H
+
+#include <stdio.h>
+#include "xil_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define SIM_TIME_NEVER		(~(SimTime)0)
+
+/**************************** Type Definitions *******************************/
+
+typedef u64 SimTime;		/**< Simulated time in picoseconds */
+
+typedef void (*SimEventHandler)(void *CallBackRef);
+
+/* Called with each frame acknowledged on a CAN bus, XCan_Recv layout */
+typedef void (*SimCanMonitor)(void *CallBackRef, SimTime At,
+			      const u32 *FramePtr);
+
+typedef struct {
+	u64 Reads;		/**< AXI read transactions */
+	u64 Writes;		/**< AXI write transactions */
+} SimBusStats;
+
+typedef struct {
+	u64 Count;		/**< Interrupts acknowledged */
+	SimTime MinLatency;	/**< Assertion to acknowledge, minimum */
+	SimTime MaxLatency;	/**< Assertion to acknowledge, maximum */
+	SimTime TotalLatency;	/**< Sum of all latencies */
+} SimIrqStats;
+
+typedef struct {
+	SimTime Now;		/**< Current simulated time */
+	SimTime Idle;		/**< Time spent waiting for interrupts */
+	SimTime Irq;		/**< Time spent in interrupt handlers */
+} SimCpuStats;
+
+typedef struct {
+	u64 TxFrames;		/**< Frames transmitted successfully */
+	u64 RxFrames;		/**< Frames stored in the RX FIFO */
+	u64 RxOverflows;	/**< Frames lost to a full RX FIFO */
+	u64 RxFiltered;		/**< Frames rejected by acceptance filters */
+	u64 ArbitrationLost;	/**< Arbitration rounds lost */
+	u32 RxFifoPeak;		/**< Highest RX FIFO occupancy seen */
+	u64 TxErrors;		/**< Transmissions failed by a fault */
+	u64 BusOffs;		/**< Times the controller went bus-off */
+} SimCanStats;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+#define SIM_NS(x)	((SimTime)(x) * 1000ULL)
+#define SIM_US(x)	((SimTime)(x) * 1000000ULL)
+#define SIM_MS(x)	((SimTime)(x) * 1000000000ULL)
+
+/************************** Function Prototypes ******************************/
+
+/* Time */
+SimTime SimNow(void);
+SimTime SimCyclesToTime(u64 Cycles, u32 FreqHz);
+u64 SimTimeToCycles(SimTime Time, u32 FreqHz);
+void SimSchedule(SimTime At, SimEventHandler Handler, void *CallBackRef);
+void SimStopAt(SimTime At);
+
+/* Processor */
+void SimCpu_Burn(u32 CpuCycles);
+void SimCpu_WaitForInterrupt(void);
+void SimCpu_GetStats(SimCpuStats *StatsPtr);
+
+/* Interconnect and interrupt controller */
+int SimBus_GetStats(UINTPTR BaseAddress, SimBusStats *StatsPtr);
+void SimBus_SetAccessCost(SimTime ReadCost, SimTime WriteCost);
+void SimIrq_GetStats(u32 IntrId, SimIrqStats *StatsPtr);
+
+/* Peripheral stimulus and observation */
+void SimGpio_SetInput(UINTPTR BaseAddress, unsigned Channel, u32 Value);
+u32 SimGpio_GetOutput(UINTPTR BaseAddress, unsigned Channel);
+void SimCan_InjectFrame(UINTPTR BaseAddress, SimTime At, const u32 *FramePtr);
+void SimCan_GetStats(UINTPTR BaseAddress, SimCanStats *StatsPtr);
+void SimCan_SetAck(UINTPTR BaseAddress, int Enable);
+void SimCan_SetMonitor(UINTPTR BaseAddress, SimCanMonitor Handler,
+		       void *CallBackRef);
+void SimCan_InjectFault(UINTPTR BaseAddress, SimTime From, SimTime Until,
+			u32 ErrorMask);
+void SimCanFd_GetStats(UINTPTR BaseAddress, SimCanStats *StatsPtr);
+
+/* Reporting */
+void SimReport(FILE *Out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* end of protection macro */
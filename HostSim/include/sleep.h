@@ -0,0 +1,26 @@
+/******************************************************************************
+* Host simulator replacement for the standalone BSP sleep.h.
+*
+* The BSP versions busy-wait on the global timer. The host versions advance
+* simulated time by the requested amount, delivering any interrupts that
+* fall due in the meantime.
+******************************************************************************/
+
+#ifndef SLEEP_H		/* prevent circular inclusions */
+#define SLEEP_H
+
+#include <unistd.h>
+#include "xil_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int usleep(useconds_t useconds);
+unsigned int sleep(unsigned int seconds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* end of protection macro */
@@ -0,0 +1,166 @@
+/******************************************************************************
+* Host simulator replacement for the can driver xcan.h.
+******************************************************************************/
+
+#ifndef XCAN_H			/* prevent circular inclusions */
+#define XCAN_H
+
+#include "xil_types.h"
+#include "xil_assert.h"
+#include "xstatus.h"
+#include "xcan_l.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************** Constant Definitions *****************************/
+
+/** @name CAN operation modes
+ *  @{
+ */
+#define XCAN_MODE_CONFIG	0x00000001 /**< Configuration mode */
+#define XCAN_MODE_NORMAL	0x00000002 /**< Normal mode */
+#define XCAN_MODE_LOOPBACK	0x00000004 /**< Loop Back mode */
+#define XCAN_MODE_SLEEP		0x00000008 /**< Sleep mode */
+/* @} */
+
+/** @name Callback identifiers used as parameters to XCan_SetHandler()
+ *  @{
+ */
+#define XCAN_HANDLER_SEND	1 /**< Handler type for frame sending interrupt */
+#define XCAN_HANDLER_RECV	2 /**< Handler type for frame reception interrupt */
+#define XCAN_HANDLER_ERROR	3 /**< Handler type for error interrupt */
+#define XCAN_HANDLER_EVENT	4 /**< Handler type for all other interrupts */
+/* @} */
+
+/* Maximum size of a CAN frame in bytes: ID, DLC and two data words */
+#define XCAN_MAX_FRAME_SIZE	sizeof(u32) * 4
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u16 DeviceId;		/**< Unique ID of device */
+	UINTPTR BaseAddress;	/**< Register base address */
+	u32 NumOfAcceptFilters;	/**< Number of Acceptance Filters */
+} XCan_Config;
+
+typedef void (*XCan_SendRecvHandler) (void *CallBackRef);
+typedef void (*XCan_ErrorHandler) (void *CallBackRef, u32 ErrorMask);
+typedef void (*XCan_EventHandler) (void *CallBackRef, u32 Mask);
+
+typedef struct {
+	XCan_Config CanConfig;		/**< Hardware configuration */
+	u32 IsReady;			/**< Device is initialized and ready */
+
+	XCan_SendRecvHandler SendHandler;
+	void *SendRef;
+
+	XCan_SendRecvHandler RecvHandler;
+	void *RecvRef;
+
+	XCan_ErrorHandler ErrorHandler;
+	void *ErrorRef;
+
+	XCan_EventHandler EventHandler;
+	void *EventRef;
+} XCan;
+
+/************************** Variable Definitions *****************************/
+
+extern XCan_Config XCan_ConfigTable[];
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+#define XCan_IsTxDone(InstancePtr) \
+	(((XCan_ReadReg(((InstancePtr)->CanConfig.BaseAddress), \
+		XCAN_ISR_OFFSET) & XCAN_IXR_TXOK_MASK) != 0) ? TRUE : FALSE)
+
+#define XCan_IsTxFifoFull(InstancePtr) \
+	(((XCan_ReadReg(((InstancePtr)->CanConfig.BaseAddress), \
+		XCAN_SR_OFFSET) & XCAN_SR_TXFLL_MASK) != 0) ? TRUE : FALSE)
+
+#define XCan_IsHighPriorityBufFull(InstancePtr) \
+	(((XCan_ReadReg(((InstancePtr)->CanConfig.BaseAddress), \
+		XCAN_SR_OFFSET) & XCAN_SR_TXBFLL_MASK) != 0) ? TRUE : FALSE)
+
+#define XCan_IsRxEmpty(InstancePtr) \
+	(((XCan_ReadReg(((InstancePtr)->CanConfig.BaseAddress), \
+		XCAN_ISR_OFFSET) & XCAN_IXR_RXNEMP_MASK) != 0) ? FALSE : TRUE)
+
+#define XCan_IsAcceptFilterBusy(InstancePtr) \
+	(((XCan_ReadReg(((InstancePtr)->CanConfig.BaseAddress), \
+		XCAN_SR_OFFSET) & XCAN_SR_ACFBSY_MASK) != 0) ? TRUE : FALSE)
+
+#define XCan_CreateIdValue(StandardId, SubRemoteTransReq, IdExtension, \
+		ExtendedId, RemoteTransReq) \
+	((((StandardId) << XCAN_IDR_ID1_SHIFT) & XCAN_IDR_ID1_MASK) | \
+	(((SubRemoteTransReq) << XCAN_IDR_SRR_SHIFT) & XCAN_IDR_SRR_MASK) | \
+	(((IdExtension) << XCAN_IDR_IDE_SHIFT) & XCAN_IDR_IDE_MASK) | \
+	(((ExtendedId) << XCAN_IDR_ID2_SHIFT) & XCAN_IDR_ID2_MASK) | \
+	((RemoteTransReq) & XCAN_IDR_RTR_MASK))
+
+#define XCan_CreateDlcValue(DataLengCode) \
+	(((DataLengCode) << XCAN_DLCR_DLC_SHIFT) & XCAN_DLCR_DLC_MASK)
+
+/************************** Function Prototypes ******************************/
+
+/*
+ * Functions in xcan.c
+ */
+int XCan_Initialize(XCan *InstancePtr, u16 DeviceId);
+int XCan_CfgInitialize(XCan *InstancePtr, XCan_Config *ConfigPtr,
+		       UINTPTR EffectiveAddr);
+void XCan_Reset(XCan *InstancePtr);
+u8 XCan_GetMode(XCan *InstancePtr);
+void XCan_EnterMode(XCan *InstancePtr, u8 OperationMode);
+u32 XCan_GetStatus(XCan *InstancePtr);
+void XCan_GetBusErrorCounter(XCan *InstancePtr, u8 *RxErrorCount,
+			     u8 *TxErrorCount);
+u32 XCan_GetBusErrorStatus(XCan *InstancePtr);
+void XCan_ClearBusErrorStatus(XCan *InstancePtr, u32 Mask);
+int XCan_Send(XCan *InstancePtr, u32 *FramePtr);
+int XCan_Recv(XCan *InstancePtr, u32 *FramePtr);
+int XCan_SendHighPriority(XCan *InstancePtr, u32 *FramePtr);
+void XCan_AcceptFilterEnable(XCan *InstancePtr, u32 FilterIndexes);
+void XCan_AcceptFilterDisable(XCan *InstancePtr, u32 FilterIndexes);
+u32 XCan_AcceptFilterGetEnabledList(XCan *InstancePtr);
+int XCan_AcceptFilterSet(XCan *InstancePtr, u32 FilterIndex,
+			 u32 MaskValue, u32 IdValue);
+void XCan_AcceptFilterGet(XCan *InstancePtr, u32 FilterIndex,
+			  u32 *MaskValue, u32 *IdValue);
+XCan_Config *XCan_LookupConfig(u16 DeviceId);
+XCan_Config *XCan_GetConfig(unsigned int InstanceIndex);
+
+/*
+ * Configuration functions in xcan_config.c
+ */
+int XCan_SetBaudRatePrescaler(XCan *InstancePtr, u8 Prescaler);
+u8 XCan_GetBaudRatePrescaler(XCan *InstancePtr);
+int XCan_SetBitTiming(XCan *InstancePtr, u8 SyncJumpWidth,
+		      u8 TimeSegment2, u8 TimeSegment1);
+void XCan_GetBitTiming(XCan *InstancePtr, u8 *SyncJumpWidth,
+		       u8 *TimeSegment2, u8 *TimeSegment1);
+
+/*
+ * Diagnostic functions in xcan_selftest.c
+ */
+int XCan_SelfTest(XCan *InstancePtr);
+
+/*
+ * Functions in xcan_intr.c
+ */
+void XCan_InterruptEnable(XCan *InstancePtr, u32 Mask);
+void XCan_InterruptDisable(XCan *InstancePtr, u32 Mask);
+u32 XCan_InterruptGetEnabled(XCan *InstancePtr);
+u32 XCan_InterruptGetStatus(XCan *InstancePtr);
+void XCan_InterruptClear(XCan *InstancePtr, u32 Mask);
+void XCan_IntrHandler(void *InstancePtr);
+int XCan_SetHandler(XCan *InstancePtr, u32 HandlerType,
+		    void *CallBackFunc, void *CallBackRef);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* end of protection macro */
@@ -0,0 +1,185 @@
+/******************************************************************************
+* Host simulator replacement for the canfd driver xcanfd.h.
+*
+* The AXI CAN FD controller sends from TX buffers, each marked ready by its
+* bit of the TX Ready Request Register (TRR), and receives into RX FIFO 0,
+* read in sequence. Frames are held as XCANFD_MAX_FRAME_SIZE words: the ID
+* and DLC registers, then up to 16 data words with data byte k at byte k of
+* the buffer.
+******************************************************************************/
+
+#ifndef XCANFD_H		/* prevent circular inclusions */
+#define XCANFD_H
+
+#include "xil_types.h"
+#include "xil_assert.h"
+#include "xstatus.h"
+#include "xcanfd_l.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************** Constant Definitions *****************************/
+
+/** @name CAN FD operation modes
+ *  @{
+ */
+#define XCANFD_MODE_CONFIG	0x00000001 /**< Configuration mode */
+#define XCANFD_MODE_NORMAL	0x00000002 /**< Normal mode */
+#define XCANFD_MODE_LOOPBACK	0x00000004 /**< Loop Back mode */
+#define XCANFD_MODE_SLEEP	0x00000008 /**< Sleep mode */
+/* @} */
+
+/** @name Callback identifiers used as parameters to XCanFd_SetHandler()
+ *  @{
+ */
+#define XCANFD_HANDLER_SEND	1 /**< Handler for frame sending interrupt */
+#define XCANFD_HANDLER_RECV	2 /**< Handler for frame reception interrupt */
+#define XCANFD_HANDLER_ERROR	3 /**< Handler for error interrupt */
+#define XCANFD_HANDLER_EVENT	4 /**< Handler for all other interrupts */
+/* @} */
+
+/* RX FIFO 0 read in sequence; the mailbox mode is not simulated */
+#define XCANFD_RX_FIFO_MODE	0U
+
+/* Maximum size of a CAN FD frame in bytes: ID, DLC and 16 data words */
+#define XCANFD_MAX_FRAME_SIZE	(sizeof(u32) * 18U)
+
+/* Longest data field, of DLC 15 */
+#define XCANFD_MAX_DATA_LENGTH	64U
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u16 DeviceId;		/**< Unique ID of device */
+	UINTPTR BaseAddress;	/**< Register base address */
+	u32 Rx_Mode;		/**< XCANFD_RX_FIFO_MODE */
+	u32 NumofRxMbBuf;	/**< RX FIFO 0 depth in FIFO mode */
+	u32 NumofTxBuf;		/**< Number of TX buffers */
+} XCanFd_Config;
+
+typedef void (*XCanFd_SendRecvHandler) (void *CallBackRef);
+typedef void (*XCanFd_ErrorHandler) (void *CallBackRef, u32 ErrorMask);
+typedef void (*XCanFd_EventHandler) (void *CallBackRef, u32 Mask);
+
+typedef struct {
+	XCanFd_Config CanFdConfig;	/**< Hardware configuration */
+	u32 IsReady;			/**< Device is initialized and ready */
+	u32 FreeTxBufferIndex;		/**< TX buffer XCanFd_Send fills next */
+
+	XCanFd_SendRecvHandler SendHandler;
+	void *SendRef;
+
+	XCanFd_SendRecvHandler RecvHandler;
+	void *RecvRef;
+
+	XCanFd_ErrorHandler ErrorHandler;
+	void *ErrorRef;
+
+	XCanFd_EventHandler EventHandler;
+	void *EventRef;
+} XCanFd;
+
+/************************** Variable Definitions *****************************/
+
+extern XCanFd_Config XCanFd_ConfigTable[];
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+#define XCanFd_IsBufferTransmitted(InstancePtr, TxBuffer) \
+	(((XCanFd_ReadReg(((InstancePtr)->CanFdConfig.BaseAddress), \
+		XCANFD_TRR_OFFSET) & (1U << (TxBuffer))) != 0) ? FALSE : TRUE)
+
+#define XCanFd_GetRxFillLevel(InstancePtr) \
+	((XCanFd_ReadReg(((InstancePtr)->CanFdConfig.BaseAddress), \
+		XCANFD_FSR_OFFSET) & XCANFD_FSR_FL_MASK) >> \
+	 XCANFD_FSR_FL_SHIFT)
+
+#define XCanFd_CreateIdValue(StandardId, SubRemoteTransReq, IdExtension, \
+		ExtendedId, RemoteTransReq) \
+	((((StandardId) << XCANFD_IDR_ID1_SHIFT) & XCANFD_IDR_ID1_MASK) | \
+	(((SubRemoteTransReq) << XCANFD_IDR_SRR_SHIFT) & \
+	 XCANFD_IDR_SRR_MASK) | \
+	(((IdExtension) << XCANFD_IDR_IDE_SHIFT) & XCANFD_IDR_IDE_MASK) | \
+	(((ExtendedId) << XCANFD_IDR_ID2_SHIFT) & XCANFD_IDR_ID2_MASK) | \
+	((RemoteTransReq) & XCANFD_IDR_RTR_MASK))
+
+/* DLC register of a classic frame */
+#define XCanFd_CreateDlcValue(DataLengCode) \
+	(((DataLengCode) << XCANFD_DLCR_DLC_SHIFT) & XCANFD_DLCR_DLC_MASK)
+
+/* DLC register of a CAN FD frame, with and without the bit rate switch */
+#define XCanFd_Create_CanFD_Dlc_BrsValue(DataLengCode) \
+	(XCanFd_CreateDlcValue(DataLengCode) | XCANFD_DLCR_EDL_MASK | \
+	 XCANFD_DLCR_BRS_MASK)
+
+#define XCanFd_Create_CanFD_DlcValue(DataLengCode) \
+	(XCanFd_CreateDlcValue(DataLengCode) | XCANFD_DLCR_EDL_MASK)
+
+/* Reads the next frame of RX FIFO 0 */
+#define XCanFd_Recv(InstancePtr, FramePtr) \
+	XCanFd_Recv_Sequential((InstancePtr), (FramePtr))
+
+/************************** Function Prototypes ******************************/
+
+/*
+ * Functions in xcanfd.c
+ */
+int XCanFd_CfgInitialize(XCanFd *InstancePtr, XCanFd_Config *ConfigPtr,
+			 UINTPTR EffectiveAddr);
+void XCanFd_Reset(XCanFd *InstancePtr);
+u8 XCanFd_GetMode(XCanFd *InstancePtr);
+void XCanFd_EnterMode(XCanFd *InstancePtr, u8 OperationMode);
+u32 XCanFd_GetStatus(XCanFd *InstancePtr);
+void XCanFd_GetBusErrorCounter(XCanFd *InstancePtr, u8 *RxErrorCount,
+			       u8 *TxErrorCount);
+u32 XCanFd_GetBusErrorStatus(XCanFd *InstancePtr);
+void XCanFd_ClearBusErrorStatus(XCanFd *InstancePtr, u32 Mask);
+int XCanFd_Send(XCanFd *InstancePtr, u32 *FramePtr, u32 *TxBufferNumber);
+int XCanFd_Recv_Sequential(XCanFd *InstancePtr, u32 *FramePtr);
+u32 XCanFd_GetFreeBuffer(XCanFd *InstancePtr);
+int XCanFd_GetDlc2len(u32 Dlc, u32 Edl);
+u8 XCanFd_GetLen2Dlc(int Len);
+void XCanFd_SetBitRateSwitch_DisableNominal(XCanFd *InstancePtr);
+void XCanFd_SetBitRateSwitch_EnableNominal(XCanFd *InstancePtr);
+XCanFd_Config *XCanFd_LookupConfig(u16 DeviceId);
+
+/*
+ * Configuration functions in xcanfd_config.c
+ */
+int XCanFd_SetBaudRatePrescaler(XCanFd *InstancePtr, u8 Prescaler);
+u8 XCanFd_GetBaudRatePrescaler(XCanFd *InstancePtr);
+int XCanFd_SetBitTiming(XCanFd *InstancePtr, u8 SyncJumpWidth,
+			u8 TimeSegment2, u8 TimeSegment1);
+void XCanFd_GetBitTiming(XCanFd *InstancePtr, u8 *SyncJumpWidth,
+			 u8 *TimeSegment2, u8 *TimeSegment1);
+int XCanFd_SetFBaudRatePrescaler(XCanFd *InstancePtr, u8 Prescaler);
+u8 XCanFd_GetFBaudRatePrescaler(XCanFd *InstancePtr);
+int XCanFd_SetFBitTiming(XCanFd *InstancePtr, u8 SyncJumpWidth,
+			 u8 TimeSegment2, u8 TimeSegment1);
+void XCanFd_GetFBitTiming(XCanFd *InstancePtr, u8 *SyncJumpWidth,
+			  u8 *TimeSegment2, u8 *TimeSegment1);
+
+/*
+ * Diagnostic functions in xcanfd_selftest.c
+ */
+int XCanFd_SelfTest(XCanFd *InstancePtr);
+
+/*
+ * Functions in xcanfd_intr.c
+ */
+void XCanFd_InterruptEnable(XCanFd *InstancePtr, u32 Mask);
+void XCanFd_InterruptDisable(XCanFd *InstancePtr, u32 Mask);
+u32 XCanFd_InterruptGetEnabled(XCanFd *InstancePtr);
+u32 XCanFd_InterruptGetStatus(XCanFd *InstancePtr);
+void XCanFd_InterruptClear(XCanFd *InstancePtr, u32 Mask);
+void XCanFd_IntrHandler(void *InstancePtr);
+int XCanFd_SetHandler(XCanFd *InstancePtr, u32 HandlerType,
+		      void *CallBackFunc, void *CallBackRef);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* end of protection macro */
@@ -0,0 +1,202 @@
+/******************************************************************************
+* Host simulator replacement for the canfd driver xcanfd_l.h.
+*
+* Register offsets and masks of the AXI CAN FD controller (PG223), as far as
+* the simulated core implements them: TX buffers with ready requests, the
+* sequential RX FIFO 0 and the nominal and data phase bit timing. There are
+* no mailbox RX buffers, acceptance filters or timestamps.
+******************************************************************************/
+
+#ifndef XCANFD_L_H	/* prevent circular inclusions */
+#define XCANFD_L_H
+
+#include "xil_types.h"
+#include "xil_assert.h"
+#include "xil_io.h"
+
+/************************** Constant Definitions *****************************/
+
+/** @name Register offsets for the CAN FD. Each register is 32 bits.
+ *  @{
+ */
+#define XCANFD_SRR_OFFSET	0x000  /**< Software Reset Register */
+#define XCANFD_MSR_OFFSET	0x004  /**< Mode Select Register */
+#define XCANFD_BRPR_OFFSET	0x008  /**< Arbitration Phase Prescaler */
+#define XCANFD_BTR_OFFSET	0x00C  /**< Arbitration Phase Bit Timing */
+#define XCANFD_ECR_OFFSET	0x010  /**< Error Counter Register */
+#define XCANFD_ESR_OFFSET	0x014  /**< Error Status Register */
+#define XCANFD_SR_OFFSET	0x018  /**< Status Register */
+
+#define XCANFD_ISR_OFFSET	0x01C  /**< Interrupt Status Register */
+#define XCANFD_IER_OFFSET	0x020  /**< Interrupt Enable Register */
+#define XCANFD_ICR_OFFSET	0x024  /**< Interrupt Clear Register */
+
+#define XCANFD_F_BRPR_OFFSET	0x088  /**< Data Phase Prescaler */
+#define XCANFD_F_BTR_OFFSET	0x08C  /**< Data Phase Bit Timing */
+#define XCANFD_TRR_OFFSET	0x090  /**< TX Buffer Ready Request */
+
+#define XCANFD_FSR_OFFSET	0x0E8  /**< RX FIFO 0 Status Register */
+
+#define XCANFD_TXFIFO_0_BASE_ID_OFFSET	0x0100 /**< TX Buffer 0 ID */
+#define XCANFD_TXFIFO_0_BASE_DLC_OFFSET	0x0104 /**< TX Buffer 0 DLC */
+#define XCANFD_TXFIFO_0_BASE_DW0_OFFSET	0x0108 /**< TX Buffer 0 Data Word 0 */
+
+#define XCANFD_RXFIFO_0_BASE_ID_OFFSET	0x2100 /**< RX FIFO 0 Element 0 ID */
+#define XCANFD_RXFIFO_0_BASE_DLC_OFFSET	0x2104 /**< RX FIFO 0 Element 0 DLC */
+#define XCANFD_RXFIFO_0_BASE_DW0_OFFSET	0x2108 /**< RX FIFO 0 Elem 0 Word 0 */
+
+/* Distance between TX buffers and between RX FIFO elements */
+#define XCANFD_MAX_FRAME_SIZE_IN_BYTES	0x48
+/* @} */
+
+/** @name Software Reset Register
+ *  @{
+ */
+#define XCANFD_SRR_CEN_MASK	0x00000002  /**< Can Enable Mask */
+#define XCANFD_SRR_SRST_MASK	0x00000001  /**< Reset Mask */
+/* @} */
+
+/** @name Mode Select Register
+ *  @{
+ */
+#define XCANFD_MSR_BRSD_MASK	0x00000008  /**< Bit Rate Switch Disable */
+#define XCANFD_MSR_LBACK_MASK	0x00000002  /**< Loop Back Mode Select Mask */
+#define XCANFD_MSR_SLEEP_MASK	0x00000001  /**< Sleep Mode Select Mask */
+/* @} */
+
+/** @name Baud Rate Prescaler Registers, arbitration and data phase
+ *  @{
+ */
+#define XCANFD_BRPR_BRP_MASK	0x000000FF  /**< Baud Rate Prescaler Mask */
+/* @} */
+
+/** @name Arbitration Phase Bit Timing Register
+ *  @{
+ */
+#define XCANFD_BTR_SJW_MASK	0x007F0000  /**< Sync Jump Width Mask */
+#define XCANFD_BTR_SJW_SHIFT	16	    /**< Sync Jump Width Shift */
+#define XCANFD_BTR_TS2_MASK	0x00007F00  /**< Time Segment 2 Mask */
+#define XCANFD_BTR_TS2_SHIFT	8	    /**< Time Segment 2 Shift */
+#define XCANFD_BTR_TS1_MASK	0x000000FF  /**< Time Segment 1 Mask */
+/* @} */
+
+/** @name Data Phase Bit Timing Register
+ *  @{
+ */
+#define XCANFD_F_BTR_SJW_MASK	0x000F0000  /**< Sync Jump Width Mask */
+#define XCANFD_F_BTR_SJW_SHIFT	16	    /**< Sync Jump Width Shift */
+#define XCANFD_F_BTR_TS2_MASK	0x00000F00  /**< Time Segment 2 Mask */
+#define XCANFD_F_BTR_TS2_SHIFT	8	    /**< Time Segment 2 Shift */
+#define XCANFD_F_BTR_TS1_MASK	0x0000001F  /**< Time Segment 1 Mask */
+/* @} */
+
+/** @name Error Counter Register
+ *  @{
+ */
+#define XCANFD_ECR_REC_MASK	0x0000FF00  /**< Receive Error Counter Mask */
+#define XCANFD_ECR_REC_SHIFT	8	    /**< Receive Error Counter Shift */
+#define XCANFD_ECR_TEC_MASK	0x000000FF  /**< Transmit Error Counter Mask */
+/* @} */
+
+/** @name Error Status Register, data phase errors in the upper byte
+ *  @{
+ */
+#define XCANFD_ESR_F_BERR_MASK	0x00000800  /**< Data Phase Bit Error */
+#define XCANFD_ESR_F_STER_MASK	0x00000400  /**< Data Phase Stuff Error */
+#define XCANFD_ESR_F_FMER_MASK	0x00000200  /**< Data Phase Form Error */
+#define XCANFD_ESR_F_CRCER_MASK	0x00000100  /**< Data Phase CRC Error */
+#define XCANFD_ESR_ACKER_MASK	0x00000010  /**< ACK Error Mask */
+#define XCANFD_ESR_BERR_MASK	0x00000008  /**< Bit Error Mask */
+#define XCANFD_ESR_STER_MASK	0x00000004  /**< Stuff Error Mask */
+#define XCANFD_ESR_FMER_MASK	0x00000002  /**< Form Error Mask */
+#define XCANFD_ESR_CRCER_MASK	0x00000001  /**< CRC Error Mask */
+#define XCANFD_ESR_ALL_MASK	0x00000F1F  /**< All Error Masks */
+/* @} */
+
+/** @name Status Register
+ *  @{
+ */
+#define XCANFD_SR_ESTAT_MASK	0x00000180  /**< Error Status Mask */
+#define XCANFD_SR_ESTAT_SHIFT	7	    /**< Error Status Shift */
+#define XCANFD_SR_ERRWRN_MASK	0x00000040  /**< Error Warning Mask */
+#define XCANFD_SR_BBSY_MASK	0x00000020  /**< Bus Busy Mask */
+#define XCANFD_SR_BIDLE_MASK	0x00000010  /**< Bus Idle Mask */
+#define XCANFD_SR_NORMAL_MASK	0x00000008  /**< Normal Mode Mask */
+#define XCANFD_SR_SLEEP_MASK	0x00000004  /**< Sleep Mode Mask */
+#define XCANFD_SR_LBACK_MASK	0x00000002  /**< Loop Back Mode Mask */
+#define XCANFD_SR_CONFIG_MASK	0x00000001  /**< Configuration Mode Mask */
+/* @} */
+
+/** @name Interrupt Status/Enable/Clear Register
+ *  @{
+ */
+#define XCANFD_IXR_WKUP_MASK	0x00000800  /**< Wake up Interrupt Mask */
+#define XCANFD_IXR_SLP_MASK	0x00000400  /**< Sleep Interrupt Mask */
+#define XCANFD_IXR_BSOFF_MASK	0x00000200  /**< Bus Off Interrupt Mask */
+#define XCANFD_IXR_ERROR_MASK	0x00000100  /**< Error Interrupt Mask */
+#define XCANFD_IXR_RXFOFLW_MASK	0x00000040  /**< RX FIFO 0 Overflow Intr */
+#define XCANFD_IXR_RXOK_MASK	0x00000010  /**< New Message Received Intr */
+#define XCANFD_IXR_BSRD_MASK	0x00000008  /**< Bus-off Recovery Done */
+#define XCANFD_IXR_TXOK_MASK	0x00000002  /**< TX Successful Interrupt Mask */
+#define XCANFD_IXR_ARBLST_MASK	0x00000001  /**< Arbitration Lost Intr Mask */
+#define XCANFD_IXR_ALL		(XCANFD_IXR_WKUP_MASK | \
+				XCANFD_IXR_SLP_MASK | \
+				XCANFD_IXR_BSOFF_MASK | \
+				XCANFD_IXR_ERROR_MASK | \
+				XCANFD_IXR_RXFOFLW_MASK | \
+				XCANFD_IXR_RXOK_MASK | \
+				XCANFD_IXR_BSRD_MASK | \
+				XCANFD_IXR_TXOK_MASK | \
+				XCANFD_IXR_ARBLST_MASK)
+/* @} */
+
+/** @name CAN Frame Identifier, the same layout as the AXI CAN
+ *  @{
+ */
+#define XCANFD_IDR_ID1_MASK	0xFFE00000  /**< Standard Messg Ident Mask */
+#define XCANFD_IDR_ID1_SHIFT	21	    /**< Standard Messg Ident Shift */
+#define XCANFD_IDR_SRR_MASK	0x00100000  /**< Substitute Remote TX Req */
+#define XCANFD_IDR_SRR_SHIFT	20
+#define XCANFD_IDR_IDE_MASK	0x00080000  /**< Identifier Extension Mask */
+#define XCANFD_IDR_IDE_SHIFT	19	    /**< Identifier Extension Shift */
+#define XCANFD_IDR_ID2_MASK	0x0007FFFE  /**< Extended Messg Ident Mask */
+#define XCANFD_IDR_ID2_SHIFT	1	    /**< Extended Messg Ident Shift */
+#define XCANFD_IDR_RTR_MASK	0x00000001  /**< Remote TX Request Mask */
+/* @} */
+
+/** @name CAN Frame Data Length Code
+ *  @{
+ */
+#define XCANFD_DLCR_DLC_MASK	0xF0000000  /**< Data Length Code Mask */
+#define XCANFD_DLCR_DLC_SHIFT	28	    /**< Data Length Code Shift */
+#define XCANFD_DLCR_EDL_MASK	0x08000000  /**< CAN FD Format (FDF) */
+#define XCANFD_DLCR_BRS_MASK	0x04000000  /**< Bit Rate Switch */
+#define XCANFD_DLCR_ESI_MASK	0x02000000  /**< Error State Indicator */
+/* @} */
+
+/** @name RX FIFO 0 Status Register
+ *  @{
+ */
+#define XCANFD_FSR_FL_MASK	0x00007F00  /**< Fill Level Mask */
+#define XCANFD_FSR_FL_SHIFT	8	    /**< Fill Level Shift */
+#define XCANFD_FSR_IRI_MASK	0x00000080  /**< Increment Read Index */
+#define XCANFD_FSR_RI_MASK	0x0000003F  /**< Read Index Mask */
+/* @} */
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+#define XCanFd_ReadReg(BaseAddress, RegOffset) \
+	Xil_In32((BaseAddress) + (RegOffset))
+
+#define XCanFd_WriteReg(BaseAddress, RegOffset, Data) \
+	Xil_Out32((BaseAddress) + (RegOffset), (Data))
+
+/* Offsets of the ID register of TX buffer and RX FIFO element Index */
+#define XCANFD_TXID_OFFSET(Index) \
+	(XCANFD_TXFIFO_0_BASE_ID_OFFSET + \
+	 ((Index) * XCANFD_MAX_FRAME_SIZE_IN_BYTES))
+#define XCANFD_RXID_OFFSET(Index) \
+	(XCANFD_RXFIFO_0_BASE_ID_OFFSET + \
+	 ((Index) * XCANFD_MAX_FRAME_SIZE_IN_BYTES))
+
+#endif	/* end of protection macro */
@@ -0,0 +1,41 @@
+/******************************************************************************
+* Host simulator replacement for the gpio driver xgpio_l.h.
+*
+* Register offsets and masks of the AXI GPIO (PG144).
+******************************************************************************/
+
+#ifndef XGPIO_L_H	/* prevent circular inclusions */
+#define XGPIO_L_H
+
+#include "xil_types.h"
+#include "xil_assert.h"
+#include "xil_io.h"
+
+/************************** Constant Definitions *****************************/
+
+#define XGPIO_DATA_OFFSET	0x0   /**< Data register for 1st channel */
+#define XGPIO_TRI_OFFSET	0x4   /**< I/O direction reg for 1st channel */
+#define XGPIO_DATA2_OFFSET	0x8   /**< Data register for 2nd channel */
+#define XGPIO_TRI2_OFFSET	0xC   /**< I/O direction reg for 2nd channel */
+
+#define XGPIO_GIE_OFFSET	0x11C /**< Global interrupt enable register */
+#define XGPIO_ISR_OFFSET	0x120 /**< Interrupt status register */
+#define XGPIO_IER_OFFSET	0x128 /**< Interrupt enable register */
+
+#define XGPIO_CHAN_OFFSET	8
+
+#define XGPIO_IR_MASK		0x3 /**< Mask of all bits */
+#define XGPIO_IR_CH1_MASK	0x1 /**< Mask for the 1st channel */
+#define XGPIO_IR_CH2_MASK	0x2 /**< Mask for the 2nd channel */
+
+#define XGPIO_GIE_GINTR_ENABLE_MASK	0x80000000
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+#define XGpio_ReadReg(BaseAddress, RegOffset) \
+	Xil_In32((BaseAddress) + (RegOffset))
+
+#define XGpio_WriteReg(BaseAddress, RegOffset, Data) \
+	Xil_Out32((BaseAddress) + (RegOffset), (u32)(Data))
+
+#endif	/* end of protection macro */
@@ -0,0 +1,80 @@
+/******************************************************************************
+* Host simulator replacement for the standalone BSP xil_assert.h.
+*
+* On the board a failed assertion spins forever when Xil_AssertWait is set.
+* On the host the simulator prints the location and aborts instead, so that
+* a failed assertion shows up as a failed run rather than a hang.
+******************************************************************************/
+
+#ifndef XIL_ASSERT_H	/* prevent circular inclusions */
+#define XIL_ASSERT_H
+
+#include "xil_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define XIL_ASSERT_NONE		0U
+#define XIL_ASSERT_OCCURRED	1U
+#define XNULL			NULL
+
+/**************************** Type Definitions *******************************/
+
+typedef void (*Xil_AssertCallback) (const char8 *File, s32 Line);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+#define Xil_AssertVoid(Expression)				\
+{								\
+	if (Expression) {					\
+		Xil_AssertStatus = XIL_ASSERT_NONE;		\
+	} else {						\
+		Xil_Assert(__FILE__, __LINE__);			\
+		Xil_AssertStatus = XIL_ASSERT_OCCURRED;		\
+		return;						\
+	}							\
+}
+
+#define Xil_AssertNonvoid(Expression)				\
+{								\
+	if (Expression) {					\
+		Xil_AssertStatus = XIL_ASSERT_NONE;		\
+	} else {						\
+		Xil_Assert(__FILE__, __LINE__);			\
+		Xil_AssertStatus = XIL_ASSERT_OCCURRED;		\
+		return 0;					\
+	}							\
+}
+
+#define Xil_AssertVoidAlways()					\
+{								\
+	Xil_Assert(__FILE__, __LINE__);				\
+	Xil_AssertStatus = XIL_ASSERT_OCCURRED;			\
+	return;							\
+}
+
+#define Xil_AssertNonvoidAlways()				\
+{								\
+	Xil_Assert(__FILE__, __LINE__);				\
+	Xil_AssertStatus = XIL_ASSERT_OCCURRED;			\
+	return 0;						\
+}
+
+/************************** Variable Definitions *****************************/
+
+extern u32 Xil_AssertStatus;
+extern s32 Xil_AssertWait;
+
+/************************** Function Prototypes ******************************/
+
+void Xil_Assert(const char8 *File, s32 Line);
+void Xil_AssertSetCallback(Xil_AssertCallback Routine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* end of protection macro */
@@ -0,0 +1,57 @@
+/******************************************************************************
+* Host simulator replacement for the standalone BSP xil_exception.h.
+*
+* Only the IRQ exception is modelled. Enabling exceptions unmasks the
+* simulated IRQ line of the CPU, after which pending GIC interrupts are
+* delivered to the registered handler between application instructions.
+******************************************************************************/
+
+#ifndef XIL_EXCEPTION_H	/* prevent circular inclusions */
+#define XIL_EXCEPTION_H
+
+#include "xil_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define XIL_EXCEPTION_FIQ	0x40U
+#define XIL_EXCEPTION_IRQ	0x80U
+#define XIL_EXCEPTION_ALL	(XIL_EXCEPTION_FIQ | XIL_EXCEPTION_IRQ)
+
+#define XIL_EXCEPTION_ID_FIRST			0U
+#define XIL_EXCEPTION_ID_RESET			0U
+#define XIL_EXCEPTION_ID_UNDEFINED_INT		1U
+#define XIL_EXCEPTION_ID_SWI_INT		2U
+#define XIL_EXCEPTION_ID_PREFETCH_ABORT_INT	3U
+#define XIL_EXCEPTION_ID_DATA_ABORT_INT		4U
+#define XIL_EXCEPTION_ID_IRQ_INT		5U
+#define XIL_EXCEPTION_ID_FIQ_INT		6U
+#define XIL_EXCEPTION_ID_LAST			6U
+
+#define XIL_EXCEPTION_ID_INT	XIL_EXCEPTION_ID_IRQ_INT
+
+/**************************** Type Definitions *******************************/
+
+typedef void (*Xil_ExceptionHandler)(void *data);
+typedef void (*Xil_InterruptHandler)(void *data);
+
+/************************** Function Prototypes ******************************/
+
+void Xil_ExceptionInit(void);
+void Xil_ExceptionRegisterHandler(u32 Exception_id,
+				  Xil_ExceptionHandler Handler, void *Data);
+void Xil_ExceptionRemoveHandler(u32 Exception_id);
+void Xil_ExceptionEnableMask(u32 Mask);
+void Xil_ExceptionDisableMask(u32 Mask);
+
+#define Xil_ExceptionEnable()	Xil_ExceptionEnableMask(XIL_EXCEPTION_IRQ)
+#define Xil_ExceptionDisable()	Xil_ExceptionDisableMask(XIL_EXCEPTION_ALL)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* end of protection macro */
@@ -0,0 +1,51 @@
+/******************************************************************************
+* Host simulator replacement for the standalone BSP xil_io.h.
+*
+* On the board Xil_In32/Xil_Out32 are plain volatile loads and stores. On the
+* host they are routed straight into the peripheral models, which charges
+* the modelled AXI access cost and keeps per-device transaction counts.
+* Raw pointer accesses to a peripheral address are trapped by the simulator
+* and end up in the same place, only more slowly.
+******************************************************************************/
+
+#ifndef XIL_IO_H	/* prevent circular inclusions */
+#define XIL_IO_H
+
+#include "xil_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************** Function Prototypes ******************************/
+
+u8 Xil_In8(UINTPTR Addr);
+u16 Xil_In16(UINTPTR Addr);
+u32 Xil_In32(UINTPTR Addr);
+void Xil_Out8(UINTPTR Addr, u8 Value);
+void Xil_Out16(UINTPTR Addr, u16 Value);
+void Xil_Out32(UINTPTR Addr, u32 Value);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+static inline u16 Xil_EndianSwap16(u16 Data)
+{
+	return (u16)((Data << 8) | (Data >> 8));
+}
+
+static inline u32 Xil_EndianSwap32(u32 Data)
+{
+	return __builtin_bswap32(Data);
+}
+
+/* The Cortex-A9 and the x86 host are both little endian */
+#define Xil_Htonl(Data)	Xil_EndianSwap32(Data)
+#define Xil_Ntohl(Data)	Xil_EndianSwap32(Data)
+#define Xil_Htons(Data)	Xil_EndianSwap16(Data)
+#define Xil_Ntohs(Data)	Xil_EndianSwap16(Data)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* end of protection macro */
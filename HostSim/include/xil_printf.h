@@ -0,0 +1,21 @@
+/******************************************************************************
+* Host simulator replacement for the standalone BSP xil_printf.h.
+******************************************************************************/
+
+#ifndef XIL_PRINTF_H	/* prevent circular inclusions */
+#define XIL_PRINTF_H
+
+#include "xil_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void xil_printf(const char8 *ctrl1, ...);
+void outbyte(char8 c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* end of protection macro */
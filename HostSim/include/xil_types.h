@@ -0,0 +1,45 @@
+/******************************************************************************
+* Host simulator replacement for the standalone BSP xil_types.h.
+*
+* Provides the basic Xilinx integer types so that the tutorial applications
+* build unchanged against the host simulator.
+******************************************************************************/
+
+#ifndef XIL_TYPES_H	/* prevent circular inclusions */
+#define XIL_TYPES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/************************** Constant Definitions *****************************/
+
+#ifndef TRUE
+#  define TRUE		1U
+#endif
+
+#ifndef FALSE
+#  define FALSE		0U
+#endif
+
+#define XIL_COMPONENT_IS_READY		0x11111111U
+#define XIL_COMPONENT_IS_STARTED	0x22222222U
+
+/**************************** Type Definitions *******************************/
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+
+typedef char char8;
+typedef int sint32;
+
+typedef uintptr_t UINTPTR;
+typedef intptr_t INTPTR;
+
+#endif	/* end of protection macro */
@@ -0,0 +1,140 @@
+/******************************************************************************
+* Host simulator replacement for the generated xparameters.h.
+*
+* Describes the simulated board: a Zynq-7000 PS (Cortex-A9 and SCUGIC) with
+* one AXI GPIO, two AXI Timers, two AXI CANs, each on a bus of its own, and
+* one AXI CAN FD in the programmable logic.
+* Base addresses and interrupt IDs follow the usual Vivado defaults so that
+* raw pointer code such as (u32 *)XPAR_TMRCTR_0_BASEADDR keeps working; the
+* simulator maps these addresses into the host process.
+******************************************************************************/
+
+#ifndef XPARAMETERS_H	/* prevent circular inclusions */
+#define XPARAMETERS_H
+
+/* Processor */
+#define XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ	666666687
+#define XPAR_PS7_CORTEXA9_0_CPU_CLK_FREQ_HZ	666666687
+#define XPAR_CPU_CORTEXA9_CORE_CLOCK_FREQ_HZ	666666687
+
+/* SCUGIC */
+#define XPAR_XSCUGIC_NUM_INSTANCES		1U
+#define XPAR_PS7_SCUGIC_0_DEVICE_ID		0U
+#define XPAR_PS7_SCUGIC_0_BASEADDR		0xF8F00100U
+#define XPAR_PS7_SCUGIC_0_HIGHADDR		0xF8F001FFU
+#define XPAR_PS7_SCUGIC_0_DIST_BASEADDR		0xF8F01000U
+#define XPAR_SCUGIC_0_DEVICE_ID			0U
+#define XPAR_SCUGIC_0_CPU_BASEADDR		0xF8F00100U
+#define XPAR_SCUGIC_0_CPU_HIGHADDR		0xF8F001FFU
+#define XPAR_SCUGIC_0_DIST_BASEADDR		0xF8F01000U
+#define XPAR_SCUGIC_SINGLE_DEVICE_ID		0U
+
+/* AXI GPIO */
+#define XPAR_XGPIO_NUM_INSTANCES		1U
+#define XPAR_AXI_GPIO_0_DEVICE_ID		0U
+#define XPAR_AXI_GPIO_0_BASEADDR		0x41200000U
+#define XPAR_AXI_GPIO_0_HIGHADDR		0x4120FFFFU
+#define XPAR_AXI_GPIO_0_INTERRUPT_PRESENT	1U
+#define XPAR_AXI_GPIO_0_IS_DUAL			1U
+#define XPAR_GPIO_0_DEVICE_ID			XPAR_AXI_GPIO_0_DEVICE_ID
+#define XPAR_GPIO_0_BASEADDR			XPAR_AXI_GPIO_0_BASEADDR
+#define XPAR_GPIO_0_HIGHADDR			XPAR_AXI_GPIO_0_HIGHADDR
+#define XPAR_GPIO_0_INTERRUPT_PRESENT		XPAR_AXI_GPIO_0_INTERRUPT_PRESENT
+#define XPAR_GPIO_0_IS_DUAL			XPAR_AXI_GPIO_0_IS_DUAL
+
+/* AXI Timer */
+#define XPAR_XTMRCTR_NUM_INSTANCES		3U
+#define XPAR_AXI_TIMER_0_DEVICE_ID		0U
+#define XPAR_AXI_TIMER_0_BASEADDR		0x42800000U
+#define XPAR_AXI_TIMER_0_HIGHADDR		0x4280FFFFU
+#define XPAR_AXI_TIMER_0_CLOCK_FREQ_HZ		100000000U
+#define XPAR_TMRCTR_0_DEVICE_ID			XPAR_AXI_TIMER_0_DEVICE_ID
+#define XPAR_TMRCTR_0_BASEADDR			XPAR_AXI_TIMER_0_BASEADDR
+#define XPAR_TMRCTR_0_HIGHADDR			XPAR_AXI_TIMER_0_HIGHADDR
+#define XPAR_TMRCTR_0_CLOCK_FREQ_HZ		XPAR_AXI_TIMER_0_CLOCK_FREQ_HZ
+
+/*
+ * Second AXI Timer, for capture: CAPTURETRIG0 and CAPTURETRIG1 both take
+ * the PWM0 output of the first timer, which also drives an LED,
+ * CAPTURETRIG1 active low (C_TRIG1_ASSERT = 0), so counter 0 latches
+ * rising and counter 1 falling edges
+ */
+#define XPAR_AXI_TIMER_1_DEVICE_ID		1U
+#define XPAR_AXI_TIMER_1_BASEADDR		0x42810000U
+#define XPAR_AXI_TIMER_1_HIGHADDR		0x4281FFFFU
+#define XPAR_AXI_TIMER_1_CLOCK_FREQ_HZ		100000000U
+#define XPAR_TMRCTR_1_DEVICE_ID			XPAR_AXI_TIMER_1_DEVICE_ID
+#define XPAR_TMRCTR_1_BASEADDR			XPAR_AXI_TIMER_1_BASEADDR
+#define XPAR_TMRCTR_1_HIGHADDR			XPAR_AXI_TIMER_1_HIGHADDR
+#define XPAR_TMRCTR_1_CLOCK_FREQ_HZ		XPAR_AXI_TIMER_1_CLOCK_FREQ_HZ
+
+/*
+ * Third AXI Timer, for the system clock: its counters run cascaded as one
+ * 64-bit counter that never wraps in practice, see Tut10/mono_clock.h
+ */
+#define XPAR_AXI_TIMER_2_DEVICE_ID		2U
+#define XPAR_AXI_TIMER_2_BASEADDR		0x42820000U
+#define XPAR_AXI_TIMER_2_HIGHADDR		0x4282FFFFU
+#define XPAR_AXI_TIMER_2_CLOCK_FREQ_HZ		100000000U
+#define XPAR_TMRCTR_2_DEVICE_ID			XPAR_AXI_TIMER_2_DEVICE_ID
+#define XPAR_TMRCTR_2_BASEADDR			XPAR_AXI_TIMER_2_BASEADDR
+#define XPAR_TMRCTR_2_HIGHADDR			XPAR_AXI_TIMER_2_HIGHADDR
+#define XPAR_TMRCTR_2_CLOCK_FREQ_HZ		XPAR_AXI_TIMER_2_CLOCK_FREQ_HZ
+
+/* AXI CAN */
+#define XPAR_XCAN_NUM_INSTANCES			2U
+#define XPAR_CAN_0_DEVICE_ID			0U
+#define XPAR_CAN_0_BASEADDR			0x43C00000U
+#define XPAR_CAN_0_HIGHADDR			0x43C0FFFFU
+#define XPAR_CAN_0_CAN_NUM_ACF			4U
+#define XPAR_CAN_0_CAN_RX_DPTH			64U
+#define XPAR_CAN_0_CAN_TX_DPTH			64U
+#define XPAR_CAN_0_CAN_CLK_FREQ_HZ		24000000U
+#define XPAR_CAN_1_DEVICE_ID			1U
+#define XPAR_CAN_1_BASEADDR			0x43C10000U
+#define XPAR_CAN_1_HIGHADDR			0x43C1FFFFU
+#define XPAR_CAN_1_CAN_NUM_ACF			4U
+#define XPAR_CAN_1_CAN_RX_DPTH			64U
+#define XPAR_CAN_1_CAN_TX_DPTH			64U
+#define XPAR_CAN_1_CAN_CLK_FREQ_HZ		24000000U
+
+/*
+ * AXI CAN FD, on a CAN FD bus of its own: 32 TX buffers and RX FIFO 0 of
+ * 32 frames read in sequence, on the usual 80 MHz CAN FD clock
+ */
+#define XPAR_XCANFD_NUM_INSTANCES		1U
+#define XPAR_CANFD_0_DEVICE_ID			0U
+#define XPAR_CANFD_0_BASEADDR			0x43C20000U
+#define XPAR_CANFD_0_HIGHADDR			0x43C2FFFFU
+#define XPAR_CANFD_0_RX_MODE			0U
+#define XPAR_CANFD_0_NUM_OF_RX_MB_BUF		32U
+#define XPAR_CANFD_0_NUM_OF_TX_BUF		32U
+#define XPAR_CANFD_0_CAN_CLK_FREQ_HZ		80000000U
+
+/* Fabric interrupts (IRQ_F2P[6:0] on GIC SPI 61..67) */
+#define XPAR_FABRIC_AXI_TIMER_0_INTERRUPT_INTR	61U
+#define XPAR_FABRIC_AXI_GPIO_0_IP2INTC_IRPT_INTR	62U
+#define XPAR_FABRIC_AXI_CAN_0_IP2BUS_INTRENT_INTR	63U
+#define XPAR_FABRIC_AXI_TIMER_1_INTERRUPT_INTR	64U
+#define XPAR_FABRIC_AXI_TIMER_2_INTERRUPT_INTR	65U
+#define XPAR_FABRIC_AXI_CAN_1_IP2BUS_INTRENT_INTR	66U
+#define XPAR_FABRIC_AXI_CANFD_0_IP2BUS_INTREVENT_INTR	67U
+#define XPAR_FABRIC_GPIO_0_VEC_ID	XPAR_FABRIC_AXI_GPIO_0_IP2INTC_IRPT_INTR
+#define XPAR_FABRIC_TMRCTR_0_VEC_ID	XPAR_FABRIC_AXI_TIMER_0_INTERRUPT_INTR
+#define XPAR_FABRIC_TMRCTR_1_VEC_ID	XPAR_FABRIC_AXI_TIMER_1_INTERRUPT_INTR
+#define XPAR_FABRIC_TMRCTR_2_VEC_ID	XPAR_FABRIC_AXI_TIMER_2_INTERRUPT_INTR
+#define XPAR_FABRIC_CAN_0_VEC_ID	XPAR_FABRIC_AXI_CAN_0_IP2BUS_INTRENT_INTR
+#define XPAR_FABRIC_CAN_1_VEC_ID	XPAR_FABRIC_AXI_CAN_1_IP2BUS_INTRENT_INTR
+#define XPAR_FABRIC_CANFD_0_VEC_ID	XPAR_FABRIC_AXI_CANFD_0_IP2BUS_INTREVENT_INTR
+
+/*
+ * Can_code.cpp and CanFd_code.cpp name their interrupt ID after the AXI
+ * INTC vector even on the SCUGIC path. There is no AXI INTC on this board
+ * (XPAR_INTC_0_DEVICE_ID is deliberately left undefined), so map it onto
+ * the fabric interrupt ID.
+ */
+#define XPAR_INTC_0_CAN_0_VEC_ID	XPAR_FABRIC_CAN_0_VEC_ID
+#define XPAR_INTC_0_CAN_1_VEC_ID	XPAR_FABRIC_CAN_1_VEC_ID
+#define XPAR_INTC_0_CANFD_0_VEC_ID	XPAR_FABRIC_CANFD_0_VEC_ID
+
+#endif	/* end of protection macro */
@@ -0,0 +1,26 @@
+/******************************************************************************
+* Host simulator replacement for the standalone BSP xpseudo_asm.h.
+*
+* Only the instructions the tutorial applications use are provided. wfi()
+* sleeps the simulated CPU until an interrupt is signalled, skipping
+* simulated time ahead and accounting it as idle.
+******************************************************************************/
+
+#ifndef XPSEUDO_ASM_H	/* prevent circular inclusions */
+#define XPSEUDO_ASM_H
+
+#include "xil_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void SimCpu_WaitForInterrupt(void);
+
+#define wfi()		SimCpu_WaitForInterrupt()
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* end of protection macro */
@@ -0,0 +1,81 @@
+/******************************************************************************
+* Host simulator replacement for the scugic driver xscugic.h.
+*
+* Same API as the standalone XScuGic driver; the implementation talks to the
+* simulated distributor and CPU interface through Xil_In32/Xil_Out32.
+******************************************************************************/
+
+#ifndef XSCUGIC_H	/* prevent circular inclusions */
+#define XSCUGIC_H
+
+#include "xil_types.h"
+#include "xil_assert.h"
+#include "xil_exception.h"
+#include "xstatus.h"
+#include "xscugic_hw.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	Xil_InterruptHandler Handler;	/**< Interrupt handler */
+	void *CallBackRef;		/**< Callback reference for handler */
+} XScuGic_VectorTableEntry;
+
+typedef struct {
+	u16 DeviceId;			/**< Unique ID of device */
+	u32 CpuBaseAddress;		/**< CPU Interface Register base address */
+	u32 DistBaseAddress;		/**< Distributor Register base address */
+	XScuGic_VectorTableEntry HandlerTable[XSCUGIC_MAX_NUM_INTR_INPUTS];
+} XScuGic_Config;
+
+typedef struct {
+	XScuGic_Config *Config;		/**< Configuration table entry */
+	u32 IsReady;			/**< Device is initialized and ready */
+	u32 UnhandledInterrupts;	/**< Intc Statistics */
+} XScuGic;
+
+/************************** Variable Definitions *****************************/
+
+extern XScuGic_Config XScuGic_ConfigTable[];
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+#define XScuGic_CPUWriteReg(InstancePtr, RegOffset, Data) \
+	(XScuGic_WriteReg(((InstancePtr)->Config->CpuBaseAddress), (RegOffset), \
+			  ((u32)(Data))))
+
+#define XScuGic_CPUReadReg(InstancePtr, RegOffset) \
+	(XScuGic_ReadReg(((InstancePtr)->Config->CpuBaseAddress), (RegOffset)))
+
+#define XScuGic_DistWriteReg(InstancePtr, RegOffset, Data) \
+	(XScuGic_WriteReg(((InstancePtr)->Config->DistBaseAddress), (RegOffset), \
+			  ((u32)(Data))))
+
+#define XScuGic_DistReadReg(InstancePtr, RegOffset) \
+	(XScuGic_ReadReg(((InstancePtr)->Config->DistBaseAddress), (RegOffset)))
+
+/************************** Function Prototypes ******************************/
+
+XScuGic_Config *XScuGic_LookupConfig(u16 DeviceId);
+s32 XScuGic_CfgInitialize(XScuGic *InstancePtr, XScuGic_Config *ConfigPtr,
+			  u32 EffectiveAddr);
+s32 XScuGic_Connect(XScuGic *InstancePtr, u32 Int_Id,
+		    Xil_InterruptHandler Handler, void *CallBackRef);
+void XScuGic_Disconnect(XScuGic *InstancePtr, u32 Int_Id);
+void XScuGic_Enable(XScuGic *InstancePtr, u32 Int_Id);
+void XScuGic_Disable(XScuGic *InstancePtr, u32 Int_Id);
+void XScuGic_SetPriorityTriggerType(XScuGic *InstancePtr, u32 Int_Id,
+				    u8 Priority, u8 Trigger);
+void XScuGic_GetPriorityTriggerType(XScuGic *InstancePtr, u32 Int_Id,
+				    u8 *Priority, u8 *Trigger);
+void XScuGic_InterruptHandler(XScuGic *InstancePtr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* end of protection macro */
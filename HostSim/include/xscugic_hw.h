@@ -0,0 +1,66 @@
+/******************************************************************************
+* Host simulator replacement for the scugic driver xscugic_hw.h.
+*
+* Register offsets and masks of the ARM GIC (PL390) distributor and CPU
+* interface as used by the XScuGic driver.
+******************************************************************************/
+
+#ifndef XSCUGIC_HW_H	/* prevent circular inclusions */
+#define XSCUGIC_HW_H
+
+#include "xil_types.h"
+#include "xil_io.h"
+
+/************************** Constant Definitions *****************************/
+
+#define XSCUGIC_MAX_NUM_INTR_INPUTS	95U
+#define XSCUGIC_SPURIOUS_INTR_ID	1023U
+
+/* Distributor register offsets */
+#define XSCUGIC_DIST_EN_OFFSET		0x00000000U /**< Distributor Enable */
+#define XSCUGIC_IC_TYPE_OFFSET		0x00000004U /**< Interrupt Controller Type */
+#define XSCUGIC_ENABLE_SET_OFFSET	0x00000100U /**< Enable Set */
+#define XSCUGIC_DISABLE_OFFSET		0x00000180U /**< Enable Clear */
+#define XSCUGIC_PENDING_SET_OFFSET	0x00000200U /**< Pending Set */
+#define XSCUGIC_PENDING_CLR_OFFSET	0x00000280U /**< Pending Clear */
+#define XSCUGIC_ACTIVE_OFFSET		0x00000300U /**< Active Status */
+#define XSCUGIC_PRIORITY_OFFSET		0x00000400U /**< Priority Level */
+#define XSCUGIC_SPI_TARGET_OFFSET	0x00000800U /**< SPI Target */
+#define XSCUGIC_INT_CFG_OFFSET		0x00000C00U /**< Interrupt Configuration */
+#define XSCUGIC_SFI_TRIG_OFFSET		0x00000F00U /**< Software Triggered */
+
+/* CPU interface register offsets */
+#define XSCUGIC_CONTROL_OFFSET		0x00000000U /**< CPU Interface Control */
+#define XSCUGIC_CPU_PRIOR_OFFSET	0x00000004U /**< Priority Mask */
+#define XSCUGIC_BIN_PT_OFFSET		0x00000008U /**< Binary Point */
+#define XSCUGIC_INT_ACK_OFFSET		0x0000000CU /**< Interrupt Acknowledge */
+#define XSCUGIC_EOI_OFFSET		0x00000010U /**< End of Interrupt */
+#define XSCUGIC_RUN_PRIOR_OFFSET	0x00000014U /**< Running Priority */
+#define XSCUGIC_HI_PEND_OFFSET		0x00000018U /**< Highest Pending */
+
+#define XSCUGIC_EN_INT_MASK		0x00000001U
+#define XSCUGIC_ACK_INTID_MASK		0x000003FFU
+#define XSCUGIC_PRIORITY_MASK		0x000000FFU
+#define XSCUGIC_INT_CFG_MASK		0x00000003U
+#define XSCUGIC_CNTR_EN_S_MASK		0x00000001U
+#define XSCUGIC_CNTR_EN_NS_MASK		0x00000002U
+#define XSCUGIC_CNTR_ACKCTL_MASK	0x00000004U
+
+#define XSCUGIC_PRIORITY_OFFSET_CALC(InterruptID) \
+	((u32)XSCUGIC_PRIORITY_OFFSET + (((InterruptID)/4U) * 4U))
+#define XSCUGIC_INT_CFG_OFFSET_CALC(InterruptID) \
+	((u32)XSCUGIC_INT_CFG_OFFSET + (((InterruptID)/16U) * 4U))
+#define XSCUGIC_EN_DIS_OFFSET_CALC(Register, InterruptID) \
+	((Register) + (((InterruptID)/32U) * 4U))
+#define XSCUGIC_SPI_TARGET_OFFSET_CALC(InterruptID) \
+	((u32)XSCUGIC_SPI_TARGET_OFFSET + (((InterruptID)/4U) * 4U))
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+#define XScuGic_ReadReg(BaseAddress, RegOffset) \
+	(Xil_In32((BaseAddress) + (RegOffset)))
+
+#define XScuGic_WriteReg(BaseAddress, RegOffset, Data) \
+	(Xil_Out32(((BaseAddress) + (RegOffset)), ((u32)(Data))))
+
+#endif	/* end of protection macro */
@@ -0,0 +1,93 @@
+/******************************************************************************
+* Host simulator replacement for the tmrctr driver xtmrctr.h.
+******************************************************************************/
+
+#ifndef XTMRCTR_H	/* prevent circular inclusions */
+#define XTMRCTR_H
+
+#include "xil_types.h"
+#include "xil_assert.h"
+#include "xstatus.h"
+#include "xtmrctr_l.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************** Constant Definitions *****************************/
+
+/*
+ * Used to configure the timer counter device through XTmrCtr_SetOptions.
+ */
+#define XTC_CASCADE_MODE_OPTION		0x00000080UL
+#define XTC_ENABLE_ALL_OPTION		0x00000040UL
+#define XTC_DOWN_COUNT_OPTION		0x00000020UL
+#define XTC_CAPTURE_MODE_OPTION		0x00000010UL
+#define XTC_INT_MODE_OPTION		0x00000008UL
+#define XTC_AUTO_RELOAD_OPTION		0x00000004UL
+#define XTC_EXT_COMPARE_OPTION		0x00000002UL
+
+/**************************** Type Definitions *******************************/
+
+typedef void (*XTmrCtr_Handler) (void *CallBackRef, u8 TmrCtrNumber);
+
+typedef struct {
+	u32 Interrupts;	 /**< The number of interrupts that have occurred */
+} XTmrCtrStats;
+
+typedef struct {
+	u16 DeviceId;		/**< Unique ID  of device */
+	UINTPTR BaseAddress;	/**< Register base address */
+	u32 SysClockFreqHz;	/**< The AXI bus clock frequency */
+} XTmrCtr_Config;
+
+typedef struct {
+	XTmrCtr_Config Config;	/**< Core configuration. */
+	XTmrCtrStats Stats;	/**< Component Statistics */
+	UINTPTR BaseAddress;	/**< Base address of registers */
+	u32 IsReady;		/**< Device is initialized and ready */
+	u32 IsStartedTmrCtr0;	/**< Is Timer Counter 0 started */
+	u32 IsStartedTmrCtr1;	/**< Is Timer Counter 1 started */
+	XTmrCtr_Handler Handler; /**< Callback function */
+	void *CallBackRef;	/**< Callback reference for handler */
+} XTmrCtr;
+
+/************************** Variable Definitions *****************************/
+
+extern XTmrCtr_Config XTmrCtr_ConfigTable[];
+
+/************************** Function Prototypes ******************************/
+
+/* Required functions, in file xtmrctr.c */
+int XTmrCtr_Initialize(XTmrCtr *InstancePtr, u16 DeviceId);
+XTmrCtr_Config *XTmrCtr_LookupConfig(u16 DeviceId);
+void XTmrCtr_CfgInitialize(XTmrCtr *InstancePtr, XTmrCtr_Config *ConfigPtr,
+			   UINTPTR EffectiveAddr);
+int XTmrCtr_InitHw(XTmrCtr *InstancePtr);
+void XTmrCtr_Start(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+void XTmrCtr_Stop(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+u32 XTmrCtr_GetValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+void XTmrCtr_SetResetValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber,
+			   u32 ResetValue);
+u32 XTmrCtr_GetCaptureValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+int XTmrCtr_IsExpired(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+void XTmrCtr_Reset(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+
+/* Functions for options, in file xtmrctr_options.c */
+void XTmrCtr_SetOptions(XTmrCtr *InstancePtr, u8 TmrCtrNumber, u32 Options);
+u32 XTmrCtr_GetOptions(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+
+/* Functions for statistics, in file xtmrctr_stats.c */
+void XTmrCtr_GetStats(XTmrCtr *InstancePtr, XTmrCtrStats *StatsPtr);
+void XTmrCtr_ClearStats(XTmrCtr *InstancePtr);
+
+/* Interrupt functions in xtmrctr_intr.c */
+void XTmrCtr_SetHandler(XTmrCtr *InstancePtr, XTmrCtr_Handler FuncPtr,
+			void *CallBackRef);
+void XTmrCtr_InterruptHandler(void *InstancePtr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* end of protection macro */
@@ -0,0 +1,68 @@
+/******************************************************************************
+* Host simulator replacement for the tmrctr driver xtmrctr_l.h.
+*
+* Register offsets and TCSR bit masks of the AXI Timer (PG079).
+******************************************************************************/
+
+#ifndef XTMRCTR_L_H	/* prevent circular inclusions */
+#define XTMRCTR_L_H
+
+#include "xil_types.h"
+#include "xil_io.h"
+
+/************************** Constant Definitions *****************************/
+
+#define XTC_DEVICE_TIMER_COUNT		2
+
+/* Each timer counter consumes 16 bytes of address space */
+#define XTC_TIMER_COUNTER_OFFSET	16
+
+#define XTC_TCSR_OFFSET		0	/**< Control/Status register */
+#define XTC_TLR_OFFSET		4	/**< Load register */
+#define XTC_TCR_OFFSET		8	/**< Timer counter register */
+
+#define XTC_CSR_CASC_MASK		0x00000800 /**< Cascade Mode */
+#define XTC_CSR_ENABLE_ALL_MASK		0x00000400 /**< Enables all timer counters */
+#define XTC_CSR_ENABLE_PWM_MASK		0x00000200 /**< Enables the Pulse Width Modulation */
+#define XTC_CSR_INT_OCCURED_MASK	0x00000100 /**< If bit is set, an interrupt has occured */
+#define XTC_CSR_ENABLE_TMR_MASK		0x00000080 /**< Enables only the specific timer */
+#define XTC_CSR_ENABLE_INT_MASK		0x00000040 /**< Enables the interrupt output */
+#define XTC_CSR_LOAD_MASK		0x00000020 /**< Loads the timer using the load value */
+#define XTC_CSR_AUTO_RELOAD_MASK	0x00000010 /**< In compare mode, reload on expiry */
+#define XTC_CSR_EXT_CAPTURE_MASK	0x00000008 /**< Enables the external input to the timer counter */
+#define XTC_CSR_EXT_GENERATE_MASK	0x00000004 /**< Enables the external generate output */
+#define XTC_CSR_DOWN_COUNT_MASK		0x00000002 /**< Configures the timer counter to count down */
+#define XTC_CSR_CAPTURE_MODE_MASK	0x00000001 /**< Enables the timer to capture */
+
+/**************************** Type Definitions *******************************/
+
+extern u8 XTmrCtr_Offsets[];
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+#define XTmrCtr_ReadReg(BaseAddress, TmrCtrNumber, RegOffset) \
+	Xil_In32((BaseAddress) + XTmrCtr_Offsets[(TmrCtrNumber)] + \
+		 (RegOffset))
+
+#define XTmrCtr_WriteReg(BaseAddress, TmrCtrNumber, RegOffset, ValueToWrite)\
+	Xil_Out32(((BaseAddress) + XTmrCtr_Offsets[(TmrCtrNumber)] + \
+		   (RegOffset)), (ValueToWrite))
+
+#define XTmrCtr_SetControlStatusReg(BaseAddress, TmrCtrNumber, RegisterValue)\
+	XTmrCtr_WriteReg((BaseAddress), (TmrCtrNumber), XTC_TCSR_OFFSET, \
+			 (RegisterValue))
+
+#define XTmrCtr_GetControlStatusReg(BaseAddress, TmrCtrNumber) \
+	XTmrCtr_ReadReg((BaseAddress), (TmrCtrNumber), XTC_TCSR_OFFSET)
+
+#define XTmrCtr_GetTimerCounterReg(BaseAddress, TmrCtrNumber) \
+	XTmrCtr_ReadReg((BaseAddress), (TmrCtrNumber), XTC_TCR_OFFSET)
+
+#define XTmrCtr_SetLoadReg(BaseAddress, TmrCtrNumber, RegisterValue) \
+	XTmrCtr_WriteReg((BaseAddress), (TmrCtrNumber), XTC_TLR_OFFSET, \
+			 (RegisterValue))
+
+#define XTmrCtr_GetLoadReg(BaseAddress, TmrCtrNumber) \
+	XTmrCtr_ReadReg((BaseAddress), (TmrCtrNumber), XTC_TLR_OFFSET)
+
+#endif	/* end of protection macro */
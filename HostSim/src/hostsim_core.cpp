@@ -0,0 +1,994 @@
+/******************************************************************************
+* Host simulator core
+*
+* Owns simulated time, the peripheral address windows and the simulated
+* Cortex-A9 IRQ line.
+*
+* Register accesses made through Xil_In32/Xil_Out32 go straight to the
+* owning model. Raw pointer accesses (for example *(u32 *)0x42800000) hit a
+* PROT_NONE mapping of the peripheral page; the SIGSEGV handler forwards the
+* access to the model, opens the page for exactly one instruction and the
+* SIGTRAP raised by the single step closes it again. Both paths charge the
+* modelled AXI cost and count towards the per-device transaction statistics.
+*
+* Interrupts are taken only at safe points: at the start and end of every
+* register access, on the periodic host tick that keeps pure spin loops
+* moving, and when the CPU waits for an interrupt. Time spent by the host
+* executing application code is accounted first, stopping early at the
+* instant an interrupt becomes deliverable, so the handler runs at the
+* simulated time the interrupt was raised rather than at the tick.
+*
+* Only x86-64 Linux hosts are supported because of the single-step trap.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "hostsim_internal.h"
+#include "xil_exception.h"
+#include "xil_io.h"
+#include "xstatus.h"
+#include "xparameters.h"
+#include "sleep.h"
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "The host simulator traps raw MMIO with x86-64 single stepping"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define SIM_PAGE_SIZE		4096U
+#define SIM_MAX_PAGES		32
+#define SIM_TICK_US		200
+#define SIM_EFLAGS_TF		0x100
+#define SIM_PF_WRITE		0x2
+
+/* Default AXI-Lite access cost seen by the Cortex-A9 */
+#define SIM_READ_COST		SIM_NS(60)
+#define SIM_WRITE_COST		SIM_NS(25)
+
+/* Exception entry plus the BSP IRQ vector prologue */
+#define SIM_IRQ_ENTRY_CYCLES	60
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	UINTPTR Addr;		/* Page address the firmware uses */
+	u8 *Alias;		/* Read/write alias used by the trap handlers */
+} SimPage;
+
+typedef struct {
+	SimTime At;
+	u64 Seq;
+	SimEventHandler Handler;
+	void *CallBackRef;
+} SimStimulus;
+
+struct SimStimulusLater {
+	bool operator()(const SimStimulus &A, const SimStimulus &B) const
+	{
+		return (A.At != B.At) ? (A.At > B.At) : (A.Seq > B.Seq);
+	}
+};
+
+/************************** Variable Definitions *****************************/
+
+SimTime SimTimeNow;
+
+static SimDevice *SimDevices[SIM_MAX_DEVICES];
+static int SimNumDevices;
+
+static SimPage SimPages[SIM_MAX_PAGES];
+static int SimNumPages;
+
+static std::priority_queue<SimStimulus, std::vector<SimStimulus>,
+			   SimStimulusLater> SimStimuli
+	__attribute__((init_priority(101)));
+static u64 SimStimulusSeq;
+
+/* Lock depth and trap state are shared with the signal handlers */
+static volatile sig_atomic_t SimDepth;
+static volatile sig_atomic_t SimTrapInFlight;
+static UINTPTR SimTrapAddr;
+static SimPage *SimTrapPage;
+static int SimTrapIsWrite;
+
+static u64 SimHostMark;
+static double SimPsPerHostNs = 1000.0;
+static SimTime SimReadCost = SIM_READ_COST;
+static SimTime SimWriteCost = SIM_WRITE_COST;
+static SimTime SimStopTime = SIM_TIME_NEVER;
+static int SimReportAtExit;
+
+/* Simulated CPU state */
+static int SimIrqMasked = 1;
+static int SimInIrq;
+static Xil_ExceptionHandler SimIrqHandler;
+static void *SimIrqData;
+static SimTime SimIdleTime;
+static SimTime SimIdleSince = SIM_TIME_NEVER;
+static SimTime SimIrqTime;
+
+/************************** Function Prototypes ******************************/
+
+static void SimRunCpu(SimTime Debt);
+
+/*****************************************************************************/
+/**
+*
+* Reads the host monotonic clock.
+*
+* @return	Host time in nanoseconds.
+*
+******************************************************************************/
+static u64 SimHostNs(void)
+{
+	struct timespec Ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &Ts);
+	return (u64)Ts.tv_sec * 1000000000ULL + (u64)Ts.tv_nsec;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the simulated time the application has spent executing on the
+* host since the last mark, and moves the mark to now.
+*
+******************************************************************************/
+static SimTime SimHostElapsed(void)
+{
+	u64 Now = SimHostNs();
+	u64 Delta = Now - SimHostMark;
+
+	SimHostMark = Now;
+	return (SimTime)((double)Delta * SimPsPerHostNs);
+}
+
+SimTime SimCyclesToTime(u64 Cycles, u32 FreqHz)
+{
+	return (SimTime)(((unsigned __int128)Cycles * 1000000000000ULL) /
+			 FreqHz);
+}
+
+u64 SimTimeToCycles(SimTime Time, u32 FreqHz)
+{
+	return (u64)(((unsigned __int128)Time * FreqHz) / 1000000000000ULL);
+}
+
+/*****************************************************************************/
+/**
+*
+* Ends the run once the configured stop time has been reached.
+*
+******************************************************************************/
+static void SimCheckStop(void)
+{
+	if (SimTimeNow >= SimStopTime) {
+		fflush(stdout);
+		exit(0);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the time of the earliest pending device or stimulus event.
+*
+******************************************************************************/
+static SimTime SimNextEvent(void)
+{
+	SimTime Next = SIM_TIME_NEVER;
+	int Index;
+
+	for (Index = 0; Index < SimNumDevices; Index++) {
+		if (SimDevices[Index]->NextEvent < Next) {
+			Next = SimDevices[Index]->NextEvent;
+		}
+	}
+	if (!SimStimuli.empty() && SimStimuli.top().At < Next) {
+		Next = SimStimuli.top().At;
+	}
+
+	return Next;
+}
+
+/*****************************************************************************/
+/**
+*
+* Checks whether the CPU would take an IRQ exception right now.
+*
+******************************************************************************/
+static int SimCpu_IrqPending(void)
+{
+	return !SimIrqMasked && !SimInIrq && SimGic_Signaled();
+}
+
+/*****************************************************************************/
+/**
+*
+* Moves simulated time forward to Target, processing every device and
+* stimulus event on the way in time order.
+*
+* @param	Target is the simulated time to reach.
+* @param	StopAtIrq stops early, at the time of the event that made an
+*		IRQ deliverable, so the caller can take it.
+*
+******************************************************************************/
+static void SimAdvance(SimTime Target, int StopAtIrq)
+{
+	SimTime Next;
+	int Index;
+
+	for (;;) {
+		if (StopAtIrq && SimCpu_IrqPending()) {
+			return;
+		}
+
+		Next = SimNextEvent();
+		if (Next > Target) {
+			break;
+		}
+		if (Next > SimTimeNow) {
+			SimTimeNow = Next;
+		}
+		SimCheckStop();
+
+		for (Index = 0; Index < SimNumDevices; Index++) {
+			SimDevice *Dev = SimDevices[Index];
+
+			if (Dev->NextEvent <= SimTimeNow) {
+				Dev->NextEvent = SIM_TIME_NEVER;
+				Dev->Advance(Dev, SimTimeNow);
+			}
+		}
+		while (!SimStimuli.empty() &&
+		       SimStimuli.top().At <= SimTimeNow) {
+			SimStimulus Stim = SimStimuli.top();
+
+			SimStimuli.pop();
+			Stim.Handler(Stim.CallBackRef);
+		}
+	}
+
+	if (Target > SimTimeNow) {
+		SimTimeNow = Target;
+	}
+	SimCheckStop();
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes one IRQ exception: runs the registered IRQ handler with the CPU in
+* IRQ mode and accounts the time spent there.
+*
+******************************************************************************/
+static void SimCpu_TakeIrq(void)
+{
+	sig_atomic_t Depth = SimDepth;
+	SimTime Entry = SimTimeNow;
+
+	if (SimIrqHandler == NULL) {
+		fprintf(stderr, "hostsim: IRQ with no exception handler, "
+			"masking IRQs\n");
+		SimIrqMasked = 1;
+		return;
+	}
+
+	SimInIrq = 1;
+	SimAdvance(SimTimeNow + SimCyclesToTime(SIM_IRQ_ENTRY_CYCLES,
+			XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ), 0);
+
+	/* The handler is application code again, run it outside the lock */
+	SimDepth = 0;
+	SimHostMark = SimHostNs();
+	SimIrqHandler(SimIrqData);
+	SimDepth = Depth;
+
+	SimAdvance(SimTimeNow + SimHostElapsed(), 0);
+	SimInIrq = 0;
+	SimIrqTime += SimTimeNow - Entry;
+}
+
+/*****************************************************************************/
+/**
+*
+* Lets the CPU execute for Debt of simulated time, taking every interrupt
+* that becomes deliverable along the way at the time it is raised.
+*
+******************************************************************************/
+static void SimRunCpu(SimTime Debt)
+{
+	SimTime Start;
+
+	for (;;) {
+		if (SimCpu_IrqPending()) {
+			SimCpu_TakeIrq();
+			continue;
+		}
+		if (Debt == 0) {
+			break;
+		}
+		Start = SimTimeNow;
+		SimAdvance(SimTimeNow + Debt, 1);
+		Debt -= SimTimeNow - Start;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Brings simulated time up to date with the host and takes pending
+* interrupts. Called with the lock held at depth one.
+*
+******************************************************************************/
+static void SimSync(void)
+{
+	SimRunCpu(SimHostElapsed());
+	SimHostMark = SimHostNs();
+}
+
+/*****************************************************************************/
+/**
+*
+* Enters the simulator. The outermost entry from application context is a
+* safe point: elapsed host time is accounted and due interrupts are taken
+* before the caller touches any model state.
+*
+******************************************************************************/
+void SimLock(void)
+{
+	SimDepth = SimDepth + 1;
+	if (SimDepth == 1 && !SimTrapInFlight) {
+		SimSync();
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Leaves the simulator. The outermost exit takes any interrupt raised by
+* the access that was just made.
+*
+******************************************************************************/
+void SimUnlock(void)
+{
+	if (SimDepth == 1 && !SimTrapInFlight) {
+		SimHostMark = SimHostNs();
+		SimSync();
+	}
+	SimDepth = SimDepth - 1;
+}
+
+void SimDevice_Register(SimDevice *Dev)
+{
+	if (SimNumDevices == SIM_MAX_DEVICES) {
+		fprintf(stderr, "hostsim: too many devices\n");
+		abort();
+	}
+	Dev->NextEvent = SIM_TIME_NEVER;
+	SimDevices[SimNumDevices++] = Dev;
+}
+
+SimDevice *SimDevice_Find(UINTPTR Addr)
+{
+	int Index;
+
+	for (Index = 0; Index < SimNumDevices; Index++) {
+		SimDevice *Dev = SimDevices[Index];
+
+		if (Addr >= Dev->BaseAddress &&
+		    Addr < Dev->BaseAddress + Dev->Size) {
+			return Dev;
+		}
+	}
+
+	return NULL;
+}
+
+void SimSignal_Set(SimSignal *Sig, int Level)
+{
+	int Index;
+
+	Level = (Level != 0);
+	if (Sig->Level == Level) {
+		return;
+	}
+	Sig->Level = Level;
+	for (Index = 0; Index < Sig->NumSinks; Index++) {
+		Sig->Sinks[Index](Sig->Refs[Index], Level);
+	}
+}
+
+void SimSignal_Connect(SimSignal *Sig, SimSignalSink Sink, void *Ref)
+{
+	if (Sig->NumSinks == SIM_SIGNAL_MAX_SINKS) {
+		fprintf(stderr, "hostsim: too many sinks on one signal\n");
+		abort();
+	}
+	Sig->Sinks[Sig->NumSinks] = Sink;
+	Sig->Refs[Sig->NumSinks] = Ref;
+	Sig->NumSinks++;
+}
+
+/*****************************************************************************/
+/**
+*
+* Performs one register read on the model owning Addr. Called locked.
+*
+******************************************************************************/
+static u32 SimBus_ReadLocked(UINTPTR Addr)
+{
+	SimDevice *Dev = SimDevice_Find(Addr);
+
+	SimAdvance(SimTimeNow + SimReadCost, 0);
+	if (Dev == NULL) {
+		return 0;
+	}
+	Dev->Reads++;
+	return Dev->Read(Dev, (u32)(Addr - Dev->BaseAddress) & ~3U);
+}
+
+/*****************************************************************************/
+/**
+*
+* Performs one register write on the model owning Addr. Called locked.
+*
+******************************************************************************/
+static void SimBus_WriteLocked(UINTPTR Addr, u32 Value)
+{
+	SimDevice *Dev = SimDevice_Find(Addr);
+
+	SimAdvance(SimTimeNow + SimWriteCost, 0);
+	if (Dev == NULL) {
+		return;
+	}
+	Dev->Writes++;
+	Dev->Write(Dev, (u32)(Addr - Dev->BaseAddress) & ~3U, Value);
+}
+
+u32 Xil_In32(UINTPTR Addr)
+{
+	u32 Value;
+
+	SimLock();
+	Value = SimBus_ReadLocked(Addr);
+	SimUnlock();
+
+	return Value;
+}
+
+void Xil_Out32(UINTPTR Addr, u32 Value)
+{
+	SimLock();
+	SimBus_WriteLocked(Addr, Value);
+	SimUnlock();
+}
+
+u16 Xil_In16(UINTPTR Addr)
+{
+	return (u16)(Xil_In32(Addr & ~3U) >> ((Addr & 2U) * 8U));
+}
+
+u8 Xil_In8(UINTPTR Addr)
+{
+	return (u8)(Xil_In32(Addr & ~3U) >> ((Addr & 3U) * 8U));
+}
+
+void Xil_Out16(UINTPTR Addr, u16 Value)
+{
+	u32 Shift = (Addr & 2U) * 8U;
+	u32 Word = Xil_In32(Addr & ~3U) & ~(0xFFFFU << Shift);
+
+	Xil_Out32(Addr & ~3U, Word | ((u32)Value << Shift));
+}
+
+void Xil_Out8(UINTPTR Addr, u8 Value)
+{
+	u32 Shift = (Addr & 3U) * 8U;
+	u32 Word = Xil_In32(Addr & ~3U) & ~(0xFFU << Shift);
+
+	Xil_Out32(Addr & ~3U, Word | ((u32)Value << Shift));
+}
+
+/*****************************************************************************/
+/**
+*
+* Finds the trapped peripheral page containing Addr.
+*
+******************************************************************************/
+static SimPage *SimPage_Find(UINTPTR Addr)
+{
+	int Index;
+
+	for (Index = 0; Index < SimNumPages; Index++) {
+		if ((Addr & ~(UINTPTR)(SIM_PAGE_SIZE - 1U)) ==
+		    SimPages[Index].Addr) {
+			return &SimPages[Index];
+		}
+	}
+
+	return NULL;
+}
+
+/*****************************************************************************/
+/**
+*
+* SIGSEGV handler: a raw pointer access hit a peripheral page. Reads are
+* satisfied by placing the model's value in the page before the faulting
+* instruction is restarted; the page is then opened for a single step.
+*
+******************************************************************************/
+static void SimTrap_Fault(int Signal, siginfo_t *Info, void *Context)
+{
+	ucontext_t *Uc = (ucontext_t *)Context;
+	UINTPTR Addr = (UINTPTR)Info->si_addr;
+	SimPage *Page = SimPage_Find(Addr);
+	int SavedErrno = errno;
+
+	(void)Signal;
+	if (Page == NULL) {
+		/* A genuine crash, let it happen */
+		signal(SIGSEGV, SIG_DFL);
+		return;
+	}
+
+	SimLock();
+	Addr &= ~(UINTPTR)3U;
+	SimTrapIsWrite = (Uc->uc_mcontext.gregs[REG_ERR] & SIM_PF_WRITE) != 0;
+	if (!SimTrapIsWrite) {
+		*(u32 *)(Page->Alias + (Addr - Page->Addr)) =
+			SimBus_ReadLocked(Addr);
+	}
+	SimTrapAddr = Addr;
+	SimTrapPage = Page;
+	SimTrapInFlight = 1;
+	SimUnlock();
+
+	mprotect((void *)Page->Addr, SIM_PAGE_SIZE, PROT_READ | PROT_WRITE);
+	Uc->uc_mcontext.gregs[REG_EFL] |= SIM_EFLAGS_TF;
+	errno = SavedErrno;
+}
+
+/*****************************************************************************/
+/**
+*
+* SIGTRAP handler: the trapped instruction has executed. Closes the page
+* again and forwards a store to the model.
+*
+******************************************************************************/
+static void SimTrap_Step(int Signal, siginfo_t *Info, void *Context)
+{
+	ucontext_t *Uc = (ucontext_t *)Context;
+	SimPage *Page = SimTrapPage;
+	int SavedErrno = errno;
+
+	(void)Signal;
+	(void)Info;
+	Uc->uc_mcontext.gregs[REG_EFL] &= ~SIM_EFLAGS_TF;
+	if (!SimTrapInFlight) {
+		return;
+	}
+
+	mprotect((void *)Page->Addr, SIM_PAGE_SIZE, PROT_NONE);
+	SimLock();
+	if (SimTrapIsWrite) {
+		SimBus_WriteLocked(SimTrapAddr,
+			*(u32 *)(Page->Alias + (SimTrapAddr - Page->Addr)));
+	}
+	SimTrapInFlight = 0;
+	SimUnlock();
+	errno = SavedErrno;
+}
+
+/*****************************************************************************/
+/**
+*
+* Host tick: a safe point for code that spins without touching a register.
+*
+******************************************************************************/
+static void SimTick(int Signal)
+{
+	int SavedErrno = errno;
+
+	(void)Signal;
+	if (SimDepth == 0 && !SimTrapInFlight) {
+		SimLock();
+		SimUnlock();
+	}
+	errno = SavedErrno;
+}
+
+/*****************************************************************************/
+/**
+*
+* Maps every register window at its physical base address, inaccessible,
+* with a read/write alias for the trap handlers.
+*
+******************************************************************************/
+static void SimMapWindows(void)
+{
+	std::vector<UINTPTR> Pages;
+	UINTPTR Addr;
+	size_t Index;
+	int Fd;
+	int DevIndex;
+
+	for (DevIndex = 0; DevIndex < SimNumDevices; DevIndex++) {
+		SimDevice *Dev = SimDevices[DevIndex];
+
+		for (Addr = Dev->BaseAddress & ~(UINTPTR)(SIM_PAGE_SIZE - 1U);
+		     Addr < Dev->BaseAddress + Dev->Size;
+		     Addr += SIM_PAGE_SIZE) {
+			bool Known = false;
+
+			for (Index = 0; Index < Pages.size(); Index++) {
+				Known = Known || (Pages[Index] == Addr);
+			}
+			if (!Known) {
+				Pages.push_back(Addr);
+			}
+		}
+	}
+
+	if (Pages.size() > SIM_MAX_PAGES) {
+		fprintf(stderr, "hostsim: too many register pages\n");
+		abort();
+	}
+
+	Fd = memfd_create("hostsim-mmio", 0);
+	if (Fd < 0 || ftruncate(Fd, (off_t)(Pages.size() * SIM_PAGE_SIZE))) {
+		perror("hostsim: memfd");
+		abort();
+	}
+
+	for (Index = 0; Index < Pages.size(); Index++) {
+		off_t Off = (off_t)(Index * SIM_PAGE_SIZE);
+		void *Window = mmap((void *)Pages[Index], SIM_PAGE_SIZE,
+				    PROT_NONE, MAP_SHARED | MAP_FIXED_NOREPLACE,
+				    Fd, Off);
+		void *Alias = mmap(NULL, SIM_PAGE_SIZE, PROT_READ | PROT_WRITE,
+				   MAP_SHARED, Fd, Off);
+
+		if (Window != (void *)Pages[Index] || Alias == MAP_FAILED) {
+			fprintf(stderr, "hostsim: cannot map register page "
+				"0x%08lx\n", (unsigned long)Pages[Index]);
+			abort();
+		}
+		SimPages[SimNumPages].Addr = Pages[Index];
+		SimPages[SimNumPages].Alias = (u8 *)Alias;
+		SimNumPages++;
+	}
+	close(Fd);
+}
+
+/*****************************************************************************/
+/**
+*
+* Maps the files of HOSTSIM_LOAD, "file@address" separated by commas, at
+* their addresses, like XSDB "dow -data" loads them into DDR. The mappings
+* are private: the program may write to them, the files are not changed.
+*
+******************************************************************************/
+static void SimLoadData(const char *Spec)
+{
+	std::string List(Spec);
+	size_t Begin = 0;
+
+	while (Begin < List.size()) {
+		size_t End = List.find(',', Begin);
+		std::string Item = List.substr(Begin,
+				(End == std::string::npos) ?
+				std::string::npos : End - Begin);
+		size_t At = Item.rfind('@');
+		std::string Path = Item.substr(0, At);
+		UINTPTR Addr;
+		struct stat Info;
+		void *Data;
+		int Fd;
+
+		Begin = (End == std::string::npos) ? List.size() : End + 1;
+		if (At == std::string::npos) {
+			fprintf(stderr, "hostsim: HOSTSIM_LOAD wants "
+				"file@address, not %s\n", Item.c_str());
+			abort();
+		}
+		Addr = (UINTPTR)strtoull(Item.c_str() + At + 1, NULL, 0);
+
+		Fd = open(Path.c_str(), O_RDONLY);
+		if (Fd < 0 || fstat(Fd, &Info) != 0) {
+			perror(Path.c_str());
+			abort();
+		}
+		Data = mmap((void *)Addr, (size_t)Info.st_size,
+			    PROT_READ | PROT_WRITE,
+			    MAP_PRIVATE | MAP_FIXED_NOREPLACE, Fd, 0);
+		if (Data != (void *)Addr) {
+			fprintf(stderr, "hostsim: cannot load %s at 0x%08lx\n",
+				Path.c_str(), (unsigned long)Addr);
+			abort();
+		}
+		close(Fd);
+	}
+}
+
+static void SimAtExit(void)
+{
+	if (SimReportAtExit) {
+		fflush(stdout);
+		SimReport(stderr);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Builds the simulated board before main() runs.
+*
+******************************************************************************/
+__attribute__((constructor(102)))
+static void SimInit(void)
+{
+	struct sigaction Action;
+	struct itimerval Tick;
+	const char *Env;
+
+	/* Board models may schedule stimuli, which syncs with the host */
+	SimHostMark = SimHostNs();
+
+	Env = getenv("HOSTSIM_CPU_SCALE");
+	if (Env != NULL && atof(Env) > 0.0) {
+		SimPsPerHostNs = 1000.0 * atof(Env);
+	}
+	Env = getenv("HOSTSIM_STOP_AFTER_MS");
+	if (Env != NULL && atof(Env) > 0.0) {
+		SimStopTime = (SimTime)(atof(Env) * 1e9);
+	}
+	SimReportAtExit = (getenv("HOSTSIM_REPORT") != NULL);
+
+	SimBoard_Init();
+	SimMapWindows();
+	Env = getenv("HOSTSIM_LOAD");
+	if (Env != NULL) {
+		SimLoadData(Env);
+	}
+
+	memset(&Action, 0, sizeof(Action));
+	Action.sa_sigaction = SimTrap_Fault;
+	Action.sa_flags = SA_SIGINFO | SA_NODEFER | SA_RESTART;
+	sigaction(SIGSEGV, &Action, NULL);
+	Action.sa_sigaction = SimTrap_Step;
+	sigaction(SIGTRAP, &Action, NULL);
+
+	memset(&Action, 0, sizeof(Action));
+	Action.sa_handler = SimTick;
+	Action.sa_flags = SA_RESTART;
+	sigaction(SIGALRM, &Action, NULL);
+
+	Tick.it_interval.tv_sec = 0;
+	Tick.it_interval.tv_usec = SIM_TICK_US;
+	Tick.it_value = Tick.it_interval;
+	setitimer(ITIMER_REAL, &Tick, NULL);
+
+	atexit(SimAtExit);
+	SimHostMark = SimHostNs();
+}
+
+/************************** Public simulator API *****************************/
+
+SimTime SimNow(void)
+{
+	SimTime Now;
+
+	SimLock();
+	Now = SimTimeNow;
+	SimUnlock();
+
+	return Now;
+}
+
+void SimSchedule(SimTime At, SimEventHandler Handler, void *CallBackRef)
+{
+	SimStimulus Stim;
+
+	Stim.At = At;
+	Stim.Seq = SimStimulusSeq++;
+	Stim.Handler = Handler;
+	Stim.CallBackRef = CallBackRef;
+
+	SimLock();
+	SimStimuli.push(Stim);
+	SimUnlock();
+}
+
+void SimStopAt(SimTime At)
+{
+	SimStopTime = At;
+}
+
+void SimBus_SetAccessCost(SimTime ReadCost, SimTime WriteCost)
+{
+	SimReadCost = ReadCost;
+	SimWriteCost = WriteCost;
+}
+
+int SimBus_GetStats(UINTPTR BaseAddress, SimBusStats *StatsPtr)
+{
+	SimDevice *Dev = SimDevice_Find(BaseAddress);
+
+	if (Dev == NULL) {
+		return XST_DEVICE_NOT_FOUND;
+	}
+	StatsPtr->Reads = Dev->Reads;
+	StatsPtr->Writes = Dev->Writes;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Models CpuCycles worth of computation on the Cortex-A9. Interrupts are
+* taken as they fall due.
+*
+******************************************************************************/
+void SimCpu_Burn(u32 CpuCycles)
+{
+	SimLock();
+	SimRunCpu(SimCyclesToTime(CpuCycles,
+				  XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ));
+	SimUnlock();
+}
+
+/*****************************************************************************/
+/**
+*
+* Models the WFI instruction: simulated time skips ahead to the next
+* peripheral event until an interrupt is signalled to the CPU. The time
+* skipped is accounted as idle. As on the A9 the CPU wakes even with IRQs
+* masked; the interrupt is then taken only once they are unmasked.
+*
+******************************************************************************/
+void SimCpu_WaitForInterrupt(void)
+{
+	SimTime Next;
+
+	SimLock();
+	while (!SimGic_Signaled()) {
+		Next = SimNextEvent();
+		if (Next == SIM_TIME_NEVER) {
+			if (SimStopTime == SIM_TIME_NEVER) {
+				fprintf(stderr, "hostsim: WFI with nothing "
+					"left to wake the CPU, stopping\n");
+				fflush(stdout);
+				exit(0);
+			}
+			Next = SimStopTime;
+		}
+		/* The run may end in here, see SimCpu_GetStats */
+		SimIdleSince = SimTimeNow;
+		SimAdvance(Next, 0);
+		SimIdleTime += SimTimeNow - SimIdleSince;
+		SimIdleSince = SIM_TIME_NEVER;
+	}
+	SimUnlock();
+}
+
+void SimCpu_GetStats(SimCpuStats *StatsPtr)
+{
+	SimLock();
+	StatsPtr->Now = SimTimeNow;
+	StatsPtr->Idle = SimIdleTime;
+	if (SimIdleSince != SIM_TIME_NEVER) {
+		StatsPtr->Idle += SimTimeNow - SimIdleSince;
+	}
+	StatsPtr->Irq = SimIrqTime;
+	SimUnlock();
+}
+
+void SimReport(FILE *Out)
+{
+	SimCpuStats Cpu;
+	int Index;
+
+	SimCpu_GetStats(&Cpu);
+	fprintf(Out, "hostsim: simulated time %.6f ms, CPU idle %.1f%%, "
+		"in IRQ %.1f%%\n", (double)Cpu.Now / 1e9,
+		Cpu.Now ? 100.0 * (double)Cpu.Idle / (double)Cpu.Now : 0.0,
+		Cpu.Now ? 100.0 * (double)Cpu.Irq / (double)Cpu.Now : 0.0);
+	fprintf(Out, "hostsim: %-10s %12s %12s %12s %12s\n", "device",
+		"reads", "writes", "reads/s", "writes/s");
+	for (Index = 0; Index < SimNumDevices; Index++) {
+		SimDevice *Dev = SimDevices[Index];
+
+		if (Dev->Size != 0) {
+			fprintf(Out, "hostsim: %-10s %12llu %12llu %12.0f "
+				"%12.0f\n", Dev->Name,
+				(unsigned long long)Dev->Reads,
+				(unsigned long long)Dev->Writes,
+				Cpu.Now ? (double)Dev->Reads * 1e12 /
+					  (double)Cpu.Now : 0.0,
+				Cpu.Now ? (double)Dev->Writes * 1e12 /
+					  (double)Cpu.Now : 0.0);
+		}
+	}
+	SimGic_Report(Out);
+	SimCan_Report(Out);
+	SimCanFd_Report(Out);
+}
+
+/************************** BSP exception support ****************************/
+
+void Xil_ExceptionInit(void)
+{
+}
+
+void Xil_ExceptionRegisterHandler(u32 Exception_id,
+				  Xil_ExceptionHandler Handler, void *Data)
+{
+	if (Exception_id == XIL_EXCEPTION_ID_IRQ_INT) {
+		SimIrqHandler = Handler;
+		SimIrqData = Data;
+	}
+}
+
+void Xil_ExceptionRemoveHandler(u32 Exception_id)
+{
+	if (Exception_id == XIL_EXCEPTION_ID_IRQ_INT) {
+		SimIrqHandler = NULL;
+		SimIrqData = NULL;
+	}
+}
+
+void Xil_ExceptionEnableMask(u32 Mask)
+{
+	SimLock();
+	if (Mask & XIL_EXCEPTION_IRQ) {
+		SimIrqMasked = 0;
+	}
+	SimUnlock();
+}
+
+void Xil_ExceptionDisableMask(u32 Mask)
+{
+	SimLock();
+	if (Mask & XIL_EXCEPTION_IRQ) {
+		SimIrqMasked = 1;
+	}
+	SimUnlock();
+}
+
+/************************** BSP sleep support ********************************/
+
+int usleep(useconds_t useconds)
+{
+	SimLock();
+	SimRunCpu(SIM_US(useconds));
+	SimUnlock();
+
+	return 0;
+}
+
+unsigned int sleep(unsigned int seconds)
+{
+	SimLock();
+	SimRunCpu(SIM_MS((u64)seconds * 1000ULL));
+	SimUnlock();
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+/******************************************************************************
+* Host simulator internals shared between the core and the peripheral models.
+******************************************************************************/
+
+#ifndef HOSTSIM_INTERNAL_H	/* prevent circular inclusions */
+#define HOSTSIM_INTERNAL_H
+
+#include "hostsim.h"
+
+/************************** Constant Definitions *****************************/
+
+#define SIM_MAX_DEVICES		16
+#define SIM_SIGNAL_MAX_SINKS	4
+
+/**************************** Type Definitions *******************************/
+
+typedef struct SimDevice SimDevice;
+
+/*
+ * A peripheral model. Register accesses arrive through Read/Write with the
+ * offset relative to BaseAddress. Models with timed behaviour publish the
+ * time of their next internal event in NextEvent; the core calls Advance
+ * once simulated time reaches it. Devices without registers (a CAN bus, for
+ * example) use a Size of zero and only take part in event processing.
+ */
+struct SimDevice {
+	const char *Name;
+	UINTPTR BaseAddress;
+	u32 Size;
+	u32 (*Read)(SimDevice *Dev, u32 Offset);
+	void (*Write)(SimDevice *Dev, u32 Offset, u32 Value);
+	void (*Advance)(SimDevice *Dev, SimTime Now);
+	SimTime NextEvent;
+	void *Priv;
+	u64 Reads;
+	u64 Writes;
+};
+
+/*
+ * A wire between two models, e.g. the timer GENERATEOUT0 pin routed to a
+ * GPIO input. Sinks are called synchronously on every level change.
+ */
+typedef void (*SimSignalSink)(void *Ref, int Level);
+
+typedef struct {
+	int Level;
+	int NumSinks;
+	SimSignalSink Sinks[SIM_SIGNAL_MAX_SINKS];
+	void *Refs[SIM_SIGNAL_MAX_SINKS];
+} SimSignal;
+
+/************************** Function Prototypes ******************************/
+
+/* Core, in hostsim_core.cpp */
+extern SimTime SimTimeNow;
+
+void SimDevice_Register(SimDevice *Dev);
+SimDevice *SimDevice_Find(UINTPTR Addr);
+void SimLock(void);
+void SimUnlock(void);
+void SimSignal_Set(SimSignal *Sig, int Level);
+void SimSignal_Connect(SimSignal *Sig, SimSignalSink Sink, void *Ref);
+
+/* Interrupt controller, in sim_gic.cpp */
+void SimGic_Create(UINTPTR CpuBase, UINTPTR DistBase);
+void SimGic_SetLine(u32 IntrId, int Level);
+int SimGic_Signaled(void);
+void SimGic_Report(FILE *Out);
+
+/* Peripheral models */
+void SimTmrCtr_Create(UINTPTR BaseAddress, u32 ClockHz, u32 IntrId);
+SimSignal *SimTmrCtr_GenerateOut(UINTPTR BaseAddress, u8 TmrCtrNumber);
+SimSignal *SimTmrCtr_PwmOut(UINTPTR BaseAddress);
+void SimTmrCtr_ConnectCapture(UINTPTR BaseAddress, u8 TmrCtrNumber,
+			      SimSignal *Sig, int ActiveLow);
+
+void SimGpio_Create(UINTPTR BaseAddress, int IsDual, u32 IntrId);
+void SimGpio_ConnectInput(UINTPTR BaseAddress, unsigned Channel, u32 Bit,
+			  SimSignal *Sig);
+
+void SimCan_Create(UINTPTR BaseAddress, u32 ClockHz, u32 IntrId, int BusId,
+		   u32 TxDepth, u32 RxDepth);
+void SimCan_Report(FILE *Out);
+u32 SimCan_FrameBits(u32 Id, u32 DlcReg, u32 Dw1, u32 Dw2);
+
+void SimCanFd_Create(UINTPTR BaseAddress, u32 ClockHz, u32 IntrId,
+		     u32 NumTxBuffers, u32 RxDepth);
+void SimCanFd_Report(FILE *Out);
+
+/* Board description, in sim_board.cpp */
+void SimBoard_Init(void);
+
+#endif	/* end of protection macro */
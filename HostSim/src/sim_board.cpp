@@ -0,0 +1,154 @@
+/******************************************************************************
+* Simulated board
+*
+* Instantiates the models described by xparameters.h and wires them up the
+* way the tutorial hardware designs do: the timer GENERATEOUT0 pin drives
+* bit 0 of the first GPIO channel (the Tut8 genout loopback), its PWM0 pin
+* drives an LED and both capture inputs of the second timer, the second
+* one active low, and every PL interrupt goes to its IRQ_F2P input of the
+* GIC. The three switches of
+* Tut8/q1.cpp on the second GPIO channel can be flipped periodically, with
+* contact bounce, see HOSTSIM_SWITCH_MS and HOSTSIM_SWITCH_BOUNCE_US in
+* hostsim.h, and the first CAN controller given a window of bus faults
+* with HOSTSIM_CAN_FAULT. The two CAN controllers sit on separate buses,
+* as on a board bridging two networks, and the CAN FD controller on a bus
+* of its own.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hostsim_internal.h"
+#include "hostsim.h"
+#include "xparameters.h"
+#include "xcan_l.h"
+
+/************************** Constant Definitions *****************************/
+
+#define SIM_BOARD_SWITCH_CHANNEL	2U
+#define SIM_BOARD_SWITCH_MASK		0x7U
+
+/* Glitches back to the old position within the bounce time of a flip */
+#define SIM_BOARD_SWITCH_GLITCHES	3U
+
+/************************** Variable Definitions *****************************/
+
+static SimTime SimBoard_SwitchPeriod;
+static SimTime SimBoard_SwitchBounce;
+static u32 SimBoard_Switches;
+
+/*****************************************************************************/
+/**
+*
+* Drives the switch pins to the level carried in CallBackRef.
+*
+******************************************************************************/
+static void SimBoard_SetSwitches(void *CallBackRef)
+{
+	SimGpio_SetInput(XPAR_GPIO_0_BASEADDR, SIM_BOARD_SWITCH_CHANNEL,
+			 (u32)(UINTPTR)CallBackRef);
+}
+
+/*****************************************************************************/
+/**
+*
+* Moves the switches to their next position and schedules the next flip.
+* With bounce configured the contacts first chatter between the old and the
+* new position, settling SimBoard_SwitchBounce after the flip.
+*
+******************************************************************************/
+static void SimBoard_FlipSwitches(void *CallBackRef)
+{
+	SimTime Now = SimNow();
+	u32 Old = SimBoard_Switches;
+	u32 Index;
+
+	(void)CallBackRef;
+
+	SimBoard_Switches = (Old + 1U) & SIM_BOARD_SWITCH_MASK;
+	SimGpio_SetInput(XPAR_GPIO_0_BASEADDR, SIM_BOARD_SWITCH_CHANNEL,
+			 SimBoard_Switches);
+
+	if (SimBoard_SwitchBounce != 0U) {
+		for (Index = 1U; Index <= SIM_BOARD_SWITCH_GLITCHES; Index++) {
+			SimSchedule(Now + (SimBoard_SwitchBounce * (2U * Index - 1U)) /
+				    (2U * SIM_BOARD_SWITCH_GLITCHES),
+				    SimBoard_SetSwitches, (void *)(UINTPTR)Old);
+			SimSchedule(Now + (SimBoard_SwitchBounce * Index) /
+				    SIM_BOARD_SWITCH_GLITCHES,
+				    SimBoard_SetSwitches,
+				    (void *)(UINTPTR)SimBoard_Switches);
+		}
+	}
+
+	SimSchedule(Now + SimBoard_SwitchPeriod, SimBoard_FlipSwitches, NULL);
+}
+
+/*****************************************************************************/
+/**
+*
+* Creates the peripheral models. Called once before main().
+*
+******************************************************************************/
+void SimBoard_Init(void)
+{
+	const char *Env;
+	double FaultAt;
+	double FaultLength;
+
+	SimGic_Create(XPAR_SCUGIC_0_CPU_BASEADDR, XPAR_SCUGIC_0_DIST_BASEADDR);
+
+	SimTmrCtr_Create(XPAR_TMRCTR_0_BASEADDR, XPAR_TMRCTR_0_CLOCK_FREQ_HZ,
+			 XPAR_FABRIC_TMRCTR_0_VEC_ID);
+	SimTmrCtr_Create(XPAR_TMRCTR_1_BASEADDR, XPAR_TMRCTR_1_CLOCK_FREQ_HZ,
+			 XPAR_FABRIC_TMRCTR_1_VEC_ID);
+	SimTmrCtr_Create(XPAR_TMRCTR_2_BASEADDR, XPAR_TMRCTR_2_CLOCK_FREQ_HZ,
+			 XPAR_FABRIC_TMRCTR_2_VEC_ID);
+
+	SimGpio_Create(XPAR_GPIO_0_BASEADDR, XPAR_GPIO_0_IS_DUAL,
+		       XPAR_FABRIC_GPIO_0_VEC_ID);
+
+	SimCan_Create(XPAR_CAN_0_BASEADDR, XPAR_CAN_0_CAN_CLK_FREQ_HZ,
+		      XPAR_FABRIC_CAN_0_VEC_ID, 0, XPAR_CAN_0_CAN_TX_DPTH,
+		      XPAR_CAN_0_CAN_RX_DPTH);
+	SimCan_Create(XPAR_CAN_1_BASEADDR, XPAR_CAN_1_CAN_CLK_FREQ_HZ,
+		      XPAR_FABRIC_CAN_1_VEC_ID, 1, XPAR_CAN_1_CAN_TX_DPTH,
+		      XPAR_CAN_1_CAN_RX_DPTH);
+	SimCanFd_Create(XPAR_CANFD_0_BASEADDR, XPAR_CANFD_0_CAN_CLK_FREQ_HZ,
+			XPAR_FABRIC_CANFD_0_VEC_ID, XPAR_CANFD_0_NUM_OF_TX_BUF,
+			XPAR_CANFD_0_NUM_OF_RX_MB_BUF);
+
+	SimGpio_ConnectInput(XPAR_GPIO_0_BASEADDR, 1, 0x1,
+			     SimTmrCtr_GenerateOut(XPAR_TMRCTR_0_BASEADDR, 0));
+	SimTmrCtr_ConnectCapture(XPAR_TMRCTR_1_BASEADDR, 0,
+				 SimTmrCtr_PwmOut(XPAR_TMRCTR_0_BASEADDR), 0);
+	SimTmrCtr_ConnectCapture(XPAR_TMRCTR_1_BASEADDR, 1,
+				 SimTmrCtr_PwmOut(XPAR_TMRCTR_0_BASEADDR), 1);
+
+	Env = getenv("HOSTSIM_SWITCH_MS");
+	if (Env != NULL && atof(Env) > 0.0) {
+		SimBoard_SwitchPeriod = (SimTime)(atof(Env) * 1e9);
+		Env = getenv("HOSTSIM_SWITCH_BOUNCE_US");
+		if (Env != NULL && atof(Env) > 0.0) {
+			SimBoard_SwitchBounce = (SimTime)(atof(Env) * 1e6);
+		}
+		SimSchedule(SimBoard_SwitchPeriod, SimBoard_FlipSwitches,
+			    NULL);
+	}
+
+	Env = getenv("HOSTSIM_CAN_FAULT");
+	if (Env != NULL) {
+		if (sscanf(Env, "%lf:%lf", &FaultAt, &FaultLength) != 2 ||
+		    FaultAt < 0.0 || FaultLength <= 0.0) {
+			fprintf(stderr, "hostsim: HOSTSIM_CAN_FAULT wants "
+				"at_ms:length_ms\n");
+			abort();
+		}
+		SimCan_InjectFault(XPAR_CAN_0_BASEADDR,
+				   (SimTime)(FaultAt * 1e9),
+				   (SimTime)((FaultAt + FaultLength) * 1e9),
+				   XCAN_ESR_BERR_MASK);
+	}
+}
@@ -0,0 +1,1048 @@
+/******************************************************************************
+* AXI CAN (PG096) controller and CAN bus model
+*
+* Each controller has a TX FIFO, a one-frame high priority buffer (HPB) and
+* an RX FIFO, all holding frames in register format (ID, DLC, DW1, DW2 with
+* data byte 0 in bits 31:24 of DW1). Controllers in normal mode share a
+* simulated bus; in loopback mode a controller transmits on a private bus
+* that only it listens to.
+*
+* The bus arbitrates at each start of frame between the head frames of all
+* attached controllers and any externally injected traffic, lowest
+* identifier register value first, which is the CAN arbitration order. The
+* frame then occupies the bus for its exact length: the stuffed bits from
+* SOF to the end of the CRC, plus CRC delimiter, ACK, EOF and interframe
+* space, at the bit time given by BRPR/BTR and the CAN clock.
+*
+* A frame nobody acknowledges raises an ACK error and is retried. By
+* default an external node on the bus acknowledges every frame so a single
+* controller in normal mode works; SimCan_SetAck() removes it.
+*
+* SimCan_SetMonitor() taps a bus, as a bus analyzer would, for every frame
+* acknowledged on it.
+*
+* SimCan_InjectFault() makes every frame a controller starts transmitting
+* within a time window fail with the given ESR errors, as a shorted or
+* mis-terminated bus does. Each failure adds 8 to the transmit error
+* counter, so a controller retrying one frame goes error passive after 16
+* attempts and bus-off after 32.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <string.h>
+#include <deque>
+
+#include "hostsim_internal.h"
+#include "xcan_l.h"
+#include "xil_io.h"
+
+/************************** Constant Definitions *****************************/
+
+#define SIM_CAN_NUM_INSTANCES	2
+#define SIM_CAN_NUM_BUSES	2
+#define SIM_CAN_MAX_NODES	4
+#define SIM_CAN_MAX_DEPTH	64
+#define SIM_CAN_NUM_FILTERS	4
+
+/* Error counter thresholds from ISO 11898-1 */
+#define SIM_CAN_WARNING_LIMIT	96U
+#define SIM_CAN_PASSIVE_LIMIT	127U
+#define SIM_CAN_BUSOFF_LIMIT	255U
+
+/* Default bit time for external traffic on a bus with no configured node */
+#define SIM_CAN_DEFAULT_BIT	SIM_US(1)
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 Id;
+	u32 Dlc;
+	u32 Dw1;
+	u32 Dw2;
+} SimCanFrame;
+
+typedef struct {
+	SimCanFrame Frame[SIM_CAN_MAX_DEPTH];
+	u32 Head;
+	u32 Count;
+	u32 Depth;
+} SimCanFifo;
+
+typedef struct {
+	SimTime At;
+	SimCanFrame Frame;
+} SimCanExtFrame;
+
+typedef struct SimCan SimCan;
+
+typedef struct {
+	SimDevice Dev;
+	SimCan *Nodes[SIM_CAN_MAX_NODES];
+	int NumNodes;
+	int IsLoopback;
+	int Ack;
+
+	int Busy;
+	int Aborted;
+	SimCanFrame Cur;
+	SimCan *Sender;
+	int FromHpb;
+	SimTime Start;
+	SimTime End;
+
+	std::deque<SimCanExtFrame> *External;
+	SimCanMonitor Monitor;
+	void *MonitorRef;
+
+	u64 Frames;
+	SimTime BusyTime;
+} SimCanBus;
+
+struct SimCan {
+	SimDevice Dev;
+	u32 ClockHz;
+	u32 IntrId;
+
+	u32 Srr;
+	u32 Msr;
+	u32 Brpr;
+	u32 Btr;
+	u32 Esr;
+	u32 Isr;
+	u32 Ier;
+	u32 Afr;
+	u32 Afmr[SIM_CAN_NUM_FILTERS];
+	u32 Afir[SIM_CAN_NUM_FILTERS];
+	u32 Tec;
+	u32 Rec;
+	int BusOff;
+	SimTime RecoverAt;
+	SimTime FaultFrom;		/* Injected transmit errors */
+	SimTime FaultUntil;
+	u32 FaultEsr;
+
+	SimCanFrame TxStage;
+	SimCanFrame HpbStage;
+	SimCanFrame Hpb;
+	int HpbFull;
+	SimCanFifo TxFifo;
+	SimCanFifo RxFifo;
+
+	SimCanBus *Bus;
+	SimCanBus Loop;
+
+	SimCanStats Stats;
+};
+
+/************************** Variable Definitions *****************************/
+
+static SimCan SimCans[SIM_CAN_NUM_INSTANCES];
+static int SimNumCans;
+static SimCanBus SimCanBuses[SIM_CAN_NUM_BUSES];
+
+/************************** Function Prototypes ******************************/
+
+static void SimCanBus_Kick(SimCanBus *Bus);
+
+/*****************************************************************************/
+/**
+*
+* Appends Count bits of Value, most significant first, to a bit string.
+*
+******************************************************************************/
+static void SimCan_PushBits(u8 *Bits, u32 *Num, u32 Value, u32 Count)
+{
+	while (Count-- > 0U) {
+		Bits[(*Num)++] = (u8)((Value >> Count) & 1U);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the number of bit times a data or remote frame occupies the bus,
+* including stuff bits and interframe space. The frame is given by its
+* registers, data byte 0 in bits 31:24 of Dw1. The CAN FD model uses it for
+* the classic frames it sends.
+*
+******************************************************************************/
+u32 SimCan_FrameBits(u32 Id, u32 DlcReg, u32 Dw1, u32 Dw2)
+{
+	u8 Bits[160];
+	u32 Num = 0;
+	u32 Dlc = DlcReg >> XCAN_DLCR_DLC_SHIFT;
+	int Extended = (Id & XCAN_IDR_IDE_MASK) != 0;
+	u32 Rtr;
+	u32 Crc = 0;
+	u32 Stuff = 0;
+	u32 Run = 1;
+	u32 Index;
+	u8 Last;
+
+	SimCan_PushBits(Bits, &Num, 0, 1);
+	SimCan_PushBits(Bits, &Num, Id >> XCAN_IDR_ID1_SHIFT, 11);
+	if (Extended) {
+		Rtr = Id & XCAN_IDR_RTR_MASK;
+		SimCan_PushBits(Bits, &Num, 3, 2);	/* SRR, IDE */
+		SimCan_PushBits(Bits, &Num, Id >> XCAN_IDR_ID2_SHIFT,
+				18);
+		SimCan_PushBits(Bits, &Num, Rtr, 1);
+		SimCan_PushBits(Bits, &Num, 0, 2);	/* r1, r0 */
+	} else {
+		Rtr = (Id & XCAN_IDR_SRR_MASK) != 0;
+		SimCan_PushBits(Bits, &Num, Rtr, 1);
+		SimCan_PushBits(Bits, &Num, 0, 2);	/* IDE, r0 */
+	}
+	SimCan_PushBits(Bits, &Num, Dlc, 4);
+	if (!Rtr) {
+		for (Index = 0; Index < Dlc && Index < 8U; Index++) {
+			u32 Word = (Index < 4U) ? Dw1 : Dw2;
+
+			SimCan_PushBits(Bits, &Num,
+					Word >> (24U - 8U * (Index % 4U)), 8);
+		}
+	}
+
+	for (Index = 0; Index < Num; Index++) {
+		u32 Next = Bits[Index] ^ ((Crc >> 14) & 1U);
+
+		Crc = (Crc << 1) & 0x7FFFU;
+		if (Next) {
+			Crc ^= 0x4599U;
+		}
+	}
+	SimCan_PushBits(Bits, &Num, Crc, 15);
+
+	Last = Bits[0];
+	for (Index = 1; Index < Num; Index++) {
+		if (Bits[Index] == Last) {
+			Run++;
+		} else {
+			Last = Bits[Index];
+			Run = 1;
+		}
+		if (Run == 5U) {
+			Stuff++;
+			Last = (u8)!Last;
+			Run = 1;
+		}
+	}
+
+	/* CRC delimiter, ACK slot and delimiter, EOF, interframe space */
+	return Num + Stuff + 1U + 2U + 7U + 3U;
+}
+
+static SimTime SimCan_BitTime(const SimCan *Can)
+{
+	u32 Ts1 = Can->Btr & XCAN_BTR_TS1_MASK;
+	u32 Ts2 = (Can->Btr & XCAN_BTR_TS2_MASK) >> XCAN_BTR_TS2_SHIFT;
+
+	return SimCyclesToTime((u64)(Can->Brpr + 1U) * (3U + Ts1 + Ts2),
+			       Can->ClockHz);
+}
+
+static int SimCan_FifoFull(const SimCanFifo *Fifo)
+{
+	return Fifo->Count == Fifo->Depth;
+}
+
+static SimCanFrame *SimCan_FifoHead(SimCanFifo *Fifo)
+{
+	return &Fifo->Frame[Fifo->Head];
+}
+
+static void SimCan_FifoPush(SimCanFifo *Fifo, const SimCanFrame *Frame)
+{
+	Fifo->Frame[(Fifo->Head + Fifo->Count) % Fifo->Depth] = *Frame;
+	Fifo->Count++;
+}
+
+static void SimCan_FifoPop(SimCanFifo *Fifo)
+{
+	Fifo->Head = (Fifo->Head + 1U) % Fifo->Depth;
+	Fifo->Count--;
+}
+
+static void SimCan_UpdateLine(SimCan *Can)
+{
+	SimGic_SetLine(Can->IntrId, (Can->Isr & Can->Ier & XCAN_IXR_ALL) != 0);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the bus the controller currently transmits on and listens to, or
+* NULL in configuration and sleep mode and while bus-off.
+*
+******************************************************************************/
+static SimCanBus *SimCan_ActiveBus(SimCan *Can)
+{
+	if (!(Can->Srr & XCAN_SRR_CEN_MASK) || Can->BusOff) {
+		return NULL;
+	}
+	if (Can->Msr & XCAN_MSR_LBACK_MASK) {
+		return &Can->Loop;
+	}
+	if (Can->Msr & XCAN_MSR_SLEEP_MASK) {
+		return NULL;
+	}
+	return Can->Bus;
+}
+
+static void SimCan_KickAll(SimCan *Can)
+{
+	SimCanBus_Kick(Can->Bus);
+	SimCanBus_Kick(&Can->Loop);
+}
+
+/*****************************************************************************/
+/**
+*
+* Drops the frame this controller has on the wire, if any. Used when the
+* controller leaves the bus in the middle of a transmission.
+*
+******************************************************************************/
+static void SimCan_AbortTx(SimCan *Can)
+{
+	SimCanBus *Buses[2] = { Can->Bus, &Can->Loop };
+	int Index;
+
+	for (Index = 0; Index < 2; Index++) {
+		if (Buses[Index]->Busy && Buses[Index]->Sender == Can) {
+			Buses[Index]->Sender = NULL;
+			Buses[Index]->Aborted = 1;
+		}
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Adds to the transmit error counter, going bus-off past the limit. The
+* controller rejoins on its own after 128 occurrences of 11 recessive bits.
+*
+******************************************************************************/
+static void SimCan_AddTec(SimCan *Can, u32 Amount)
+{
+	Can->Tec += Amount;
+	if (Can->Tec > SIM_CAN_BUSOFF_LIMIT) {
+		Can->Tec = SIM_CAN_BUSOFF_LIMIT;
+		Can->BusOff = 1;
+		Can->Isr |= XCAN_IXR_BSOFF_MASK;
+		Can->Stats.BusOffs++;
+		SimCan_AbortTx(Can);
+		Can->RecoverAt = SimTimeNow + 128U * 11U * SimCan_BitTime(Can);
+		Can->Dev.NextEvent = Can->RecoverAt;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Stores a frame seen on the bus in the RX FIFO, subject to the acceptance
+* filters.
+*
+******************************************************************************/
+static void SimCan_Receive(SimCan *Can, const SimCanFrame *Frame)
+{
+	int Index;
+
+	if (Can->Afr & XCAN_AFR_UAF_ALL_MASK) {
+		int Accept = 0;
+
+		for (Index = 0; Index < SIM_CAN_NUM_FILTERS; Index++) {
+			if ((Can->Afr & (1U << Index)) &&
+			    ((Frame->Id & Can->Afmr[Index]) ==
+			     (Can->Afir[Index] & Can->Afmr[Index]))) {
+				Accept = 1;
+			}
+		}
+		if (!Accept) {
+			Can->Stats.RxFiltered++;
+			return;
+		}
+	}
+
+	if (Can->Rec > 0U) {
+		Can->Rec--;
+	}
+
+	if (SimCan_FifoFull(&Can->RxFifo)) {
+		Can->Isr |= XCAN_IXR_RXOFLW_MASK;
+		Can->Stats.RxOverflows++;
+	} else {
+		SimCan_FifoPush(&Can->RxFifo, Frame);
+		Can->Isr |= XCAN_IXR_RXOK_MASK | XCAN_IXR_RXNEMP_MASK;
+		Can->Stats.RxFrames++;
+		if (Can->RxFifo.Count > Can->Stats.RxFifoPeak) {
+			Can->Stats.RxFifoPeak = Can->RxFifo.Count;
+		}
+	}
+	SimCan_UpdateLine(Can);
+}
+
+/*****************************************************************************/
+/**
+*
+* Starts the next frame on an idle bus: arbitration between the pending
+* head frames of all attached controllers and due external traffic.
+*
+******************************************************************************/
+static void SimCanBus_Kick(SimCanBus *Bus)
+{
+	SimCan *Contender[SIM_CAN_MAX_NODES];
+	int NumContenders = 0;
+	SimCan *Winner = NULL;
+	const SimCanFrame *Best = NULL;
+	SimTime BitTime = SIM_CAN_DEFAULT_BIT;
+	int Index;
+
+	if (Bus->Busy) {
+		return;
+	}
+
+	for (Index = 0; Index < Bus->NumNodes; Index++) {
+		SimCan *Can = Bus->Nodes[Index];
+		const SimCanFrame *Frame;
+
+		if (SimCan_ActiveBus(Can) != Bus) {
+			continue;
+		}
+		if (Can->HpbFull) {
+			Frame = &Can->Hpb;
+		} else if (Can->TxFifo.Count != 0U) {
+			Frame = SimCan_FifoHead(&Can->TxFifo);
+		} else {
+			continue;
+		}
+		Contender[NumContenders++] = Can;
+		if (Best == NULL || Frame->Id < Best->Id) {
+			Best = Frame;
+			Winner = Can;
+		}
+	}
+
+	if (!Bus->External->empty() && Bus->External->front().At <= SimTimeNow &&
+	    (Best == NULL || Bus->External->front().Frame.Id < Best->Id)) {
+		Best = &Bus->External->front().Frame;
+		Winner = NULL;
+	}
+
+	if (Best == NULL) {
+		Bus->Dev.NextEvent = Bus->External->empty() ? SIM_TIME_NEVER :
+				     Bus->External->front().At;
+		return;
+	}
+
+	for (Index = 0; Index < NumContenders; Index++) {
+		if (Contender[Index] != Winner) {
+			Contender[Index]->Isr |= XCAN_IXR_ARBLST_MASK;
+			Contender[Index]->Stats.ArbitrationLost++;
+			SimCan_UpdateLine(Contender[Index]);
+		}
+	}
+
+	Bus->Cur = *Best;
+	Bus->Sender = Winner;
+	Bus->Aborted = 0;
+	if (Winner != NULL) {
+		Bus->FromHpb = Winner->HpbFull;
+		BitTime = SimCan_BitTime(Winner);
+	} else {
+		Bus->External->pop_front();
+		for (Index = 0; Index < Bus->NumNodes; Index++) {
+			if (SimCan_ActiveBus(Bus->Nodes[Index]) == Bus) {
+				BitTime = SimCan_BitTime(Bus->Nodes[Index]);
+				break;
+			}
+		}
+	}
+
+	Bus->Busy = 1;
+	Bus->Start = SimTimeNow;
+	Bus->End = SimTimeNow + BitTime * SimCan_FrameBits(Bus->Cur.Id,
+				Bus->Cur.Dlc, Bus->Cur.Dw1, Bus->Cur.Dw2);
+	Bus->Dev.NextEvent = Bus->End;
+}
+
+/*****************************************************************************/
+/**
+*
+* Completes the frame on the wire: acknowledgement, TX completion on the
+* sender and reception on every other listening node.
+*
+******************************************************************************/
+static void SimCanBus_Complete(SimCanBus *Bus)
+{
+	SimCan *Sender = Bus->Sender;
+	int Ack = Bus->IsLoopback || Bus->Ack;
+	int Index;
+
+	Bus->Busy = 0;
+	Bus->Frames++;
+	Bus->BusyTime += Bus->End - Bus->Start;
+	if (Bus->Aborted) {
+		return;
+	}
+
+	/* An injected fault destroys the frame for every node */
+	if (Sender != NULL && Sender->FaultEsr != 0U &&
+	    Bus->Start >= Sender->FaultFrom &&
+	    Bus->Start < Sender->FaultUntil) {
+		Sender->Esr |= Sender->FaultEsr;
+		Sender->Isr |= XCAN_IXR_ERROR_MASK;
+		Sender->Stats.TxErrors++;
+		SimCan_AddTec(Sender, 8);
+		SimCan_UpdateLine(Sender);
+		return;
+	}
+
+	for (Index = 0; Index < Bus->NumNodes; Index++) {
+		SimCan *Can = Bus->Nodes[Index];
+
+		if (Can != Sender && SimCan_ActiveBus(Can) == Bus) {
+			Ack = 1;
+		}
+	}
+
+	if (Sender != NULL) {
+		if (Ack) {
+			if (Bus->FromHpb) {
+				Sender->HpbFull = 0;
+			} else {
+				SimCan_FifoPop(&Sender->TxFifo);
+			}
+			if (Sender->Tec > 0U) {
+				Sender->Tec--;
+			}
+			Sender->Isr |= XCAN_IXR_TXOK_MASK;
+			Sender->Stats.TxFrames++;
+		} else {
+			Sender->Esr |= XCAN_ESR_ACKER_MASK;
+			Sender->Isr |= XCAN_IXR_ERROR_MASK;
+			/* An error passive transmitter does not count ACK errors */
+			if (Sender->Tec <= SIM_CAN_PASSIVE_LIMIT) {
+				SimCan_AddTec(Sender, 8);
+			}
+		}
+		SimCan_UpdateLine(Sender);
+	}
+
+	if (!Ack) {
+		return;
+	}
+	if (Bus->Monitor != NULL) {
+		u32 Frame[4] = { Bus->Cur.Id, Bus->Cur.Dlc,
+				 Xil_Htonl(Bus->Cur.Dw1),
+				 Xil_Htonl(Bus->Cur.Dw2) };
+
+		Bus->Monitor(Bus->MonitorRef, Bus->End, Frame);
+	}
+	for (Index = 0; Index < Bus->NumNodes; Index++) {
+		SimCan *Can = Bus->Nodes[Index];
+
+		if ((Can != Sender || Bus->IsLoopback) &&
+		    SimCan_ActiveBus(Can) == Bus) {
+			SimCan_Receive(Can, &Bus->Cur);
+		}
+	}
+}
+
+static void SimCanBus_Advance(SimDevice *Dev, SimTime Now)
+{
+	SimCanBus *Bus = (SimCanBus *)Dev->Priv;
+
+	if (Bus->Busy && Bus->End <= Now) {
+		SimCanBus_Complete(Bus);
+	}
+	SimCanBus_Kick(Bus);
+}
+
+static void SimCanBus_Init(SimCanBus *Bus, const char *Name, int IsLoopback)
+{
+	Bus->Dev.Name = Name;
+	Bus->Dev.Advance = SimCanBus_Advance;
+	Bus->Dev.Priv = Bus;
+	Bus->IsLoopback = IsLoopback;
+	Bus->Ack = !IsLoopback;
+	Bus->External = new std::deque<SimCanExtFrame>();
+	SimDevice_Register(&Bus->Dev);
+}
+
+/*****************************************************************************/
+/**
+*
+* Puts the controller back into its reset state.
+*
+******************************************************************************/
+static void SimCan_Reset(SimCan *Can)
+{
+	SimCan_AbortTx(Can);
+	Can->Srr = 0;
+	Can->Msr = 0;
+	Can->Brpr = 0;
+	Can->Btr = 0;
+	Can->Esr = 0;
+	Can->Isr = 0;
+	Can->Ier = 0;
+	Can->Afr = 0;
+	memset(Can->Afmr, 0, sizeof(Can->Afmr));
+	memset(Can->Afir, 0, sizeof(Can->Afir));
+	Can->Tec = 0;
+	Can->Rec = 0;
+	Can->BusOff = 0;
+	Can->HpbFull = 0;
+	Can->TxFifo.Head = 0;
+	Can->TxFifo.Count = 0;
+	Can->RxFifo.Head = 0;
+	Can->RxFifo.Count = 0;
+	SimCan_UpdateLine(Can);
+}
+
+static u32 SimCan_Status(SimCan *Can)
+{
+	SimCanBus *Bus = SimCan_ActiveBus(Can);
+	u32 Status = 0;
+	u32 Estat;
+
+	if (!(Can->Srr & XCAN_SRR_CEN_MASK)) {
+		Status |= XCAN_SR_CONFIG_MASK;
+	} else if (Can->Msr & XCAN_MSR_LBACK_MASK) {
+		Status |= XCAN_SR_LBACK_MASK;
+	} else if (Can->Msr & XCAN_MSR_SLEEP_MASK) {
+		Status |= XCAN_SR_SLEEP_MASK;
+	} else {
+		Status |= XCAN_SR_NORMAL_MASK;
+	}
+
+	if (Bus != NULL && Bus->Busy) {
+		Status |= XCAN_SR_BBSY_MASK;
+	} else if (Can->Srr & XCAN_SRR_CEN_MASK) {
+		Status |= XCAN_SR_BIDLE_MASK;
+	}
+
+	if (Can->Tec >= SIM_CAN_WARNING_LIMIT ||
+	    Can->Rec >= SIM_CAN_WARNING_LIMIT) {
+		Status |= XCAN_SR_ERRWRN_MASK;
+	}
+
+	if (Can->Srr & XCAN_SRR_CEN_MASK) {
+		if (Can->BusOff) {
+			Estat = 2;
+		} else if (Can->Tec > SIM_CAN_PASSIVE_LIMIT ||
+			   Can->Rec > SIM_CAN_PASSIVE_LIMIT) {
+			Estat = 3;
+		} else {
+			Estat = 1;
+		}
+		Status |= Estat << XCAN_SR_ESTAT_SHIFT;
+	}
+
+	if (SimCan_FifoFull(&Can->TxFifo)) {
+		Status |= XCAN_SR_TXFLL_MASK;
+	}
+	if (Can->HpbFull) {
+		Status |= XCAN_SR_TXBFLL_MASK;
+	}
+
+	return Status;
+}
+
+static u32 SimCan_ReadRx(SimCan *Can, u32 Offset)
+{
+	SimCanFrame *Frame;
+
+	if (Can->RxFifo.Count == 0U) {
+		Can->Isr |= XCAN_IXR_RXUFLW_MASK;
+		SimCan_UpdateLine(Can);
+		return 0;
+	}
+
+	Frame = SimCan_FifoHead(&Can->RxFifo);
+	switch (Offset) {
+	case XCAN_RXFIFO_ID_OFFSET:
+		return Frame->Id;
+	case XCAN_RXFIFO_DLC_OFFSET:
+		return Frame->Dlc;
+	case XCAN_RXFIFO_DW1_OFFSET:
+		return Frame->Dw1;
+	default:
+		/* Reading the last word releases the FIFO entry */
+		{
+			u32 Dw2 = Frame->Dw2;
+
+			SimCan_FifoPop(&Can->RxFifo);
+			return Dw2;
+		}
+	}
+}
+
+static u32 SimCan_Read(SimDevice *Dev, u32 Offset)
+{
+	SimCan *Can = (SimCan *)Dev->Priv;
+
+	switch (Offset) {
+	case XCAN_SRR_OFFSET:
+		return Can->Srr;
+	case XCAN_MSR_OFFSET:
+		return Can->Msr;
+	case XCAN_BRPR_OFFSET:
+		return Can->Brpr;
+	case XCAN_BTR_OFFSET:
+		return Can->Btr;
+	case XCAN_ECR_OFFSET:
+		return (Can->Rec << XCAN_ECR_REC_SHIFT) | Can->Tec;
+	case XCAN_ESR_OFFSET:
+		return Can->Esr;
+	case XCAN_SR_OFFSET:
+		return SimCan_Status(Can);
+	case XCAN_ISR_OFFSET:
+		return Can->Isr;
+	case XCAN_IER_OFFSET:
+		return Can->Ier;
+	case XCAN_RXFIFO_ID_OFFSET:
+	case XCAN_RXFIFO_DLC_OFFSET:
+	case XCAN_RXFIFO_DW1_OFFSET:
+	case XCAN_RXFIFO_DW2_OFFSET:
+		return SimCan_ReadRx(Can, Offset);
+	case XCAN_AFR_OFFSET:
+		return Can->Afr;
+	default:
+		break;
+	}
+
+	if (Offset >= XCAN_AFMR1_OFFSET && Offset <= XCAN_AFIR4_OFFSET) {
+		u32 Index = (Offset - XCAN_AFMR1_OFFSET) / 8U;
+
+		return ((Offset - XCAN_AFMR1_OFFSET) % 8U) ?
+		       Can->Afir[Index] : Can->Afmr[Index];
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Stages one word of a TX FIFO or HPB write. The frame is committed on the
+* write of its second data word, as on the real core.
+*
+******************************************************************************/
+static void SimCan_WriteTx(SimCan *Can, u32 Offset, u32 Value)
+{
+	int IsHpb = Offset >= XCAN_TXHPB_ID_OFFSET;
+	SimCanFrame *Stage = IsHpb ? &Can->HpbStage : &Can->TxStage;
+
+	switch (Offset & 0xFU) {
+	case 0x0:
+		Stage->Id = Value;
+		return;
+	case 0x4:
+		Stage->Dlc = Value & XCAN_DLCR_DLC_MASK;
+		return;
+	case 0x8:
+		Stage->Dw1 = Value;
+		return;
+	default:
+		Stage->Dw2 = Value;
+		break;
+	}
+
+	if (IsHpb) {
+		if (Can->HpbFull) {
+			return;
+		}
+		Can->Hpb = *Stage;
+		Can->HpbFull = 1;
+		Can->Isr |= XCAN_IXR_TXBFLL_MASK;
+	} else {
+		if (SimCan_FifoFull(&Can->TxFifo)) {
+			return;
+		}
+		SimCan_FifoPush(&Can->TxFifo, Stage);
+		if (SimCan_FifoFull(&Can->TxFifo)) {
+			Can->Isr |= XCAN_IXR_TXFLL_MASK;
+		}
+	}
+	SimCan_UpdateLine(Can);
+	SimCan_KickAll(Can);
+}
+
+static void SimCan_Write(SimDevice *Dev, u32 Offset, u32 Value)
+{
+	SimCan *Can = (SimCan *)Dev->Priv;
+	int Config = !(Can->Srr & XCAN_SRR_CEN_MASK);
+	u32 Index;
+
+	switch (Offset) {
+	case XCAN_SRR_OFFSET:
+		if (Value & XCAN_SRR_SRST_MASK) {
+			SimCan_Reset(Can);
+			return;
+		}
+		if (!Config && !(Value & XCAN_SRR_CEN_MASK)) {
+			/* Entering configuration mode clears the error state */
+			SimCan_AbortTx(Can);
+			Can->Tec = 0;
+			Can->Rec = 0;
+			Can->BusOff = 0;
+		}
+		Can->Srr = Value & XCAN_SRR_CEN_MASK;
+		SimCan_KickAll(Can);
+		return;
+	case XCAN_MSR_OFFSET:
+		if (Config) {
+			Can->Msr = Value & (XCAN_MSR_LBACK_MASK |
+					    XCAN_MSR_SLEEP_MASK);
+		} else {
+			Can->Msr = (Can->Msr & XCAN_MSR_LBACK_MASK) |
+				   (Value & XCAN_MSR_SLEEP_MASK);
+		}
+		SimCan_KickAll(Can);
+		return;
+	case XCAN_BRPR_OFFSET:
+		if (Config) {
+			Can->Brpr = Value & XCAN_BRPR_BRP_MASK;
+		}
+		return;
+	case XCAN_BTR_OFFSET:
+		if (Config) {
+			Can->Btr = Value & (XCAN_BTR_SJW_MASK |
+					    XCAN_BTR_TS2_MASK |
+					    XCAN_BTR_TS1_MASK);
+		}
+		return;
+	case XCAN_ESR_OFFSET:
+		Can->Esr &= ~Value;
+		return;
+	case XCAN_IER_OFFSET:
+		Can->Ier = Value & XCAN_IXR_ALL;
+		SimCan_UpdateLine(Can);
+		return;
+	case XCAN_ICR_OFFSET:
+		Can->Isr &= ~Value;
+		SimCan_UpdateLine(Can);
+		/* Not-empty is raised again while frames remain */
+		if (Can->RxFifo.Count != 0U) {
+			Can->Isr |= XCAN_IXR_RXNEMP_MASK;
+			SimCan_UpdateLine(Can);
+		}
+		return;
+	case XCAN_AFR_OFFSET:
+		Can->Afr = Value & XCAN_AFR_UAF_ALL_MASK;
+		return;
+	default:
+		break;
+	}
+
+	if (Offset >= XCAN_TXFIFO_ID_OFFSET && Offset <= XCAN_TXHPB_DW2_OFFSET) {
+		SimCan_WriteTx(Can, Offset, Value);
+	} else if (Offset >= XCAN_AFMR1_OFFSET && Offset <= XCAN_AFIR4_OFFSET) {
+		Index = (Offset - XCAN_AFMR1_OFFSET) / 8U;
+		if (Can->Afr & (1U << Index)) {
+			return;
+		}
+		if ((Offset - XCAN_AFMR1_OFFSET) % 8U) {
+			Can->Afir[Index] = Value;
+		} else {
+			Can->Afmr[Index] = Value;
+		}
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Controller events: automatic bus-off recovery.
+*
+******************************************************************************/
+static void SimCan_Advance(SimDevice *Dev, SimTime Now)
+{
+	SimCan *Can = (SimCan *)Dev->Priv;
+
+	if (Can->BusOff && Can->RecoverAt <= Now) {
+		Can->BusOff = 0;
+		Can->Tec = 0;
+		Can->Rec = 0;
+		SimCan_KickAll(Can);
+	} else if (Can->BusOff) {
+		Dev->NextEvent = Can->RecoverAt;
+	}
+}
+
+void SimCan_Create(UINTPTR BaseAddress, u32 ClockHz, u32 IntrId, int BusId,
+		   u32 TxDepth, u32 RxDepth)
+{
+	SimCan *Can = &SimCans[SimNumCans++];
+	SimCanBus *Bus = &SimCanBuses[BusId];
+
+	memset(&Can->Dev, 0, sizeof(Can->Dev));
+	Can->ClockHz = ClockHz;
+	Can->IntrId = IntrId;
+	Can->TxFifo.Depth = (TxDepth < SIM_CAN_MAX_DEPTH) ? TxDepth :
+			    SIM_CAN_MAX_DEPTH;
+	Can->RxFifo.Depth = (RxDepth < SIM_CAN_MAX_DEPTH) ? RxDepth :
+			    SIM_CAN_MAX_DEPTH;
+
+	if (Bus->External == NULL) {
+		SimCanBus_Init(Bus, "can-bus", 0);
+	}
+	Bus->Nodes[Bus->NumNodes++] = Can;
+	Can->Bus = Bus;
+
+	SimCanBus_Init(&Can->Loop, "can-loop", 1);
+	Can->Loop.Nodes[Can->Loop.NumNodes++] = Can;
+
+	Can->Dev.Name = "axi-can";
+	Can->Dev.BaseAddress = BaseAddress;
+	Can->Dev.Size = 0x100;
+	Can->Dev.Read = SimCan_Read;
+	Can->Dev.Write = SimCan_Write;
+	Can->Dev.Advance = SimCan_Advance;
+	Can->Dev.Priv = Can;
+	SimDevice_Register(&Can->Dev);
+
+	SimCan_Reset(Can);
+}
+
+static SimCan *SimCan_Find(UINTPTR BaseAddress)
+{
+	SimDevice *Dev = SimDevice_Find(BaseAddress);
+
+	return (Dev != NULL && Dev->Read == SimCan_Read) ?
+	       (SimCan *)Dev->Priv : NULL;
+}
+
+/*****************************************************************************/
+/**
+*
+* Queues a frame sent by an external node on the bus of the controller at
+* BaseAddress. The frame uses the XCan_Send() buffer layout and competes in
+* arbitration from time At onwards.
+*
+******************************************************************************/
+void SimCan_InjectFrame(UINTPTR BaseAddress, SimTime At, const u32 *FramePtr)
+{
+	SimCan *Can = SimCan_Find(BaseAddress);
+	SimCanExtFrame Ext;
+	std::deque<SimCanExtFrame>::iterator Pos;
+
+	if (Can == NULL) {
+		return;
+	}
+
+	Ext.At = At;
+	Ext.Frame.Id = FramePtr[0];
+	Ext.Frame.Dlc = FramePtr[1] & XCAN_DLCR_DLC_MASK;
+	Ext.Frame.Dw1 = Xil_Htonl(FramePtr[2]);
+	Ext.Frame.Dw2 = Xil_Htonl(FramePtr[3]);
+
+	SimLock();
+	Pos = Can->Bus->External->end();
+	while (Pos != Can->Bus->External->begin() && (Pos - 1)->At > At) {
+		--Pos;
+	}
+	Can->Bus->External->insert(Pos, Ext);
+	if (!Can->Bus->Busy && At < Can->Bus->Dev.NextEvent) {
+		Can->Bus->Dev.NextEvent = At;
+	}
+	SimUnlock();
+}
+
+void SimCan_SetAck(UINTPTR BaseAddress, int Enable)
+{
+	SimCan *Can = SimCan_Find(BaseAddress);
+
+	if (Can != NULL) {
+		Can->Bus->Ack = Enable;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Calls Handler with every frame acknowledged on the bus of the controller
+* at BaseAddress, sent by a controller or injected, at the end of the
+* frame. The handler runs in the simulator and must not access
+* peripherals. NULL removes it.
+*
+******************************************************************************/
+void SimCan_SetMonitor(UINTPTR BaseAddress, SimCanMonitor Handler,
+		       void *CallBackRef)
+{
+	SimCan *Can = SimCan_Find(BaseAddress);
+
+	if (Can != NULL) {
+		SimLock();
+		Can->Bus->Monitor = Handler;
+		Can->Bus->MonitorRef = CallBackRef;
+		SimUnlock();
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Fails every frame the controller at BaseAddress starts transmitting from
+* time From until time Until, setting ErrorMask (XCAN_ESR_*_MASK) in its
+* ESR. A new window replaces the previous one.
+*
+******************************************************************************/
+void SimCan_InjectFault(UINTPTR BaseAddress, SimTime From, SimTime Until,
+			u32 ErrorMask)
+{
+	SimCan *Can = SimCan_Find(BaseAddress);
+
+	if (Can != NULL) {
+		SimLock();
+		Can->FaultFrom = From;
+		Can->FaultUntil = Until;
+		Can->FaultEsr = ErrorMask & XCAN_ESR_ALL_MASK;
+		SimUnlock();
+	}
+}
+
+void SimCan_GetStats(UINTPTR BaseAddress, SimCanStats *StatsPtr)
+{
+	SimCan *Can = SimCan_Find(BaseAddress);
+
+	SimLock();
+	if (Can != NULL) {
+		*StatsPtr = Can->Stats;
+	} else {
+		memset(StatsPtr, 0, sizeof(*StatsPtr));
+	}
+	SimUnlock();
+}
+
+void SimCan_Report(FILE *Out)
+{
+	int Index;
+
+	for (Index = 0; Index < SimNumCans; Index++) {
+		SimCan *Can = &SimCans[Index];
+
+		fprintf(Out, "hostsim: can%d: tx %llu, rx %llu, rx overflow "
+			"%llu, filtered %llu, arb lost %llu, rx fifo peak %u, "
+			"tx errors %llu, bus-off %llu\n",
+			Index, (unsigned long long)Can->Stats.TxFrames,
+			(unsigned long long)Can->Stats.RxFrames,
+			(unsigned long long)Can->Stats.RxOverflows,
+			(unsigned long long)Can->Stats.RxFiltered,
+			(unsigned long long)Can->Stats.ArbitrationLost,
+			Can->Stats.RxFifoPeak,
+			(unsigned long long)Can->Stats.TxErrors,
+			(unsigned long long)Can->Stats.BusOffs);
+	}
+	for (Index = 0; Index < SIM_CAN_NUM_BUSES; Index++) {
+		SimCanBus *Bus = &SimCanBuses[Index];
+
+		if (Bus->External == NULL || SimTimeNow == 0) {
+			continue;
+		}
+		fprintf(Out, "hostsim: can bus %d: %llu frames, load %.1f%%\n",
+			Index, (unsigned long long)Bus->Frames,
+			100.0 * (double)Bus->BusyTime / (double)SimTimeNow);
+	}
+}
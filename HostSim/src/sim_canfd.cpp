@@ -0,0 +1,788 @@
+/******************************************************************************
+* AXI CAN FD (PG223) controller and CAN FD bus model
+*
+* Each controller has NumTxBuffers TX buffers, sent once their bit of the
+* TX Ready Request Register (TRR) is set, and RX FIFO 0, read in sequence
+* through the FIFO status register. Buffers and FIFO elements hold frames
+* in register format: ID, DLC, then up to 16 data words with data byte 0 in
+* bits 31:24 of the first. In normal mode the controllers share a CAN FD
+* bus of their own, on which an external node acknowledges every frame; in
+* loopback mode a controller transmits on a private bus that only it
+* listens to. The bus has no faults, so the error registers stay clear.
+*
+* Among the ready buffers of a controller the lowest identifier register
+* value goes first, of equal ones the buffer requested first; the bus then
+* arbitrates between the controllers the same way.
+*
+* A classic frame occupies the bus for the same time as on the AXI CAN
+* model. A CAN FD frame takes the nominal bit time of BRPR/BTR from SOF to
+* its BRS bit and from the CRC delimiter on, and with BRS set the data bit
+* time of F_BRPR/F_BTR in between: ESI, DLC, data, the stuff count and
+* the CRC with their fixed stuff bits. Dynamic stuff bits count in the
+* phase they fall in.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <string.h>
+
+#include "hostsim_internal.h"
+#include "xcanfd_l.h"
+
+/************************** Constant Definitions *****************************/
+
+#define SIM_CANFD_NUM_INSTANCES	1
+#define SIM_CANFD_MAX_NODES	4
+#define SIM_CANFD_MAX_TX	32
+#define SIM_CANFD_MAX_DEPTH	64
+#define SIM_CANFD_FRAME_WORDS	18
+
+/* Register window: up to the end of a 64-element RX FIFO 0 */
+#define SIM_CANFD_SIZE		(XCANFD_RXFIFO_0_BASE_ID_OFFSET + \
+				 SIM_CANFD_MAX_DEPTH * \
+				 XCANFD_MAX_FRAME_SIZE_IN_BYTES)
+
+/*
+ * Stuff count, CRC and their fixed stuff bits, one ahead of the stuff
+ * count and one after every 4 bits: CRC-17 up to 16 data bytes, CRC-21
+ * above
+ */
+#define SIM_CANFD_CRC17_BITS	(4U + 17U + 6U)
+#define SIM_CANFD_CRC21_BITS	(4U + 21U + 7U)
+
+/* CRC delimiter, ACK slot and delimiter, EOF, interframe space */
+#define SIM_CANFD_TAIL_BITS	(1U + 2U + 7U + 3U)
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 Word[SIM_CANFD_FRAME_WORDS];	/* ID, DLC, DW0..DW15 */
+} SimCanFdFrame;
+
+typedef struct SimCanFd SimCanFd;
+
+typedef struct {
+	SimDevice Dev;
+	SimCanFd *Nodes[SIM_CANFD_MAX_NODES];
+	int NumNodes;
+	int IsLoopback;
+
+	int Busy;
+	int Aborted;
+	SimCanFdFrame Cur;
+	SimCanFd *Sender;
+	u32 Buffer;
+	SimTime Start;
+	SimTime End;
+
+	u64 Frames;
+	SimTime BusyTime;
+} SimCanFdBus;
+
+struct SimCanFd {
+	SimDevice Dev;
+	u32 ClockHz;
+	u32 IntrId;
+	u32 NumTx;
+
+	u32 Srr;
+	u32 Msr;
+	u32 Brpr;
+	u32 Btr;
+	u32 FBrpr;
+	u32 FBtr;
+	u32 Esr;
+	u32 Isr;
+	u32 Ier;
+	u32 Trr;
+
+	SimCanFdFrame Tx[SIM_CANFD_MAX_TX];
+	u32 TxSeq[SIM_CANFD_MAX_TX];	/* Order of the ready requests */
+	u32 NextSeq;
+
+	SimCanFdFrame Rx[SIM_CANFD_MAX_DEPTH];
+	u32 RxHead;
+	u32 RxCount;
+	u32 RxDepth;
+
+	SimCanFdBus *Bus;
+	SimCanFdBus Loop;
+
+	SimCanStats Stats;
+};
+
+/************************** Variable Definitions *****************************/
+
+static SimCanFd SimCanFds[SIM_CANFD_NUM_INSTANCES];
+static int SimNumCanFds;
+static SimCanFdBus SimCanFdBusShared;
+
+static const u8 SimCanFd_DlcLength[16] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64
+};
+
+/************************** Function Prototypes ******************************/
+
+static void SimCanFdBus_Kick(SimCanFdBus *Bus);
+
+/*****************************************************************************/
+/**
+*
+* Returns the data field length of a frame from its DLC register.
+*
+******************************************************************************/
+static u32 SimCanFd_Length(u32 Dlc)
+{
+	u32 Code = Dlc >> XCANFD_DLCR_DLC_SHIFT;
+
+	if (!(Dlc & XCANFD_DLCR_EDL_MASK) && (Code > 8U)) {
+		return 8U;
+	}
+
+	return SimCanFd_DlcLength[Code];
+}
+
+static void SimCanFd_PushBits(u8 *Bits, u32 *Num, u32 Value, u32 Count)
+{
+	while (Count-- > 0U) {
+		Bits[(*Num)++] = (u8)((Value >> Count) & 1U);
+	}
+}
+
+static SimTime SimCanFd_NominalBit(const SimCanFd *Can)
+{
+	u32 Ts1 = Can->Btr & XCANFD_BTR_TS1_MASK;
+	u32 Ts2 = (Can->Btr & XCANFD_BTR_TS2_MASK) >> XCANFD_BTR_TS2_SHIFT;
+
+	return SimCyclesToTime((u64)(Can->Brpr + 1U) * (3U + Ts1 + Ts2),
+			       Can->ClockHz);
+}
+
+static SimTime SimCanFd_DataBit(const SimCanFd *Can)
+{
+	u32 Ts1 = Can->FBtr & XCANFD_F_BTR_TS1_MASK;
+	u32 Ts2 = (Can->FBtr & XCANFD_F_BTR_TS2_MASK) >>
+		  XCANFD_F_BTR_TS2_SHIFT;
+
+	return SimCyclesToTime((u64)(Can->FBrpr + 1U) * (3U + Ts1 + Ts2),
+			       Can->ClockHz);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the time a frame sent by Can occupies the bus, with its stuff bits
+* and the interframe space.
+*
+******************************************************************************/
+static SimTime SimCanFd_FrameTime(const SimCanFd *Can,
+				  const SimCanFdFrame *Frame)
+{
+	u8 Bits[64 + 8 * 64];
+	u32 Num = 0;
+	u32 Id = Frame->Word[0];
+	u32 Dlc = Frame->Word[1];
+	u32 Length = SimCanFd_Length(Dlc);
+	u32 Switch;
+	u32 NominalBits;
+	u32 DataBits;
+	u32 NominalStuff = 0;
+	u32 DataStuff = 0;
+	u32 Run = 1;
+	u32 Index;
+	u8 Last;
+
+	if (!(Dlc & XCANFD_DLCR_EDL_MASK)) {
+		return SimCanFd_NominalBit(Can) *
+		       SimCan_FrameBits(Id, Dlc, Frame->Word[2],
+					Frame->Word[3]);
+	}
+
+	SimCanFd_PushBits(Bits, &Num, 0, 1);
+	SimCanFd_PushBits(Bits, &Num, Id >> XCANFD_IDR_ID1_SHIFT, 11);
+	if (Id & XCANFD_IDR_IDE_MASK) {
+		SimCanFd_PushBits(Bits, &Num, 3, 2);	/* SRR, IDE */
+		SimCanFd_PushBits(Bits, &Num, Id >> XCANFD_IDR_ID2_SHIFT, 18);
+	} else {
+		SimCanFd_PushBits(Bits, &Num, 0, 1);	/* IDE */
+	}
+	SimCanFd_PushBits(Bits, &Num, 2, 3);		/* RRS, FDF, res */
+	SimCanFd_PushBits(Bits, &Num, (Dlc & XCANFD_DLCR_BRS_MASK) != 0, 1);
+	Switch = Num;
+	SimCanFd_PushBits(Bits, &Num, 0, 1);		/* ESI */
+	SimCanFd_PushBits(Bits, &Num, Dlc >> XCANFD_DLCR_DLC_SHIFT, 4);
+	for (Index = 0; Index < Length; Index++) {
+		SimCanFd_PushBits(Bits, &Num, Frame->Word[2U + Index / 4U] >>
+				  (24U - 8U * (Index % 4U)), 8);
+	}
+
+	Last = Bits[0];
+	for (Index = 1; Index < Num; Index++) {
+		if (Bits[Index] == Last) {
+			Run++;
+		} else {
+			Last = Bits[Index];
+			Run = 1;
+		}
+		if (Run == 5U) {
+			if (Index < Switch) {
+				NominalStuff++;
+			} else {
+				DataStuff++;
+			}
+			Last = (u8)!Last;
+			Run = 1;
+		}
+	}
+
+	NominalBits = Switch + NominalStuff + SIM_CANFD_TAIL_BITS;
+	DataBits = Num - Switch + DataStuff +
+		   ((Length <= 16U) ? SIM_CANFD_CRC17_BITS :
+				      SIM_CANFD_CRC21_BITS);
+
+	if (!(Dlc & XCANFD_DLCR_BRS_MASK)) {
+		return SimCanFd_NominalBit(Can) * (NominalBits + DataBits);
+	}
+
+	return SimCanFd_NominalBit(Can) * NominalBits +
+	       SimCanFd_DataBit(Can) * DataBits;
+}
+
+static void SimCanFd_UpdateLine(SimCanFd *Can)
+{
+	SimGic_SetLine(Can->IntrId,
+		       (Can->Isr & Can->Ier & XCANFD_IXR_ALL) != 0);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the bus the controller currently transmits on and listens to, or
+* NULL in configuration and sleep mode.
+*
+******************************************************************************/
+static SimCanFdBus *SimCanFd_ActiveBus(SimCanFd *Can)
+{
+	if (!(Can->Srr & XCANFD_SRR_CEN_MASK)) {
+		return NULL;
+	}
+	if (Can->Msr & XCANFD_MSR_LBACK_MASK) {
+		return &Can->Loop;
+	}
+	if (Can->Msr & XCANFD_MSR_SLEEP_MASK) {
+		return NULL;
+	}
+	return Can->Bus;
+}
+
+static void SimCanFd_KickAll(SimCanFd *Can)
+{
+	SimCanFdBus_Kick(Can->Bus);
+	SimCanFdBus_Kick(&Can->Loop);
+}
+
+/*****************************************************************************/
+/**
+*
+* Drops the frame this controller has on the wire, if any. Used when the
+* controller leaves the bus in the middle of a transmission.
+*
+******************************************************************************/
+static void SimCanFd_AbortTx(SimCanFd *Can)
+{
+	SimCanFdBus *Buses[2] = { Can->Bus, &Can->Loop };
+	int Index;
+
+	for (Index = 0; Index < 2; Index++) {
+		if (Buses[Index]->Busy && Buses[Index]->Sender == Can) {
+			Buses[Index]->Sender = NULL;
+			Buses[Index]->Aborted = 1;
+		}
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the ready TX buffer the controller sends next, or -1 if none:
+* the lowest ID, of equal IDs the one requested first.
+*
+******************************************************************************/
+static int SimCanFd_NextBuffer(const SimCanFd *Can)
+{
+	int Best = -1;
+	u32 Index;
+
+	for (Index = 0; Index < Can->NumTx; Index++) {
+		if (!(Can->Trr & (1U << Index))) {
+			continue;
+		}
+		if ((Best < 0) ||
+		    (Can->Tx[Index].Word[0] < Can->Tx[Best].Word[0]) ||
+		    ((Can->Tx[Index].Word[0] == Can->Tx[Best].Word[0]) &&
+		     ((s32)(Can->TxSeq[Index] - Can->TxSeq[Best]) < 0))) {
+			Best = (int)Index;
+		}
+	}
+
+	return Best;
+}
+
+/*****************************************************************************/
+/**
+*
+* Stores a frame seen on the bus in RX FIFO 0.
+*
+******************************************************************************/
+static void SimCanFd_Receive(SimCanFd *Can, const SimCanFdFrame *Frame)
+{
+	if (Can->RxCount == Can->RxDepth) {
+		Can->Isr |= XCANFD_IXR_RXFOFLW_MASK;
+		Can->Stats.RxOverflows++;
+	} else {
+		Can->Rx[(Can->RxHead + Can->RxCount) % Can->RxDepth] = *Frame;
+		Can->RxCount++;
+		Can->Isr |= XCANFD_IXR_RXOK_MASK;
+		Can->Stats.RxFrames++;
+		if (Can->RxCount > Can->Stats.RxFifoPeak) {
+			Can->Stats.RxFifoPeak = Can->RxCount;
+		}
+	}
+	SimCanFd_UpdateLine(Can);
+}
+
+/*****************************************************************************/
+/**
+*
+* Starts the next frame on an idle bus: arbitration between the next ready
+* buffers of all attached controllers.
+*
+******************************************************************************/
+static void SimCanFdBus_Kick(SimCanFdBus *Bus)
+{
+	SimCanFd *Contender[SIM_CANFD_MAX_NODES];
+	int Buffer[SIM_CANFD_MAX_NODES];
+	int NumContenders = 0;
+	int Winner = -1;
+	int Index;
+
+	if (Bus->Busy) {
+		return;
+	}
+
+	for (Index = 0; Index < Bus->NumNodes; Index++) {
+		SimCanFd *Can = Bus->Nodes[Index];
+		int Next;
+
+		if (SimCanFd_ActiveBus(Can) != Bus) {
+			continue;
+		}
+		Next = SimCanFd_NextBuffer(Can);
+		if (Next < 0) {
+			continue;
+		}
+		Contender[NumContenders] = Can;
+		Buffer[NumContenders] = Next;
+		if ((Winner < 0) || (Can->Tx[Next].Word[0] <
+				     Contender[Winner]->Tx[Buffer[Winner]].
+				     Word[0])) {
+			Winner = NumContenders;
+		}
+		NumContenders++;
+	}
+
+	if (Winner < 0) {
+		Bus->Dev.NextEvent = SIM_TIME_NEVER;
+		return;
+	}
+
+	for (Index = 0; Index < NumContenders; Index++) {
+		if (Index != Winner) {
+			Contender[Index]->Isr |= XCANFD_IXR_ARBLST_MASK;
+			Contender[Index]->Stats.ArbitrationLost++;
+			SimCanFd_UpdateLine(Contender[Index]);
+		}
+	}
+
+	Bus->Sender = Contender[Winner];
+	Bus->Buffer = (u32)Buffer[Winner];
+	Bus->Cur = Bus->Sender->Tx[Bus->Buffer];
+	if (Bus->Sender->Msr & XCANFD_MSR_BRSD_MASK) {
+		Bus->Cur.Word[1] &= ~XCANFD_DLCR_BRS_MASK;
+	}
+	Bus->Aborted = 0;
+	Bus->Busy = 1;
+	Bus->Start = SimTimeNow;
+	Bus->End = SimTimeNow + SimCanFd_FrameTime(Bus->Sender, &Bus->Cur);
+	Bus->Dev.NextEvent = Bus->End;
+}
+
+/*****************************************************************************/
+/**
+*
+* Completes the frame on the wire: TX completion on the sender and
+* reception on every other listening node.
+*
+******************************************************************************/
+static void SimCanFdBus_Complete(SimCanFdBus *Bus)
+{
+	SimCanFd *Sender = Bus->Sender;
+	int Index;
+
+	Bus->Busy = 0;
+	Bus->Frames++;
+	Bus->BusyTime += Bus->End - Bus->Start;
+	if (Bus->Aborted) {
+		return;
+	}
+
+	Sender->Trr &= ~(1U << Bus->Buffer);
+	Sender->Isr |= XCANFD_IXR_TXOK_MASK;
+	Sender->Stats.TxFrames++;
+	SimCanFd_UpdateLine(Sender);
+
+	for (Index = 0; Index < Bus->NumNodes; Index++) {
+		SimCanFd *Can = Bus->Nodes[Index];
+
+		if ((Can != Sender || Bus->IsLoopback) &&
+		    SimCanFd_ActiveBus(Can) == Bus) {
+			SimCanFd_Receive(Can, &Bus->Cur);
+		}
+	}
+}
+
+static void SimCanFdBus_Advance(SimDevice *Dev, SimTime Now)
+{
+	SimCanFdBus *Bus = (SimCanFdBus *)Dev->Priv;
+
+	if (Bus->Busy && Bus->End <= Now) {
+		SimCanFdBus_Complete(Bus);
+	}
+	SimCanFdBus_Kick(Bus);
+}
+
+static void SimCanFdBus_Init(SimCanFdBus *Bus, const char *Name,
+			     int IsLoopback)
+{
+	Bus->Dev.Name = Name;
+	Bus->Dev.Advance = SimCanFdBus_Advance;
+	Bus->Dev.Priv = Bus;
+	Bus->IsLoopback = IsLoopback;
+	SimDevice_Register(&Bus->Dev);
+}
+
+/*****************************************************************************/
+/**
+*
+* Puts the controller back into its reset state.
+*
+******************************************************************************/
+static void SimCanFd_Reset(SimCanFd *Can)
+{
+	SimCanFd_AbortTx(Can);
+	Can->Srr = 0;
+	Can->Msr = 0;
+	Can->Brpr = 0;
+	Can->Btr = 0;
+	Can->FBrpr = 0;
+	Can->FBtr = 0;
+	Can->Esr = 0;
+	Can->Isr = 0;
+	Can->Ier = 0;
+	Can->Trr = 0;
+	Can->RxHead = 0;
+	Can->RxCount = 0;
+	SimCanFd_UpdateLine(Can);
+}
+
+static u32 SimCanFd_Status(SimCanFd *Can)
+{
+	SimCanFdBus *Bus = SimCanFd_ActiveBus(Can);
+	u32 Status = 0;
+
+	if (!(Can->Srr & XCANFD_SRR_CEN_MASK)) {
+		return XCANFD_SR_CONFIG_MASK;
+	}
+
+	if (Can->Msr & XCANFD_MSR_LBACK_MASK) {
+		Status |= XCANFD_SR_LBACK_MASK;
+	} else if (Can->Msr & XCANFD_MSR_SLEEP_MASK) {
+		Status |= XCANFD_SR_SLEEP_MASK;
+	} else {
+		Status |= XCANFD_SR_NORMAL_MASK;
+	}
+
+	if (Bus != NULL && Bus->Busy) {
+		Status |= XCANFD_SR_BBSY_MASK;
+	} else {
+		Status |= XCANFD_SR_BIDLE_MASK;
+	}
+
+	/* Always error active */
+	return Status | (1U << XCANFD_SR_ESTAT_SHIFT);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the register word at Offset within the TX buffers or RX FIFO 0
+* elements starting at Base, or NULL past the last one.
+*
+******************************************************************************/
+static u32 *SimCanFd_FrameWord(SimCanFdFrame *Frames, u32 Count, u32 Base,
+			       u32 Offset)
+{
+	u32 Index = (Offset - Base) / XCANFD_MAX_FRAME_SIZE_IN_BYTES;
+	u32 Word = ((Offset - Base) % XCANFD_MAX_FRAME_SIZE_IN_BYTES) / 4U;
+
+	if (Offset < Base || Index >= Count) {
+		return NULL;
+	}
+
+	return &Frames[Index].Word[Word];
+}
+
+static u32 SimCanFd_Read(SimDevice *Dev, u32 Offset)
+{
+	SimCanFd *Can = (SimCanFd *)Dev->Priv;
+	u32 *WordPtr;
+
+	switch (Offset) {
+	case XCANFD_SRR_OFFSET:
+		return Can->Srr;
+	case XCANFD_MSR_OFFSET:
+		return Can->Msr;
+	case XCANFD_BRPR_OFFSET:
+		return Can->Brpr;
+	case XCANFD_BTR_OFFSET:
+		return Can->Btr;
+	case XCANFD_ECR_OFFSET:
+		return 0;
+	case XCANFD_ESR_OFFSET:
+		return Can->Esr;
+	case XCANFD_SR_OFFSET:
+		return SimCanFd_Status(Can);
+	case XCANFD_ISR_OFFSET:
+		return Can->Isr;
+	case XCANFD_IER_OFFSET:
+		return Can->Ier;
+	case XCANFD_F_BRPR_OFFSET:
+		return Can->FBrpr;
+	case XCANFD_F_BTR_OFFSET:
+		return Can->FBtr;
+	case XCANFD_TRR_OFFSET:
+		return Can->Trr;
+	case XCANFD_FSR_OFFSET:
+		return (Can->RxCount << XCANFD_FSR_FL_SHIFT) | Can->RxHead;
+	default:
+		break;
+	}
+
+	if (Offset >= XCANFD_RXFIFO_0_BASE_ID_OFFSET) {
+		WordPtr = SimCanFd_FrameWord(Can->Rx, Can->RxDepth,
+					     XCANFD_RXFIFO_0_BASE_ID_OFFSET,
+					     Offset);
+	} else {
+		WordPtr = SimCanFd_FrameWord(Can->Tx, Can->NumTx,
+					     XCANFD_TXFIFO_0_BASE_ID_OFFSET,
+					     Offset);
+	}
+
+	return (WordPtr != NULL) ? *WordPtr : 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets ready requests: each new one is numbered, for the order among
+* buffers of equal ID.
+*
+******************************************************************************/
+static void SimCanFd_Request(SimCanFd *Can, u32 Mask)
+{
+	u32 Index;
+
+	Mask &= (Can->NumTx == 32U) ? ~0U : ((1U << Can->NumTx) - 1U);
+	for (Index = 0; Index < Can->NumTx; Index++) {
+		if ((Mask & ~Can->Trr) & (1U << Index)) {
+			Can->TxSeq[Index] = Can->NextSeq++;
+		}
+	}
+	Can->Trr |= Mask;
+	SimCanFd_KickAll(Can);
+}
+
+static void SimCanFd_Write(SimDevice *Dev, u32 Offset, u32 Value)
+{
+	SimCanFd *Can = (SimCanFd *)Dev->Priv;
+	int Config = !(Can->Srr & XCANFD_SRR_CEN_MASK);
+	u32 *WordPtr;
+
+	switch (Offset) {
+	case XCANFD_SRR_OFFSET:
+		if (Value & XCANFD_SRR_SRST_MASK) {
+			SimCanFd_Reset(Can);
+			return;
+		}
+		if (!Config && !(Value & XCANFD_SRR_CEN_MASK)) {
+			SimCanFd_AbortTx(Can);
+		}
+		Can->Srr = Value & XCANFD_SRR_CEN_MASK;
+		SimCanFd_KickAll(Can);
+		return;
+	case XCANFD_MSR_OFFSET:
+		if (Config) {
+			Can->Msr = Value & (XCANFD_MSR_LBACK_MASK |
+					    XCANFD_MSR_SLEEP_MASK |
+					    XCANFD_MSR_BRSD_MASK);
+		} else {
+			Can->Msr = (Can->Msr & (XCANFD_MSR_LBACK_MASK |
+						XCANFD_MSR_BRSD_MASK)) |
+				   (Value & XCANFD_MSR_SLEEP_MASK);
+		}
+		SimCanFd_KickAll(Can);
+		return;
+	case XCANFD_BRPR_OFFSET:
+		if (Config) {
+			Can->Brpr = Value & XCANFD_BRPR_BRP_MASK;
+		}
+		return;
+	case XCANFD_BTR_OFFSET:
+		if (Config) {
+			Can->Btr = Value & (XCANFD_BTR_SJW_MASK |
+					    XCANFD_BTR_TS2_MASK |
+					    XCANFD_BTR_TS1_MASK);
+		}
+		return;
+	case XCANFD_F_BRPR_OFFSET:
+		if (Config) {
+			Can->FBrpr = Value & XCANFD_BRPR_BRP_MASK;
+		}
+		return;
+	case XCANFD_F_BTR_OFFSET:
+		if (Config) {
+			Can->FBtr = Value & (XCANFD_F_BTR_SJW_MASK |
+					     XCANFD_F_BTR_TS2_MASK |
+					     XCANFD_F_BTR_TS1_MASK);
+		}
+		return;
+	case XCANFD_ESR_OFFSET:
+		Can->Esr &= ~Value;
+		return;
+	case XCANFD_IER_OFFSET:
+		Can->Ier = Value & XCANFD_IXR_ALL;
+		SimCanFd_UpdateLine(Can);
+		return;
+	case XCANFD_ICR_OFFSET:
+		Can->Isr &= ~Value;
+		SimCanFd_UpdateLine(Can);
+		return;
+	case XCANFD_TRR_OFFSET:
+		SimCanFd_Request(Can, Value);
+		return;
+	case XCANFD_FSR_OFFSET:
+		if ((Value & XCANFD_FSR_IRI_MASK) && (Can->RxCount != 0U)) {
+			Can->RxHead = (Can->RxHead + 1U) % Can->RxDepth;
+			Can->RxCount--;
+		}
+		return;
+	default:
+		break;
+	}
+
+	if (Offset < XCANFD_RXFIFO_0_BASE_ID_OFFSET) {
+		WordPtr = SimCanFd_FrameWord(Can->Tx, Can->NumTx,
+					     XCANFD_TXFIFO_0_BASE_ID_OFFSET,
+					     Offset);
+		if (WordPtr != NULL) {
+			*WordPtr = Value;
+		}
+	}
+}
+
+void SimCanFd_Create(UINTPTR BaseAddress, u32 ClockHz, u32 IntrId,
+		     u32 NumTxBuffers, u32 RxDepth)
+{
+	SimCanFd *Can = &SimCanFds[SimNumCanFds++];
+	SimCanFdBus *Bus = &SimCanFdBusShared;
+
+	memset(&Can->Dev, 0, sizeof(Can->Dev));
+	Can->ClockHz = ClockHz;
+	Can->IntrId = IntrId;
+	Can->NumTx = (NumTxBuffers < SIM_CANFD_MAX_TX) ? NumTxBuffers :
+		     SIM_CANFD_MAX_TX;
+	Can->RxDepth = (RxDepth < SIM_CANFD_MAX_DEPTH) ? RxDepth :
+		       SIM_CANFD_MAX_DEPTH;
+
+	if (Bus->Dev.Advance == NULL) {
+		SimCanFdBus_Init(Bus, "canfd-bus", 0);
+	}
+	Bus->Nodes[Bus->NumNodes++] = Can;
+	Can->Bus = Bus;
+
+	SimCanFdBus_Init(&Can->Loop, "canfd-loop", 1);
+	Can->Loop.Nodes[Can->Loop.NumNodes++] = Can;
+
+	/* No events of its own: the buses carry the frames */
+	Can->Dev.Name = "axi-canfd";
+	Can->Dev.BaseAddress = BaseAddress;
+	Can->Dev.Size = SIM_CANFD_SIZE;
+	Can->Dev.Read = SimCanFd_Read;
+	Can->Dev.Write = SimCanFd_Write;
+	Can->Dev.Priv = Can;
+	SimDevice_Register(&Can->Dev);
+
+	SimCanFd_Reset(Can);
+}
+
+static SimCanFd *SimCanFd_Find(UINTPTR BaseAddress)
+{
+	SimDevice *Dev = SimDevice_Find(BaseAddress);
+
+	return (Dev != NULL && Dev->Read == SimCanFd_Read) ?
+	       (SimCanFd *)Dev->Priv : NULL;
+}
+
+void SimCanFd_GetStats(UINTPTR BaseAddress, SimCanStats *StatsPtr)
+{
+	SimCanFd *Can = SimCanFd_Find(BaseAddress);
+
+	SimLock();
+	if (Can != NULL) {
+		*StatsPtr = Can->Stats;
+	} else {
+		memset(StatsPtr, 0, sizeof(*StatsPtr));
+	}
+	SimUnlock();
+}
+
+void SimCanFd_Report(FILE *Out)
+{
+	SimCanFdBus *Bus;
+	int Index;
+
+	for (Index = 0; Index < SimNumCanFds; Index++) {
+		SimCanFd *Can = &SimCanFds[Index];
+
+		fprintf(Out, "hostsim: canfd%d: tx %llu, rx %llu, rx overflow "
+			"%llu, arb lost %llu, rx fifo peak %u\n",
+			Index, (unsigned long long)Can->Stats.TxFrames,
+			(unsigned long long)Can->Stats.RxFrames,
+			(unsigned long long)Can->Stats.RxOverflows,
+			(unsigned long long)Can->Stats.ArbitrationLost,
+			Can->Stats.RxFifoPeak);
+	}
+	for (Index = -1; Index < SimNumCanFds; Index++) {
+		Bus = (Index < 0) ? &SimCanFdBusShared : &SimCanFds[Index].Loop;
+		if (Bus->Frames == 0U || SimTimeNow == 0) {
+			continue;
+		}
+		fprintf(Out, "hostsim: %s", Bus->Dev.Name);
+		if (Index >= 0) {
+			fprintf(Out, " %d", Index);
+		}
+		fprintf(Out, ": %llu frames, load %.1f%%\n",
+			(unsigned long long)Bus->Frames,
+			100.0 * (double)Bus->BusyTime / (double)SimTimeNow);
+	}
+}
@@ -0,0 +1,461 @@
+/******************************************************************************
+* ARM GIC (PL390) model
+*
+* Models the distributor and the CPU interface of the Zynq SCUGIC for a
+* single CPU. Shared peripheral interrupts are either level sensitive, in
+* which case the pending state follows the input line, or rising edge
+* triggered, in which case an edge latches the pending state until it is
+* acknowledged. Acknowledge-to-EOI is tracked with an active priority stack
+* so that preemption follows the usual running priority rules.
+*
+* For every interrupt ID the model records how long it stayed pending
+* before the CPU acknowledged it through ICCIAR.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <string.h>
+
+#include "hostsim_internal.h"
+#include "xscugic_hw.h"
+
+/************************** Constant Definitions *****************************/
+
+#define SIM_GIC_NUM_INTR	96
+#define SIM_GIC_IDLE_PRIORITY	0x100U
+#define SIM_GIC_EDGE_MASK	0x2U
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	SimDevice Cpu;
+	SimDevice Dist;
+
+	u32 DistCtrl;
+	u32 CpuCtrl;
+	u32 PriorityMask;
+	u32 BinaryPoint;
+
+	u8 Priority[SIM_GIC_NUM_INTR];
+	u8 Config[SIM_GIC_NUM_INTR];
+	u8 Target[SIM_GIC_NUM_INTR];
+	u8 Enabled[SIM_GIC_NUM_INTR];
+	u8 Line[SIM_GIC_NUM_INTR];
+	u8 Latched[SIM_GIC_NUM_INTR];
+	u8 Active[SIM_GIC_NUM_INTR];
+
+	u32 ActiveStack[SIM_GIC_NUM_INTR];
+	int NumActive;
+
+	SimTime AssertTime[SIM_GIC_NUM_INTR];
+	SimIrqStats Stats[SIM_GIC_NUM_INTR];
+} SimGic;
+
+/************************** Variable Definitions *****************************/
+
+static SimGic Gic;
+
+/*****************************************************************************/
+/**
+*
+* Returns non-zero if the interrupt is in the pending state.
+*
+******************************************************************************/
+static int SimGic_IsPending(u32 IntrId)
+{
+	if (Gic.Config[IntrId] & SIM_GIC_EDGE_MASK) {
+		return Gic.Latched[IntrId];
+	}
+	return Gic.Line[IntrId] || Gic.Latched[IntrId];
+}
+
+static u32 SimGic_RunningPriority(void)
+{
+	if (Gic.NumActive == 0) {
+		return SIM_GIC_IDLE_PRIORITY;
+	}
+	return Gic.Priority[Gic.ActiveStack[Gic.NumActive - 1]];
+}
+
+/*****************************************************************************/
+/**
+*
+* Finds the highest priority pending interrupt that may be signalled to the
+* CPU, or XSCUGIC_SPURIOUS_INTR_ID if there is none.
+*
+******************************************************************************/
+static u32 SimGic_HighestPending(void)
+{
+	u32 Best = XSCUGIC_SPURIOUS_INTR_ID;
+	u32 BestPriority = SIM_GIC_IDLE_PRIORITY;
+	u32 Running = SimGic_RunningPriority();
+	u32 IntrId;
+
+	if (!(Gic.DistCtrl & XSCUGIC_EN_INT_MASK) ||
+	    !(Gic.CpuCtrl & XSCUGIC_CNTR_EN_S_MASK)) {
+		return XSCUGIC_SPURIOUS_INTR_ID;
+	}
+
+	for (IntrId = 0; IntrId < SIM_GIC_NUM_INTR; IntrId++) {
+		u32 Priority = Gic.Priority[IntrId];
+
+		if (Gic.Enabled[IntrId] && !Gic.Active[IntrId] &&
+		    SimGic_IsPending(IntrId) && Priority < BestPriority &&
+		    Priority < Gic.PriorityMask && Priority < Running) {
+			Best = IntrId;
+			BestPriority = Priority;
+		}
+	}
+
+	return Best;
+}
+
+int SimGic_Signaled(void)
+{
+	return SimGic_HighestPending() != XSCUGIC_SPURIOUS_INTR_ID;
+}
+
+/*****************************************************************************/
+/**
+*
+* Drives the interrupt input line of IntrId from a peripheral model.
+*
+******************************************************************************/
+void SimGic_SetLine(u32 IntrId, int Level)
+{
+	Level = (Level != 0);
+	if (IntrId >= SIM_GIC_NUM_INTR || Gic.Line[IntrId] == Level) {
+		return;
+	}
+
+	Gic.Line[IntrId] = (u8)Level;
+	if (Level) {
+		if (!Gic.Latched[IntrId]) {
+			Gic.AssertTime[IntrId] = SimTimeNow;
+		}
+		if (Gic.Config[IntrId] & SIM_GIC_EDGE_MASK) {
+			Gic.Latched[IntrId] = 1;
+		}
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Interrupt acknowledge: the highest priority pending interrupt becomes
+* active and its pending-to-acknowledge latency is recorded.
+*
+******************************************************************************/
+static u32 SimGic_Acknowledge(void)
+{
+	u32 IntrId = SimGic_HighestPending();
+	SimIrqStats *Stats;
+	SimTime Latency;
+
+	if (IntrId == XSCUGIC_SPURIOUS_INTR_ID) {
+		return IntrId;
+	}
+
+	Gic.Active[IntrId] = 1;
+	Gic.Latched[IntrId] = 0;
+	Gic.ActiveStack[Gic.NumActive++] = IntrId;
+
+	Stats = &Gic.Stats[IntrId];
+	Latency = SimTimeNow - Gic.AssertTime[IntrId];
+	if (Stats->Count == 0 || Latency < Stats->MinLatency) {
+		Stats->MinLatency = Latency;
+	}
+	if (Latency > Stats->MaxLatency) {
+		Stats->MaxLatency = Latency;
+	}
+	Stats->TotalLatency += Latency;
+	Stats->Count++;
+
+	return IntrId;
+}
+
+static void SimGic_EndOfInterrupt(u32 IntrId)
+{
+	int Index;
+
+	if (IntrId >= SIM_GIC_NUM_INTR || !Gic.Active[IntrId]) {
+		return;
+	}
+
+	Gic.Active[IntrId] = 0;
+	for (Index = 0; Index < Gic.NumActive; Index++) {
+		if (Gic.ActiveStack[Index] == IntrId) {
+			memmove(&Gic.ActiveStack[Index],
+				&Gic.ActiveStack[Index + 1],
+				(size_t)(Gic.NumActive - Index - 1) *
+				sizeof(Gic.ActiveStack[0]));
+			Gic.NumActive--;
+			break;
+		}
+	}
+
+	/* A level interrupt still asserted is pending again from now on */
+	if (Gic.Line[IntrId]) {
+		Gic.AssertTime[IntrId] = SimTimeNow;
+	}
+}
+
+static u32 SimGic_CpuRead(SimDevice *Dev, u32 Offset)
+{
+	(void)Dev;
+	switch (Offset) {
+	case XSCUGIC_CONTROL_OFFSET:
+		return Gic.CpuCtrl;
+	case XSCUGIC_CPU_PRIOR_OFFSET:
+		return Gic.PriorityMask;
+	case XSCUGIC_BIN_PT_OFFSET:
+		return Gic.BinaryPoint;
+	case XSCUGIC_INT_ACK_OFFSET:
+		return SimGic_Acknowledge();
+	case XSCUGIC_RUN_PRIOR_OFFSET:
+		return SimGic_RunningPriority() & XSCUGIC_PRIORITY_MASK;
+	case XSCUGIC_HI_PEND_OFFSET:
+		return SimGic_HighestPending();
+	default:
+		return 0;
+	}
+}
+
+static void SimGic_CpuWrite(SimDevice *Dev, u32 Offset, u32 Value)
+{
+	(void)Dev;
+	switch (Offset) {
+	case XSCUGIC_CONTROL_OFFSET:
+		Gic.CpuCtrl = Value & 0x1FU;
+		break;
+	case XSCUGIC_CPU_PRIOR_OFFSET:
+		Gic.PriorityMask = Value & XSCUGIC_PRIORITY_MASK;
+		break;
+	case XSCUGIC_BIN_PT_OFFSET:
+		Gic.BinaryPoint = Value & 0x7U;
+		break;
+	case XSCUGIC_EOI_OFFSET:
+		SimGic_EndOfInterrupt(Value & XSCUGIC_ACK_INTID_MASK);
+		break;
+	default:
+		break;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads back a one-bit-per-interrupt register bank word.
+*
+******************************************************************************/
+static u32 SimGic_BitWord(const u8 *Bits, u32 Word)
+{
+	u32 Value = 0;
+	u32 Bit;
+
+	for (Bit = 0; Bit < 32U; Bit++) {
+		u32 IntrId = Word * 32U + Bit;
+
+		if (IntrId < SIM_GIC_NUM_INTR && Bits[IntrId]) {
+			Value |= 1U << Bit;
+		}
+	}
+
+	return Value;
+}
+
+static void SimGic_SetBits(u8 *Bits, u32 Word, u32 Value, u8 NewState)
+{
+	u32 Bit;
+
+	for (Bit = 0; Bit < 32U; Bit++) {
+		u32 IntrId = Word * 32U + Bit;
+
+		if ((Value & (1U << Bit)) && IntrId < SIM_GIC_NUM_INTR) {
+			Bits[IntrId] = NewState;
+		}
+	}
+}
+
+static u32 SimGic_DistRead(SimDevice *Dev, u32 Offset)
+{
+	u32 Value = 0;
+	u32 Index;
+
+	(void)Dev;
+	if (Offset == XSCUGIC_DIST_EN_OFFSET) {
+		return Gic.DistCtrl;
+	}
+	if (Offset == XSCUGIC_IC_TYPE_OFFSET) {
+		return (SIM_GIC_NUM_INTR / 32U) - 1U;
+	}
+	if (Offset >= XSCUGIC_ENABLE_SET_OFFSET &&
+	    Offset < XSCUGIC_PENDING_SET_OFFSET) {
+		return SimGic_BitWord(Gic.Enabled, (Offset & 0x7FU) / 4U);
+	}
+	if (Offset >= XSCUGIC_PENDING_SET_OFFSET &&
+	    Offset < XSCUGIC_ACTIVE_OFFSET) {
+		u32 Word = (Offset & 0x7FU) / 4U;
+
+		for (Index = 0; Index < 32U; Index++) {
+			u32 IntrId = Word * 32U + Index;
+
+			if (IntrId < SIM_GIC_NUM_INTR &&
+			    SimGic_IsPending(IntrId)) {
+				Value |= 1U << Index;
+			}
+		}
+		return Value;
+	}
+	if (Offset >= XSCUGIC_ACTIVE_OFFSET &&
+	    Offset < XSCUGIC_ACTIVE_OFFSET + 0x80U) {
+		return SimGic_BitWord(Gic.Active, (Offset & 0x7FU) / 4U);
+	}
+	if (Offset >= XSCUGIC_PRIORITY_OFFSET &&
+	    Offset < XSCUGIC_PRIORITY_OFFSET + SIM_GIC_NUM_INTR) {
+		Index = Offset - XSCUGIC_PRIORITY_OFFSET;
+		return (u32)Gic.Priority[Index] |
+		       ((u32)Gic.Priority[Index + 1] << 8) |
+		       ((u32)Gic.Priority[Index + 2] << 16) |
+		       ((u32)Gic.Priority[Index + 3] << 24);
+	}
+	if (Offset >= XSCUGIC_SPI_TARGET_OFFSET &&
+	    Offset < XSCUGIC_SPI_TARGET_OFFSET + SIM_GIC_NUM_INTR) {
+		Index = Offset - XSCUGIC_SPI_TARGET_OFFSET;
+		return (u32)Gic.Target[Index] |
+		       ((u32)Gic.Target[Index + 1] << 8) |
+		       ((u32)Gic.Target[Index + 2] << 16) |
+		       ((u32)Gic.Target[Index + 3] << 24);
+	}
+	if (Offset >= XSCUGIC_INT_CFG_OFFSET &&
+	    Offset < XSCUGIC_INT_CFG_OFFSET + SIM_GIC_NUM_INTR / 4U) {
+		Index = (Offset - XSCUGIC_INT_CFG_OFFSET) * 4U;
+		for (u32 Field = 0; Field < 16U; Field++) {
+			Value |= (u32)Gic.Config[Index + Field] << (Field * 2U);
+		}
+		return Value;
+	}
+
+	return 0;
+}
+
+static void SimGic_DistWrite(SimDevice *Dev, u32 Offset, u32 Value)
+{
+	u32 Index;
+
+	(void)Dev;
+	if (Offset == XSCUGIC_DIST_EN_OFFSET) {
+		Gic.DistCtrl = Value & XSCUGIC_EN_INT_MASK;
+	} else if (Offset >= XSCUGIC_ENABLE_SET_OFFSET &&
+		   Offset < XSCUGIC_DISABLE_OFFSET) {
+		SimGic_SetBits(Gic.Enabled, (Offset & 0x7FU) / 4U, Value, 1);
+	} else if (Offset >= XSCUGIC_DISABLE_OFFSET &&
+		   Offset < XSCUGIC_PENDING_SET_OFFSET) {
+		SimGic_SetBits(Gic.Enabled, (Offset & 0x7FU) / 4U, Value, 0);
+	} else if (Offset >= XSCUGIC_PENDING_SET_OFFSET &&
+		   Offset < XSCUGIC_PENDING_CLR_OFFSET) {
+		for (Index = 0; Index < 32U; Index++) {
+			u32 IntrId = ((Offset & 0x7FU) / 4U) * 32U + Index;
+
+			if ((Value & (1U << Index)) &&
+			    IntrId < SIM_GIC_NUM_INTR &&
+			    !Gic.Latched[IntrId]) {
+				Gic.Latched[IntrId] = 1;
+				Gic.AssertTime[IntrId] = SimTimeNow;
+			}
+		}
+	} else if (Offset >= XSCUGIC_PENDING_CLR_OFFSET &&
+		   Offset < XSCUGIC_ACTIVE_OFFSET) {
+		SimGic_SetBits(Gic.Latched, (Offset & 0x7FU) / 4U, Value, 0);
+	} else if (Offset >= XSCUGIC_PRIORITY_OFFSET &&
+		   Offset < XSCUGIC_PRIORITY_OFFSET + SIM_GIC_NUM_INTR) {
+		Index = Offset - XSCUGIC_PRIORITY_OFFSET;
+		for (u32 Byte = 0; Byte < 4U; Byte++) {
+			/* Zynq implements 5 priority bits */
+			Gic.Priority[Index + Byte] =
+				(u8)((Value >> (Byte * 8U)) & 0xF8U);
+		}
+	} else if (Offset >= XSCUGIC_SPI_TARGET_OFFSET &&
+		   Offset < XSCUGIC_SPI_TARGET_OFFSET + SIM_GIC_NUM_INTR) {
+		Index = Offset - XSCUGIC_SPI_TARGET_OFFSET;
+		for (u32 Byte = 0; Byte < 4U; Byte++) {
+			Gic.Target[Index + Byte] = (u8)(Value >> (Byte * 8U));
+		}
+	} else if (Offset >= XSCUGIC_INT_CFG_OFFSET &&
+		   Offset < XSCUGIC_INT_CFG_OFFSET + SIM_GIC_NUM_INTR / 4U) {
+		Index = (Offset - XSCUGIC_INT_CFG_OFFSET) * 4U;
+		for (u32 Field = 0; Field < 16U; Field++) {
+			Gic.Config[Index + Field] =
+				(u8)((Value >> (Field * 2U)) &
+				     XSCUGIC_INT_CFG_MASK);
+		}
+	} else if (Offset == XSCUGIC_SFI_TRIG_OFFSET) {
+		Index = Value & 0xFU;
+		Gic.Latched[Index] = 1;
+		Gic.AssertTime[Index] = SimTimeNow;
+	}
+}
+
+static void SimGic_Advance(SimDevice *Dev, SimTime Now)
+{
+	(void)Dev;
+	(void)Now;
+}
+
+void SimGic_Create(UINTPTR CpuBase, UINTPTR DistBase)
+{
+	u32 IntrId;
+
+	memset(&Gic, 0, sizeof(Gic));
+	for (IntrId = 0; IntrId < SIM_GIC_NUM_INTR; IntrId++) {
+		/* SGIs are always edge triggered */
+		Gic.Config[IntrId] = (IntrId < 16U) ? SIM_GIC_EDGE_MASK : 0U;
+	}
+
+	Gic.Cpu.Name = "scugic-cpu";
+	Gic.Cpu.BaseAddress = CpuBase;
+	Gic.Cpu.Size = 0x100;
+	Gic.Cpu.Read = SimGic_CpuRead;
+	Gic.Cpu.Write = SimGic_CpuWrite;
+	Gic.Cpu.Advance = SimGic_Advance;
+	SimDevice_Register(&Gic.Cpu);
+
+	Gic.Dist.Name = "scugic-dist";
+	Gic.Dist.BaseAddress = DistBase;
+	Gic.Dist.Size = 0x1000;
+	Gic.Dist.Read = SimGic_DistRead;
+	Gic.Dist.Write = SimGic_DistWrite;
+	Gic.Dist.Advance = SimGic_Advance;
+	SimDevice_Register(&Gic.Dist);
+}
+
+void SimIrq_GetStats(u32 IntrId, SimIrqStats *StatsPtr)
+{
+	SimLock();
+	if (IntrId < SIM_GIC_NUM_INTR) {
+		*StatsPtr = Gic.Stats[IntrId];
+	} else {
+		memset(StatsPtr, 0, sizeof(*StatsPtr));
+	}
+	SimUnlock();
+}
+
+void SimGic_Report(FILE *Out)
+{
+	u32 IntrId;
+
+	for (IntrId = 0; IntrId < SIM_GIC_NUM_INTR; IntrId++) {
+		SimIrqStats *Stats = &Gic.Stats[IntrId];
+
+		if (Stats->Count == 0) {
+			continue;
+		}
+		fprintf(Out, "hostsim: irq %2u: %llu taken, latency ns "
+			"min %.0f avg %.0f max %.0f\n", IntrId,
+			(unsigned long long)Stats->Count,
+			(double)Stats->MinLatency / 1e3,
+			(double)Stats->TotalLatency / 1e3 /
+			(double)Stats->Count,
+			(double)Stats->MaxLatency / 1e3);
+	}
+}
@@ -0,0 +1,216 @@
+/******************************************************************************
+* AXI GPIO (PG144) model
+*
+* One or two 32-bit channels. Reading GPIO_DATA returns the pin level for
+* bits configured as inputs in GPIO_TRI and the output register for bits
+* configured as outputs. Input pins are driven either by the test program
+* through SimGpio_SetInput() or by a signal from another model, such as a
+* timer GENERATEOUT pin. Any change on an input bit sets the channel bit in
+* IP_ISR; IP_ISR is toggle-on-write as on the real core.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <string.h>
+
+#include "hostsim_internal.h"
+#include "xgpio_l.h"
+
+/************************** Constant Definitions *****************************/
+
+#define SIM_GPIO_NUM_INSTANCES	2
+#define SIM_GPIO_NUM_CHANNELS	2
+#define SIM_GPIO_MAX_WIRES	8
+
+/**************************** Type Definitions *******************************/
+
+typedef struct SimGpio SimGpio;
+
+typedef struct {
+	SimGpio *Gpio;
+	unsigned Channel;
+	u32 Bit;
+} SimGpioWire;
+
+typedef struct {
+	u32 Data;		/* Output register */
+	u32 Tri;		/* 1 = input */
+	u32 Pins;		/* External pin levels */
+} SimGpioChannel;
+
+struct SimGpio {
+	SimDevice Dev;
+	u32 IntrId;
+	int IsDual;
+	u32 Gier;
+	u32 Ier;
+	u32 Isr;
+	SimGpioChannel Chan[SIM_GPIO_NUM_CHANNELS];
+	SimGpioWire Wires[SIM_GPIO_MAX_WIRES];
+	int NumWires;
+};
+
+/************************** Variable Definitions *****************************/
+
+static SimGpio SimGpios[SIM_GPIO_NUM_INSTANCES];
+static int SimNumGpios;
+
+static void SimGpio_UpdateLine(SimGpio *Gpio)
+{
+	SimGic_SetLine(Gpio->IntrId,
+		       (Gpio->Gier & XGPIO_GIE_GINTR_ENABLE_MASK) &&
+		       (Gpio->Isr & Gpio->Ier));
+}
+
+/*****************************************************************************/
+/**
+*
+* Changes the level of the external pins of a channel.
+*
+******************************************************************************/
+static void SimGpio_DrivePins(SimGpio *Gpio, unsigned Channel, u32 Pins)
+{
+	SimGpioChannel *Chan = &Gpio->Chan[Channel - 1U];
+	u32 Changed = (Chan->Pins ^ Pins) & Chan->Tri;
+
+	Chan->Pins = Pins;
+	if (Changed) {
+		Gpio->Isr |= (Channel == 1U) ? XGPIO_IR_CH1_MASK :
+					       XGPIO_IR_CH2_MASK;
+		SimGpio_UpdateLine(Gpio);
+	}
+}
+
+static void SimGpio_WireSink(void *Ref, int Level)
+{
+	SimGpioWire *Wire = (SimGpioWire *)Ref;
+	u32 Pins = Wire->Gpio->Chan[Wire->Channel - 1U].Pins;
+
+	if (Level) {
+		Pins |= Wire->Bit;
+	} else {
+		Pins &= ~Wire->Bit;
+	}
+	SimGpio_DrivePins(Wire->Gpio, Wire->Channel, Pins);
+}
+
+static u32 SimGpio_Read(SimDevice *Dev, u32 Offset)
+{
+	SimGpio *Gpio = (SimGpio *)Dev->Priv;
+	SimGpioChannel *Chan;
+
+	switch (Offset) {
+	case XGPIO_DATA_OFFSET:
+	case XGPIO_DATA2_OFFSET:
+		Chan = &Gpio->Chan[Offset / XGPIO_CHAN_OFFSET];
+		return (Chan->Pins & Chan->Tri) | (Chan->Data & ~Chan->Tri);
+	case XGPIO_TRI_OFFSET:
+	case XGPIO_TRI2_OFFSET:
+		return Gpio->Chan[Offset / XGPIO_CHAN_OFFSET].Tri;
+	case XGPIO_GIE_OFFSET:
+		return Gpio->Gier;
+	case XGPIO_ISR_OFFSET:
+		return Gpio->Isr;
+	case XGPIO_IER_OFFSET:
+		return Gpio->Ier;
+	default:
+		return 0;
+	}
+}
+
+static void SimGpio_Write(SimDevice *Dev, u32 Offset, u32 Value)
+{
+	SimGpio *Gpio = (SimGpio *)Dev->Priv;
+
+	switch (Offset) {
+	case XGPIO_DATA_OFFSET:
+	case XGPIO_DATA2_OFFSET:
+		Gpio->Chan[Offset / XGPIO_CHAN_OFFSET].Data = Value;
+		break;
+	case XGPIO_TRI_OFFSET:
+	case XGPIO_TRI2_OFFSET:
+		Gpio->Chan[Offset / XGPIO_CHAN_OFFSET].Tri = Value;
+		break;
+	case XGPIO_GIE_OFFSET:
+		Gpio->Gier = Value & XGPIO_GIE_GINTR_ENABLE_MASK;
+		break;
+	case XGPIO_ISR_OFFSET:
+		Gpio->Isr ^= Value & XGPIO_IR_MASK;
+		break;
+	case XGPIO_IER_OFFSET:
+		Gpio->Ier = Value & XGPIO_IR_MASK;
+		break;
+	default:
+		return;
+	}
+
+	SimGpio_UpdateLine(Gpio);
+}
+
+static void SimGpio_Advance(SimDevice *Dev, SimTime Now)
+{
+	(void)Dev;
+	(void)Now;
+}
+
+void SimGpio_Create(UINTPTR BaseAddress, int IsDual, u32 IntrId)
+{
+	SimGpio *Gpio = &SimGpios[SimNumGpios++];
+	int Index;
+
+	memset(Gpio, 0, sizeof(*Gpio));
+	Gpio->IntrId = IntrId;
+	Gpio->IsDual = IsDual;
+	for (Index = 0; Index < SIM_GPIO_NUM_CHANNELS; Index++) {
+		/* All bits are inputs out of reset */
+		Gpio->Chan[Index].Tri = 0xFFFFFFFFU;
+	}
+
+	Gpio->Dev.Name = "axi-gpio";
+	Gpio->Dev.BaseAddress = BaseAddress;
+	Gpio->Dev.Size = 0x200;
+	Gpio->Dev.Read = SimGpio_Read;
+	Gpio->Dev.Write = SimGpio_Write;
+	Gpio->Dev.Advance = SimGpio_Advance;
+	Gpio->Dev.Priv = Gpio;
+	SimDevice_Register(&Gpio->Dev);
+}
+
+void SimGpio_ConnectInput(UINTPTR BaseAddress, unsigned Channel, u32 Bit,
+			  SimSignal *Sig)
+{
+	SimGpio *Gpio = (SimGpio *)SimDevice_Find(BaseAddress)->Priv;
+	SimGpioWire *Wire = &Gpio->Wires[Gpio->NumWires++];
+
+	Wire->Gpio = Gpio;
+	Wire->Channel = Channel;
+	Wire->Bit = Bit;
+	SimSignal_Connect(Sig, SimGpio_WireSink, Wire);
+}
+
+void SimGpio_SetInput(UINTPTR BaseAddress, unsigned Channel, u32 Value)
+{
+	SimDevice *Dev = SimDevice_Find(BaseAddress);
+
+	SimLock();
+	if (Dev != NULL && Channel >= 1U && Channel <= SIM_GPIO_NUM_CHANNELS) {
+		SimGpio_DrivePins((SimGpio *)Dev->Priv, Channel, Value);
+	}
+	SimUnlock();
+}
+
+u32 SimGpio_GetOutput(UINTPTR BaseAddress, unsigned Channel)
+{
+	SimDevice *Dev = SimDevice_Find(BaseAddress);
+	u32 Value = 0;
+
+	SimLock();
+	if (Dev != NULL && Channel >= 1U && Channel <= SIM_GPIO_NUM_CHANNELS) {
+		SimGpioChannel *Chan = &((SimGpio *)Dev->Priv)->Chan[Channel - 1U];
+
+		Value = Chan->Data & ~Chan->Tri;
+	}
+	SimUnlock();
+
+	return Value;
+}
@@ -0,0 +1,465 @@
+/******************************************************************************
+* AXI Timer (PG079) model
+*
+* Two 32-bit timer counters, each with TCSR/TLR/TCR. Counter values are
+* evaluated lazily from the time the counter was last loaded, so a running
+* counter costs nothing until it is read or reaches its terminal count.
+*
+* Generate mode is modelled in both count directions, with and without
+* auto reload: the counter expires when it rolls over past 0xFFFFFFFF
+* (up) or below zero (down), sets TINT and, with GENT set, pulses its
+* GENERATEOUT pin for one timer clock. An auto reload takes one further
+* clock, which gives the (MAX - TLR + 2) and (TLR + 2) periods of the
+* datasheet. Without auto reload the counter holds at its terminal value.
+*
+* Capture mode (MDT) lets the counter run free through its wrap; an
+* asserting edge on the CAPTURETRIG input of a counter with CAPT set
+* latches the counter value into TLR at the exact time of the edge and sets
+* TINT. Without ARHT a capture is held until TINT is cleared and later
+* edges are lost, with ARHT every edge overwrites TLR.
+*
+* PWM mode (PWMA in both counters) drives the PWM0 pin high when counter 0
+* expires and low when counter 1 does. Counter 1 is reloaded from TLR1
+* whenever counter 0 reloads and otherwise holds, so a high time of
+* (TLR1 + 2) clocks starts every (TLR0 + 2) clock period, counting down,
+* and both registers are sampled at the period boundary. A high time
+* longer than the period keeps the pin high.
+*
+* Cascade mode (CASC in TCSR0) joins the counters into one 64-bit counter
+* controlled by TCSR0, counter 0 the low and counter 1 the high word. The
+* pair is evaluated as a single value, so the high word steps on the same
+* clock as the low word wraps, and it never expires within a simulation.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <string.h>
+
+#include "hostsim_internal.h"
+#include "xtmrctr_l.h"
+
+/************************** Constant Definitions *****************************/
+
+#define SIM_TMR_NUM_INSTANCES	3
+
+/**************************** Type Definitions *******************************/
+
+typedef struct SimTmrCtr SimTmrCtr;
+
+typedef struct {
+	SimTmrCtr *Tmr;
+	u32 Tcsr;
+	u32 Tlr;
+	u32 Base;		/* Counter value at T0 */
+	SimTime T0;		/* Time the counter last took a new value */
+	int Running;
+	int Halted;		/* Expired without auto reload */
+	SimTime Expiry;
+	SimSignal GenOut;
+	SimTime GenOutFall;
+	int CaptureLevel;	/* Level of CAPTURETRIG that asserts it */
+} SimTmrCounter;
+
+struct SimTmrCtr {
+	SimDevice Dev;
+	u32 ClockHz;
+	u32 IntrId;
+	SimTmrCounter Counter[XTC_DEVICE_TIMER_COUNT];
+	SimSignal Pwm;
+};
+
+/************************** Variable Definitions *****************************/
+
+static SimTmrCtr SimTimers[SIM_TMR_NUM_INSTANCES];
+static int SimNumTimers;
+
+/* The counters form one 64-bit counter */
+static int SimTmr_IsCascade(SimTmrCtr *Tmr)
+{
+	return (Tmr->Counter[0].Tcsr & XTC_CSR_CASC_MASK) != 0U;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the value of the cascaded counter pair at the current simulated
+* time. Counter 0 holds the state of the pair.
+*
+******************************************************************************/
+static u64 SimTmr_Value64(SimTmrCtr *Tmr)
+{
+	SimTmrCounter *Low = &Tmr->Counter[0];
+	u64 Base = ((u64)Tmr->Counter[1].Base << 32) | Low->Base;
+	u64 Cycles;
+
+	if (!Low->Running) {
+		return Base;
+	}
+
+	Cycles = SimTimeToCycles(SimTimeNow - Low->T0, Tmr->ClockHz);
+	if (Low->Tcsr & XTC_CSR_DOWN_COUNT_MASK) {
+		return Base - Cycles;
+	}
+	return Base + Cycles;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the value of a counter at the current simulated time.
+*
+******************************************************************************/
+static u32 SimTmr_Value(SimTmrCtr *Tmr, SimTmrCounter *Cnt)
+{
+	u32 Cycles;
+
+	if (SimTmr_IsCascade(Tmr)) {
+		u64 Value = SimTmr_Value64(Tmr);
+
+		return (Cnt == &Tmr->Counter[0]) ? (u32)Value :
+						   (u32)(Value >> 32);
+	}
+
+	if (!Cnt->Running) {
+		return Cnt->Base;
+	}
+
+	Cycles = (u32)SimTimeToCycles(SimTimeNow - Cnt->T0, Tmr->ClockHz);
+	if (Cnt->Tcsr & XTC_CSR_DOWN_COUNT_MASK) {
+		return Cnt->Base - Cycles;
+	}
+	return Cnt->Base + Cycles;
+}
+
+/*
+ * Folds the elapsed clocks of a counter into Base. T0 stays on a clock
+ * edge, so the partial clock in progress is not lost, which would make a
+ * counter that is written often run slow. A cascaded pair is folded as a
+ * whole, through counter 0.
+ */
+static void SimTmr_Freeze(SimTmrCtr *Tmr, SimTmrCounter *Cnt)
+{
+	u64 Cycles;
+
+	if (SimTmr_IsCascade(Tmr)) {
+		SimTmrCounter *Low = &Tmr->Counter[0];
+		u64 Value = SimTmr_Value64(Tmr);
+
+		if (!Low->Running) {
+			Low->T0 = SimTimeNow;
+			return;
+		}
+		Cycles = SimTimeToCycles(SimTimeNow - Low->T0, Tmr->ClockHz);
+		Low->Base = (u32)Value;
+		Tmr->Counter[1].Base = (u32)(Value >> 32);
+		Low->T0 += SimCyclesToTime(Cycles, Tmr->ClockHz);
+		return;
+	}
+
+	if (!Cnt->Running) {
+		Cnt->T0 = SimTimeNow;
+		return;
+	}
+
+	Cycles = SimTimeToCycles(SimTimeNow - Cnt->T0, Tmr->ClockHz);
+	Cnt->Base = SimTmr_Value(Tmr, Cnt);
+	Cnt->T0 += SimCyclesToTime(Cycles, Tmr->ClockHz);
+}
+
+/*****************************************************************************/
+/**
+*
+* Recomputes the expiry time of a counter and the next event of the device.
+*
+******************************************************************************/
+static void SimTmr_Schedule(SimTmrCtr *Tmr)
+{
+	SimTime Next = SIM_TIME_NEVER;
+	int Index;
+
+	for (Index = 0; Index < XTC_DEVICE_TIMER_COUNT; Index++) {
+		SimTmrCounter *Cnt = &Tmr->Counter[Index];
+		u64 Distance;
+
+		Cnt->Running = (Cnt->Tcsr & XTC_CSR_ENABLE_TMR_MASK) &&
+			       !(Cnt->Tcsr & XTC_CSR_LOAD_MASK) &&
+			       !Cnt->Halted;
+		Cnt->Expiry = SIM_TIME_NEVER;
+		if (Cnt->Running && !SimTmr_IsCascade(Tmr) &&
+		    !(Cnt->Tcsr & XTC_CSR_CAPTURE_MODE_MASK)) {
+			if (Cnt->Tcsr & XTC_CSR_DOWN_COUNT_MASK) {
+				Distance = (u64)Cnt->Base + 1ULL;
+			} else {
+				Distance = 0x100000000ULL - Cnt->Base;
+			}
+			Cnt->Expiry = Cnt->T0 +
+				SimCyclesToTime(Distance, Tmr->ClockHz);
+		}
+
+		if (Cnt->Expiry < Next) {
+			Next = Cnt->Expiry;
+		}
+		if (Cnt->GenOutFall < Next) {
+			Next = Cnt->GenOutFall;
+		}
+	}
+
+	Tmr->Dev.NextEvent = Next;
+}
+
+/* Both counters are in PWM mode */
+static int SimTmr_IsPwm(SimTmrCtr *Tmr)
+{
+	return (Tmr->Counter[0].Tcsr & XTC_CSR_ENABLE_PWM_MASK) &&
+	       (Tmr->Counter[1].Tcsr & XTC_CSR_ENABLE_PWM_MASK);
+}
+
+static void SimTmr_UpdateLine(SimTmrCtr *Tmr)
+{
+	int Level = 0;
+	int Index;
+
+	for (Index = 0; Index < XTC_DEVICE_TIMER_COUNT; Index++) {
+		u32 Tcsr = Tmr->Counter[Index].Tcsr;
+
+		Level |= (Tcsr & XTC_CSR_INT_OCCURED_MASK) &&
+			 (Tcsr & XTC_CSR_ENABLE_INT_MASK);
+	}
+	SimGic_SetLine(Tmr->IntrId, Level);
+}
+
+/*****************************************************************************/
+/**
+*
+* Processes terminal counts and the end of GENERATEOUT pulses.
+*
+******************************************************************************/
+static void SimTmr_Advance(SimDevice *Dev, SimTime Now)
+{
+	SimTmrCtr *Tmr = (SimTmrCtr *)Dev->Priv;
+	SimTime OneClock = SimCyclesToTime(1, Tmr->ClockHz);
+	int Index;
+
+	for (Index = 0; Index < XTC_DEVICE_TIMER_COUNT; Index++) {
+		SimTmrCounter *Cnt = &Tmr->Counter[Index];
+
+		if (Cnt->GenOutFall <= Now) {
+			Cnt->GenOutFall = SIM_TIME_NEVER;
+			SimSignal_Set(&Cnt->GenOut, 0);
+		}
+
+		if (Cnt->Expiry > Now) {
+			continue;
+		}
+
+		Cnt->Tcsr |= XTC_CSR_INT_OCCURED_MASK;
+		if (Cnt->Tcsr & XTC_CSR_EXT_GENERATE_MASK) {
+			SimSignal_Set(&Cnt->GenOut, 1);
+			Cnt->GenOutFall = Cnt->Expiry + OneClock;
+		}
+
+		if (SimTmr_IsPwm(Tmr) && (Index == 0)) {
+			SimTmrCounter *High = &Tmr->Counter[1];
+
+			SimSignal_Set(&Tmr->Pwm, 1);
+			High->Base = High->Tlr;
+			High->T0 = Cnt->Expiry + OneClock;
+			High->Halted = 0;
+			High->Expiry = SIM_TIME_NEVER;
+		} else if (SimTmr_IsPwm(Tmr)) {
+			SimSignal_Set(&Tmr->Pwm, 0);
+		}
+
+		if ((Cnt->Tcsr & XTC_CSR_AUTO_RELOAD_MASK) &&
+		    !(SimTmr_IsPwm(Tmr) && (Index == 1))) {
+			Cnt->Base = Cnt->Tlr;
+			Cnt->T0 = Cnt->Expiry + OneClock;
+		} else {
+			Cnt->Base = (Cnt->Tcsr & XTC_CSR_DOWN_COUNT_MASK) ?
+				    0U : 0xFFFFFFFFU;
+			Cnt->T0 = Cnt->Expiry;
+			Cnt->Halted = 1;
+		}
+	}
+
+	SimTmr_Schedule(Tmr);
+	SimTmr_UpdateLine(Tmr);
+}
+
+static u32 SimTmr_Read(SimDevice *Dev, u32 Offset)
+{
+	SimTmrCtr *Tmr = (SimTmrCtr *)Dev->Priv;
+	u32 Index = Offset / XTC_TIMER_COUNTER_OFFSET;
+	SimTmrCounter *Cnt;
+
+	if (Index >= XTC_DEVICE_TIMER_COUNT) {
+		return 0;
+	}
+	Cnt = &Tmr->Counter[Index];
+
+	switch (Offset % XTC_TIMER_COUNTER_OFFSET) {
+	case XTC_TCSR_OFFSET:
+		return Cnt->Tcsr;
+	case XTC_TLR_OFFSET:
+		return Cnt->Tlr;
+	case XTC_TCR_OFFSET:
+		return SimTmr_Value(Tmr, Cnt);
+	default:
+		return 0;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Applies a TCSR write: TINT is write-one-to-clear, LOAD holds the counter
+* at TLR while set and ENALL mirrors into both counters. In cascade mode
+* LOAD in TCSR0 loads both words.
+*
+******************************************************************************/
+static void SimTmr_WriteTcsr(SimTmrCtr *Tmr, u32 Index, u32 Value)
+{
+	SimTmrCounter *Cnt = &Tmr->Counter[Index];
+	SimTmrCounter *Other = &Tmr->Counter[Index ^ 1U];
+	u32 Old = Cnt->Tcsr;
+
+	SimTmr_Freeze(Tmr, Cnt);
+	SimTmr_Freeze(Tmr, Other);
+
+	Cnt->Tcsr = (Value & ~XTC_CSR_INT_OCCURED_MASK) |
+		    (Old & XTC_CSR_INT_OCCURED_MASK &
+		     ~(Value & XTC_CSR_INT_OCCURED_MASK));
+
+	if (Value & XTC_CSR_ENABLE_ALL_MASK) {
+		Cnt->Tcsr |= XTC_CSR_ENABLE_TMR_MASK;
+		if (!(Other->Tcsr & XTC_CSR_ENABLE_TMR_MASK)) {
+			Other->Halted = 0;
+		}
+		Other->Tcsr |= XTC_CSR_ENABLE_ALL_MASK |
+			       XTC_CSR_ENABLE_TMR_MASK;
+	} else if (Old & XTC_CSR_ENABLE_ALL_MASK) {
+		Other->Tcsr &= ~XTC_CSR_ENABLE_ALL_MASK;
+	}
+
+	if (Cnt->Tcsr & XTC_CSR_LOAD_MASK) {
+		Cnt->Base = Cnt->Tlr;
+		Cnt->Halted = 0;
+		if (SimTmr_IsCascade(Tmr) && (Index == 0U)) {
+			Other->Base = Other->Tlr;
+		}
+	}
+	if ((Cnt->Tcsr & XTC_CSR_ENABLE_TMR_MASK) &&
+	    !(Old & XTC_CSR_ENABLE_TMR_MASK)) {
+		Cnt->Halted = 0;
+	}
+	if (!SimTmr_IsPwm(Tmr) ||
+	    !(Tmr->Counter[0].Tcsr & XTC_CSR_ENABLE_TMR_MASK)) {
+		SimSignal_Set(&Tmr->Pwm, 0);
+	}
+}
+
+static void SimTmr_Write(SimDevice *Dev, u32 Offset, u32 Value)
+{
+	SimTmrCtr *Tmr = (SimTmrCtr *)Dev->Priv;
+	u32 Index = Offset / XTC_TIMER_COUNTER_OFFSET;
+	SimTmrCounter *Cnt;
+
+	if (Index >= XTC_DEVICE_TIMER_COUNT) {
+		return;
+	}
+	Cnt = &Tmr->Counter[Index];
+
+	switch (Offset % XTC_TIMER_COUNTER_OFFSET) {
+	case XTC_TCSR_OFFSET:
+		SimTmr_WriteTcsr(Tmr, Index, Value & 0xFFFU);
+		break;
+	case XTC_TLR_OFFSET:
+		Cnt->Tlr = Value;
+		if ((Cnt->Tcsr & XTC_CSR_LOAD_MASK) ||
+		    (SimTmr_IsCascade(Tmr) &&
+		     (Tmr->Counter[0].Tcsr & XTC_CSR_LOAD_MASK))) {
+			Cnt->Base = Value;
+		}
+		break;
+	default:
+		return;
+	}
+
+	SimTmr_Schedule(Tmr);
+	SimTmr_UpdateLine(Tmr);
+}
+
+void SimTmrCtr_Create(UINTPTR BaseAddress, u32 ClockHz, u32 IntrId)
+{
+	SimTmrCtr *Tmr = &SimTimers[SimNumTimers++];
+	int Index;
+
+	memset(Tmr, 0, sizeof(*Tmr));
+	Tmr->ClockHz = ClockHz;
+	Tmr->IntrId = IntrId;
+	for (Index = 0; Index < XTC_DEVICE_TIMER_COUNT; Index++) {
+		Tmr->Counter[Index].Tmr = Tmr;
+		Tmr->Counter[Index].Expiry = SIM_TIME_NEVER;
+		Tmr->Counter[Index].GenOutFall = SIM_TIME_NEVER;
+	}
+
+	Tmr->Dev.Name = "axi-timer";
+	Tmr->Dev.BaseAddress = BaseAddress;
+	Tmr->Dev.Size = 0x20;
+	Tmr->Dev.Read = SimTmr_Read;
+	Tmr->Dev.Write = SimTmr_Write;
+	Tmr->Dev.Advance = SimTmr_Advance;
+	Tmr->Dev.Priv = Tmr;
+	SimDevice_Register(&Tmr->Dev);
+}
+
+/*****************************************************************************/
+/**
+*
+* Latches the counter into TLR on an asserting CAPTURETRIG edge.
+*
+******************************************************************************/
+static void SimTmr_CaptureTrig(void *Ref, int Level)
+{
+	SimTmrCounter *Cnt = (SimTmrCounter *)Ref;
+	SimTmrCtr *Tmr = Cnt->Tmr;
+	u32 Tcsr = Cnt->Tcsr;
+
+	if ((Level != Cnt->CaptureLevel) || !Cnt->Running ||
+	    !(Tcsr & XTC_CSR_CAPTURE_MODE_MASK) ||
+	    !(Tcsr & XTC_CSR_EXT_CAPTURE_MASK)) {
+		return;
+	}
+	if ((Tcsr & XTC_CSR_INT_OCCURED_MASK) &&
+	    !(Tcsr & XTC_CSR_AUTO_RELOAD_MASK)) {
+		return;
+	}
+
+	Cnt->Tlr = SimTmr_Value(Tmr, Cnt);
+	Cnt->Tcsr |= XTC_CSR_INT_OCCURED_MASK;
+	SimTmr_UpdateLine(Tmr);
+}
+
+SimSignal *SimTmrCtr_GenerateOut(UINTPTR BaseAddress, u8 TmrCtrNumber)
+{
+	SimDevice *Dev = SimDevice_Find(BaseAddress);
+
+	return &((SimTmrCtr *)Dev->Priv)->Counter[TmrCtrNumber].GenOut;
+}
+
+SimSignal *SimTmrCtr_PwmOut(UINTPTR BaseAddress)
+{
+	SimDevice *Dev = SimDevice_Find(BaseAddress);
+
+	return &((SimTmrCtr *)Dev->Priv)->Pwm;
+}
+
+void SimTmrCtr_ConnectCapture(UINTPTR BaseAddress, u8 TmrCtrNumber,
+			      SimSignal *Sig, int ActiveLow)
+{
+	SimDevice *Dev = SimDevice_Find(BaseAddress);
+	SimTmrCounter *Cnt = &((SimTmrCtr *)Dev->Priv)->Counter[TmrCtrNumber];
+
+	Cnt->CaptureLevel = !ActiveLow;
+	SimSignal_Connect(Sig, SimTmr_CaptureTrig, Cnt);
+}
@@ -0,0 +1,861 @@
+/******************************************************************************
+* Host simulator build of the XCan driver.
+*
+* Follows the standalone can driver for the AXI CAN controller (xcan.c,
+* xcan_config.c, xcan_intr.c and xcan_selftest.c).
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xparameters.h"
+#include "xcan.h"
+
+/************************** Constant Definitions *****************************/
+
+#define XCAN_MAX_FRAME_SIZE_IN_WORDS	(XCAN_MAX_FRAME_SIZE / sizeof(u32))
+#define FRAME_DATA_LENGTH		8
+#define TEST_MESSAGE_ID			2000
+
+/************************** Variable Definitions *****************************/
+
+XCan_Config XCan_ConfigTable[XPAR_XCAN_NUM_INSTANCES] = {
+	{
+		XPAR_CAN_0_DEVICE_ID,
+		XPAR_CAN_0_BASEADDR,
+		XPAR_CAN_0_CAN_NUM_ACF
+	},
+	{
+		XPAR_CAN_1_DEVICE_ID,
+		XPAR_CAN_1_BASEADDR,
+		XPAR_CAN_1_CAN_NUM_ACF
+	}
+};
+
+/*****************************************************************************/
+/**
+*
+* Stub handlers installed by XCan_CfgInitialize(). An interrupt arriving
+* for a handler type the application never set is a programming error.
+*
+******************************************************************************/
+static void StubHandler(void)
+{
+	Xil_AssertVoidAlways();
+}
+
+static void StubSendRecvHandler(void *CallBackRef)
+{
+	(void)CallBackRef;
+	StubHandler();
+}
+
+static void StubErrorHandler(void *CallBackRef, u32 ErrorMask)
+{
+	(void)CallBackRef;
+	(void)ErrorMask;
+	StubHandler();
+}
+
+static void StubEventHandler(void *CallBackRef, u32 Mask)
+{
+	(void)CallBackRef;
+	(void)Mask;
+	StubHandler();
+}
+
+/*****************************************************************************/
+/**
+*
+* Initializes the XCan instance provided by the caller based on the given
+* DeviceID.
+*
+* @return
+*		- XST_SUCCESS if initialization was successful
+*		- XST_DEVICE_NOT_FOUND if device configuration information was
+*		not found for a device with the supplied device ID.
+*
+******************************************************************************/
+int XCan_Initialize(XCan *InstancePtr, u16 DeviceId)
+{
+	XCan_Config *ConfigPtr;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+
+	ConfigPtr = XCan_LookupConfig(DeviceId);
+	if (ConfigPtr == (XCan_Config *) NULL) {
+		return XST_DEVICE_NOT_FOUND;
+	}
+
+	return XCan_CfgInitialize(InstancePtr, ConfigPtr,
+				  ConfigPtr->BaseAddress);
+}
+
+/*****************************************************************************/
+/**
+*
+* Initializes a specific XCan instance: installs stub handlers and resets
+* the device, which leaves it in configuration mode.
+*
+******************************************************************************/
+int XCan_CfgInitialize(XCan *InstancePtr, XCan_Config *ConfigPtr,
+		       UINTPTR EffectiveAddr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(ConfigPtr != NULL);
+
+	InstancePtr->IsReady = 0;
+	InstancePtr->CanConfig.DeviceId = ConfigPtr->DeviceId;
+	InstancePtr->CanConfig.BaseAddress = EffectiveAddr;
+	InstancePtr->CanConfig.NumOfAcceptFilters =
+		ConfigPtr->NumOfAcceptFilters;
+
+	InstancePtr->SendHandler = StubSendRecvHandler;
+	InstancePtr->RecvHandler = StubSendRecvHandler;
+	InstancePtr->ErrorHandler = StubErrorHandler;
+	InstancePtr->EventHandler = StubEventHandler;
+
+	InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+
+	XCan_Reset(InstancePtr);
+
+	return XST_SUCCESS;
+}
+
+void XCan_Reset(XCan *InstancePtr)
+{
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress, XCAN_SRR_OFFSET,
+		      XCAN_SRR_SRST_MASK);
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the current operation mode from the status register.
+*
+* @return	One of XCAN_MODE_CONFIG, XCAN_MODE_SLEEP, XCAN_MODE_NORMAL or
+*		XCAN_MODE_LOOPBACK.
+*
+******************************************************************************/
+u8 XCan_GetMode(XCan *InstancePtr)
+{
+	u32 StatusReg;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	StatusReg = XCan_GetStatus(InstancePtr);
+
+	if (StatusReg & XCAN_SR_CONFIG_MASK) {
+		return XCAN_MODE_CONFIG;
+	} else if (StatusReg & XCAN_SR_SLEEP_MASK) {
+		return XCAN_MODE_SLEEP;
+	} else if (StatusReg & XCAN_SR_NORMAL_MASK) {
+		return XCAN_MODE_NORMAL;
+	} else {
+		return XCAN_MODE_LOOPBACK;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Switches the device to another operation mode. Normal and sleep mode
+* switch directly; every other transition goes through configuration mode.
+* The caller should poll XCan_GetMode() to confirm the new mode.
+*
+******************************************************************************/
+void XCan_EnterMode(XCan *InstancePtr, u8 OperationMode)
+{
+	u8 CurrentMode;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid((OperationMode == XCAN_MODE_CONFIG) ||
+		       (OperationMode == XCAN_MODE_SLEEP) ||
+		       (OperationMode == XCAN_MODE_NORMAL) ||
+		       (OperationMode == XCAN_MODE_LOOPBACK));
+
+	CurrentMode = XCan_GetMode(InstancePtr);
+
+	if ((CurrentMode == XCAN_MODE_NORMAL) &&
+	    (OperationMode == XCAN_MODE_SLEEP)) {
+		XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+			      XCAN_MSR_OFFSET, XCAN_MSR_SLEEP_MASK);
+		return;
+	} else if ((CurrentMode == XCAN_MODE_SLEEP) &&
+		   (OperationMode == XCAN_MODE_NORMAL)) {
+		XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+			      XCAN_MSR_OFFSET, 0);
+		return;
+	}
+
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress, XCAN_SRR_OFFSET, 0);
+
+	if (XCan_GetMode(InstancePtr) != XCAN_MODE_CONFIG) {
+		return;
+	}
+
+	switch (OperationMode) {
+	case XCAN_MODE_CONFIG:
+		break;
+
+	case XCAN_MODE_SLEEP:
+		XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+			      XCAN_MSR_OFFSET, XCAN_MSR_SLEEP_MASK);
+		XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+			      XCAN_SRR_OFFSET, XCAN_SRR_CEN_MASK);
+		break;
+
+	case XCAN_MODE_NORMAL:
+		XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+			      XCAN_MSR_OFFSET, 0);
+		XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+			      XCAN_SRR_OFFSET, XCAN_SRR_CEN_MASK);
+		break;
+
+	case XCAN_MODE_LOOPBACK:
+		XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+			      XCAN_MSR_OFFSET, XCAN_MSR_LBACK_MASK);
+		XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+			      XCAN_SRR_OFFSET, XCAN_SRR_CEN_MASK);
+		break;
+	}
+}
+
+u32 XCan_GetStatus(XCan *InstancePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	return XCan_ReadReg(InstancePtr->CanConfig.BaseAddress,
+			    XCAN_SR_OFFSET);
+}
+
+void XCan_GetBusErrorCounter(XCan *InstancePtr, u8 *RxErrorCount,
+			     u8 *TxErrorCount)
+{
+	u32 Result;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(RxErrorCount != NULL);
+	Xil_AssertVoid(TxErrorCount != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	Result = XCan_ReadReg(InstancePtr->CanConfig.BaseAddress,
+			      XCAN_ECR_OFFSET);
+
+	*RxErrorCount = (u8)((Result & XCAN_ECR_REC_MASK) >>
+			     XCAN_ECR_REC_SHIFT);
+	*TxErrorCount = (u8)(Result & XCAN_ECR_TEC_MASK);
+}
+
+u32 XCan_GetBusErrorStatus(XCan *InstancePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	return XCan_ReadReg(InstancePtr->CanConfig.BaseAddress,
+			    XCAN_ESR_OFFSET);
+}
+
+void XCan_ClearBusErrorStatus(XCan *InstancePtr, u32 Mask)
+{
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress, XCAN_ESR_OFFSET,
+		      Mask);
+}
+
+/*****************************************************************************/
+/**
+*
+* Sends a CAN frame through the TX FIFO. The frame is committed to the FIFO
+* by the write of its second data word.
+*
+* @param	InstancePtr is a pointer to the XCan instance.
+* @param	FramePtr is a pointer to a 32-bit aligned buffer containing
+*		the CAN frame: ID, DLC and two data words, with data byte 0
+*		first in memory.
+*
+* @return
+*		- XST_SUCCESS if the frame was written to the TX FIFO
+*		- XST_FIFO_NO_ROOM if there is no room in the TX FIFO
+*
+******************************************************************************/
+int XCan_Send(XCan *InstancePtr, u32 *FramePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(FramePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	if (XCan_IsTxFifoFull(InstancePtr) == TRUE) {
+		return XST_FIFO_NO_ROOM;
+	}
+
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+		      XCAN_TXFIFO_ID_OFFSET, FramePtr[0]);
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+		      XCAN_TXFIFO_DLC_OFFSET, FramePtr[1]);
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+		      XCAN_TXFIFO_DW1_OFFSET, Xil_Htonl(FramePtr[2]));
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+		      XCAN_TXFIFO_DW2_OFFSET, Xil_Htonl(FramePtr[3]));
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads one CAN frame from the RX FIFO and acknowledges the not-empty
+* interrupt.
+*
+* @return
+*		- XST_SUCCESS if a frame was read
+*		- XST_NO_DATA if the RX FIFO was empty
+*
+******************************************************************************/
+int XCan_Recv(XCan *InstancePtr, u32 *FramePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(FramePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	if (XCan_IsRxEmpty(InstancePtr) == TRUE) {
+		return XST_NO_DATA;
+	}
+
+	FramePtr[0] = XCan_ReadReg(InstancePtr->CanConfig.BaseAddress,
+				   XCAN_RXFIFO_ID_OFFSET);
+	FramePtr[1] = XCan_ReadReg(InstancePtr->CanConfig.BaseAddress,
+				   XCAN_RXFIFO_DLC_OFFSET);
+	FramePtr[2] = Xil_Htonl(XCan_ReadReg(InstancePtr->CanConfig.BaseAddress,
+					     XCAN_RXFIFO_DW1_OFFSET));
+	FramePtr[3] = Xil_Htonl(XCan_ReadReg(InstancePtr->CanConfig.BaseAddress,
+					     XCAN_RXFIFO_DW2_OFFSET));
+
+	XCan_InterruptClear(InstancePtr, XCAN_IXR_RXNEMP_MASK);
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Sends a CAN frame through the one-frame high priority buffer, which is
+* always served ahead of the TX FIFO.
+*
+* @return
+*		- XST_SUCCESS if the frame was written to the buffer
+*		- XST_FIFO_NO_ROOM if the buffer is full
+*
+******************************************************************************/
+int XCan_SendHighPriority(XCan *InstancePtr, u32 *FramePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(FramePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	if (XCan_IsHighPriorityBufFull(InstancePtr) == TRUE) {
+		return XST_FIFO_NO_ROOM;
+	}
+
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+		      XCAN_TXHPB_ID_OFFSET, FramePtr[0]);
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+		      XCAN_TXHPB_DLC_OFFSET, FramePtr[1]);
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+		      XCAN_TXHPB_DW1_OFFSET, Xil_Htonl(FramePtr[2]));
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress,
+		      XCAN_TXHPB_DW2_OFFSET, Xil_Htonl(FramePtr[3]));
+
+	return XST_SUCCESS;
+}
+
+void XCan_AcceptFilterEnable(XCan *InstancePtr, u32 FilterIndexes)
+{
+	u32 EnabledFilters;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	EnabledFilters = XCan_ReadReg(InstancePtr->CanConfig.BaseAddress,
+				      XCAN_AFR_OFFSET);
+	EnabledFilters |= FilterIndexes;
+	EnabledFilters &= XCAN_AFR_UAF_ALL_MASK;
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress, XCAN_AFR_OFFSET,
+		      EnabledFilters);
+}
+
+void XCan_AcceptFilterDisable(XCan *InstancePtr, u32 FilterIndexes)
+{
+	u32 EnabledFilters;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	EnabledFilters = XCan_ReadReg(InstancePtr->CanConfig.BaseAddress,
+				      XCAN_AFR_OFFSET);
+	EnabledFilters &= XCAN_AFR_UAF_ALL_MASK & (~FilterIndexes);
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress, XCAN_AFR_OFFSET,
+		      EnabledFilters);
+}
+
+u32 XCan_AcceptFilterGetEnabledList(XCan *InstancePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	return XCan_ReadReg(InstancePtr->CanConfig.BaseAddress,
+			    XCAN_AFR_OFFSET);
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets the mask and ID of one acceptance filter. The filter must be
+* disabled while it is changed.
+*
+* @param	FilterIndex is one of XCAN_AFR_UAF1_MASK .. XCAN_AFR_UAF4_MASK.
+*
+* @return
+*		- XST_SUCCESS if the values were set
+*		- XST_FAILURE if the filter is enabled or the acceptance
+*		filter logic is busy
+*
+******************************************************************************/
+int XCan_AcceptFilterSet(XCan *InstancePtr, u32 FilterIndex,
+			 u32 MaskValue, u32 IdValue)
+{
+	u32 Offset;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertNonvoid((FilterIndex == XCAN_AFR_UAF4_MASK) ||
+			  (FilterIndex == XCAN_AFR_UAF3_MASK) ||
+			  (FilterIndex == XCAN_AFR_UAF2_MASK) ||
+			  (FilterIndex == XCAN_AFR_UAF1_MASK));
+
+	if ((XCan_AcceptFilterGetEnabledList(InstancePtr) & FilterIndex) ==
+	    FilterIndex) {
+		return XST_FAILURE;
+	}
+
+	if (XCan_IsAcceptFilterBusy(InstancePtr) == TRUE) {
+		return XST_FAILURE;
+	}
+
+	switch (FilterIndex) {
+	case XCAN_AFR_UAF1_MASK:
+		Offset = XCAN_AFMR1_OFFSET;
+		break;
+	case XCAN_AFR_UAF2_MASK:
+		Offset = XCAN_AFMR2_OFFSET;
+		break;
+	case XCAN_AFR_UAF3_MASK:
+		Offset = XCAN_AFMR3_OFFSET;
+		break;
+	default:
+		Offset = XCAN_AFMR4_OFFSET;
+		break;
+	}
+
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress, Offset, MaskValue);
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress, Offset + 4U,
+		      IdValue);
+
+	return XST_SUCCESS;
+}
+
+void XCan_AcceptFilterGet(XCan *InstancePtr, u32 FilterIndex,
+			  u32 *MaskValue, u32 *IdValue)
+{
+	u32 Offset;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid((FilterIndex == XCAN_AFR_UAF4_MASK) ||
+		       (FilterIndex == XCAN_AFR_UAF3_MASK) ||
+		       (FilterIndex == XCAN_AFR_UAF2_MASK) ||
+		       (FilterIndex == XCAN_AFR_UAF1_MASK));
+	Xil_AssertVoid(MaskValue != NULL);
+	Xil_AssertVoid(IdValue != NULL);
+
+	switch (FilterIndex) {
+	case XCAN_AFR_UAF1_MASK:
+		Offset = XCAN_AFMR1_OFFSET;
+		break;
+	case XCAN_AFR_UAF2_MASK:
+		Offset = XCAN_AFMR2_OFFSET;
+		break;
+	case XCAN_AFR_UAF3_MASK:
+		Offset = XCAN_AFMR3_OFFSET;
+		break;
+	default:
+		Offset = XCAN_AFMR4_OFFSET;
+		break;
+	}
+
+	*MaskValue = XCan_ReadReg(InstancePtr->CanConfig.BaseAddress, Offset);
+	*IdValue = XCan_ReadReg(InstancePtr->CanConfig.BaseAddress,
+				Offset + 4U);
+}
+
+XCan_Config *XCan_LookupConfig(u16 DeviceId)
+{
+	XCan_Config *CfgPtr = NULL;
+	u32 Index;
+
+	for (Index = 0; Index < XPAR_XCAN_NUM_INSTANCES; Index++) {
+		if (XCan_ConfigTable[Index].DeviceId == DeviceId) {
+			CfgPtr = &XCan_ConfigTable[Index];
+			break;
+		}
+	}
+
+	return CfgPtr;
+}
+
+XCan_Config *XCan_GetConfig(unsigned int InstanceIndex)
+{
+	if (InstanceIndex >= XPAR_XCAN_NUM_INSTANCES) {
+		return NULL;
+	}
+
+	return &XCan_ConfigTable[InstanceIndex];
+}
+
+/************************** xcan_config.c ************************************/
+
+/*****************************************************************************/
+/**
+*
+* Sets the baud rate prescaler. Only possible in configuration mode.
+*
+* @return
+*		- XST_SUCCESS if the prescaler was set
+*		- XST_FAILURE if the device is not in configuration mode
+*
+******************************************************************************/
+int XCan_SetBaudRatePrescaler(XCan *InstancePtr, u8 Prescaler)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	if (XCan_GetMode(InstancePtr) != XCAN_MODE_CONFIG) {
+		return XST_FAILURE;
+	}
+
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress, XCAN_BRPR_OFFSET,
+		      (u32)Prescaler);
+
+	return XST_SUCCESS;
+}
+
+u8 XCan_GetBaudRatePrescaler(XCan *InstancePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	return (u8)XCan_ReadReg(InstancePtr->CanConfig.BaseAddress,
+				XCAN_BRPR_OFFSET);
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets the bit timing: synchronization jump width and the two time
+* segments, each as the register value (actual value minus one). Only
+* possible in configuration mode.
+*
+* @return
+*		- XST_SUCCESS if the bit timing was set
+*		- XST_FAILURE if the device is not in configuration mode
+*
+******************************************************************************/
+int XCan_SetBitTiming(XCan *InstancePtr, u8 SyncJumpWidth,
+		      u8 TimeSegment2, u8 TimeSegment1)
+{
+	u32 Value;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertNonvoid(SyncJumpWidth <= (u8)3U);
+	Xil_AssertNonvoid(TimeSegment2 <= (u8)7U);
+	Xil_AssertNonvoid(TimeSegment1 <= (u8)15U);
+
+	if (XCan_GetMode(InstancePtr) != XCAN_MODE_CONFIG) {
+		return XST_FAILURE;
+	}
+
+	Value = ((u32)TimeSegment1) & XCAN_BTR_TS1_MASK;
+	Value |= (((u32)TimeSegment2) << XCAN_BTR_TS2_SHIFT) &
+		 XCAN_BTR_TS2_MASK;
+	Value |= (((u32)SyncJumpWidth) << XCAN_BTR_SJW_SHIFT) &
+		 XCAN_BTR_SJW_MASK;
+
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress, XCAN_BTR_OFFSET,
+		      Value);
+
+	return XST_SUCCESS;
+}
+
+void XCan_GetBitTiming(XCan *InstancePtr, u8 *SyncJumpWidth,
+		       u8 *TimeSegment2, u8 *TimeSegment1)
+{
+	u32 Value;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(SyncJumpWidth != NULL);
+	Xil_AssertVoid(TimeSegment2 != NULL);
+	Xil_AssertVoid(TimeSegment1 != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	Value = XCan_ReadReg(InstancePtr->CanConfig.BaseAddress,
+			     XCAN_BTR_OFFSET);
+
+	*TimeSegment1 = (u8)(Value & XCAN_BTR_TS1_MASK);
+	*TimeSegment2 = (u8)((Value & XCAN_BTR_TS2_MASK) >>
+			     XCAN_BTR_TS2_SHIFT);
+	*SyncJumpWidth = (u8)((Value & XCAN_BTR_SJW_MASK) >>
+			      XCAN_BTR_SJW_SHIFT);
+}
+
+/************************** xcan_selftest.c **********************************/
+
+/*****************************************************************************/
+/**
+*
+* Runs a self-test: resets the device, sends one frame in loopback mode,
+* polls for it to come back and compares it, then resets the device again,
+* leaving it in configuration mode.
+*
+* @return
+*		- XST_SUCCESS if the frame came back intact
+*		- XST_FAILURE otherwise
+*
+******************************************************************************/
+int XCan_SelfTest(XCan *InstancePtr)
+{
+	u8 *FramePtr;
+	u32 Index;
+	u32 Buffer[XCAN_MAX_FRAME_SIZE_IN_WORDS];
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	XCan_Reset(InstancePtr);
+
+	XCan_SetBaudRatePrescaler(InstancePtr, 1);
+	XCan_SetBitTiming(InstancePtr, 1, 3, 8);
+
+	XCan_EnterMode(InstancePtr, XCAN_MODE_LOOPBACK);
+
+	Buffer[0] = XCan_CreateIdValue(TEST_MESSAGE_ID, 0, 0, 0, 0);
+	Buffer[1] = XCan_CreateDlcValue(FRAME_DATA_LENGTH);
+
+	FramePtr = (u8 *)(&Buffer[2]);
+	for (Index = 0; Index < FRAME_DATA_LENGTH; Index++) {
+		*FramePtr++ = (u8)Index;
+	}
+
+	if (XCan_Send(InstancePtr, Buffer) != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	while (XCan_IsTxDone(InstancePtr) == FALSE);
+	while (XCan_IsRxEmpty(InstancePtr) == TRUE);
+
+	if (XCan_Recv(InstancePtr, Buffer) != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	if (Buffer[0] != (u32)XCan_CreateIdValue(TEST_MESSAGE_ID, 0, 0, 0, 0)) {
+		return XST_FAILURE;
+	}
+
+	if (Buffer[1] != (u32)XCan_CreateDlcValue(FRAME_DATA_LENGTH)) {
+		return XST_FAILURE;
+	}
+
+	FramePtr = (u8 *)(&Buffer[2]);
+	for (Index = 0; Index < FRAME_DATA_LENGTH; Index++) {
+		if (*FramePtr++ != (u8)Index) {
+			return XST_FAILURE;
+		}
+	}
+
+	XCan_Reset(InstancePtr);
+
+	return XST_SUCCESS;
+}
+
+/************************** xcan_intr.c **************************************/
+
+void XCan_InterruptEnable(XCan *InstancePtr, u32 Mask)
+{
+	u32 IntrValue;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	IntrValue = XCan_InterruptGetEnabled(InstancePtr);
+	IntrValue |= Mask & XCAN_IXR_ALL;
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress, XCAN_IER_OFFSET,
+		      IntrValue);
+}
+
+void XCan_InterruptDisable(XCan *InstancePtr, u32 Mask)
+{
+	u32 IntrValue;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	IntrValue = XCan_InterruptGetEnabled(InstancePtr);
+	IntrValue &= ~Mask;
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress, XCAN_IER_OFFSET,
+		      IntrValue);
+}
+
+u32 XCan_InterruptGetEnabled(XCan *InstancePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	return XCan_ReadReg(InstancePtr->CanConfig.BaseAddress,
+			    XCAN_IER_OFFSET);
+}
+
+u32 XCan_InterruptGetStatus(XCan *InstancePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	return XCan_ReadReg(InstancePtr->CanConfig.BaseAddress,
+			    XCAN_ISR_OFFSET);
+}
+
+void XCan_InterruptClear(XCan *InstancePtr, u32 Mask)
+{
+	u32 IntrValue;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	IntrValue = XCan_InterruptGetStatus(InstancePtr);
+	IntrValue &= Mask;
+	XCan_WriteReg(InstancePtr->CanConfig.BaseAddress, XCAN_ICR_OFFSET,
+		      IntrValue);
+}
+
+/*****************************************************************************/
+/**
+*
+* Interrupt handler for the CAN driver. Reads the pending and enabled
+* interrupts, clears them and dispatches to the error, event, receive and
+* send handlers in that order. After a bus-off event nothing else is
+* processed.
+*
+* @param	InstancePtr is a pointer to the XCan instance.
+*
+* @return	None.
+*
+******************************************************************************/
+void XCan_IntrHandler(void *InstancePtr)
+{
+	u32 PendingIntr;
+	u32 EventIntr;
+	u32 ErrorStatus;
+	XCan *CanPtr = (XCan *) ((void *)InstancePtr);
+
+	Xil_AssertVoid(CanPtr != NULL);
+	Xil_AssertVoid(CanPtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	PendingIntr = XCan_InterruptGetStatus(CanPtr);
+	PendingIntr &= XCan_InterruptGetEnabled(CanPtr);
+
+	XCan_InterruptClear(CanPtr, PendingIntr);
+
+	if (PendingIntr & XCAN_IXR_ERROR_MASK) {
+		ErrorStatus = XCan_GetBusErrorStatus(CanPtr);
+		CanPtr->ErrorHandler(CanPtr->ErrorRef, ErrorStatus);
+		XCan_ClearBusErrorStatus(CanPtr, ErrorStatus);
+	}
+
+	EventIntr = PendingIntr & (XCAN_IXR_RXOFLW_MASK |
+				   XCAN_IXR_RXUFLW_MASK |
+				   XCAN_IXR_TXBFLL_MASK |
+				   XCAN_IXR_TXFLL_MASK |
+				   XCAN_IXR_WKUP_MASK |
+				   XCAN_IXR_SLP_MASK |
+				   XCAN_IXR_BSOFF_MASK |
+				   XCAN_IXR_ARBLST_MASK);
+	if (EventIntr) {
+		CanPtr->EventHandler(CanPtr->EventRef, EventIntr);
+
+		if (EventIntr & XCAN_IXR_BSOFF_MASK) {
+			/* The controller has gone bus-off */
+			return;
+		}
+	}
+
+	if (PendingIntr & (XCAN_IXR_RXNEMP_MASK | XCAN_IXR_RXOK_MASK)) {
+		CanPtr->RecvHandler(CanPtr->RecvRef);
+	}
+
+	if (PendingIntr & XCAN_IXR_TXOK_MASK) {
+		CanPtr->SendHandler(CanPtr->SendRef);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Installs an asynchronous callback function for the given HandlerType.
+*
+* @return
+*		- XST_SUCCESS if the handler was installed
+*		- XST_INVALID_PARAM if HandlerType is not recognized
+*
+******************************************************************************/
+int XCan_SetHandler(XCan *InstancePtr, u32 HandlerType,
+		    void *CallBackFunc, void *CallBackRef)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(CallBackFunc != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	switch (HandlerType) {
+	case XCAN_HANDLER_SEND:
+		InstancePtr->SendHandler =
+			(XCan_SendRecvHandler) CallBackFunc;
+		InstancePtr->SendRef = CallBackRef;
+		break;
+
+	case XCAN_HANDLER_RECV:
+		InstancePtr->RecvHandler =
+			(XCan_SendRecvHandler) CallBackFunc;
+		InstancePtr->RecvRef = CallBackRef;
+		break;
+
+	case XCAN_HANDLER_ERROR:
+		InstancePtr->ErrorHandler = (XCan_ErrorHandler) CallBackFunc;
+		InstancePtr->ErrorRef = CallBackRef;
+		break;
+
+	case XCAN_HANDLER_EVENT:
+		InstancePtr->EventHandler = (XCan_EventHandler) CallBackFunc;
+		InstancePtr->EventRef = CallBackRef;
+		break;
+
+	default:
+		return XST_INVALID_PARAM;
+	}
+
+	return XST_SUCCESS;
+}
@@ -0,0 +1,923 @@
+/******************************************************************************
+* Host simulator build of the XCanFd driver.
+*
+* Follows the standalone canfd driver for the AXI CAN FD controller
+* (xcanfd.c, xcanfd_config.c, xcanfd_intr.c and xcanfd_selftest.c), with
+* RX FIFO 0 read in sequence and without the mailbox and filter functions.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xparameters.h"
+#include "xcanfd.h"
+
+/************************** Constant Definitions *****************************/
+
+#define XCANFD_MAX_FRAME_SIZE_IN_WORDS	(XCANFD_MAX_FRAME_SIZE / sizeof(u32))
+#define FRAME_DATA_LENGTH		64
+#define TEST_MESSAGE_ID			2000
+
+/************************** Variable Definitions *****************************/
+
+XCanFd_Config XCanFd_ConfigTable[XPAR_XCANFD_NUM_INSTANCES] = {
+	{
+		XPAR_CANFD_0_DEVICE_ID,
+		XPAR_CANFD_0_BASEADDR,
+		XPAR_CANFD_0_RX_MODE,
+		XPAR_CANFD_0_NUM_OF_RX_MB_BUF,
+		XPAR_CANFD_0_NUM_OF_TX_BUF
+	}
+};
+
+/* Data field lengths of the DLC codes of a CAN FD frame */
+static const u8 XCanFd_DlcLength[16] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64
+};
+
+/*****************************************************************************/
+/**
+*
+* Stub handlers installed by XCanFd_CfgInitialize(). An interrupt arriving
+* for a handler type the application never set is a programming error.
+*
+******************************************************************************/
+static void StubHandler(void)
+{
+	Xil_AssertVoidAlways();
+}
+
+static void StubSendRecvHandler(void *CallBackRef)
+{
+	(void)CallBackRef;
+	StubHandler();
+}
+
+static void StubErrorHandler(void *CallBackRef, u32 ErrorMask)
+{
+	(void)CallBackRef;
+	(void)ErrorMask;
+	StubHandler();
+}
+
+static void StubEventHandler(void *CallBackRef, u32 Mask)
+{
+	(void)CallBackRef;
+	(void)Mask;
+	StubHandler();
+}
+
+/*****************************************************************************/
+/**
+*
+* Initializes a specific XCanFd instance: installs stub handlers and resets
+* the device, which leaves it in configuration mode.
+*
+* @return
+*		- XST_SUCCESS if initialization was successful
+*		- XST_INVALID_PARAM if the configuration asks for the mailbox
+*		RX mode or more TX buffers than TRR has bits
+*
+******************************************************************************/
+int XCanFd_CfgInitialize(XCanFd *InstancePtr, XCanFd_Config *ConfigPtr,
+			 UINTPTR EffectiveAddr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(ConfigPtr != NULL);
+
+	if ((ConfigPtr->Rx_Mode != XCANFD_RX_FIFO_MODE) ||
+	    (ConfigPtr->NumofTxBuf == 0U) || (ConfigPtr->NumofTxBuf > 32U)) {
+		return XST_INVALID_PARAM;
+	}
+
+	InstancePtr->IsReady = 0;
+	InstancePtr->CanFdConfig.DeviceId = ConfigPtr->DeviceId;
+	InstancePtr->CanFdConfig.BaseAddress = EffectiveAddr;
+	InstancePtr->CanFdConfig.Rx_Mode = ConfigPtr->Rx_Mode;
+	InstancePtr->CanFdConfig.NumofRxMbBuf = ConfigPtr->NumofRxMbBuf;
+	InstancePtr->CanFdConfig.NumofTxBuf = ConfigPtr->NumofTxBuf;
+	InstancePtr->FreeTxBufferIndex = 0;
+
+	InstancePtr->SendHandler = StubSendRecvHandler;
+	InstancePtr->RecvHandler = StubSendRecvHandler;
+	InstancePtr->ErrorHandler = StubErrorHandler;
+	InstancePtr->EventHandler = StubEventHandler;
+
+	InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+
+	XCanFd_Reset(InstancePtr);
+
+	return XST_SUCCESS;
+}
+
+void XCanFd_Reset(XCanFd *InstancePtr)
+{
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+			XCANFD_SRR_OFFSET, XCANFD_SRR_SRST_MASK);
+	InstancePtr->FreeTxBufferIndex = 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the current operation mode from the status register.
+*
+* @return	One of XCANFD_MODE_CONFIG, XCANFD_MODE_SLEEP,
+*		XCANFD_MODE_NORMAL or XCANFD_MODE_LOOPBACK.
+*
+******************************************************************************/
+u8 XCanFd_GetMode(XCanFd *InstancePtr)
+{
+	u32 StatusReg;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	StatusReg = XCanFd_GetStatus(InstancePtr);
+
+	if (StatusReg & XCANFD_SR_CONFIG_MASK) {
+		return XCANFD_MODE_CONFIG;
+	} else if (StatusReg & XCANFD_SR_SLEEP_MASK) {
+		return XCANFD_MODE_SLEEP;
+	} else if (StatusReg & XCANFD_SR_NORMAL_MASK) {
+		return XCANFD_MODE_NORMAL;
+	} else {
+		return XCANFD_MODE_LOOPBACK;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Switches the device to another operation mode. Normal and sleep mode
+* switch directly; every other transition goes through configuration mode.
+* The bit rate switch setting of the Mode Select Register is kept. The
+* caller should poll XCanFd_GetMode() to confirm the new mode.
+*
+******************************************************************************/
+void XCanFd_EnterMode(XCanFd *InstancePtr, u8 OperationMode)
+{
+	u8 CurrentMode;
+	u32 Brsd;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid((OperationMode == XCANFD_MODE_CONFIG) ||
+		       (OperationMode == XCANFD_MODE_SLEEP) ||
+		       (OperationMode == XCANFD_MODE_NORMAL) ||
+		       (OperationMode == XCANFD_MODE_LOOPBACK));
+
+	CurrentMode = XCanFd_GetMode(InstancePtr);
+	Brsd = XCanFd_ReadReg(InstancePtr->CanFdConfig.BaseAddress,
+			      XCANFD_MSR_OFFSET) & XCANFD_MSR_BRSD_MASK;
+
+	if ((CurrentMode == XCANFD_MODE_NORMAL) &&
+	    (OperationMode == XCANFD_MODE_SLEEP)) {
+		XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+				XCANFD_MSR_OFFSET,
+				Brsd | XCANFD_MSR_SLEEP_MASK);
+		return;
+	} else if ((CurrentMode == XCANFD_MODE_SLEEP) &&
+		   (OperationMode == XCANFD_MODE_NORMAL)) {
+		XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+				XCANFD_MSR_OFFSET, Brsd);
+		return;
+	}
+
+	XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+			XCANFD_SRR_OFFSET, 0);
+
+	if (XCanFd_GetMode(InstancePtr) != XCANFD_MODE_CONFIG) {
+		return;
+	}
+
+	switch (OperationMode) {
+	case XCANFD_MODE_CONFIG:
+		break;
+
+	case XCANFD_MODE_SLEEP:
+		XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+				XCANFD_MSR_OFFSET,
+				Brsd | XCANFD_MSR_SLEEP_MASK);
+		XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+				XCANFD_SRR_OFFSET, XCANFD_SRR_CEN_MASK);
+		break;
+
+	case XCANFD_MODE_NORMAL:
+		XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+				XCANFD_MSR_OFFSET, Brsd);
+		XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+				XCANFD_SRR_OFFSET, XCANFD_SRR_CEN_MASK);
+		break;
+
+	case XCANFD_MODE_LOOPBACK:
+		XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+				XCANFD_MSR_OFFSET,
+				Brsd | XCANFD_MSR_LBACK_MASK);
+		XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+				XCANFD_SRR_OFFSET, XCANFD_SRR_CEN_MASK);
+		break;
+	}
+}
+
+u32 XCanFd_GetStatus(XCanFd *InstancePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	return XCanFd_ReadReg(InstancePtr->CanFdConfig.BaseAddress,
+			      XCANFD_SR_OFFSET);
+}
+
+void XCanFd_GetBusErrorCounter(XCanFd *InstancePtr, u8 *RxErrorCount,
+			       u8 *TxErrorCount)
+{
+	u32 Result;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(RxErrorCount != NULL);
+	Xil_AssertVoid(TxErrorCount != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	Result = XCanFd_ReadReg(InstancePtr->CanFdConfig.BaseAddress,
+				XCANFD_ECR_OFFSET);
+
+	*RxErrorCount = (u8)((Result & XCANFD_ECR_REC_MASK) >>
+			     XCANFD_ECR_REC_SHIFT);
+	*TxErrorCount = (u8)(Result & XCANFD_ECR_TEC_MASK);
+}
+
+u32 XCanFd_GetBusErrorStatus(XCanFd *InstancePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	return XCanFd_ReadReg(InstancePtr->CanFdConfig.BaseAddress,
+			      XCANFD_ESR_OFFSET);
+}
+
+void XCanFd_ClearBusErrorStatus(XCanFd *InstancePtr, u32 Mask)
+{
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+			XCANFD_ESR_OFFSET, Mask);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the data field length of a DLC.
+*
+* @param	Dlc is the DLC register value of the frame.
+* @param	Edl is non-zero for a CAN FD frame; a classic frame carries
+*		8 bytes at most whatever its DLC.
+*
+* @return	The number of data bytes, 0 to 64.
+*
+******************************************************************************/
+int XCanFd_GetDlc2len(u32 Dlc, u32 Edl)
+{
+	u32 Code = (Dlc & XCANFD_DLCR_DLC_MASK) >> XCANFD_DLCR_DLC_SHIFT;
+
+	if (!Edl && (Code > 8U)) {
+		return 8;
+	}
+
+	return XCanFd_DlcLength[Code];
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the smallest DLC code whose data field holds Len bytes. The
+* frame is padded up to its length: 9 to 12 bytes take DLC 9, and so on.
+*
+******************************************************************************/
+u8 XCanFd_GetLen2Dlc(int Len)
+{
+	u8 Code = 0;
+
+	while ((Code < 15U) && ((int)XCanFd_DlcLength[Code] < Len)) {
+		Code++;
+	}
+
+	return Code;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the number of TX buffers free for XCanFd_Send, those without a
+* pending ready request.
+*
+******************************************************************************/
+u32 XCanFd_GetFreeBuffer(XCanFd *InstancePtr)
+{
+	u32 Trr;
+	u32 Free = 0;
+	u32 Index;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	Trr = XCanFd_ReadReg(InstancePtr->CanFdConfig.BaseAddress,
+			     XCANFD_TRR_OFFSET);
+	for (Index = 0; Index < InstancePtr->CanFdConfig.NumofTxBuf;
+	     Index++) {
+		if ((Trr & (1U << Index)) == 0U) {
+			Free++;
+		}
+	}
+
+	return Free;
+}
+
+/*****************************************************************************/
+/**
+*
+* Sends a CAN or CAN FD frame: writes it into the next TX buffer in turn
+* and sets the buffer's ready request. The buffers are used round robin, so
+* frames of one ID go out in the order they were sent.
+*
+* @param	InstancePtr is a pointer to the XCanFd instance.
+* @param	FramePtr is a pointer to a 32-bit aligned buffer containing
+*		the frame: ID, DLC and as many data words as the DLC needs,
+*		with data byte 0 first in memory.
+* @param	TxBufferNumber returns the TX buffer the frame went to.
+*
+* @return
+*		- XST_SUCCESS if the frame was written and requested
+*		- XST_FIFO_NO_ROOM if the next buffer is still pending
+*
+******************************************************************************/
+int XCanFd_Send(XCanFd *InstancePtr, u32 *FramePtr, u32 *TxBufferNumber)
+{
+	UINTPTR Base;
+	u32 Index;
+	u32 Offset;
+	u32 Words;
+	u32 Word;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(FramePtr != NULL);
+	Xil_AssertNonvoid(TxBufferNumber != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	Base = InstancePtr->CanFdConfig.BaseAddress;
+	Index = InstancePtr->FreeTxBufferIndex;
+	if (XCanFd_ReadReg(Base, XCANFD_TRR_OFFSET) & (1U << Index)) {
+		return XST_FIFO_NO_ROOM;
+	}
+
+	Offset = XCANFD_TXID_OFFSET(Index);
+	XCanFd_WriteReg(Base, Offset, FramePtr[0]);
+	XCanFd_WriteReg(Base, Offset + 4U, FramePtr[1]);
+
+	Words = ((u32)XCanFd_GetDlc2len(FramePtr[1], FramePtr[1] &
+					XCANFD_DLCR_EDL_MASK) + 3U) / 4U;
+	for (Word = 0; Word < Words; Word++) {
+		XCanFd_WriteReg(Base, Offset + 8U + 4U * Word,
+				Xil_Htonl(FramePtr[2U + Word]));
+	}
+
+	XCanFd_WriteReg(Base, XCANFD_TRR_OFFSET, 1U << Index);
+
+	*TxBufferNumber = Index;
+	InstancePtr->FreeTxBufferIndex =
+		(Index + 1U) % InstancePtr->CanFdConfig.NumofTxBuf;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the next frame of RX FIFO 0, as many data words as its DLC needs,
+* and releases the FIFO element.
+*
+* @return
+*		- XST_SUCCESS if a frame was read
+*		- XST_NO_DATA if RX FIFO 0 was empty
+*
+******************************************************************************/
+int XCanFd_Recv_Sequential(XCanFd *InstancePtr, u32 *FramePtr)
+{
+	UINTPTR Base;
+	u32 Fsr;
+	u32 Offset;
+	u32 Words;
+	u32 Word;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(FramePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	Base = InstancePtr->CanFdConfig.BaseAddress;
+	Fsr = XCanFd_ReadReg(Base, XCANFD_FSR_OFFSET);
+	if ((Fsr & XCANFD_FSR_FL_MASK) == 0U) {
+		return XST_NO_DATA;
+	}
+
+	Offset = XCANFD_RXID_OFFSET(Fsr & XCANFD_FSR_RI_MASK);
+	FramePtr[0] = XCanFd_ReadReg(Base, Offset);
+	FramePtr[1] = XCanFd_ReadReg(Base, Offset + 4U);
+
+	Words = ((u32)XCanFd_GetDlc2len(FramePtr[1], FramePtr[1] &
+					XCANFD_DLCR_EDL_MASK) + 3U) / 4U;
+	for (Word = 0; Word < Words; Word++) {
+		FramePtr[2U + Word] = Xil_Htonl(XCanFd_ReadReg(Base,
+					Offset + 8U + 4U * Word));
+	}
+
+	XCanFd_WriteReg(Base, XCANFD_FSR_OFFSET, XCANFD_FSR_IRI_MASK);
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Sends CAN FD frames with the bit rate switch flag in the arbitration
+* phase bit rate throughout (Disable), or at the data phase bit rate from
+* the BRS bit on (Enable, the reset state). Only possible in configuration
+* mode.
+*
+******************************************************************************/
+void XCanFd_SetBitRateSwitch_DisableNominal(XCanFd *InstancePtr)
+{
+	u32 Msr;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	Msr = XCanFd_ReadReg(InstancePtr->CanFdConfig.BaseAddress,
+			     XCANFD_MSR_OFFSET);
+	XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+			XCANFD_MSR_OFFSET, Msr | XCANFD_MSR_BRSD_MASK);
+}
+
+void XCanFd_SetBitRateSwitch_EnableNominal(XCanFd *InstancePtr)
+{
+	u32 Msr;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	Msr = XCanFd_ReadReg(InstancePtr->CanFdConfig.BaseAddress,
+			     XCANFD_MSR_OFFSET);
+	XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+			XCANFD_MSR_OFFSET, Msr & ~XCANFD_MSR_BRSD_MASK);
+}
+
+XCanFd_Config *XCanFd_LookupConfig(u16 DeviceId)
+{
+	XCanFd_Config *CfgPtr = NULL;
+	u32 Index;
+
+	for (Index = 0; Index < XPAR_XCANFD_NUM_INSTANCES; Index++) {
+		if (XCanFd_ConfigTable[Index].DeviceId == DeviceId) {
+			CfgPtr = &XCanFd_ConfigTable[Index];
+			break;
+		}
+	}
+
+	return CfgPtr;
+}
+
+/************************** xcanfd_config.c **********************************/
+
+/*****************************************************************************/
+/**
+*
+* Sets the arbitration phase baud rate prescaler. Only possible in
+* configuration mode.
+*
+* @return
+*		- XST_SUCCESS if the prescaler was set
+*		- XST_FAILURE if the device is not in configuration mode
+*
+******************************************************************************/
+int XCanFd_SetBaudRatePrescaler(XCanFd *InstancePtr, u8 Prescaler)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	if (XCanFd_GetMode(InstancePtr) != XCANFD_MODE_CONFIG) {
+		return XST_FAILURE;
+	}
+
+	XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+			XCANFD_BRPR_OFFSET, (u32)Prescaler);
+
+	return XST_SUCCESS;
+}
+
+u8 XCanFd_GetBaudRatePrescaler(XCanFd *InstancePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	return (u8)XCanFd_ReadReg(InstancePtr->CanFdConfig.BaseAddress,
+				  XCANFD_BRPR_OFFSET);
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets the arbitration phase bit timing: synchronization jump width and the
+* two time segments, each as the register value (actual value minus one).
+* Only possible in configuration mode.
+*
+* @return
+*		- XST_SUCCESS if the bit timing was set
+*		- XST_FAILURE if the device is not in configuration mode
+*
+******************************************************************************/
+int XCanFd_SetBitTiming(XCanFd *InstancePtr, u8 SyncJumpWidth,
+			u8 TimeSegment2, u8 TimeSegment1)
+{
+	u32 Value;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertNonvoid(SyncJumpWidth <= (u8)127U);
+	Xil_AssertNonvoid(TimeSegment2 <= (u8)127U);
+
+	if (XCanFd_GetMode(InstancePtr) != XCANFD_MODE_CONFIG) {
+		return XST_FAILURE;
+	}
+
+	Value = ((u32)TimeSegment1) & XCANFD_BTR_TS1_MASK;
+	Value |= (((u32)TimeSegment2) << XCANFD_BTR_TS2_SHIFT) &
+		 XCANFD_BTR_TS2_MASK;
+	Value |= (((u32)SyncJumpWidth) << XCANFD_BTR_SJW_SHIFT) &
+		 XCANFD_BTR_SJW_MASK;
+
+	XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+			XCANFD_BTR_OFFSET, Value);
+
+	return XST_SUCCESS;
+}
+
+void XCanFd_GetBitTiming(XCanFd *InstancePtr, u8 *SyncJumpWidth,
+			 u8 *TimeSegment2, u8 *TimeSegment1)
+{
+	u32 Value;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(SyncJumpWidth != NULL);
+	Xil_AssertVoid(TimeSegment2 != NULL);
+	Xil_AssertVoid(TimeSegment1 != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	Value = XCanFd_ReadReg(InstancePtr->CanFdConfig.BaseAddress,
+			       XCANFD_BTR_OFFSET);
+
+	*TimeSegment1 = (u8)(Value & XCANFD_BTR_TS1_MASK);
+	*TimeSegment2 = (u8)((Value & XCANFD_BTR_TS2_MASK) >>
+			     XCANFD_BTR_TS2_SHIFT);
+	*SyncJumpWidth = (u8)((Value & XCANFD_BTR_SJW_MASK) >>
+			      XCANFD_BTR_SJW_SHIFT);
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets the data phase baud rate prescaler, used from the BRS bit of a CAN
+* FD frame to its CRC delimiter. Only possible in configuration mode.
+*
+* @return
+*		- XST_SUCCESS if the prescaler was set
+*		- XST_FAILURE if the device is not in configuration mode
+*
+******************************************************************************/
+int XCanFd_SetFBaudRatePrescaler(XCanFd *InstancePtr, u8 Prescaler)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	if (XCanFd_GetMode(InstancePtr) != XCANFD_MODE_CONFIG) {
+		return XST_FAILURE;
+	}
+
+	XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+			XCANFD_F_BRPR_OFFSET, (u32)Prescaler);
+
+	return XST_SUCCESS;
+}
+
+u8 XCanFd_GetFBaudRatePrescaler(XCanFd *InstancePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	return (u8)XCanFd_ReadReg(InstancePtr->CanFdConfig.BaseAddress,
+				  XCANFD_F_BRPR_OFFSET);
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets the data phase bit timing, register values as XCanFd_SetBitTiming()
+* takes them. Only possible in configuration mode.
+*
+* @return
+*		- XST_SUCCESS if the bit timing was set
+*		- XST_FAILURE if the device is not in configuration mode
+*
+******************************************************************************/
+int XCanFd_SetFBitTiming(XCanFd *InstancePtr, u8 SyncJumpWidth,
+			 u8 TimeSegment2, u8 TimeSegment1)
+{
+	u32 Value;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertNonvoid(SyncJumpWidth <= (u8)15U);
+	Xil_AssertNonvoid(TimeSegment2 <= (u8)15U);
+	Xil_AssertNonvoid(TimeSegment1 <= (u8)31U);
+
+	if (XCanFd_GetMode(InstancePtr) != XCANFD_MODE_CONFIG) {
+		return XST_FAILURE;
+	}
+
+	Value = ((u32)TimeSegment1) & XCANFD_F_BTR_TS1_MASK;
+	Value |= (((u32)TimeSegment2) << XCANFD_F_BTR_TS2_SHIFT) &
+		 XCANFD_F_BTR_TS2_MASK;
+	Value |= (((u32)SyncJumpWidth) << XCANFD_F_BTR_SJW_SHIFT) &
+		 XCANFD_F_BTR_SJW_MASK;
+
+	XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+			XCANFD_F_BTR_OFFSET, Value);
+
+	return XST_SUCCESS;
+}
+
+void XCanFd_GetFBitTiming(XCanFd *InstancePtr, u8 *SyncJumpWidth,
+			  u8 *TimeSegment2, u8 *TimeSegment1)
+{
+	u32 Value;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(SyncJumpWidth != NULL);
+	Xil_AssertVoid(TimeSegment2 != NULL);
+	Xil_AssertVoid(TimeSegment1 != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	Value = XCanFd_ReadReg(InstancePtr->CanFdConfig.BaseAddress,
+			       XCANFD_F_BTR_OFFSET);
+
+	*TimeSegment1 = (u8)(Value & XCANFD_F_BTR_TS1_MASK);
+	*TimeSegment2 = (u8)((Value & XCANFD_F_BTR_TS2_MASK) >>
+			     XCANFD_F_BTR_TS2_SHIFT);
+	*SyncJumpWidth = (u8)((Value & XCANFD_F_BTR_SJW_MASK) >>
+			      XCANFD_F_BTR_SJW_SHIFT);
+}
+
+/************************** xcanfd_selftest.c ********************************/
+
+/*****************************************************************************/
+/**
+*
+* Runs a self-test: resets the device, sends one 64-byte CAN FD frame with
+* the bit rate switch in loopback mode, polls for it to come back and
+* compares it, then resets the device again, leaving it in configuration
+* mode.
+*
+* @return
+*		- XST_SUCCESS if the frame came back intact
+*		- XST_FAILURE otherwise
+*
+******************************************************************************/
+int XCanFd_SelfTest(XCanFd *InstancePtr)
+{
+	u8 *FramePtr;
+	u32 Index;
+	u32 TxBuffer;
+	u32 Buffer[XCANFD_MAX_FRAME_SIZE_IN_WORDS];
+	u32 Dlc;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	XCanFd_Reset(InstancePtr);
+
+	XCanFd_SetBaudRatePrescaler(InstancePtr, 1);
+	XCanFd_SetBitTiming(InstancePtr, 1, 3, 8);
+	XCanFd_SetFBaudRatePrescaler(InstancePtr, 1);
+	XCanFd_SetFBitTiming(InstancePtr, 1, 1, 2);
+
+	XCanFd_EnterMode(InstancePtr, XCANFD_MODE_LOOPBACK);
+
+	Dlc = XCanFd_Create_CanFD_Dlc_BrsValue(
+		XCanFd_GetLen2Dlc(FRAME_DATA_LENGTH));
+	Buffer[0] = XCanFd_CreateIdValue(TEST_MESSAGE_ID, 0, 0, 0, 0);
+	Buffer[1] = Dlc;
+
+	FramePtr = (u8 *)(&Buffer[2]);
+	for (Index = 0; Index < FRAME_DATA_LENGTH; Index++) {
+		*FramePtr++ = (u8)Index;
+	}
+
+	if (XCanFd_Send(InstancePtr, Buffer, &TxBuffer) != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	while (XCanFd_IsBufferTransmitted(InstancePtr, TxBuffer) == FALSE);
+	while (XCanFd_GetRxFillLevel(InstancePtr) == 0U);
+
+	if (XCanFd_Recv(InstancePtr, Buffer) != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	if (Buffer[0] != (u32)XCanFd_CreateIdValue(TEST_MESSAGE_ID, 0, 0, 0,
+						   0)) {
+		return XST_FAILURE;
+	}
+
+	if (Buffer[1] != Dlc) {
+		return XST_FAILURE;
+	}
+
+	FramePtr = (u8 *)(&Buffer[2]);
+	for (Index = 0; Index < FRAME_DATA_LENGTH; Index++) {
+		if (*FramePtr++ != (u8)Index) {
+			return XST_FAILURE;
+		}
+	}
+
+	XCanFd_Reset(InstancePtr);
+
+	return XST_SUCCESS;
+}
+
+/************************** xcanfd_intr.c ************************************/
+
+void XCanFd_InterruptEnable(XCanFd *InstancePtr, u32 Mask)
+{
+	u32 IntrValue;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	IntrValue = XCanFd_InterruptGetEnabled(InstancePtr);
+	IntrValue |= Mask & XCANFD_IXR_ALL;
+	XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+			XCANFD_IER_OFFSET, IntrValue);
+}
+
+void XCanFd_InterruptDisable(XCanFd *InstancePtr, u32 Mask)
+{
+	u32 IntrValue;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	IntrValue = XCanFd_InterruptGetEnabled(InstancePtr);
+	IntrValue &= ~Mask;
+	XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+			XCANFD_IER_OFFSET, IntrValue);
+}
+
+u32 XCanFd_InterruptGetEnabled(XCanFd *InstancePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	return XCanFd_ReadReg(InstancePtr->CanFdConfig.BaseAddress,
+			      XCANFD_IER_OFFSET);
+}
+
+u32 XCanFd_InterruptGetStatus(XCanFd *InstancePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	return XCanFd_ReadReg(InstancePtr->CanFdConfig.BaseAddress,
+			      XCANFD_ISR_OFFSET);
+}
+
+void XCanFd_InterruptClear(XCanFd *InstancePtr, u32 Mask)
+{
+	u32 IntrValue;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	IntrValue = XCanFd_InterruptGetStatus(InstancePtr);
+	IntrValue &= Mask;
+	XCanFd_WriteReg(InstancePtr->CanFdConfig.BaseAddress,
+			XCANFD_ICR_OFFSET, IntrValue);
+}
+
+/*****************************************************************************/
+/**
+*
+* Interrupt handler for the CAN FD driver. Reads the pending and enabled
+* interrupts, clears them and dispatches to the error, event, receive and
+* send handlers in that order. After a bus-off event nothing else is
+* processed. RXOK is raised once per frame, so the receive handler should
+* empty RX FIFO 0.
+*
+* @param	InstancePtr is a pointer to the XCanFd instance.
+*
+* @return	None.
+*
+******************************************************************************/
+void XCanFd_IntrHandler(void *InstancePtr)
+{
+	u32 PendingIntr;
+	u32 EventIntr;
+	u32 ErrorStatus;
+	XCanFd *CanPtr = (XCanFd *) ((void *)InstancePtr);
+
+	Xil_AssertVoid(CanPtr != NULL);
+	Xil_AssertVoid(CanPtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	PendingIntr = XCanFd_InterruptGetStatus(CanPtr);
+	PendingIntr &= XCanFd_InterruptGetEnabled(CanPtr);
+
+	XCanFd_InterruptClear(CanPtr, PendingIntr);
+
+	if (PendingIntr & XCANFD_IXR_ERROR_MASK) {
+		ErrorStatus = XCanFd_GetBusErrorStatus(CanPtr);
+		CanPtr->ErrorHandler(CanPtr->ErrorRef, ErrorStatus);
+		XCanFd_ClearBusErrorStatus(CanPtr, ErrorStatus);
+	}
+
+	EventIntr = PendingIntr & (XCANFD_IXR_RXFOFLW_MASK |
+				   XCANFD_IXR_WKUP_MASK |
+				   XCANFD_IXR_SLP_MASK |
+				   XCANFD_IXR_BSOFF_MASK |
+				   XCANFD_IXR_BSRD_MASK |
+				   XCANFD_IXR_ARBLST_MASK);
+	if (EventIntr) {
+		CanPtr->EventHandler(CanPtr->EventRef, EventIntr);
+
+		if (EventIntr & XCANFD_IXR_BSOFF_MASK) {
+			/* The controller has gone bus-off */
+			return;
+		}
+	}
+
+	if (PendingIntr & XCANFD_IXR_RXOK_MASK) {
+		CanPtr->RecvHandler(CanPtr->RecvRef);
+	}
+
+	if (PendingIntr & XCANFD_IXR_TXOK_MASK) {
+		CanPtr->SendHandler(CanPtr->SendRef);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Installs an asynchronous callback function for the given HandlerType.
+*
+* @return
+*		- XST_SUCCESS if the handler was installed
+*		- XST_INVALID_PARAM if HandlerType is not recognized
+*
+******************************************************************************/
+int XCanFd_SetHandler(XCanFd *InstancePtr, u32 HandlerType,
+		      void *CallBackFunc, void *CallBackRef)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(CallBackFunc != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	switch (HandlerType) {
+	case XCANFD_HANDLER_SEND:
+		InstancePtr->SendHandler =
+			(XCanFd_SendRecvHandler) CallBackFunc;
+		InstancePtr->SendRef = CallBackRef;
+		break;
+
+	case XCANFD_HANDLER_RECV:
+		InstancePtr->RecvHandler =
+			(XCanFd_SendRecvHandler) CallBackFunc;
+		InstancePtr->RecvRef = CallBackRef;
+		break;
+
+	case XCANFD_HANDLER_ERROR:
+		InstancePtr->ErrorHandler =
+			(XCanFd_ErrorHandler) CallBackFunc;
+		InstancePtr->ErrorRef = CallBackRef;
+		break;
+
+	case XCANFD_HANDLER_EVENT:
+		InstancePtr->EventHandler =
+			(XCanFd_EventHandler) CallBackFunc;
+		InstancePtr->EventRef = CallBackRef;
+		break;
+
+	default:
+		return XST_INVALID_PARAM;
+	}
+
+	return XST_SUCCESS;
+}
@@ -0,0 +1,243 @@
+/******************************************************************************
+* Host simulator build of the XGpio driver.
+*
+* Follows the standalone gpio driver (xgpio.c, xgpio_extra.c and
+* xgpio_intr.c). Channels are numbered 1 and 2.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xparameters.h"
+#include "xgpio.h"
+
+/************************** Variable Definitions *****************************/
+
+XGpio_Config XGpio_ConfigTable[XPAR_XGPIO_NUM_INSTANCES] = {
+	{
+		XPAR_GPIO_0_DEVICE_ID,
+		XPAR_GPIO_0_BASEADDR,
+		XPAR_GPIO_0_INTERRUPT_PRESENT,
+		XPAR_GPIO_0_IS_DUAL
+	}
+};
+
+/*****************************************************************************/
+/**
+*
+* Initialize the XGpio instance provided by the caller based on the
+* given DeviceID.
+*
+* @return
+*		- XST_SUCCESS if the initialization was successful.
+*		- XST_DEVICE_NOT_FOUND if the device configuration data was
+*		not found for a device with the supplied device ID.
+*
+******************************************************************************/
+int XGpio_Initialize(XGpio *InstancePtr, u16 DeviceId)
+{
+	XGpio_Config *ConfigPtr;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+
+	ConfigPtr = XGpio_LookupConfig(DeviceId);
+	if (ConfigPtr == (XGpio_Config *) NULL) {
+		InstancePtr->IsReady = 0;
+		return (XST_DEVICE_NOT_FOUND);
+	}
+
+	return XGpio_CfgInitialize(InstancePtr, ConfigPtr,
+				   ConfigPtr->BaseAddress);
+}
+
+XGpio_Config *XGpio_LookupConfig(u16 DeviceId)
+{
+	XGpio_Config *CfgPtr = NULL;
+	int Index;
+
+	for (Index = 0; Index < (int)XPAR_XGPIO_NUM_INSTANCES; Index++) {
+		if (XGpio_ConfigTable[Index].DeviceId == DeviceId) {
+			CfgPtr = &XGpio_ConfigTable[Index];
+			break;
+		}
+	}
+
+	return CfgPtr;
+}
+
+int XGpio_CfgInitialize(XGpio *InstancePtr, XGpio_Config *Config,
+			UINTPTR EffectiveAddr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+
+	InstancePtr->BaseAddress = EffectiveAddr;
+	InstancePtr->InterruptPresent = Config->InterruptPresent;
+	InstancePtr->IsDual = Config->IsDual;
+
+	InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+
+	return (XST_SUCCESS);
+}
+
+void XGpio_SetDataDirection(XGpio *InstancePtr, unsigned Channel,
+			    u32 DirectionMask)
+{
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid((Channel == 1) ||
+		       ((Channel == 2) && (InstancePtr->IsDual == TRUE)));
+
+	XGpio_WriteReg(InstancePtr->BaseAddress,
+		       ((Channel - 1) * XGPIO_CHAN_OFFSET) + XGPIO_TRI_OFFSET,
+		       DirectionMask);
+}
+
+u32 XGpio_GetDataDirection(XGpio *InstancePtr, unsigned Channel)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertNonvoid((Channel == 1) ||
+			  ((Channel == 2) && (InstancePtr->IsDual == TRUE)));
+
+	return XGpio_ReadReg(InstancePtr->BaseAddress,
+			     ((Channel - 1) * XGPIO_CHAN_OFFSET) +
+			     XGPIO_TRI_OFFSET);
+}
+
+u32 XGpio_DiscreteRead(XGpio *InstancePtr, unsigned Channel)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertNonvoid((Channel == 1) ||
+			  ((Channel == 2) && (InstancePtr->IsDual == TRUE)));
+
+	return XGpio_ReadReg(InstancePtr->BaseAddress,
+			     ((Channel - 1) * XGPIO_CHAN_OFFSET) +
+			     XGPIO_DATA_OFFSET);
+}
+
+void XGpio_DiscreteWrite(XGpio *InstancePtr, unsigned Channel, u32 Mask)
+{
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid((Channel == 1) ||
+		       ((Channel == 2) && (InstancePtr->IsDual == TRUE)));
+
+	XGpio_WriteReg(InstancePtr->BaseAddress,
+		       ((Channel - 1) * XGPIO_CHAN_OFFSET) + XGPIO_DATA_OFFSET,
+		       Mask);
+}
+
+void XGpio_DiscreteSet(XGpio *InstancePtr, unsigned Channel, u32 Mask)
+{
+	u32 Current;
+	unsigned DataOffset;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid((Channel == 1) ||
+		       ((Channel == 2) && (InstancePtr->IsDual == TRUE)));
+
+	DataOffset = ((Channel - 1) * XGPIO_CHAN_OFFSET) + XGPIO_DATA_OFFSET;
+	Current = XGpio_ReadReg(InstancePtr->BaseAddress, DataOffset);
+	Current |= Mask;
+	XGpio_WriteReg(InstancePtr->BaseAddress, DataOffset, Current);
+}
+
+void XGpio_DiscreteClear(XGpio *InstancePtr, unsigned Channel, u32 Mask)
+{
+	u32 Current;
+	unsigned DataOffset;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid((Channel == 1) ||
+		       ((Channel == 2) && (InstancePtr->IsDual == TRUE)));
+
+	DataOffset = ((Channel - 1) * XGPIO_CHAN_OFFSET) + XGPIO_DATA_OFFSET;
+	Current = XGpio_ReadReg(InstancePtr->BaseAddress, DataOffset);
+	Current &= ~Mask;
+	XGpio_WriteReg(InstancePtr->BaseAddress, DataOffset, Current);
+}
+
+void XGpio_InterruptGlobalEnable(XGpio *InstancePtr)
+{
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid(InstancePtr->InterruptPresent == TRUE);
+
+	XGpio_WriteReg(InstancePtr->BaseAddress, XGPIO_GIE_OFFSET,
+		       XGPIO_GIE_GINTR_ENABLE_MASK);
+}
+
+void XGpio_InterruptGlobalDisable(XGpio *InstancePtr)
+{
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid(InstancePtr->InterruptPresent == TRUE);
+
+	XGpio_WriteReg(InstancePtr->BaseAddress, XGPIO_GIE_OFFSET, 0x0);
+}
+
+void XGpio_InterruptEnable(XGpio *InstancePtr, u32 Mask)
+{
+	u32 Register;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid(InstancePtr->InterruptPresent == TRUE);
+
+	Register = XGpio_ReadReg(InstancePtr->BaseAddress, XGPIO_IER_OFFSET);
+	XGpio_WriteReg(InstancePtr->BaseAddress, XGPIO_IER_OFFSET,
+		       Register | Mask);
+}
+
+void XGpio_InterruptDisable(XGpio *InstancePtr, u32 Mask)
+{
+	u32 Register;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid(InstancePtr->InterruptPresent == TRUE);
+
+	Register = XGpio_ReadReg(InstancePtr->BaseAddress, XGPIO_IER_OFFSET);
+	XGpio_WriteReg(InstancePtr->BaseAddress, XGPIO_IER_OFFSET,
+		       Register & (~Mask));
+}
+
+/*****************************************************************************/
+/**
+*
+* Clears pending interrupt(s) with the provided mask. IP_ISR is
+* toggle-on-write, so only bits that are currently set are written.
+*
+******************************************************************************/
+void XGpio_InterruptClear(XGpio *InstancePtr, u32 Mask)
+{
+	u32 Register;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid(InstancePtr->InterruptPresent == TRUE);
+
+	Register = XGpio_ReadReg(InstancePtr->BaseAddress, XGPIO_ISR_OFFSET);
+	XGpio_WriteReg(InstancePtr->BaseAddress, XGPIO_ISR_OFFSET,
+		       Register & Mask);
+}
+
+u32 XGpio_InterruptGetEnabled(XGpio *InstancePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertNonvoid(InstancePtr->InterruptPresent == TRUE);
+
+	return XGpio_ReadReg(InstancePtr->BaseAddress, XGPIO_IER_OFFSET);
+}
+
+u32 XGpio_InterruptGetStatus(XGpio *InstancePtr)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertNonvoid(InstancePtr->InterruptPresent == TRUE);
+
+	return XGpio_ReadReg(InstancePtr->BaseAddress, XGPIO_ISR_OFFSET);
+}
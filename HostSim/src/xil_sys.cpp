@@ -0,0 +1,86 @@
+/******************************************************************************
+* Standalone BSP support routines: assertions and xil_printf.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "xil_assert.h"
+#include "xil_printf.h"
+
+/************************** Variable Definitions *****************************/
+
+u32 Xil_AssertStatus;
+
+/*
+ * On the board a non-zero Xil_AssertWait makes a failed assertion spin
+ * forever. On the host the run is aborted instead.
+ */
+s32 Xil_AssertWait = 1;
+
+static Xil_AssertCallback Xil_AssertCallbackRoutine;
+
+/*****************************************************************************/
+/**
+*
+* Implements assert. Currently, it calls a user-defined callback function
+* if one has been set. Then, it aborts the run if Xil_AssertWait is set.
+*
+* @param	File is the name of the filename of the source
+* @param	Line is the linenumber within File
+*
+* @return	None.
+*
+******************************************************************************/
+void Xil_Assert(const char8 *File, s32 Line)
+{
+	if (Xil_AssertCallbackRoutine != NULL) {
+		(*Xil_AssertCallbackRoutine)(File, Line);
+	}
+
+	if (Xil_AssertWait != 0) {
+		fflush(stdout);
+		fprintf(stderr, "Xil_Assert: %s:%d\n", File, (int)Line);
+		abort();
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets up a callback function to be invoked when an assert occurs.
+*
+* @param	Routine is the callback to be invoked when an assert is taken
+*
+* @return	None.
+*
+******************************************************************************/
+void Xil_AssertSetCallback(Xil_AssertCallback Routine)
+{
+	Xil_AssertCallbackRoutine = Routine;
+}
+
+void xil_printf(const char8 *ctrl1, ...)
+{
+	va_list Args;
+
+	va_start(Args, ctrl1);
+	vprintf(ctrl1, Args);
+	va_end(Args);
+	fflush(stdout);
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes one byte to the STDOUT UART, here the host standard output. Binary
+* data passes through unchanged.
+*
+******************************************************************************/
+void outbyte(char8 c)
+{
+	putchar((unsigned char)c);
+}
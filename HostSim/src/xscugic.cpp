@@ -0,0 +1,287 @@
+/******************************************************************************
+* Host simulator build of the XScuGic driver.
+*
+* Follows the standalone scugic driver: every access goes through the
+* distributor and CPU interface registers of the simulated GIC.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xparameters.h"
+#include "xscugic.h"
+
+/************************** Constant Definitions *****************************/
+
+#define DEFAULT_PRIORITY	0xa0a0a0a0U
+#define XSCUGIC_INTR_PRIO_MASK	0x000000F8U
+
+/************************** Variable Definitions *****************************/
+
+XScuGic_Config XScuGic_ConfigTable[XPAR_XSCUGIC_NUM_INSTANCES] = {
+	{
+		XPAR_PS7_SCUGIC_0_DEVICE_ID,
+		XPAR_PS7_SCUGIC_0_BASEADDR,
+		XPAR_PS7_SCUGIC_0_DIST_BASEADDR,
+		{{0}}
+	}
+};
+
+/*****************************************************************************/
+/**
+*
+* Default handler for interrupts that have no handler connected. Counts the
+* interrupt as unhandled.
+*
+******************************************************************************/
+static void StubHandler(void *CallBackRef)
+{
+	Xil_AssertVoid(CallBackRef != NULL);
+
+	((XScuGic *)CallBackRef)->UnhandledInterrupts++;
+}
+
+/*****************************************************************************/
+/**
+*
+* Initializes the distributor: all SPIs level sensitive, default priority,
+* targeted at CPU0 and disabled.
+*
+******************************************************************************/
+static void DistributorInit(XScuGic *InstancePtr)
+{
+	u32 Int_Id;
+
+	XScuGic_DistWriteReg(InstancePtr, XSCUGIC_DIST_EN_OFFSET, 0U);
+
+	for (Int_Id = 32U; Int_Id < XSCUGIC_MAX_NUM_INTR_INPUTS;
+	     Int_Id = Int_Id + 16U) {
+		XScuGic_DistWriteReg(InstancePtr,
+				     XSCUGIC_INT_CFG_OFFSET_CALC(Int_Id), 0U);
+	}
+
+	for (Int_Id = 0U; Int_Id < XSCUGIC_MAX_NUM_INTR_INPUTS;
+	     Int_Id = Int_Id + 4U) {
+		XScuGic_DistWriteReg(InstancePtr,
+				     XSCUGIC_PRIORITY_OFFSET_CALC(Int_Id),
+				     DEFAULT_PRIORITY);
+	}
+
+	for (Int_Id = 32U; Int_Id < XSCUGIC_MAX_NUM_INTR_INPUTS;
+	     Int_Id = Int_Id + 4U) {
+		XScuGic_DistWriteReg(InstancePtr,
+				     XSCUGIC_SPI_TARGET_OFFSET_CALC(Int_Id),
+				     0x01010101U);
+	}
+
+	for (Int_Id = 0U; Int_Id < XSCUGIC_MAX_NUM_INTR_INPUTS;
+	     Int_Id = Int_Id + 32U) {
+		XScuGic_DistWriteReg(InstancePtr,
+			XSCUGIC_EN_DIS_OFFSET_CALC(XSCUGIC_DISABLE_OFFSET,
+						   Int_Id),
+			0xFFFFFFFFU);
+	}
+
+	XScuGic_DistWriteReg(InstancePtr, XSCUGIC_DIST_EN_OFFSET,
+			     XSCUGIC_EN_INT_MASK);
+}
+
+/*****************************************************************************/
+/**
+*
+* Initializes the CPU interface: accept every priority and enable
+* signalling of both secure and non-secure interrupts.
+*
+******************************************************************************/
+static void CPUInitialize(XScuGic *InstancePtr)
+{
+	XScuGic_CPUWriteReg(InstancePtr, XSCUGIC_CPU_PRIOR_OFFSET, 0xF0U);
+	XScuGic_CPUWriteReg(InstancePtr, XSCUGIC_CONTROL_OFFSET, 0x07U);
+}
+
+s32 XScuGic_CfgInitialize(XScuGic *InstancePtr, XScuGic_Config *ConfigPtr,
+			  u32 EffectiveAddr)
+{
+	u32 Int_Id;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(ConfigPtr != NULL);
+	(void)EffectiveAddr;
+
+	if (InstancePtr->IsReady != XIL_COMPONENT_IS_READY) {
+		InstancePtr->IsReady = 0U;
+		InstancePtr->Config = ConfigPtr;
+
+		for (Int_Id = 0U; Int_Id < XSCUGIC_MAX_NUM_INTR_INPUTS;
+		     Int_Id++) {
+			if (InstancePtr->Config->HandlerTable[Int_Id].Handler ==
+			    NULL) {
+				InstancePtr->Config->HandlerTable[Int_Id].Handler =
+					StubHandler;
+			}
+			InstancePtr->Config->HandlerTable[Int_Id].CallBackRef =
+				InstancePtr;
+		}
+
+		DistributorInit(InstancePtr);
+		CPUInitialize(InstancePtr);
+
+		InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+	}
+
+	return XST_SUCCESS;
+}
+
+XScuGic_Config *XScuGic_LookupConfig(u16 DeviceId)
+{
+	XScuGic_Config *CfgPtr = NULL;
+	u32 Index;
+
+	for (Index = 0U; Index < XPAR_XSCUGIC_NUM_INSTANCES; Index++) {
+		if (XScuGic_ConfigTable[Index].DeviceId == DeviceId) {
+			CfgPtr = &XScuGic_ConfigTable[Index];
+			break;
+		}
+	}
+
+	return CfgPtr;
+}
+
+s32 XScuGic_Connect(XScuGic *InstancePtr, u32 Int_Id,
+		    Xil_InterruptHandler Handler, void *CallBackRef)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(Int_Id < XSCUGIC_MAX_NUM_INTR_INPUTS);
+	Xil_AssertNonvoid(Handler != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	InstancePtr->Config->HandlerTable[Int_Id].Handler = Handler;
+	InstancePtr->Config->HandlerTable[Int_Id].CallBackRef = CallBackRef;
+
+	return XST_SUCCESS;
+}
+
+void XScuGic_Disconnect(XScuGic *InstancePtr, u32 Int_Id)
+{
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(Int_Id < XSCUGIC_MAX_NUM_INTR_INPUTS);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	XScuGic_Disable(InstancePtr, Int_Id);
+
+	InstancePtr->Config->HandlerTable[Int_Id].Handler = StubHandler;
+	InstancePtr->Config->HandlerTable[Int_Id].CallBackRef = InstancePtr;
+}
+
+void XScuGic_Enable(XScuGic *InstancePtr, u32 Int_Id)
+{
+	u32 Mask;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(Int_Id < XSCUGIC_MAX_NUM_INTR_INPUTS);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	Mask = 0x00000001U << (Int_Id % 32U);
+	XScuGic_DistWriteReg(InstancePtr, (u32)XSCUGIC_ENABLE_SET_OFFSET +
+			     ((Int_Id / 32U) * 4U), Mask);
+}
+
+void XScuGic_Disable(XScuGic *InstancePtr, u32 Int_Id)
+{
+	u32 Mask;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(Int_Id < XSCUGIC_MAX_NUM_INTR_INPUTS);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	Mask = 0x00000001U << (Int_Id % 32U);
+	XScuGic_DistWriteReg(InstancePtr, (u32)XSCUGIC_DISABLE_OFFSET +
+			     ((Int_Id / 32U) * 4U), Mask);
+}
+
+void XScuGic_SetPriorityTriggerType(XScuGic *InstancePtr, u32 Int_Id,
+				    u8 Priority, u8 Trigger)
+{
+	u32 RegValue;
+	u8 LocalPriority = Priority;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid(Int_Id < XSCUGIC_MAX_NUM_INTR_INPUTS);
+	Xil_AssertVoid(Trigger <= (u8)XSCUGIC_INT_CFG_MASK);
+
+	RegValue = XScuGic_DistReadReg(InstancePtr,
+				       XSCUGIC_PRIORITY_OFFSET_CALC(Int_Id));
+
+	/* Only the upper five bits of the priority are implemented */
+	LocalPriority = LocalPriority & (u8)XSCUGIC_INTR_PRIO_MASK;
+	RegValue &= ~(XSCUGIC_PRIORITY_MASK << ((Int_Id % 4U) * 8U));
+	RegValue |= (u32)LocalPriority << ((Int_Id % 4U) * 8U);
+
+	XScuGic_DistWriteReg(InstancePtr, XSCUGIC_PRIORITY_OFFSET_CALC(Int_Id),
+			     RegValue);
+
+	RegValue = XScuGic_DistReadReg(InstancePtr,
+				       XSCUGIC_INT_CFG_OFFSET_CALC(Int_Id));
+
+	RegValue &= ~(XSCUGIC_INT_CFG_MASK << ((Int_Id % 16U) * 2U));
+	RegValue |= (u32)Trigger << ((Int_Id % 16U) * 2U);
+
+	XScuGic_DistWriteReg(InstancePtr, XSCUGIC_INT_CFG_OFFSET_CALC(Int_Id),
+			     RegValue);
+}
+
+void XScuGic_GetPriorityTriggerType(XScuGic *InstancePtr, u32 Int_Id,
+				    u8 *Priority, u8 *Trigger)
+{
+	u32 RegValue;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid(Int_Id < XSCUGIC_MAX_NUM_INTR_INPUTS);
+	Xil_AssertVoid(Priority != NULL);
+	Xil_AssertVoid(Trigger != NULL);
+
+	RegValue = XScuGic_DistReadReg(InstancePtr,
+				       XSCUGIC_PRIORITY_OFFSET_CALC(Int_Id));
+	RegValue = RegValue >> ((Int_Id % 4U) * 8U);
+	*Priority = (u8)(RegValue & XSCUGIC_PRIORITY_MASK);
+
+	RegValue = XScuGic_DistReadReg(InstancePtr,
+				       XSCUGIC_INT_CFG_OFFSET_CALC(Int_Id));
+	RegValue = RegValue >> ((Int_Id % 16U) * 2U);
+	*Trigger = (u8)(RegValue & XSCUGIC_INT_CFG_MASK);
+}
+
+/*****************************************************************************/
+/**
+*
+* The IRQ exception handler: acknowledges the highest priority pending
+* interrupt, calls the handler connected to it and signals end of
+* interrupt.
+*
+* @param	InstancePtr is a pointer to the XScuGic instance.
+*
+* @return	None.
+*
+******************************************************************************/
+void XScuGic_InterruptHandler(XScuGic *InstancePtr)
+{
+	XScuGic_VectorTableEntry *TablePtr;
+	u32 InterruptID;
+	u32 IntIDFull;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+
+	IntIDFull = XScuGic_CPUReadReg(InstancePtr, XSCUGIC_INT_ACK_OFFSET);
+	InterruptID = IntIDFull & XSCUGIC_ACK_INTID_MASK;
+
+	if (XSCUGIC_MAX_NUM_INTR_INPUTS <= InterruptID) {
+		/* Spurious interrupt, nothing to acknowledge */
+		return;
+	}
+
+	TablePtr = &(InstancePtr->Config->HandlerTable[InterruptID]);
+	TablePtr->Handler(TablePtr->CallBackRef);
+
+	XScuGic_CPUWriteReg(InstancePtr, XSCUGIC_EOI_OFFSET, IntIDFull);
+}
@@ -0,0 +1,430 @@
+/******************************************************************************
+* Host simulator build of the XTmrCtr driver.
+*
+* Follows the standalone tmrctr driver (xtmrctr.c, xtmrctr_options.c,
+* xtmrctr_stats.c and xtmrctr_intr.c) register access for register access,
+* so access counts measured on the simulator match the board.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xparameters.h"
+#include "xtmrctr.h"
+
+/**************************** Type Definitions *******************************/
+
+/*
+ * Maps each option to the bits that implement it in the control/status
+ * register.
+ */
+typedef struct {
+	u32 Option;
+	u32 Mask;
+} Mapping;
+
+/************************** Variable Definitions *****************************/
+
+u8 XTmrCtr_Offsets[XTC_DEVICE_TIMER_COUNT] = { 0, XTC_TIMER_COUNTER_OFFSET };
+
+XTmrCtr_Config XTmrCtr_ConfigTable[XPAR_XTMRCTR_NUM_INSTANCES] = {
+	{
+		XPAR_TMRCTR_0_DEVICE_ID,
+		XPAR_TMRCTR_0_BASEADDR,
+		XPAR_TMRCTR_0_CLOCK_FREQ_HZ
+	},
+	{
+		XPAR_TMRCTR_1_DEVICE_ID,
+		XPAR_TMRCTR_1_BASEADDR,
+		XPAR_TMRCTR_1_CLOCK_FREQ_HZ
+	},
+	{
+		XPAR_TMRCTR_2_DEVICE_ID,
+		XPAR_TMRCTR_2_BASEADDR,
+		XPAR_TMRCTR_2_CLOCK_FREQ_HZ
+	}
+};
+
+static Mapping OptionsTable[] = {
+	{XTC_CASCADE_MODE_OPTION, XTC_CSR_CASC_MASK},
+	{XTC_ENABLE_ALL_OPTION, XTC_CSR_ENABLE_ALL_MASK},
+	{XTC_DOWN_COUNT_OPTION, XTC_CSR_DOWN_COUNT_MASK},
+	{XTC_CAPTURE_MODE_OPTION, XTC_CSR_CAPTURE_MODE_MASK |
+				  XTC_CSR_EXT_CAPTURE_MASK},
+	{XTC_INT_MODE_OPTION, XTC_CSR_ENABLE_INT_MASK},
+	{XTC_AUTO_RELOAD_OPTION, XTC_CSR_AUTO_RELOAD_MASK},
+	{XTC_EXT_COMPARE_OPTION, XTC_CSR_EXT_GENERATE_MASK}
+};
+
+#define XTC_NUM_OPTIONS	(sizeof(OptionsTable) / sizeof(Mapping))
+
+/*****************************************************************************/
+/**
+*
+* Initializes a specific timer/counter instance/driver. Initialize fields
+* of the XTmrCtr structure, then reset the timer/counter.
+*
+* @param	InstancePtr is a pointer to the XTmrCtr instance.
+* @param	DeviceId is the unique id of the device controlled by this
+*		XTmrCtr component.
+*
+* @return
+*		- XST_SUCCESS if initialization was successful
+*		- XST_DEVICE_IS_STARTED if the device has already been started
+*		- XST_DEVICE_NOT_FOUND if the device doesn't exist
+*
+******************************************************************************/
+int XTmrCtr_Initialize(XTmrCtr *InstancePtr, u16 DeviceId)
+{
+	XTmrCtr_Config *ConfigPtr;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+
+	if (InstancePtr->IsReady == XIL_COMPONENT_IS_READY) {
+		return XST_DEVICE_IS_STARTED;
+	}
+
+	ConfigPtr = XTmrCtr_LookupConfig(DeviceId);
+	if (ConfigPtr == (XTmrCtr_Config *) NULL) {
+		return XST_DEVICE_NOT_FOUND;
+	}
+
+	XTmrCtr_CfgInitialize(InstancePtr, ConfigPtr, ConfigPtr->BaseAddress);
+
+	return XTmrCtr_InitHw(InstancePtr);
+}
+
+XTmrCtr_Config *XTmrCtr_LookupConfig(u16 DeviceId)
+{
+	XTmrCtr_Config *CfgPtr = NULL;
+	int Index;
+
+	for (Index = 0; Index < (int)XPAR_XTMRCTR_NUM_INSTANCES; Index++) {
+		if (XTmrCtr_ConfigTable[Index].DeviceId == DeviceId) {
+			CfgPtr = &XTmrCtr_ConfigTable[Index];
+			break;
+		}
+	}
+
+	return CfgPtr;
+}
+
+void XTmrCtr_CfgInitialize(XTmrCtr *InstancePtr, XTmrCtr_Config *ConfigPtr,
+			   UINTPTR EffectiveAddr)
+{
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(ConfigPtr != NULL);
+	Xil_AssertVoid(EffectiveAddr != 0x0);
+
+	InstancePtr->IsReady = 0;
+	InstancePtr->Config = *ConfigPtr;
+
+	InstancePtr->Config.BaseAddress = EffectiveAddr;
+	InstancePtr->BaseAddress = EffectiveAddr;
+
+	InstancePtr->Handler = NULL;
+	InstancePtr->CallBackRef = NULL;
+
+	InstancePtr->IsStartedTmrCtr0 = 0;
+	InstancePtr->IsStartedTmrCtr1 = 0;
+
+	InstancePtr->Stats.Interrupts = 0;
+
+	InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+}
+
+/*****************************************************************************/
+/**
+*
+* (Re-)initializes all timer counters: load register cleared, counter
+* loaded from it and control/status register cleared.
+*
+* @return
+*		- XST_SUCCESS if the timer counters were initialized
+*		- XST_DEVICE_IS_STARTED if a timer counter is running
+*
+******************************************************************************/
+int XTmrCtr_InitHw(XTmrCtr *InstancePtr)
+{
+	int Status = XST_FAILURE;
+	u8 TmrIndex;
+	u32 TmrCtrStarted[XTC_DEVICE_TIMER_COUNT];
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+
+	TmrCtrStarted[0] = InstancePtr->IsStartedTmrCtr0;
+	TmrCtrStarted[1] = InstancePtr->IsStartedTmrCtr1;
+
+	for (TmrIndex = 0; TmrIndex < XTC_DEVICE_TIMER_COUNT; TmrIndex++) {
+		if (TmrCtrStarted[TmrIndex] == XIL_COMPONENT_IS_STARTED) {
+			Status = XST_DEVICE_IS_STARTED;
+			continue;
+		}
+
+		XTmrCtr_WriteReg(InstancePtr->BaseAddress, TmrIndex,
+				 XTC_TLR_OFFSET, 0);
+		XTmrCtr_WriteReg(InstancePtr->BaseAddress, TmrIndex,
+				 XTC_TCSR_OFFSET,
+				 XTC_CSR_INT_OCCURED_MASK | XTC_CSR_LOAD_MASK);
+		XTmrCtr_WriteReg(InstancePtr->BaseAddress, TmrIndex,
+				 XTC_TCSR_OFFSET, 0);
+
+		Status = XST_SUCCESS;
+	}
+
+	return Status;
+}
+
+/*****************************************************************************/
+/**
+*
+* Starts the specified counter of the device such that it starts running.
+* The timer counter is reset before it is started and the reset value is
+* loaded into the timer counter.
+*
+******************************************************************************/
+void XTmrCtr_Start(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	u32 ControlStatusReg;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(TmrCtrNumber < XTC_DEVICE_TIMER_COUNT);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	ControlStatusReg = XTmrCtr_ReadReg(InstancePtr->BaseAddress,
+					   TmrCtrNumber, XTC_TCSR_OFFSET);
+
+	/* Reset the timer counter so it loads the reset value */
+	XTmrCtr_WriteReg(InstancePtr->BaseAddress, TmrCtrNumber,
+			 XTC_TCSR_OFFSET, XTC_CSR_LOAD_MASK);
+
+	if (TmrCtrNumber == 0) {
+		InstancePtr->IsStartedTmrCtr0 = XIL_COMPONENT_IS_STARTED;
+	} else {
+		InstancePtr->IsStartedTmrCtr1 = XIL_COMPONENT_IS_STARTED;
+	}
+
+	/* Remove the reset condition such that the counter starts running */
+	XTmrCtr_WriteReg(InstancePtr->BaseAddress, TmrCtrNumber,
+			 XTC_TCSR_OFFSET,
+			 ControlStatusReg | XTC_CSR_ENABLE_TMR_MASK);
+}
+
+void XTmrCtr_Stop(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	u32 ControlStatusReg;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(TmrCtrNumber < XTC_DEVICE_TIMER_COUNT);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	ControlStatusReg = XTmrCtr_ReadReg(InstancePtr->BaseAddress,
+					   TmrCtrNumber, XTC_TCSR_OFFSET);
+
+	ControlStatusReg &= (u32)~(XTC_CSR_ENABLE_TMR_MASK);
+
+	XTmrCtr_WriteReg(InstancePtr->BaseAddress, TmrCtrNumber,
+			 XTC_TCSR_OFFSET, ControlStatusReg);
+
+	if (TmrCtrNumber == 0) {
+		InstancePtr->IsStartedTmrCtr0 = 0;
+	} else {
+		InstancePtr->IsStartedTmrCtr1 = 0;
+	}
+}
+
+u32 XTmrCtr_GetValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(TmrCtrNumber < XTC_DEVICE_TIMER_COUNT);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	return XTmrCtr_GetTimerCounterReg(InstancePtr->BaseAddress,
+					  TmrCtrNumber);
+}
+
+void XTmrCtr_SetResetValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber,
+			   u32 ResetValue)
+{
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(TmrCtrNumber < XTC_DEVICE_TIMER_COUNT);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	XTmrCtr_WriteReg(InstancePtr->BaseAddress, TmrCtrNumber,
+			 XTC_TLR_OFFSET, ResetValue);
+}
+
+u32 XTmrCtr_GetCaptureValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(TmrCtrNumber < XTC_DEVICE_TIMER_COUNT);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	return XTmrCtr_ReadReg(InstancePtr->BaseAddress, TmrCtrNumber,
+			       XTC_TLR_OFFSET);
+}
+
+void XTmrCtr_Reset(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	u32 CounterControlReg;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(TmrCtrNumber < XTC_DEVICE_TIMER_COUNT);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	CounterControlReg = XTmrCtr_ReadReg(InstancePtr->BaseAddress,
+					    TmrCtrNumber, XTC_TCSR_OFFSET);
+
+	XTmrCtr_WriteReg(InstancePtr->BaseAddress, TmrCtrNumber,
+			 XTC_TCSR_OFFSET,
+			 CounterControlReg | XTC_CSR_LOAD_MASK);
+	XTmrCtr_WriteReg(InstancePtr->BaseAddress, TmrCtrNumber,
+			 XTC_TCSR_OFFSET, CounterControlReg);
+}
+
+int XTmrCtr_IsExpired(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	u32 CounterControlReg;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(TmrCtrNumber < XTC_DEVICE_TIMER_COUNT);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	CounterControlReg = XTmrCtr_ReadReg(InstancePtr->BaseAddress,
+					    TmrCtrNumber, XTC_TCSR_OFFSET);
+
+	return ((CounterControlReg & XTC_CSR_INT_OCCURED_MASK) ==
+		XTC_CSR_INT_OCCURED_MASK);
+}
+
+/*****************************************************************************/
+/**
+*
+* Enables the specified options for the specified timer counter. Options
+* not given are disabled. The control/status register is rewritten as a
+* whole.
+*
+******************************************************************************/
+void XTmrCtr_SetOptions(XTmrCtr *InstancePtr, u8 TmrCtrNumber, u32 Options)
+{
+	u32 CounterControlReg = 0;
+	u32 Index;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(TmrCtrNumber < XTC_DEVICE_TIMER_COUNT);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	for (Index = 0; Index < XTC_NUM_OPTIONS; Index++) {
+		if (Options & OptionsTable[Index].Option) {
+			CounterControlReg |= OptionsTable[Index].Mask;
+		} else {
+			CounterControlReg &= ~OptionsTable[Index].Mask;
+		}
+	}
+
+	XTmrCtr_WriteReg(InstancePtr->BaseAddress, TmrCtrNumber,
+			 XTC_TCSR_OFFSET, CounterControlReg);
+}
+
+u32 XTmrCtr_GetOptions(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	u32 Options = 0;
+	u32 CounterControlReg;
+	u32 Index;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(TmrCtrNumber < XTC_DEVICE_TIMER_COUNT);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	CounterControlReg = XTmrCtr_ReadReg(InstancePtr->BaseAddress,
+					    TmrCtrNumber, XTC_TCSR_OFFSET);
+
+	for (Index = 0; Index < XTC_NUM_OPTIONS; Index++) {
+		if (CounterControlReg & OptionsTable[Index].Mask) {
+			Options |= OptionsTable[Index].Option;
+		}
+	}
+
+	return Options;
+}
+
+void XTmrCtr_GetStats(XTmrCtr *InstancePtr, XTmrCtrStats *StatsPtr)
+{
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(StatsPtr != NULL);
+
+	StatsPtr->Interrupts = InstancePtr->Stats.Interrupts;
+}
+
+void XTmrCtr_ClearStats(XTmrCtr *InstancePtr)
+{
+	Xil_AssertVoid(InstancePtr != NULL);
+
+	InstancePtr->Stats.Interrupts = 0;
+}
+
+void XTmrCtr_SetHandler(XTmrCtr *InstancePtr, XTmrCtr_Handler FuncPtr,
+			void *CallBackRef)
+{
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(FuncPtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	InstancePtr->Handler = FuncPtr;
+	InstancePtr->CallBackRef = CallBackRef;
+}
+
+/*****************************************************************************/
+/**
+*
+* Interrupt Service Routine (ISR) for the driver. Checks each timer counter
+* of the device, calls the user handler for every one that has expired and
+* acknowledges the interrupt. A single shot timer in compare mode is
+* stopped and reloaded so that its interrupt can be acknowledged.
+*
+* @param	InstancePtr contains a pointer to the timer/counter instance
+*		for the interrupt.
+*
+* @return	None.
+*
+******************************************************************************/
+void XTmrCtr_InterruptHandler(void *InstancePtr)
+{
+	XTmrCtr *TmrCtrPtr = NULL;
+	u8 TmrCtrNumber;
+	u32 ControlStatusReg;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+
+	TmrCtrPtr = (XTmrCtr *) InstancePtr;
+
+	for (TmrCtrNumber = 0; TmrCtrNumber < XTC_DEVICE_TIMER_COUNT;
+	     TmrCtrNumber++) {
+		ControlStatusReg = XTmrCtr_ReadReg(TmrCtrPtr->BaseAddress,
+						   TmrCtrNumber,
+						   XTC_TCSR_OFFSET);
+
+		if (!(ControlStatusReg & XTC_CSR_ENABLE_INT_MASK) ||
+		    !(ControlStatusReg & XTC_CSR_INT_OCCURED_MASK)) {
+			continue;
+		}
+
+		TmrCtrPtr->Stats.Interrupts++;
+		TmrCtrPtr->Handler(TmrCtrPtr->CallBackRef, TmrCtrNumber);
+
+		ControlStatusReg = XTmrCtr_ReadReg(TmrCtrPtr->BaseAddress,
+						   TmrCtrNumber,
+						   XTC_TCSR_OFFSET);
+
+		if (((ControlStatusReg & XTC_CSR_AUTO_RELOAD_MASK) == 0) &&
+		    ((ControlStatusReg & XTC_CSR_CAPTURE_MODE_MASK) == 0)) {
+			ControlStatusReg &= (u32)~XTC_CSR_ENABLE_TMR_MASK;
+			XTmrCtr_WriteReg(TmrCtrPtr->BaseAddress, TmrCtrNumber,
+					 XTC_TCSR_OFFSET,
+					 ControlStatusReg | XTC_CSR_LOAD_MASK);
+		}
+
+		XTmrCtr_WriteReg(TmrCtrPtr->BaseAddress, TmrCtrNumber,
+				 XTC_TCSR_OFFSET,
+				 ControlStatusReg | XTC_CSR_INT_OCCURED_MASK);
+	}
+}
@@ -0,0 +1,307 @@
+/******************************************************************************
+* Host converter for CAN capture logs
+*
+* Works on the binary log of Tut10/can_log.h, a header and fixed-size
+* records that this tool maps and reads in place:
+*
+*	build/Can_code > can.out
+*	build/canlog extract can.out can.log	pull the log CanLog_Flush
+*						wrote out of the output
+*	build/canlog dump can.log [can0]	print it as candump -L text
+*	build/canlog import in.txt can.log	build one from candump -L
+*
+* candump -L lines look like "(1436509052.249713) can0 123#DEADBEEF", with
+* eight hex digits for an extended ID and "#R" for a remote frame. Imported
+* logs keep the candump microseconds, ClockHz 1000000.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "can_log.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Rate of the timestamps of imported logs, those of candump */
+#define CANLOG_IMPORT_HZ		1000000U
+
+/*****************************************************************************/
+
+/* The checks of CanLog_IsValid, which is target code */
+static int IsValid(const CanLog_Header *LogPtr, size_t Size)
+{
+	return (Size >= sizeof(CanLog_Header)) &&
+	       (LogPtr->Magic == CAN_LOG_MAGIC) &&
+	       (LogPtr->Version == CAN_LOG_VERSION) &&
+	       (LogPtr->RecordSize == sizeof(CanLog_Record)) &&
+	       (LogPtr->ClockHz != 0U) &&
+	       (LogPtr->NumRecords <= (Size - sizeof(CanLog_Header)) /
+				      sizeof(CanLog_Record));
+}
+
+/* Maps a whole file read-only, NULL if it cannot */
+static const u8 *MapFile(const char *Path, size_t *SizePtr)
+{
+	struct stat Info;
+	void *Data;
+	int Fd;
+
+	Fd = open(Path, O_RDONLY);
+	if (Fd < 0 || fstat(Fd, &Info) != 0) {
+		perror(Path);
+		return NULL;
+	}
+	*SizePtr = (size_t)Info.st_size;
+	Data = (Info.st_size == 0) ? NULL :
+	       mmap(NULL, *SizePtr, PROT_READ, MAP_PRIVATE, Fd, 0);
+	close(Fd);
+	if (Data == MAP_FAILED || Data == NULL) {
+		fprintf(stderr, "%s: cannot map\n", Path);
+		return NULL;
+	}
+
+	return (const u8 *)Data;
+}
+
+static int WriteLog(const char *Path, const CanLog_Header *LogPtr)
+{
+	FILE *Out = fopen(Path, "wb");
+	size_t Size = CAN_LOG_SIZE(LogPtr->NumRecords);
+
+	if (Out == NULL) {
+		perror(Path);
+		return 1;
+	}
+	if (fwrite(LogPtr, 1, Size, Out) != Size || fclose(Out) != 0) {
+		perror(Path);
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Finds the first log image in the output of a program */
+static int Extract(const char *InPath, const char *OutPath)
+{
+	size_t Size;
+	const u8 *Data = MapFile(InPath, &Size);
+	CanLog_Header Header;
+	size_t Pos;
+
+	if (Data == NULL) {
+		return 1;
+	}
+
+	for (Pos = 0; Pos + sizeof(Header) <= Size; Pos++) {
+		/* The image may sit at any offset, copy out the header */
+		memcpy(&Header, Data + Pos, sizeof(Header));
+		if (!IsValid(&Header, Size - Pos)) {
+			continue;
+		}
+
+		/* Copied, for the alignment of the records */
+		std::vector<u64> Image((CAN_LOG_SIZE(Header.NumRecords) + 7U) /
+				       8U);
+
+		memcpy(Image.data(), Data + Pos,
+		       CAN_LOG_SIZE(Header.NumRecords));
+		fprintf(stderr, "canlog: %u frames, %u dropped, at offset "
+			"%zu\n", Header.NumRecords, Header.Dropped, Pos);
+		return WriteLog(OutPath, (const CanLog_Header *)Image.data());
+	}
+
+	fprintf(stderr, "%s: no capture log found\n", InPath);
+	return 1;
+}
+
+/* Prints a log as candump -L lines, reading the mapped file in place */
+static int Dump(const char *InPath, const char *Interface)
+{
+	size_t Size;
+	const u8 *Data = MapFile(InPath, &Size);
+	const CanLog_Header *LogPtr = (const CanLog_Header *)Data;
+	const CanLog_Record *RecordPtr;
+	u32 Index;
+
+	if (Data == NULL) {
+		return 1;
+	}
+	if (!IsValid(LogPtr, Size)) {
+		fprintf(stderr, "%s: not a CAN capture log\n", InPath);
+		return 1;
+	}
+
+	RecordPtr = CanLog_Records(LogPtr);
+	for (Index = 0; Index < LogPtr->NumRecords; Index++) {
+		const u32 *FramePtr = RecordPtr[Index].Frame;
+		const u8 *DataPtr = (const u8 *)&FramePtr[2];
+		u64 Ticks = RecordPtr[Index].Ticks;
+		u32 Idr = FramePtr[0];
+		u32 Dlc = (FramePtr[1] & XCAN_DLCR_DLC_MASK) >>
+			  XCAN_DLCR_DLC_SHIFT;
+		u32 Id1 = (Idr & XCAN_IDR_ID1_MASK) >> XCAN_IDR_ID1_SHIFT;
+		int Remote;
+		u32 Byte;
+
+		printf("(%llu.%06llu) %s ",
+		       (unsigned long long)(Ticks / LogPtr->ClockHz),
+		       (unsigned long long)((Ticks % LogPtr->ClockHz) *
+					    1000000ULL / LogPtr->ClockHz),
+		       Interface);
+		if (Idr & XCAN_IDR_IDE_MASK) {
+			u32 Id2 = (Idr & XCAN_IDR_ID2_MASK) >> XCAN_IDR_ID2_SHIFT;
+
+			printf("%08X#", (Id1 << 18) | Id2);
+			Remote = (Idr & XCAN_IDR_RTR_MASK) != 0U;
+		} else {
+			printf("%03X#", Id1);
+			Remote = (Idr & XCAN_IDR_SRR_MASK) != 0U;
+		}
+		if (Remote) {
+			printf("R\n");
+			continue;
+		}
+		for (Byte = 0; Byte < Dlc && Byte < 8U; Byte++) {
+			printf("%02X", DataPtr[Byte]);
+		}
+		printf("\n");
+	}
+
+	if (LogPtr->NumRecords != 0U) {
+		u64 Span = RecordPtr[LogPtr->NumRecords - 1U].Ticks -
+			   RecordPtr[0].Ticks;
+
+		fprintf(stderr, "canlog: %u frames over %.6f s, %u dropped\n",
+			LogPtr->NumRecords, (double)Span / LogPtr->ClockHz,
+			LogPtr->Dropped);
+	}
+	return 0;
+}
+
+/* Parses one candump -L line into a record, FALSE if it is not one */
+static int ParseLine(const char *Line, CanLog_Record *RecordPtr)
+{
+	unsigned long long Seconds;
+	char Fraction[16];
+	char Frame[64];
+	u8 *DataPtr = (u8 *)&RecordPtr->Frame[2];
+	const char *Hash;
+	u32 Micros = 0;
+	u32 Digits;
+	u32 Id;
+	u32 Dlc = 0;
+	u32 Index;
+	int Extended;
+	int Remote;
+
+	if (sscanf(Line, " (%llu.%15[0-9]) %*s %63s", &Seconds, Fraction,
+		   Frame) != 3) {
+		return FALSE;
+	}
+	Digits = (u32)strlen(Fraction);
+	for (Index = 0; Index < 6U; Index++) {
+		Micros = Micros * 10U + ((Index < Digits) ?
+					 (u32)(Fraction[Index] - '0') : 0U);
+	}
+
+	Hash = strchr(Frame, '#');
+	if (Hash == NULL || Hash[1] == '#') {
+		/* No CAN FD */
+		return FALSE;
+	}
+	Id = (u32)strtoul(Frame, NULL, 16);
+	Extended = (Hash - Frame > 3) || (Id > 0x7FFU);
+	Remote = (Hash[1] == 'R');
+
+	RecordPtr->Ticks = Seconds * CANLOG_IMPORT_HZ + Micros;
+	RecordPtr->Frame[2] = 0U;
+	RecordPtr->Frame[3] = 0U;
+	if (Remote) {
+		Dlc = (Hash[2] >= '0' && Hash[2] <= '8') ?
+		      (u32)(Hash[2] - '0') : 0U;
+	} else {
+		for (Hash++; Hash[0] != '\0' && Hash[1] != '\0' && Dlc < 8U;
+		     Hash += 2) {
+			char Pair[3] = { Hash[0], Hash[1], '\0' };
+
+			DataPtr[Dlc++] = (u8)strtoul(Pair, NULL, 16);
+		}
+	}
+
+	if (Extended) {
+		RecordPtr->Frame[0] = XCan_CreateIdValue(Id >> 18, 1U, 1U, Id,
+							 (u32)Remote);
+	} else {
+		RecordPtr->Frame[0] = XCan_CreateIdValue(Id, (u32)Remote, 0U,
+							 0U, 0U);
+	}
+	RecordPtr->Frame[1] = XCan_CreateDlcValue(Dlc);
+
+	return TRUE;
+}
+
+/* Builds a log from candump -L text */
+static int Import(const char *InPath, const char *OutPath)
+{
+	FILE *In = fopen(InPath, "r");
+	std::vector<u8> Image(sizeof(CanLog_Header));
+	CanLog_Header *LogPtr;
+	CanLog_Record Record;
+	char Line[256];
+	u32 Records = 0;
+	u32 Skipped = 0;
+
+	if (In == NULL) {
+		perror(InPath);
+		return 1;
+	}
+	while (fgets(Line, sizeof(Line), In) != NULL) {
+		if (!ParseLine(Line, &Record)) {
+			Skipped++;
+			continue;
+		}
+		Image.insert(Image.end(), (const u8 *)&Record,
+			     (const u8 *)(&Record + 1));
+		Records++;
+	}
+	fclose(In);
+
+	LogPtr = (CanLog_Header *)Image.data();
+	memset(LogPtr, 0, sizeof(*LogPtr));
+	LogPtr->Magic = CAN_LOG_MAGIC;
+	LogPtr->Version = CAN_LOG_VERSION;
+	LogPtr->RecordSize = (u16)sizeof(CanLog_Record);
+	LogPtr->ClockHz = CANLOG_IMPORT_HZ;
+	LogPtr->NumRecords = Records;
+
+	fprintf(stderr, "canlog: %u frames, %u lines skipped\n", Records,
+		Skipped);
+	return WriteLog(OutPath, LogPtr);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc == 4 && strcmp(argv[1], "extract") == 0) {
+		return Extract(argv[2], argv[3]);
+	}
+	if ((argc == 3 || argc == 4) && strcmp(argv[1], "dump") == 0) {
+		return Dump(argv[2], (argc == 4) ? argv[3] : "can0");
+	}
+	if (argc == 4 && strcmp(argv[1], "import") == 0) {
+		return Import(argv[2], argv[3]);
+	}
+
+	fprintf(stderr, "usage: %s extract program-output log\n"
+		"       %s dump log [interface]\n"
+		"       %s import candump-text log\n", argv[0], argv[0],
+		argv[0]);
+	return 2;
+}
@@ -0,0 +1,155 @@
+/******************************************************************************
+* Host decoder for binary trace logs
+*
+* Reads what a program wrote with TraceLog_Flush in TRACE_LOG_BINARY mode,
+* e.g. a capture of the STDOUT UART or the standard output of a simulated
+* run, and prints one line per event with its format from
+* Tut10/trace_events.h:
+*
+*	build/Can_code > can.trace
+*	build/trace_decode can.trace
+*
+* Text printed by the program between records is skipped: records are
+* found by their sync byte, which never occurs in ASCII, and checked
+* against the event table and the record sequence number. Timestamps are
+* extended past the 32-bit wrap of the counter and shown relative to the
+* first record, using the clock frequency of the TRACE_EV_CLOCK record.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "xil_types.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Must match trace_log.h */
+#define TRACE_LOG_SYNC			0xA5U
+#define TRACE_LOG_RECORD_SIZE		16U
+
+/* Event identifiers, as in trace_log.h */
+enum {
+#define TRACE_EVENT(Id, NumArgs, Format)	Id,
+#include "trace_events.h"
+#undef TRACE_EVENT
+	TRACE_EV_COUNT
+};
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	const char *Name;
+	u32 NumArgs;
+	const char *Format;
+} TraceFormat;
+
+/************************** Variable Definitions *****************************/
+
+static const TraceFormat Formats[TRACE_EV_COUNT] = {
+#define TRACE_EVENT(Id, NumArgs, Format)	{ #Id, NumArgs, Format },
+#include "trace_events.h"
+#undef TRACE_EVENT
+};
+
+/*****************************************************************************/
+/**
+*
+* Reads a little-endian word.
+*
+******************************************************************************/
+static u32 GetWord(const u8 *Ptr)
+{
+	return (u32)Ptr[0] | ((u32)Ptr[1] << 8) | ((u32)Ptr[2] << 16) |
+	       ((u32)Ptr[3] << 24);
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<u8> Data;
+	FILE *In = stdin;
+	size_t Pos = 0;
+	u64 Skipped = 0;
+	u64 Records = 0;
+	u64 Lost = 0;
+	u64 Dropped = 0;
+	u64 Ticks = 0;
+	u64 Origin = 0;
+	u32 ClockHz = 100000000U;
+	u32 LastStamp = 0;
+	u32 ExpectSeq = 0;
+	int Synced = 0;
+	int Ch;
+
+	if (argc > 2) {
+		fprintf(stderr, "usage: %s [trace-file]\n", argv[0]);
+		return 2;
+	}
+	if (argc == 2) {
+		In = fopen(argv[1], "rb");
+		if (In == NULL) {
+			perror(argv[1]);
+			return 1;
+		}
+	}
+	while ((Ch = fgetc(In)) != EOF) {
+		Data.push_back((u8)Ch);
+	}
+
+	while (Pos + TRACE_LOG_RECORD_SIZE <= Data.size()) {
+		const u8 *Rec = &Data[Pos];
+		u32 Tag = GetWord(Rec);
+		u32 Id = (Tag >> 8) & 0xFFU;
+		u32 Seq = Tag >> 16;
+		u32 Stamp = GetWord(Rec + 4);
+		u32 Arg0 = GetWord(Rec + 8);
+		u32 Arg1 = GetWord(Rec + 12);
+
+		if ((Tag & 0xFFU) != TRACE_LOG_SYNC || Id >= TRACE_EV_COUNT) {
+			Pos++;
+			Skipped++;
+			continue;
+		}
+		Pos += TRACE_LOG_RECORD_SIZE;
+
+		/* Out of band, carries the sequence number of the next one */
+		if (Id == TRACE_EV_DROPPED) {
+			Dropped += Arg0;
+		} else {
+			if (Synced && Seq != ExpectSeq) {
+				Lost += (Seq - ExpectSeq) & 0xFFFFU;
+			}
+			ExpectSeq = (Seq + 1U) & 0xFFFFU;
+			Records++;
+		}
+
+		if (!Synced) {
+			Ticks = Stamp;
+			Origin = Stamp;
+			Synced = 1;
+		} else {
+			Ticks += (u32)(Stamp - LastStamp);
+		}
+		LastStamp = Stamp;
+
+		if (Id == TRACE_EV_CLOCK && Arg0 != 0U) {
+			ClockHz = Arg0;
+		}
+
+		printf("[%12.3f us] ",
+		       (double)(Ticks - Origin) * 1e6 / (double)ClockHz);
+		printf(Formats[Id].Format, (int)Arg0, (int)Arg1);
+		printf("\n");
+	}
+	Skipped += Data.size() - Pos;
+
+	fprintf(stderr, "trace_decode: %llu records, %llu dropped by the "
+		"target, %llu lost in the capture, %llu bytes of other "
+		"output skipped\n", (unsigned long long)Records,
+		(unsigned long long)Dropped, (unsigned long long)Lost,
+		(unsigned long long)Skipped);
+
+	return 0;
+}
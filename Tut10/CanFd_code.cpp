@@ -0,0 +1,641 @@
+/******************************************************************************
+* Copyright (C) 2015 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xcanfd.h"
+#include "xparameters.h"
+#include "xstatus.h"
+#include "xil_exception.h"
+#include "xpseudo_asm.h"
+#include "canfd_bit_timing.h"
+
+#ifdef XPAR_INTC_0_DEVICE_ID
+#include "xintc.h"
+#include <stdio.h>
+#else  /* SCU GIC */
+#include "xscugic.h"
+#include "xil_printf.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+/*
+ * The following constants map to the XPAR parameters created in the
+ * xparameters.h file. They are defined here such that a user can easily
+ * change all the needed parameters in one place.
+ */
+#define CANFD_DEVICE_ID		XPAR_CANFD_0_DEVICE_ID
+#define CANFD_INTR_VEC_ID	XPAR_INTC_0_CANFD_0_VEC_ID
+
+#ifdef XPAR_INTC_0_DEVICE_ID
+ #define INTC_DEVICE_ID		XPAR_INTC_0_DEVICE_ID
+#else
+ #define INTC_DEVICE_ID		XPAR_SCUGIC_SINGLE_DEVICE_ID
+#endif /* XPAR_INTC_0_DEVICE_ID */
+
+/* Maximum CAN FD frame size in words */
+#define XCANFD_MAX_FRAME_SIZE_IN_WORDS (XCANFD_MAX_FRAME_SIZE / sizeof(u32))
+
+/* Message ID for test */
+#define TEST_MESSAGE_ID		1024
+
+/*
+ * Frames sent, frame n with DLC n % 16, so every data length from 0 to 64
+ * bytes goes through the TX buffers and RX FIFO twice. All of them are
+ * queued at once, one per TX buffer.
+ */
+#define TEST_FRAME_COUNT	32
+
+/*
+ * Bit rates and sample points of the arbitration and data phases. The
+ * BRPR/BTR and F_BRPR/F_BTR values are solved from them and the CAN clock
+ * at compile time, see canfd_bit_timing.h; rates the clock cannot make
+ * fail the build.
+ */
+#define CANFD_CLOCK_HZ			XPAR_CANFD_0_CAN_CLK_FREQ_HZ
+#define TEST_NOMINAL_BIT_RATE		1000000
+#define TEST_NOMINAL_SAMPLE_POINT	875	/* per mille */
+#define TEST_DATA_BIT_RATE		5000000
+#define TEST_DATA_SAMPLE_POINT		750	/* per mille */
+
+/**************************** Type Definitions *******************************/
+
+#ifdef XPAR_INTC_0_DEVICE_ID
+ #define INTC		XIntc
+ #define INTC_HANDLER	XIntc_InterruptHandler
+#else
+ #define INTC		XScuGic
+ #define INTC_HANDLER	XScuGic_InterruptHandler
+#endif /* XPAR_INTC_0_DEVICE_ID */
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/************************** Function Prototypes ******************************/
+
+static int XCanFdIntrExample(u16 DeviceId);
+static void Config(XCanFd *InstancePtr);
+static int SendFrame(XCanFd *InstancePtr, int Index);
+
+static void SendHandler(void *CallBackRef);
+static void RecvHandler(void *CallBackRef);
+static void ErrorHandler(void *CallBackRef, u32 ErrorMask);
+static void EventHandler(void *CallBackRef, u32 Mask);
+
+static int SetupInterruptSystem(XCanFd *InstancePtr);
+
+/************************** Variable Definitions *****************************/
+
+/* BRPR/BTR and F_BRPR/F_BTR for the test bit rates */
+static constexpr CanFdBitTiming BitTiming =
+	CanFdBitTiming_Check<CANFD_CLOCK_HZ, TEST_NOMINAL_BIT_RATE,
+			     TEST_NOMINAL_SAMPLE_POINT, TEST_DATA_BIT_RATE,
+			     TEST_DATA_SAMPLE_POINT>();
+
+/* Driver instance */
+static XCanFd CanFd;
+
+/*
+ * Buffers to hold frames to send and receive. These are declared as global
+ * so that they are not on the stack.
+ */
+static u32 TxFrame[XCANFD_MAX_FRAME_SIZE_IN_WORDS];
+static u32 RxFrame[XCANFD_MAX_FRAME_SIZE_IN_WORDS];
+
+/* Flags for status */
+volatile static int LoopbackError;	/* Asynchronous error occurred */
+volatile static int SendInterrupts;	/* TXOK interrupts handled */
+volatile static int RecvCount;		/* Frames validated so far */
+volatile static u32 RecvBytes;		/* Payload bytes validated */
+
+/* For interrupt system */
+static INTC InterruptController;
+
+/******************************************************************************/
+/**
+*
+* Main function to call the CAN FD Interrupt example.
+*
+* @param	None.
+*
+* @return	XST_SUCCESS if successful, otherwise XST_FAILURE.
+*
+* @note		None.
+*
+******************************************************************************/
+int main(void)
+{
+	int Status;
+
+	xil_printf("===== CAN FD Interface Example =====\r\n");
+	xil_printf("Running CAN FD interrupt example...\r\n");
+
+	/*
+	 * Run the CAN FD interrupt example
+	 */
+	Status = XCanFdIntrExample(CANFD_DEVICE_ID);
+	if (Status != XST_SUCCESS) {
+		xil_printf("CAN FD Interrupt Example Failed\r\n");
+		return XST_FAILURE;
+	}
+
+	xil_printf("Successfully ran CAN FD Interrupt Example\r\n");
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* The main entry point for showing the usage of XCanFd driver in interrupt
+* mode. This function sends CAN FD frames of every data length with the
+* bit rate switch and receives the same frames using the loopback mode.
+*
+* @param	DeviceId is the XPAR_CANFD_<instance_num>_DEVICE_ID value from
+*		xparameters.h.
+*
+* @return	XST_SUCCESS if successful, otherwise XST_FAILURE.
+*
+* @note		If the device is not working correctly, this function may enter
+*		an infinite loop and will never return to the caller.
+*
+******************************************************************************/
+static int XCanFdIntrExample(u16 DeviceId)
+{
+	int Status;
+	int Index;
+	XCanFd_Config *ConfigPtr;
+
+	/*
+	 * Initialize the CAN FD driver
+	 */
+	ConfigPtr = XCanFd_LookupConfig(DeviceId);
+	if (ConfigPtr == NULL) {
+		return XST_FAILURE;
+	}
+	Status = XCanFd_CfgInitialize(&CanFd, ConfigPtr,
+				      ConfigPtr->BaseAddress);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Failed to initialize CAN FD driver\r\n");
+		return XST_FAILURE;
+	}
+
+	/*
+	 * Run self-test on the device
+	 */
+	Status = XCanFd_SelfTest(&CanFd);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Self test failed\r\n");
+		return XST_FAILURE;
+	}
+
+	/*
+	 * Configure the CAN FD device
+	 */
+	Config(&CanFd);
+
+	/*
+	 * Set interrupt handlers
+	 */
+	XCanFd_SetHandler(&CanFd, XCANFD_HANDLER_SEND,
+			  (void *)SendHandler, (void *)&CanFd);
+	XCanFd_SetHandler(&CanFd, XCANFD_HANDLER_RECV,
+			  (void *)RecvHandler, (void *)&CanFd);
+	XCanFd_SetHandler(&CanFd, XCANFD_HANDLER_ERROR,
+			  (void *)ErrorHandler, (void *)&CanFd);
+	XCanFd_SetHandler(&CanFd, XCANFD_HANDLER_EVENT,
+			  (void *)EventHandler, (void *)&CanFd);
+
+	/*
+	 * Initialize flags
+	 */
+	LoopbackError = FALSE;
+	SendInterrupts = 0;
+	RecvCount = 0;
+	RecvBytes = 0;
+
+	/*
+	 * Connect to the interrupt controller
+	 */
+	Status = SetupInterruptSystem(&CanFd);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Interrupt setup failed\r\n");
+		return XST_FAILURE;
+	}
+
+	/*
+	 * Enable all interrupts in CAN FD device
+	 */
+	XCanFd_InterruptEnable(&CanFd, XCANFD_IXR_ALL);
+
+	/*
+	 * Enter Loop Back Mode
+	 */
+	XCanFd_EnterMode(&CanFd, XCANFD_MODE_LOOPBACK);
+	while (XCanFd_GetMode(&CanFd) != XCANFD_MODE_LOOPBACK);
+
+	xil_printf("Nominal %d bit/s, data %d bit/s\r\n",
+		   (int)BitTiming.Nominal.BitRate,
+		   (int)BitTiming.Data.BitRate);
+
+	/*
+	 * Queue the test frames, one per TX buffer
+	 */
+	for (Index = 0; Index < TEST_FRAME_COUNT; Index++) {
+		Status = SendFrame(&CanFd, Index);
+		if (Status != XST_SUCCESS) {
+			xil_printf("Failed to send frame %d\r\n", Index);
+			return XST_FAILURE;
+		}
+	}
+
+	/*
+	 * Wait here until all frames are received, or an error occurs. In
+	 * loopback mode a frame is received as it is sent. Interrupts are
+	 * masked from the check to the WFI, so one that comes in between
+	 * still wakes it.
+	 */
+	while ((RecvCount != TEST_FRAME_COUNT) && !LoopbackError) {
+		Xil_ExceptionDisable();
+		if ((RecvCount != TEST_FRAME_COUNT) && !LoopbackError) {
+			wfi();
+		}
+		Xil_ExceptionEnable();
+	}
+
+	if (LoopbackError == TRUE) {
+		xil_printf("Frame %d lost or corrupted\r\n", RecvCount);
+		return XST_FAILURE;
+	}
+
+	/*
+	 * Every TX buffer must have been released
+	 */
+	for (Index = 0; Index < TEST_FRAME_COUNT; Index++) {
+		if (!XCanFd_IsBufferTransmitted(&CanFd, (u32)Index)) {
+			xil_printf("TX buffer %d still pending\r\n", Index);
+			return XST_FAILURE;
+		}
+	}
+
+	xil_printf("%d CAN FD frames, %d payload bytes, sent and received "
+		   "successfully, %d TX interrupts\r\n", RecvCount,
+		   (int)RecvBytes, SendInterrupts);
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* This function configures the CAN FD device for the bit rates and timing
+* parameters of both phases.
+*
+* @param	InstancePtr is a pointer to the driver instance
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+static void Config(XCanFd *InstancePtr)
+{
+	/*
+	 * Enter configuration mode
+	 */
+	XCanFd_EnterMode(InstancePtr, XCANFD_MODE_CONFIG);
+	while (XCanFd_GetMode(InstancePtr) != XCANFD_MODE_CONFIG);
+
+	/*
+	 * Set the baud rate prescalers and bit timing values of the
+	 * arbitration and data phases
+	 */
+	CanFdBitTiming_Apply(InstancePtr, &BitTiming);
+
+	/*
+	 * Switch to the data phase bit rate in frames with BRS set
+	 */
+	XCanFd_SetBitRateSwitch_EnableNominal(InstancePtr);
+}
+
+/*****************************************************************************/
+/**
+*
+* Sends test frame Index: a CAN FD frame with the bit rate switch, DLC
+* Index % 16 and data bytes Index, Index + 1, ...
+*
+* @param	InstancePtr is a pointer to the driver instance
+* @param	Index is the number of the frame.
+*
+* @return	XST_SUCCESS if the frame was queued, otherwise the status of
+*		XCanFd_Send.
+*
+* @note		None.
+*
+******************************************************************************/
+static int SendFrame(XCanFd *InstancePtr, int Index)
+{
+	u8 *FramePtr;
+	u32 TxBufferNumber;
+	u32 Dlc = (u32)Index % 16U;
+	int Length = XCanFd_GetDlc2len(Dlc << XCANFD_DLCR_DLC_SHIFT,
+				       XCANFD_DLCR_EDL_MASK);
+	int Byte;
+
+	TxFrame[0] = XCanFd_CreateIdValue(TEST_MESSAGE_ID, 0, 0, 0, 0);
+	TxFrame[1] = XCanFd_Create_CanFD_Dlc_BrsValue(Dlc);
+
+	FramePtr = (u8 *)(&TxFrame[2]);
+	for (Byte = 0; Byte < Length; Byte++) {
+		*FramePtr++ = (u8)(Index + Byte);
+	}
+
+	return XCanFd_Send(InstancePtr, TxFrame, &TxBufferNumber);
+}
+
+/*****************************************************************************/
+/**
+*
+* Callback function (called from interrupt handler) to handle confirmation
+* of transmit events when in interrupt mode.
+*
+* @param	CallBackRef is the callback reference passed from the interrupt
+*		handler, which in our case is a pointer to the driver instance.
+*
+* @return	None.
+*
+* @note		One TXOK interrupt may stand for several frames sent; the
+*		TRR bits of the TX buffers tell which are done.
+*
+******************************************************************************/
+static void SendHandler(void *CallBackRef)
+{
+	(void)CallBackRef;
+
+	SendInterrupts = SendInterrupts + 1;
+}
+
+/*****************************************************************************/
+/**
+*
+* Callback function (called from interrupt handler) to handle frames
+* received in interrupt mode. It reads every frame in RX FIFO 0 and checks
+* it against the one sent in the same place.
+*
+* @param	CallBackRef is the callback reference passed from the interrupt
+*		handler, which in our case is a pointer to the device instance.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+static void RecvHandler(void *CallBackRef)
+{
+	XCanFd *CanPtr = (XCanFd *)CallBackRef;
+	u8 *FramePtr;
+	u32 Dlc;
+	int Length;
+	int Byte;
+
+	while (XCanFd_GetRxFillLevel(CanPtr) != 0U) {
+		if (XCanFd_Recv(CanPtr, RxFrame) != XST_SUCCESS) {
+			LoopbackError = TRUE;
+			return;
+		}
+
+		/*
+		 * Verify Identifier, Data Length Code and the bit rate
+		 * switch
+		 */
+		Dlc = XCanFd_Create_CanFD_Dlc_BrsValue(RecvCount % 16);
+		if ((RecvCount >= TEST_FRAME_COUNT) ||
+		    (RxFrame[0] != (u32)XCanFd_CreateIdValue(TEST_MESSAGE_ID,
+							     0, 0, 0, 0)) ||
+		    ((RxFrame[1] & (XCANFD_DLCR_DLC_MASK |
+				    XCANFD_DLCR_EDL_MASK |
+				    XCANFD_DLCR_BRS_MASK)) != Dlc)) {
+			LoopbackError = TRUE;
+			return;
+		}
+
+		/*
+		 * Verify the data
+		 */
+		Length = XCanFd_GetDlc2len(RxFrame[1] & XCANFD_DLCR_DLC_MASK,
+					   XCANFD_DLCR_EDL_MASK);
+		FramePtr = (u8 *)(&RxFrame[2]);
+		for (Byte = 0; Byte < Length; Byte++) {
+			if (*FramePtr++ != (u8)(RecvCount + Byte)) {
+				LoopbackError = TRUE;
+				return;
+			}
+		}
+
+		RecvBytes = RecvBytes + (u32)Length;
+		RecvCount = RecvCount + 1;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* This function is the interrupt handler for the error interrupt.
+* Any error ends the loopback test: in loopback mode there is no other
+* node that could disturb the frames.
+*
+* @param	CallBackRef is a pointer to the driver instance.
+* @param	ErrorMask is a mask that indicates the cause of the error.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+static void ErrorHandler(void *CallBackRef, u32 ErrorMask)
+{
+	XCanFd *CanPtr = (XCanFd *)CallBackRef;
+
+	if (ErrorMask & (XCANFD_ESR_F_BERR_MASK | XCANFD_ESR_F_STER_MASK |
+			 XCANFD_ESR_F_FMER_MASK | XCANFD_ESR_F_CRCER_MASK)) {
+		xil_printf("Data phase error 0x%x\r\n", (int)ErrorMask);
+	} else {
+		xil_printf("Bus error 0x%x\r\n", (int)ErrorMask);
+	}
+
+	/*
+	 * Clear the error status
+	 */
+	XCanFd_ClearBusErrorStatus(CanPtr, XCanFd_GetBusErrorStatus(CanPtr));
+	LoopbackError = TRUE;
+}
+
+/*****************************************************************************/
+/**
+*
+* This function is the interrupt handler for the event interrupt.
+*
+* @param	CallBackRef is a pointer to the driver instance.
+* @param	Mask is a mask that indicates the cause of the event.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+static void EventHandler(void *CallBackRef, u32 Mask)
+{
+	XCanFd *CanPtr = (XCanFd *)CallBackRef;
+
+	if (Mask & XCANFD_IXR_BSOFF_MASK) {
+		/*
+		 * Entering Bus off status interrupt requires the CAN FD
+		 * device be reset and reconfigured.
+		 */
+		XCanFd_Reset(CanPtr);
+		Config(CanPtr);
+		LoopbackError = TRUE;
+		return;
+	}
+
+	if (Mask & XCANFD_IXR_RXFOFLW_MASK) {
+		/*
+		 * Code to handle RX FIFO 0 Overflow Interrupt should be put
+		 * here.
+		 */
+		LoopbackError = TRUE;
+	}
+
+	if (Mask & XCANFD_IXR_WKUP_MASK) {
+		/*
+		 * Code to handle Wake up from sleep mode Interrupt should be
+		 * put here.
+		 */
+	}
+
+	if (Mask & XCANFD_IXR_SLP_MASK) {
+		/*
+		 * Code to handle Enter sleep mode Interrupt should be put
+		 * here.
+		 */
+	}
+
+	if (Mask & XCANFD_IXR_ARBLST_MASK) {
+		/*
+		 * Code to handle Lost bus arbitration Interrupt should be put
+		 * here.
+		 */
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* This function sets up the interrupt system so interrupts can occur for the
+* CAN FD. This function is application-specific since the actual system may
+* or may not have an interrupt controller.
+*
+* @param	InstancePtr is a pointer to the XCanFd instance.
+*
+* @return	XST_SUCCESS if successful, otherwise XST_FAILURE.
+*
+* @note		None.
+*
+******************************************************************************/
+static int SetupInterruptSystem(XCanFd *InstancePtr)
+{
+	int Status;
+
+#ifdef XPAR_INTC_0_DEVICE_ID
+	/*
+	 * Initialize the interrupt controller driver
+	 */
+	Status = XIntc_Initialize(&InterruptController, INTC_DEVICE_ID);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	/*
+	 * Connect the device driver handler
+	 */
+	Status = XIntc_Connect(&InterruptController,
+				CANFD_INTR_VEC_ID,
+				(XInterruptHandler)XCanFd_IntrHandler,
+				InstancePtr);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	/*
+	 * Start the interrupt controller
+	 */
+	Status = XIntc_Start(&InterruptController, XIN_REAL_MODE);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	/*
+	 * Enable the interrupt for the CAN FD device
+	 */
+	XIntc_Enable(&InterruptController, CANFD_INTR_VEC_ID);
+
+#else /* SCUGIC */
+
+	XScuGic_Config *IntcConfig;
+
+	/*
+	 * Initialize the interrupt controller driver
+	 */
+	IntcConfig = XScuGic_LookupConfig(INTC_DEVICE_ID);
+	if (NULL == IntcConfig) {
+		return XST_FAILURE;
+	}
+
+	Status = XScuGic_CfgInitialize(&InterruptController, IntcConfig,
+				IntcConfig->CpuBaseAddress);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	/*
+	 * Set priority and trigger type
+	 */
+	XScuGic_SetPriorityTriggerType(&InterruptController, CANFD_INTR_VEC_ID,
+					0xA0, 0x3);
+
+	/*
+	 * Connect the interrupt handler
+	 */
+	Status = XScuGic_Connect(&InterruptController, CANFD_INTR_VEC_ID,
+				(Xil_InterruptHandler)XCanFd_IntrHandler,
+				InstancePtr);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	/*
+	 * Enable the interrupt for the CAN FD device
+	 */
+	XScuGic_Enable(&InterruptController, CANFD_INTR_VEC_ID);
+
+#endif /* XPAR_INTC_0_DEVICE_ID */
+
+	/*
+	 * Initialize the exception table
+	 */
+	Xil_ExceptionInit();
+
+	/*
+	 * Register the interrupt controller handler with the exception table
+	 */
+	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT,
+			(Xil_ExceptionHandler)INTC_HANDLER,
+			&InterruptController);
+
+	/*
+	 * Enable exceptions
+	 */
+	Xil_ExceptionEnable();
+
+	return XST_SUCCESS;
+}
@@ -5,10 +5,28 @@
 
 /***************************** Include Files *********************************/
 
+#include <string.h>
+
 #include "xcan.h"
 #include "xparameters.h"
 #include "xstatus.h"
 #include "xil_exception.h"
+#include "xtmrctr.h"
+#include "can_pool.h"
+#include "can_txsched.h"
+#include "can_async.h"
+#include "timestamp.h"
+#include "mono_clock.h"
+#include "can_bit_timing.h"
+#include "can_dispatch.h"
+#include "can_signal.h"
+#include "can_log.h"
+#include "can_replay.h"
+#include "can_stats.h"
+#include "can_recovery.h"
+#include "can_rx_poll.h"
+#include "trace_log.h"
+#include "latency_hist.h"
 
 #ifdef XPAR_INTC_0_DEVICE_ID
 #include "xintc.h"
@@ -26,12 +44,18 @@
  * change all the needed parameters in one place.
  */
 #define CAN_DEVICE_ID		XPAR_CAN_0_DEVICE_ID
+#define CAN_TX_FIFO_DEPTH	XPAR_CAN_0_CAN_TX_DPTH
+#define TMRCTR_DEVICE_ID	XPAR_TMRCTR_2_DEVICE_ID
+#define POLL_TIMER_DEVICE_ID	XPAR_TMRCTR_0_DEVICE_ID
+#define POLL_TIMER_COUNTER	0
 #define CAN_INTR_VEC_ID		XPAR_INTC_0_CAN_0_VEC_ID
 
 #ifdef XPAR_INTC_0_DEVICE_ID
  #define INTC_DEVICE_ID		XPAR_INTC_0_DEVICE_ID
+ #define POLL_TIMER_INTR_VEC_ID	XPAR_INTC_0_TMRCTR_0_VEC_ID
 #else
  #define INTC_DEVICE_ID		XPAR_SCUGIC_SINGLE_DEVICE_ID
+ #define POLL_TIMER_INTR_VEC_ID	XPAR_FABRIC_TMRCTR_0_VEC_ID
 #endif /* XPAR_INTC_0_DEVICE_ID */
 
 /* Maximum CAN frame size in words */
@@ -41,17 +65,86 @@
 /* Message ID for test */
 #define TEST_MESSAGE_ID		1024
 
+/* Data of the test frames, bytes 0, 1, 2... read as one Intel value */
+#define TEST_PATTERN_VALUE	0x0706050403020100ULL
+
+/*
+ * Frames sent through the TX scheduler, by TEST_SEND_TASKS tasks with one
+ * frame in flight each, see can_async.h
+ */
+#define TEST_FRAME_COUNT	32
+#define TEST_SEND_TASKS		4
+
+/*
+ * Traffic of the test: TEST_TRAFFIC_PATTERN sends TEST_FRAME_COUNT frames
+ * of TEST_MESSAGE_ID, TEST_TRAFFIC_REPLAY replays the capture log loaded at
+ * REPLAY_LOG_ADDR (XSDB "dow -data", HOSTSIM_LOAD on the host), first at
+ * its recorded timing and then as fast as the bus takes it, and checks
+ * every frame received against the log
+ */
+#define TEST_TRAFFIC_PATTERN	0
+#define TEST_TRAFFIC_REPLAY	1
+
+#ifndef TEST_TRAFFIC
+#define TEST_TRAFFIC		TEST_TRAFFIC_PATTERN
+#endif
+
+#define REPLAY_LOG_ADDR		0x10000000U
+#define REPLAY_LOG_MAX_SIZE	0x01000000U
+
+/*
+ * Every received frame is timestamped into the capture log, up to
+ * CAPTURE_FRAMES. With CAPTURE_OUTPUT TRUE the log is written to STDOUT at
+ * the end, for HostSim/tools/canlog.
+ */
+#define CAPTURE_FRAMES		4096U
+#define CAPTURE_OUTPUT		FALSE
+
+/*
+ * Trace output of the idle loop: TRACE_LOG_TEXT prints the events,
+ * TRACE_LOG_BINARY writes raw records for HostSim/tools/trace_decode
+ */
+#define TRACE_OUTPUT		TRACE_LOG_TEXT
+
+/*
+ * Back-off before rejoining the bus after a bus-off, doubling from the
+ * minimum with every bus-off of one outage, see can_recovery.h
+ */
+#define RECOVERY_MIN_BACKOFF_MS	10U
+#define RECOVERY_MAX_BACKOFF_MS	640U
+
+/*
+ * Receive by interrupt up to RX_POLL_RATE frames/s, above it by polling
+ * the RX FIFO every RX_POLL_PERIOD_US, RX_POLL_BUDGET frames at most, see
+ * can_rx_poll.h. The budget covers a period at the full rate of the bus.
+ */
+#define RX_POLL_RATE		2000U
+#define RX_POLL_PERIOD_US	1000U
+#define RX_POLL_BUDGET		16U
+
 /*
- * The Baud Rate Prescaler Register (BRPR) and Bit Timing Register (BTR)
- * are setup such that CAN baud rate equals 40Kbps, assuming that the
- * CAN clock is 24MHz. These values should be modified based on the desired
- * baud rate and CAN clock frequency.
+ * Transmit priority classes by the highest base ID of each, see
+ * can_txsched.h: class 0 goes through the high priority buffer, the
+ * others through the TX FIFO, which holds TX_FIFO_LIMIT frames at most so
+ * that urgent frames do not queue behind a burst already in it.
  */
-#define TEST_BRPR_BAUD_PRESCALAR	29
+#define TX_CLASS_0_MAX_ID	0x0FF
+#define TX_CLASS_1_MAX_ID	0x3FF
+#define TX_CLASS_2_MAX_ID	0x5FF
+#define TX_FIFO_LIMIT		2U
+
+/* Period of the bus statistics line printed by the idle loop */
+#define STATS_EXPORT_MS		100U
 
-#define TEST_BTR_SYNCJUMPWIDTH		3
-#define TEST_BTR_SECOND_TIMESEGMENT	2
-#define TEST_BTR_FIRST_TIMESEGMENT	15
+/*
+ * Bit rate and sample point of the bus. The Baud Rate Prescaler Register
+ * (BRPR) and Bit Timing Register (BTR) values are solved from them and the
+ * CAN clock at compile time, see can_bit_timing.h; a rate the clock cannot
+ * make fails the build.
+ */
+#define CAN_CLOCK_HZ			XPAR_CAN_0_CAN_CLK_FREQ_HZ
+#define TEST_BIT_RATE			1000000
+#define TEST_SAMPLE_POINT		875	/* per mille */
 
 /**************************** Type Definitions *******************************/
 
@@ -63,34 +156,116 @@
  #define INTC_HANDLER	XScuGic_InterruptHandler
 #endif /* XPAR_INTC_0_DEVICE_ID */
 
+/* The test message and its whole payload as one signal */
+using TestMessage = CanMessage<TEST_MESSAGE_ID, FALSE, FRAME_DATA_LENGTH>;
+using TestPattern = CanSignal<CanSignalDesc{ 0, 64, CAN_SIGNAL_INTEL }>;
+
 /***************** Macros (Inline Functions) Definitions *********************/
 
 /************************** Function Prototypes ******************************/
 
 static int XCanIntrExample(u16 DeviceId);
 static void Config(XCan *InstancePtr);
-static void SendFrame(XCan *InstancePtr);
+static u32 ReceiveFrames(XCan *CanPtr, u32 Budget);
+static void ProcessRxFrames(void);
+static void ExportStats(int Full);
+#if TEST_TRAFFIC == TEST_TRAFFIC_REPLAY
+static int ReplayLog(void);
+static void ReplayFrameHandler(void *CallBackRef, const u32 *FramePtr);
+#else
+static CanTask SendTask(CanAsync *AsyncPtr, int Count);
+static CanTask ReceiveTask(CanAsync *AsyncPtr, int Count);
+static int PollTasks(void *CallBackRef);
+static void TestFrameHandler(void *CallBackRef, const u32 *FramePtr);
+static void UnknownFrameHandler(void *CallBackRef, const u32 *FramePtr);
+#endif
 
 static void SendHandler(void *CallBackRef);
+static void RetireHandler(void *CallBackRef, const u32 *FramePtr);
 static void RecvHandler(void *CallBackRef);
 static void ErrorHandler(void *CallBackRef, u32 ErrorMask);
 static void EventHandler(void *CallBackRef, u32 Mask);
 
 static int SetupInterruptSystem(XCan *InstancePtr);
+static void CanIsr(void *InstancePtr);
+static void PollTimerHandler(void *CallBackRef, u8 TmrCtrNumber);
 
 /************************** Variable Definitions *****************************/
 
+/* BRPR and BTR for TEST_BIT_RATE */
+static constexpr CanBitTiming BitTiming =
+	CanBitTiming_Check<CAN_CLOCK_HZ, TEST_BIT_RATE, TEST_SAMPLE_POINT>();
+
 /* Driver instance */
 static XCan Can;
 
-/* Buffers for transmit and receive */
-static u32 TxFrame[XCAN_MAX_FRAME_SIZE_IN_WORDS];
-static u32 RxFrame[XCAN_MAX_FRAME_SIZE_IN_WORDS];
+/* Cascaded system clock timer, the timestamps of the TX scheduler */
+static XTmrCtr TimerCounter;
+
+/* The scheduler feeding the TXHPB and TX FIFO from SendHandler */
+static CanTxSched TxSched;
+static const u16 TxClassLimit[CAN_TXS_CLASSES - 1U] = {
+	TX_CLASS_0_MAX_ID, TX_CLASS_1_MAX_ID, TX_CLASS_2_MAX_ID
+};
+
+/*
+ * Received frames, read into pool frames by RecvHandler and queued to
+ * ProcessRxFrames, which hands them on without a copy. RxDiscard absorbs
+ * frames read out of the hardware while the pool is exhausted.
+ */
+static CanPool FramePool;
+static CanPool_Queue RxQueue;
+static u32 RxDiscard[XCAN_MAX_FRAME_SIZE_IN_WORDS];
+
+/* Handlers of the received IDs, which also set the acceptance filters */
+static CanDispatch RxDispatch;
+
+/* Received frames with their system clock time, see can_log.h */
+static CanLog Capture;
+static u64 CaptureBuffer[CAN_LOG_SIZE(CAPTURE_FRAMES) / sizeof(u64)];
+
+#if TEST_TRAFFIC != TEST_TRAFFIC_REPLAY
+/* The executor of the test tasks, woken by the CAN interrupts */
+static CanAsync Async;
+#else
+/*
+ * Replay of the loaded log, its due time to reception latency and the
+ * next record to match of each TX class
+ */
+static CanReplay Replay;
+static LatencyHist ReplayHist;
+static u32 ReplayCursor[CAN_TXS_CLASSES];
+#endif
+
+/* Bus load, per-ID rates and error counts, see can_stats.h */
+static CanStats BusStats;
+static CanStats_Snapshot BusSnapshot;
+static u64 StatsExportTime;
+
+/* Bus-off and error passive handling, keeping the queued frames */
+static CanRecovery Recovery;
+
+/* Interrupt or polled receive by frame rate, and the timer polling */
+static CanRxPoll RxPoll;
+static XTmrCtr PollTimer;
+
+/* Hardware RX FIFO overflow events */
+volatile static u32 RxFifoOverflows;
+
+/*
+ * Interval between successive CAN interrupts and handler execution time,
+ * in timestamp counter ticks. With frames back to back on the bus the
+ * spread of the interval is the jitter of the interrupt latency.
+ */
+static LatencyHist CanIntervalHist;
+static LatencyHist CanExecHist;
+static u32 CanLastEntry;
 
 /* Flags for status */
 volatile static int LoopbackError;	/* Asynchronous error occurred */
 volatile static int RecvDone;		/* Received a frame */
-volatile static int SendDone;		/* Frame was sent successfully */
+static int RecvCount;			/* Frames validated so far */
+static int ExpectedCount;		/* Frames the test receives */
 
 /* For interrupt system */
 static INTC InterruptController;
@@ -146,6 +321,38 @@ int main(void)
 static int XCanIntrExample(u16 DeviceId)
 {
 	int Status;
+	CanPool_Stats RxStats;
+	CanTxSched_Stats TxStats;
+	CanTxSched_ClassStats *ClassPtr;
+	u32 Class;
+	CanRecovery_Stats LinkStats;
+	CanRxPoll_Stats PollStats;
+#if TEST_TRAFFIC != TEST_TRAFFIC_REPLAY
+	CanAsync_Stats AsyncStats;
+	int Task;
+#endif
+	const CanRxPoll_Config PollConfig = {
+		RX_POLL_RATE, RX_POLL_PERIOD_US, RX_POLL_BUDGET
+	};
+
+	/*
+	 * Start the system clock, the timebase of the TX latency statistics
+	 * and of the trace log
+	 */
+	Status = XTmrCtr_Initialize(&TimerCounter, TMRCTR_DEVICE_ID);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Failed to initialize timer\r\n");
+		return XST_FAILURE;
+	}
+	MonoClock_Initialize(&TimerCounter);
+	TraceLog_Init(TRACE_OUTPUT);
+	LatencyHist_Init(&CanIntervalHist, "CAN interrupt interval");
+	LatencyHist_Init(&CanExecHist, "CAN handler execution");
+	CanLog_Init(&Capture, CaptureBuffer, sizeof(CaptureBuffer),
+		    MonoClock_ClockHz);
+	CanStats_Init(&BusStats, BitTiming.BitRate, MonoClock_ClockHz,
+		      XCAN_MODE_LOOPBACK, MonoClock_Now());
+	StatsExportTime = MonoClock_Now();
 
 	/*
 	 * Initialize the CAN driver
@@ -185,9 +392,43 @@ static int XCanIntrExample(u16 DeviceId)
 	/*
 	 * Initialize flags
 	 */
-	SendDone = FALSE;
 	RecvDone = FALSE;
 	LoopbackError = FALSE;
+	RecvCount = 0;
+	ExpectedCount = TEST_FRAME_COUNT;
+	RxFifoOverflows = 0;
+	CanPool_Init(&FramePool);
+	CanPool_QueueInit(&RxQueue);
+	Status = CanTxSched_Init(&TxSched, &Can, TX_FIFO_LIMIT, TxClassLimit);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Invalid TX classes\r\n");
+		return XST_FAILURE;
+	}
+	CanTxSched_SetRetireHandler(&TxSched, RetireHandler, NULL);
+#if TEST_TRAFFIC != TEST_TRAFFIC_REPLAY
+	CanAsync_Init(&Async, &TxSched);
+#endif
+	CanRecovery_Init(&Recovery, &Can, &TxSched, XCAN_MODE_LOOPBACK,
+			 (u64)MonoClock_ClockHz * RECOVERY_MIN_BACKOFF_MS /
+			 1000U,
+			 (u64)MonoClock_ClockHz * RECOVERY_MAX_BACKOFF_MS /
+			 1000U);
+
+	/*
+	 * Set up the timer polling the RX FIFO above RX_POLL_RATE
+	 */
+	Status = XTmrCtr_Initialize(&PollTimer, POLL_TIMER_DEVICE_ID);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Failed to initialize poll timer\r\n");
+		return XST_FAILURE;
+	}
+	Status = CanRxPoll_Init(&RxPoll, &Can, &PollTimer, POLL_TIMER_COUNTER,
+				&PollConfig);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Invalid RX poll period\r\n");
+		return XST_FAILURE;
+	}
+	XTmrCtr_SetHandler(&PollTimer, PollTimerHandler, &Can);
 
 	/*
 	 * Connect to processor interrupt
@@ -209,16 +450,45 @@ static int XCanIntrExample(u16 DeviceId)
 	XCan_EnterMode(&Can, XCAN_MODE_LOOPBACK);
 	while(XCan_GetMode(&Can) != XCAN_MODE_LOOPBACK);
 
+#if TEST_TRAFFIC == TEST_TRAFFIC_REPLAY
+	Status = ReplayLog();
+	if (Status != XST_SUCCESS) {
+		return Status;
+	}
+#else
 	/*
-	 * Send a frame
+	 * Start the tasks, each runs up to its first wait. The frames of the
+	 * senders are spread over them, the first taking the remainder.
 	 */
-	xil_printf("Sending CAN frame...\r\n");
-	SendFrame(&Can);
+	xil_printf("Sending %d CAN frames...\r\n", TEST_FRAME_COUNT);
+	if (!ReceiveTask(&Async, TEST_FRAME_COUNT).Started) {
+		xil_printf("No frame for the receive task\r\n");
+		return XST_FAILURE;
+	}
+	for (Task = 0; Task < TEST_SEND_TASKS; Task++) {
+		if (!SendTask(&Async, TEST_FRAME_COUNT / TEST_SEND_TASKS +
+			      ((Task == 0) ? TEST_FRAME_COUNT %
+					     TEST_SEND_TASKS : 0)).Started) {
+			xil_printf("No frame for send task %d\r\n", Task);
+			return XST_FAILURE;
+		}
+	}
 
 	/*
-	 * Wait for the frame to be transmitted and received
+	 * Run them until every frame has been sent and received, sleeping
+	 * while they wait for the CAN interrupts
 	 */
-	while ((SendDone != TRUE) || (RecvDone != TRUE));
+	CanAsync_Run(&Async, PollTasks, NULL);
+	TraceLog_Flush();
+
+	CanAsync_GetStats(&Async, &AsyncStats);
+	xil_printf("Tasks: %d started, %d frames of %d bytes at most "
+		   "(largest %d), %d resumes, %d sleeps\r\n",
+		   (int)AsyncStats.Started, (int)AsyncStats.MaxFrames,
+		   (int)(CAN_ASYNC_BLOCK_SIZE - CAN_ASYNC_BLOCK_HEADER),
+		   (int)AsyncStats.MaxFrameSize, (int)AsyncStats.Resumes,
+		   (int)AsyncStats.Sleeps);
+#endif
 
 	/*
 	 * Check for errors found in the callbacks
@@ -228,7 +498,65 @@ static int XCanIntrExample(u16 DeviceId)
 		return XST_LOOPBACK_ERROR;
 	}
 
-	xil_printf("CAN frame sent and received successfully\r\n");
+	CanTxSched_GetStats(&TxSched, &TxStats);
+	for (Class = 0U; Class < CAN_TXS_CLASSES; Class++) {
+		ClassPtr = &TxStats.Class[Class];
+		if ((ClassPtr->Frames == 0U) && (ClassPtr->Full == 0U)) {
+			continue;
+		}
+		xil_printf("TX class %d: %d frames, %d rejected, "
+			   "%d queued at most\r\n", (int)Class,
+			   (int)ClassPtr->Frames, (int)ClassPtr->Full,
+			   (int)ClassPtr->MaxWaiting);
+		if (ClassPtr->Frames != 0U) {
+			xil_printf("  enqueue to wire: min %d us, mean %d us, "
+				   "max %d us\r\n",
+				   (int)(Timestamp_TicksToNs(
+					ClassPtr->MinLatency) / 1000),
+				   (int)(Timestamp_TicksToNs((u32)(
+					ClassPtr->TotalLatency /
+					ClassPtr->Frames)) / 1000),
+				   (int)(Timestamp_TicksToNs(
+					ClassPtr->MaxLatency) / 1000));
+		}
+	}
+
+	CanPool_GetStats(&FramePool, &RxStats);
+	xil_printf("RX frames: %d from the pool, high watermark %d of %d, "
+		   "%d dropped with the pool exhausted, "
+		   "%d hardware FIFO overflows\r\n",
+		   (int)RxStats.Allocs, (int)RxStats.HighWatermark,
+		   (int)CAN_POOL_FRAMES, (int)RxStats.Exhausted,
+		   (int)RxFifoOverflows);
+
+	CanRecovery_GetStats(&Recovery, &LinkStats);
+	xil_printf("Link: %d bus-off, %d error passive, %d rejoins, "
+		   "%d recoveries (last %d us, max %d us), %d frames kept, "
+		   "%d sends rejected\r\n",
+		   (int)LinkStats.BusOffs, (int)LinkStats.Passives,
+		   (int)LinkStats.Rejoins, (int)LinkStats.Recoveries,
+		   (int)MonoClock_TicksToUs(LinkStats.LastRecovery),
+		   (int)MonoClock_TicksToUs(LinkStats.MaxRecovery),
+		   (int)LinkStats.MaxHeld, (int)LinkStats.Rejected);
+
+	CanRxPoll_GetStats(&RxPoll, &PollStats);
+	xil_printf("RX: %d frames by interrupt, %d polled in %d polls "
+		   "(%d full), %d switches to polling\r\n",
+		   (int)PollStats.IrqFrames, (int)PollStats.PolledFrames,
+		   (int)PollStats.Polls, (int)PollStats.FullPolls,
+		   (int)PollStats.Switches);
+
+	LatencyHist_Print(&CanIntervalHist, TRUE);
+	LatencyHist_Print(&CanExecHist, TRUE);
+	ExportStats(TRUE);
+
+	xil_printf("Capture log: %d frames, %d dropped\r\n",
+		   (int)Capture.Log->NumRecords, (int)Capture.Log->Dropped);
+#if CAPTURE_OUTPUT
+	CanLog_Flush(&Capture);
+#endif
+
+	xil_printf("CAN frames sent and received successfully\r\n");
 	return XST_SUCCESS;
 }
 
@@ -256,69 +584,132 @@ static void Config(XCan *InstancePtr)
 	/*
 	 * Set the baud rate prescaler and bit timing values
 	 */
-	XCan_SetBaudRatePrescaler(InstancePtr, TEST_BRPR_BAUD_PRESCALAR);
-	XCan_SetBitTiming(InstancePtr, TEST_BTR_SYNCJUMPWIDTH,
-			TEST_BTR_SECOND_TIMESEGMENT,
-			TEST_BTR_FIRST_TIMESEGMENT);
+	CanBitTiming_Apply(InstancePtr, &BitTiming);
+
+	/*
+	 * Let only the IDs with a handler through the acceptance filters.
+	 * A replay registers none, which turns the filters off, and checks
+	 * every frame in the default handler.
+	 */
+	CanDispatch_Initialize(&RxDispatch);
+#if TEST_TRAFFIC == TEST_TRAFFIC_REPLAY
+	CanDispatch_SetDefault(&RxDispatch, ReplayFrameHandler, NULL);
+#else
+	CanDispatch_Register(&RxDispatch, TEST_MESSAGE_ID, FALSE,
+			     TestFrameHandler, NULL);
+	CanDispatch_SetDefault(&RxDispatch, UnknownFrameHandler, NULL);
+#endif
+	CanDispatch_ProgramFilters(&RxDispatch, InstancePtr);
 }
 
+#if TEST_TRAFFIC != TEST_TRAFFIC_REPLAY
 /*****************************************************************************/
 /**
 *
-* Send a CAN frame.
+* Task sending Count test frames, each once the previous one is on the
+* wire. Several of them keep that many frames in flight.
 *
-* @param	InstancePtr is a pointer to the driver instance.
+* @param	AsyncPtr is the executor the task runs on.
+* @param	Count is the number of frames to send.
 *
-* @return	None.
+* @return	None, the task completes when the last frame is sent.
 *
 * @note		None.
 *
 ******************************************************************************/
-static void SendFrame(XCan *InstancePtr)
+static CanTask SendTask(CanAsync *AsyncPtr, int Count)
 {
-	u8 *FramePtr;
+	u32 TxFrame[XCAN_MAX_FRAME_SIZE_IN_WORDS];
+	CanFrameView Frame(TxFrame);
 	int Index;
-	int Status;
 
 	/*
-	 * Create the message ID
+	 * Create the message ID and fill in the data field with
+	 * incremental values (0, 1, 2...)
 	 */
-	TxFrame[0] = XCan_CreateIdValue(TEST_MESSAGE_ID, 0, 0, 0, 0);
-	TxFrame[1] = XCan_CreateDlcValue(FRAME_DATA_LENGTH);
+	Frame.Init<TestMessage>();
+	Frame.SetRaw<TestPattern>(TEST_PATTERN_VALUE);
 
-	/*
-	 * Fill in the data field with incremental values (0, 1, 2...)
-	 */
-	FramePtr = (u8 *)(&TxFrame[2]);
-	for (Index = 0; Index < FRAME_DATA_LENGTH; Index++) {
-		*FramePtr++ = (u8)Index;
+	for (Index = 0; Index < Count; Index++) {
+		co_await CanAsync_Send(AsyncPtr, TxFrame);
 	}
+}
 
-	/*
-	 * Wait until TX FIFO is not full
-	 */
-	while (XCan_IsTxFifoFull(InstancePtr) == TRUE);
+/*****************************************************************************/
+/**
+*
+* Task receiving Count test frames and checking each against the frames
+* SendTask sends.
+*
+* @param	AsyncPtr is the executor the task runs on.
+* @param	Count is the number of frames to receive.
+*
+* @return	None, the task completes when the last frame is received.
+*
+* @note		Errors are reported in LoopbackError.
+*
+******************************************************************************/
+static CanTask ReceiveTask(CanAsync *AsyncPtr, int Count)
+{
+	CanPool_Frame *RxFrame;
+	int Index;
 
-	/*
-	 * Send the frame
-	 */
-	Status = XCan_Send(InstancePtr, TxFrame);
-	if (Status != XST_SUCCESS) {
-		/*
-		 * The frame could not be sent successfully
-		 */
-		xil_printf("Failed to send frame\r\n");
-		LoopbackError = TRUE;
-		SendDone = TRUE;
-		RecvDone = TRUE;
+	for (Index = 0; Index < Count; Index++) {
+		RxFrame = co_await CanAsync_Recv(AsyncPtr,
+						 TestMessage::IdValue, ~0U);
+
+		/* Check data length code */
+		if (RxFrame->Words[1] != TestMessage::DlcValue) {
+			xil_printf("Received wrong DLC\r\n");
+			LoopbackError = TRUE;
+		}
+
+		/* Check data field, all 8 bytes in one compare */
+		if (TestPattern::GetRaw(RxFrame->Words) !=
+		    TEST_PATTERN_VALUE) {
+			xil_printf("Received wrong data\r\n");
+			LoopbackError = TRUE;
+		}
+
+		CanPool_Release(&FramePool, RxFrame);
 	}
 }
 
+/*****************************************************************************/
+/**
+*
+* The task context work done on every pass of the executor: validating
+* and dispatching the received frames, which completes the receive task,
+* the link recovery and the trace and statistics output.
+*
+* @param	CallBackRef is unused.
+*
+* @return	TRUE if the executor may sleep until the next interrupt,
+*		FALSE while a bus-off back-off is timed from here.
+*
+* @note		The statistics line is printed on the passes only, at most
+*		every STATS_EXPORT_MS.
+*
+******************************************************************************/
+static int PollTasks(void *CallBackRef)
+{
+	(void)CallBackRef;
+
+	ProcessRxFrames();
+	CanRecovery_Poll(&Recovery, MonoClock_Now());
+	TraceLog_Flush();
+	ExportStats(FALSE);
+
+	return CanRecovery_GetState(&Recovery) == CAN_LINK_ERROR_ACTIVE;
+}
+#endif
+
 /*****************************************************************************/
 /**
 *
 * This function is the interrupt handler for the send interrupt.
-* It is called when a frame is transmitted successfully.
+* It is called when a frame is transmitted successfully and refills the
+* TXHPB and TX FIFO from the TX scheduler.
 *
 * @param	CallBackRef is a pointer to the driver instance.
 *
@@ -329,17 +720,43 @@ static void SendFrame(XCan *InstancePtr)
 ******************************************************************************/
 static void SendHandler(void *CallBackRef)
 {
-	/*
-	 * The frame was sent successfully. Notify the task context.
-	 */
-	SendDone = TRUE;
+	if (CanRecovery_GetState(&Recovery) != CAN_LINK_ERROR_ACTIVE) {
+		CanRecovery_Recovered(&Recovery, MonoClock_Now());
+	}
+	CanTxSched_SendHandler(&TxSched);
+#if TEST_TRAFFIC != TEST_TRAFFIC_REPLAY
+	CanAsync_Post(&Async, CAN_ASYNC_EV_TX);
+#endif
+}
+
+/*****************************************************************************/
+/**
+*
+* This function is called by the TX scheduler from SendHandler for each
+* frame that has gone on the wire, and counts it in BusStats. It runs
+* inside the CanStats_WriteBegin and CanStats_WriteEnd of CanIsr.
+*
+* @param	CallBackRef is not used.
+* @param	FramePtr is the frame sent, in XCan_Send layout.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+static void RetireHandler(void *CallBackRef, const u32 *FramePtr)
+{
+	(void)CallBackRef;
+	CanStats_TxFrame(&BusStats, FramePtr);
 }
 
 /*****************************************************************************/
 /**
 *
 * This function is the interrupt handler for the receive interrupt.
-* It processes the received frame and checks its validity.
+* It drains every frame pending in the hardware RX FIFO, so a single
+* interrupt keeps up with back-to-back frames, and past RX_POLL_RATE
+* hands the reception over to PollTimerHandler.
 *
 * @param	CallBackRef is a pointer to the driver instance.
 *
@@ -351,57 +768,354 @@ static void SendHandler(void *CallBackRef)
 static void RecvHandler(void *CallBackRef)
 {
 	XCan *CanPtr = (XCan *)CallBackRef;
-	int Status;
-	int Index;
-	u8 *FramePtr;
 
-	/*
-	 * Receive the frame
-	 */
-	Status = XCan_Recv(CanPtr, RxFrame);
-	if (Status != XST_SUCCESS) {
-		LoopbackError = TRUE;
-		RecvDone = TRUE;
+	if (CanRecovery_GetState(&Recovery) != CAN_LINK_ERROR_ACTIVE) {
+		CanRecovery_Recovered(&Recovery, MonoClock_Now());
+	}
+	CanRxPoll_Received(&RxPoll, ReceiveFrames(CanPtr, ~0U));
+#if TEST_TRAFFIC != TEST_TRAFFIC_REPLAY
+	CanAsync_Post(&Async, CAN_ASYNC_EV_RX);
+#endif
+}
+
+/*****************************************************************************/
+/**
+*
+* This function is the handler of the poll timer while the receive
+* interrupts are masked. It reads up to RX_POLL_BUDGET frames a tick.
+*
+* @param	CallBackRef is a pointer to the driver instance.
+* @param	TmrCtrNumber is the counter that expired.
+*
+* @return	None.
+*
+* @note		The CAN and timer interrupts have the same priority and do
+*		not nest.
+*
+******************************************************************************/
+static void PollTimerHandler(void *CallBackRef, u8 TmrCtrNumber)
+{
+	XCan *CanPtr = (XCan *)CallBackRef;
+	u32 Frames;
+
+	(void)TmrCtrNumber;
+
+	if (RxPoll.Mode != CAN_RX_POLL) {
 		return;
 	}
+	if (CanRecovery_GetState(&Recovery) != CAN_LINK_ERROR_ACTIVE) {
+		CanRecovery_Recovered(&Recovery, MonoClock_Now());
+	}
 
-	/*
-	 * Verify the frame received is expected
-	 */
+	CanStats_WriteBegin(&BusStats);
+	Frames = ReceiveFrames(CanPtr, RxPoll.Config.Budget);
+	CanStats_WriteEnd(&BusStats);
+	CanRxPoll_Polled(&RxPoll, Frames);
+#if TEST_TRAFFIC != TEST_TRAFFIC_REPLAY
+	CanAsync_Post(&Async, CAN_ASYNC_EV_RX);
+#endif
+}
 
-	/* Check message ID */
-	if (RxFrame[0] != XCan_CreateIdValue(TEST_MESSAGE_ID, 0, 0, 0, 0)) {
-		xil_printf("Received wrong message ID\r\n");
-		LoopbackError = TRUE;
-		RecvDone = TRUE;
+/*****************************************************************************/
+/**
+*
+* This function reads frames from the hardware RX FIFO into frames of
+* FramePool, timestamps each into the capture log and queues it on
+* RxQueue. Validation is left to ProcessRxFrames in task context.
+*
+* @param	CanPtr is a pointer to the driver instance.
+* @param	Budget is the most frames to read.
+*
+* @return	The number of frames read.
+*
+* @note		Frames that find the pool exhausted are still read out of
+*		the hardware, to keep the FIFO from overflowing, and are
+*		counted by the pool.
+*
+******************************************************************************/
+static u32 ReceiveFrames(XCan *CanPtr, u32 Budget)
+{
+	CanPool_Frame *FramePtr;
+	u32 Frames = 0U;
+
+	while ((Frames < Budget) && (XCan_IsRxEmpty(CanPtr) == FALSE)) {
+		Frames++;
+		FramePtr = CanPool_Alloc(&FramePool);
+		if (FramePtr == NULL) {
+			(void)XCan_Recv(CanPtr, RxDiscard);
+			CanStats_RxFrame(&BusStats, RxDiscard);
+			CanLog_Append(&Capture, RxDiscard, MonoClock_Now());
+			continue;
+		}
+
+		(void)XCan_Recv(CanPtr, FramePtr->Words);
+		CanStats_RxFrame(&BusStats, FramePtr->Words);
+		CanLog_Append(&Capture, FramePtr->Words, MonoClock_Now());
+		CanPool_Put(&RxQueue, FramePtr);
+	}
+
+	return Frames;
+}
+
+/*****************************************************************************/
+/**
+*
+* This function hands the frames queued by RecvHandler to the handlers of
+* their IDs, then drops its reference to each: a handler that keeps a
+* frame takes its own. It runs in task context.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+static void ProcessRxFrames(void)
+{
+	CanPool_Frame *RxFrame;
+
+	while ((RxFrame = CanPool_Peek(&RxQueue)) != NULL) {
+		CanPool_Take(&RxQueue);
+		CanDispatch_Frame(&RxDispatch, RxFrame->Words);
+
+		CanPool_Release(&FramePool, RxFrame);
+		RecvCount++;
+		if (RecvCount == ExpectedCount) {
+			RecvDone = TRUE;
+		}
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* This function prints the bus statistics line every STATS_EXPORT_MS, or
+* the full report at once. It runs in task context, with the CAN interrupt
+* enabled.
+*
+* @param	Full is TRUE for the full report, now.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+static void ExportStats(int Full)
+{
+	u64 Now = MonoClock_Now();
+
+	if (!Full && (Now - StatsExportTime <
+		      (u64)MonoClock_ClockHz * STATS_EXPORT_MS / 1000U)) {
 		return;
 	}
+	StatsExportTime = Now;
+
+	CanStats_GetSnapshot(&BusStats, &Can, Now, &BusSnapshot);
+	if (Full) {
+		CanStats_Print(&BusSnapshot);
+	} else {
+		CanStats_PrintLine(&BusSnapshot);
+	}
+}
 
-	/* Check data length code */
-	if (RxFrame[1] != XCan_CreateDlcValue(FRAME_DATA_LENGTH)) {
-		xil_printf("Received wrong DLC\r\n");
+#if TEST_TRAFFIC != TEST_TRAFFIC_REPLAY
+/*****************************************************************************/
+/**
+*
+* This function hands a frame of TEST_MESSAGE_ID to ReceiveTask, which
+* checks it in place and releases it.
+*
+* @param	CallBackRef is unused.
+* @param	FramePtr is the received frame, the words of a FramePool
+*		frame.
+*
+* @return	None.
+*
+* @note		The receive task is always waiting for the next frame: it
+*		waits for nothing else between two.
+*
+******************************************************************************/
+static void TestFrameHandler(void *CallBackRef, const u32 *FramePtr)
+{
+	(void)CallBackRef;
+
+	if (!CanAsync_Deliver(&Async, CanPool_FrameOf(FramePtr))) {
+		xil_printf("Received more frames than sent\r\n");
 		LoopbackError = TRUE;
-		RecvDone = TRUE;
-		return;
 	}
+}
 
-	/* Check data field */
-	FramePtr = (u8 *)(&RxFrame[2]);
-	for (Index = 0; Index < FRAME_DATA_LENGTH; Index++) {
-		if (*FramePtr++ != (u8)Index) {
-			xil_printf("Received wrong data byte at index %d\r\n", Index);
-			LoopbackError = TRUE;
-			break;
+/*****************************************************************************/
+/**
+*
+* This function is called for frames of an ID without a handler, which the
+* acceptance filters let through.
+*
+* @param	CallBackRef is unused.
+* @param	FramePtr is the received frame.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+static void UnknownFrameHandler(void *CallBackRef, const u32 *FramePtr)
+{
+	(void)CallBackRef;
+	(void)FramePtr;
+
+	xil_printf("Received wrong message ID\r\n");
+	LoopbackError = TRUE;
+}
+#endif
+
+#if TEST_TRAFFIC == TEST_TRAFFIC_REPLAY
+/*****************************************************************************/
+/**
+*
+* Replays the capture log at REPLAY_LOG_ADDR twice, at its recorded timing
+* and as fast as the bus takes it, and reports the time each pass took.
+* The received frames are checked by ReplayFrameHandler.
+*
+* @param	None.
+*
+* @return	XST_SUCCESS if every frame came back as logged, otherwise
+*		XST_FAILURE or XST_LOOPBACK_ERROR.
+*
+* @note		None.
+*
+******************************************************************************/
+static int ReplayLog(void)
+{
+	const CanLog_Header *LogPtr = (const CanLog_Header *)REPLAY_LOG_ADDR;
+	static const char8 *const PassName[] = { "Timed", "Fast" };
+	static const CanReplay_Mode PassMode[] = {
+		CAN_REPLAY_TIMED, CAN_REPLAY_FAST
+	};
+	CanReplay_Stats Stats;
+	u64 Elapsed;
+	u32 Pass;
+
+	if (!CanLog_IsValid(LogPtr, REPLAY_LOG_MAX_SIZE)) {
+		xil_printf("No capture log at 0x%08x\r\n", REPLAY_LOG_ADDR);
+		return XST_FAILURE;
+	}
+	LatencyHist_Init(&ReplayHist, "Replay due to receive");
+	xil_printf("Replaying %d CAN frames...\r\n", (int)LogPtr->NumRecords);
+
+	for (Pass = 0; Pass < 2U; Pass++) {
+		RecvCount = 0;
+		memset(ReplayCursor, 0, sizeof(ReplayCursor));
+		ExpectedCount = (int)LogPtr->NumRecords;
+		RecvDone = (ExpectedCount == 0) ? TRUE : FALSE;
+		CanLog_Reset(&Capture);
+		CanReplay_Start(&Replay, LogPtr, PassMode[Pass],
+				MonoClock_ClockHz, MonoClock_Now());
+
+		while ((CanReplay_IsDone(&Replay) != TRUE) ||
+		       (RecvDone != TRUE)) {
+			CanReplay_Poll(&Replay, &TxSched, MonoClock_Now());
+			ProcessRxFrames();
+			CanRecovery_Poll(&Recovery, MonoClock_Now());
+			TraceLog_Flush();
+			ExportStats(FALSE);
+			if (LoopbackError == TRUE) {
+				return XST_LOOPBACK_ERROR;
+			}
 		}
+		TraceLog_Flush();
+
+		CanReplay_GetStats(&Replay, &Stats);
+		Elapsed = (Capture.Log->NumRecords != 0U) ?
+			  CanLog_Records(Capture.Log)[Capture.Log->NumRecords -
+						      1U].Ticks - Replay.Start :
+			  0U;
+		xil_printf("%s replay: %d frames in %d us, %d frames/s, "
+			   "queued up to %d us late, %d retries\r\n",
+			   PassName[Pass], (int)Stats.Frames,
+			   (int)(MonoClock_TicksToUs(Elapsed)),
+			   (Elapsed != 0U) ? (int)((u64)Stats.Frames *
+				MonoClock_ClockHz / Elapsed) : 0,
+			   (int)MonoClock_TicksToUs(Stats.MaxLate),
+			   (int)Stats.Retries);
+	}
+
+	LatencyHist_Print(&ReplayHist, TRUE);
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* This function checks a frame received during a replay against the log
+* record it was sent from, the next one of its TX class. In a timed replay
+* it also records how long after its due time the frame was received.
+*
+* @param	CallBackRef is unused.
+* @param	FramePtr is the received frame.
+*
+* @return	None.
+*
+* @note		Frames come back in log order within each TX class: the
+*		scheduler keeps it, the TXHPB and TX FIFO too, and nothing
+*		else sends on the loopback bus. A more urgent class may
+*		overtake a less urgent one.
+*
+******************************************************************************/
+static void ReplayFrameHandler(void *CallBackRef, const u32 *FramePtr)
+{
+	const CanLog_Record *RecordPtr = CanLog_Records(Replay.Log);
+	u32 Class = CanTxSched_ClassOf(&TxSched, FramePtr[0]);
+	u32 Index = ReplayCursor[Class];
+	u32 Dlc = (FramePtr[1] & XCAN_DLCR_DLC_MASK) >> XCAN_DLCR_DLC_SHIFT;
+	u64 DataMask = (Dlc >= 8U) ? ~0ULL : (1ULL << (Dlc * 8U)) - 1ULL;
+	u64 Data = ((u64)FramePtr[3] << 32) | FramePtr[2];
+	u64 Logged;
+
+	(void)CallBackRef;
+
+	while ((Index < Replay.Log->NumRecords) &&
+	       (CanTxSched_ClassOf(&TxSched, RecordPtr[Index].Frame[0]) !=
+		Class)) {
+		Index++;
+	}
+	if (Index >= Replay.Log->NumRecords) {
+		xil_printf("Replayed frame %d was never sent\r\n", RecvCount);
+		LoopbackError = TRUE;
+		return;
+	}
+	ReplayCursor[Class] = Index + 1U;
+	RecordPtr = &RecordPtr[Index];
+	Logged = ((u64)RecordPtr->Frame[3] << 32) | RecordPtr->Frame[2];
+
+	/* Data bytes past the DLC are not transmitted */
+	if ((FramePtr[0] != RecordPtr->Frame[0]) ||
+	    (FramePtr[1] != RecordPtr->Frame[1]) ||
+	    (((Data ^ Logged) & DataMask) != 0U)) {
+		xil_printf("Replayed frame %d came back different\r\n",
+			   (int)Index);
+		LoopbackError = TRUE;
+		return;
 	}
 
-	RecvDone = TRUE;
+	if ((Replay.Mode == CAN_REPLAY_TIMED) &&
+	    ((u32)RecvCount < Capture.Log->NumRecords)) {
+		LatencyHist_Record(&ReplayHist,
+			(u32)(CanLog_Records(Capture.Log)[RecvCount].Ticks -
+			      CanReplay_DueTicks(&Replay, Index)));
+	}
 }
+#endif
 
 /*****************************************************************************/
 /**
 *
 * This function is the interrupt handler for the error interrupt.
+* The causes are recorded in the trace log and printed by the idle loop.
+* Bus errors no longer end the test: the controller retransmits, and
+* goes error passive and bus-off as they accumulate, which Recovery
+* handles.
 *
 * @param	CallBackRef is a pointer to the driver instance.
 * @param	ErrorMask is a mask that indicates the cause of the error.
@@ -416,40 +1130,39 @@ static void ErrorHandler(void *CallBackRef, u32 ErrorMask)
 	XCan *CanPtr = (XCan *)CallBackRef;
 	u32 Status;
 
+	CanStats_Errors(&BusStats, ErrorMask);
+	CanRecovery_Error(&Recovery);
 	if(ErrorMask & XCAN_ESR_ACKER_MASK) {
-		xil_printf("Received ACK Error\r\n");
+		TraceLog_Event(TRACE_EV_CAN_ACK_ERROR, 0, 0);
 	}
 	if(ErrorMask & XCAN_ESR_BERR_MASK) {
-		xil_printf("Received Bit Error\r\n");
+		TraceLog_Event(TRACE_EV_CAN_BIT_ERROR, 0, 0);
 	}
 	if(ErrorMask & XCAN_ESR_STER_MASK) {
-		xil_printf("Received Stuff Error\r\n");
+		TraceLog_Event(TRACE_EV_CAN_STUFF_ERROR, 0, 0);
 	}
 	if(ErrorMask & XCAN_ESR_FMER_MASK) {
-		xil_printf("Received Form Error\r\n");
+		TraceLog_Event(TRACE_EV_CAN_FORM_ERROR, 0, 0);
 	}
 	if(ErrorMask & XCAN_ESR_CRCER_MASK) {
-		xil_printf("Received CRC Error\r\n");
+		TraceLog_Event(TRACE_EV_CAN_CRC_ERROR, 0, 0);
 	}
 
-	/*
-	 * Set error flag
-	 */
-	LoopbackError = TRUE;
-	RecvDone = TRUE;
-	SendDone = TRUE;
-
 	/*
 	 * Clear the error status
 	 */
 	Status = XCan_GetBusErrorStatus(CanPtr);
 	XCan_ClearBusErrorStatus(CanPtr, Status);
+#if TEST_TRAFFIC != TEST_TRAFFIC_REPLAY
+	CanAsync_Post(&Async, CAN_ASYNC_EV_ERROR);
+#endif
 }
 
 /*****************************************************************************/
 /**
 *
 * This function is the interrupt handler for the event interrupt.
+* The causes are recorded in the trace log and printed by the idle loop.
 *
 * @param	CallBackRef is a pointer to the driver instance.
 * @param	Mask is a mask that indicates the cause of the event.
@@ -461,25 +1174,31 @@ static void ErrorHandler(void *CallBackRef, u32 ErrorMask)
 ******************************************************************************/
 static void EventHandler(void *CallBackRef, u32 Mask)
 {
+	CanStats_Events(&BusStats, Mask);
+
 	/* Handle various events */
 	if (Mask & XCAN_IXR_BSOFF_MASK) {
-		xil_printf("Bus Off event\r\n");
-		LoopbackError = TRUE;
-		RecvDone = TRUE;
-		SendDone = TRUE;
+		/* Off the bus until the back-off has elapsed */
+		TraceLog_Event(TRACE_EV_CAN_BUS_OFF, 0, 0);
+		CanRecovery_BusOff(&Recovery, MonoClock_Now());
 	}
 	if (Mask & XCAN_IXR_RXOFLW_MASK) {
-		xil_printf("RX FIFO Overflow event\r\n");
+		/* Frames were lost in hardware */
+		RxFifoOverflows = RxFifoOverflows + 1;
+		TraceLog_Event(TRACE_EV_CAN_RX_OVERFLOW, RxFifoOverflows, 0);
 	}
 	if (Mask & XCAN_IXR_WKUP_MASK) {
-		xil_printf("Wake up event\r\n");
+		TraceLog_Event(TRACE_EV_CAN_WAKE_UP, 0, 0);
 	}
 	if (Mask & XCAN_IXR_SLP_MASK) {
-		xil_printf("Sleep event\r\n");
+		TraceLog_Event(TRACE_EV_CAN_SLEEP, 0, 0);
 	}
 	if (Mask & XCAN_IXR_ARBLST_MASK) {
-		xil_printf("Arbitration lost event\r\n");
+		TraceLog_Event(TRACE_EV_CAN_ARB_LOST, 0, 0);
 	}
+#if TEST_TRAFFIC != TEST_TRAFFIC_REPLAY
+	CanAsync_Post(&Async, CAN_ASYNC_EV_ERROR);
+#endif
 }
 
 /*****************************************************************************/
@@ -510,11 +1229,11 @@ static int SetupInterruptSystem(XCan *InstancePtr)
 	}
 
 	/*
-	 * Connect the device driver handler
+	 * Connect the interrupt handler
 	 */
 	Status = XIntc_Connect(&InterruptController,
 				CAN_INTR_VEC_ID,
-				(XInterruptHandler)XCan_IntrHandler,
+				(XInterruptHandler)CanIsr,
 				InstancePtr);
 	if (Status != XST_SUCCESS) {
 		return XST_FAILURE;
@@ -533,6 +1252,18 @@ static int SetupInterruptSystem(XCan *InstancePtr)
 	 */
 	XIntc_Enable(&InterruptController, CAN_INTR_VEC_ID);
 
+	/*
+	 * Connect the poll timer, which does not nest with the CAN
+	 */
+	Status = XIntc_Connect(&InterruptController,
+				POLL_TIMER_INTR_VEC_ID,
+				(XInterruptHandler)XTmrCtr_InterruptHandler,
+				&PollTimer);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+	XIntc_Enable(&InterruptController, POLL_TIMER_INTR_VEC_ID);
+
 	/*
 	 * Initialize the exception table
 	 */
@@ -578,7 +1309,7 @@ static int SetupInterruptSystem(XCan *InstancePtr)
 	 * Connect the interrupt handler
 	 */
 	Status = XScuGic_Connect(&InterruptController, CAN_INTR_VEC_ID,
-				(Xil_InterruptHandler)XCan_IntrHandler,
+				(Xil_InterruptHandler)CanIsr,
 				InstancePtr);
 	if (Status != XST_SUCCESS) {
 		return XST_FAILURE;
@@ -589,6 +1320,20 @@ static int SetupInterruptSystem(XCan *InstancePtr)
 	 */
 	XScuGic_Enable(&InterruptController, CAN_INTR_VEC_ID);
 
+	/*
+	 * Connect the poll timer at the priority of the CAN, so that the
+	 * two handlers never nest
+	 */
+	XScuGic_SetPriorityTriggerType(&InterruptController,
+					POLL_TIMER_INTR_VEC_ID, 0xA0, 0x3);
+	Status = XScuGic_Connect(&InterruptController, POLL_TIMER_INTR_VEC_ID,
+				(Xil_InterruptHandler)XTmrCtr_InterruptHandler,
+				&PollTimer);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+	XScuGic_Enable(&InterruptController, POLL_TIMER_INTR_VEC_ID);
+
 	/*
 	 * Initialize the exception table
 	 */
@@ -610,3 +1355,39 @@ static int SetupInterruptSystem(XCan *InstancePtr)
 
 	return XST_SUCCESS;
 }
+
+/*****************************************************************************/
+/**
+*
+* CAN interrupt service routine, connected to the interrupt controller in
+* place of XCan_IntrHandler. It records the interval since the previous
+* CAN interrupt and the execution time of the driver handler, and runs
+* the handler between CanStats_WriteBegin and CanStats_WriteEnd, so that
+* readers of BusStats see a torn snapshot and retry. Both interrupt
+* controllers must connect it for that to hold.
+*
+* @param	InstancePtr is a pointer to the XCan instance.
+*
+* @return	None.
+*
+* @note		The AXI CAN does not timestamp frames, so the latency from
+*		the event to handler entry cannot be read directly. Under
+*		periodic traffic its jitter shows as the spread of the
+*		interval histogram.
+*
+******************************************************************************/
+static void CanIsr(void *InstancePtr)
+{
+	u32 Entry = Timestamp_Now();
+
+	if (CanExecHist.Samples != 0U) {
+		LatencyHist_Record(&CanIntervalHist, Entry - CanLastEntry);
+	}
+	CanLastEntry = Entry;
+
+	CanStats_WriteBegin(&BusStats);
+	XCan_IntrHandler(InstancePtr);
+	CanStats_WriteEnd(&BusStats);
+
+	LatencyHist_Record(&CanExecHist, Timestamp_Now() - Entry);
+}
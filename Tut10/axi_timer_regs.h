@@ -0,0 +1,182 @@
+/******************************************************************************
+* Typed AXI Timer register access
+*
+* Compile-time description of the TCSR, TLR and TCR registers of each AXI
+* Timer counter and of the TCSR bitfields, replacing magic constants such
+* as 0x0F4 written through raw pointers:
+*
+*	using Timer0 = AxiTimer_Counter<XPAR_AXI_TIMER_0_BASEADDR, 0>;
+*
+*	Timer0::TLR::Write(TLR_VALUE(0));
+*	Timer0::TCSR::Write<TCSR_ENIT | TCSR_LOAD | TCSR_ARHT | TCSR_GENT>();
+*	Timer0::TCSR::Modify<~TCSR_LOAD | TCSR_ENT>();
+*
+* A field value carries the bits it sets and the mask of the bits it
+* covers. Values are combined with | and a field is cleared with ~, all in
+* constexpr arithmetic, so any combination of fields becomes one constant:
+* Write<> is a single volatile store of it and Modify<> a single read and
+* a single store. Write<> takes the value as a template argument, so the
+* merge is guaranteed to happen at compile time, at any optimization
+* level. Every field is tied to its register type: using a TCSR field on
+* TLR does not compile.
+*
+* Write<> stores 0 to every field it does not name, as the raw constants
+* did. T0INT is write-one-to-clear, so writing 0 to it leaves a pending
+* interrupt alone. Modify<> stores back what it read, in which a pending
+* T0INT is 1, so it clears the write-one-to-clear bits of the layout
+* (W1cMask) from the value read: only a Modify<> that names T0INT, e.g.
+* Modify<TCSR_T0INT>(), acknowledges the interrupt.
+******************************************************************************/
+
+#ifndef AXI_TIMER_REGS_H		/* prevent circular inclusions */
+#define AXI_TIMER_REGS_H
+
+/***************************** Include Files *********************************/
+
+#include "xil_types.h"
+#include "xtmrctr_l.h"
+
+/**************************** Type Definitions *******************************/
+
+/*
+ * Value of some fields of register Reg: the bits to store and the mask of
+ * the fields they cover
+ */
+template <typename Reg>
+struct RegValue {
+	u32 Bits;
+	u32 Mask;
+
+	constexpr RegValue operator|(RegValue Other) const
+	{
+		return RegValue{Bits | Other.Bits, Mask | Other.Mask};
+	}
+
+	/* The same fields, all cleared */
+	constexpr RegValue operator~() const
+	{
+		return RegValue{0U, Mask};
+	}
+};
+
+/* A Width-bit field at bit Pos of register Reg */
+template <typename Reg, u32 Pos, u32 Width>
+struct RegField {
+	static_assert(Width >= 1U && Pos + Width <= 32U,
+		      "field does not fit in a 32-bit register");
+
+	static constexpr u32 Mask =
+		(u32)((((u64)1U << Width) - 1U) << Pos);
+
+	/* The field set to Value, truncated to the field width */
+	constexpr RegValue<Reg> operator()(u32 Value) const
+	{
+		return RegValue<Reg>{(Value << Pos) & Mask, Mask};
+	}
+};
+
+/* A one-bit field, named by its set state */
+template <typename Reg, u32 Pos>
+inline constexpr RegValue<Reg> RegFlag{1U << Pos, 1U << Pos};
+
+/* One memory-mapped register of layout Reg at a fixed address */
+template <UINTPTR Address, typename Reg>
+struct MmioReg {
+	static u32 Read(void)
+	{
+		return *(volatile u32 *)Address;
+	}
+
+	/* One store of a value known at compile time */
+	template <RegValue<Reg> Value>
+	static void Write(void)
+	{
+		*(volatile u32 *)Address = Value.Bits;
+	}
+
+	/* One store of a value computed at run time */
+	static void Write(RegValue<Reg> Value)
+	{
+		*(volatile u32 *)Address = Value.Bits;
+	}
+
+	/*
+	 * One read and one store, fields outside Value are kept, except the
+	 * write-one-to-clear ones, which are stored as 0 unless Value names
+	 * them
+	 */
+	template <RegValue<Reg> Value>
+	static void Modify(void)
+	{
+		*(volatile u32 *)Address =
+			(Read() & ~(Value.Mask | Reg::W1cMask)) | Value.Bits;
+	}
+
+	/* Tells whether every field of Value currently holds its bits */
+	template <RegValue<Reg> Value>
+	static bool Test(void)
+	{
+		return (Read() & Value.Mask) == Value.Bits;
+	}
+};
+
+/* Register layouts, with the bits a 1 written to clears */
+struct AxiTimer_Tcsr {
+	static constexpr u32 W1cMask = XTC_CSR_INT_OCCURED_MASK;
+};
+struct AxiTimer_Tlr {
+	static constexpr u32 W1cMask = 0U;
+};
+struct AxiTimer_Tcr {
+	static constexpr u32 W1cMask = 0U;
+};
+
+/* The registers of counter Counter of the AXI Timer at BaseAddress */
+template <UINTPTR BaseAddress, u32 Counter>
+struct AxiTimer_Counter {
+	static_assert(Counter < XTC_DEVICE_TIMER_COUNT, "no such counter");
+
+	static constexpr UINTPTR Base =
+		BaseAddress + Counter * XTC_TIMER_COUNTER_OFFSET;
+
+	using TCSR = MmioReg<Base + XTC_TCSR_OFFSET, AxiTimer_Tcsr>;
+	using TLR = MmioReg<Base + XTC_TLR_OFFSET, AxiTimer_Tlr>;
+	using TCR = MmioReg<Base + XTC_TCR_OFFSET, AxiTimer_Tcr>;
+};
+
+/************************** Variable Definitions *****************************/
+
+/* TCSR fields, see PG079 */
+inline constexpr auto TCSR_MDT = RegFlag<AxiTimer_Tcsr, 0>;	/**< Capture mode */
+inline constexpr auto TCSR_UDT = RegFlag<AxiTimer_Tcsr, 1>;	/**< Count down */
+inline constexpr auto TCSR_GENT = RegFlag<AxiTimer_Tcsr, 2>;	/**< GENERATEOUT on */
+inline constexpr auto TCSR_CAPT = RegFlag<AxiTimer_Tcsr, 3>;	/**< CAPTURETRIG on */
+inline constexpr auto TCSR_ARHT = RegFlag<AxiTimer_Tcsr, 4>;	/**< Auto reload/hold */
+inline constexpr auto TCSR_LOAD = RegFlag<AxiTimer_Tcsr, 5>;	/**< Load TLR */
+inline constexpr auto TCSR_ENIT = RegFlag<AxiTimer_Tcsr, 6>;	/**< Interrupt on */
+inline constexpr auto TCSR_ENT = RegFlag<AxiTimer_Tcsr, 7>;	/**< Counter on */
+inline constexpr auto TCSR_T0INT = RegFlag<AxiTimer_Tcsr, 8>;	/**< Interrupt, W1C */
+inline constexpr auto TCSR_PWMA = RegFlag<AxiTimer_Tcsr, 9>;	/**< PWM mode */
+inline constexpr auto TCSR_ENALL = RegFlag<AxiTimer_Tcsr, 10>;	/**< Both counters on */
+inline constexpr auto TCSR_CASC = RegFlag<AxiTimer_Tcsr, 11>;	/**< 64-bit cascade */
+
+/* TLR and TCR hold a single 32-bit count */
+inline constexpr RegField<AxiTimer_Tlr, 0, 32> TLR_VALUE{};
+inline constexpr RegField<AxiTimer_Tcr, 0, 32> TCR_VALUE{};
+
+/* The field positions agree with the driver masks */
+static_assert(TCSR_MDT.Bits == XTC_CSR_CAPTURE_MODE_MASK &&
+	      TCSR_UDT.Bits == XTC_CSR_DOWN_COUNT_MASK &&
+	      TCSR_GENT.Bits == XTC_CSR_EXT_GENERATE_MASK &&
+	      TCSR_CAPT.Bits == XTC_CSR_EXT_CAPTURE_MASK &&
+	      TCSR_ARHT.Bits == XTC_CSR_AUTO_RELOAD_MASK &&
+	      TCSR_LOAD.Bits == XTC_CSR_LOAD_MASK &&
+	      TCSR_ENIT.Bits == XTC_CSR_ENABLE_INT_MASK &&
+	      TCSR_ENT.Bits == XTC_CSR_ENABLE_TMR_MASK &&
+	      TCSR_T0INT.Bits == XTC_CSR_INT_OCCURED_MASK &&
+	      TCSR_PWMA.Bits == XTC_CSR_ENABLE_PWM_MASK &&
+	      TCSR_ENALL.Bits == XTC_CSR_ENABLE_ALL_MASK &&
+	      TCSR_CASC.Bits == XTC_CSR_CASC_MASK,
+	      "TCSR field layout");
+
+#endif	/* end of protection macro */
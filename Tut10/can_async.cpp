@@ -0,0 +1,377 @@
+/******************************************************************************
+* Coroutine CAN transfers on a single-threaded WFI executor
+*
+* See can_async.h for the design.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <exception>
+
+#include "xstatus.h"
+#include "xil_exception.h"
+#include "xpseudo_asm.h"
+#include "can_async.h"
+
+/************************** Constant Definitions *****************************/
+
+static_assert(CAN_ASYNC_FRAMES <= 32U, "FreeMask has 32 bits");
+static_assert(CAN_ASYNC_BLOCK_SIZE % CAN_ASYNC_BLOCK_HEADER == 0U,
+	      "blocks must keep the frames aligned");
+
+/************************** Function Prototypes ******************************/
+
+static void CanAsync_Link(CanAsync *AsyncPtr, CanAsync_Wait *WaitPtr);
+static int CanAsync_SendDone(CanAsync_Wait *WaitPtr);
+
+/*****************************************************************************/
+/**
+*
+* Initializes the executor with every frame of the pool free.
+*
+* @param	AsyncPtr is a pointer to the executor.
+* @param	SchedPtr is the TX scheduler CanAsync_Send queues on. Its
+*		CanTxSched_SendHandler must be followed by a post of
+*		CAN_ASYNC_EV_TX.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanAsync_Init(CanAsync *AsyncPtr, CanTxSched *SchedPtr)
+{
+	AsyncPtr->SchedPtr = SchedPtr;
+	AsyncPtr->FreeMask = ~0U >> (32U - CAN_ASYNC_FRAMES);
+	AsyncPtr->Running = 0U;
+	AsyncPtr->Head = NULL;
+	AsyncPtr->TailPtr = &AsyncPtr->Head;
+	AsyncPtr->Receivers = NULL;
+	AsyncPtr->Pending.store(0U, std::memory_order_relaxed);
+
+	AsyncPtr->Stats.Started = 0U;
+	AsyncPtr->Stats.Failed = 0U;
+	AsyncPtr->Stats.MaxFrames = 0U;
+	AsyncPtr->Stats.MaxFrameSize = 0U;
+	AsyncPtr->Stats.Resumes = 0U;
+	AsyncPtr->Stats.Sleeps = 0U;
+}
+
+/*****************************************************************************/
+/**
+*
+* Runs the tasks until all have returned, sleeping in WFI while none can
+* run.
+*
+* @param	AsyncPtr is a pointer to the executor.
+* @param	PollFn is called on every pass, after the waits are
+*		checked, to drain the receive queue into CanAsync_Deliver and
+*		do the other task context work. It returns FALSE to keep the
+*		executor from sleeping, while it waits for something no
+*		interrupt signals, such as a back-off. May be NULL.
+* @param	CallBackRef is passed to PollFn.
+*
+* @return	None.
+*
+* @note		A pass walks the waits detached from the list, so a task
+*		that waits again as soon as it is resumed, or yields, runs
+*		once per pass and the others get their turn. The waits come
+*		first so that a task whose send completes on this pass is
+*		already waiting for the reply when PollFn delivers it.
+*
+******************************************************************************/
+void CanAsync_Run(CanAsync *AsyncPtr, CanAsync_PollFn PollFn,
+		  void *CallBackRef)
+{
+	CanAsync_Wait *WaitPtr;
+	CanAsync_Wait *NextPtr;
+	u32 Resumes;
+	u32 Events;
+	int Sleep;
+
+	while (AsyncPtr->Running != 0U) {
+		Resumes = AsyncPtr->Stats.Resumes;
+		Events = AsyncPtr->Pending.exchange(0U,
+						    std::memory_order_acquire);
+
+		WaitPtr = AsyncPtr->Head;
+		AsyncPtr->Head = NULL;
+		AsyncPtr->TailPtr = &AsyncPtr->Head;
+		while (WaitPtr != NULL) {
+			NextPtr = WaitPtr->Next;
+			if ((WaitPtr->Done == NULL) ||
+			    (((WaitPtr->Events & Events) != 0U) &&
+			     WaitPtr->Done(WaitPtr))) {
+				AsyncPtr->Stats.Resumes++;
+				WaitPtr->Handle.resume();
+			} else {
+				CanAsync_Link(AsyncPtr, WaitPtr);
+			}
+			WaitPtr = NextPtr;
+		}
+		Sleep = (PollFn == NULL) ? TRUE : PollFn(CallBackRef);
+
+		if (!Sleep || (AsyncPtr->Stats.Resumes != Resumes)) {
+			continue;
+		}
+		Xil_ExceptionDisable();
+		if (AsyncPtr->Pending.load(std::memory_order_relaxed) == 0U) {
+			AsyncPtr->Stats.Sleeps++;
+			wfi();
+		}
+		Xil_ExceptionEnable();
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Signals events to the executor, waking it if it sleeps. Call it from
+* the interrupt handlers.
+*
+* @param	AsyncPtr is a pointer to the executor.
+* @param	Events is a mask of CAN_ASYNC_EV_* bits.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanAsync_Post(CanAsync *AsyncPtr, u32 Events)
+{
+	AsyncPtr->Pending.fetch_or(Events, std::memory_order_release);
+}
+
+/*****************************************************************************/
+/**
+*
+* Completes the oldest receive waiting for a frame of this ID, handing it
+* a new reference to the frame and running its task up to its next wait.
+* Task context only, normally from the frame handlers of the poll
+* function.
+*
+* @param	AsyncPtr is a pointer to the executor.
+* @param	FramePtr is the frame, of which the caller keeps its own
+*		reference.
+*
+* @return	TRUE if a task took the frame, FALSE if none was waiting for
+*		it.
+*
+******************************************************************************/
+int CanAsync_Deliver(CanAsync *AsyncPtr, CanPool_Frame *FramePtr)
+{
+	CanAsync_Wait **LinkPtr = &AsyncPtr->Receivers;
+	CanAsync_RecvOp *OpPtr;
+
+	for (; *LinkPtr != NULL; LinkPtr = &(*LinkPtr)->Next) {
+		OpPtr = (CanAsync_RecvOp *)*LinkPtr;
+		if (((FramePtr->Words[0] ^ OpPtr->Id) & OpPtr->Mask) != 0U) {
+			continue;
+		}
+
+		*LinkPtr = OpPtr->Wait.Next;
+		CanPool_Ref(FramePtr);
+		OpPtr->FramePtr = FramePtr;
+		AsyncPtr->Stats.Resumes++;
+		OpPtr->Wait.Handle.resume();
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the executor statistics.
+*
+* @param	AsyncPtr is a pointer to the executor.
+* @param	StatsPtr is where the statistics are returned.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanAsync_GetStats(CanAsync *AsyncPtr, CanAsync_Stats *StatsPtr)
+{
+	*StatsPtr = AsyncPtr->Stats;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the awaitable of a send. FramePtr must stay valid until the
+* await completes, the frame being copied only once its class has room.
+*
+******************************************************************************/
+CanAsync_SendOp CanAsync_Send(CanAsync *AsyncPtr, const u32 *FramePtr)
+{
+	return CanAsync_SendOp{ { NULL, {}, CAN_ASYNC_EV_TX,
+				  CanAsync_SendDone },
+				AsyncPtr, FramePtr, 0U, 0U, FALSE };
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the awaitable of a receive. Id and Mask are in the XCAN_IDR
+* layout; the await returns the frame, whose reference the task must
+* release with CanPool_Release.
+*
+******************************************************************************/
+CanAsync_RecvOp CanAsync_Recv(CanAsync *AsyncPtr, u32 Id, u32 Mask)
+{
+	return CanAsync_RecvOp{ { NULL, {}, 0U, NULL }, AsyncPtr, Id, Mask,
+				NULL };
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the awaitable of a yield, which resumes on the next pass.
+*
+******************************************************************************/
+CanAsync_YieldOp CanAsync_Yield(CanAsync *AsyncPtr)
+{
+	return CanAsync_YieldOp{ { NULL, {}, 0U, NULL }, AsyncPtr };
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes a block of the pool for the frame of a new task.
+*
+******************************************************************************/
+void *CanTask::promise_type::Alloc(CanAsync *Async, size_t Size) noexcept
+{
+	u8 *BlockPtr;
+	u32 Index;
+	u32 Used;
+
+	if (Size > Async->Stats.MaxFrameSize) {
+		Async->Stats.MaxFrameSize = (u32)Size;
+	}
+	if ((Size > CAN_ASYNC_BLOCK_SIZE - CAN_ASYNC_BLOCK_HEADER) ||
+	    (Async->FreeMask == 0U)) {
+		Async->Stats.Failed++;
+		return NULL;
+	}
+
+	Index = (u32)__builtin_ctz(Async->FreeMask);
+	Async->FreeMask &= ~(1U << Index);
+	Used = CAN_ASYNC_FRAMES - (u32)__builtin_popcount(Async->FreeMask);
+	if (Used > Async->Stats.MaxFrames) {
+		Async->Stats.MaxFrames = Used;
+	}
+	Async->Stats.Started++;
+
+	BlockPtr = Async->Pool[Index];
+	*(CanAsync **)BlockPtr = Async;
+	return BlockPtr + CAN_ASYNC_BLOCK_HEADER;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the block of a task that has returned to the pool.
+*
+******************************************************************************/
+void CanTask::promise_type::Free(void *Ptr) noexcept
+{
+	u8 *BlockPtr = (u8 *)Ptr - CAN_ASYNC_BLOCK_HEADER;
+	CanAsync *Async = *(CanAsync **)BlockPtr;
+	u32 Index = (u32)((BlockPtr - Async->Pool[0]) / CAN_ASYNC_BLOCK_SIZE);
+
+	Async->FreeMask |= 1U << Index;
+}
+
+/*****************************************************************************/
+/**
+*
+* The tasks have no one to throw to: an exception escaping one is fatal,
+* as it would be in a build without exceptions.
+*
+******************************************************************************/
+void CanTask::promise_type::unhandled_exception() noexcept
+{
+	std::terminate();
+}
+
+/*****************************************************************************/
+/**
+*
+* Queues the frame if its class has room and tells whether it has been
+* sent. Skips the call rather than have the scheduler count a rejected
+* send for every retry.
+*
+******************************************************************************/
+bool CanAsync_SendOp::await_ready() noexcept
+{
+	return CanAsync_SendDone(&Wait);
+}
+
+void CanAsync_SendOp::await_suspend(std::coroutine_handle<> Handle) noexcept
+{
+	Wait.Handle = Handle;
+	CanAsync_Link(AsyncPtr, &Wait);
+}
+
+void CanAsync_RecvOp::await_suspend(std::coroutine_handle<> Handle) noexcept
+{
+	CanAsync_Wait **LinkPtr = &AsyncPtr->Receivers;
+
+	while (*LinkPtr != NULL) {
+		LinkPtr = &(*LinkPtr)->Next;
+	}
+	Wait.Handle = Handle;
+	Wait.Next = NULL;
+	*LinkPtr = &Wait;
+}
+
+void CanAsync_YieldOp::await_suspend(std::coroutine_handle<> Handle)
+	noexcept
+{
+	Wait.Handle = Handle;
+	CanAsync_Link(AsyncPtr, &Wait);
+}
+
+/*****************************************************************************/
+/**
+*
+* Appends a wait to the list the executor checks.
+*
+******************************************************************************/
+static void CanAsync_Link(CanAsync *AsyncPtr, CanAsync_Wait *WaitPtr)
+{
+	WaitPtr->Next = NULL;
+	*AsyncPtr->TailPtr = WaitPtr;
+	AsyncPtr->TailPtr = &WaitPtr->Next;
+}
+
+/*****************************************************************************/
+/**
+*
+* The Done function of a send: queues the frame once its class has room,
+* then waits for the class to retire past it.
+*
+******************************************************************************/
+static int CanAsync_SendDone(CanAsync_Wait *WaitPtr)
+{
+	CanAsync_SendOp *OpPtr = (CanAsync_SendOp *)WaitPtr;
+	CanTxSched *SchedPtr = OpPtr->AsyncPtr->SchedPtr;
+	CanTxSched_Class *ClassPtr;
+	u32 Done;
+
+	if (!OpPtr->Queued) {
+		OpPtr->Class = CanTxSched_ClassOf(SchedPtr,
+						  OpPtr->FramePtr[0]);
+		ClassPtr = &SchedPtr->Class[OpPtr->Class];
+		OpPtr->Seq = ClassPtr->Head.load(std::memory_order_relaxed);
+		Done = ClassPtr->Done.load(std::memory_order_acquire);
+		if ((OpPtr->Seq - Done == CAN_TXS_CLASS_SIZE) ||
+		    (CanTxSched_Send(SchedPtr, OpPtr->FramePtr) !=
+		     XST_SUCCESS)) {
+			return FALSE;
+		}
+		OpPtr->Queued = TRUE;
+	}
+
+	ClassPtr = &SchedPtr->Class[OpPtr->Class];
+	Done = ClassPtr->Done.load(std::memory_order_acquire);
+	return (s32)(Done - OpPtr->Seq) > 0;
+}
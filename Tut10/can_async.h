@@ -0,0 +1,228 @@
+/******************************************************************************
+* Coroutine CAN transfers on a single-threaded WFI executor
+*
+* C++20 coroutines that wait for transmit completions and received frames
+* instead of spinning on flags set by the interrupt handlers:
+*
+*	static CanTask Echo(CanAsync *AsyncPtr)
+*	{
+*		CanPool_Frame *FramePtr;
+*
+*		for (;;) {
+*			FramePtr = co_await CanAsync_Recv(AsyncPtr, Id, Mask);
+*			co_await CanAsync_Send(AsyncPtr, FramePtr->Words);
+*			CanPool_Release(&Pool, FramePtr);
+*		}
+*	}
+*
+*	CanAsync_Init(&Async, &TxSched);
+*	Echo(&Async);			runs up to its first wait
+*	CanAsync_Run(&Async, Poll, Ref);	until every task has returned
+*
+* A task is a coroutine returning CanTask whose first parameter is the
+* CanAsync it runs on. It starts at once, in its caller, and its frame
+* comes from a pool of CAN_ASYNC_FRAMES blocks in the CanAsync, never from
+* the heap: when the pool is exhausted or the frame does not fit in a
+* block the task is not started and its CanTask is not Started.
+* CanAsync_GetStats reports the largest frame asked for, which depends on
+* the compiler and its options, to size CAN_ASYNC_BLOCK_SIZE.
+*
+*	CanAsync_Send	queues a frame on the TX scheduler, waiting for room
+*			in its class, and completes on its TXOK
+*	CanAsync_Recv	completes with the next frame whose ID register
+*			matches Id under Mask, of those the application
+*			passes to CanAsync_Deliver, holding a reference
+*			to it the task releases
+*	CanAsync_Yield	lets the other tasks run
+*
+* The tasks run in task context only, one at a time, resumed from
+* CanAsync_Run or, for a receive, from CanAsync_Deliver. The interrupt
+* handlers only post events, with CanAsync_Post: SendHandler
+* CAN_ASYNC_EV_TX, RecvHandler CAN_ASYNC_EV_RX and the error handlers
+* CAN_ASYNC_EV_ERROR. Each pass of the executor re-checks the waits on
+* the events posted since the last pass, resumes the tasks whose wait is
+* over, then calls the poll function, which drains the receive queue and
+* does the other task context work. With no task resumed and no event
+* posted, it masks interrupts and sleeps in WFI, which still wakes on the
+* pending interrupt, so an event posted after the check is never lost.
+*
+* A frame no task waits for is refused by CanAsync_Deliver. The caller
+* may treat it as unexpected or, to give a task that is still waiting
+* for its send the time to ask for it, leave it queued for the next
+* pass.
+******************************************************************************/
+
+#ifndef CAN_ASYNC_H		/* prevent circular inclusions */
+#define CAN_ASYNC_H
+
+/***************************** Include Files *********************************/
+
+#include <stddef.h>
+#include <atomic>
+#include <coroutine>
+
+#include "xil_types.h"
+#include "can_txsched.h"
+#include "can_pool.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Task frames in the pool, at most 32, and the bytes of each block */
+#define CAN_ASYNC_FRAMES		8U
+#define CAN_ASYNC_BLOCK_SIZE		256U
+
+/* Bytes of a block before the frame, holding its CanAsync */
+#define CAN_ASYNC_BLOCK_HEADER		16U
+
+/* Words per frame, as XCan_Send and XCan_Recv use */
+#define CAN_ASYNC_FRAME_WORDS		(XCAN_MAX_FRAME_SIZE / sizeof(u32))
+
+/* Events for CanAsync_Post */
+#define CAN_ASYNC_EV_TX			0x00000001U	/**< TXOK */
+#define CAN_ASYNC_EV_RX			0x00000002U	/**< Frames received */
+#define CAN_ASYNC_EV_ERROR		0x00000004U	/**< Errors, bus-off */
+
+/**************************** Type Definitions *******************************/
+
+/*
+ * A suspended task and how to tell its wait is over. Each awaitable keeps
+ * one, first in it, in the frame of the waiting task.
+ */
+typedef struct CanAsync_Wait {
+	struct CanAsync_Wait *Next;
+	std::coroutine_handle<> Handle;
+	u32 Events;			/**< Events to re-check it on */
+	int (*Done)(struct CanAsync_Wait *WaitPtr);	/**< NULL at once */
+} CanAsync_Wait;
+
+typedef struct {
+	u32 Started;			/**< Tasks given a frame */
+	u32 Failed;			/**< Tasks refused one */
+	u32 MaxFrames;			/**< Most frames in use */
+	u32 MaxFrameSize;		/**< Largest frame asked for, bytes */
+	u32 Resumes;			/**< Waits completed */
+	u32 Sleeps;			/**< WFIs entered */
+} CanAsync_Stats;
+
+/* Task context work, returns FALSE if the executor must not sleep */
+typedef int (*CanAsync_PollFn)(void *CallBackRef);
+
+typedef struct CanAsync {
+	CanTxSched *SchedPtr;
+	alignas(CAN_ASYNC_BLOCK_HEADER)
+		u8 Pool[CAN_ASYNC_FRAMES][CAN_ASYNC_BLOCK_SIZE];
+	u32 FreeMask;			/**< Bit set per free block */
+	u32 Running;			/**< Tasks not returned yet */
+	CanAsync_Wait *Head;		/**< Waits on events, oldest first */
+	CanAsync_Wait **TailPtr;
+	CanAsync_Wait *Receivers;	/**< Receive waits, oldest first */
+	std::atomic<u32> Pending;	/**< Events posted (interrupts) */
+	CanAsync_Stats Stats;
+} CanAsync;
+
+/*
+ * The return type of a task. Its frame is destroyed when it returns;
+ * nothing is returned to the caller but whether it started.
+ */
+struct CanTask {
+	struct promise_type {
+		CanAsync *AsyncPtr;
+
+		template <typename... Args>
+		promise_type(CanAsync *Async, Args &...) noexcept
+			: AsyncPtr(Async)
+		{
+			AsyncPtr->Running++;
+		}
+
+		~promise_type()
+		{
+			AsyncPtr->Running--;
+		}
+
+		template <typename... Args>
+		static void *operator new(size_t Size, CanAsync *Async,
+					  Args &...) noexcept
+		{
+			return Alloc(Async, Size);
+		}
+
+		static void operator delete(void *Ptr) noexcept
+		{
+			Free(Ptr);
+		}
+
+		static void *Alloc(CanAsync *Async, size_t Size) noexcept;
+		static void Free(void *Ptr) noexcept;
+
+		static CanTask get_return_object_on_allocation_failure()
+			noexcept
+		{
+			return CanTask{ FALSE };
+		}
+
+		CanTask get_return_object() noexcept
+		{
+			return CanTask{ TRUE };
+		}
+
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() noexcept {}
+		void unhandled_exception() noexcept;
+	};
+
+	int Started;
+};
+
+/* co_await CanAsync_Send(AsyncPtr, FramePtr) */
+struct CanAsync_SendOp {
+	CanAsync_Wait Wait;
+	CanAsync *AsyncPtr;
+	const u32 *FramePtr;
+	u32 Class;
+	u32 Seq;			/**< Class Head it was queued at */
+	u32 Queued;
+
+	bool await_ready() noexcept;
+	void await_suspend(std::coroutine_handle<> Handle) noexcept;
+	void await_resume() noexcept {}
+};
+
+/* FramePtr = co_await CanAsync_Recv(AsyncPtr, Id, Mask) */
+struct CanAsync_RecvOp {
+	CanAsync_Wait Wait;
+	CanAsync *AsyncPtr;
+	u32 Id;
+	u32 Mask;
+	CanPool_Frame *FramePtr;	/**< Frame delivered, referenced */
+
+	bool await_ready() noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> Handle) noexcept;
+	CanPool_Frame *await_resume() noexcept { return FramePtr; }
+};
+
+/* co_await CanAsync_Yield(AsyncPtr) */
+struct CanAsync_YieldOp {
+	CanAsync_Wait Wait;
+	CanAsync *AsyncPtr;
+
+	bool await_ready() noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> Handle) noexcept;
+	void await_resume() noexcept {}
+};
+
+/************************** Function Prototypes ******************************/
+
+void CanAsync_Init(CanAsync *AsyncPtr, CanTxSched *SchedPtr);
+void CanAsync_Run(CanAsync *AsyncPtr, CanAsync_PollFn PollFn,
+		  void *CallBackRef);
+void CanAsync_Post(CanAsync *AsyncPtr, u32 Events);
+int CanAsync_Deliver(CanAsync *AsyncPtr, CanPool_Frame *FramePtr);
+void CanAsync_GetStats(CanAsync *AsyncPtr, CanAsync_Stats *StatsPtr);
+
+CanAsync_SendOp CanAsync_Send(CanAsync *AsyncPtr, const u32 *FramePtr);
+CanAsync_RecvOp CanAsync_Recv(CanAsync *AsyncPtr, u32 Id, u32 Mask);
+CanAsync_YieldOp CanAsync_Yield(CanAsync *AsyncPtr);
+
+#endif	/* end of protection macro */
@@ -0,0 +1,243 @@
+/******************************************************************************
+* CAN bit timing solver
+*
+* Finds the Baud Rate Prescaler Register (BRPR) and Bit Timing Register
+* (BTR) settings of the AXI CAN controller for a CAN clock, a bit rate and
+* a sample point, instead of working them out by hand for every rate:
+*
+*	constexpr CanBitTiming Timing =
+*		CanBitTiming_Check<24000000, 1000000, 875>();
+*	CanBitTiming_Apply(&Can, &Timing);
+*
+* A bit is 1 + TSEG1 + TSEG2 time quanta of (BRP + 1) CAN clocks, sampled
+* at the end of TSEG1. The solver tries every legal prescaler (1..256) and
+* split (TSEG1 1..16, TSEG2 1..8 and no longer than TSEG1, 8 to 25 quanta
+* per bit) and keeps the one with, in order:
+*
+*	- the smallest bit rate error
+*	- the sample point closest to the one asked for, the earlier one of
+*	  two equally close
+*	- the most quanta per bit, for the finest resynchronization
+*
+* SJW does not change the bit rate or the sample point; it is set to the
+* largest the controller takes, min(4, TSEG2), which tolerates the most
+* oscillator drift.
+*
+* Those ranges are the AXI CAN ones; passing CanBitTiming_Limits of another
+* controller solves for its registers instead, see canfd_bit_timing.h.
+*
+* CanBitTiming_Solve is constexpr and works on any inputs, at run time too.
+* CanBitTiming_Check solves constant inputs at compile time and fails the
+* build if there is no legal setting or its bit rate error exceeds
+* MaxErrorPpm, so a bad rate is never flashed.
+******************************************************************************/
+
+#ifndef CAN_BIT_TIMING_H		/* prevent circular inclusions */
+#define CAN_BIT_TIMING_H
+
+/***************************** Include Files *********************************/
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xcan.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Ranges of the controller, in time quanta and CAN clocks */
+#define CAN_BIT_TIMING_MAX_PRESCALER	256U
+#define CAN_BIT_TIMING_MAX_TSEG1	16U
+#define CAN_BIT_TIMING_MAX_TSEG2	8U
+#define CAN_BIT_TIMING_MAX_SJW		4U
+
+/* Quanta per bit allowed by ISO 11898-1 */
+#define CAN_BIT_TIMING_MIN_QUANTA	8U
+#define CAN_BIT_TIMING_MAX_QUANTA	25U
+
+/* Default largest bit rate error accepted by CanBitTiming_Check, 0.5 % */
+#define CAN_BIT_TIMING_MAX_ERROR_PPM	5000U
+
+/**************************** Type Definitions *******************************/
+
+/* Ranges of a controller's bit timing fields, as lengths */
+typedef struct {
+	u32 MaxPrescaler;		/**< Largest BRP + 1 */
+	u32 MaxTseg1;			/**< Largest TSEG1, in quanta */
+	u32 MaxTseg2;			/**< Largest TSEG2, in quanta */
+	u32 MaxSjw;			/**< Largest SJW, in quanta */
+	u32 MinQuanta;			/**< Fewest quanta per bit */
+	u32 MaxQuanta;			/**< Most quanta per bit */
+} CanBitTiming_Limits;
+
+/*
+ * A solution: the register fields, as XCan_SetBaudRatePrescaler and
+ * XCan_SetBitTiming take them (each one less than its length), and what
+ * they give
+ */
+typedef struct {
+	u32 Valid;			/**< A legal setting was found */
+	u8 Prescaler;			/**< BRPR.BRP, quantum = BRP + 1 clocks */
+	u8 SyncJumpWidth;		/**< BTR.SJW, SJW - 1 */
+	u8 TimeSegment2;		/**< BTR.TS2, TSEG2 - 1 */
+	u8 TimeSegment1;		/**< BTR.TS1, TSEG1 - 1 */
+	u32 Quanta;			/**< Time quanta per bit */
+	u32 BitRate;			/**< Actual bit rate, bit/s */
+	u32 ErrorPpm;			/**< |BitRate - asked| in ppm */
+	u32 SamplePoint;		/**< Actual sample point, per mille */
+} CanBitTiming;
+
+/************************** Variable Definitions *****************************/
+
+static constexpr CanBitTiming_Limits CanBitTiming_AxiCan = {
+	CAN_BIT_TIMING_MAX_PRESCALER, CAN_BIT_TIMING_MAX_TSEG1,
+	CAN_BIT_TIMING_MAX_TSEG2, CAN_BIT_TIMING_MAX_SJW,
+	CAN_BIT_TIMING_MIN_QUANTA, CAN_BIT_TIMING_MAX_QUANTA
+};
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/*****************************************************************************/
+/**
+*
+* Searches the bit timings of the controller for a bit rate.
+*
+* @param	ClockHz is the CAN clock of the controller.
+* @param	BitRate is the bit rate wanted, in bit/s.
+* @param	SamplePoint is the sample point wanted, in per mille of the
+*		bit, e.g. 875 for the CiA recommended 87.5 %.
+* @param	Limits are the ranges of the controller, the AXI CAN ones
+*		by default.
+*
+* @return	The best setting, with Valid clear if the bit rate cannot be
+*		divided from the clock in the quanta per bit allowed at all.
+*
+******************************************************************************/
+static constexpr CanBitTiming CanBitTiming_Solve(u32 ClockHz, u32 BitRate,
+		u32 SamplePoint,
+		const CanBitTiming_Limits &Limits = CanBitTiming_AxiCan)
+{
+	CanBitTiming Best = {};
+	u32 BestSpError = 0;
+
+	if ((ClockHz == 0U) || (BitRate == 0U)) {
+		return Best;
+	}
+
+	for (u32 Brp = 1; Brp <= Limits.MaxPrescaler; Brp++) {
+		/* Quanta per bit nearest the bit rate for this prescaler */
+		u64 Clocks = (u64)Brp * BitRate;
+		u32 Quanta = (u32)(((u64)ClockHz + Clocks / 2U) / Clocks);
+
+		if ((Quanta < Limits.MinQuanta) ||
+		    (Quanta > Limits.MaxQuanta)) {
+			continue;
+		}
+
+		u32 Actual = (u32)((u64)ClockHz / ((u64)Brp * Quanta));
+		u64 Diff = (Actual > BitRate) ? Actual - BitRate :
+						BitRate - Actual;
+		u32 ErrorPpm = (u32)((Diff * 1000000U) / BitRate);
+
+		for (u32 Tseg2 = 1; Tseg2 <= Limits.MaxTseg2; Tseg2++) {
+			u32 Tseg1 = Quanta - 1U - Tseg2;
+
+			if ((Tseg2 >= Quanta - 1U) || (Tseg1 < 1U) ||
+			    (Tseg1 > Limits.MaxTseg1) ||
+			    (Tseg2 > Tseg1)) {
+				continue;
+			}
+
+			u32 Sp = ((1U + Tseg1) * 1000U) / Quanta;
+			/* Equal distances: the earlier sample point wins */
+			u32 SpError = (Sp > SamplePoint) ?
+				      2U * (Sp - SamplePoint) :
+				      (Sp < SamplePoint) ?
+				      2U * (SamplePoint - Sp) - 1U : 0U;
+
+			if (Best.Valid &&
+			    ((ErrorPpm > Best.ErrorPpm) ||
+			     ((ErrorPpm == Best.ErrorPpm) &&
+			      ((SpError > BestSpError) ||
+			       ((SpError == BestSpError) &&
+				(Quanta <= Best.Quanta)))))) {
+				continue;
+			}
+
+			u32 Sjw = (Tseg2 < Limits.MaxSjw) ? Tseg2 :
+							    Limits.MaxSjw;
+
+			Best.Valid = TRUE;
+			Best.Prescaler = (u8)(Brp - 1U);
+			Best.SyncJumpWidth = (u8)(Sjw - 1U);
+			Best.TimeSegment2 = (u8)(Tseg2 - 1U);
+			Best.TimeSegment1 = (u8)(Tseg1 - 1U);
+			Best.Quanta = Quanta;
+			Best.BitRate = Actual;
+			Best.ErrorPpm = ErrorPpm;
+			Best.SamplePoint = Sp;
+			BestSpError = SpError;
+		}
+	}
+
+	return Best;
+}
+
+/*****************************************************************************/
+/**
+*
+* Solves a constant bit timing at compile time.
+*
+* @return	The setting of CanBitTiming_Solve. The build fails if there
+*		is none or its bit rate error is above MaxErrorPpm.
+*
+******************************************************************************/
+template <u32 ClockHz, u32 BitRate, u32 SamplePoint,
+	  u32 MaxErrorPpm = CAN_BIT_TIMING_MAX_ERROR_PPM>
+constexpr CanBitTiming CanBitTiming_Check(void)
+{
+	constexpr CanBitTiming Timing =
+		CanBitTiming_Solve(ClockHz, BitRate, SamplePoint);
+
+	static_assert(Timing.Valid,
+		      "no CAN bit timing for this clock and bit rate");
+	static_assert(Timing.ErrorPpm <= MaxErrorPpm,
+		      "CAN bit rate error too large for this clock");
+
+	return Timing;
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes a bit timing to the controller, which must be in configuration
+* mode.
+*
+* @param	InstancePtr is a pointer to the XCan instance.
+* @param	TimingPtr is a setting from CanBitTiming_Solve or
+*		CanBitTiming_Check.
+*
+* @return
+*		- XST_SUCCESS if the setting was written
+*		- XST_INVALID_PARAM if the setting is not valid
+*		- XST_FAILURE if the controller is not in configuration mode
+*
+******************************************************************************/
+static inline int CanBitTiming_Apply(XCan *InstancePtr,
+				     const CanBitTiming *TimingPtr)
+{
+	int Status;
+
+	if (!TimingPtr->Valid) {
+		return XST_INVALID_PARAM;
+	}
+
+	Status = XCan_SetBaudRatePrescaler(InstancePtr, TimingPtr->Prescaler);
+	if (Status != XST_SUCCESS) {
+		return Status;
+	}
+
+	return XCan_SetBitTiming(InstancePtr, TimingPtr->SyncJumpWidth,
+				 TimingPtr->TimeSegment2,
+				 TimingPtr->TimeSegment1);
+}
+
+#endif	/* end of protection macro */
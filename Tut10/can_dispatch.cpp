@@ -0,0 +1,354 @@
+/******************************************************************************
+* CAN message ID dispatch with hardware acceptance filtering
+*
+* See can_dispatch.h for the design. The lookup is inline in the header;
+* this file holds registration and the acceptance filter computation,
+* which run at initialization only.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <string.h>
+
+#include "xstatus.h"
+#include "can_dispatch.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Moves tried when placing an extended ID before a new hash seed is taken */
+#define CAN_DISPATCH_MAX_KICKS		64U
+
+/* Hash seeds tried before registration gives up */
+#define CAN_DISPATCH_MAX_SEEDS		32U
+
+/* Largest IDs of each format */
+#define CAN_DISPATCH_MAX_STANDARD_ID	0x7FFU
+#define CAN_DISPATCH_MAX_EXTENDED_ID	0x1FFFFFFFU
+
+/* Bits of an extended ID held in ID2 of the ID register */
+#define CAN_DISPATCH_ID2_BITS		18U
+
+/************************** Variable Definitions *****************************/
+
+/* Groups of CanDispatch_ComputeFilters, too large for the stack */
+static u32 GroupValue[CAN_DISPATCH_MAX_IDS];
+static u32 GroupAgree[CAN_DISPATCH_MAX_IDS];
+
+/* Extended table before CanDispatch_Register places an ID, to undo it */
+static u16 SavedExtended[CAN_DISPATCH_HASH_SIZE];
+
+/*****************************************************************************/
+/**
+*
+* Empties the dispatcher: no IDs, no default handler and no filters.
+*
+* @param	DispatchPtr is a pointer to the dispatcher.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanDispatch_Initialize(CanDispatch *DispatchPtr)
+{
+	memset(DispatchPtr, 0, sizeof(*DispatchPtr));
+	DispatchPtr->Seed = 0x2545F491U;
+}
+
+/*
+ * Puts an extended entry into the cuckoo table, moving the entries in its
+ * way to their other slot. Returns FALSE if some entry is left without a
+ * slot, which then is in no slot at all until the table is rebuilt.
+ */
+static int CanDispatch_Place(CanDispatch *DispatchPtr, u32 Index)
+{
+	u16 Moving = (u16)(Index + 1U);
+	u32 Key = DispatchPtr->Entries[Index].Key;
+	u32 Slot = CanDispatch_Hash1(Key, DispatchPtr->Seed);
+	u32 Kick;
+
+	for (Kick = 0; Kick < CAN_DISPATCH_MAX_KICKS; Kick++) {
+		u16 Evicted = DispatchPtr->Extended[Slot];
+
+		DispatchPtr->Extended[Slot] = Moving;
+		if (Evicted == 0U) {
+			return TRUE;
+		}
+
+		/* The evicted entry goes to its other slot */
+		Moving = Evicted;
+		Key = DispatchPtr->Entries[Moving - 1U].Key;
+		Slot = (Slot == CanDispatch_Hash1(Key, DispatchPtr->Seed)) ?
+		       CanDispatch_Hash2(Key, DispatchPtr->Seed) :
+		       CanDispatch_Hash1(Key, DispatchPtr->Seed);
+	}
+
+	return FALSE;
+}
+
+/*
+ * Places all extended entries again with new seeds until they all fit
+ */
+static int CanDispatch_Rehash(CanDispatch *DispatchPtr)
+{
+	u32 Attempt;
+	u32 Index;
+
+	for (Attempt = 0; Attempt < CAN_DISPATCH_MAX_SEEDS; Attempt++) {
+		int Placed = TRUE;
+
+		DispatchPtr->Seed = DispatchPtr->Seed * 0x2C1B3C6DU +
+				    0x297A2D39U;
+		DispatchPtr->Stats.Rehashes++;
+		memset(DispatchPtr->Extended, 0,
+		       sizeof(DispatchPtr->Extended));
+
+		for (Index = 0; Placed && (Index < DispatchPtr->NumEntries);
+		     Index++) {
+			if (DispatchPtr->Entries[Index].Key &
+			    XCAN_IDR_IDE_MASK) {
+				Placed = CanDispatch_Place(DispatchPtr, Index);
+			}
+		}
+		if (Placed) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/*****************************************************************************/
+/**
+*
+* Registers the handler of an ID. The acceptance filters are not changed
+* until CanDispatch_ProgramFilters.
+*
+* @param	DispatchPtr is a pointer to the dispatcher.
+* @param	Id is the standard (11-bit) or extended (29-bit) identifier.
+* @param	Extended is TRUE for an extended identifier.
+* @param	Handler is called with CallBackRef and every frame of the ID.
+* @param	CallBackRef is passed to Handler.
+*
+* @return
+*		- XST_SUCCESS if the ID was registered
+*		- XST_INVALID_PARAM if the ID is out of range or Handler is
+*		NULL
+*		- XST_FAILURE if the ID is registered already or the table
+*		is full
+*
+******************************************************************************/
+int CanDispatch_Register(CanDispatch *DispatchPtr, u32 Id, u32 Extended,
+			 CanDispatch_Handler Handler, void *CallBackRef)
+{
+	CanDispatch_Entry *EntryPtr;
+	u32 Index = DispatchPtr->NumEntries;
+	u32 SavedSeed;
+	u32 Key;
+
+	if ((Handler == NULL) ||
+	    (Id > (Extended ? CAN_DISPATCH_MAX_EXTENDED_ID :
+			      CAN_DISPATCH_MAX_STANDARD_ID))) {
+		return XST_INVALID_PARAM;
+	}
+
+	if (Extended) {
+		Key = XCan_CreateIdValue(Id >> CAN_DISPATCH_ID2_BITS, 0U, 1U,
+					 Id, 0U);
+	} else {
+		Key = XCan_CreateIdValue(Id, 0U, 0U, 0U, 0U);
+	}
+	if ((Index == CAN_DISPATCH_MAX_IDS) ||
+	    (CanDispatch_Lookup(DispatchPtr, Key) != NULL)) {
+		return XST_FAILURE;
+	}
+
+	EntryPtr = &DispatchPtr->Entries[Index];
+	EntryPtr->Key = Key;
+	EntryPtr->Handler = Handler;
+	EntryPtr->CallBackRef = CallBackRef;
+	EntryPtr->Frames = 0U;
+	DispatchPtr->NumEntries++;
+
+	if (!Extended) {
+		DispatchPtr->Standard[Id] = (u16)(Index + 1U);
+		return XST_SUCCESS;
+	}
+
+	SavedSeed = DispatchPtr->Seed;
+	memcpy(SavedExtended, DispatchPtr->Extended, sizeof(SavedExtended));
+	if (!CanDispatch_Place(DispatchPtr, Index) &&
+	    !CanDispatch_Rehash(DispatchPtr)) {
+		/* Drop the new ID again and put the table back as it was */
+		DispatchPtr->NumEntries--;
+		DispatchPtr->Seed = SavedSeed;
+		memcpy(DispatchPtr->Extended, SavedExtended,
+		       sizeof(SavedExtended));
+		return XST_FAILURE;
+	}
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets the handler of frames whose ID is not registered, which the
+* acceptance filters may let through.
+*
+* @param	DispatchPtr is a pointer to the dispatcher.
+* @param	Handler is called for each such frame, NULL to drop them.
+* @param	CallBackRef is passed to Handler.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanDispatch_SetDefault(CanDispatch *DispatchPtr,
+			    CanDispatch_Handler Handler, void *CallBackRef)
+{
+	DispatchPtr->Default = Handler;
+	DispatchPtr->DefaultRef = CallBackRef;
+}
+
+/* ID bits a group lets through, the fewer the better */
+static u32 CanDispatch_FreeBits(u32 Agree)
+{
+	return (u32)__builtin_popcount(CAN_DISPATCH_EXTENDED_KEY & ~Agree);
+}
+
+/*****************************************************************************/
+/**
+*
+* Covers the registered IDs with at most MaxFilters mask and ID pairs and
+* stores them in FilterMask and FilterId. A frame passes a filter if
+* (ID register & mask) == (ID & mask).
+*
+* @param	DispatchPtr is a pointer to the dispatcher.
+* @param	MaxFilters is the number of filters to use, at most
+*		CAN_DISPATCH_MAX_FILTERS.
+*
+* @return	The number of filters, 0 if no ID is registered.
+*
+******************************************************************************/
+u32 CanDispatch_ComputeFilters(CanDispatch *DispatchPtr, u32 MaxFilters)
+{
+	u32 Groups = DispatchPtr->NumEntries;
+	u32 Index;
+
+	if (MaxFilters > CAN_DISPATCH_MAX_FILTERS) {
+		MaxFilters = CAN_DISPATCH_MAX_FILTERS;
+	}
+	if ((Groups == 0U) || (MaxFilters == 0U)) {
+		DispatchPtr->NumFilters = 0U;
+		return 0U;
+	}
+
+	/* One group per ID, sorted by ID register value */
+	for (Index = 0; Index < Groups; Index++) {
+		u32 Key = DispatchPtr->Entries[Index].Key;
+		u32 Pos = Index;
+
+		while ((Pos > 0U) && (GroupValue[Pos - 1U] > Key)) {
+			GroupValue[Pos] = GroupValue[Pos - 1U];
+			Pos--;
+		}
+		GroupValue[Pos] = Key;
+	}
+	for (Index = 0; Index < Groups; Index++) {
+		GroupAgree[Index] = CAN_DISPATCH_EXTENDED_KEY;
+	}
+
+	/* Merge the neighbours that lose the fewest bits */
+	while (Groups > MaxFilters) {
+		u32 Best = 0;
+		u32 BestFree = 0xFFFFFFFFU;
+		u32 Agree;
+
+		for (Index = 0; Index + 1U < Groups; Index++) {
+			u32 Free;
+
+			Agree = GroupAgree[Index] & GroupAgree[Index + 1U] &
+				~(GroupValue[Index] ^ GroupValue[Index + 1U]);
+			Free = CanDispatch_FreeBits(Agree);
+			if (Free < BestFree) {
+				Best = Index;
+				BestFree = Free;
+			}
+		}
+
+		Agree = GroupAgree[Best] & GroupAgree[Best + 1U] &
+			~(GroupValue[Best] ^ GroupValue[Best + 1U]);
+		GroupAgree[Best] = Agree;
+		GroupValue[Best] &= Agree;
+		for (Index = Best + 1U; Index + 1U < Groups; Index++) {
+			GroupValue[Index] = GroupValue[Index + 1U];
+			GroupAgree[Index] = GroupAgree[Index + 1U];
+		}
+		Groups--;
+	}
+
+	for (Index = 0; Index < Groups; Index++) {
+		DispatchPtr->FilterMask[Index] = GroupAgree[Index];
+		DispatchPtr->FilterId[Index] = GroupValue[Index];
+	}
+	DispatchPtr->NumFilters = Groups;
+
+	return Groups;
+}
+
+/*****************************************************************************/
+/**
+*
+* Computes the acceptance filters for the registered IDs and writes them to
+* the controller. With no ID registered the filters are turned off and all
+* frames are received.
+*
+* @param	DispatchPtr is a pointer to the dispatcher.
+* @param	InstancePtr is a pointer to the XCan instance.
+*
+* @return
+*		- XST_SUCCESS if the filters were written
+*		- XST_FAILURE if the controller refused a filter
+*
+******************************************************************************/
+int CanDispatch_ProgramFilters(CanDispatch *DispatchPtr, XCan *InstancePtr)
+{
+	u32 Filters;
+	u32 Index;
+	int Status;
+
+	Filters = CanDispatch_ComputeFilters(DispatchPtr,
+			InstancePtr->CanConfig.NumOfAcceptFilters);
+
+	XCan_AcceptFilterDisable(InstancePtr, XCAN_AFR_UAF_ALL_MASK);
+	while (XCan_IsAcceptFilterBusy(InstancePtr) == TRUE);
+
+	for (Index = 0; Index < Filters; Index++) {
+		Status = XCan_AcceptFilterSet(InstancePtr, 1U << Index,
+					      DispatchPtr->FilterMask[Index],
+					      DispatchPtr->FilterId[Index]);
+		if (Status != XST_SUCCESS) {
+			return XST_FAILURE;
+		}
+	}
+	if (Filters != 0U) {
+		XCan_AcceptFilterEnable(InstancePtr, (1U << Filters) - 1U);
+	}
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the dispatch statistics.
+*
+* @param	DispatchPtr is a pointer to the dispatcher.
+* @param	StatsPtr is where the statistics are returned.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanDispatch_GetStats(CanDispatch *DispatchPtr,
+			  CanDispatch_Stats *StatsPtr)
+{
+	*StatsPtr = DispatchPtr->Stats;
+}
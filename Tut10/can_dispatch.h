@@ -0,0 +1,192 @@
+/******************************************************************************
+* CAN message ID dispatch with hardware acceptance filtering
+*
+* Maps the identifiers an application listens to onto their handlers, so
+* a received frame costs one table lookup whatever the number of IDs,
+* instead of a chain of compares:
+*
+*	CanDispatch_Initialize(&Dispatch);
+*	CanDispatch_Register(&Dispatch, 0x123, FALSE, EngineHandler, &Engine);
+*	CanDispatch_Register(&Dispatch, 0x18FEF100, TRUE, Dm1Handler, NULL);
+*	CanDispatch_ProgramFilters(&Dispatch, &Can);
+*	...
+*	while ((FramePtr = CanRing_Peek(&Ring)) != NULL) {
+*		CanDispatch_Frame(&Dispatch, FramePtr);
+*		CanRing_Release(&Ring);
+*	}
+*
+* Standard (11-bit) IDs index a table of all 2048 of them directly.
+* Extended (29-bit) IDs go to a cuckoo hash table: every ID sits in one of
+* the two slots its two hashes give, so a lookup reads at most two slots
+* and never searches. Registration moves IDs between their slots to make
+* room and, if that does not settle, starts over with a new hash seed.
+*
+* CanDispatch_ProgramFilters covers the registered IDs with the acceptance
+* filters of the controller (four mask and ID pairs), so most unwanted
+* traffic is dropped by the hardware and never raises an interrupt. The IDs
+* are sorted and neighbours merged into groups, always the pair whose mask
+* keeps the most bits, until there are as many groups as filters; each
+* group is one filter with the bits all its IDs agree on. The filters may
+* let through some IDs that are not registered, which the lookup counts in
+* Unmatched and hands to the default handler, if there is one.
+*
+* Registration and filter programming are for initialization; the lookup
+* reads the tables without locks, from task or interrupt context.
+******************************************************************************/
+
+#ifndef CAN_DISPATCH_H		/* prevent circular inclusions */
+#define CAN_DISPATCH_H
+
+/***************************** Include Files *********************************/
+
+#include "xil_types.h"
+#include "xcan.h"
+
+/************************** Constant Definitions *****************************/
+
+/* IDs that can be registered, at most 65535 */
+#define CAN_DISPATCH_MAX_IDS		512U
+
+/* Slots of the extended ID table, a power of two, twice the IDs */
+#define CAN_DISPATCH_HASH_BITS		10U
+#define CAN_DISPATCH_HASH_SIZE		(1U << CAN_DISPATCH_HASH_BITS)
+
+/* Standard IDs, the size of the direct table */
+#define CAN_DISPATCH_STANDARD_IDS	2048U
+
+/* Acceptance filters the controller has */
+#define CAN_DISPATCH_MAX_FILTERS	4U
+
+/* ID register bits that identify a frame, for each format */
+#define CAN_DISPATCH_STANDARD_KEY	(XCAN_IDR_ID1_MASK | XCAN_IDR_IDE_MASK)
+#define CAN_DISPATCH_EXTENDED_KEY	(XCAN_IDR_ID1_MASK | XCAN_IDR_IDE_MASK | \
+					 XCAN_IDR_ID2_MASK)
+
+/**************************** Type Definitions *******************************/
+
+/*
+ * Called with the frame in the XCan_Recv layout: ID register, DLC register
+ * and the data words
+ */
+typedef void (*CanDispatch_Handler)(void *CallBackRef, const u32 *FramePtr);
+
+typedef struct {
+	u32 Key;			/**< ID register bits of the ID */
+	CanDispatch_Handler Handler;
+	void *CallBackRef;
+	u32 Frames;			/**< Frames dispatched to it */
+} CanDispatch_Entry;
+
+typedef struct {
+	u32 Dispatched;			/**< Frames that found their ID */
+	u32 Unmatched;			/**< Frames of unregistered IDs */
+	u32 Rehashes;			/**< Extended table rebuilds */
+} CanDispatch_Stats;
+
+typedef struct {
+	CanDispatch_Entry Entries[CAN_DISPATCH_MAX_IDS];
+	u32 NumEntries;
+	u16 Standard[CAN_DISPATCH_STANDARD_IDS];/**< Entry + 1, 0 if none */
+	u16 Extended[CAN_DISPATCH_HASH_SIZE];	/**< Entry + 1, 0 if empty */
+	u32 Seed;			/**< Hash seed of Extended */
+	CanDispatch_Handler Default;	/**< Unmatched frames, may be NULL */
+	void *DefaultRef;
+	u32 NumFilters;			/**< Filters in use, 0 accepts all */
+	u32 FilterMask[CAN_DISPATCH_MAX_FILTERS];
+	u32 FilterId[CAN_DISPATCH_MAX_FILTERS];
+	CanDispatch_Stats Stats;
+} CanDispatch;
+
+/************************** Function Prototypes ******************************/
+
+void CanDispatch_Initialize(CanDispatch *DispatchPtr);
+int CanDispatch_Register(CanDispatch *DispatchPtr, u32 Id, u32 Extended,
+			 CanDispatch_Handler Handler, void *CallBackRef);
+void CanDispatch_SetDefault(CanDispatch *DispatchPtr,
+			    CanDispatch_Handler Handler, void *CallBackRef);
+u32 CanDispatch_ComputeFilters(CanDispatch *DispatchPtr, u32 MaxFilters);
+int CanDispatch_ProgramFilters(CanDispatch *DispatchPtr, XCan *InstancePtr);
+void CanDispatch_GetStats(CanDispatch *DispatchPtr,
+			  CanDispatch_Stats *StatsPtr);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/* The two slots of an extended ID */
+static inline u32 CanDispatch_Hash1(u32 Key, u32 Seed)
+{
+	return ((Key ^ Seed) * 0x9E3779B1U) >> (32U - CAN_DISPATCH_HASH_BITS);
+}
+
+static inline u32 CanDispatch_Hash2(u32 Key, u32 Seed)
+{
+	return ((Key ^ Seed) * 0x85EBCA77U) >> (32U - CAN_DISPATCH_HASH_BITS);
+}
+
+/*****************************************************************************/
+/**
+*
+* Finds the entry of a frame ID.
+*
+* @param	DispatchPtr is a pointer to the dispatcher.
+* @param	IdValue is the ID register word of the frame.
+*
+* @return	The entry, or NULL if the ID is not registered.
+*
+******************************************************************************/
+static inline CanDispatch_Entry *CanDispatch_Lookup(CanDispatch *DispatchPtr,
+						    u32 IdValue)
+{
+	u32 Key;
+	u32 Slot;
+
+	if ((IdValue & XCAN_IDR_IDE_MASK) == 0U) {
+		Slot = DispatchPtr->Standard[IdValue >> XCAN_IDR_ID1_SHIFT];
+		return (Slot != 0U) ? &DispatchPtr->Entries[Slot - 1U] : NULL;
+	}
+
+	Key = IdValue & CAN_DISPATCH_EXTENDED_KEY;
+	Slot = DispatchPtr->Extended[CanDispatch_Hash1(Key, DispatchPtr->Seed)];
+	if ((Slot != 0U) && (DispatchPtr->Entries[Slot - 1U].Key == Key)) {
+		return &DispatchPtr->Entries[Slot - 1U];
+	}
+	Slot = DispatchPtr->Extended[CanDispatch_Hash2(Key, DispatchPtr->Seed)];
+	if ((Slot != 0U) && (DispatchPtr->Entries[Slot - 1U].Key == Key)) {
+		return &DispatchPtr->Entries[Slot - 1U];
+	}
+
+	return NULL;
+}
+
+/*****************************************************************************/
+/**
+*
+* Calls the handler of a received frame.
+*
+* @param	DispatchPtr is a pointer to the dispatcher.
+* @param	FramePtr is the frame in the XCan_Recv layout.
+*
+* @return	TRUE if the ID is registered, FALSE if the frame went to the
+*		default handler or was dropped.
+*
+******************************************************************************/
+static inline int CanDispatch_Frame(CanDispatch *DispatchPtr,
+				    const u32 *FramePtr)
+{
+	CanDispatch_Entry *EntryPtr = CanDispatch_Lookup(DispatchPtr,
+							 FramePtr[0]);
+
+	if (EntryPtr == NULL) {
+		DispatchPtr->Stats.Unmatched++;
+		if (DispatchPtr->Default != NULL) {
+			DispatchPtr->Default(DispatchPtr->DefaultRef, FramePtr);
+		}
+		return FALSE;
+	}
+
+	DispatchPtr->Stats.Dispatched++;
+	EntryPtr->Frames++;
+	EntryPtr->Handler(EntryPtr->CallBackRef, FramePtr);
+	return TRUE;
+}
+
+#endif	/* end of protection macro */
@@ -0,0 +1,450 @@
+/******************************************************************************
+* CAN gateway forwarding frames between controllers by a routing table
+*
+* See can_gateway.h for the design. The handlers use Timestamp_Now, so
+* Timestamp_Initialize or MonoClock_Initialize must have been called
+* before the first frame is received.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xstatus.h"
+#include "xil_io.h"
+#include "xcan_l.h"
+#include "timestamp.h"
+#include "can_gateway.h"
+
+/************************** Constant Definitions *****************************/
+
+static_assert((CAN_GW_TX_SIZE & (CAN_GW_TX_SIZE - 1U)) == 0U,
+	      "the TX queue index wraps on a power of two");
+
+/* Highest standard and extended ID */
+#define CAN_GW_MAX_STANDARD_ID		0x7FFU
+#define CAN_GW_MAX_EXTENDED_ID		0x1FFFFFFFU
+
+/* Bits of the extended ID in ID2 */
+#define CAN_GW_ID2_BITS			18U
+
+/************************** Function Prototypes ******************************/
+
+static u32 CanGateway_IdOf(u32 IdValue);
+static u32 CanGateway_SetId(u32 IdValue, u32 Id);
+static void CanGateway_Forward(CanGateway *GatewayPtr, u32 PortIndex,
+			       CanPool_Frame *FramePtr, u32 IdValue,
+			       u32 Stamp);
+static void CanGateway_Fill(CanGateway_Port *PortPtr);
+static void CanGateway_Retire(CanGateway *GatewayPtr,
+			      CanGateway_Port *PortPtr, u32 Now);
+
+/*****************************************************************************/
+/**
+*
+* Initializes a gateway with no routes over the given controllers, port i
+* being CanPtrs[i].
+*
+* @param	GatewayPtr is a pointer to the gateway.
+* @param	PoolPtr is the pool received frames are read into.
+* @param	CanPtrs are the initialized XCan instances.
+* @param	NumPorts is their number, 1 to CAN_GW_MAX_PORTS.
+*
+* @return	XST_SUCCESS, or XST_INVALID_PARAM for too many ports.
+*
+******************************************************************************/
+int CanGateway_Init(CanGateway *GatewayPtr, CanPool *PoolPtr,
+		    XCan *const *CanPtrs, u32 NumPorts)
+{
+	CanGateway_Port *PortPtr;
+	u32 Index;
+
+	if ((NumPorts == 0U) || (NumPorts > CAN_GW_MAX_PORTS)) {
+		return XST_INVALID_PARAM;
+	}
+
+	GatewayPtr->PoolPtr = PoolPtr;
+	GatewayPtr->NumPorts = NumPorts;
+	for (Index = 0U; Index < NumPorts; Index++) {
+		PortPtr = &GatewayPtr->Port[Index];
+		PortPtr->GatewayPtr = GatewayPtr;
+		PortPtr->CanPtr = CanPtrs[Index];
+		PortPtr->TxHead = 0U;
+		PortPtr->TxNext = 0U;
+		PortPtr->TxDone = 0U;
+		PortPtr->Stats.Received = 0U;
+		PortPtr->Stats.Unrouted = 0U;
+		PortPtr->Stats.TxHighWatermark = 0U;
+	}
+	GatewayPtr->NumRoutes = 0U;
+	GatewayPtr->LocalFn = NULL;
+	GatewayPtr->LocalRef = NULL;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Adds a route, after those already added.
+*
+* @param	GatewayPtr is a pointer to the gateway.
+* @param	RoutePtr is the route, copied.
+*
+* @return	XST_SUCCESS, XST_INVALID_PARAM for a port that does not exist
+*		or an ID range, before or after the rewrite, out of its
+*		format, or XST_FAILURE with the table full.
+*
+******************************************************************************/
+int CanGateway_AddRoute(CanGateway *GatewayPtr,
+			const CanGateway_Route *RoutePtr)
+{
+	u32 MaxId = RoutePtr->Extended ? CAN_GW_MAX_EXTENDED_ID :
+					 CAN_GW_MAX_STANDARD_ID;
+	CanGateway_RouteStats *StatsPtr;
+
+	if ((RoutePtr->Source >= GatewayPtr->NumPorts) ||
+	    (RoutePtr->Dest >= GatewayPtr->NumPorts) ||
+	    (RoutePtr->FirstId > RoutePtr->LastId) ||
+	    (RoutePtr->LastId > MaxId)) {
+		return XST_INVALID_PARAM;
+	}
+	if ((RoutePtr->NewFirstId != CAN_GW_KEEP_ID) &&
+	    ((RoutePtr->NewFirstId > MaxId) ||
+	     (RoutePtr->LastId - RoutePtr->FirstId >
+	      MaxId - RoutePtr->NewFirstId))) {
+		return XST_INVALID_PARAM;
+	}
+	if (GatewayPtr->NumRoutes == CAN_GW_MAX_ROUTES) {
+		return XST_FAILURE;
+	}
+
+	GatewayPtr->Route[GatewayPtr->NumRoutes] = *RoutePtr;
+	StatsPtr = &GatewayPtr->RouteStats[GatewayPtr->NumRoutes];
+	StatsPtr->Forwarded = 0U;
+	StatsPtr->Sent = 0U;
+	StatsPtr->NoFrame = 0U;
+	StatsPtr->NoRoom = 0U;
+	StatsPtr->MinLatency = ~0U;
+	StatsPtr->MaxLatency = 0U;
+	StatsPtr->TotalLatency = 0U;
+	GatewayPtr->NumRoutes++;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets the handler of the frames no route takes.
+*
+* @param	GatewayPtr is a pointer to the gateway.
+* @param	LocalFn is called, from the receive interrupt handler, with
+*		the port and the frame. It may take a reference to keep the
+*		frame. NULL drops such frames.
+* @param	CallBackRef is passed to LocalFn.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanGateway_SetLocalHandler(CanGateway *GatewayPtr,
+				CanGateway_LocalFn LocalFn, void *CallBackRef)
+{
+	GatewayPtr->LocalRef = CallBackRef;
+	GatewayPtr->LocalFn = LocalFn;
+}
+
+/*****************************************************************************/
+/**
+*
+* The receive handler of a port: reads every frame in its RX FIFO into the
+* pool and forwards it on its routes.
+*
+* @param	CallBackRef is the CanGateway_Port of the controller.
+*
+* @return	None.
+*
+* @note		A frame that finds the pool exhausted is still read out of
+*		the hardware, to keep the FIFO from overflowing, and counted
+*		on the routes it would have taken.
+*
+******************************************************************************/
+void CanGateway_RecvHandler(void *CallBackRef)
+{
+	CanGateway_Port *PortPtr = (CanGateway_Port *)CallBackRef;
+	CanGateway *GatewayPtr = PortPtr->GatewayPtr;
+	u32 PortIndex = (u32)(PortPtr - GatewayPtr->Port);
+	CanPool_Frame *FramePtr;
+	u32 *WordsPtr;
+
+	while (XCan_IsRxEmpty(PortPtr->CanPtr) == FALSE) {
+		FramePtr = CanPool_Alloc(GatewayPtr->PoolPtr);
+		WordsPtr = (FramePtr != NULL) ? FramePtr->Words :
+						GatewayPtr->Discard;
+		(void)XCan_Recv(PortPtr->CanPtr, WordsPtr);
+		PortPtr->Stats.Received++;
+
+		CanGateway_Forward(GatewayPtr, PortIndex, FramePtr,
+				   WordsPtr[0], Timestamp_Now());
+		if (FramePtr != NULL) {
+			CanPool_Release(GatewayPtr->PoolPtr, FramePtr);
+		}
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* The send handler of a port: retires the frame the TXOK is for and
+* writes the next queued frames into the TX FIFO.
+*
+* @param	CallBackRef is the CanGateway_Port of the controller.
+*
+* @return	None.
+*
+* @note		As in CanTxSched_SendHandler, each TXOK retires the oldest
+*		frame in the FIFO and an idle bus all of them, which catches
+*		up with TXOKs that coalesced into one interrupt.
+*
+******************************************************************************/
+void CanGateway_SendHandler(void *CallBackRef)
+{
+	CanGateway_Port *PortPtr = (CanGateway_Port *)CallBackRef;
+	CanGateway *GatewayPtr = PortPtr->GatewayPtr;
+	u32 Status = XCan_GetStatus(PortPtr->CanPtr);
+	u32 Now = Timestamp_Now();
+
+	if (PortPtr->TxDone != PortPtr->TxNext) {
+		CanGateway_Retire(GatewayPtr, PortPtr, Now);
+	}
+	if ((Status & XCAN_SR_BIDLE_MASK) != 0U) {
+		while (PortPtr->TxDone != PortPtr->TxNext) {
+			CanGateway_Retire(GatewayPtr, PortPtr, Now);
+		}
+	}
+
+	CanGateway_Fill(PortPtr);
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the statistics of a route.
+*
+* @param	GatewayPtr is a pointer to the gateway.
+* @param	RouteIndex is the route, in the order they were added.
+* @param	StatsPtr is where the statistics are returned.
+*
+* @return	None.
+*
+* @note		Each word is read consistently; TotalLatency may be torn by
+*		a TXOK on a 32-bit CPU.
+*
+******************************************************************************/
+void CanGateway_GetRouteStats(CanGateway *GatewayPtr, u32 RouteIndex,
+			      CanGateway_RouteStats *StatsPtr)
+{
+	*StatsPtr = GatewayPtr->RouteStats[RouteIndex];
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the statistics of a port.
+*
+* @param	GatewayPtr is a pointer to the gateway.
+* @param	PortIndex is the port.
+* @param	StatsPtr is where the statistics are returned.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanGateway_GetPortStats(CanGateway *GatewayPtr, u32 PortIndex,
+			     CanGateway_PortStats *StatsPtr)
+{
+	*StatsPtr = GatewayPtr->Port[PortIndex].Stats;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the ID of a frame, 11 or 29 bits, from its ID register.
+*
+******************************************************************************/
+static u32 CanGateway_IdOf(u32 IdValue)
+{
+	u32 Id = (IdValue & XCAN_IDR_ID1_MASK) >> XCAN_IDR_ID1_SHIFT;
+
+	if ((IdValue & XCAN_IDR_IDE_MASK) != 0U) {
+		Id = (Id << CAN_GW_ID2_BITS) |
+		     ((IdValue & XCAN_IDR_ID2_MASK) >> XCAN_IDR_ID2_SHIFT);
+	}
+
+	return Id;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns an ID register with its ID replaced, keeping its format and the
+* SRR and RTR bits.
+*
+******************************************************************************/
+static u32 CanGateway_SetId(u32 IdValue, u32 Id)
+{
+	if ((IdValue & XCAN_IDR_IDE_MASK) == 0U) {
+		return (IdValue & ~XCAN_IDR_ID1_MASK) |
+		       (Id << XCAN_IDR_ID1_SHIFT);
+	}
+
+	return (IdValue & ~(XCAN_IDR_ID1_MASK | XCAN_IDR_ID2_MASK)) |
+	       ((Id >> CAN_GW_ID2_BITS) << XCAN_IDR_ID1_SHIFT) |
+	       ((Id << XCAN_IDR_ID2_SHIFT) & XCAN_IDR_ID2_MASK);
+}
+
+/*****************************************************************************/
+/**
+*
+* Queues a received frame on the destination of every route it matches,
+* each holding a reference, and passes it to the local handler if none
+* does.
+*
+* @param	GatewayPtr is a pointer to the gateway.
+* @param	PortIndex is the port it came in on.
+* @param	FramePtr is the frame, or NULL when the pool was exhausted.
+* @param	IdValue is its ID register.
+* @param	Stamp is the time it was read.
+*
+* @return	None.
+*
+******************************************************************************/
+static void CanGateway_Forward(CanGateway *GatewayPtr, u32 PortIndex,
+			       CanPool_Frame *FramePtr, u32 IdValue,
+			       u32 Stamp)
+{
+	u32 Extended = ((IdValue & XCAN_IDR_IDE_MASK) != 0U);
+	u32 Id = CanGateway_IdOf(IdValue);
+	const CanGateway_Route *RoutePtr;
+	CanGateway_RouteStats *StatsPtr;
+	CanGateway_Port *DestPtr;
+	CanGateway_TxEntry *EntryPtr;
+	u32 Matched = 0U;
+	u32 Queued;
+	u32 Index;
+
+	for (Index = 0U; Index < GatewayPtr->NumRoutes; Index++) {
+		RoutePtr = &GatewayPtr->Route[Index];
+		if ((RoutePtr->Source != PortIndex) ||
+		    (RoutePtr->Extended != Extended) ||
+		    (Id < RoutePtr->FirstId) || (Id > RoutePtr->LastId)) {
+			continue;
+		}
+
+		Matched++;
+		StatsPtr = &GatewayPtr->RouteStats[Index];
+		if (FramePtr == NULL) {
+			StatsPtr->NoFrame++;
+			continue;
+		}
+		DestPtr = &GatewayPtr->Port[RoutePtr->Dest];
+		Queued = DestPtr->TxHead - DestPtr->TxDone;
+		if (Queued == CAN_GW_TX_SIZE) {
+			StatsPtr->NoRoom++;
+			continue;
+		}
+
+		CanPool_Ref(FramePtr);
+		EntryPtr = &DestPtr->Tx[DestPtr->TxHead &
+				       (CAN_GW_TX_SIZE - 1U)];
+		EntryPtr->FramePtr = FramePtr;
+		EntryPtr->IdValue = (RoutePtr->NewFirstId == CAN_GW_KEEP_ID) ?
+			IdValue :
+			CanGateway_SetId(IdValue, Id - RoutePtr->FirstId +
+					 RoutePtr->NewFirstId);
+		EntryPtr->Stamp = Stamp;
+		EntryPtr->Route = Index;
+		DestPtr->TxHead++;
+		if (Queued + 1U > DestPtr->Stats.TxHighWatermark) {
+			DestPtr->Stats.TxHighWatermark = Queued + 1U;
+		}
+		StatsPtr->Forwarded++;
+
+		CanGateway_Fill(DestPtr);
+	}
+
+	if (Matched == 0U) {
+		GatewayPtr->Port[PortIndex].Stats.Unrouted++;
+		if ((FramePtr != NULL) && (GatewayPtr->LocalFn != NULL)) {
+			GatewayPtr->LocalFn(GatewayPtr->LocalRef, PortIndex,
+					    FramePtr);
+		}
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes the queued frames of a port into its TX FIFO while it has room,
+* straight from the pool frames, with the ID of each route.
+*
+* @param	PortPtr is the port.
+*
+* @return	None.
+*
+******************************************************************************/
+static void CanGateway_Fill(CanGateway_Port *PortPtr)
+{
+	UINTPTR BaseAddress = PortPtr->CanPtr->CanConfig.BaseAddress;
+	CanGateway_TxEntry *EntryPtr;
+	const u32 *WordsPtr;
+
+	while ((PortPtr->TxNext != PortPtr->TxHead) &&
+	       (XCan_IsTxFifoFull(PortPtr->CanPtr) == FALSE)) {
+		EntryPtr = &PortPtr->Tx[PortPtr->TxNext &
+					(CAN_GW_TX_SIZE - 1U)];
+		WordsPtr = EntryPtr->FramePtr->Words;
+
+		XCan_WriteReg(BaseAddress, XCAN_TXFIFO_ID_OFFSET,
+			      EntryPtr->IdValue);
+		XCan_WriteReg(BaseAddress, XCAN_TXFIFO_DLC_OFFSET,
+			      WordsPtr[1]);
+		XCan_WriteReg(BaseAddress, XCAN_TXFIFO_DW1_OFFSET,
+			      Xil_Htonl(WordsPtr[2]));
+		XCan_WriteReg(BaseAddress, XCAN_TXFIFO_DW2_OFFSET,
+			      Xil_Htonl(WordsPtr[3]));
+		PortPtr->TxNext++;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Retires the oldest frame in the TX FIFO of a port: times it on its route
+* and drops its reference.
+*
+* @param	GatewayPtr is a pointer to the gateway.
+* @param	PortPtr is the port.
+* @param	Now is the current Timestamp.
+*
+* @return	None.
+*
+******************************************************************************/
+static void CanGateway_Retire(CanGateway *GatewayPtr,
+			      CanGateway_Port *PortPtr, u32 Now)
+{
+	CanGateway_TxEntry *EntryPtr =
+		&PortPtr->Tx[PortPtr->TxDone & (CAN_GW_TX_SIZE - 1U)];
+	CanGateway_RouteStats *StatsPtr =
+		&GatewayPtr->RouteStats[EntryPtr->Route];
+	u32 Latency = Now - EntryPtr->Stamp;
+
+	StatsPtr->Sent++;
+	StatsPtr->TotalLatency += Latency;
+	if (Latency < StatsPtr->MinLatency) {
+		StatsPtr->MinLatency = Latency;
+	}
+	if (Latency > StatsPtr->MaxLatency) {
+		StatsPtr->MaxLatency = Latency;
+	}
+
+	CanPool_Release(GatewayPtr->PoolPtr, EntryPtr->FramePtr);
+	PortPtr->TxDone++;
+}
@@ -0,0 +1,150 @@
+/******************************************************************************
+* CAN gateway forwarding frames between controllers by a routing table
+*
+* Bridges up to CAN_GW_MAX_PORTS AXI CAN controllers, each a port on a bus
+* of its own. A route takes the frames of one ID range received on its
+* source port to its destination port, optionally moving them to another
+* ID range of the same format:
+*
+*	CanGateway_Route Route = {
+*		0, 1, FALSE, 0x100, 0x1FF, 0x500	CAN0 0x100-0x1FF
+*	};					to CAN1 0x500-0x5FF
+*
+*	CanGateway_Init(&Gateway, &Pool, CanPtrs, 2);
+*	CanGateway_AddRoute(&Gateway, &Route);
+*	XCan_SetHandler(CanPtr, XCAN_HANDLER_RECV,
+*			(void *)CanGateway_RecvHandler, &Gateway.Port[0]);
+*	XCan_SetHandler(CanPtr, XCAN_HANDLER_SEND,
+*			(void *)CanGateway_SendHandler, &Gateway.Port[0]);
+*	... and the same for each port
+*
+* Forwarding is done in the receive interrupt handler of the source port:
+* the frame is read from the RX FIFO into a frame of a can_pool.h pool,
+* and a reference to it, with the ID it is to go out with, is queued on
+* each destination port and written straight into that controller's TX
+* FIFO if it has room. The send handler of the destination releases the
+* reference on TXOK and writes the next queued frame. The frame is never
+* copied between the two FIFOs, however many routes it takes: each
+* destination writes its own ID register and the shared words.
+*
+* Every route a frame matches forwards it, so one frame can go to several
+* ports, or to one port under two IDs. A frame no route matches is handed
+* to the local handler, if any, which may keep it with CanPool_Ref.
+*
+* For each route the gateway counts the frames forwarded, sent and dropped,
+* for want of a pool frame at the source or of room in the destination
+* queue, and times each frame from the end of its receive interrupt
+* handler's read to the TXOK of its destination, in Timestamp ticks.
+*
+* All the handlers of all the ports must run at one interrupt priority, so
+* that none preempts another: the destination queues are shared between
+* them without locks. CanGateway_Init and CanGateway_AddRoute are called
+* before the interrupts are enabled; the statistics may be read at any
+* time.
+*
+* A controller carrying gateway traffic is written by the gateway alone:
+* its TX FIFO must not also be fed by XCan_Send or a can_txsched.h
+* scheduler, whose TXOK accounting would then count the other's frames.
+* Timestamp_Initialize or MonoClock_Initialize must have been called.
+******************************************************************************/
+
+#ifndef CAN_GATEWAY_H		/* prevent circular inclusions */
+#define CAN_GATEWAY_H
+
+/***************************** Include Files *********************************/
+
+#include "xil_types.h"
+#include "xcan.h"
+#include "can_pool.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Controllers, routes, and frames queued per destination, a power of two */
+#define CAN_GW_MAX_PORTS		4U
+#define CAN_GW_MAX_ROUTES		16U
+#define CAN_GW_TX_SIZE			32U
+
+/* NewFirstId of a route that keeps the IDs */
+#define CAN_GW_KEEP_ID			0xFFFFFFFFU
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u8 Source;			/**< Port the frames come in on */
+	u8 Dest;			/**< Port they go out on */
+	u8 Extended;			/**< TRUE for 29-bit IDs */
+	u32 FirstId;			/**< ID range matched */
+	u32 LastId;
+	u32 NewFirstId;			/**< FirstId moves here, or KEEP */
+} CanGateway_Route;
+
+typedef struct {
+	u32 Forwarded;			/**< Frames queued to the dest */
+	u32 Sent;			/**< Frames the dest sent (TXOK) */
+	u32 NoFrame;			/**< Dropped, pool exhausted */
+	u32 NoRoom;			/**< Dropped, dest queue full */
+	u32 MinLatency;			/**< Receive to TXOK, ticks */
+	u32 MaxLatency;
+	u64 TotalLatency;
+} CanGateway_RouteStats;
+
+typedef struct {
+	u32 Received;			/**< Frames read from the RX FIFO */
+	u32 Unrouted;			/**< Frames no route took */
+	u32 TxHighWatermark;		/**< Most frames queued to send */
+} CanGateway_PortStats;
+
+/* A frame queued on a destination port */
+typedef struct {
+	CanPool_Frame *FramePtr;	/**< One reference held */
+	u32 IdValue;			/**< ID register it goes out with */
+	u32 Stamp;			/**< Timestamp of its reception */
+	u32 Route;
+} CanGateway_TxEntry;
+
+struct CanGateway;
+
+typedef struct {
+	struct CanGateway *GatewayPtr;
+	XCan *CanPtr;
+	CanGateway_TxEntry Tx[CAN_GW_TX_SIZE];
+	u32 TxHead;			/**< Next entry to queue */
+	u32 TxNext;			/**< Next entry to write to the FIFO */
+	u32 TxDone;			/**< Next entry to see its TXOK */
+	CanGateway_PortStats Stats;
+} CanGateway_Port;
+
+/* Handler of the frames no route takes, in interrupt context */
+typedef void (*CanGateway_LocalFn)(void *CallBackRef, u32 PortIndex,
+				   CanPool_Frame *FramePtr);
+
+typedef struct CanGateway {
+	CanPool *PoolPtr;
+	CanGateway_Port Port[CAN_GW_MAX_PORTS];
+	u32 NumPorts;
+	CanGateway_Route Route[CAN_GW_MAX_ROUTES];
+	CanGateway_RouteStats RouteStats[CAN_GW_MAX_ROUTES];
+	u32 NumRoutes;
+	CanGateway_LocalFn LocalFn;
+	void *LocalRef;
+	u32 Discard[CAN_POOL_FRAME_WORDS];	/**< Read with no pool frame */
+} CanGateway;
+
+/************************** Function Prototypes ******************************/
+
+int CanGateway_Init(CanGateway *GatewayPtr, CanPool *PoolPtr,
+		    XCan *const *CanPtrs, u32 NumPorts);
+int CanGateway_AddRoute(CanGateway *GatewayPtr,
+			const CanGateway_Route *RoutePtr);
+void CanGateway_SetLocalHandler(CanGateway *GatewayPtr,
+				CanGateway_LocalFn LocalFn, void *CallBackRef);
+
+void CanGateway_RecvHandler(void *CallBackRef);
+void CanGateway_SendHandler(void *CallBackRef);
+
+void CanGateway_GetRouteStats(CanGateway *GatewayPtr, u32 RouteIndex,
+			      CanGateway_RouteStats *StatsPtr);
+void CanGateway_GetPortStats(CanGateway *GatewayPtr, u32 PortIndex,
+			     CanGateway_PortStats *StatsPtr);
+
+#endif	/* end of protection macro */
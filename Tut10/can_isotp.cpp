@@ -0,0 +1,743 @@
+/******************************************************************************
+* ISO 15765-2 (ISO-TP) transport of messages longer than one CAN frame
+*
+* See can_isotp.h for the design. Timeouts and separation times are kept
+* in Timestamp_Now ticks, so Timestamp_Initialize or MonoClock_Initialize
+* must have been called before the first transfer.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <string.h>
+
+#include "xstatus.h"
+#include "timestamp.h"
+#include "can_isotp.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Protocol control information, the high nibble of the first byte */
+#define CAN_ISOTP_PCI_SF		0x00U
+#define CAN_ISOTP_PCI_FF		0x10U
+#define CAN_ISOTP_PCI_CF		0x20U
+#define CAN_ISOTP_PCI_FC		0x30U
+#define CAN_ISOTP_PCI_MASK		0xF0U
+
+/* Flow status of a Flow Control */
+#define CAN_ISOTP_FS_CTS		0x00U
+#define CAN_ISOTP_FS_WAIT		0x01U
+#define CAN_ISOTP_FS_OVFLW		0x02U
+#define CAN_ISOTP_FS_NONE		0xFFU
+
+/* Payload of each frame type */
+#define CAN_ISOTP_SF_BYTES		7U
+#define CAN_ISOTP_FF_BYTES		6U
+#define CAN_ISOTP_CF_BYTES		7U
+#define CAN_ISOTP_FRAME_BYTES		8U
+
+/* STmin the standard reserves are taken as the longest */
+#define CAN_ISOTP_MAX_STMIN_US		127000U
+
+/* States of each direction */
+#define CAN_ISOTP_IDLE_STATE		0U
+#define CAN_ISOTP_RX_CF			1U	/**< Consecutive Frames due */
+#define CAN_ISOTP_TX_FIRST		1U	/**< SF or FF to send */
+#define CAN_ISOTP_TX_WAIT_FC		2U	/**< Waiting for the receiver */
+#define CAN_ISOTP_TX_CF			3U	/**< Sending a block */
+
+/* Bits of the extended ID in ID2 */
+#define CAN_ISOTP_ID2_BITS		18U
+
+/************************** Function Prototypes ******************************/
+
+static u32 CanIsoTp_IdValue(u32 Id, u32 Extended);
+static int CanIsoTp_Due(u32 Now, u32 Time);
+static u32 CanIsoTp_Sooner(u32 Wait, u32 Now, u32 Time);
+static int CanIsoTp_SendFrame(CanIsoTp_Session *SessionPtr, u8 Pci,
+			      const u8 *DataPtr, u32 Offset, u32 Bytes,
+			      u8 *RetryPtr);
+static void CanIsoTp_SendFc(CanIsoTp_Session *SessionPtr, u8 Status);
+static int CanIsoTp_Transmit(CanIsoTp_Session *SessionPtr, u32 Now);
+static void CanIsoTp_Finish(CanIsoTp_Session *SessionPtr, int Status);
+static void CanIsoTp_Deliver(CanIsoTp_Session *SessionPtr);
+static void CanIsoTp_FlowControl(CanIsoTp_Session *SessionPtr,
+				 const u8 *DataPtr, u32 Now);
+static void CanIsoTp_Consecutive(CanIsoTp_Session *SessionPtr,
+				 const u8 *DataPtr, u32 Dlc, u32 Now);
+
+/*****************************************************************************/
+/**
+*
+* Initializes an engine with no sessions and no handlers.
+*
+* @param	IsoTpPtr is a pointer to the engine.
+* @param	SendFn queues the frames of every session for transmission.
+* @param	SendRef is passed to SendFn.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanIsoTp_Init(CanIsoTp *IsoTpPtr, CanIsoTp_SendFn SendFn, void *SendRef)
+{
+	memset(IsoTpPtr, 0, sizeof(*IsoTpPtr));
+	IsoTpPtr->SendFn = SendFn;
+	IsoTpPtr->SendRef = SendRef;
+	IsoTpPtr->Timeout = (u32)((u64)Timestamp_ClockHz *
+				  CAN_ISOTP_TIMEOUT_MS / 1000U);
+}
+
+/*****************************************************************************/
+/**
+*
+* Adds a session, numbered in the order the sessions are added from 0.
+* Its receive ID is not dispatched to it until the application registers
+* CanIsoTp_Frame for it, with the session as CallBackRef.
+*
+* @param	IsoTpPtr is a pointer to the engine.
+* @param	ConfigPtr gives the IDs and the flow control of the session.
+* @param	RxBuffer is where the messages received are reassembled.
+* @param	RxSize is its size, the longest message the session accepts.
+*
+* @return	XST_SUCCESS, XST_INVALID_PARAM for an ID out of range, or
+*		XST_FAILURE if the engine has no session left.
+*
+******************************************************************************/
+int CanIsoTp_AddSession(CanIsoTp *IsoTpPtr, const CanIsoTp_Config *ConfigPtr,
+			u8 *RxBuffer, u32 RxSize)
+{
+	CanIsoTp_Session *SessionPtr;
+	u32 MaxId = ConfigPtr->Extended ? 0x1FFFFFFFU : 0x7FFU;
+
+	if ((ConfigPtr->TxId > MaxId) || (ConfigPtr->RxId > MaxId)) {
+		return XST_INVALID_PARAM;
+	}
+	if (IsoTpPtr->NumSessions == CAN_ISOTP_MAX_SESSIONS) {
+		return XST_FAILURE;
+	}
+
+	SessionPtr = &IsoTpPtr->Session[IsoTpPtr->NumSessions];
+	memset(SessionPtr, 0, sizeof(*SessionPtr));
+	SessionPtr->IsoTpPtr = IsoTpPtr;
+	SessionPtr->TxIdValue = CanIsoTp_IdValue(ConfigPtr->TxId,
+						 ConfigPtr->Extended);
+	SessionPtr->BlockSize = ConfigPtr->BlockSize;
+	SessionPtr->STmin = ConfigPtr->STmin;
+	SessionPtr->FcPending = CAN_ISOTP_FS_NONE;
+	SessionPtr->RxBuffer = RxBuffer;
+	SessionPtr->RxSize = RxSize;
+	IsoTpPtr->NumSessions++;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Installs the handler of the messages received or of the end of the
+* messages sent, of all sessions.
+*
+* @param	IsoTpPtr is a pointer to the engine.
+* @param	HandlerType is CAN_ISOTP_HANDLER_RECV, a
+*		CanIsoTp_RecvHandler, or CAN_ISOTP_HANDLER_SEND, a
+*		CanIsoTp_SendHandler.
+* @param	CallBackFunc is the handler.
+* @param	CallBackRef is passed to it.
+*
+* @return	XST_SUCCESS, or XST_INVALID_PARAM for an unknown type.
+*
+******************************************************************************/
+int CanIsoTp_SetHandler(CanIsoTp *IsoTpPtr, u32 HandlerType,
+			void *CallBackFunc, void *CallBackRef)
+{
+	switch (HandlerType) {
+	case CAN_ISOTP_HANDLER_RECV:
+		IsoTpPtr->RecvHandler = (CanIsoTp_RecvHandler)CallBackFunc;
+		IsoTpPtr->RecvRef = CallBackRef;
+		break;
+
+	case CAN_ISOTP_HANDLER_SEND:
+		IsoTpPtr->SendHandler = (CanIsoTp_SendHandler)CallBackFunc;
+		IsoTpPtr->SendHandlerRef = CallBackRef;
+		break;
+
+	default:
+		return XST_INVALID_PARAM;
+	}
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Changes the block size and separation time a session asks of the peers
+* sending to it, from the next Flow Control on.
+*
+* @param	IsoTpPtr is a pointer to the engine.
+* @param	SessionIndex is the session.
+* @param	BlockSize is the Consecutive Frames between Flow Controls,
+*		0 for no more Flow Control after the first.
+* @param	STmin is the separation time, coded as on the wire.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanIsoTp_SetFlowControl(CanIsoTp *IsoTpPtr, u32 SessionIndex,
+			     u8 BlockSize, u8 STmin)
+{
+	IsoTpPtr->Session[SessionIndex].BlockSize = BlockSize;
+	IsoTpPtr->Session[SessionIndex].STmin = STmin;
+}
+
+/*****************************************************************************/
+/**
+*
+* Holds the Consecutive Frames of all sessions back while the send queue
+* has Limit frames or more not yet on the wire, so that a Flow Control
+* never waits behind more than that. CanIsoTp_Poll offers them again
+* once frames have gone, typically after the next TXOK.
+*
+* @param	IsoTpPtr is a pointer to the engine.
+* @param	PendingFn returns the frames queued, called with the SendRef
+*		of CanIsoTp_Init; NULL lifts the limit.
+* @param	Limit is the most frames left queued before a Consecutive
+*		Frame is offered, about one block.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanIsoTp_SetQueueLimit(CanIsoTp *IsoTpPtr, CanIsoTp_PendingFn PendingFn,
+			    u32 Limit)
+{
+	IsoTpPtr->PendingFn = PendingFn;
+	IsoTpPtr->QueueLimit = Limit;
+}
+
+/*****************************************************************************/
+/**
+*
+* Starts sending a message on a session. The first frame is offered to
+* the send function at once, the rest as the receiver lets them go.
+*
+* @param	IsoTpPtr is a pointer to the engine.
+* @param	SessionIndex is the session.
+* @param	DataPtr is the message. It is not copied and must stay as it
+*		is until the send handler is called.
+* @param	Length is its length, 1 to CAN_ISOTP_MAX_LENGTH bytes.
+*
+* @return
+*		- XST_SUCCESS if the message is being sent
+*		- XST_DEVICE_BUSY if the session is sending another
+*		- XST_INVALID_PARAM for a length out of range
+*
+******************************************************************************/
+int CanIsoTp_Send(CanIsoTp *IsoTpPtr, u32 SessionIndex, const u8 *DataPtr,
+		  u32 Length)
+{
+	CanIsoTp_Session *SessionPtr = &IsoTpPtr->Session[SessionIndex];
+
+	if ((Length == 0U) || (Length > CAN_ISOTP_MAX_LENGTH)) {
+		return XST_INVALID_PARAM;
+	}
+	if (SessionPtr->TxState != CAN_ISOTP_IDLE_STATE) {
+		return XST_DEVICE_BUSY;
+	}
+
+	SessionPtr->TxData = DataPtr;
+	SessionPtr->TxLength = Length;
+	SessionPtr->TxOffset = 0U;
+	SessionPtr->TxWaits = 0U;
+	SessionPtr->TxState = CAN_ISOTP_TX_FIRST;
+	(void)CanIsoTp_Transmit(SessionPtr, Timestamp_Now());
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Handles a frame received on the ID of a session: a CanDispatch_Handler,
+* registered with the session as CallBackRef.
+*
+* @param	CallBackRef is a pointer to the session.
+* @param	FramePtr is the frame in the XCan_Recv layout.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanIsoTp_Frame(void *CallBackRef, const u32 *FramePtr)
+{
+	CanIsoTp_Session *SessionPtr = (CanIsoTp_Session *)CallBackRef;
+	const u8 *DataPtr = (const u8 *)&FramePtr[2];
+	u32 Dlc = FramePtr[1] >> XCAN_DLCR_DLC_SHIFT;
+	u32 Now = Timestamp_Now();
+	u32 Length;
+
+	if (Dlc == 0U) {
+		return;
+	}
+	/* A classic CAN DLC of 9 to 15 means 8 bytes */
+	if (Dlc > CAN_ISOTP_FRAME_BYTES) {
+		Dlc = CAN_ISOTP_FRAME_BYTES;
+	}
+
+	switch (DataPtr[0] & CAN_ISOTP_PCI_MASK) {
+	case CAN_ISOTP_PCI_SF:
+		Length = DataPtr[0] & 0x0FU;
+		if ((Length == 0U) || (Length > CAN_ISOTP_SF_BYTES) ||
+		    (Length > Dlc - 1U)) {
+			break;
+		}
+		/* A new message ends the one being received, as ISO says */
+		SessionPtr->RxState = CAN_ISOTP_IDLE_STATE;
+		if (Length > SessionPtr->RxSize) {
+			SessionPtr->Stats.Overflows++;
+			break;
+		}
+		memcpy(SessionPtr->RxBuffer, &DataPtr[1], Length);
+		SessionPtr->RxLength = Length;
+		CanIsoTp_Deliver(SessionPtr);
+		break;
+
+	case CAN_ISOTP_PCI_FF:
+		Length = ((DataPtr[0] & 0x0FU) << 8) | DataPtr[1];
+		if ((Dlc != CAN_ISOTP_FRAME_BYTES) ||
+		    (Length <= CAN_ISOTP_SF_BYTES)) {
+			break;
+		}
+		SessionPtr->RxState = CAN_ISOTP_IDLE_STATE;
+		if (Length > SessionPtr->RxSize) {
+			SessionPtr->Stats.Overflows++;
+			CanIsoTp_SendFc(SessionPtr, CAN_ISOTP_FS_OVFLW);
+			break;
+		}
+		memcpy(SessionPtr->RxBuffer, &DataPtr[2], CAN_ISOTP_FF_BYTES);
+		SessionPtr->RxLength = Length;
+		SessionPtr->RxOffset = CAN_ISOTP_FF_BYTES;
+		SessionPtr->RxSn = 1U;
+		SessionPtr->RxBlockLeft = SessionPtr->BlockSize;
+		SessionPtr->RxDeadline = Now + SessionPtr->IsoTpPtr->Timeout;
+		SessionPtr->RxState = CAN_ISOTP_RX_CF;
+		CanIsoTp_SendFc(SessionPtr, CAN_ISOTP_FS_CTS);
+		break;
+
+	case CAN_ISOTP_PCI_CF:
+		CanIsoTp_Consecutive(SessionPtr, DataPtr, Dlc, Now);
+		break;
+
+	case CAN_ISOTP_PCI_FC:
+		if (Dlc >= 3U) {
+			CanIsoTp_FlowControl(SessionPtr, DataPtr, Now);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Does the work that waits for time or for room: sends the Consecutive
+* Frames that are due and the frames the send function refused, and gives
+* up the transfers whose peer has timed out.
+*
+* @param	IsoTpPtr is a pointer to the engine.
+*
+* @return	Timestamp ticks until the engine next has work, 0 if a frame
+*		was refused, to retry after the next TXOK, or CAN_ISOTP_IDLE
+*		if no transfer waits for time.
+*
+******************************************************************************/
+u32 CanIsoTp_Poll(CanIsoTp *IsoTpPtr)
+{
+	CanIsoTp_Session *SessionPtr;
+	u32 Now = Timestamp_Now();
+	u32 Wait = CAN_ISOTP_IDLE;
+	u32 Index;
+	u32 Start;
+	u32 Count;
+	int Sent;
+
+	for (Index = 0U; Index < IsoTpPtr->NumSessions; Index++) {
+		SessionPtr = &IsoTpPtr->Session[Index];
+
+		if (SessionPtr->FcPending != CAN_ISOTP_FS_NONE) {
+			CanIsoTp_SendFc(SessionPtr, SessionPtr->FcPending);
+		}
+		if ((SessionPtr->RxState == CAN_ISOTP_RX_CF) &&
+		    CanIsoTp_Due(Now, SessionPtr->RxDeadline)) {
+			SessionPtr->Stats.Timeouts++;
+			SessionPtr->RxState = CAN_ISOTP_IDLE_STATE;
+		}
+		if ((SessionPtr->TxState == CAN_ISOTP_TX_WAIT_FC) &&
+		    CanIsoTp_Due(Now, SessionPtr->TxDeadline)) {
+			SessionPtr->Stats.Timeouts++;
+			CanIsoTp_Finish(SessionPtr, XST_FAILURE);
+		}
+	}
+
+	/*
+	 * A frame of each session a round, so that they share the queue,
+	 * starting after the session that sent last, so that a queue with
+	 * room for one frame at a time does not always go to the first
+	 */
+	Start = IsoTpPtr->NextSession;
+	do {
+		Sent = FALSE;
+		for (Count = 0U; Count < IsoTpPtr->NumSessions; Count++) {
+			Index = (Start + Count) % IsoTpPtr->NumSessions;
+			if (CanIsoTp_Transmit(&IsoTpPtr->Session[Index],
+					      Now)) {
+				IsoTpPtr->NextSession = (Index + 1U) %
+					IsoTpPtr->NumSessions;
+				Sent = TRUE;
+			}
+		}
+	} while (Sent);
+
+	for (Index = 0U; Index < IsoTpPtr->NumSessions; Index++) {
+		SessionPtr = &IsoTpPtr->Session[Index];
+
+		/* What is left to wait for, a frame refused at once */
+		if ((SessionPtr->FcPending != CAN_ISOTP_FS_NONE) ||
+		    (SessionPtr->TxState == CAN_ISOTP_TX_FIRST)) {
+			Wait = 0U;
+		} else if (SessionPtr->TxState == CAN_ISOTP_TX_CF) {
+			Wait = CanIsoTp_Sooner(Wait, Now, SessionPtr->TxDue);
+		} else if (SessionPtr->TxState == CAN_ISOTP_TX_WAIT_FC) {
+			Wait = CanIsoTp_Sooner(Wait, Now,
+					       SessionPtr->TxDeadline);
+		}
+		if (SessionPtr->RxState == CAN_ISOTP_RX_CF) {
+			Wait = CanIsoTp_Sooner(Wait, Now,
+					       SessionPtr->RxDeadline);
+		}
+	}
+
+	return Wait;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the separation time a coded STmin asks for.
+*
+* @param	STmin is the STmin byte of a Flow Control.
+*
+* @return	The time in microseconds; reserved codes give the longest,
+*		127 ms, as ISO 15765-2 requires.
+*
+******************************************************************************/
+u32 CanIsoTp_STminUs(u8 STmin)
+{
+	if (STmin <= 0x7FU) {
+		return STmin * 1000U;
+	}
+	if ((STmin >= 0xF1U) && (STmin <= 0xF9U)) {
+		return (STmin - 0xF0U) * 100U;
+	}
+
+	return CAN_ISOTP_MAX_STMIN_US;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the statistics of a session.
+*
+* @param	IsoTpPtr is a pointer to the engine.
+* @param	SessionIndex is the session.
+* @param	StatsPtr is where the statistics are returned.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanIsoTp_GetStats(CanIsoTp *IsoTpPtr, u32 SessionIndex,
+		       CanIsoTp_Stats *StatsPtr)
+{
+	*StatsPtr = IsoTpPtr->Session[SessionIndex].Stats;
+}
+
+/*
+ * Returns the ID register of an ID
+ */
+static u32 CanIsoTp_IdValue(u32 Id, u32 Extended)
+{
+	if (Extended) {
+		u32 Id2 = Id & ((1U << CAN_ISOTP_ID2_BITS) - 1U);
+
+		return XCan_CreateIdValue(Id >> CAN_ISOTP_ID2_BITS, 1U, 1U,
+					  Id2, 0U);
+	}
+
+	return XCan_CreateIdValue(Id, 0U, 0U, 0U, 0U);
+}
+
+/*
+ * Returns TRUE once the timestamp Now has reached Time, across the wrap
+ */
+static int CanIsoTp_Due(u32 Now, u32 Time)
+{
+	return (s32)(Now - Time) >= 0;
+}
+
+/*
+ * Returns the shorter of Wait and the ticks from Now to Time, 0 if Time
+ * has come
+ */
+static u32 CanIsoTp_Sooner(u32 Wait, u32 Now, u32 Time)
+{
+	if (CanIsoTp_Due(Now, Time)) {
+		return 0U;
+	}
+
+	return ((Time - Now) < Wait) ? (Time - Now) : Wait;
+}
+
+/*
+ * Offers a frame of Pci and Bytes of the data from Offset to the send
+ * function, padded to 8 bytes. Pci is one byte, or two for a First Frame.
+ * *RetryPtr marks a frame already refused, which is counted once.
+ */
+static int CanIsoTp_SendFrame(CanIsoTp_Session *SessionPtr, u8 Pci,
+			      const u8 *DataPtr, u32 Offset, u32 Bytes,
+			      u8 *RetryPtr)
+{
+	CanIsoTp *IsoTpPtr = SessionPtr->IsoTpPtr;
+	u32 Frame[XCAN_MAX_FRAME_SIZE / sizeof(u32)];
+	u8 *BytePtr = (u8 *)&Frame[2];
+	u32 Start = 1U;
+
+	Frame[0] = SessionPtr->TxIdValue;
+	Frame[1] = XCan_CreateDlcValue(CAN_ISOTP_FRAME_BYTES);
+	memset(BytePtr, CAN_ISOTP_PADDING, CAN_ISOTP_FRAME_BYTES);
+	BytePtr[0] = Pci;
+	if ((Pci & CAN_ISOTP_PCI_MASK) == CAN_ISOTP_PCI_FF) {
+		BytePtr[1] = (u8)SessionPtr->TxLength;
+		Start = 2U;
+	}
+	memcpy(&BytePtr[Start], &DataPtr[Offset], Bytes);
+
+	if (IsoTpPtr->SendFn(IsoTpPtr->SendRef, Frame) != XST_SUCCESS) {
+		if (!*RetryPtr) {
+			SessionPtr->Stats.Refused++;
+			*RetryPtr = TRUE;
+		}
+		return FALSE;
+	}
+	*RetryPtr = FALSE;
+
+	return TRUE;
+}
+
+/*
+ * Sends a Flow Control with the block size and STmin of the session, or
+ * leaves it pending for the next poll if the send function refuses it
+ */
+static void CanIsoTp_SendFc(CanIsoTp_Session *SessionPtr, u8 Status)
+{
+	u8 Fc[2] = { SessionPtr->BlockSize, SessionPtr->STmin };
+
+	if (CanIsoTp_SendFrame(SessionPtr, CAN_ISOTP_PCI_FC | Status, Fc, 0U,
+			       sizeof(Fc), &SessionPtr->FcRetry)) {
+		SessionPtr->FcPending = CAN_ISOTP_FS_NONE;
+		SessionPtr->Stats.FlowControls++;
+	} else {
+		SessionPtr->FcPending = Status;
+	}
+}
+
+/*
+ * Offers the next frame of the message of a session if it is due: the
+ * first frame, or a Consecutive Frame whose separation time is over and
+ * that the queue limit lets through. Returns TRUE if the send function
+ * took it.
+ */
+static int CanIsoTp_Transmit(CanIsoTp_Session *SessionPtr, u32 Now)
+{
+	CanIsoTp *IsoTpPtr = SessionPtr->IsoTpPtr;
+	u32 Bytes;
+
+	if (SessionPtr->TxState == CAN_ISOTP_TX_FIRST) {
+		if (SessionPtr->TxLength <= CAN_ISOTP_SF_BYTES) {
+			if (!CanIsoTp_SendFrame(SessionPtr,
+						CAN_ISOTP_PCI_SF |
+						SessionPtr->TxLength,
+						SessionPtr->TxData, 0U,
+						SessionPtr->TxLength,
+						&SessionPtr->TxRetry)) {
+				return FALSE;
+			}
+			SessionPtr->TxOffset = SessionPtr->TxLength;
+			CanIsoTp_Finish(SessionPtr, XST_SUCCESS);
+			return TRUE;
+		}
+		if (!CanIsoTp_SendFrame(SessionPtr, CAN_ISOTP_PCI_FF |
+					(SessionPtr->TxLength >> 8),
+					SessionPtr->TxData, 0U,
+					CAN_ISOTP_FF_BYTES,
+					&SessionPtr->TxRetry)) {
+			return FALSE;
+		}
+		SessionPtr->TxOffset = CAN_ISOTP_FF_BYTES;
+		SessionPtr->TxSn = 1U;
+		SessionPtr->TxDeadline = Now + SessionPtr->IsoTpPtr->Timeout;
+		SessionPtr->TxState = CAN_ISOTP_TX_WAIT_FC;
+		return TRUE;
+	}
+
+	if ((SessionPtr->TxState != CAN_ISOTP_TX_CF) ||
+	    !CanIsoTp_Due(Now, SessionPtr->TxDue)) {
+		return FALSE;
+	}
+	if ((IsoTpPtr->PendingFn != NULL) &&
+	    (IsoTpPtr->PendingFn(IsoTpPtr->SendRef) >= IsoTpPtr->QueueLimit)) {
+		return FALSE;
+	}
+	Bytes = SessionPtr->TxLength - SessionPtr->TxOffset;
+	if (Bytes > CAN_ISOTP_CF_BYTES) {
+		Bytes = CAN_ISOTP_CF_BYTES;
+	}
+	if (!CanIsoTp_SendFrame(SessionPtr, CAN_ISOTP_PCI_CF | SessionPtr->TxSn,
+				SessionPtr->TxData, SessionPtr->TxOffset,
+				Bytes, &SessionPtr->TxRetry)) {
+		return FALSE;
+	}
+	SessionPtr->TxOffset += Bytes;
+	SessionPtr->TxSn = (SessionPtr->TxSn + 1U) & 0x0FU;
+	SessionPtr->TxDue = Now + SessionPtr->TxGap;
+
+	if (SessionPtr->TxOffset == SessionPtr->TxLength) {
+		CanIsoTp_Finish(SessionPtr, XST_SUCCESS);
+	} else if ((SessionPtr->TxBlockSize != 0U) &&
+		   (--SessionPtr->TxBlockLeft == 0U)) {
+		SessionPtr->TxDeadline = Now + SessionPtr->IsoTpPtr->Timeout;
+		SessionPtr->TxState = CAN_ISOTP_TX_WAIT_FC;
+	}
+
+	return TRUE;
+}
+
+/*
+ * Ends the message being sent and tells the send handler, which may start
+ * the next
+ */
+static void CanIsoTp_Finish(CanIsoTp_Session *SessionPtr, int Status)
+{
+	CanIsoTp *IsoTpPtr = SessionPtr->IsoTpPtr;
+
+	SessionPtr->TxState = CAN_ISOTP_IDLE_STATE;
+	if (Status == XST_SUCCESS) {
+		SessionPtr->Stats.Sent++;
+		SessionPtr->Stats.TxBytes += SessionPtr->TxLength;
+	}
+	if (IsoTpPtr->SendHandler != NULL) {
+		IsoTpPtr->SendHandler(IsoTpPtr->SendHandlerRef,
+				      (u32)(SessionPtr - IsoTpPtr->Session),
+				      Status);
+	}
+}
+
+/*
+ * Hands the message reassembled to the receive handler
+ */
+static void CanIsoTp_Deliver(CanIsoTp_Session *SessionPtr)
+{
+	CanIsoTp *IsoTpPtr = SessionPtr->IsoTpPtr;
+
+	SessionPtr->Stats.Received++;
+	SessionPtr->Stats.RxBytes += SessionPtr->RxLength;
+	if (IsoTpPtr->RecvHandler != NULL) {
+		IsoTpPtr->RecvHandler(IsoTpPtr->RecvRef,
+				      (u32)(SessionPtr - IsoTpPtr->Session),
+				      SessionPtr->RxBuffer,
+				      SessionPtr->RxLength);
+	}
+}
+
+/*
+ * Handles the Flow Control of the receiver of the message being sent
+ */
+static void CanIsoTp_FlowControl(CanIsoTp_Session *SessionPtr,
+				 const u8 *DataPtr, u32 Now)
+{
+	if (SessionPtr->TxState != CAN_ISOTP_TX_WAIT_FC) {
+		return;
+	}
+	SessionPtr->Stats.FlowControls++;
+
+	switch (DataPtr[0] & 0x0FU) {
+	case CAN_ISOTP_FS_CTS:
+		SessionPtr->TxBlockSize = DataPtr[1];
+		SessionPtr->TxBlockLeft = DataPtr[1];
+		SessionPtr->TxGap = (u32)((u64)Timestamp_ClockHz *
+					  CanIsoTp_STminUs(DataPtr[2]) /
+					  1000000U);
+		SessionPtr->TxWaits = 0U;
+		SessionPtr->TxDue = Now;
+		SessionPtr->TxState = CAN_ISOTP_TX_CF;
+		break;
+
+	case CAN_ISOTP_FS_WAIT:
+		SessionPtr->Stats.Waits++;
+		if (++SessionPtr->TxWaits > CAN_ISOTP_MAX_WAITS) {
+			SessionPtr->Stats.Timeouts++;
+			CanIsoTp_Finish(SessionPtr, XST_FAILURE);
+		} else {
+			SessionPtr->TxDeadline = Now +
+						 SessionPtr->IsoTpPtr->Timeout;
+		}
+		break;
+
+	case CAN_ISOTP_FS_OVFLW:
+		SessionPtr->Stats.Overflows++;
+		CanIsoTp_Finish(SessionPtr, XST_BUFFER_TOO_SMALL);
+		break;
+
+	default:
+		break;
+	}
+}
+
+/*
+ * Reassembles a Consecutive Frame of the message being received, asking
+ * for the next block when this one is complete
+ */
+static void CanIsoTp_Consecutive(CanIsoTp_Session *SessionPtr,
+				 const u8 *DataPtr, u32 Dlc, u32 Now)
+{
+	u32 Bytes;
+
+	if (SessionPtr->RxState != CAN_ISOTP_RX_CF) {
+		return;
+	}
+	if ((DataPtr[0] & 0x0FU) != SessionPtr->RxSn) {
+		SessionPtr->Stats.SequenceErrors++;
+		SessionPtr->RxState = CAN_ISOTP_IDLE_STATE;
+		return;
+	}
+	Bytes = SessionPtr->RxLength - SessionPtr->RxOffset;
+	if (Bytes > CAN_ISOTP_CF_BYTES) {
+		Bytes = CAN_ISOTP_CF_BYTES;
+	}
+	if (Bytes > Dlc - 1U) {
+		return;
+	}
+
+	memcpy(&SessionPtr->RxBuffer[SessionPtr->RxOffset], &DataPtr[1],
+	       Bytes);
+	SessionPtr->RxOffset += Bytes;
+	SessionPtr->RxSn = (SessionPtr->RxSn + 1U) & 0x0FU;
+	SessionPtr->RxDeadline = Now + SessionPtr->IsoTpPtr->Timeout;
+
+	if (SessionPtr->RxOffset == SessionPtr->RxLength) {
+		SessionPtr->RxState = CAN_ISOTP_IDLE_STATE;
+		CanIsoTp_Deliver(SessionPtr);
+	} else if ((SessionPtr->BlockSize != 0U) &&
+		   (--SessionPtr->RxBlockLeft == 0U)) {
+		SessionPtr->RxBlockLeft = SessionPtr->BlockSize;
+		CanIsoTp_SendFc(SessionPtr, CAN_ISOTP_FS_CTS);
+	}
+}
@@ -0,0 +1,209 @@
+/******************************************************************************
+* ISO 15765-2 (ISO-TP) transport of messages longer than one CAN frame
+*
+* Segments messages of up to CAN_ISOTP_MAX_LENGTH bytes into a First Frame
+* and Consecutive Frames, paced by the Flow Control frames of the receiver,
+* and reassembles them on the other side. Messages of up to 7 bytes go in
+* one Single Frame. A session is one pair of IDs, one to send on and one to
+* receive on, and carries one message each way at a time:
+*
+*	CanIsoTp_Init(&IsoTp, (CanIsoTp_SendFn)CanTxSched_Send, &TxSched);
+*	CanIsoTp_AddSession(&IsoTp, &Config, RxBuffer, sizeof(RxBuffer));
+*	CanIsoTp_SetHandler(&IsoTp, CAN_ISOTP_HANDLER_RECV,
+*			    (void *)MessageHandler, &App);
+*	CanDispatch_Register(&Dispatch, Config.RxId, Config.Extended,
+*			     CanIsoTp_Frame, &IsoTp.Session[0]);
+*	...
+*	CanIsoTp_Send(&IsoTp, 0, Request, Length);
+*	for (;;) {
+*		... dispatch the frames received ...
+*		Wait = CanIsoTp_Poll(&IsoTp);
+*		... sleep up to Wait ticks, or until an interrupt ...
+*	}
+*
+* Reception is in place: each session reassembles into the buffer given to
+* CanIsoTp_AddSession, which the receive handler is handed when the last
+* Consecutive Frame is in and may read until it returns. A First Frame
+* announcing more than the buffer holds is refused with a Flow Control
+* overflow. As the receiver, a session asks the sender for the block size
+* and separation time of its configuration, see CanIsoTp_SetFlowControl:
+* BS Consecutive Frames between Flow Controls, 0 for all at once, and
+* STmin between frames, coded as on the wire (0x00-0x7F milliseconds,
+* 0xF1-0xF9 100-900 microseconds).
+*
+* Transmission is zero copy too: CanIsoTp_Send takes the message where it
+* lies, which must stay untouched until the send handler is called. The
+* frames go to the send function, CanTxSched_Send or any other with its
+* return codes; one it refuses for want of room is offered again by the
+* next CanIsoTp_Poll. STmin is kept between frames handed to the send
+* function, which lags the wire by the frames already queued ahead.
+*
+* A Flow Control goes out on the same ID as the Consecutive Frames of the
+* session's own message the other way, so in a FIFO send queue it waits
+* behind every one of them already queued. CanIsoTp_SetQueueLimit keeps
+* that short: with the queue's count of frames not yet on the wire, e.g.
+* CanTxSched_Pending, Consecutive Frames are only offered while fewer
+* than Limit wait, about one block, and the Flow Controls, First and
+* Single Frames are not held back.
+*
+* Apart from the first frame of a message, sent by CanIsoTp_Send, the
+* frames are sent by CanIsoTp_Poll, which the caller runs after each batch
+* of frames dispatched. It sends the Consecutive Frames whose separation
+* time is over, one of each session in turn so that concurrent transfers
+* share the queue, and gives up the transfers whose peer has been silent
+* for CAN_ISOTP_TIMEOUT_MS (N_Bs and N_Cr). It returns the timestamp ticks
+* until it next has work, so the caller can sleep on a timer; a frame
+* refused makes it return 0, and the next TXOK is the time to call again.
+*
+* CanIsoTp_Frame, CanIsoTp_Send and CanIsoTp_Poll and the handlers they
+* call run in one context, normally the task draining the receive queue,
+* without locks. Timestamp_Initialize or MonoClock_Initialize must have
+* been called.
+******************************************************************************/
+
+#ifndef CAN_ISOTP_H		/* prevent circular inclusions */
+#define CAN_ISOTP_H
+
+/***************************** Include Files *********************************/
+
+#include "xil_types.h"
+#include "xcan.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Sessions of an engine, and the longest message, 12 bits of length */
+#define CAN_ISOTP_MAX_SESSIONS		8U
+#define CAN_ISOTP_MAX_LENGTH		4095U
+
+/* N_Bs and N_Cr: most a peer may keep a transfer waiting, and FC WAITs */
+#define CAN_ISOTP_TIMEOUT_MS		1000U
+#define CAN_ISOTP_MAX_WAITS		8U
+
+/* Value of the frame bytes past the end of a message */
+#define CAN_ISOTP_PADDING		0xCCU
+
+/* CanIsoTp_Poll: no transfer waits for time */
+#define CAN_ISOTP_IDLE			0xFFFFFFFFU
+
+/* Handler types for CanIsoTp_SetHandler */
+#define CAN_ISOTP_HANDLER_RECV		1U
+#define CAN_ISOTP_HANDLER_SEND		2U
+
+/**************************** Type Definitions *******************************/
+
+/*
+ * Queues a frame, XCan_Send layout; returns XST_SUCCESS or, without room,
+ * any other status
+ */
+typedef int (*CanIsoTp_SendFn)(void *SendRef, const u32 *FramePtr);
+
+/* Returns the frames queued and not yet on the wire */
+typedef u32 (*CanIsoTp_PendingFn)(void *SendRef);
+
+/* A message came in, in the buffer of the session */
+typedef void (*CanIsoTp_RecvHandler)(void *CallBackRef, u32 SessionIndex,
+				     u8 *DataPtr, u32 Length);
+
+/*
+ * A message went out, XST_SUCCESS, or was given up: XST_BUFFER_TOO_SMALL
+ * if the receiver had no room, XST_FAILURE if it did not answer
+ */
+typedef void (*CanIsoTp_SendHandler)(void *CallBackRef, u32 SessionIndex,
+				     int Status);
+
+typedef struct {
+	u32 TxId;			/**< ID the session sends on */
+	u32 RxId;			/**< ID it receives on */
+	u32 Extended;			/**< TRUE for 29-bit IDs */
+	u8 BlockSize;			/**< BS asked of senders, 0 none */
+	u8 STmin;			/**< STmin asked of senders, coded */
+} CanIsoTp_Config;
+
+typedef struct {
+	u32 Sent;			/**< Messages sent */
+	u32 Received;			/**< Messages received */
+	u32 TxBytes;
+	u32 RxBytes;
+	u32 FlowControls;		/**< Flow Controls sent and received */
+	u32 Waits;			/**< FC WAIT received */
+	u32 Timeouts;			/**< Transfers given up, N_Bs or N_Cr */
+	u32 SequenceErrors;		/**< Receptions lost to a wrong SN */
+	u32 Overflows;			/**< Messages too long for a buffer */
+	u32 Refused;			/**< Frames refused, counted once */
+} CanIsoTp_Stats;
+
+struct CanIsoTp;
+
+typedef struct {
+	struct CanIsoTp *IsoTpPtr;
+	u32 TxIdValue;			/**< ID register of the frames sent */
+	u8 BlockSize;
+	u8 STmin;
+
+	/* Reception, into RxBuffer */
+	u8 RxState;
+	u8 RxSn;			/**< Sequence number expected */
+	u8 RxBlockLeft;			/**< Frames until the next FC */
+	u8 FcPending;			/**< FC status refused, or NONE */
+	u8 FcRetry;			/**< The FC pending was refused */
+	u8 *RxBuffer;
+	u32 RxSize;
+	u32 RxLength;
+	u32 RxOffset;
+	u32 RxDeadline;			/**< Timestamp N_Cr runs out */
+
+	/* Transmission, from TxData */
+	u8 TxState;
+	u8 TxSn;
+	u8 TxBlockSize;			/**< BS of the receiver */
+	u8 TxBlockLeft;
+	u8 TxWaits;			/**< FC WAIT in a row */
+	u8 TxRetry;			/**< The next frame was refused */
+	const u8 *TxData;
+	u32 TxLength;
+	u32 TxOffset;
+	u32 TxGap;			/**< STmin of the receiver, ticks */
+	u32 TxDue;			/**< Timestamp the next CF is due */
+	u32 TxDeadline;			/**< Timestamp N_Bs runs out */
+
+	CanIsoTp_Stats Stats;
+} CanIsoTp_Session;
+
+typedef struct CanIsoTp {
+	CanIsoTp_SendFn SendFn;
+	void *SendRef;
+	CanIsoTp_PendingFn PendingFn;	/**< NULL: Consecutive Frames unheld */
+	u32 QueueLimit;			/**< Frames left queued before a CF */
+	CanIsoTp_Session Session[CAN_ISOTP_MAX_SESSIONS];
+	u32 NumSessions;
+	u32 NextSession;		/**< Offered a frame first next round */
+	u32 Timeout;			/**< N_Bs and N_Cr, timestamp ticks */
+	CanIsoTp_RecvHandler RecvHandler;
+	void *RecvRef;
+	CanIsoTp_SendHandler SendHandler;
+	void *SendHandlerRef;
+} CanIsoTp;
+
+/************************** Function Prototypes ******************************/
+
+void CanIsoTp_Init(CanIsoTp *IsoTpPtr, CanIsoTp_SendFn SendFn,
+		   void *SendRef);
+int CanIsoTp_AddSession(CanIsoTp *IsoTpPtr, const CanIsoTp_Config *ConfigPtr,
+			u8 *RxBuffer, u32 RxSize);
+int CanIsoTp_SetHandler(CanIsoTp *IsoTpPtr, u32 HandlerType,
+			void *CallBackFunc, void *CallBackRef);
+void CanIsoTp_SetFlowControl(CanIsoTp *IsoTpPtr, u32 SessionIndex,
+			     u8 BlockSize, u8 STmin);
+void CanIsoTp_SetQueueLimit(CanIsoTp *IsoTpPtr, CanIsoTp_PendingFn PendingFn,
+			    u32 Limit);
+
+int CanIsoTp_Send(CanIsoTp *IsoTpPtr, u32 SessionIndex, const u8 *DataPtr,
+		  u32 Length);
+void CanIsoTp_Frame(void *CallBackRef, const u32 *FramePtr);
+u32 CanIsoTp_Poll(CanIsoTp *IsoTpPtr);
+
+u32 CanIsoTp_STminUs(u8 STmin);
+void CanIsoTp_GetStats(CanIsoTp *IsoTpPtr, u32 SessionIndex,
+		       CanIsoTp_Stats *StatsPtr);
+
+#endif	/* end of protection macro */
@@ -0,0 +1,106 @@
+/******************************************************************************
+* Binary CAN capture log
+*
+* The append fast path is inline in can_log.h. This file sets up logs,
+* checks loaded ones and writes them out, outside the interrupt handler.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <string.h>
+
+#include "xil_printf.h"
+#include "can_log.h"
+
+/*****************************************************************************/
+/**
+*
+* Sets up an empty log image in Buffer.
+*
+* @param	CapturePtr is a pointer to the capture.
+* @param	Buffer is the memory of the image, 8-byte aligned.
+* @param	Size is the size of Buffer in bytes, see CAN_LOG_SIZE.
+* @param	ClockHz is the rate of the timestamps that will be appended.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanLog_Init(CanLog *CapturePtr, void *Buffer, u32 Size, u32 ClockHz)
+{
+	CanLog_Header *LogPtr = (CanLog_Header *)Buffer;
+
+	memset(LogPtr, 0, sizeof(*LogPtr));
+	LogPtr->Magic = CAN_LOG_MAGIC;
+	LogPtr->Version = CAN_LOG_VERSION;
+	LogPtr->RecordSize = (u16)sizeof(CanLog_Record);
+	LogPtr->ClockHz = ClockHz;
+
+	CapturePtr->Log = LogPtr;
+	CapturePtr->MaxRecords = (Size - (u32)sizeof(CanLog_Header)) /
+				 (u32)sizeof(CanLog_Record);
+}
+
+/*****************************************************************************/
+/**
+*
+* Empties the log. The appending context must not run meanwhile.
+*
+* @param	CapturePtr is a pointer to the capture.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanLog_Reset(CanLog *CapturePtr)
+{
+	CapturePtr->Log->NumRecords = 0U;
+	CapturePtr->Log->Dropped = 0U;
+}
+
+/*****************************************************************************/
+/**
+*
+* Checks that memory holds a log image of this version, e.g. one loaded
+* for replay.
+*
+* @param	LogPtr is a pointer to the image.
+* @param	Size is the number of bytes available at LogPtr.
+*
+* @return	TRUE if the header is valid and all its records are within
+*		Size, FALSE otherwise.
+*
+******************************************************************************/
+int CanLog_IsValid(const CanLog_Header *LogPtr, u32 Size)
+{
+	if ((Size < sizeof(CanLog_Header)) ||
+	    (LogPtr->Magic != CAN_LOG_MAGIC) ||
+	    (LogPtr->Version != CAN_LOG_VERSION) ||
+	    (LogPtr->RecordSize != sizeof(CanLog_Record)) ||
+	    (LogPtr->ClockHz == 0U)) {
+		return FALSE;
+	}
+
+	return LogPtr->NumRecords <= (Size - sizeof(CanLog_Header)) /
+				     sizeof(CanLog_Record);
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes the log image, header and records, to STDOUT as raw bytes. Call it
+* from the idle loop once the capture is over.
+*
+* @param	CapturePtr is a pointer to the capture.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanLog_Flush(CanLog *CapturePtr)
+{
+	const u8 *BytePtr = (const u8 *)CapturePtr->Log;
+	u32 Size = (u32)CAN_LOG_SIZE(CapturePtr->Log->NumRecords);
+	u32 Index;
+
+	for (Index = 0U; Index < Size; Index++) {
+		outbyte((char8)BytePtr[Index]);
+	}
+}
@@ -0,0 +1,135 @@
+/******************************************************************************
+* Binary CAN capture log
+*
+* Records every received frame with its timestamp into a log image in
+* memory, cheap enough to call from the receive interrupt handler:
+*
+*	CanLog_Init(&Capture, CaptureBuffer, sizeof(CaptureBuffer),
+*		    MonoClock_ClockHz);
+*	...
+*	ISR:	XCan_Recv(CanPtr, FramePtr);
+*		CanLog_Append(&Capture, FramePtr, MonoClock_Now());
+*	...
+*	CanLog_Flush(&Capture);
+*
+* The image is the file format: a header and fixed-size records, all
+* little-endian and naturally aligned, so the host maps a log file and
+* reads it in place (HostSim/tools/canlog converts it to and from candump
+* text) and the target replays one loaded into memory without parsing it
+* (can_replay.h). Each record holds the 64-bit clock count and the frame in
+* the XCan_Recv layout, ID register, DLC register and the two data words
+* with the data bytes in bus order, so a record's Frame goes to
+* XCan_Send, CanTxQueue_Send or CanDispatch_Frame as it is.
+*
+* A full log keeps its first frames and counts the rest in Dropped.
+* CanLog_Flush writes the image to STDOUT, where HostSim/tools/canlog
+* extract finds it among the text output by its magic number.
+******************************************************************************/
+
+#ifndef CAN_LOG_H		/* prevent circular inclusions */
+#define CAN_LOG_H
+
+/***************************** Include Files *********************************/
+
+#include "xil_types.h"
+#include "xcan.h"
+
+/************************** Constant Definitions *****************************/
+
+/* First word of a log, 0xA5 'C' 'L' 'G' in memory, never seen in text */
+#define CAN_LOG_MAGIC			0x474C43A5U
+#define CAN_LOG_VERSION			1U
+
+/* Words of a frame, as XCan_Recv stores it */
+#define CAN_LOG_FRAME_WORDS		(XCAN_MAX_FRAME_SIZE / sizeof(u32))
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 Magic;			/**< CAN_LOG_MAGIC */
+	u16 Version;			/**< CAN_LOG_VERSION */
+	u16 RecordSize;			/**< sizeof(CanLog_Record) */
+	u32 ClockHz;			/**< Rate of the record Ticks */
+	u32 NumRecords;
+	u32 Dropped;			/**< Frames lost, log full */
+	u32 Reserved[3];
+} CanLog_Header;
+
+typedef struct {
+	u64 Ticks;			/**< Clock count at reception */
+	u32 Frame[CAN_LOG_FRAME_WORDS];	/**< As XCan_Recv stores it */
+} CanLog_Record;
+
+typedef struct {
+	CanLog_Header *Log;		/**< The image, records follow */
+	u32 MaxRecords;
+} CanLog;
+
+static_assert(sizeof(CanLog_Header) == 32U, "log header layout");
+static_assert(sizeof(CanLog_Record) == 24U, "log record layout");
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/* Bytes of a log image holding Records records */
+#define CAN_LOG_SIZE(Records) \
+	(sizeof(CanLog_Header) + (Records) * sizeof(CanLog_Record))
+
+/************************** Function Prototypes ******************************/
+
+void CanLog_Init(CanLog *CapturePtr, void *Buffer, u32 Size, u32 ClockHz);
+void CanLog_Reset(CanLog *CapturePtr);
+int CanLog_IsValid(const CanLog_Header *LogPtr, u32 Size);
+void CanLog_Flush(CanLog *CapturePtr);
+
+/*****************************************************************************/
+/**
+*
+* Returns the records of a log image.
+*
+* @param	LogPtr is a pointer to the log header.
+*
+* @return	Pointer to the first of NumRecords records.
+*
+******************************************************************************/
+static inline CanLog_Record *CanLog_Records(const CanLog_Header *LogPtr)
+{
+	return (CanLog_Record *)(LogPtr + 1);
+}
+
+/*****************************************************************************/
+/**
+*
+* Appends a frame to the log. Call it from a single context, normally the
+* receive interrupt handler.
+*
+* @param	CapturePtr is a pointer to the capture.
+* @param	FramePtr is the frame as XCan_Recv stores it.
+* @param	Ticks is the clock count at reception.
+*
+* @return	TRUE if the frame was logged, FALSE if the log is full.
+*
+******************************************************************************/
+static inline int CanLog_Append(CanLog *CapturePtr, const u32 *FramePtr,
+				u64 Ticks)
+{
+	CanLog_Header *LogPtr = CapturePtr->Log;
+	u32 Index = LogPtr->NumRecords;
+	CanLog_Record *RecordPtr;
+
+	if (Index == CapturePtr->MaxRecords) {
+		LogPtr->Dropped++;
+		return FALSE;
+	}
+
+	RecordPtr = &CanLog_Records(LogPtr)[Index];
+	RecordPtr->Ticks = Ticks;
+	RecordPtr->Frame[0] = FramePtr[0];
+	RecordPtr->Frame[1] = FramePtr[1];
+	RecordPtr->Frame[2] = FramePtr[2];
+	RecordPtr->Frame[3] = FramePtr[3];
+	LogPtr->NumRecords = Index + 1U;
+
+	return TRUE;
+}
+
+#endif	/* end of protection macro */
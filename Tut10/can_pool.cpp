@@ -0,0 +1,104 @@
+/******************************************************************************
+* Lock-free pool of reference-counted CAN frames
+*
+* The fast paths are inline in can_pool.h. This file holds the set-up and
+* statistics functions, which are only called from task context.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "can_pool.h"
+
+/************************** Constant Definitions *****************************/
+
+static_assert((CAN_POOL_FRAMES & (CAN_POOL_FRAMES - 1U)) == 0U,
+	      "the queue index wraps on a power of two");
+static_assert(CAN_POOL_FRAMES < CAN_POOL_NONE,
+	      "frame indexes must fit below the empty mark");
+
+/*****************************************************************************/
+/**
+*
+* Returns every frame to the pool and clears its statistics. Must be called
+* before any interrupt handler allocates from it.
+*
+* @param	PoolPtr is a pointer to the pool.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanPool_Init(CanPool *PoolPtr)
+{
+	u32 Index;
+
+	for (Index = 0U; Index < CAN_POOL_FRAMES; Index++) {
+		PoolPtr->Frame[Index].Refs.store(0U, std::memory_order_relaxed);
+		PoolPtr->Frame[Index].Next.store(Index + 1U < CAN_POOL_FRAMES ?
+						 Index + 1U : CAN_POOL_NONE,
+						 std::memory_order_relaxed);
+	}
+	PoolPtr->Free.store(0U, std::memory_order_relaxed);
+	PoolPtr->InUse.store(0U, std::memory_order_relaxed);
+	PoolPtr->HighWatermark.store(0U, std::memory_order_relaxed);
+	PoolPtr->Allocs.store(0U, std::memory_order_relaxed);
+	PoolPtr->Exhausted.store(0U, std::memory_order_relaxed);
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the pool statistics. Each counter is read consistently on its own,
+* without masking interrupts.
+*
+* @param	PoolPtr is a pointer to the pool.
+* @param	StatsPtr is where the statistics are returned.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanPool_GetStats(CanPool *PoolPtr, CanPool_Stats *StatsPtr)
+{
+	StatsPtr->InUse = PoolPtr->InUse.load(std::memory_order_relaxed);
+	StatsPtr->HighWatermark =
+		PoolPtr->HighWatermark.load(std::memory_order_relaxed);
+	StatsPtr->Allocs = PoolPtr->Allocs.load(std::memory_order_relaxed);
+	StatsPtr->Exhausted =
+		PoolPtr->Exhausted.load(std::memory_order_relaxed);
+}
+
+/*****************************************************************************/
+/**
+*
+* Restarts the allocation counts and the high watermark, e.g. at the start
+* of a measurement window. The high watermark restarts from the frames in
+* use.
+*
+* @param	PoolPtr is a pointer to the pool.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanPool_ClearStats(CanPool *PoolPtr)
+{
+	PoolPtr->Allocs.store(0U, std::memory_order_relaxed);
+	PoolPtr->Exhausted.store(0U, std::memory_order_relaxed);
+	PoolPtr->HighWatermark.store(
+		PoolPtr->InUse.load(std::memory_order_relaxed),
+		std::memory_order_relaxed);
+}
+
+/*****************************************************************************/
+/**
+*
+* Empties a queue. Must be called before its producer runs.
+*
+* @param	QueuePtr is a pointer to the queue.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanPool_QueueInit(CanPool_Queue *QueuePtr)
+{
+	QueuePtr->Head.store(0U, std::memory_order_relaxed);
+	QueuePtr->Tail.store(0U, std::memory_order_relaxed);
+}
@@ -0,0 +1,282 @@
+/******************************************************************************
+* Lock-free pool of reference-counted CAN frames
+*
+* A fixed set of CAN_POOL_FRAMES frame buffers, handed out and returned
+* without masking interrupts, so the receive interrupt handler can read a
+* frame straight into a buffer and pass that same buffer, by handle, to
+* any number of consumers in task context:
+*
+*	ISR:	FramePtr = CanPool_Alloc(&Pool);	one reference
+*		if (FramePtr == NULL) -> pool exhausted, frame is dropped
+*		XCan_Recv(CanPtr, FramePtr->Words);
+*		CanPool_Put(&Queue, FramePtr);		the queue holds it
+*
+*	Task:	while ((FramePtr = CanPool_Peek(&Queue)) != NULL) {
+*			CanPool_Take(&Queue);		now the task's
+*			... each consumer keeping the frame takes a
+*			    CanPool_Ref and releases it when done ...
+*			CanPool_Release(&Pool, FramePtr);
+*		}
+*
+* The last CanPool_Release returns the buffer to the pool; nothing is
+* copied between the hardware FIFO and the last consumer. The frame words
+* come first in a CanPool_Frame, so a handler given only the words, as
+* CanDispatch handlers are, gets its handle back with CanPool_FrameOf.
+*
+* The free frames form a stack linked by index. Its top is one word, the
+* index and a tag counting the pushes and pops, replaced with a
+* compare-and-swap: an interrupt handler that takes or returns a frame
+* between the read of the top and the swap of a task makes the swap fail
+* and the task retry, and the tag keeps a top that was popped and pushed
+* back meanwhile from passing as unchanged, up to 65535 pops and pushes
+* within one retry. Any context may allocate and release.
+*
+* A CanPool_Queue is a single-producer/single-consumer ring of handles, as
+* can_ring.h is of frames. It holds as many handles as the pool has
+* frames, so it cannot fill while each frame is queued at most once.
+*
+* InUse counts the frames allocated and not yet released, HighWatermark
+* the most at once, to size the pool, and Exhausted the allocations
+* refused because none was free.
+******************************************************************************/
+
+#ifndef CAN_POOL_H		/* prevent circular inclusions */
+#define CAN_POOL_H
+
+/***************************** Include Files *********************************/
+
+#include <stddef.h>
+#include <atomic>
+
+#include "xil_types.h"
+#include "xcan.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Frames in the pool, a power of two below 65536 */
+#define CAN_POOL_FRAMES			64U
+
+/* Words per frame, as read by XCan_Recv */
+#define CAN_POOL_FRAME_WORDS		(XCAN_MAX_FRAME_SIZE / sizeof(u32))
+
+/* Top of the free stack: index of the first free frame, and the tag */
+#define CAN_POOL_INDEX_MASK		0x0000FFFFU
+#define CAN_POOL_TAG_ONE		0x00010000U
+#define CAN_POOL_NONE			CAN_POOL_INDEX_MASK	/**< Empty */
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 Words[CAN_POOL_FRAME_WORDS];	/**< XCan_Recv layout */
+	std::atomic<u32> Refs;		/**< References, 0 while free */
+	std::atomic<u32> Next;		/**< Next free frame, while free */
+} CanPool_Frame;
+
+typedef struct {
+	CanPool_Frame Frame[CAN_POOL_FRAMES];
+	std::atomic<u32> Free;		/**< Top of the free stack */
+	std::atomic<u32> InUse;		/**< Frames allocated */
+	std::atomic<u32> HighWatermark;	/**< Most frames allocated */
+	std::atomic<u32> Allocs;	/**< Frames handed out */
+	std::atomic<u32> Exhausted;	/**< Allocations refused */
+} CanPool;
+
+typedef struct {
+	u32 InUse;			/**< Frames allocated */
+	u32 HighWatermark;		/**< Most frames allocated */
+	u32 Allocs;			/**< Frames handed out */
+	u32 Exhausted;			/**< Allocations refused */
+} CanPool_Stats;
+
+typedef struct {
+	CanPool_Frame *Slot[CAN_POOL_FRAMES];
+	std::atomic<u32> Head;		/**< Next slot to fill (producer) */
+	std::atomic<u32> Tail;		/**< Next slot to drain (consumer) */
+} CanPool_Queue;
+
+/************************** Function Prototypes ******************************/
+
+void CanPool_Init(CanPool *PoolPtr);
+void CanPool_GetStats(CanPool *PoolPtr, CanPool_Stats *StatsPtr);
+void CanPool_ClearStats(CanPool *PoolPtr);
+void CanPool_QueueInit(CanPool_Queue *QueuePtr);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/*****************************************************************************/
+/**
+*
+* Takes a frame from the pool, holding one reference. An empty pool is
+* counted as exhausted, the caller is expected to discard the frame.
+*
+* @param	PoolPtr is a pointer to the pool.
+*
+* @return	Pointer to the frame, or NULL.
+*
+******************************************************************************/
+static inline CanPool_Frame *CanPool_Alloc(CanPool *PoolPtr)
+{
+	u32 Top = PoolPtr->Free.load(std::memory_order_acquire);
+	u32 Next;
+	u32 Used;
+	u32 Max;
+	CanPool_Frame *FramePtr;
+
+	do {
+		if ((Top & CAN_POOL_INDEX_MASK) == CAN_POOL_NONE) {
+			PoolPtr->Exhausted.fetch_add(1U,
+						     std::memory_order_relaxed);
+			return NULL;
+		}
+		FramePtr = &PoolPtr->Frame[Top & CAN_POOL_INDEX_MASK];
+		Next = FramePtr->Next.load(std::memory_order_relaxed) |
+		       ((Top + CAN_POOL_TAG_ONE) & ~CAN_POOL_INDEX_MASK);
+	} while (!PoolPtr->Free.compare_exchange_weak(Top, Next,
+					std::memory_order_acquire,
+					std::memory_order_acquire));
+
+	FramePtr->Refs.store(1U, std::memory_order_relaxed);
+	PoolPtr->Allocs.fetch_add(1U, std::memory_order_relaxed);
+	Used = PoolPtr->InUse.fetch_add(1U, std::memory_order_relaxed) + 1U;
+	Max = PoolPtr->HighWatermark.load(std::memory_order_relaxed);
+	while ((Used > Max) &&
+	       !PoolPtr->HighWatermark.compare_exchange_weak(Max, Used,
+					std::memory_order_relaxed)) {
+	}
+
+	return FramePtr;
+}
+
+/*****************************************************************************/
+/**
+*
+* Adds a reference to a frame, for a consumer that keeps it past the
+* release of the reference it was handed.
+*
+* @param	FramePtr is a frame holding at least one reference.
+*
+* @return	None.
+*
+******************************************************************************/
+static inline void CanPool_Ref(CanPool_Frame *FramePtr)
+{
+	FramePtr->Refs.fetch_add(1U, std::memory_order_relaxed);
+}
+
+/*****************************************************************************/
+/**
+*
+* Drops a reference to a frame, returning it to the pool with the last.
+*
+* @param	PoolPtr is the pool the frame came from.
+* @param	FramePtr is the frame.
+*
+* @return	None.
+*
+******************************************************************************/
+static inline void CanPool_Release(CanPool *PoolPtr, CanPool_Frame *FramePtr)
+{
+	u32 Index = (u32)(FramePtr - PoolPtr->Frame);
+	u32 Top;
+	u32 NewTop;
+
+	if (FramePtr->Refs.fetch_sub(1U, std::memory_order_acq_rel) != 1U) {
+		return;
+	}
+
+	PoolPtr->InUse.fetch_sub(1U, std::memory_order_relaxed);
+	Top = PoolPtr->Free.load(std::memory_order_relaxed);
+	do {
+		FramePtr->Next.store(Top & CAN_POOL_INDEX_MASK,
+				     std::memory_order_relaxed);
+		NewTop = Index |
+			 ((Top + CAN_POOL_TAG_ONE) & ~CAN_POOL_INDEX_MASK);
+	} while (!PoolPtr->Free.compare_exchange_weak(Top, NewTop,
+					std::memory_order_release,
+					std::memory_order_relaxed));
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the frame whose words these are, for a handler given only the
+* words of a pool frame.
+*
+* @param	WordsPtr is the Words of a CanPool_Frame.
+*
+* @return	Pointer to the frame.
+*
+******************************************************************************/
+static inline CanPool_Frame *CanPool_FrameOf(const u32 *WordsPtr)
+{
+	static_assert(offsetof(CanPool_Frame, Words) == 0U,
+		      "the words must start the frame");
+
+	return (CanPool_Frame *)WordsPtr;
+}
+
+/*****************************************************************************/
+/**
+*
+* Producer side: queues a frame, handing the caller's reference to the
+* consumer.
+*
+* @param	QueuePtr is a pointer to the queue.
+* @param	FramePtr is the frame.
+*
+* @return	None.
+*
+* @note		The queue holds CAN_POOL_FRAMES handles, so it never fills
+*		with the frames of one pool queued once each.
+*
+******************************************************************************/
+static inline void CanPool_Put(CanPool_Queue *QueuePtr,
+			       CanPool_Frame *FramePtr)
+{
+	u32 Head = QueuePtr->Head.load(std::memory_order_relaxed);
+
+	QueuePtr->Slot[Head & (CAN_POOL_FRAMES - 1U)] = FramePtr;
+	QueuePtr->Head.store(Head + 1U, std::memory_order_release);
+}
+
+/*****************************************************************************/
+/**
+*
+* Consumer side: returns the oldest frame in the queue without removing
+* it, or NULL when the queue is empty.
+*
+* @param	QueuePtr is a pointer to the queue.
+*
+* @return	Pointer to the frame, or NULL.
+*
+******************************************************************************/
+static inline CanPool_Frame *CanPool_Peek(CanPool_Queue *QueuePtr)
+{
+	u32 Tail = QueuePtr->Tail.load(std::memory_order_relaxed);
+
+	if (Tail == QueuePtr->Head.load(std::memory_order_acquire)) {
+		return NULL;
+	}
+
+	return QueuePtr->Slot[Tail & (CAN_POOL_FRAMES - 1U)];
+}
+
+/*****************************************************************************/
+/**
+*
+* Consumer side: removes the frame returned by CanPool_Peek, whose
+* reference passes to the caller.
+*
+* @param	QueuePtr is a pointer to the queue.
+*
+* @return	None.
+*
+******************************************************************************/
+static inline void CanPool_Take(CanPool_Queue *QueuePtr)
+{
+	u32 Tail = QueuePtr->Tail.load(std::memory_order_relaxed);
+
+	QueuePtr->Tail.store(Tail + 1U, std::memory_order_release);
+}
+
+#endif	/* end of protection macro */
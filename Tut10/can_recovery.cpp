@@ -0,0 +1,247 @@
+/******************************************************************************
+* CAN bus-off and error-passive recovery
+*
+* See can_recovery.h for the state machine. CanRecovery_BusOff,
+* CanRecovery_Error and CanRecovery_Recovered run in the CAN interrupt;
+* CanRecovery_Poll runs in task context and masks interrupts for the few
+* fields both sides write.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xil_exception.h"
+#include "can_recovery.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Fault confinement states in the ESTAT field of the status register */
+#define CAN_RECOVERY_ESTAT_ACTIVE	1U
+#define CAN_RECOVERY_ESTAT_PASSIVE	3U
+
+/************************** Function Prototypes ******************************/
+
+static u32 CanRecovery_Estat(CanRecovery *RecPtr);
+
+/*****************************************************************************/
+/**
+*
+* Initializes the recovery of a controller that is error active.
+*
+* @param	RecPtr is a pointer to the recovery.
+* @param	CanPtr is a pointer to the XCan instance.
+* @param	SchedPtr is the transmit scheduler feeding it, for the
+*		frame counts.
+* @param	Mode is the mode to rejoin the bus in, XCAN_MODE_NORMAL or
+*		XCAN_MODE_LOOPBACK.
+* @param	MinBackoff is the delay before the first attempt to rejoin,
+*		in ticks of the clock the Now arguments are read from.
+* @param	MaxBackoff is the longest delay, and how long the link must
+*		stay up for the delay to return to MinBackoff.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanRecovery_Init(CanRecovery *RecPtr, XCan *CanPtr,
+		      CanTxSched *SchedPtr, u8 Mode, u64 MinBackoff,
+		      u64 MaxBackoff)
+{
+	RecPtr->CanPtr = CanPtr;
+	RecPtr->SchedPtr = SchedPtr;
+	RecPtr->Mode = Mode;
+	RecPtr->MinBackoff = MinBackoff;
+	RecPtr->MaxBackoff = (MaxBackoff > MinBackoff) ? MaxBackoff :
+			     MinBackoff;
+	RecPtr->State.store(CAN_LINK_ERROR_ACTIVE, std::memory_order_relaxed);
+	RecPtr->Backoff = MinBackoff;
+	RecPtr->OutageStart = 0U;
+	RecPtr->RetryAt = 0U;
+	RecPtr->UpSince = 0U;
+	RecPtr->FullAtBusOff = 0U;
+
+	RecPtr->Stats.BusOffs = 0U;
+	RecPtr->Stats.Passives = 0U;
+	RecPtr->Stats.Rejoins = 0U;
+	RecPtr->Stats.Recoveries = 0U;
+	RecPtr->Stats.Rejected = 0U;
+	RecPtr->Stats.MaxHeld = 0U;
+	RecPtr->Stats.LastRecovery = 0U;
+	RecPtr->Stats.MaxRecovery = 0U;
+	RecPtr->Stats.TotalRecovery = 0U;
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes the controller off the bus after a bus-off and sets the time to
+* rejoin. Call it from the event handler on XCAN_IXR_BSOFF_MASK.
+*
+* @param	RecPtr is a pointer to the recovery.
+* @param	Now is the current time.
+*
+* @return	None.
+*
+* @note		Configuration mode stops the automatic recovery of the
+*		controller, which would otherwise rejoin at once.
+*
+******************************************************************************/
+void CanRecovery_BusOff(CanRecovery *RecPtr, u64 Now)
+{
+	u32 State = RecPtr->State.load(std::memory_order_relaxed);
+
+	XCan_EnterMode(RecPtr->CanPtr, XCAN_MODE_CONFIG);
+
+	/* A bus-off while rejoining belongs to the same outage */
+	if (State != CAN_LINK_REJOINING && State != CAN_LINK_BUS_OFF) {
+		RecPtr->OutageStart = Now;
+		RecPtr->FullAtBusOff = RecPtr->SchedPtr->Stats.Full;
+	}
+
+	RecPtr->RetryAt = Now + RecPtr->Backoff;
+	RecPtr->Backoff = (RecPtr->Backoff > RecPtr->MaxBackoff / 2U) ?
+			  RecPtr->MaxBackoff : RecPtr->Backoff * 2U;
+	RecPtr->Stats.BusOffs++;
+	RecPtr->State.store(CAN_LINK_BUS_OFF, std::memory_order_release);
+}
+
+/*****************************************************************************/
+/**
+*
+* Notes an error passive controller. Call it from the error handler; the
+* status register is read only while the link is error active.
+*
+* @param	RecPtr is a pointer to the recovery.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanRecovery_Error(CanRecovery *RecPtr)
+{
+	if (RecPtr->State.load(std::memory_order_relaxed) !=
+	    CAN_LINK_ERROR_ACTIVE) {
+		return;
+	}
+
+	if (CanRecovery_Estat(RecPtr) == CAN_RECOVERY_ESTAT_PASSIVE) {
+		RecPtr->Stats.Passives++;
+		RecPtr->State.store(CAN_LINK_ERROR_PASSIVE,
+				    std::memory_order_release);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Handles a frame sent or received while the link is not error active;
+* the handlers check CanRecovery_GetState first. A frame through after
+* rejoining ends the outage; one through while error passive returns the
+* link to error active once the error counters have come down.
+*
+* @param	RecPtr is a pointer to the recovery.
+* @param	Now is the current time.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanRecovery_Recovered(CanRecovery *RecPtr, u64 Now)
+{
+	CanRecovery_Stats *StatsPtr = &RecPtr->Stats;
+	u64 Recovery;
+
+	switch (RecPtr->State.load(std::memory_order_relaxed)) {
+	case CAN_LINK_ERROR_PASSIVE:
+		if (CanRecovery_Estat(RecPtr) != CAN_RECOVERY_ESTAT_ACTIVE) {
+			return;
+		}
+		break;
+
+	case CAN_LINK_REJOINING:
+		Recovery = Now - RecPtr->OutageStart;
+		StatsPtr->Recoveries++;
+		StatsPtr->LastRecovery = Recovery;
+		StatsPtr->TotalRecovery += Recovery;
+		if (Recovery > StatsPtr->MaxRecovery) {
+			StatsPtr->MaxRecovery = Recovery;
+		}
+		StatsPtr->Rejected += RecPtr->SchedPtr->Stats.Full -
+				      RecPtr->FullAtBusOff;
+		RecPtr->UpSince = Now;
+		break;
+
+	default:
+		/* Frames left in the RX FIFO by a bus-off */
+		return;
+	}
+
+	RecPtr->State.store(CAN_LINK_ERROR_ACTIVE, std::memory_order_release);
+}
+
+/*****************************************************************************/
+/**
+*
+* Rejoins the bus once the back-off has elapsed, and resets the back-off
+* after the link has stayed up long enough. Call it from the idle loop.
+*
+* @param	RecPtr is a pointer to the recovery.
+* @param	Now is the current time.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanRecovery_Poll(CanRecovery *RecPtr, u64 Now)
+{
+	u32 State = RecPtr->State.load(std::memory_order_acquire);
+	u32 Held;
+
+	if (State == CAN_LINK_BUS_OFF && Now >= RecPtr->RetryAt) {
+		Xil_ExceptionDisable();
+		Held = CanTxSched_Pending(RecPtr->SchedPtr);
+		if (Held > RecPtr->Stats.MaxHeld) {
+			RecPtr->Stats.MaxHeld = Held;
+		}
+		RecPtr->Stats.Rejoins++;
+		RecPtr->State.store(CAN_LINK_REJOINING,
+				    std::memory_order_relaxed);
+		XCan_EnterMode(RecPtr->CanPtr, RecPtr->Mode);
+		Xil_ExceptionEnable();
+	} else if (State == CAN_LINK_ERROR_ACTIVE &&
+		   RecPtr->Backoff != RecPtr->MinBackoff &&
+		   Now - RecPtr->UpSince >= RecPtr->MaxBackoff) {
+		Xil_ExceptionDisable();
+		if (RecPtr->State.load(std::memory_order_relaxed) ==
+		    CAN_LINK_ERROR_ACTIVE) {
+			RecPtr->Backoff = RecPtr->MinBackoff;
+		}
+		Xil_ExceptionEnable();
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the recovery statistics. Times are in ticks of the clock the Now
+* arguments are read from.
+*
+* @param	RecPtr is a pointer to the recovery.
+* @param	StatsPtr is where the statistics are returned.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanRecovery_GetStats(CanRecovery *RecPtr, CanRecovery_Stats *StatsPtr)
+{
+	Xil_ExceptionDisable();
+	*StatsPtr = RecPtr->Stats;
+	Xil_ExceptionEnable();
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the fault confinement state from the status register.
+*
+******************************************************************************/
+static u32 CanRecovery_Estat(CanRecovery *RecPtr)
+{
+	return (XCan_GetStatus(RecPtr->CanPtr) & XCAN_SR_ESTAT_MASK) >>
+	       XCAN_SR_ESTAT_SHIFT;
+}
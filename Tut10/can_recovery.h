@@ -0,0 +1,105 @@
+/******************************************************************************
+* CAN bus-off and error-passive recovery
+*
+* Keeps a controller on the bus through bus faults. The AXI CAN rejoins
+* on its own after a bus-off, 128 occurrences of 11 recessive bits later,
+* and goes straight back off if the fault is still there, flooding the bus
+* with error frames. Here the controller is held in configuration mode
+* instead and rejoins after a back-off that doubles with every bus-off of
+* the same outage:
+*
+*	ISR:	EventHandler:	BSOFF -> CanRecovery_BusOff(&Rec, Now)
+*		ErrorHandler:	CanRecovery_Error(&Rec)
+*		Send and RecvHandler, while not CAN_LINK_ERROR_ACTIVE:
+*				CanRecovery_Recovered(&Rec, Now)
+*
+*	Task:	CanRecovery_Poll(&Rec, MonoClock_Now());
+*
+*	ERROR_ACTIVE <--> ERROR_PASSIVE    checked after each bus error,
+*	     |                 |           back once a frame goes through
+*	     v                 v
+*	  BUS_OFF <-------------------.    in configuration mode until
+*	     |  back-off elapsed      |    RetryAt, then XCan_EnterMode
+*	     v                        |
+*	 REJOINING -------------------'    bus-off again: back-off doubles,
+*	     |  a frame goes through       up to MaxBackoff
+*	     v
+*	ERROR_ACTIVE                       recovery time recorded; back-off
+*	                                   to MinBackoff after MaxBackoff up
+*
+* Configuration mode clears the error counters but keeps the TX FIFO and
+* TXHPB, and the frames in the transmit scheduler stay queued, so every
+* frame accepted by CanTxSched_Send before or during the outage goes out
+* after it. The sends refused meanwhile, a class being full, are counted
+* in Rejected: those frames are lost unless the sender retries them. The
+* frames other nodes sent while this one was off the bus are not seen and
+* cannot be counted.
+******************************************************************************/
+
+#ifndef CAN_RECOVERY_H		/* prevent circular inclusions */
+#define CAN_RECOVERY_H
+
+/***************************** Include Files *********************************/
+
+#include <atomic>
+
+#include "xil_types.h"
+#include "xcan.h"
+#include "can_txsched.h"
+
+/**************************** Type Definitions *******************************/
+
+typedef enum {
+	CAN_LINK_ERROR_ACTIVE,
+	CAN_LINK_ERROR_PASSIVE,		/**< TEC or REC above 127 */
+	CAN_LINK_BUS_OFF,		/**< Waiting out the back-off */
+	CAN_LINK_REJOINING		/**< Back on, no frame through yet */
+} CanLink_State;
+
+typedef struct {
+	u32 BusOffs;			/**< Bus-off events */
+	u32 Passives;			/**< Entries into error passive */
+	u32 Rejoins;			/**< Attempts to rejoin the bus */
+	u32 Recoveries;			/**< Outages ended */
+	u32 Rejected;			/**< Sends the TX scheduler refused */
+	u32 MaxHeld;			/**< Most frames kept by an outage */
+	u64 LastRecovery;		/**< Bus-off to first frame, ticks */
+	u64 MaxRecovery;
+	u64 TotalRecovery;
+} CanRecovery_Stats;
+
+typedef struct {
+	XCan *CanPtr;
+	CanTxSched *SchedPtr;
+	u8 Mode;			/**< XCAN_MODE_NORMAL or _LOOPBACK */
+	u64 MinBackoff;			/**< Ticks of the clock Now is read */
+	u64 MaxBackoff;
+	std::atomic<u32> State;		/**< CanLink_State */
+	u64 Backoff;			/**< Of the next bus-off */
+	u64 OutageStart;		/**< First bus-off of the outage */
+	u64 RetryAt;
+	u64 UpSince;			/**< End of the last outage */
+	u32 FullAtBusOff;		/**< Rejected sends at the start */
+	CanRecovery_Stats Stats;
+} CanRecovery;
+
+/************************** Function Prototypes ******************************/
+
+void CanRecovery_Init(CanRecovery *RecPtr, XCan *CanPtr,
+		      CanTxSched *SchedPtr, u8 Mode, u64 MinBackoff,
+		      u64 MaxBackoff);
+void CanRecovery_BusOff(CanRecovery *RecPtr, u64 Now);
+void CanRecovery_Error(CanRecovery *RecPtr);
+void CanRecovery_Recovered(CanRecovery *RecPtr, u64 Now);
+void CanRecovery_Poll(CanRecovery *RecPtr, u64 Now);
+void CanRecovery_GetStats(CanRecovery *RecPtr, CanRecovery_Stats *StatsPtr);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/* The current state, checked before reading the clock for the handlers */
+static inline CanLink_State CanRecovery_GetState(CanRecovery *RecPtr)
+{
+	return (CanLink_State)RecPtr->State.load(std::memory_order_acquire);
+}
+
+#endif	/* end of protection macro */
@@ -0,0 +1,132 @@
+/******************************************************************************
+* Replay of a CAN capture log through the transmit scheduler
+*
+* See can_replay.h. Everything here runs in task context, which is the
+* only context CanTxSched_Send may be called from.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xstatus.h"
+#include "can_replay.h"
+
+/*****************************************************************************/
+/**
+*
+* Starts replaying a log from its first record.
+*
+* @param	ReplayPtr is a pointer to the replay.
+* @param	LogPtr is the log image, checked with CanLog_IsValid.
+* @param	Mode is CAN_REPLAY_TIMED or CAN_REPLAY_FAST.
+* @param	ClockHz is the rate of the clock Now is read from.
+* @param	Now is the current time, the time of the first record.
+*
+* @return
+*		- XST_SUCCESS if the replay was started
+*		- XST_INVALID_PARAM if ClockHz is 0
+*
+******************************************************************************/
+int CanReplay_Start(CanReplay *ReplayPtr, const CanLog_Header *LogPtr,
+		    CanReplay_Mode Mode, u32 ClockHz, u64 Now)
+{
+	if (ClockHz == 0U) {
+		return XST_INVALID_PARAM;
+	}
+
+	ReplayPtr->Log = LogPtr;
+	ReplayPtr->Mode = Mode;
+	ReplayPtr->ClockHz = ClockHz;
+	ReplayPtr->Next = 0U;
+	ReplayPtr->Start = Now;
+	ReplayPtr->Stats.Frames = 0U;
+	ReplayPtr->Stats.Retries = 0U;
+	ReplayPtr->Stats.MaxLate = 0U;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the local time a record is due at in timed replay: its offset
+* from the first record, converted to the local clock, after Start.
+*
+* @param	ReplayPtr is a pointer to the replay.
+* @param	Index is the record, less than NumRecords.
+*
+* @return	The time in local clock ticks.
+*
+******************************************************************************/
+u64 CanReplay_DueTicks(CanReplay *ReplayPtr, u32 Index)
+{
+	const CanLog_Record *RecordPtr = CanLog_Records(ReplayPtr->Log);
+	u64 Delta = RecordPtr[Index].Ticks - RecordPtr[0].Ticks;
+	u64 LogHz = ReplayPtr->Log->ClockHz;
+
+	/* Whole seconds first, the remainder cannot overflow */
+	return ReplayPtr->Start + (Delta / LogHz) * ReplayPtr->ClockHz +
+	       (Delta % LogHz) * ReplayPtr->ClockHz / LogHz;
+}
+
+/*****************************************************************************/
+/**
+*
+* Queues the frames that are due, stopping at the first one that is not,
+* or when the class of the next one is full. Call it from the idle loop, often
+* enough for the timing wanted.
+*
+* @param	ReplayPtr is a pointer to the replay.
+* @param	SchedPtr is the transmit scheduler to send through.
+* @param	Now is the current time.
+*
+* @return	The number of frames queued.
+*
+******************************************************************************/
+u32 CanReplay_Poll(CanReplay *ReplayPtr, CanTxSched *SchedPtr, u64 Now)
+{
+	const CanLog_Record *RecordPtr = CanLog_Records(ReplayPtr->Log);
+	const u32 *FramePtr;
+	u32 Queued = 0U;
+	u64 Due;
+
+	while (ReplayPtr->Next < ReplayPtr->Log->NumRecords) {
+		if (ReplayPtr->Mode == CAN_REPLAY_TIMED) {
+			Due = CanReplay_DueTicks(ReplayPtr, ReplayPtr->Next);
+			if (Due > Now) {
+				break;
+			}
+		} else {
+			Due = Now;
+		}
+
+		FramePtr = RecordPtr[ReplayPtr->Next].Frame;
+		if (CanTxSched_Send(SchedPtr, FramePtr) != XST_SUCCESS) {
+			ReplayPtr->Stats.Retries++;
+			break;
+		}
+		if (Now - Due > ReplayPtr->Stats.MaxLate) {
+			ReplayPtr->Stats.MaxLate = Now - Due;
+		}
+		ReplayPtr->Next++;
+		ReplayPtr->Stats.Frames++;
+		Queued++;
+	}
+
+	return Queued;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the replay statistics.
+*
+* @param	ReplayPtr is a pointer to the replay.
+* @param	StatsPtr is where the statistics are returned.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanReplay_GetStats(CanReplay *ReplayPtr, CanReplay_Stats *StatsPtr)
+{
+	*StatsPtr = ReplayPtr->Stats;
+}
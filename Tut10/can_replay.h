@@ -0,0 +1,76 @@
+/******************************************************************************
+* Replay of a CAN capture log through the transmit scheduler
+*
+* Sends the frames of a log image (can_log.h) in memory, e.g. a field
+* capture loaded with XSDB "dow -data" or HOSTSIM_LOAD, at the times they
+* were recorded or as fast as the transmit scheduler takes them:
+*
+*	CanReplay_Start(&Replay, LogPtr, CAN_REPLAY_TIMED,
+*			MonoClock_ClockHz, MonoClock_Now());
+*	while (!CanReplay_IsDone(&Replay)) {
+*		CanReplay_Poll(&Replay, &TxSched, MonoClock_Now());
+*		...
+*	}
+*
+* With the controller in loopback mode every frame comes back through the
+* receive path, so recorded traffic, peak load included, reaches the
+* application as it did in the field. The frames are queued from the log
+* records themselves; nothing is copied until CanTxSched_Send. The
+* scheduler sends them by the priority of their IDs, as it would live
+* traffic.
+*
+* Timed replay keeps the spacing of the records, converted from the log
+* clock to the local one, from the time of the first record. A frame is
+* queued at the first poll at or after its time; MaxLate is how late that
+* was at worst. Fast replay queues every frame as soon as the queue has
+* room, so the bus sets the pace.
+******************************************************************************/
+
+#ifndef CAN_REPLAY_H		/* prevent circular inclusions */
+#define CAN_REPLAY_H
+
+/***************************** Include Files *********************************/
+
+#include "xil_types.h"
+#include "can_log.h"
+#include "can_txsched.h"
+
+/**************************** Type Definitions *******************************/
+
+typedef enum {
+	CAN_REPLAY_TIMED,		/**< At the recorded times */
+	CAN_REPLAY_FAST			/**< As the queue takes them */
+} CanReplay_Mode;
+
+typedef struct {
+	u32 Frames;			/**< Frames queued */
+	u32 Retries;			/**< Polls finding the queue full */
+	u64 MaxLate;			/**< Worst delay past due, ticks */
+} CanReplay_Stats;
+
+typedef struct {
+	const CanLog_Header *Log;
+	CanReplay_Mode Mode;
+	u32 ClockHz;			/**< Rate of the local clock */
+	u32 Next;			/**< Next record to queue */
+	u64 Start;			/**< Local time of the first record */
+	CanReplay_Stats Stats;
+} CanReplay;
+
+/************************** Function Prototypes ******************************/
+
+int CanReplay_Start(CanReplay *ReplayPtr, const CanLog_Header *LogPtr,
+		    CanReplay_Mode Mode, u32 ClockHz, u64 Now);
+u64 CanReplay_DueTicks(CanReplay *ReplayPtr, u32 Index);
+u32 CanReplay_Poll(CanReplay *ReplayPtr, CanTxSched *SchedPtr, u64 Now);
+void CanReplay_GetStats(CanReplay *ReplayPtr, CanReplay_Stats *StatsPtr);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/* TRUE once every frame of the log has been queued */
+static inline int CanReplay_IsDone(CanReplay *ReplayPtr)
+{
+	return ReplayPtr->Next == ReplayPtr->Log->NumRecords;
+}
+
+#endif	/* end of protection macro */
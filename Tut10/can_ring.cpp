@@ -0,0 +1,70 @@
+/******************************************************************************
+* Lock-free single-producer/single-consumer ring of CAN frames
+*
+* The fast paths are inline in can_ring.h. This file holds the set-up and
+* statistics functions, which are only called from task context.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "can_ring.h"
+
+/*****************************************************************************/
+/**
+*
+* Empties the ring and clears its statistics. Must be called before the
+* receive interrupt is enabled.
+*
+* @param	RingPtr is a pointer to the ring.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanRing_Init(CanRing *RingPtr)
+{
+	RingPtr->Head.store(0U, std::memory_order_relaxed);
+	RingPtr->Tail.store(0U, std::memory_order_relaxed);
+	RingPtr->Overflows = 0U;
+	RingPtr->HighWatermark = 0U;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the ring statistics. The counters are written by the ISR; each one
+* is a single aligned word, so it is read consistently without masking
+* interrupts.
+*
+* @param	RingPtr is a pointer to the ring.
+* @param	StatsPtr is where the statistics are returned.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanRing_GetStats(CanRing *RingPtr, CanRing_Stats *StatsPtr)
+{
+	StatsPtr->Count = RingPtr->Head.load(std::memory_order_acquire) -
+			  RingPtr->Tail.load(std::memory_order_relaxed);
+	StatsPtr->Overflows = RingPtr->Overflows;
+	StatsPtr->HighWatermark = RingPtr->HighWatermark;
+}
+
+/*****************************************************************************/
+/**
+*
+* Restarts the overflow count and the high watermark, e.g. at the start of
+* a measurement window. The high watermark restarts from the current
+* occupancy.
+*
+* @param	RingPtr is a pointer to the ring.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanRing_ClearStats(CanRing *RingPtr)
+{
+	RingPtr->Overflows = 0U;
+	RingPtr->HighWatermark =
+		RingPtr->Head.load(std::memory_order_acquire) -
+		RingPtr->Tail.load(std::memory_order_relaxed);
+}
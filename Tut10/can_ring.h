@@ -0,0 +1,156 @@
+/******************************************************************************
+* Lock-free single-producer/single-consumer ring of CAN frames
+*
+* The receive interrupt handler is the only producer and the task context
+* (main loop) is the only consumer. Frames are stored in the XCan_Recv
+* register layout, four words each, so the ISR reads the hardware FIFO
+* straight into a ring slot and no copy is made on either side:
+*
+*	ISR:	FramePtr = CanRing_Reserve(&Ring);
+*		if (FramePtr == NULL) -> ring full, frame is dropped
+*		XCan_Recv(CanPtr, FramePtr);
+*		CanRing_Commit(&Ring);
+*
+*	Task:	while ((FramePtr = CanRing_Peek(&Ring)) != NULL) {
+*			... validate and dispatch FramePtr ...
+*			CanRing_Release(&Ring);
+*		}
+*
+* Head is only written by the producer and Tail only by the consumer.
+* Both are free-running counters; the occupancy is Head - Tail, which stays
+* correct across wrap-around because the ring size is a power of two.
+*
+* Overflows counts frames the ISR had to discard because the ring was full
+* and HighWatermark records the highest occupancy seen, so the ring can be
+* sized for the bus load of a given application.
+******************************************************************************/
+
+#ifndef CAN_RING_H		/* prevent circular inclusions */
+#define CAN_RING_H
+
+/***************************** Include Files *********************************/
+
+#include <atomic>
+
+#include "xil_types.h"
+#include "xcan.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Frames held by the ring, must be a power of two */
+#define CAN_RING_SIZE			64U
+
+/* Words per frame, as read by XCan_Recv */
+#define CAN_RING_FRAME_WORDS		(XCAN_MAX_FRAME_SIZE / sizeof(u32))
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 Frame[CAN_RING_SIZE][CAN_RING_FRAME_WORDS];
+	std::atomic<u32> Head;		/**< Next slot to fill (producer) */
+	std::atomic<u32> Tail;		/**< Next slot to drain (consumer) */
+	u32 Overflows;			/**< Frames dropped, ring full */
+	u32 HighWatermark;		/**< Highest occupancy seen */
+} CanRing;
+
+typedef struct {
+	u32 Count;			/**< Frames waiting in the ring */
+	u32 Overflows;			/**< Frames dropped, ring full */
+	u32 HighWatermark;		/**< Highest occupancy seen */
+} CanRing_Stats;
+
+/************************** Function Prototypes ******************************/
+
+void CanRing_Init(CanRing *RingPtr);
+void CanRing_GetStats(CanRing *RingPtr, CanRing_Stats *StatsPtr);
+void CanRing_ClearStats(CanRing *RingPtr);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/*****************************************************************************/
+/**
+*
+* Producer side: returns the next free slot, or NULL when the ring is full.
+* A full ring is counted as an overflow, the caller is expected to discard
+* the frame.
+*
+* @param	RingPtr is a pointer to the ring.
+*
+* @return	Pointer to CAN_RING_FRAME_WORDS words, or NULL.
+*
+******************************************************************************/
+static inline u32 *CanRing_Reserve(CanRing *RingPtr)
+{
+	u32 Head = RingPtr->Head.load(std::memory_order_relaxed);
+	u32 Tail = RingPtr->Tail.load(std::memory_order_acquire);
+
+	if ((Head - Tail) == CAN_RING_SIZE) {
+		RingPtr->Overflows++;
+		return NULL;
+	}
+
+	return RingPtr->Frame[Head & (CAN_RING_SIZE - 1U)];
+}
+
+/*****************************************************************************/
+/**
+*
+* Producer side: publishes the slot returned by CanRing_Reserve to the
+* consumer.
+*
+* @param	RingPtr is a pointer to the ring.
+*
+* @return	None.
+*
+******************************************************************************/
+static inline void CanRing_Commit(CanRing *RingPtr)
+{
+	u32 Head = RingPtr->Head.load(std::memory_order_relaxed) + 1U;
+	u32 Used = Head - RingPtr->Tail.load(std::memory_order_relaxed);
+
+	if (Used > RingPtr->HighWatermark) {
+		RingPtr->HighWatermark = Used;
+	}
+	RingPtr->Head.store(Head, std::memory_order_release);
+}
+
+/*****************************************************************************/
+/**
+*
+* Consumer side: returns the oldest frame in the ring without removing it,
+* or NULL when the ring is empty.
+*
+* @param	RingPtr is a pointer to the ring.
+*
+* @return	Pointer to CAN_RING_FRAME_WORDS words, or NULL.
+*
+******************************************************************************/
+static inline u32 *CanRing_Peek(CanRing *RingPtr)
+{
+	u32 Tail = RingPtr->Tail.load(std::memory_order_relaxed);
+
+	if (Tail == RingPtr->Head.load(std::memory_order_acquire)) {
+		return NULL;
+	}
+
+	return RingPtr->Frame[Tail & (CAN_RING_SIZE - 1U)];
+}
+
+/*****************************************************************************/
+/**
+*
+* Consumer side: hands the frame returned by CanRing_Peek back to the
+* producer.
+*
+* @param	RingPtr is a pointer to the ring.
+*
+* @return	None.
+*
+******************************************************************************/
+static inline void CanRing_Release(CanRing *RingPtr)
+{
+	RingPtr->Tail.store(RingPtr->Tail.load(std::memory_order_relaxed) + 1U,
+			    std::memory_order_release);
+}
+
+#endif	/* end of protection macro */
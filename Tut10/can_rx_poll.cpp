@@ -0,0 +1,217 @@
+/******************************************************************************
+* Adaptive CAN receive: per-frame interrupts or timer-driven polling
+*
+* See can_rx_poll.h for the design. The rate window is measured with
+* Timestamp_Now, so Timestamp_Initialize or MonoClock_Initialize must have
+* been called before the first frame.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xstatus.h"
+#include "xil_exception.h"
+#include "timestamp.h"
+#include "can_rx_poll.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Clocks the counter takes to reload in generate mode, see timer_wheel.cpp */
+#define CAN_RX_POLL_RELOAD_CLOCKS	2U
+
+/************************** Function Prototypes ******************************/
+
+static void CanRxPoll_StartPolling(CanRxPoll *PollPtr);
+static void CanRxPoll_StopPolling(CanRxPoll *PollPtr);
+
+/*****************************************************************************/
+/**
+*
+* Initializes the adaptive receive in interrupt mode and sets up the timer
+* counter for the polling period. The counter is started only on the
+* switch to polling.
+*
+* @param	PollPtr is a pointer to the adaptive receive.
+* @param	CanPtr is a pointer to the XCan instance.
+* @param	TimerPtr is a pointer to an initialized XTmrCtr instance. Its
+*		handler is the application's, draining the RX FIFO and calling
+*		CanRxPoll_Polled.
+* @param	TimerNumber is the counter of TimerPtr to poll with. It must
+*		not be the one of the timestamp counter.
+* @param	ConfigPtr is the switch rate, polling period and budget.
+*
+* @return	XST_SUCCESS, or XST_INVALID_PARAM for a zero budget or a
+*		period the counter cannot make.
+*
+******************************************************************************/
+int CanRxPoll_Init(CanRxPoll *PollPtr, XCan *CanPtr, XTmrCtr *TimerPtr,
+		   u8 TimerNumber, const CanRxPoll_Config *ConfigPtr)
+{
+	u64 PeriodClocks;
+
+	PeriodClocks = ((u64)TimerPtr->Config.SysClockFreqHz *
+			ConfigPtr->PollPeriodUs) / 1000000U;
+	if ((ConfigPtr->Budget == 0U) ||
+	    (PeriodClocks <= CAN_RX_POLL_RELOAD_CLOCKS) ||
+	    (PeriodClocks > 0xFFFFFFFFULL)) {
+		return XST_INVALID_PARAM;
+	}
+
+	PollPtr->CanPtr = CanPtr;
+	PollPtr->TimerPtr = TimerPtr;
+	PollPtr->TimerNumber = TimerNumber;
+	PollPtr->Config = *ConfigPtr;
+	PollPtr->Mode = CAN_RX_IRQ;
+	PollPtr->WindowTicks = (u32)(((u64)Timestamp_ClockHz *
+				      CAN_RX_POLL_WINDOW_US) / 1000000U);
+	PollPtr->WindowLimit = (u32)(((u64)ConfigPtr->PollRate *
+				      CAN_RX_POLL_WINDOW_US) / 1000000U);
+	PollPtr->WindowStart = Timestamp_Now();
+	PollPtr->WindowFrames = 0U;
+
+	PollPtr->Stats.IrqFrames = 0U;
+	PollPtr->Stats.PolledFrames = 0U;
+	PollPtr->Stats.Polls = 0U;
+	PollPtr->Stats.FullPolls = 0U;
+	PollPtr->Stats.Switches = 0U;
+
+	XTmrCtr_SetOptions(TimerPtr, TimerNumber, XTC_INT_MODE_OPTION |
+			   XTC_AUTO_RELOAD_OPTION | XTC_DOWN_COUNT_OPTION);
+	XTmrCtr_SetResetValue(TimerPtr, TimerNumber,
+			      (u32)PeriodClocks - CAN_RX_POLL_RELOAD_CLOCKS);
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Counts the frames the receive interrupt read and switches to polling
+* once they exceed the switch rate over the window. Call it from the
+* receive handler after draining the RX FIFO.
+*
+* @param	PollPtr is a pointer to the adaptive receive.
+* @param	Frames is the number of frames read.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanRxPoll_Received(CanRxPoll *PollPtr, u32 Frames)
+{
+	u32 Now = Timestamp_Now();
+
+	PollPtr->Stats.IrqFrames += Frames;
+	if (PollPtr->Config.PollRate == 0U) {
+		return;
+	}
+
+	if (Now - PollPtr->WindowStart >= PollPtr->WindowTicks) {
+		PollPtr->WindowStart = Now;
+		PollPtr->WindowFrames = 0U;
+	}
+	PollPtr->WindowFrames += Frames;
+
+	if (PollPtr->WindowFrames > PollPtr->WindowLimit) {
+		CanRxPoll_StartPolling(PollPtr);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Counts the frames a timer tick read and returns to interrupts once the
+* rate over the window has dropped to half the switch rate. Call it from
+* the timer handler after draining up to Config.Budget frames.
+*
+* @param	PollPtr is a pointer to the adaptive receive.
+* @param	Frames is the number of frames read.
+*
+* @return	None.
+*
+* @note		A tick pending from before the return to interrupts finds
+*		the mode changed and is ignored.
+*
+******************************************************************************/
+void CanRxPoll_Polled(CanRxPoll *PollPtr, u32 Frames)
+{
+	u32 Now;
+
+	if (PollPtr->Mode != CAN_RX_POLL) {
+		return;
+	}
+
+	PollPtr->Stats.Polls++;
+	PollPtr->Stats.PolledFrames += Frames;
+	PollPtr->WindowFrames += Frames;
+	if (Frames >= PollPtr->Config.Budget) {
+		PollPtr->Stats.FullPolls++;
+		return;
+	}
+
+	Now = Timestamp_Now();
+	if (Now - PollPtr->WindowStart < PollPtr->WindowTicks) {
+		return;
+	}
+	if (PollPtr->WindowFrames <= PollPtr->WindowLimit / 2U) {
+		CanRxPoll_StopPolling(PollPtr);
+	} else {
+		PollPtr->WindowStart = Now;
+		PollPtr->WindowFrames = 0U;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the adaptive receive statistics.
+*
+* @param	PollPtr is a pointer to the adaptive receive.
+* @param	StatsPtr is where the statistics are returned.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanRxPoll_GetStats(CanRxPoll *PollPtr, CanRxPoll_Stats *StatsPtr)
+{
+	Xil_ExceptionDisable();
+	*StatsPtr = PollPtr->Stats;
+	Xil_ExceptionEnable();
+}
+
+/*****************************************************************************/
+/**
+*
+* Masks the receive interrupts and starts the polling timer.
+*
+******************************************************************************/
+static void CanRxPoll_StartPolling(CanRxPoll *PollPtr)
+{
+	XCan_InterruptDisable(PollPtr->CanPtr, CAN_RX_POLL_IXR_MASK);
+	PollPtr->Mode = CAN_RX_POLL;
+	PollPtr->WindowStart = Timestamp_Now();
+	PollPtr->WindowFrames = 0U;
+	PollPtr->Stats.Switches++;
+	XTmrCtr_Start(PollPtr->TimerPtr, PollPtr->TimerNumber);
+}
+
+/*****************************************************************************/
+/**
+*
+* Stops the polling timer and unmasks the receive interrupts. The status
+* bits latched while polling are cleared first and the FIFO checked after:
+* a frame arriving before the check keeps the timer polling, one arriving
+* after it sets RXNEMP again and interrupts as soon as it is unmasked.
+*
+******************************************************************************/
+static void CanRxPoll_StopPolling(CanRxPoll *PollPtr)
+{
+	XCan_InterruptClear(PollPtr->CanPtr, CAN_RX_POLL_IXR_MASK);
+	if (XCan_IsRxEmpty(PollPtr->CanPtr) == FALSE) {
+		return;
+	}
+
+	XTmrCtr_Stop(PollPtr->TimerPtr, PollPtr->TimerNumber);
+	PollPtr->Mode = CAN_RX_IRQ;
+	PollPtr->WindowStart = Timestamp_Now();
+	PollPtr->WindowFrames = 0U;
+	XCan_InterruptEnable(PollPtr->CanPtr, CAN_RX_POLL_IXR_MASK);
+}
@@ -0,0 +1,88 @@
+/******************************************************************************
+* Adaptive CAN receive: per-frame interrupts or timer-driven polling
+*
+* At a low frame rate every received frame raises its own interrupt, for
+* the lowest latency. Past a configured rate that costs more in interrupt
+* entry, status reads and acknowledges than in reading the frames, so the
+* receive interrupts are masked and an AXI Timer interrupt polls the RX
+* FIFO instead, a bounded number of frames per tick, as NAPI does:
+*
+*	RecvHandler:	Frames = drain the RX FIFO;
+*			CanRxPoll_Received(&RxPoll, Frames);
+*
+*	Timer handler:	Frames = drain up to RxPoll.Config.Budget frames;
+*			CanRxPoll_Polled(&RxPoll, Frames);
+*
+* The rate is measured over CAN_RX_POLL_WINDOW_US windows in both modes.
+* Polling starts once more than PollRate frames per second arrive in a
+* window, and ends after a window of no more than half that, on a tick
+* that drained the FIFO; the hysteresis keeps a rate near PollRate from
+* flipping the mode. Latency while polling is up to one PollPeriodUs, so
+* the period and budget must also keep the RX FIFO from overflowing at the
+* highest rate of the bus.
+*
+* Both functions run in interrupt context, the CAN and timer interrupts
+* never nesting, and are the only writers of the state. Transmit
+* completions and error events keep their interrupts.
+******************************************************************************/
+
+#ifndef CAN_RX_POLL_H		/* prevent circular inclusions */
+#define CAN_RX_POLL_H
+
+/***************************** Include Files *********************************/
+
+#include "xil_types.h"
+#include "xcan.h"
+#include "xtmrctr.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Window the receive rate is measured over */
+#define CAN_RX_POLL_WINDOW_US		10000U
+
+/* The interrupts a frame received raises, masked while polling */
+#define CAN_RX_POLL_IXR_MASK	(XCAN_IXR_RXOK_MASK | XCAN_IXR_RXNEMP_MASK)
+
+/**************************** Type Definitions *******************************/
+
+typedef enum {
+	CAN_RX_IRQ,			/**< An interrupt per frame */
+	CAN_RX_POLL			/**< Polled from the timer */
+} CanRxPoll_Mode;
+
+typedef struct {
+	u32 PollRate;			/**< Frames/s to switch at, 0 never */
+	u32 PollPeriodUs;		/**< Timer period while polling */
+	u32 Budget;			/**< Frames read per tick at most */
+} CanRxPoll_Config;
+
+typedef struct {
+	u32 IrqFrames;			/**< Received by interrupt */
+	u32 PolledFrames;		/**< Received by the timer */
+	u32 Polls;			/**< Timer ticks */
+	u32 FullPolls;			/**< Ticks that used the budget */
+	u32 Switches;			/**< Changes to polling */
+} CanRxPoll_Stats;
+
+typedef struct {
+	XCan *CanPtr;
+	XTmrCtr *TimerPtr;
+	u8 TimerNumber;
+	CanRxPoll_Config Config;
+	volatile u32 Mode;		/**< CanRxPoll_Mode */
+	u32 WindowTicks;		/**< Timestamp ticks of the window */
+	u32 WindowLimit;		/**< Frames of PollRate per window */
+	u32 WindowStart;
+	u32 WindowFrames;
+	CanRxPoll_Stats Stats;
+} CanRxPoll;
+
+/************************** Function Prototypes ******************************/
+
+int CanRxPoll_Init(CanRxPoll *PollPtr, XCan *CanPtr, XTmrCtr *TimerPtr,
+		   u8 TimerNumber, const CanRxPoll_Config *ConfigPtr);
+void CanRxPoll_Received(CanRxPoll *PollPtr, u32 Frames);
+void CanRxPoll_Polled(CanRxPoll *PollPtr, u32 Frames);
+void CanRxPoll_GetStats(CanRxPoll *PollPtr, CanRxPoll_Stats *StatsPtr);
+
+#endif	/* end of protection macro */
@@ -0,0 +1,346 @@
+/******************************************************************************
+* Typed CAN frames and compile-time signal codec
+*
+* A view over a frame in the XCan_Send/XCan_Recv layout (ID register, DLC
+* register, two data words) and signals described the way a DBC file does,
+* packed and unpacked in place in the frame words, with no byte loops and
+* no copy:
+*
+*	using Speed = CanSignal<CanSignalDesc{ 8, 16, CAN_SIGNAL_INTEL,
+*					       FALSE, 0.01, 0.0 }>;
+*	using Gear = CanSignal<CanSignalDesc{ 39, 4, CAN_SIGNAL_MOTOROLA }>;
+*
+*	CanFrameView Frame(RxFrame);
+*	if (Frame.Is<EngineMsg>()) {
+*		double Kmh = Frame.Get<Speed>();
+*		...
+*	CanFrameView(TxFrame).Set<Speed>(87.5);
+*
+* Start bits are numbered as in DBC files, byte * 8 + bit with bit 0 the
+* least significant of the byte. An Intel (little endian) signal starts at
+* its least significant bit and runs up; a Motorola (big endian) signal
+* starts at its most significant bit and runs down into the next byte.
+* Physical value = raw * Scale + Offset, with the raw value sign extended
+* for a signed signal.
+*
+* The data words hold the bytes in bus order in memory, as XCan_Recv
+* leaves them (it converts from the big-endian data registers), so on the
+* little-endian Zynq and host the two words read as one 64-bit value are
+* an Intel payload and its byte reverse a Motorola one. Each signal is
+* placed at compile time: one within a single data word is a 32-bit load,
+* shift and mask, plus one byte reverse if it is Motorola and crosses a
+* byte; only signals across the word boundary take 64-bit arithmetic. A
+* description that does not fit in 8 bytes fails the build.
+*
+* CanSignal<>::DecodeBatch decodes one signal from many frames into an
+* array, a loop simple enough for the compiler to vectorize on the host,
+* e.g. for a capture log. GCC does so at -O3, and for Motorola signals
+* only with SSSE3 for the byte reverse; HostSim/bench/signal_codec times it
+* against byte loops.
+******************************************************************************/
+
+#ifndef CAN_SIGNAL_H		/* prevent circular inclusions */
+#define CAN_SIGNAL_H
+
+/***************************** Include Files *********************************/
+
+#include <math.h>
+
+#include "xil_types.h"
+#include "xcan.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Words of a frame, as XCan_Recv stores it */
+#define CAN_FRAME_WORDS		(XCAN_MAX_FRAME_SIZE / sizeof(u32))
+
+/* Index of the first data word */
+#define CAN_FRAME_DATA_WORD	2U
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+	      "the signal layout assumes a little-endian CPU");
+
+/**************************** Type Definitions *******************************/
+
+typedef enum {
+	CAN_SIGNAL_INTEL,		/**< Little endian, DBC @1 */
+	CAN_SIGNAL_MOTOROLA		/**< Big endian, DBC @0 */
+} CanSignalOrder;
+
+/* One signal of a message, as in a DBC SG_ line */
+struct CanSignalDesc {
+	u32 StartBit;
+	u32 Length;			/**< 1 to 64 bits */
+	CanSignalOrder Order;
+	u32 Signed = FALSE;
+	double Scale = 1.0;
+	double Offset = 0.0;
+};
+
+/*
+ * An ID and length, as the register words of a data frame: SRR is set for
+ * an extended ID, as the bus requires, and RTR is clear
+ */
+template <u32 Id, u32 Extended, u32 Dlc>
+struct CanMessage {
+	static_assert(Dlc <= 8U, "a classic CAN frame has up to 8 bytes");
+	static_assert(Id <= (Extended ? 0x1FFFFFFFU : 0x7FFU),
+		      "ID out of range");
+
+	static constexpr u32 IdValue = Extended ?
+		XCan_CreateIdValue(Id >> 18, 1U, 1U, Id, 0U) :
+		XCan_CreateIdValue(Id, 0U, 0U, 0U, 0U);
+	static constexpr u32 DlcValue = XCan_CreateDlcValue(Dlc);
+};
+
+/*
+ * A signal: where its raw value sits in the data words, worked out at
+ * compile time from the description
+ */
+template <CanSignalDesc Desc>
+struct CanSignal {
+	static_assert((Desc.Length >= 1U) && (Desc.Length <= 64U),
+		      "signal length must be 1 to 64 bits");
+	static_assert(Desc.StartBit < 64U, "start bit beyond the 8th byte");
+	static_assert(Desc.Scale != 0.0, "signal scale cannot be 0");
+
+	/*
+	 * Least significant bit in the Intel view (bytes in order, byte 0
+	 * lowest) or, for Motorola, in the byte reversed view
+	 */
+	static constexpr u32 MotorolaMsb = (7U - Desc.StartBit / 8U) * 8U +
+					   Desc.StartBit % 8U;
+	static_assert((Desc.Order == CAN_SIGNAL_INTEL) ?
+		      (Desc.StartBit + Desc.Length <= 64U) :
+		      (MotorolaMsb + 1U >= Desc.Length),
+		      "signal runs past the end of the frame");
+	static constexpr u32 Lsb = (Desc.Order == CAN_SIGNAL_INTEL) ?
+		Desc.StartBit : MotorolaMsb + 1U - Desc.Length;
+
+	/* A Motorola signal within one byte needs no byte reverse */
+	static constexpr u32 Msb = Lsb + Desc.Length - 1U;
+	static constexpr u32 Swap = (Desc.Order == CAN_SIGNAL_MOTOROLA) &&
+				    ((Lsb / 8U) != (Msb / 8U));
+	static constexpr u32 Pos = Swap ? Lsb :
+		(Desc.Order == CAN_SIGNAL_INTEL) ? Lsb :
+		(7U - Lsb / 8U) * 8U + Lsb % 8U;
+
+	/* Word of the (possibly reversed) view, or both */
+	static constexpr u32 Wide =
+		(Pos / 32U) != ((Pos + Desc.Length - 1U) / 32U);
+	static constexpr u32 Word = Swap ? 1U - Pos / 32U : Pos / 32U;
+	static constexpr u32 Shift = Pos % 32U;
+	static constexpr u64 Mask = (Desc.Length == 64U) ? ~0ULL :
+				    ((1ULL << Desc.Length) - 1ULL);
+
+	/* Raw value range, for encoding */
+	static constexpr s64 RawMin = Desc.Signed ?
+		-(s64)(Mask >> 1) - 1 : 0;
+	static constexpr u64 RawMax = Desc.Signed ? Mask >> 1 : Mask;
+
+	/* The raw value, zero extended */
+	static inline u64 GetRaw(const u32 *FramePtr)
+	{
+		const u32 *DataPtr = FramePtr + CAN_FRAME_DATA_WORD;
+
+		if constexpr (Wide) {
+			u64 Payload = ((u64)DataPtr[1] << 32) | DataPtr[0];
+
+			if constexpr (Swap) {
+				Payload = __builtin_bswap64(Payload);
+			}
+			return (Payload >> Shift) & Mask;
+		} else {
+			u32 Value = DataPtr[Word];
+
+			if constexpr (Swap) {
+				Value = __builtin_bswap32(Value);
+			}
+			return (Value >> Shift) & (u32)Mask;
+		}
+	}
+
+	/* The raw value, sign extended if the signal is signed */
+	static inline s64 GetRawSigned(const u32 *FramePtr)
+	{
+		u64 Raw = GetRaw(FramePtr);
+
+		if constexpr (Desc.Signed && (Desc.Length <= 32U)) {
+			return (s32)((u32)Raw << (32U - Desc.Length)) >>
+			       (32U - Desc.Length);
+		} else if constexpr (Desc.Signed && (Desc.Length < 64U)) {
+			return (s64)(Raw << (64U - Desc.Length)) >>
+			       (64U - Desc.Length);
+		}
+		return (s64)Raw;
+	}
+
+	/* Stores a raw value, leaving the other bits of the frame alone */
+	static inline void SetRaw(u32 *FramePtr, u64 Raw)
+	{
+		u32 *DataPtr = FramePtr + CAN_FRAME_DATA_WORD;
+
+		if constexpr (Wide) {
+			u64 Payload = ((u64)DataPtr[1] << 32) | DataPtr[0];
+
+			if constexpr (Swap) {
+				Payload = __builtin_bswap64(Payload);
+			}
+			Payload = (Payload & ~(Mask << Shift)) |
+				  ((Raw & Mask) << Shift);
+			if constexpr (Swap) {
+				Payload = __builtin_bswap64(Payload);
+			}
+			DataPtr[0] = (u32)Payload;
+			DataPtr[1] = (u32)(Payload >> 32);
+		} else {
+			u32 Value = DataPtr[Word];
+
+			if constexpr (Swap) {
+				Value = __builtin_bswap32(Value);
+			}
+			Value = (Value & ~((u32)Mask << Shift)) |
+				(((u32)Raw & (u32)Mask) << Shift);
+			if constexpr (Swap) {
+				Value = __builtin_bswap32(Value);
+			}
+			DataPtr[Word] = Value;
+		}
+	}
+
+	/* Physical value */
+	static inline double Decode(const u32 *FramePtr)
+	{
+		if constexpr (Desc.Signed) {
+			return (double)GetRawSigned(FramePtr) * Desc.Scale +
+			       Desc.Offset;
+		} else {
+			return (double)GetRaw(FramePtr) * Desc.Scale +
+			       Desc.Offset;
+		}
+	}
+
+	/* Stores a physical value, rounded and clamped to the raw range */
+	static inline void Encode(u32 *FramePtr, double Value)
+	{
+		double Raw = nearbyint((Value - Desc.Offset) / Desc.Scale);
+
+		if (Raw <= (double)RawMin) {
+			SetRaw(FramePtr, (u64)RawMin);
+		} else if (Raw >= (double)RawMax) {
+			SetRaw(FramePtr, RawMax);
+		} else if (Raw < 0.0) {
+			SetRaw(FramePtr, (u64)(s64)Raw);
+		} else {
+			SetRaw(FramePtr, (u64)Raw);
+		}
+	}
+
+	/*
+	 * Decodes the signal of Count frames, stored back to back, into
+	 * Values. No branch depends on the data, so the loop vectorizes.
+	 */
+	static void DecodeBatch(const u32 (*Frames)[CAN_FRAME_WORDS], u32 Count,
+				float *Values)
+	{
+		for (u32 Index = 0; Index < Count; Index++) {
+			float Raw;
+
+			/* Through s32 where it fits, which SIMD converts */
+			if constexpr (Desc.Signed && (Desc.Length <= 32U)) {
+				Raw = (float)(s32)GetRawSigned(Frames[Index]);
+			} else if constexpr (Desc.Signed) {
+				Raw = (float)GetRawSigned(Frames[Index]);
+			} else if constexpr (Desc.Length <= 31U) {
+				Raw = (float)(s32)GetRaw(Frames[Index]);
+			} else {
+				Raw = (float)GetRaw(Frames[Index]);
+			}
+			Values[Index] = Raw * (float)Desc.Scale +
+					(float)Desc.Offset;
+		}
+	}
+};
+
+/*
+ * Zero-copy view of a frame in the XCan layout. Costs a pointer; all
+ * accessors are inline.
+ */
+class CanFrameView {
+public:
+	explicit CanFrameView(u32 *FramePtr) : Words(FramePtr) {}
+
+	u32 IsExtended() const
+	{
+		return (Words[0] & XCAN_IDR_IDE_MASK) != 0U;
+	}
+
+	u32 IsRemote() const
+	{
+		return IsExtended() ? (Words[0] & XCAN_IDR_RTR_MASK) != 0U :
+				      (Words[0] & XCAN_IDR_SRR_MASK) != 0U;
+	}
+
+	/* 11 or 29-bit identifier */
+	u32 Id() const
+	{
+		u32 Id1 = (Words[0] & XCAN_IDR_ID1_MASK) >> XCAN_IDR_ID1_SHIFT;
+
+		if (!IsExtended()) {
+			return Id1;
+		}
+		return (Id1 << 18) |
+		       ((Words[0] & XCAN_IDR_ID2_MASK) >> XCAN_IDR_ID2_SHIFT);
+	}
+
+	u32 Dlc() const
+	{
+		return (Words[1] & XCAN_DLCR_DLC_MASK) >> XCAN_DLCR_DLC_SHIFT;
+	}
+
+	/* The frame is a data frame of message Msg, ID and length */
+	template <typename Msg>
+	u32 Is() const
+	{
+		return (Words[0] == Msg::IdValue) &&
+		       (Words[1] == Msg::DlcValue);
+	}
+
+	/* Sets up a data frame of message Msg, data cleared */
+	template <typename Msg>
+	void Init()
+	{
+		Words[0] = Msg::IdValue;
+		Words[1] = Msg::DlcValue;
+		Words[2] = 0U;
+		Words[3] = 0U;
+	}
+
+	template <typename Sig>
+	double Get() const
+	{
+		return Sig::Decode(Words);
+	}
+
+	template <typename Sig>
+	u64 GetRaw() const
+	{
+		return Sig::GetRaw(Words);
+	}
+
+	template <typename Sig>
+	void Set(double Value)
+	{
+		Sig::Encode(Words, Value);
+	}
+
+	template <typename Sig>
+	void SetRaw(u64 Raw)
+	{
+		Sig::SetRaw(Words, Raw);
+	}
+
+	u32 *Words;
+};
+
+#endif	/* end of protection macro */
@@ -0,0 +1,198 @@
+/******************************************************************************
+* CAN bus health and throughput statistics
+*
+* The counting fast path is inline in can_stats.h. This file holds the
+* snapshot and printing, which are called from task context.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <string.h>
+
+#include "xil_printf.h"
+#include "can_stats.h"
+
+/************************** Function Prototypes ******************************/
+
+static u64 CanStats_Scale(u64 Count, u64 Ticks, u32 ClockHz);
+
+/*****************************************************************************/
+/**
+*
+* Clears the statistics.
+*
+* @param	StatsPtr is a pointer to the statistics.
+* @param	BitRate is the nominal bit rate of the bus, for the load.
+* @param	ClockHz is the rate of the clock snapshot times are read from.
+* @param	Mode is the XCAN_MODE_* the controller runs in, to tell
+*		whether the frames sent come back as received.
+* @param	Now is the current time, where the first period starts.
+*
+* @return	None.
+*
+* @note		Call it before the CAN interrupt is enabled.
+*
+******************************************************************************/
+void CanStats_Init(CanStats *StatsPtr, u32 BitRate, u32 ClockHz, u8 Mode,
+		   u64 Now)
+{
+	memset(&StatsPtr->Live, 0, sizeof(StatsPtr->Live));
+	memset(StatsPtr->Slot, 0, sizeof(StatsPtr->Slot));
+	memset(StatsPtr->LastFrames, 0, sizeof(StatsPtr->LastFrames));
+	StatsPtr->Seq.store(0U, std::memory_order_relaxed);
+	StatsPtr->ClockHz = ClockHz;
+	StatsPtr->BitRate = BitRate;
+	StatsPtr->Loopback = (Mode == XCAN_MODE_LOOPBACK) ? TRUE : FALSE;
+	StatsPtr->LastTime = Now;
+	StatsPtr->LastBits = 0U;
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes a consistent copy of the counters, adds the controller error
+* counters and works out the rates since the previous snapshot, which
+* starts the next period. Interrupts stay enabled: a copy the interrupt
+* handler updated meanwhile is simply taken again.
+*
+* @param	StatsPtr is a pointer to the statistics.
+* @param	CanPtr is the controller, for the error counters.
+* @param	Now is the current time.
+* @param	SnapshotPtr is where the snapshot is returned.
+*
+* @return	None.
+*
+* @note		Call it from one task only; it keeps the previous period.
+*
+******************************************************************************/
+void CanStats_GetSnapshot(CanStats *StatsPtr, XCan *CanPtr, u64 Now,
+			  CanStats_Snapshot *SnapshotPtr)
+{
+	u64 Period = Now - StatsPtr->LastTime;
+	u64 Capacity;
+	u32 Before;
+	u8 RxErrors;
+	u8 TxErrors;
+	u32 Index;
+
+	do {
+		Before = StatsPtr->Seq.load(std::memory_order_acquire);
+		if (Before & 1U) {
+			continue;
+		}
+		*SnapshotPtr = StatsPtr->Live;
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while ((Before & 1U) ||
+		 StatsPtr->Seq.load(std::memory_order_relaxed) != Before);
+
+	XCan_GetBusErrorCounter(CanPtr, &RxErrors, &TxErrors);
+	SnapshotPtr->Tec = TxErrors;
+	SnapshotPtr->Rec = RxErrors;
+	SnapshotPtr->Time = Now;
+	SnapshotPtr->Period = Period;
+
+	/* Nothing to divide by in an empty period, the rates read 0 */
+	if (Period == 0U) {
+		Period = ~0ULL;
+	}
+	for (Index = 0U; Index < SnapshotPtr->NumIds; Index++) {
+		SnapshotPtr->Ids[Index].Fps = (u32)CanStats_Scale(
+			SnapshotPtr->Ids[Index].Frames -
+			StatsPtr->LastFrames[Index], Period, StatsPtr->ClockHz);
+		StatsPtr->LastFrames[Index] = SnapshotPtr->Ids[Index].Frames;
+	}
+
+	/* Bits the bus carries in the period, whole seconds first */
+	Capacity = (Period / StatsPtr->ClockHz) * StatsPtr->BitRate +
+		   (Period % StatsPtr->ClockHz) * StatsPtr->BitRate /
+		   StatsPtr->ClockHz;
+	SnapshotPtr->BusLoad = (Capacity == 0U) ? 0U :
+		(u32)((SnapshotPtr->BusBits - StatsPtr->LastBits) * 1000U /
+		      Capacity);
+
+	StatsPtr->LastTime = Now;
+	StatsPtr->LastBits = SnapshotPtr->BusBits;
+}
+
+/*****************************************************************************/
+/**
+*
+* Prints the one-line summary of a snapshot, for periodic export.
+*
+* @param	SnapshotPtr is a pointer to the snapshot.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanStats_PrintLine(const CanStats_Snapshot *SnapshotPtr)
+{
+	xil_printf("CAN: load %d.%d%%, rx %d, tx %d, TEC %d, REC %d, "
+		   "errors %d, overflows %d, bus-off %d\r\n",
+		   (int)(SnapshotPtr->BusLoad / 10U),
+		   (int)(SnapshotPtr->BusLoad % 10U),
+		   (int)SnapshotPtr->RxFrames, (int)SnapshotPtr->TxFrames,
+		   (int)SnapshotPtr->Tec, (int)SnapshotPtr->Rec,
+		   (int)(SnapshotPtr->AckErrors + SnapshotPtr->BitErrors +
+			 SnapshotPtr->StuffErrors + SnapshotPtr->FormErrors +
+			 SnapshotPtr->CrcErrors),
+		   (int)SnapshotPtr->RxOverflows, (int)SnapshotPtr->BusOff);
+}
+
+/*****************************************************************************/
+/**
+*
+* Prints a snapshot in full: the summary, each error count and the frames
+* and rate of every ID.
+*
+* @param	SnapshotPtr is a pointer to the snapshot.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanStats_Print(const CanStats_Snapshot *SnapshotPtr)
+{
+	const CanStats_Id *IdPtr;
+	u32 Index;
+	u32 Key;
+
+	CanStats_PrintLine(SnapshotPtr);
+	xil_printf("  ACK %d, bit %d, stuff %d, form %d, CRC %d, "
+		   "arbitration lost %d\r\n",
+		   (int)SnapshotPtr->AckErrors, (int)SnapshotPtr->BitErrors,
+		   (int)SnapshotPtr->StuffErrors, (int)SnapshotPtr->FormErrors,
+		   (int)SnapshotPtr->CrcErrors,
+		   (int)SnapshotPtr->ArbitrationLost);
+
+	for (Index = 0U; Index < SnapshotPtr->NumIds; Index++) {
+		IdPtr = &SnapshotPtr->Ids[Index];
+		Key = IdPtr->Key;
+		if (Key & XCAN_IDR_IDE_MASK) {
+			xil_printf("  ID %08x: %d frames, %d/s\r\n",
+				   (int)((((Key & XCAN_IDR_ID1_MASK) >>
+					   XCAN_IDR_ID1_SHIFT) << 18) |
+					 ((Key & XCAN_IDR_ID2_MASK) >>
+					  XCAN_IDR_ID2_SHIFT)),
+				   (int)IdPtr->Frames, (int)IdPtr->Fps);
+		} else {
+			xil_printf("  ID %03x: %d frames, %d/s\r\n",
+				   (int)((Key & XCAN_IDR_ID1_MASK) >>
+					 XCAN_IDR_ID1_SHIFT),
+				   (int)IdPtr->Frames, (int)IdPtr->Fps);
+		}
+	}
+	if (SnapshotPtr->OtherFrames != 0U) {
+		xil_printf("  other IDs: %d frames\r\n",
+			   (int)SnapshotPtr->OtherFrames);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns a count per second, given the ticks it took at ClockHz.
+*
+******************************************************************************/
+static u64 CanStats_Scale(u64 Count, u64 Ticks, u32 ClockHz)
+{
+	return Count * ClockHz / Ticks;
+}
@@ -0,0 +1,229 @@
+/******************************************************************************
+* CAN bus health and throughput statistics
+*
+* Always-on counters kept by the CAN interrupt handler, cheap enough for
+* every frame, and read by the task as one consistent snapshot:
+*
+*	ISR:	CanStats_WriteBegin(&Stats);
+*		... CanStats_RxFrame(&Stats, FramePtr) per received frame,
+*		CanStats_Errors(&Stats, ErrorMask) from the error handler,
+*		CanStats_Events(&Stats, Mask) from the event handler ...
+*		CanStats_WriteEnd(&Stats);
+*
+*	Task:	CanStats_GetSnapshot(&Stats, &Can, MonoClock_Now(),
+*				     &Snapshot);
+*		CanStats_Print(&Snapshot);
+*
+* The counters are the frames of each ID, the bits they took on the bus,
+* one count per ESR error type (ACKER, BERR, STER, FMER, CRCER), RX FIFO
+* overflows, lost arbitrations and bus-off events. A snapshot adds the
+* transmit and receive error counters, read from the controller, and the
+* rates since the previous snapshot: frames per second of each ID and the
+* bus load, the bits seen against what the bit rate carries in the time.
+* Frame lengths are worked out from the DLC without stuff bits, which add
+* up to a fifth more, so the load is a lower bound. The frames this node
+* sends are passed to CanStats_TxFrame as they complete, e.g. from the
+* retire handler of can_txsched.h. Their bits count toward the load in
+* normal mode only, since in loopback mode they come back as received.
+*
+* The live counters are a sequence lock: the interrupt handler makes the
+* sequence odd while it updates them and the snapshot copies them until it
+* sees the same even sequence before and after the copy. The interrupt
+* handler therefore never waits, and the task never sees half an update.
+* The counters and the snapshot are aligned to CAN_STATS_CACHE_LINE so
+* copying or exporting them touches no unrelated line.
+******************************************************************************/
+
+#ifndef CAN_STATS_H		/* prevent circular inclusions */
+#define CAN_STATS_H
+
+/***************************** Include Files *********************************/
+
+#include <atomic>
+
+#include "xil_types.h"
+#include "xcan.h"
+
+/************************** Constant Definitions *****************************/
+
+/* The larger of the Cortex-A9 (32) and host (64) cache lines */
+#define CAN_STATS_CACHE_LINE		64U
+
+/* IDs counted one by one, the frames of any others are counted together */
+#define CAN_STATS_MAX_IDS		64U
+
+/* Slots of the ID table, a power of two, twice the IDs */
+#define CAN_STATS_HASH_BITS		7U
+#define CAN_STATS_HASH_SIZE		(1U << CAN_STATS_HASH_BITS)
+
+/*
+ * Bits of a data frame besides its data, SOF to the end of the
+ * interframe space, without stuff bits
+ */
+#define CAN_STATS_STANDARD_BITS		47U
+#define CAN_STATS_EXTENDED_BITS		67U
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 Key;			/**< ID register bits of the ID */
+	u32 Frames;			/**< Frames since CanStats_Init */
+	u32 Fps;			/**< Frames per second, last period */
+} CanStats_Id;
+
+typedef struct alignas(CAN_STATS_CACHE_LINE) {
+	u64 Time;			/**< Clock count of the snapshot */
+	u64 Period;			/**< Ticks since the previous one */
+	u64 BusBits;			/**< Bits of the frames counted */
+	u32 BusLoad;			/**< Per mille, last period */
+	u32 RxFrames;
+	u32 TxFrames;
+	u32 Tec;			/**< Transmit error counter */
+	u32 Rec;			/**< Receive error counter */
+	u32 AckErrors;
+	u32 BitErrors;
+	u32 StuffErrors;
+	u32 FormErrors;
+	u32 CrcErrors;
+	u32 RxOverflows;
+	u32 ArbitrationLost;
+	u32 BusOff;
+	u32 OtherFrames;		/**< Frames of IDs past the table */
+	u32 NumIds;
+	CanStats_Id Ids[CAN_STATS_MAX_IDS];
+} CanStats_Snapshot;
+
+typedef struct {
+	CanStats_Snapshot Live;		/**< Written by the ISR only */
+	alignas(CAN_STATS_CACHE_LINE) std::atomic<u32> Seq;
+	u8 Slot[CAN_STATS_HASH_SIZE];	/**< Ids index + 1, 0 if free */
+	u32 ClockHz;			/**< Rate of the snapshot times */
+	u32 BitRate;
+	u32 Loopback;			/**< Own frames come back received */
+	u64 LastTime;			/**< Of the previous snapshot */
+	u64 LastBits;
+	u32 LastFrames[CAN_STATS_MAX_IDS];
+} CanStats;
+
+/************************** Function Prototypes ******************************/
+
+void CanStats_Init(CanStats *StatsPtr, u32 BitRate, u32 ClockHz, u8 Mode,
+		   u64 Now);
+void CanStats_GetSnapshot(CanStats *StatsPtr, XCan *CanPtr, u64 Now,
+			  CanStats_Snapshot *SnapshotPtr);
+void CanStats_Print(const CanStats_Snapshot *SnapshotPtr);
+void CanStats_PrintLine(const CanStats_Snapshot *SnapshotPtr);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/* Opens an update of the live counters, at the start of the ISR */
+static inline void CanStats_WriteBegin(CanStats *StatsPtr)
+{
+	StatsPtr->Seq.store(StatsPtr->Seq.load(std::memory_order_relaxed) + 1U,
+			    std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+/* Publishes the update, at the end of the ISR */
+static inline void CanStats_WriteEnd(CanStats *StatsPtr)
+{
+	StatsPtr->Seq.store(StatsPtr->Seq.load(std::memory_order_relaxed) + 1U,
+			    std::memory_order_release);
+}
+
+/* Bits a frame takes on the bus, without stuff bits */
+static inline u32 CanStats_FrameBits(const u32 *FramePtr)
+{
+	u32 Dlc = (FramePtr[1] & XCAN_DLCR_DLC_MASK) >> XCAN_DLCR_DLC_SHIFT;
+
+	if (FramePtr[0] & XCAN_IDR_IDE_MASK) {
+		return (FramePtr[0] & XCAN_IDR_RTR_MASK) ?
+		       CAN_STATS_EXTENDED_BITS :
+		       CAN_STATS_EXTENDED_BITS + 8U * ((Dlc > 8U) ? 8U : Dlc);
+	}
+	return (FramePtr[0] & XCAN_IDR_SRR_MASK) ?
+	       CAN_STATS_STANDARD_BITS :
+	       CAN_STATS_STANDARD_BITS + 8U * ((Dlc > 8U) ? 8U : Dlc);
+}
+
+/*****************************************************************************/
+/**
+*
+* Counts a received frame against its ID and the bus load. Call it between
+* CanStats_WriteBegin and CanStats_WriteEnd.
+*
+* @param	StatsPtr is a pointer to the statistics.
+* @param	FramePtr is the frame as XCan_Recv stores it.
+*
+* @return	None.
+*
+******************************************************************************/
+static inline void CanStats_RxFrame(CanStats *StatsPtr, const u32 *FramePtr)
+{
+	CanStats_Snapshot *LivePtr = &StatsPtr->Live;
+	u32 Key = FramePtr[0] & ((FramePtr[0] & XCAN_IDR_IDE_MASK) ?
+		  (XCAN_IDR_ID1_MASK | XCAN_IDR_IDE_MASK | XCAN_IDR_ID2_MASK) :
+		  XCAN_IDR_ID1_MASK);
+	u32 Slot = (Key * 0x9E3779B1U) >> (32U - CAN_STATS_HASH_BITS);
+	u32 Index;
+
+	LivePtr->RxFrames++;
+	LivePtr->BusBits += CanStats_FrameBits(FramePtr);
+
+	/* Linear probing, the table is never more than half full */
+	for (;;) {
+		Index = StatsPtr->Slot[Slot];
+		if (Index == 0U) {
+			if (LivePtr->NumIds == CAN_STATS_MAX_IDS) {
+				LivePtr->OtherFrames++;
+				return;
+			}
+			Index = ++LivePtr->NumIds;
+			LivePtr->Ids[Index - 1U].Key = Key;
+			StatsPtr->Slot[Slot] = (u8)Index;
+			break;
+		}
+		if (LivePtr->Ids[Index - 1U].Key == Key) {
+			break;
+		}
+		Slot = (Slot + 1U) & (CAN_STATS_HASH_SIZE - 1U);
+	}
+	LivePtr->Ids[Index - 1U].Frames++;
+}
+
+/*
+ * Counts a frame this node transmitted, and its bits unless it comes back
+ * received in loopback mode. Call it between CanStats_WriteBegin and
+ * CanStats_WriteEnd.
+ */
+static inline void CanStats_TxFrame(CanStats *StatsPtr, const u32 *FramePtr)
+{
+	StatsPtr->Live.TxFrames++;
+	if (!StatsPtr->Loopback) {
+		StatsPtr->Live.BusBits += CanStats_FrameBits(FramePtr);
+	}
+}
+
+/* Counts the error types of an ESR value, from the error handler */
+static inline void CanStats_Errors(CanStats *StatsPtr, u32 ErrorMask)
+{
+	CanStats_Snapshot *LivePtr = &StatsPtr->Live;
+
+	LivePtr->AckErrors += (ErrorMask & XCAN_ESR_ACKER_MASK) ? 1U : 0U;
+	LivePtr->BitErrors += (ErrorMask & XCAN_ESR_BERR_MASK) ? 1U : 0U;
+	LivePtr->StuffErrors += (ErrorMask & XCAN_ESR_STER_MASK) ? 1U : 0U;
+	LivePtr->FormErrors += (ErrorMask & XCAN_ESR_FMER_MASK) ? 1U : 0U;
+	LivePtr->CrcErrors += (ErrorMask & XCAN_ESR_CRCER_MASK) ? 1U : 0U;
+}
+
+/* Counts the events of an interrupt status value, from the event handler */
+static inline void CanStats_Events(CanStats *StatsPtr, u32 Mask)
+{
+	CanStats_Snapshot *LivePtr = &StatsPtr->Live;
+
+	LivePtr->RxOverflows += (Mask & XCAN_IXR_RXOFLW_MASK) ? 1U : 0U;
+	LivePtr->ArbitrationLost += (Mask & XCAN_IXR_ARBLST_MASK) ? 1U : 0U;
+	LivePtr->BusOff += (Mask & XCAN_IXR_BSOFF_MASK) ? 1U : 0U;
+}
+
+#endif	/* end of protection macro */
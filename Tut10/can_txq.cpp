@@ -0,0 +1,235 @@
+/******************************************************************************
+* Non-blocking CAN transmit queue
+*
+* See can_txq.h for the design. Latencies are taken with Timestamp_Now, so
+* Timestamp_Initialize or MonoClock_Initialize must have been called before
+* the first frame is queued.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xstatus.h"
+#include "xil_exception.h"
+#include "can_txq.h"
+#include "timestamp.h"
+
+/************************** Function Prototypes ******************************/
+
+static void CanTxQueue_Retire(CanTxQueue *QueuePtr, u32 Now);
+static void CanTxQueue_Refill(CanTxQueue *QueuePtr);
+
+/*****************************************************************************/
+/**
+*
+* Initializes an empty queue feeding the TX FIFO of a CAN controller.
+*
+* @param	QueuePtr is a pointer to the queue.
+* @param	CanPtr is a pointer to the initialized XCan instance.
+* @param	HwDepth is the depth of the hardware TX FIFO, normally
+*		XPAR_CAN_<n>_CAN_TX_DPTH.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanTxQueue_Init(CanTxQueue *QueuePtr, XCan *CanPtr, u32 HwDepth)
+{
+	QueuePtr->CanPtr = CanPtr;
+	QueuePtr->HwDepth = HwDepth;
+	QueuePtr->Head.store(0U, std::memory_order_relaxed);
+	QueuePtr->Next.store(0U, std::memory_order_relaxed);
+	QueuePtr->Done.store(0U, std::memory_order_relaxed);
+
+	QueuePtr->Stats.Frames = 0U;
+	QueuePtr->Stats.Full = 0U;
+	QueuePtr->Stats.Refills = 0U;
+	QueuePtr->Stats.MaxBatch = 0U;
+	QueuePtr->Stats.MinLatency = 0xFFFFFFFFU;
+	QueuePtr->Stats.MaxLatency = 0U;
+	QueuePtr->Stats.TotalLatency = 0U;
+}
+
+/*****************************************************************************/
+/**
+*
+* Queues a frame for transmission. Never waits: when the queue is full the
+* frame is rejected and the caller decides whether to retry or drop it.
+*
+* @param	QueuePtr is a pointer to the queue.
+* @param	FramePtr is the frame in XCan_Send layout. It is copied, the
+*		buffer may be reused as soon as the call returns.
+*
+* @return
+*		- XST_SUCCESS if the frame was queued
+*		- XST_FIFO_NO_ROOM if the queue is full
+*
+* @note		Task context only. The hardware is written with interrupts
+*		masked when the refill cannot be left to the next TXOK.
+*
+******************************************************************************/
+int CanTxQueue_Send(CanTxQueue *QueuePtr, const u32 *FramePtr)
+{
+	u32 Head = QueuePtr->Head.load(std::memory_order_relaxed);
+	u32 Done = QueuePtr->Done.load(std::memory_order_acquire);
+	CanTxQueue_Entry *EntryPtr;
+	u32 Index;
+
+	if ((Head - Done) == CAN_TXQ_SIZE) {
+		QueuePtr->Stats.Full++;
+		return XST_FIFO_NO_ROOM;
+	}
+
+	EntryPtr = &QueuePtr->Entry[Head & (CAN_TXQ_SIZE - 1U)];
+	for (Index = 0U; Index < CAN_TXQ_FRAME_WORDS; Index++) {
+		EntryPtr->Frame[Index] = FramePtr[Index];
+	}
+	EntryPtr->Stamp = Timestamp_Now();
+	QueuePtr->Head.store(Head + 1U, std::memory_order_release);
+
+	if ((QueuePtr->Next.load(std::memory_order_acquire) - Done) <
+	    CAN_TXQ_KICK_THRESHOLD) {
+		Xil_ExceptionDisable();
+		CanTxQueue_Refill(QueuePtr);
+		Xil_ExceptionEnable();
+	}
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Handles a TXOK interrupt: retires the oldest frame in flight and moves as
+* many queued frames as fit into the hardware TX FIFO. Call it from the
+* XCAN_HANDLER_SEND callback.
+*
+* @param	QueuePtr is a pointer to the queue.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanTxQueue_SendHandler(CanTxQueue *QueuePtr)
+{
+	u32 Next = QueuePtr->Next.load(std::memory_order_relaxed);
+	u32 Now = Timestamp_Now();
+
+	if (QueuePtr->Done.load(std::memory_order_relaxed) != Next) {
+		CanTxQueue_Retire(QueuePtr, Now);
+	}
+
+	/* An idle bus means every frame handed to the hardware has gone */
+	if ((XCan_GetStatus(QueuePtr->CanPtr) & XCAN_SR_BIDLE_MASK) != 0U) {
+		while (QueuePtr->Done.load(std::memory_order_relaxed) != Next) {
+			CanTxQueue_Retire(QueuePtr, Now);
+		}
+	}
+
+	CanTxQueue_Refill(QueuePtr);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the number of frames queued or in flight, i.e. not yet known to
+* be on the wire.
+*
+* @param	QueuePtr is a pointer to the queue.
+*
+* @return	The number of frames.
+*
+******************************************************************************/
+u32 CanTxQueue_Pending(CanTxQueue *QueuePtr)
+{
+	return QueuePtr->Head.load(std::memory_order_relaxed) -
+	       QueuePtr->Done.load(std::memory_order_acquire);
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the queue statistics. Latencies are in timer ticks, see
+* Timestamp_TicksToNs.
+*
+* @param	QueuePtr is a pointer to the queue.
+* @param	StatsPtr is where the statistics are returned.
+*
+* @return	None.
+*
+* @note		The statistics are read with interrupts masked so the
+*		latency fields are consistent with each other.
+*
+******************************************************************************/
+void CanTxQueue_GetStats(CanTxQueue *QueuePtr, CanTxQueue_Stats *StatsPtr)
+{
+	Xil_ExceptionDisable();
+	*StatsPtr = QueuePtr->Stats;
+	Xil_ExceptionEnable();
+}
+
+/*****************************************************************************/
+/**
+*
+* Retires the oldest frame in flight and accounts its latency.
+*
+******************************************************************************/
+static void CanTxQueue_Retire(CanTxQueue *QueuePtr, u32 Now)
+{
+	u32 Done = QueuePtr->Done.load(std::memory_order_relaxed);
+	CanTxQueue_Stats *StatsPtr = &QueuePtr->Stats;
+	u32 Latency;
+
+	Latency = Now - QueuePtr->Entry[Done & (CAN_TXQ_SIZE - 1U)].Stamp;
+	if (Latency < StatsPtr->MinLatency) {
+		StatsPtr->MinLatency = Latency;
+	}
+	if (Latency > StatsPtr->MaxLatency) {
+		StatsPtr->MaxLatency = Latency;
+	}
+	StatsPtr->TotalLatency += Latency;
+	StatsPtr->Frames++;
+
+	QueuePtr->Done.store(Done + 1U, std::memory_order_release);
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes queued frames to the hardware TX FIFO until either runs out. Runs
+* in the CAN interrupt or with interrupts masked.
+*
+******************************************************************************/
+static void CanTxQueue_Refill(CanTxQueue *QueuePtr)
+{
+	u32 Head = QueuePtr->Head.load(std::memory_order_acquire);
+	u32 Next = QueuePtr->Next.load(std::memory_order_relaxed);
+	u32 Batch = 0U;
+	CanTxQueue_Entry *EntryPtr;
+
+	while (Next != Head) {
+		EntryPtr = &QueuePtr->Entry[Next & (CAN_TXQ_SIZE - 1U)];
+		if (XCan_Send(QueuePtr->CanPtr, EntryPtr->Frame) !=
+		    XST_SUCCESS) {
+			break;
+		}
+
+		/*
+		 * The FIFO took a frame although a full FIFO's worth is
+		 * believed in flight: a TXOK was merged with another one.
+		 */
+		if ((Next - QueuePtr->Done.load(std::memory_order_relaxed)) ==
+		    QueuePtr->HwDepth) {
+			CanTxQueue_Retire(QueuePtr, Timestamp_Now());
+		}
+
+		Next++;
+		Batch++;
+	}
+
+	QueuePtr->Next.store(Next, std::memory_order_release);
+
+	if (Batch != 0U) {
+		QueuePtr->Stats.Refills++;
+		if (Batch > QueuePtr->Stats.MaxBatch) {
+			QueuePtr->Stats.MaxBatch = Batch;
+		}
+	}
+}
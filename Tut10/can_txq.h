@@ -0,0 +1,97 @@
+/******************************************************************************
+* Non-blocking CAN transmit queue
+*
+* Frames are queued in software by the task context and moved into the
+* hardware TX FIFO in batches from the XCAN_HANDLER_SEND callback, so the
+* producer never waits for the bus:
+*
+*	Task:		Status = CanTxQueue_Send(&TxQueue, Frame);
+*			XST_FIFO_NO_ROOM -> queue full, retry later or drop
+*
+*	SendHandler:	CanTxQueue_SendHandler(&TxQueue);
+*
+* Each TXOK interrupt refills the hardware FIFO until it is full. When the
+* hardware is about to run dry, CanTxQueue_Send writes the new frame
+* itself, so the bus never idles while frames are waiting and the refill
+* does not depend on a TXOK that may never come.
+*
+* The queue is a ring indexed by three free-running counters:
+*
+*	Done <= Next <= Head
+*	[Done, Next)	frames written to the hardware, not yet on the wire
+*	[Next, Head)	frames waiting in software
+*
+* Head is written only by CanTxQueue_Send. Next and Done are written only by
+* the refill path, which runs in the CAN interrupt or with interrupts
+* masked.
+*
+* The AXI CAN raises a single TXOK bit, however many frames completed
+* before the interrupt was serviced, so each TXOK retires one frame.
+* Completions that were merged into one interrupt are recovered the next
+* time a TXOK finds the bus idle, or when the hardware FIFO takes a frame
+* although the queue believes it full. Enqueue-to-wire latency is
+* therefore exact while interrupts keep up with the bus, and an upper
+* bound otherwise.
+******************************************************************************/
+
+#ifndef CAN_TXQ_H		/* prevent circular inclusions */
+#define CAN_TXQ_H
+
+/***************************** Include Files *********************************/
+
+#include <atomic>
+
+#include "xil_types.h"
+#include "xcan.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Frames held by the queue, must be a power of two */
+#define CAN_TXQ_SIZE			128U
+
+/* Words per frame, as written by XCan_Send */
+#define CAN_TXQ_FRAME_WORDS		(XCAN_MAX_FRAME_SIZE / sizeof(u32))
+
+/*
+ * CanTxQueue_Send writes to the hardware itself while fewer frames than
+ * this are in flight. Two keeps the next frame queued in the controller
+ * while the current one is on the wire.
+ */
+#define CAN_TXQ_KICK_THRESHOLD		2U
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 Frame[CAN_TXQ_FRAME_WORDS];
+	u32 Stamp;			/**< Timestamp_Now at enqueue */
+} CanTxQueue_Entry;
+
+typedef struct {
+	u32 Frames;			/**< Frames put on the wire */
+	u32 Full;			/**< CanTxQueue_Send calls rejected */
+	u32 Refills;			/**< Refills that wrote frames */
+	u32 MaxBatch;			/**< Most frames written by one refill */
+	u32 MinLatency;			/**< Enqueue to TXOK, timer ticks */
+	u32 MaxLatency;			/**< Enqueue to TXOK, timer ticks */
+	u64 TotalLatency;		/**< Sum of latencies, timer ticks */
+} CanTxQueue_Stats;
+
+typedef struct {
+	XCan *CanPtr;
+	u32 HwDepth;			/**< Frames the TX FIFO holds */
+	CanTxQueue_Entry Entry[CAN_TXQ_SIZE];
+	std::atomic<u32> Head;		/**< Next entry to fill (task) */
+	std::atomic<u32> Next;		/**< Next entry to write (refill) */
+	std::atomic<u32> Done;		/**< Oldest entry in flight (refill) */
+	CanTxQueue_Stats Stats;
+} CanTxQueue;
+
+/************************** Function Prototypes ******************************/
+
+void CanTxQueue_Init(CanTxQueue *QueuePtr, XCan *CanPtr, u32 HwDepth);
+int CanTxQueue_Send(CanTxQueue *QueuePtr, const u32 *FramePtr);
+void CanTxQueue_SendHandler(CanTxQueue *QueuePtr);
+u32 CanTxQueue_Pending(CanTxQueue *QueuePtr);
+void CanTxQueue_GetStats(CanTxQueue *QueuePtr, CanTxQueue_Stats *StatsPtr);
+
+#endif	/* end of protection macro */
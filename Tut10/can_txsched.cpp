@@ -0,0 +1,383 @@
+/******************************************************************************
+* Priority CAN transmit scheduler
+*
+* See can_txsched.h for the design. Latencies are taken with
+* Timestamp_Now, so Timestamp_Initialize or MonoClock_Initialize must have
+* been called before the first frame is queued.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xstatus.h"
+#include "xil_exception.h"
+#include "can_txsched.h"
+#include "timestamp.h"
+
+/************************** Function Prototypes ******************************/
+
+static void CanTxSched_Retire(CanTxSched *SchedPtr, u32 ClassIndex,
+			      u32 Now);
+static void CanTxSched_RetireFifo(CanTxSched *SchedPtr, u32 Now);
+static void CanTxSched_Refill(CanTxSched *SchedPtr);
+
+/*****************************************************************************/
+/**
+*
+* Initializes an empty scheduler feeding the TXHPB and TX FIFO of a CAN
+* controller.
+*
+* @param	SchedPtr is a pointer to the scheduler.
+* @param	CanPtr is a pointer to the initialized XCan instance.
+* @param	FifoLimit is the most frames let into the TX FIFO, 1 to the
+*		smaller of CAN_TXS_MAX_FIFO and XPAR_CAN_<n>_CAN_TX_DPTH.
+* @param	ClassLimit is the highest base ID of each class but the last,
+*		CAN_TXS_CLASSES - 1 IDs in ascending order. A frame goes to
+*		the first class whose limit its base ID does not exceed.
+*
+* @return	XST_SUCCESS, or XST_INVALID_PARAM for a FifoLimit out of
+*		range or limits out of order.
+*
+******************************************************************************/
+int CanTxSched_Init(CanTxSched *SchedPtr, XCan *CanPtr, u32 FifoLimit,
+		    const u16 *ClassLimit)
+{
+	CanTxSched_Class *ClassPtr;
+	CanTxSched_ClassStats *ClassStatsPtr;
+	u32 Index;
+
+	if ((FifoLimit == 0U) || (FifoLimit > CAN_TXS_MAX_FIFO)) {
+		return XST_INVALID_PARAM;
+	}
+	for (Index = 1U; Index < CAN_TXS_CLASSES - 1U; Index++) {
+		if (ClassLimit[Index] < ClassLimit[Index - 1U]) {
+			return XST_INVALID_PARAM;
+		}
+	}
+
+	SchedPtr->CanPtr = CanPtr;
+	SchedPtr->FifoLimit = FifoLimit;
+	for (Index = 0U; Index < CAN_TXS_CLASSES - 1U; Index++) {
+		SchedPtr->ClassLimit[Index] = ClassLimit[Index];
+	}
+	SchedPtr->HpbBusy.store(FALSE, std::memory_order_relaxed);
+	SchedPtr->FifoCount.store(0U, std::memory_order_relaxed);
+	SchedPtr->FifoHead = 0U;
+
+	for (Index = 0U; Index < CAN_TXS_CLASSES; Index++) {
+		ClassPtr = &SchedPtr->Class[Index];
+		ClassPtr->Head.store(0U, std::memory_order_relaxed);
+		ClassPtr->Next.store(0U, std::memory_order_relaxed);
+		ClassPtr->Done.store(0U, std::memory_order_relaxed);
+
+		ClassStatsPtr = &SchedPtr->Stats.Class[Index];
+		ClassStatsPtr->Frames = 0U;
+		ClassStatsPtr->Full = 0U;
+		ClassStatsPtr->MaxWaiting = 0U;
+		ClassStatsPtr->MinLatency = 0xFFFFFFFFU;
+		ClassStatsPtr->MaxLatency = 0U;
+		ClassStatsPtr->TotalLatency = 0U;
+	}
+	SchedPtr->Stats.Full = 0U;
+	SchedPtr->Stats.CatchUps = 0U;
+	SchedPtr->RetireHandler = NULL;
+	SchedPtr->RetireRef = NULL;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Queues a frame for transmission in the class of its ID. Never waits:
+* when the class is full the frame is rejected and the caller decides
+* whether to retry or drop it.
+*
+* @param	SchedPtr is a pointer to the scheduler.
+* @param	FramePtr is the frame in XCan_Send layout. It is copied, the
+*		buffer may be reused as soon as the call returns.
+*
+* @return
+*		- XST_SUCCESS if the frame was queued
+*		- XST_FIFO_NO_ROOM if its class is full
+*
+* @note		Task context only. The hardware is written with interrupts
+*		masked when the frame can go to it at once.
+*
+******************************************************************************/
+int CanTxSched_Send(CanTxSched *SchedPtr, const u32 *FramePtr)
+{
+	u32 ClassIndex = CanTxSched_ClassOf(SchedPtr, FramePtr[0]);
+	CanTxSched_Class *ClassPtr = &SchedPtr->Class[ClassIndex];
+	CanTxSched_ClassStats *ClassStatsPtr =
+		&SchedPtr->Stats.Class[ClassIndex];
+	u32 Head = ClassPtr->Head.load(std::memory_order_relaxed);
+	u32 Done = ClassPtr->Done.load(std::memory_order_acquire);
+	CanTxSched_Entry *EntryPtr;
+	u32 Index;
+	int Room;
+
+	if ((Head - Done) == CAN_TXS_CLASS_SIZE) {
+		ClassStatsPtr->Full++;
+		SchedPtr->Stats.Full++;
+		return XST_FIFO_NO_ROOM;
+	}
+
+	EntryPtr = &ClassPtr->Entry[Head & (CAN_TXS_CLASS_SIZE - 1U)];
+	for (Index = 0U; Index < CAN_TXS_FRAME_WORDS; Index++) {
+		EntryPtr->Frame[Index] = FramePtr[Index];
+	}
+	EntryPtr->Stamp = Timestamp_Now();
+	ClassPtr->Head.store(Head + 1U, std::memory_order_release);
+
+	if (Head + 1U - Done > ClassStatsPtr->MaxWaiting) {
+		ClassStatsPtr->MaxWaiting = Head + 1U - Done;
+	}
+
+	/* Only a free TXHPB or FIFO slot needs the refill now */
+	if (ClassIndex == 0U) {
+		Room = !SchedPtr->HpbBusy.load(std::memory_order_acquire);
+	} else {
+		Room = SchedPtr->FifoCount.load(std::memory_order_acquire) <
+		       SchedPtr->FifoLimit;
+	}
+	if (Room) {
+		Xil_ExceptionDisable();
+		CanTxSched_Refill(SchedPtr);
+		Xil_ExceptionEnable();
+	}
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Handles a TXOK interrupt: retires the frame sent and refills the TXHPB
+* and TX FIFO with the most urgent frames waiting. Call it from the
+* XCAN_HANDLER_SEND callback.
+*
+* @param	SchedPtr is a pointer to the scheduler.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanTxSched_SendHandler(CanTxSched *SchedPtr)
+{
+	u32 Status = XCan_GetStatus(SchedPtr->CanPtr);
+	u32 Now = Timestamp_Now();
+	int Retired = FALSE;
+
+	if (SchedPtr->HpbBusy.load(std::memory_order_relaxed) &&
+	    ((Status & XCAN_SR_TXBFLL_MASK) == 0U)) {
+		CanTxSched_Retire(SchedPtr, 0U, Now);
+		SchedPtr->HpbBusy.store(FALSE, std::memory_order_release);
+		Retired = TRUE;
+	}
+	if (!Retired &&
+	    (SchedPtr->FifoCount.load(std::memory_order_relaxed) != 0U)) {
+		CanTxSched_RetireFifo(SchedPtr, Now);
+	}
+
+	/* An idle bus means every frame handed to the hardware has gone */
+	if ((Status & XCAN_SR_BIDLE_MASK) != 0U) {
+		while (SchedPtr->FifoCount.load(std::memory_order_relaxed) !=
+		       0U) {
+			CanTxSched_RetireFifo(SchedPtr, Now);
+			SchedPtr->Stats.CatchUps++;
+		}
+	}
+
+	CanTxSched_Refill(SchedPtr);
+}
+
+/*****************************************************************************/
+/**
+*
+* Sets the handler each frame is handed to as it is retired, known to be
+* on the wire. It runs in the CAN interrupt, from CanTxSched_SendHandler.
+*
+* @param	SchedPtr is a pointer to the scheduler.
+* @param	Handler is called with CallBackRef and the frame, NULL for
+*		none.
+* @param	CallBackRef is passed to Handler.
+*
+* @return	None.
+*
+* @note		Call it before the CAN interrupt is enabled.
+*
+******************************************************************************/
+void CanTxSched_SetRetireHandler(CanTxSched *SchedPtr,
+				 CanTxSched_RetireHandler Handler,
+				 void *CallBackRef)
+{
+	SchedPtr->RetireHandler = Handler;
+	SchedPtr->RetireRef = CallBackRef;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the class of a frame.
+*
+* @param	SchedPtr is a pointer to the scheduler.
+* @param	IdValue is the first word of the frame, XCAN_IDR layout.
+*
+* @return	The class, 0 the most urgent.
+*
+******************************************************************************/
+u32 CanTxSched_ClassOf(CanTxSched *SchedPtr, u32 IdValue)
+{
+	u32 BaseId = (IdValue & XCAN_IDR_ID1_MASK) >> XCAN_IDR_ID1_SHIFT;
+	u32 Index;
+
+	for (Index = 0U; Index < CAN_TXS_CLASSES - 1U; Index++) {
+		if (BaseId <= SchedPtr->ClassLimit[Index]) {
+			break;
+		}
+	}
+
+	return Index;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the number of frames queued or in flight, i.e. not yet known to
+* be on the wire, in all classes.
+*
+* @param	SchedPtr is a pointer to the scheduler.
+*
+* @return	The number of frames.
+*
+******************************************************************************/
+u32 CanTxSched_Pending(CanTxSched *SchedPtr)
+{
+	u32 Pending = 0U;
+	u32 Index;
+
+	for (Index = 0U; Index < CAN_TXS_CLASSES; Index++) {
+		Pending += SchedPtr->Class[Index].Head.load(
+				   std::memory_order_relaxed) -
+			   SchedPtr->Class[Index].Done.load(
+				   std::memory_order_acquire);
+	}
+
+	return Pending;
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the scheduler statistics. Latencies are in timer ticks, see
+* Timestamp_TicksToNs.
+*
+* @param	SchedPtr is a pointer to the scheduler.
+* @param	StatsPtr is where the statistics are returned.
+*
+* @return	None.
+*
+******************************************************************************/
+void CanTxSched_GetStats(CanTxSched *SchedPtr, CanTxSched_Stats *StatsPtr)
+{
+	Xil_ExceptionDisable();
+	*StatsPtr = SchedPtr->Stats;
+	Xil_ExceptionEnable();
+}
+
+/*****************************************************************************/
+/**
+*
+* Retires the oldest frame in flight of a class, accounts its latency and
+* hands it to the retire handler.
+*
+******************************************************************************/
+static void CanTxSched_Retire(CanTxSched *SchedPtr, u32 ClassIndex,
+			      u32 Now)
+{
+	CanTxSched_Class *ClassPtr = &SchedPtr->Class[ClassIndex];
+	CanTxSched_ClassStats *StatsPtr = &SchedPtr->Stats.Class[ClassIndex];
+	u32 Done = ClassPtr->Done.load(std::memory_order_relaxed);
+	CanTxSched_Entry *EntryPtr =
+		&ClassPtr->Entry[Done & (CAN_TXS_CLASS_SIZE - 1U)];
+	u32 Latency;
+
+	Latency = Now - EntryPtr->Stamp;
+	if (Latency < StatsPtr->MinLatency) {
+		StatsPtr->MinLatency = Latency;
+	}
+	if (Latency > StatsPtr->MaxLatency) {
+		StatsPtr->MaxLatency = Latency;
+	}
+	StatsPtr->TotalLatency += Latency;
+	StatsPtr->Frames++;
+	if (SchedPtr->RetireHandler != NULL) {
+		SchedPtr->RetireHandler(SchedPtr->RetireRef, EntryPtr->Frame);
+	}
+
+	ClassPtr->Done.store(Done + 1U, std::memory_order_release);
+}
+
+/*****************************************************************************/
+/**
+*
+* Retires the oldest frame of the TX FIFO.
+*
+******************************************************************************/
+static void CanTxSched_RetireFifo(CanTxSched *SchedPtr, u32 Now)
+{
+	u32 Count = SchedPtr->FifoCount.load(std::memory_order_relaxed);
+	u32 Oldest = (SchedPtr->FifoHead - Count) & (CAN_TXS_MAX_FIFO - 1U);
+
+	CanTxSched_Retire(SchedPtr, SchedPtr->FifoClass[Oldest], Now);
+	SchedPtr->FifoCount.store(Count - 1U, std::memory_order_release);
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes the oldest class 0 frame to a free TXHPB and the most urgent of
+* the other classes to the TX FIFO, up to its limit. Runs in the CAN
+* interrupt or with interrupts masked.
+*
+******************************************************************************/
+static void CanTxSched_Refill(CanTxSched *SchedPtr)
+{
+	CanTxSched_Class *ClassPtr = &SchedPtr->Class[0];
+	u32 Count = SchedPtr->FifoCount.load(std::memory_order_relaxed);
+	u32 ClassIndex = 1U;
+	u32 *FramePtr;
+	u32 Next;
+
+	Next = ClassPtr->Next.load(std::memory_order_relaxed);
+	if (!SchedPtr->HpbBusy.load(std::memory_order_relaxed) &&
+	    (Next != ClassPtr->Head.load(std::memory_order_acquire)) &&
+	    (XCan_SendHighPriority(SchedPtr->CanPtr,
+		ClassPtr->Entry[Next & (CAN_TXS_CLASS_SIZE - 1U)].Frame) ==
+	     XST_SUCCESS)) {
+		ClassPtr->Next.store(Next + 1U, std::memory_order_relaxed);
+		SchedPtr->HpbBusy.store(TRUE, std::memory_order_release);
+	}
+
+	while ((Count < SchedPtr->FifoLimit) &&
+	       (ClassIndex < CAN_TXS_CLASSES)) {
+		ClassPtr = &SchedPtr->Class[ClassIndex];
+		Next = ClassPtr->Next.load(std::memory_order_relaxed);
+		if (Next == ClassPtr->Head.load(std::memory_order_acquire)) {
+			ClassIndex++;
+			continue;
+		}
+		FramePtr = ClassPtr->Entry[Next &
+					   (CAN_TXS_CLASS_SIZE - 1U)].Frame;
+		if (XCan_Send(SchedPtr->CanPtr, FramePtr) != XST_SUCCESS) {
+			break;
+		}
+
+		ClassPtr->Next.store(Next + 1U, std::memory_order_relaxed);
+		SchedPtr->FifoClass[SchedPtr->FifoHead &
+				    (CAN_TXS_MAX_FIFO - 1U)] = (u8)ClassIndex;
+		SchedPtr->FifoHead++;
+		Count++;
+	}
+
+	SchedPtr->FifoCount.store(Count, std::memory_order_release);
+}
@@ -0,0 +1,124 @@
+/******************************************************************************
+* Priority CAN transmit scheduler
+*
+* A non-blocking transmit queue, like can_txq.h, that sends frames by the
+* priority of their ID rather than in submission order. Frames are sorted
+* into CAN_TXS_CLASSES classes by their 11-bit base ID, the first field
+* arbitrated on the wire and the priority field of J1939 IDs, and each
+* class keeps its own order, so the frames of one ID never overtake each
+* other:
+*
+*	class 0		the high priority buffer (TXHPB), which the
+*			controller sends before anything in its TX FIFO
+*	classes 1..	the TX FIFO, lowest class first, filled only
+*			FifoLimit frames deep
+*
+* The shallow FIFO is what removes the head-of-line blocking: a frame
+* written to the hardware cannot be overtaken any more, so a burst of low
+* priority frames may hold the FIFO for at most FifoLimit frame times
+* while a more urgent one waits in software. A limit of two keeps the bus
+* busy while TXOK is serviced, as in can_txq.h.
+*
+*	Task:		Status = CanTxSched_Send(&TxSched, Frame);
+*			XST_FIFO_NO_ROOM -> class full, retry later or drop
+*
+*	SendHandler:	CanTxSched_SendHandler(&TxSched);
+*
+* Each class is a ring of three free-running counters, Done <= Next <=
+* Head, as in can_txq.h. Head is written only by CanTxSched_Send, Next and
+* Done only in the CAN interrupt or with interrupts masked.
+*
+* One TXOK retires one frame: the one in the TXHPB if the buffer has
+* emptied, otherwise the oldest in the TX FIFO. As in can_txq.h,
+* completions merged into one interrupt are caught up when a TXOK finds
+* the bus idle, so the queueing delay of each class, enqueue to TXOK, is
+* exact while interrupts keep up with the bus and an upper bound
+* otherwise. CanTxSched_SetRetireHandler has each frame handed on as it
+* is retired, e.g. to count what this node sent.
+******************************************************************************/
+
+#ifndef CAN_TXSCHED_H		/* prevent circular inclusions */
+#define CAN_TXSCHED_H
+
+/***************************** Include Files *********************************/
+
+#include <atomic>
+
+#include "xil_types.h"
+#include "xcan.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Priority classes, class 0 being the TXHPB */
+#define CAN_TXS_CLASSES			4U
+
+/* Frames held by each class, must be a power of two */
+#define CAN_TXS_CLASS_SIZE		64U
+
+/* Most frames CanTxSched_Init lets into the TX FIFO */
+#define CAN_TXS_MAX_FIFO		64U
+
+/* Words per frame, as written by XCan_Send */
+#define CAN_TXS_FRAME_WORDS		(XCAN_MAX_FRAME_SIZE / sizeof(u32))
+
+/**************************** Type Definitions *******************************/
+
+/* Called in the CAN interrupt with each frame retired, XCan_Send layout */
+typedef void (*CanTxSched_RetireHandler)(void *CallBackRef,
+					 const u32 *FramePtr);
+
+typedef struct {
+	u32 Frame[CAN_TXS_FRAME_WORDS];
+	u32 Stamp;			/**< Timestamp_Now at enqueue */
+} CanTxSched_Entry;
+
+typedef struct {
+	u32 Frames;			/**< Frames put on the wire */
+	u32 Full;			/**< CanTxSched_Send calls rejected */
+	u32 MaxWaiting;			/**< Most frames queued or in flight */
+	u32 MinLatency;			/**< Enqueue to TXOK, timer ticks */
+	u32 MaxLatency;
+	u64 TotalLatency;
+} CanTxSched_ClassStats;
+
+typedef struct {
+	CanTxSched_ClassStats Class[CAN_TXS_CLASSES];
+	u32 Full;			/**< Rejected sends of all classes */
+	u32 CatchUps;			/**< Frames retired on an idle bus */
+} CanTxSched_Stats;
+
+typedef struct {
+	CanTxSched_Entry Entry[CAN_TXS_CLASS_SIZE];
+	std::atomic<u32> Head;		/**< Next entry to fill (task) */
+	std::atomic<u32> Next;		/**< Next entry to write (refill) */
+	std::atomic<u32> Done;		/**< Oldest entry in flight (refill) */
+} CanTxSched_Class;
+
+typedef struct {
+	XCan *CanPtr;
+	u32 FifoLimit;			/**< Frames let into the TX FIFO */
+	u16 ClassLimit[CAN_TXS_CLASSES - 1U];	/**< Highest base ID */
+	CanTxSched_Class Class[CAN_TXS_CLASSES];
+	std::atomic<u32> HpbBusy;	/**< A class 0 frame is in the TXHPB */
+	std::atomic<u32> FifoCount;	/**< Frames in the TX FIFO */
+	u32 FifoHead;			/**< Class of each, in write order */
+	u8 FifoClass[CAN_TXS_MAX_FIFO];
+	CanTxSched_Stats Stats;
+	CanTxSched_RetireHandler RetireHandler;	/**< NULL if none */
+	void *RetireRef;
+} CanTxSched;
+
+/************************** Function Prototypes ******************************/
+
+int CanTxSched_Init(CanTxSched *SchedPtr, XCan *CanPtr, u32 FifoLimit,
+		    const u16 *ClassLimit);
+int CanTxSched_Send(CanTxSched *SchedPtr, const u32 *FramePtr);
+void CanTxSched_SendHandler(CanTxSched *SchedPtr);
+void CanTxSched_SetRetireHandler(CanTxSched *SchedPtr,
+				 CanTxSched_RetireHandler Handler,
+				 void *CallBackRef);
+u32 CanTxSched_ClassOf(CanTxSched *SchedPtr, u32 IdValue);
+u32 CanTxSched_Pending(CanTxSched *SchedPtr);
+void CanTxSched_GetStats(CanTxSched *SchedPtr, CanTxSched_Stats *StatsPtr);
+
+#endif	/* end of protection macro */
@@ -0,0 +1,159 @@
+/******************************************************************************
+* CAN FD bit timing solver
+*
+* Finds the nominal (arbitration phase) BRPR/BTR and the data phase
+* F_BRPR/F_BTR settings of the AXI CAN FD controller with the solver of
+* can_bit_timing.h, within the wider ranges of its registers:
+*
+*	constexpr CanFdBitTiming Timing =
+*		CanFdBitTiming_Check<80000000, 1000000, 875, 5000000, 750>();
+*	CanFdBitTiming_Apply(&CanFd, &Timing);
+*
+* The arbitration phase takes TSEG1 1..256, TSEG2 1..128 and SJW up to
+* 128 quanta, the data phase TSEG1 1..32, TSEG2 1..16 and SJW up to 16.
+* Both phases allow as many quanta per bit as the segments add up to, so
+* the solver, which prefers the most quanta, settles on the smallest
+* prescaler that divides each rate; at rates both divide from the clock
+* that is the same one in both phases, as CiA 601-3 recommends for a
+* consistent transmitter delay compensation.
+*
+* The data phase is usually sampled earlier than the arbitration phase,
+* e.g. at 75 % against 87.5 %, since the transceiver delay is a larger
+* part of its shorter bit.
+******************************************************************************/
+
+#ifndef CANFD_BIT_TIMING_H		/* prevent circular inclusions */
+#define CANFD_BIT_TIMING_H
+
+/***************************** Include Files *********************************/
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xcanfd.h"
+#include "can_bit_timing.h"
+
+/**************************** Type Definitions *******************************/
+
+/* Settings of both phases, the fields as XCanFd_Set*BitTiming take them */
+typedef struct {
+	CanBitTiming Nominal;		/**< Arbitration phase, BRPR/BTR */
+	CanBitTiming Data;		/**< Data phase, F_BRPR/F_BTR */
+} CanFdBitTiming;
+
+/************************** Variable Definitions *****************************/
+
+static constexpr CanBitTiming_Limits CanFdBitTiming_Nominal = {
+	256U, 256U, 128U, 128U, CAN_BIT_TIMING_MIN_QUANTA, 1U + 256U + 128U
+};
+
+static constexpr CanBitTiming_Limits CanFdBitTiming_Data = {
+	256U, 32U, 16U, 16U, CAN_BIT_TIMING_MIN_QUANTA, 1U + 32U + 16U
+};
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/*****************************************************************************/
+/**
+*
+* Searches the bit timings of both phases of the controller.
+*
+* @param	ClockHz is the CAN clock of the controller.
+* @param	NominalRate and NominalSp are the arbitration phase bit rate
+*		in bit/s and sample point in per mille.
+* @param	DataRate and DataSp are the same for the data phase.
+*
+* @return	The best settings, each with Valid clear if its rate cannot
+*		be divided from the clock.
+*
+******************************************************************************/
+static constexpr CanFdBitTiming CanFdBitTiming_Solve(u32 ClockHz,
+		u32 NominalRate, u32 NominalSp, u32 DataRate, u32 DataSp)
+{
+	return {
+		CanBitTiming_Solve(ClockHz, NominalRate, NominalSp,
+				   CanFdBitTiming_Nominal),
+		CanBitTiming_Solve(ClockHz, DataRate, DataSp,
+				   CanFdBitTiming_Data)
+	};
+}
+
+/*****************************************************************************/
+/**
+*
+* Solves constant bit timings at compile time.
+*
+* @return	The settings of CanFdBitTiming_Solve. The build fails if
+*		either phase has none, its bit rate error is above
+*		MaxErrorPpm, or the data phase is slower than the
+*		arbitration phase.
+*
+******************************************************************************/
+template <u32 ClockHz, u32 NominalRate, u32 NominalSp, u32 DataRate,
+	  u32 DataSp, u32 MaxErrorPpm = CAN_BIT_TIMING_MAX_ERROR_PPM>
+constexpr CanFdBitTiming CanFdBitTiming_Check(void)
+{
+	constexpr CanFdBitTiming Timing =
+		CanFdBitTiming_Solve(ClockHz, NominalRate, NominalSp,
+				     DataRate, DataSp);
+
+	static_assert(Timing.Nominal.Valid && Timing.Data.Valid,
+		      "no CAN FD bit timing for this clock and bit rates");
+	static_assert((Timing.Nominal.ErrorPpm <= MaxErrorPpm) &&
+		      (Timing.Data.ErrorPpm <= MaxErrorPpm),
+		      "CAN FD bit rate error too large for this clock");
+	static_assert(DataRate >= NominalRate,
+		      "CAN FD data phase slower than the arbitration phase");
+
+	return Timing;
+}
+
+/*****************************************************************************/
+/**
+*
+* Writes the bit timings of both phases to the controller, which must be
+* in configuration mode.
+*
+* @param	InstancePtr is a pointer to the XCanFd instance.
+* @param	TimingPtr is a setting from CanFdBitTiming_Solve or
+*		CanFdBitTiming_Check.
+*
+* @return
+*		- XST_SUCCESS if the settings were written
+*		- XST_INVALID_PARAM if either setting is not valid
+*		- XST_FAILURE if the controller is not in configuration mode
+*
+******************************************************************************/
+static inline int CanFdBitTiming_Apply(XCanFd *InstancePtr,
+				       const CanFdBitTiming *TimingPtr)
+{
+	const CanBitTiming *NominalPtr = &TimingPtr->Nominal;
+	const CanBitTiming *DataPtr = &TimingPtr->Data;
+	int Status;
+
+	if (!NominalPtr->Valid || !DataPtr->Valid) {
+		return XST_INVALID_PARAM;
+	}
+
+	Status = XCanFd_SetBaudRatePrescaler(InstancePtr,
+					     NominalPtr->Prescaler);
+	if (Status == XST_SUCCESS) {
+		Status = XCanFd_SetBitTiming(InstancePtr,
+					     NominalPtr->SyncJumpWidth,
+					     NominalPtr->TimeSegment2,
+					     NominalPtr->TimeSegment1);
+	}
+	if (Status == XST_SUCCESS) {
+		Status = XCanFd_SetFBaudRatePrescaler(InstancePtr,
+						      DataPtr->Prescaler);
+	}
+	if (Status == XST_SUCCESS) {
+		Status = XCanFd_SetFBitTiming(InstancePtr,
+					      DataPtr->SyncJumpWidth,
+					      DataPtr->TimeSegment2,
+					      DataPtr->TimeSegment1);
+	}
+
+	return Status;
+}
+
+#endif	/* end of protection macro */
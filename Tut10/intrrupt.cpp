@@ -3,6 +3,8 @@
 * 
 * This application uses an AXI timer/counter to generate periodic interrupts.
 * An instance of interrupt controller is used to handle interrupt signal generation.
+* Counter 0 drives a timer wheel (timer_wheel.h) that multiplexes all the
+* periodic and one-shot jobs of the application onto its interrupt.
 * 
 * Copyright (c) 2009 Xilinx, Inc. All rights reserved.
 ******************************************************************************/
@@ -15,7 +17,14 @@
 #include "xtmrctr.h"
 #include "xil_io.h"
 #include "xil_exception.h"
+#include "xil_printf.h"
 #include "xscugic.h"
+#include "timestamp.h"
+#include "mono_clock.h"
+#include "trace_log.h"
+#include "latency_hist.h"
+#include "timer_wheel.h"
+#include "axi_timer_regs.h"
 #include <stdio.h>
 
 using namespace std;
@@ -30,6 +39,7 @@ using namespace std;
 #define TIMER_DEVICE_ID         XPAR_AXI_TIMER_0_DEVICE_ID
 #define INTC_DEVICE_ID          XPAR_PS7_SCUGIC_0_DEVICE_ID
 #define TIMER_INTERRUPT_ID      XPAR_FABRIC_AXI_TIMER_0_INTERRUPT_INTR
+#define CLOCK_TIMER_DEVICE_ID   XPAR_AXI_TIMER_2_DEVICE_ID
 
 /*
  * Timer counter configuration
@@ -44,6 +54,35 @@ using namespace std;
  */
 #define TIMER_COUNTER_0         0
 
+/*
+ * Counter 0 register by register, for direct access without the driver
+ */
+using Timer0 = AxiTimer_Counter<XPAR_AXI_TIMER_0_BASEADDR, TIMER_COUNTER_0>;
+
+/*
+ * Timer wheel configuration: tick length and whether counter 0 interrupts
+ * every tick (TIMER_WHEEL_PERIODIC) or only when a job is due
+ * (TIMER_WHEEL_TICKLESS)
+ */
+#define WHEEL_TICK_US           1000
+#define WHEEL_MODE              TIMER_WHEEL_TICKLESS
+
+/*
+ * Jobs on the wheel, in wheel ticks: the one second tick of the original
+ * example, which stops after TICK_COUNT_MAX expiries, a faster background
+ * job and a one-shot timeout
+ */
+#define TICK_PERIOD             (1000000 / WHEEL_TICK_US)
+#define TICK_COUNT_MAX          10
+#define POLL_PERIOD             250
+#define TIMEOUT_DELAY           5500
+
+/*
+ * Trace output of the idle loop: TRACE_LOG_TEXT prints the events,
+ * TRACE_LOG_BINARY writes raw records for HostSim/tools/trace_decode
+ */
+#define TRACE_OUTPUT            TRACE_LOG_TEXT
+
 /************************** Variable Definitions *****************************/
 
 /* Instance of the Interrupt Controller */
@@ -55,15 +94,38 @@ static XScuGic_Config *GicConfig;
 /* Timer Instance */
 XTmrCtr TimerInstancePtr;
 
+/* Cascaded 64-bit system clock, the timebase of all timestamps */
+static XTmrCtr ClockTimer;
+
 /* Counter for tracking interrupts */
 volatile int InterruptCounter = 0;
 
 /* Flag to track if timer has been started */
 volatile int TimerStarted = 0;
 
+/* Timer wheel on counter 0 and the jobs it runs */
+static TimerWheel Wheel;
+static TimerWheel_Timer TickTimer;
+static TimerWheel_Timer PollTimer;
+static TimerWheel_Timer TimeoutTimer;
+
+/* Expiries of the background job */
+volatile int PollCounter = 0;
+
+/*
+ * Expiry to handler entry latency and handler execution time of the timer
+ * interrupt, in timestamp counter ticks
+ */
+static LatencyHist TimerLatencyHist;
+static LatencyHist TimerExecHist;
+
 /************************** Function Prototypes ******************************/
 
-void Timer_InterruptHandler(void *CallBackRef, u8 TmrCtrNumber);
+void Timer_InterruptHandler(void *CallBackRef);
+void Poll_Handler(void *CallBackRef);
+void Timeout_Handler(void *CallBackRef);
+void Timer_Isr(void *CallBackRef);
+void PrintLatencyReport(void);
 int SetUpInterruptSystem(XScuGic *XScuGicInstancePtr);
 int ScuGicInterrupt_Init(u16 DeviceId, XTmrCtr *TimerInstancePtr);
 
@@ -71,42 +133,133 @@ int ScuGicInterrupt_Init(u16 DeviceId, XTmrCtr *TimerInstancePtr);
 /**
 *
 * Timer Interrupt Handler
-* This function is called when a timer interrupt occurs.
-* It increments a counter and prints a message.
+* This function is called by the timer wheel every TICK_PERIOD ticks.
+* It increments a counter and logs a trace event, which the idle loop
+* prints later: formatting text here would delay every other interrupt.
 *
-* @param    CallBackRef is a pointer to the callback reference
-* @param    TmrCtrNumber is the number of the timer generating the interrupt
+* @param    CallBackRef is a pointer to the timer wheel
 *
 * @return   None.
 *
-* @note     None.
+* @note     The wheel reloads the job from its previous expiry, so the
+*           ticks do not drift however late the interrupt is serviced.
 *
 ******************************************************************************/
-void Timer_InterruptHandler(void *CallBackRef, u8 TmrCtrNumber)
+void Timer_InterruptHandler(void *CallBackRef)
+{
+    TimerWheel *WheelPtr = (TimerWheel *)CallBackRef;
+    
+    /* Increment interrupt counter */
+    InterruptCounter++;
+    
+    /* Log the interrupt, printed by the idle loop */
+    TraceLog_Event(TRACE_EV_TIMER_TICK, InterruptCounter, 0);
+    
+    /* Stop after certain number of interrupts: only this job, the
+     * counter keeps serving the rest of the wheel */
+    if (InterruptCounter >= TICK_COUNT_MAX) {
+        TraceLog_Event(TRACE_EV_TIMER_STOP, InterruptCounter, 0);
+        TimerWheel_Cancel(WheelPtr, &TickTimer);
+        TimerWheel_Cancel(WheelPtr, &PollTimer);
+        TimerStarted = 0;
+    }
+}
+
+/******************************************************************************/
+/**
+*
+* Background job, run every POLL_PERIOD ticks while the main tick runs.
+*
+* @param    CallBackRef is a pointer to the timer wheel
+*
+* @return   None.
+*
+******************************************************************************/
+void Poll_Handler(void *CallBackRef)
+{
+    (void)CallBackRef;
+    
+    PollCounter++;
+}
+
+/******************************************************************************/
+/**
+*
+* One-shot timeout, TIMEOUT_DELAY ticks after the wheel started.
+*
+* @param    CallBackRef is a pointer to the timer wheel
+*
+* @return   None.
+*
+******************************************************************************/
+void Timeout_Handler(void *CallBackRef)
+{
+    TimerWheel *WheelPtr = (TimerWheel *)CallBackRef;
+    
+    TraceLog_Event(TRACE_EV_TIMER_ONESHOT,
+                   (u32)TimerWheel_Now(WheelPtr), PollCounter);
+}
+
+/******************************************************************************/
+/**
+*
+* Timer interrupt service routine, connected to the interrupt controller in
+* place of XTmrCtr_InterruptHandler. It measures how long after expiry of
+* counter 0 the handler was entered and how long the handler ran.
+*
+* @param    CallBackRef is a pointer to the XTmrCtr instance
+*
+* @return   None.
+*
+* @note     The wheel runs counter 0 down with auto reload, so on entry it
+*           holds TLR0 less the ticks since reload: the latency is
+*           TLR0 - TCR0, plus the one clock the reload itself takes.
+*
+******************************************************************************/
+void Timer_Isr(void *CallBackRef)
 {
     XTmrCtr *InstancePtr = (XTmrCtr *)CallBackRef;
+    u32 Entry = Timestamp_Now();
+    u32 Csr = XTmrCtr_GetControlStatusReg(InstancePtr->BaseAddress,
+                                          TIMER_COUNTER_0);
     
-    /* Check if the interrupt is from the correct timer counter */
-    if (XTmrCtr_IsExpired(InstancePtr, TmrCtrNumber)) {
-        
-        /* Increment interrupt counter */
-        InterruptCounter++;
-        
-        /* Print interrupt message */
-        printf("Timer interrupt occurred! Count: %d\r\n", InterruptCounter);
-        
-        /* Clear the interrupt flag - IMPORTANT! */
-        /* This is done automatically by the driver for generate mode */
-        
-        /* Optional: Toggle an LED or perform other periodic tasks here */
-        
-        /* Optional: Stop after certain number of interrupts */
-        if (InterruptCounter >= 10) {
-            printf("Stopping timer after 10 interrupts\r\n");
-            XTmrCtr_Stop(InstancePtr, TmrCtrNumber);
-            TimerStarted = 0;
-        }
+    if (Csr & XTC_CSR_INT_OCCURED_MASK) {
+        LatencyHist_Record(&TimerLatencyHist,
+            XTmrCtr_GetLoadReg(InstancePtr->BaseAddress,
+                               TIMER_COUNTER_0) -
+            XTmrCtr_GetTimerCounterReg(InstancePtr->BaseAddress,
+                                       TIMER_COUNTER_0) + 1);
     }
+    
+    XTmrCtr_InterruptHandler(InstancePtr);
+    
+    LatencyHist_Record(&TimerExecHist, Timestamp_Now() - Entry);
+}
+
+/******************************************************************************/
+/**
+*
+* Prints the latency histograms of the timer interrupt and the timer wheel
+* statistics. Can be called at any time from task context.
+*
+* @param    None.
+*
+* @return   None.
+*
+******************************************************************************/
+void PrintLatencyReport(void)
+{
+    xil_printf("report at %d us of uptime\r\n",
+               (int)MonoClock_TicksToUs(MonoClock_Now()));
+    LatencyHist_Print(&TimerLatencyHist, TRUE);
+    LatencyHist_Print(&TimerExecHist, TRUE);
+    
+    TimerWheel_Stats Stats;
+    TimerWheel_GetStats(&Wheel, &Stats);
+    xil_printf("timer wheel: %d interrupts, %d expiries, %d cascades, "
+               "%d reloads of counter 0, background job ran %d times\r\n",
+               (int)Stats.Interrupts, (int)Stats.Expired,
+               (int)Stats.Cascaded, (int)Stats.Programs, PollCounter);
 }
 
 /******************************************************************************/
@@ -186,7 +339,7 @@ int ScuGicInterrupt_Init(u16 DeviceId, XTmrCtr *TimerInstancePtr)
      */
     Status = XScuGic_Connect(&InterruptController,
                             TIMER_INTERRUPT_ID,
-                            (Xil_ExceptionHandler)XTmrCtr_InterruptHandler,
+                            (Xil_ExceptionHandler)Timer_Isr,
                             (void *)TimerInstancePtr);
     if (Status != XST_SUCCESS) {
         return XST_FAILURE;
@@ -224,19 +377,29 @@ int main()
         cout << "timer counter initialization failed" ;
     }
     
-    // timer handler
-    XTmrCtr_SetHandler(&TimerInstancePtr, (XTmrCtr_Handler)Timer_InterruptHandler, &TimerInstancePtr);
-    
-    // initialize time pointer with value from xparameters.h file
-    unsigned int* timer_ptr = (unsigned int*)XPAR_AXI_TIMER_0_BASEADDR;
-    
-    // load tlr
-    *(timer_ptr + 1) = 0x00000000;
+    // the system clock timestamps the trace log, counter 0 is ours
+    xStatus = XTmrCtr_Initialize(&ClockTimer, CLOCK_TIMER_DEVICE_ID);
+    if(XST_SUCCESS != xStatus)
+    {
+        cout << "clock timer initialization failed" << endl;
+        return 1;
+    }
+    MonoClock_Initialize(&ClockTimer);
+    TraceLog_Init(TRACE_OUTPUT);
+    LatencyHist_Init(&TimerLatencyHist, "timer expiry to handler");
+    LatencyHist_Init(&TimerExecHist, "timer handler execution");
     
-    // timer counter configuration
-    // Configure timer in generate mode, count up, interrupt enabled
-    // with autoreload of load register
-    *(timer_ptr) = 0x0f4 ;
+    // timer wheel on counter 0, it installs its own timer handler
+    xStatus = TimerWheel_Initialize(&Wheel, &TimerInstancePtr, TIMER_COUNTER_0,
+                                    WHEEL_TICK_US, WHEEL_MODE);
+    if(XST_SUCCESS != xStatus)
+    {
+        cout << "timer wheel initialization failed" << endl;
+        return 1;
+    }
+    TimerWheel_InitTimer(&TickTimer, Timer_InterruptHandler, &Wheel);
+    TimerWheel_InitTimer(&PollTimer, Poll_Handler, &Wheel);
+    TimerWheel_InitTimer(&TimeoutTimer, Timeout_Handler, &Wheel);
     
     xStatus=
     ScuGicInterrupt_Init(XPAR_PS7_SCUGIC_0_DEVICE_ID, &TimerInstancePtr);
@@ -246,13 +409,27 @@ int main()
         return 1;
     }
     
-    *(timer_ptr) = 0x0d4 ;  // deassert the load 5 to allow the timer to start counting
+    // start counter 0 and the jobs
+    TimerWheel_Start(&Wheel);
+    TimerWheel_Arm(&Wheel, &TickTimer, TICK_PERIOD, TICK_PERIOD);
+    TimerWheel_Arm(&Wheel, &PollTimer, POLL_PERIOD, POLL_PERIOD);
+    TimerWheel_Arm(&Wheel, &TimeoutTimer, TIMEOUT_DELAY, 0);
+    TimerStarted = 1;
+    
+    // let the wheel run forever generating the job interrupts
     
-    // let timer run forever generating periodic interrupts
+    int Reported = 0;
     
     while(1)
     {
-        // infinite loop
+        // idle loop: output what the interrupt handler logged
+        TraceLog_Flush();
+        
+        // report the interrupt latency once the timer has stopped
+        if (InterruptCounter >= TICK_COUNT_MAX && !Reported) {
+            PrintLatencyReport();
+            Reported = 1;
+        }
     }
     
     return 0;
@@ -266,33 +443,13 @@ int main()
 ******************************************************************************/
 void Timer_DirectRegisterSetup(void)
 {
-    unsigned int *timer_ptr;
-    
-    /* Initialize timer pointer with base address from xparameters.h */
-    timer_ptr = (unsigned int *)XPAR_AXI_TIMER_0_BASEADDR;
-    
     /* Load Timer Load Register (TLR) with the reset value */
-    *(timer_ptr + 1) = TIMER_LOAD_VALUE;  /* TLR0 offset = 4 bytes */
-    
-    /* Configure Timer Control/Status Register (TCSR) */
-    /* Bit 11: CASC - Cascade mode (0 = no cascade)
-     * Bit 10: ENALL - Enable all timers (0 = use enable bit)
-     * Bit 9: PWMA - PWM mode (0 = generate mode)
-     * Bit 8: T0INT - Timer 0 interrupt flag (read/clear)
-     * Bit 7: ENT - Enable timer (1 = enable)
-     * Bit 6: ENIT - Enable interrupt (1 = enable)
-     * Bit 5: LOAD - Load timer (1 = load from TLR)
-     * Bit 4: ARHT - Auto reload (1 = auto reload)
-     * Bit 3: CAPT - Capture mode (0 = generate mode)
-     * Bit 2: GENT - Generate enable (0 = external generate)
-     * Bit 1: UDT - Up/Down count (0 = up)
-     * Bit 0: MDT - Mode (0 = generate, 1 = capture)
-     */
+    Timer0::TLR::Write(TLR_VALUE(TIMER_LOAD_VALUE));
     
     /* Configure timer in generate mode, count up, interrupt enabled */
-    /* with autoreload of load register */
-    *(timer_ptr) = 0x00D4;  /* TCSR0: Enable interrupt, auto-reload, load TLR */
+    /* with autoreload of load register, and load TLR into the counter */
+    Timer0::TCSR::Write<TCSR_ENIT | TCSR_LOAD | TCSR_ARHT | TCSR_GENT>();
     
-    /* Deassert the load bit to allow the timer to start counting */
-    *(timer_ptr) = 0x00C4;  /* TCSR0: Clear load bit, keep other settings */
+    /* Deassert the load bit and enable the timer, keep other settings */
+    Timer0::TCSR::Write<TCSR_ENT | TCSR_ENIT | TCSR_ARHT | TCSR_GENT>();
 }
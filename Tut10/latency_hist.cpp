@@ -0,0 +1,185 @@
+/******************************************************************************
+* Log-bucketed latency histograms
+*
+* The recording fast path is inline in latency_hist.h. This file holds the
+* queries, which are called from task context.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xil_exception.h"
+#include "xil_printf.h"
+#include "latency_hist.h"
+#include "timestamp.h"
+
+/************************** Function Prototypes ******************************/
+
+static u32 LatencyHist_BucketLimit(u32 Bucket);
+
+/*****************************************************************************/
+/**
+*
+* Empties a histogram.
+*
+* @param	HistPtr is a pointer to the histogram.
+* @param	Name is printed by LatencyHist_Print. The string is not
+*		copied.
+*
+* @return	None.
+*
+******************************************************************************/
+void LatencyHist_Init(LatencyHist *HistPtr, const char8 *Name)
+{
+	u32 Index;
+
+	HistPtr->Name = Name;
+	HistPtr->Samples = 0U;
+	HistPtr->Min = 0xFFFFFFFFU;
+	HistPtr->Max = 0U;
+	HistPtr->Total = 0U;
+	for (Index = 0U; Index < LATENCY_HIST_BUCKETS; Index++) {
+		HistPtr->Count[Index] = 0U;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns a percentile of the recorded intervals.
+*
+* @param	HistPtr is a pointer to the histogram.
+* @param	PerMille is the percentile in tenths of a percent, e.g. 990
+*		for p99.
+*
+* @return	Upper bound of the bucket holding the percentile, at most the
+*		maximum recorded, in timer clock ticks. 0 if the histogram is
+*		empty.
+*
+* @note		Not synchronized with the recording side, see
+*		LatencyHist_GetSummary.
+*
+******************************************************************************/
+u32 LatencyHist_Percentile(LatencyHist *HistPtr, u32 PerMille)
+{
+	u64 Target;
+	u64 Seen = 0U;
+	u32 Index;
+	u32 Limit;
+
+	if (HistPtr->Samples == 0U) {
+		return 0U;
+	}
+
+	Target = ((u64)HistPtr->Samples * PerMille + 999U) / 1000U;
+	if (Target == 0U) {
+		Target = 1U;
+	}
+
+	for (Index = 0U; Index < LATENCY_HIST_BUCKETS; Index++) {
+		Seen += HistPtr->Count[Index];
+		if (Seen >= Target) {
+			break;
+		}
+	}
+
+	Limit = LatencyHist_BucketLimit(Index);
+	return (Limit < HistPtr->Max) ? Limit : HistPtr->Max;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns minimum, mean, p99 and maximum of the recorded intervals. The
+* histogram is read with interrupts masked, so the figures are consistent
+* even while an interrupt handler keeps recording.
+*
+* @param	HistPtr is a pointer to the histogram.
+* @param	SummaryPtr is where the summary is returned, in timer clock
+*		ticks. All zero if the histogram is empty.
+*
+* @return	None.
+*
+******************************************************************************/
+void LatencyHist_GetSummary(LatencyHist *HistPtr,
+			    LatencyHist_Summary *SummaryPtr)
+{
+	Xil_ExceptionDisable();
+
+	SummaryPtr->Samples = HistPtr->Samples;
+	if (HistPtr->Samples == 0U) {
+		SummaryPtr->Min = 0U;
+		SummaryPtr->Mean = 0U;
+		SummaryPtr->P99 = 0U;
+		SummaryPtr->Max = 0U;
+	} else {
+		SummaryPtr->Min = HistPtr->Min;
+		SummaryPtr->Mean = (u32)(HistPtr->Total / HistPtr->Samples);
+		SummaryPtr->P99 = LatencyHist_Percentile(HistPtr, 990U);
+		SummaryPtr->Max = HistPtr->Max;
+	}
+
+	Xil_ExceptionEnable();
+}
+
+/*****************************************************************************/
+/**
+*
+* Prints the summary of a histogram in nanoseconds and, optionally, every
+* non-empty bucket.
+*
+* @param	HistPtr is a pointer to the histogram.
+* @param	Buckets is non-zero to print the buckets as well.
+*
+* @return	None.
+*
+******************************************************************************/
+void LatencyHist_Print(LatencyHist *HistPtr, int Buckets)
+{
+	LatencyHist_Summary Summary;
+	u32 Index;
+
+	LatencyHist_GetSummary(HistPtr, &Summary);
+
+	xil_printf("%s: %d samples, min %d ns, mean %d ns, p99 %d ns, "
+		   "max %d ns\r\n", HistPtr->Name, (int)Summary.Samples,
+		   (int)Timestamp_TicksToNs(Summary.Min),
+		   (int)Timestamp_TicksToNs(Summary.Mean),
+		   (int)Timestamp_TicksToNs(Summary.P99),
+		   (int)Timestamp_TicksToNs(Summary.Max));
+
+	if (!Buckets) {
+		return;
+	}
+
+	for (Index = 0U; Index < LATENCY_HIST_BUCKETS; Index++) {
+		if (HistPtr->Count[Index] == 0U) {
+			continue;
+		}
+		xil_printf("  <= %10d ns: %d\r\n",
+			   (int)Timestamp_TicksToNs(
+				LatencyHist_BucketLimit(Index)),
+			   (int)HistPtr->Count[Index]);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the largest value that falls in a bucket.
+*
+******************************************************************************/
+static u32 LatencyHist_BucketLimit(u32 Bucket)
+{
+	u32 Group = Bucket >> LATENCY_HIST_SUB_BITS;
+	u32 Sub = Bucket & (LATENCY_HIST_SUB_COUNT - 1U);
+	u32 Width;
+	u32 Lower;
+
+	if (Group == 0U) {
+		return Bucket;
+	}
+
+	Width = 1U << (Group - 1U);
+	Lower = (1U << (Group + LATENCY_HIST_SUB_BITS - 1U)) + (Sub * Width);
+	return Lower + (Width - 1U);
+}
@@ -0,0 +1,111 @@
+/******************************************************************************
+* Log-bucketed latency histograms
+*
+* Records intervals measured with Timestamp_Now, in timer clock ticks, into
+* a fixed histogram whose buckets double in width every four buckets: each
+* power of two is split into four sub-buckets, so any recorded value is
+* known to within 25% (exactly below 4 ticks) over the full 32-bit range in
+* 124 counters. Recording is a count-leading-zeros and a few adds, cheap
+* enough to run at the start and end of every interrupt handler:
+*
+*	Entry = Timestamp_Now();
+*	...
+*	LatencyHist_Record(&IsrExecHist, Timestamp_Now() - Entry);
+*
+* Minimum, maximum and mean are exact; percentiles are reported as the upper
+* bound of the bucket they fall in, capped at the maximum, so they never
+* understate the latency.
+******************************************************************************/
+
+#ifndef LATENCY_HIST_H		/* prevent circular inclusions */
+#define LATENCY_HIST_H
+
+/***************************** Include Files *********************************/
+
+#include "xil_types.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Sub-buckets per power of two, as a number of bits */
+#define LATENCY_HIST_SUB_BITS		2U
+#define LATENCY_HIST_SUB_COUNT		(1U << LATENCY_HIST_SUB_BITS)
+
+/* Buckets needed for the whole 32-bit range */
+#define LATENCY_HIST_BUCKETS \
+	((32U - LATENCY_HIST_SUB_BITS + 1U) * LATENCY_HIST_SUB_COUNT)
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	const char8 *Name;		/**< Printed by LatencyHist_Print */
+	u32 Samples;
+	u32 Min;
+	u32 Max;
+	u64 Total;
+	u32 Count[LATENCY_HIST_BUCKETS];
+} LatencyHist;
+
+typedef struct {
+	u32 Samples;
+	u32 Min;			/**< All in timer clock ticks */
+	u32 Mean;
+	u32 P99;
+	u32 Max;
+} LatencyHist_Summary;
+
+/************************** Function Prototypes ******************************/
+
+void LatencyHist_Init(LatencyHist *HistPtr, const char8 *Name);
+u32 LatencyHist_Percentile(LatencyHist *HistPtr, u32 PerMille);
+void LatencyHist_GetSummary(LatencyHist *HistPtr,
+			    LatencyHist_Summary *SummaryPtr);
+void LatencyHist_Print(LatencyHist *HistPtr, int Buckets);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/*****************************************************************************/
+/**
+*
+* Returns the bucket holding Value.
+*
+******************************************************************************/
+static inline u32 LatencyHist_Bucket(u32 Value)
+{
+	u32 Msb;
+
+	if (Value < LATENCY_HIST_SUB_COUNT) {
+		return Value;
+	}
+
+	Msb = 31U - (u32)__builtin_clz(Value);
+	return ((Msb - LATENCY_HIST_SUB_BITS + 1U) << LATENCY_HIST_SUB_BITS) +
+	       ((Value >> (Msb - LATENCY_HIST_SUB_BITS)) &
+		(LATENCY_HIST_SUB_COUNT - 1U));
+}
+
+/*****************************************************************************/
+/**
+*
+* Records one interval. Call it from a single context per histogram, or
+* with interrupts masked.
+*
+* @param	HistPtr is a pointer to the histogram.
+* @param	Ticks is the interval in timer clock ticks.
+*
+* @return	None.
+*
+******************************************************************************/
+static inline void LatencyHist_Record(LatencyHist *HistPtr, u32 Ticks)
+{
+	if (Ticks < HistPtr->Min) {
+		HistPtr->Min = Ticks;
+	}
+	if (Ticks > HistPtr->Max) {
+		HistPtr->Max = Ticks;
+	}
+	HistPtr->Total += Ticks;
+	HistPtr->Samples++;
+	HistPtr->Count[LatencyHist_Bucket(Ticks)]++;
+}
+
+#endif	/* end of protection macro */
@@ -0,0 +1,170 @@
+/******************************************************************************
+* Monotonic 64-bit clock on a cascaded AXI Timer
+*
+* See mono_clock.h for the design.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "mono_clock.h"
+#include "timestamp.h"
+
+/************************** Constant Definitions *****************************/
+
+#define NS_PER_SECOND		1000000000ULL
+#define US_PER_SECOND		1000000ULL
+
+/************************** Variable Definitions *****************************/
+
+UINTPTR MonoClock_LowAddr;
+UINTPTR MonoClock_HighAddr;
+u32 MonoClock_ClockHz;
+
+/* Nanoseconds per tick when that is a whole number, 0 otherwise */
+static u64 NsPerTick;
+
+/*****************************************************************************/
+/**
+*
+* Starts both counters of the timer as one cascaded 64-bit up counter from
+* zero, with no interrupt, and makes its low word the timestamp counter of
+* timestamp.h.
+*
+* @param	TmrCtrPtr is a pointer to an initialized XTmrCtr instance.
+*		Both counters are taken over.
+*
+* @return	None.
+*
+* @note		The registers are written directly: XTmrCtr_Start writes
+*		TCSR0 with LOAD alone, which would drop CASC while loading.
+*
+******************************************************************************/
+void MonoClock_Initialize(XTmrCtr *TmrCtrPtr)
+{
+	UINTPTR BaseAddr = TmrCtrPtr->BaseAddress;
+
+	XTmrCtr_WriteReg(BaseAddr, MONO_CLOCK_LOW_COUNTER, XTC_TCSR_OFFSET, 0U);
+	XTmrCtr_WriteReg(BaseAddr, MONO_CLOCK_HIGH_COUNTER, XTC_TCSR_OFFSET, 0U);
+	XTmrCtr_WriteReg(BaseAddr, MONO_CLOCK_LOW_COUNTER, XTC_TLR_OFFSET, 0U);
+	XTmrCtr_WriteReg(BaseAddr, MONO_CLOCK_HIGH_COUNTER, XTC_TLR_OFFSET, 0U);
+
+	/* Load both words, then run; TCSR0 controls the pair */
+	XTmrCtr_WriteReg(BaseAddr, MONO_CLOCK_LOW_COUNTER, XTC_TCSR_OFFSET,
+			 XTC_CSR_CASC_MASK | XTC_CSR_LOAD_MASK);
+	XTmrCtr_WriteReg(BaseAddr, MONO_CLOCK_LOW_COUNTER, XTC_TCSR_OFFSET,
+			 XTC_CSR_CASC_MASK | XTC_CSR_ENABLE_TMR_MASK);
+
+	MonoClock_ClockHz = TmrCtrPtr->Config.SysClockFreqHz;
+	MonoClock_LowAddr = BaseAddr +
+			    XTmrCtr_Offsets[MONO_CLOCK_LOW_COUNTER] +
+			    XTC_TCR_OFFSET;
+	MonoClock_HighAddr = BaseAddr +
+			     XTmrCtr_Offsets[MONO_CLOCK_HIGH_COUNTER] +
+			     XTC_TCR_OFFSET;
+	NsPerTick = ((NS_PER_SECOND % MonoClock_ClockHz) == 0U) ?
+		    NS_PER_SECOND / MonoClock_ClockHz : 0U;
+
+	/* Everything stamped with Timestamp_Now shares this timebase */
+	Timestamp_ClockHz = MonoClock_ClockHz;
+	Timestamp_CounterAddr = MonoClock_LowAddr;
+}
+
+/*
+ * Scales a tick count to a unit of PerSecond per second without overflow:
+ * whole seconds and the remainder are scaled apart, the remainder times
+ * PerSecond stays below 2^62.
+ */
+static u64 ScaleTicks(u64 Ticks, u64 PerSecond)
+{
+	return (Ticks / MonoClock_ClockHz) * PerSecond +
+	       ((Ticks % MonoClock_ClockHz) * PerSecond) / MonoClock_ClockHz;
+}
+
+/* The reverse of ScaleTicks */
+static u64 ScaleToTicks(u64 Value, u64 PerSecond)
+{
+	return (Value / PerSecond) * MonoClock_ClockHz +
+	       ((Value % PerSecond) * MonoClock_ClockHz) / PerSecond;
+}
+
+/*****************************************************************************/
+/**
+*
+* Converts clock ticks to nanoseconds, rounding down.
+*
+* @param	Ticks is a MonoClock_Now value or a difference of two.
+*
+* @return	The time in nanoseconds.
+*
+* @note		A single multiply when a tick is a whole number of
+*		nanoseconds, as at 100 MHz.
+*
+******************************************************************************/
+u64 MonoClock_TicksToNs(u64 Ticks)
+{
+	if (NsPerTick != 0U) {
+		return Ticks * NsPerTick;
+	}
+	return ScaleTicks(Ticks, NS_PER_SECOND);
+}
+
+/*****************************************************************************/
+/**
+*
+* Converts clock ticks to microseconds, rounding down.
+*
+* @param	Ticks is a MonoClock_Now value or a difference of two.
+*
+* @return	The time in microseconds.
+*
+******************************************************************************/
+u64 MonoClock_TicksToUs(u64 Ticks)
+{
+	return ScaleTicks(Ticks, US_PER_SECOND);
+}
+
+/*****************************************************************************/
+/**
+*
+* Converts nanoseconds to clock ticks, rounding down.
+*
+* @param	Ns is a time in nanoseconds.
+*
+* @return	The time in clock ticks.
+*
+******************************************************************************/
+u64 MonoClock_NsToTicks(u64 Ns)
+{
+	if (NsPerTick != 0U) {
+		return Ns / NsPerTick;
+	}
+	return ScaleToTicks(Ns, NS_PER_SECOND);
+}
+
+/*****************************************************************************/
+/**
+*
+* Converts microseconds to clock ticks, rounding down.
+*
+* @param	Us is a time in microseconds.
+*
+* @return	The time in clock ticks.
+*
+******************************************************************************/
+u64 MonoClock_UsToTicks(u64 Us)
+{
+	return ScaleToTicks(Us, US_PER_SECOND);
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads the clock in nanoseconds.
+*
+* @return	The time since MonoClock_Initialize, in nanoseconds.
+*
+******************************************************************************/
+u64 MonoClock_NowNs(void)
+{
+	return MonoClock_TicksToNs(MonoClock_Now());
+}
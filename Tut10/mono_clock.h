@@ -0,0 +1,89 @@
+/******************************************************************************
+* Monotonic 64-bit clock on a cascaded AXI Timer
+*
+* Runs both counters of an AXI Timer in cascade mode (CASC), as one 64-bit
+* up counter at the timer clock: counter 0 is the low word and counter 1
+* the high word, which the hardware steps when the low word wraps. At
+* 100 MHz the clock wraps after more than 5000 years, so its values can be
+* compared and subtracted without any care:
+*
+*	MonoClock_Initialize(&ClockTimer);
+*	Start = MonoClock_Now();
+*	...
+*	Elapsed = MonoClock_TicksToNs(MonoClock_Now() - Start);
+*
+* The two words cannot be read in one AXI transaction. MonoClock_Now reads
+* high, low, high and retries if the high word moved, which can only happen
+* once in 2^32 clocks, so a read costs three bus reads, takes no lock and
+* is safe in interrupt handlers and tasks alike.
+*
+* MonoClock_Initialize also makes the low word the timestamp counter of
+* timestamp.h, in place of Timestamp_Initialize, so Timestamp_Now, the
+* trace log, the latency histograms and everything else stamped with it
+* run on this same timebase: a Timestamp_Now value is the low 32 bits of
+* MonoClock_Now.
+******************************************************************************/
+
+#ifndef MONO_CLOCK_H		/* prevent circular inclusions */
+#define MONO_CLOCK_H
+
+/***************************** Include Files *********************************/
+
+#include "xil_types.h"
+#include "xil_io.h"
+#include "xtmrctr.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Counters holding the low and the high word */
+#define MONO_CLOCK_LOW_COUNTER		0U
+#define MONO_CLOCK_HIGH_COUNTER		1U
+
+/************************** Variable Definitions *****************************/
+
+/* Addresses of the TCRs of both words, set by MonoClock_Initialize */
+extern UINTPTR MonoClock_LowAddr;
+extern UINTPTR MonoClock_HighAddr;
+extern u32 MonoClock_ClockHz;
+
+/************************** Function Prototypes ******************************/
+
+void MonoClock_Initialize(XTmrCtr *TmrCtrPtr);
+u64 MonoClock_TicksToNs(u64 Ticks);
+u64 MonoClock_TicksToUs(u64 Ticks);
+u64 MonoClock_NsToTicks(u64 Ns);
+u64 MonoClock_UsToTicks(u64 Us);
+u64 MonoClock_NowNs(void);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/*****************************************************************************/
+/**
+*
+* Reads the clock.
+*
+* @return	The time since MonoClock_Initialize, in timer clock ticks.
+*
+* @note		The high word is read before and after the low word; if it
+*		changed, the low word wrapped in between and is read again.
+*
+******************************************************************************/
+static inline u64 MonoClock_Now(void)
+{
+	u32 High = Xil_In32(MonoClock_HighAddr);
+	u32 Low;
+	u32 Check;
+
+	for (;;) {
+		Low = Xil_In32(MonoClock_LowAddr);
+		Check = Xil_In32(MonoClock_HighAddr);
+		if (Check == High) {
+			break;
+		}
+		High = Check;
+	}
+
+	return ((u64)High << 32) | Low;
+}
+
+#endif	/* end of protection macro */
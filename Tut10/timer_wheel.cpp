@@ -0,0 +1,618 @@
+/******************************************************************************
+* Hierarchical timer wheel on one AXI Timer counter
+*
+* See timer_wheel.h for the design. Tick numbers are derived from
+* Timestamp_Now, so Timestamp_Initialize (on the same XTmrCtr instance) or
+* MonoClock_Initialize must have been called before TimerWheel_Start.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xstatus.h"
+#include "xil_exception.h"
+#include "timer_wheel.h"
+#include "timestamp.h"
+
+/************************** Function Prototypes ******************************/
+
+static void TimerWheel_Lock(TimerWheel *WheelPtr);
+static void TimerWheel_Unlock(TimerWheel *WheelPtr);
+static u64 TimerWheel_Update(TimerWheel *WheelPtr);
+static void TimerWheel_Insert(TimerWheel *WheelPtr,
+			      TimerWheel_Timer *TimerPtr);
+static void TimerWheel_Remove(TimerWheel *WheelPtr,
+			      TimerWheel_Timer *TimerPtr);
+static void TimerWheel_Detach(TimerWheel *WheelPtr, u32 Level, u32 Index,
+			      TimerWheel_Node *ListPtr);
+static u64 TimerWheel_Next(TimerWheel *WheelPtr);
+static void TimerWheel_Step(TimerWheel *WheelPtr);
+static void TimerWheel_Program(TimerWheel *WheelPtr, u32 Load);
+static void TimerWheel_Reprogram(TimerWheel *WheelPtr);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+#define TIMER_WHEEL_SHIFT(Level)	((Level) * TIMER_WHEEL_SLOT_BITS)
+
+/*****************************************************************************/
+/**
+*
+* Initializes an empty wheel and takes over the interrupt handler of the
+* timer instance. The counter is not started until TimerWheel_Start.
+*
+* @param	WheelPtr is a pointer to the wheel.
+* @param	TmrCtrPtr is a pointer to the initialized XTmrCtr instance.
+*		Its interrupt must be connected to XTmrCtr_InterruptHandler.
+* @param	TmrCtrNumber is the counter the wheel runs on. It cannot be
+*		TIMESTAMP_COUNTER, which the wheel reads its time from.
+* @param	TickUs is the wheel tick, in microseconds.
+* @param	Mode is TIMER_WHEEL_PERIODIC or TIMER_WHEEL_TICKLESS.
+*
+* @return
+*		- XST_SUCCESS if the wheel was initialized
+*		- XST_INVALID_PARAM if the counter is the timestamp counter or
+*		the tick is shorter than the minimum tickless interval or
+*		longer than the timestamp counter can measure
+*
+******************************************************************************/
+int TimerWheel_Initialize(TimerWheel *WheelPtr, XTmrCtr *TmrCtrPtr,
+			  u8 TmrCtrNumber, u32 TickUs, u32 Mode)
+{
+	u64 TickClocks;
+	u32 Level;
+	u32 Index;
+
+	TickClocks = ((u64)TmrCtrPtr->Config.SysClockFreqHz * TickUs) /
+		     1000000U;
+	if ((TmrCtrNumber == TIMESTAMP_COUNTER) ||
+	    (TickClocks < TIMER_WHEEL_MIN_SLEEP) ||
+	    (TickClocks > TIMER_WHEEL_MAX_SLEEP)) {
+		return XST_INVALID_PARAM;
+	}
+
+	WheelPtr->TmrCtrPtr = TmrCtrPtr;
+	WheelPtr->TmrCtrNumber = TmrCtrNumber;
+	WheelPtr->Mode = Mode;
+	WheelPtr->TickClocks = (u32)TickClocks;
+	WheelPtr->Base = 0U;
+	WheelPtr->Programmed = TIMER_WHEEL_NEVER;
+	WheelPtr->Clock = 0U;
+	WheelPtr->Origin = 0U;
+	WheelPtr->LastStamp = 0U;
+	WheelPtr->InHandler = FALSE;
+
+	for (Level = 0U; Level < TIMER_WHEEL_LEVELS; Level++) {
+		WheelPtr->Pending[Level] = 0U;
+		for (Index = 0U; Index < TIMER_WHEEL_SLOTS; Index++) {
+			WheelPtr->Slot[Level][Index].Next =
+				&WheelPtr->Slot[Level][Index];
+			WheelPtr->Slot[Level][Index].Prev =
+				&WheelPtr->Slot[Level][Index];
+		}
+	}
+
+	WheelPtr->Stats.Interrupts = 0U;
+	WheelPtr->Stats.Expired = 0U;
+	WheelPtr->Stats.Cascaded = 0U;
+	WheelPtr->Stats.Programs = 0U;
+
+	XTmrCtr_SetHandler(TmrCtrPtr, TimerWheel_InterruptHandler, WheelPtr);
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Makes now tick 0 and starts the counter: every tick in periodic mode, at
+* the first expiry in tickless mode. Timers are armed after the start.
+*
+* @param	WheelPtr is a pointer to the wheel.
+*
+* @return	None.
+*
+******************************************************************************/
+void TimerWheel_Start(TimerWheel *WheelPtr)
+{
+	Xil_ExceptionDisable();
+
+	WheelPtr->LastStamp = Timestamp_Now();
+	WheelPtr->Clock = WheelPtr->LastStamp;
+	WheelPtr->Origin = WheelPtr->Clock;
+
+	if (WheelPtr->Mode == TIMER_WHEEL_PERIODIC) {
+		TimerWheel_Program(WheelPtr, WheelPtr->TickClocks - 2U);
+	} else {
+		TimerWheel_Reprogram(WheelPtr);
+	}
+
+	Xil_ExceptionEnable();
+}
+
+/*****************************************************************************/
+/**
+*
+* Initializes a timer, which is not armed.
+*
+* @param	TimerPtr is a pointer to the timer.
+* @param	Handler is called, in the timer interrupt, when it expires.
+* @param	CallBackRef is passed to the handler.
+*
+* @return	None.
+*
+******************************************************************************/
+void TimerWheel_InitTimer(TimerWheel_Timer *TimerPtr,
+			  TimerWheel_Handler Handler, void *CallBackRef)
+{
+	TimerPtr->Node.Next = &TimerPtr->Node;
+	TimerPtr->Node.Prev = &TimerPtr->Node;
+	TimerPtr->Expires = 0U;
+	TimerPtr->Period = 0U;
+	TimerPtr->Slot = TIMER_WHEEL_IDLE;
+	TimerPtr->Handler = Handler;
+	TimerPtr->CallBackRef = CallBackRef;
+}
+
+/*****************************************************************************/
+/**
+*
+* Arms a timer, re-arming it if it is already armed.
+*
+* @param	WheelPtr is a pointer to the wheel.
+* @param	TimerPtr is a pointer to an initialized timer.
+* @param	Delay is the number of ticks from now to the first expiry.
+*		0 expires at the next interrupt.
+* @param	Period is the number of ticks between later expiries,
+*		counted from the previous expiry, or 0 for a one-shot timer.
+*
+* @return	None.
+*
+* @note		Task context or a timer handler. In tickless mode the counter
+*		is reprogrammed if the timer is now the first to expire.
+*
+******************************************************************************/
+void TimerWheel_Arm(TimerWheel *WheelPtr, TimerWheel_Timer *TimerPtr,
+		    u32 Delay, u32 Period)
+{
+	TimerWheel_Lock(WheelPtr);
+
+	if (TimerPtr->Slot != TIMER_WHEEL_IDLE) {
+		TimerWheel_Remove(WheelPtr, TimerPtr);
+	}
+
+	TimerPtr->Expires = TimerWheel_Update(WheelPtr) + Delay;
+	TimerPtr->Period = Period;
+	TimerWheel_Insert(WheelPtr, TimerPtr);
+
+	if ((WheelPtr->Mode == TIMER_WHEEL_TICKLESS) && !WheelPtr->InHandler &&
+	    (TimerWheel_Next(WheelPtr) < WheelPtr->Programmed)) {
+		TimerWheel_Reprogram(WheelPtr);
+	}
+
+	TimerWheel_Unlock(WheelPtr);
+}
+
+/*****************************************************************************/
+/**
+*
+* Disarms a timer. A periodic timer may cancel itself from its handler.
+*
+* @param	WheelPtr is a pointer to the wheel.
+* @param	TimerPtr is a pointer to the timer.
+*
+* @return	TRUE if the timer was armed, FALSE if it had already expired
+*		or was never armed.
+*
+* @note		The counter is not reprogrammed: in tickless mode an interrupt
+*		the timer would have needed may still come and find nothing
+*		to do.
+*
+******************************************************************************/
+int TimerWheel_Cancel(TimerWheel *WheelPtr, TimerWheel_Timer *TimerPtr)
+{
+	int Armed = FALSE;
+
+	TimerWheel_Lock(WheelPtr);
+
+	if (TimerPtr->Slot != TIMER_WHEEL_IDLE) {
+		TimerWheel_Remove(WheelPtr, TimerPtr);
+		Armed = TRUE;
+	}
+
+	TimerWheel_Unlock(WheelPtr);
+
+	return Armed;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the current tick, counted from TimerWheel_Start.
+*
+* @param	WheelPtr is a pointer to the wheel.
+*
+* @return	The tick number.
+*
+******************************************************************************/
+u64 TimerWheel_Now(TimerWheel *WheelPtr)
+{
+	u64 Now;
+
+	TimerWheel_Lock(WheelPtr);
+	Now = TimerWheel_Update(WheelPtr);
+	TimerWheel_Unlock(WheelPtr);
+
+	return Now;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the first tick at which the wheel has work: a timer expiry or a
+* cascade of a coarse slot. Tickless mode programs the counter for it.
+*
+* @param	WheelPtr is a pointer to the wheel.
+*
+* @return	The tick number, or TIMER_WHEEL_NEVER if no timer is armed.
+*
+******************************************************************************/
+u64 TimerWheel_NextExpiry(TimerWheel *WheelPtr)
+{
+	u64 Next;
+
+	TimerWheel_Lock(WheelPtr);
+	Next = TimerWheel_Next(WheelPtr);
+	TimerWheel_Unlock(WheelPtr);
+
+	return Next;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns a consistent copy of the wheel statistics.
+*
+* @param	WheelPtr is a pointer to the wheel.
+* @param	StatsPtr is where the statistics are returned.
+*
+* @return	None.
+*
+******************************************************************************/
+void TimerWheel_GetStats(TimerWheel *WheelPtr, TimerWheel_Stats *StatsPtr)
+{
+	TimerWheel_Lock(WheelPtr);
+	*StatsPtr = WheelPtr->Stats;
+	TimerWheel_Unlock(WheelPtr);
+}
+
+/*****************************************************************************/
+/**
+*
+* Timer counter callback, installed by TimerWheel_Initialize. Runs every
+* tick up to now that has work, calling the handlers of the timers that
+* expired, then in tickless mode programs the counter for the next expiry.
+*
+* @param	CallBackRef is a pointer to the wheel.
+* @param	TmrCtrNumber is the counter that interrupted.
+*
+* @return	None.
+*
+* @note		Ticks without work are skipped rather than stepped through,
+*		so catching up after a long sleep costs one step per expiry
+*		or cascade, not one per tick.
+*
+******************************************************************************/
+void TimerWheel_InterruptHandler(void *CallBackRef, u8 TmrCtrNumber)
+{
+	TimerWheel *WheelPtr = (TimerWheel *)CallBackRef;
+	u64 Now;
+	u64 Next;
+
+	if (TmrCtrNumber != WheelPtr->TmrCtrNumber) {
+		return;
+	}
+
+	WheelPtr->InHandler = TRUE;
+	WheelPtr->Stats.Interrupts++;
+
+	Now = TimerWheel_Update(WheelPtr);
+	while (WheelPtr->Base <= Now) {
+		Next = TimerWheel_Next(WheelPtr);
+		if (Next > Now) {
+			WheelPtr->Base = Now + 1U;
+			break;
+		}
+		WheelPtr->Base = Next;
+		TimerWheel_Step(WheelPtr);
+	}
+
+	if (WheelPtr->Mode == TIMER_WHEEL_TICKLESS) {
+		TimerWheel_Reprogram(WheelPtr);
+	}
+
+	WheelPtr->InHandler = FALSE;
+}
+
+/*****************************************************************************/
+/**
+*
+* Masks interrupts around a wheel update from task context. Timer handlers
+* already run with interrupts masked and must not unmask them.
+*
+******************************************************************************/
+static void TimerWheel_Lock(TimerWheel *WheelPtr)
+{
+	if (!WheelPtr->InHandler) {
+		Xil_ExceptionDisable();
+	}
+}
+
+static void TimerWheel_Unlock(TimerWheel *WheelPtr)
+{
+	if (!WheelPtr->InHandler) {
+		Xil_ExceptionEnable();
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Folds the timestamp counter into the 64-bit clock and returns the current
+* tick. The counter wraps every 2^32 clocks; the wheel reads it at least
+* every TIMER_WHEEL_MAX_SLEEP clocks, so no wrap is missed.
+*
+******************************************************************************/
+static u64 TimerWheel_Update(TimerWheel *WheelPtr)
+{
+	u32 Stamp = Timestamp_Now();
+
+	WheelPtr->Clock += (u32)(Stamp - WheelPtr->LastStamp);
+	WheelPtr->LastStamp = Stamp;
+
+	return (WheelPtr->Clock - WheelPtr->Origin) / WheelPtr->TickClocks;
+}
+
+/*****************************************************************************/
+/**
+*
+* Links a timer into the slot of the finest level that reaches its expiry,
+* relative to the next tick to process. An expiry in the past goes to that
+* tick, one beyond the range of the wheel to the last slot it reaches, from
+* where it is cascaded again. Expires itself is never changed, so periodic
+* timers keep their phase.
+*
+******************************************************************************/
+static void TimerWheel_Insert(TimerWheel *WheelPtr, TimerWheel_Timer *TimerPtr)
+{
+	u64 Due = TimerPtr->Expires;
+	u64 Delta;
+	u32 Level;
+	u32 Index;
+	TimerWheel_Node *SlotPtr;
+
+	if (Due < WheelPtr->Base) {
+		Due = WheelPtr->Base;
+	}
+
+	Delta = Due - WheelPtr->Base;
+	if (Delta >= TIMER_WHEEL_RANGE) {
+		Delta = TIMER_WHEEL_RANGE - 1U;
+		Due = WheelPtr->Base + Delta;
+	}
+
+	Level = (Delta < TIMER_WHEEL_SLOTS) ? 0U :
+		(63U - (u32)__builtin_clzll(Delta)) / TIMER_WHEEL_SLOT_BITS;
+	Index = (u32)(Due >> TIMER_WHEEL_SHIFT(Level)) &
+		(TIMER_WHEEL_SLOTS - 1U);
+
+	SlotPtr = &WheelPtr->Slot[Level][Index];
+	TimerPtr->Node.Next = SlotPtr;
+	TimerPtr->Node.Prev = SlotPtr->Prev;
+	SlotPtr->Prev->Next = &TimerPtr->Node;
+	SlotPtr->Prev = &TimerPtr->Node;
+
+	WheelPtr->Pending[Level] |= 1ULL << Index;
+	TimerPtr->Slot = (u16)((Level << TIMER_WHEEL_SLOT_BITS) | Index);
+}
+
+/*****************************************************************************/
+/**
+*
+* Unlinks an armed timer, from its slot or from the list of a step in
+* progress, and clears the slot bit if the slot is now empty.
+*
+******************************************************************************/
+static void TimerWheel_Remove(TimerWheel *WheelPtr, TimerWheel_Timer *TimerPtr)
+{
+	u32 Level = (u32)TimerPtr->Slot >> TIMER_WHEEL_SLOT_BITS;
+	u32 Index = (u32)TimerPtr->Slot & (TIMER_WHEEL_SLOTS - 1U);
+	TimerWheel_Node *SlotPtr = &WheelPtr->Slot[Level][Index];
+
+	TimerPtr->Node.Prev->Next = TimerPtr->Node.Next;
+	TimerPtr->Node.Next->Prev = TimerPtr->Node.Prev;
+	TimerPtr->Node.Next = &TimerPtr->Node;
+	TimerPtr->Node.Prev = &TimerPtr->Node;
+	TimerPtr->Slot = TIMER_WHEEL_IDLE;
+
+	if (SlotPtr->Next == SlotPtr) {
+		WheelPtr->Pending[Level] &= ~(1ULL << Index);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Moves the whole list of a slot to ListPtr and marks the slot empty. The
+* timers keep their Slot, so a handler cancelling one still finds it.
+*
+******************************************************************************/
+static void TimerWheel_Detach(TimerWheel *WheelPtr, u32 Level, u32 Index,
+			      TimerWheel_Node *ListPtr)
+{
+	TimerWheel_Node *SlotPtr = &WheelPtr->Slot[Level][Index];
+
+	if (SlotPtr->Next == SlotPtr) {
+		ListPtr->Next = ListPtr;
+		ListPtr->Prev = ListPtr;
+		return;
+	}
+
+	ListPtr->Next = SlotPtr->Next;
+	ListPtr->Prev = SlotPtr->Prev;
+	ListPtr->Next->Prev = ListPtr;
+	ListPtr->Prev->Next = ListPtr;
+	SlotPtr->Next = SlotPtr;
+	SlotPtr->Prev = SlotPtr;
+
+	WheelPtr->Pending[Level] &= ~(1ULL << Index);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the first tick from Base that has work. On level 0 that is the
+* first non-empty slot; on a coarser level it is the tick at which the
+* first non-empty slot is cascaded, the start of its span.
+*
+******************************************************************************/
+static u64 TimerWheel_Next(TimerWheel *WheelPtr)
+{
+	u64 Best = TIMER_WHEEL_NEVER;
+	u64 Start;
+	u64 Rotated;
+	u64 Candidate;
+	u32 Shift;
+	u32 Level;
+	u32 Index;
+
+	for (Level = 0U; Level < TIMER_WHEEL_LEVELS; Level++) {
+		if (WheelPtr->Pending[Level] == 0U) {
+			continue;
+		}
+
+		/* First slot boundary of this level at or after Base */
+		Shift = TIMER_WHEEL_SHIFT(Level);
+		Start = (WheelPtr->Base + (1ULL << Shift) - 1U) >> Shift;
+
+		/* Distance, in slots, to the first non-empty slot from there */
+		Index = (u32)Start & (TIMER_WHEEL_SLOTS - 1U);
+		Rotated = WheelPtr->Pending[Level] >> Index;
+		if (Index != 0U) {
+			Rotated |= WheelPtr->Pending[Level] <<
+				   (TIMER_WHEEL_SLOTS - Index);
+		}
+
+		Candidate = (Start + (u64)__builtin_ctzll(Rotated)) << Shift;
+		if (Candidate < Best) {
+			Best = Candidate;
+		}
+	}
+
+	return Best;
+}
+
+/*****************************************************************************/
+/**
+*
+* Processes tick Base: cascades the coarse slots whose span starts here,
+* then expires the timers of the level 0 slot and advances Base. Periodic
+* timers are re-armed from their expiry before their handler runs, so the
+* handler may still cancel them.
+*
+******************************************************************************/
+static void TimerWheel_Step(TimerWheel *WheelPtr)
+{
+	TimerWheel_Node List;
+	TimerWheel_Timer *TimerPtr;
+	u64 Tick = WheelPtr->Base;
+	u32 Shift;
+	u32 Level;
+
+	for (Level = 1U; Level < TIMER_WHEEL_LEVELS; Level++) {
+		Shift = TIMER_WHEEL_SHIFT(Level);
+		if ((Tick & ((1ULL << Shift) - 1U)) != 0U) {
+			break;
+		}
+
+		TimerWheel_Detach(WheelPtr, Level, (u32)(Tick >> Shift) &
+				  (TIMER_WHEEL_SLOTS - 1U), &List);
+		while (List.Next != &List) {
+			TimerPtr = (TimerWheel_Timer *)List.Next;
+			TimerWheel_Remove(WheelPtr, TimerPtr);
+			TimerWheel_Insert(WheelPtr, TimerPtr);
+			WheelPtr->Stats.Cascaded++;
+		}
+	}
+
+	TimerWheel_Detach(WheelPtr, 0U,
+			  (u32)Tick & (TIMER_WHEEL_SLOTS - 1U), &List);
+	WheelPtr->Base = Tick + 1U;
+
+	while (List.Next != &List) {
+		TimerPtr = (TimerWheel_Timer *)List.Next;
+		TimerWheel_Remove(WheelPtr, TimerPtr);
+
+		if (TimerPtr->Period != 0U) {
+			TimerPtr->Expires += TimerPtr->Period;
+			TimerWheel_Insert(WheelPtr, TimerPtr);
+		}
+
+		WheelPtr->Stats.Expired++;
+		TimerPtr->Handler(TimerPtr->CallBackRef);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Loads counter 0 as a down counter from Load. It first expires Load + 1
+* timer clocks later, then every Load + 2 clocks as it auto reloads. Auto
+* reload gives the ticks in periodic mode, and keeps the driver from
+* stopping the counter when it acknowledges the interrupt in tickless mode.
+*
+******************************************************************************/
+static void TimerWheel_Program(TimerWheel *WheelPtr, u32 Load)
+{
+	UINTPTR BaseAddress = WheelPtr->TmrCtrPtr->BaseAddress;
+	u8 Number = WheelPtr->TmrCtrNumber;
+	u32 Csr = XTC_CSR_ENABLE_TMR_MASK | XTC_CSR_ENABLE_INT_MASK |
+		  XTC_CSR_AUTO_RELOAD_MASK | XTC_CSR_DOWN_COUNT_MASK;
+
+	XTmrCtr_SetLoadReg(BaseAddress, Number, Load);
+	XTmrCtr_SetControlStatusReg(BaseAddress, Number,
+				    Csr | XTC_CSR_LOAD_MASK);
+	XTmrCtr_SetControlStatusReg(BaseAddress, Number, Csr);
+
+	WheelPtr->Stats.Programs++;
+}
+
+/*****************************************************************************/
+/**
+*
+* Tickless mode: programs counter 0 for the next tick with work, measured
+* from the timestamp clock so that programming delays do not accumulate.
+* With nothing armed the counter still fires every TIMER_WHEEL_MAX_SLEEP
+* clocks to keep the clock extension exact.
+*
+******************************************************************************/
+static void TimerWheel_Reprogram(TimerWheel *WheelPtr)
+{
+	u64 Next = TimerWheel_Next(WheelPtr);
+	u64 Deadline;
+	u64 Clocks = TIMER_WHEEL_MAX_SLEEP;
+
+	(void)TimerWheel_Update(WheelPtr);
+
+	if (Next != TIMER_WHEEL_NEVER) {
+		Deadline = WheelPtr->Origin + (Next * WheelPtr->TickClocks);
+		Clocks = (Deadline > WheelPtr->Clock) ?
+			 (Deadline - WheelPtr->Clock) : 0U;
+		if (Clocks < TIMER_WHEEL_MIN_SLEEP) {
+			Clocks = TIMER_WHEEL_MIN_SLEEP;
+		} else if (Clocks > TIMER_WHEEL_MAX_SLEEP) {
+			Clocks = TIMER_WHEEL_MAX_SLEEP;
+		}
+	}
+
+	WheelPtr->Programmed = Next;
+	TimerWheel_Program(WheelPtr, (u32)Clocks - 1U);
+}
@@ -0,0 +1,149 @@
+/******************************************************************************
+* Hierarchical timer wheel on one AXI Timer counter
+*
+* Multiplexes any number of software timers onto the interrupt of counter 0
+* of an AXI Timer, so one hardware counter serves every periodic job and
+* timeout of the application:
+*
+*	TimerWheel_Initialize(&Wheel, &TmrCtr, 0, 1000, TIMER_WHEEL_TICKLESS);
+*	TimerWheel_InitTimer(&Blink, BlinkHandler, NULL);
+*	TimerWheel_Start(&Wheel);
+*	TimerWheel_Arm(&Wheel, &Blink, 250, 250);	every 250 ticks
+*	...
+*	TimerWheel_Cancel(&Wheel, &Blink);
+*
+* Time is counted in wheel ticks (jiffies) of TickUs microseconds. The wheel
+* has TIMER_WHEEL_LEVELS levels of 64 slots, each level 64 times coarser than
+* the one below, so 4 levels cover 2^24 ticks, 4.6 hours at 1 ms. A timer is
+* put in the slot of the finest level that reaches its expiry; when the
+* ticks come round to a coarse slot, its timers are cascaded into the finer
+* levels. Slots are intrusive doubly linked lists and every level keeps a
+* 64-bit occupancy bitmap, so arming and cancelling are O(1) and the next
+* expiry is found with a count-trailing-zeros per level.
+*
+* The tick count is derived from the free-running timestamp counter (see
+* timestamp.h, counter 1 of the same timer), never from counting
+* interrupts. Periodic timers are reloaded from their previous expiry, not
+* from when their handler ran, so neither interrupt latency, masked
+* interrupts nor reprogramming the counter make them drift.
+*
+* Modes:
+*	TIMER_WHEEL_PERIODIC	counter 0 interrupts every tick
+*	TIMER_WHEEL_TICKLESS	counter 0 is reprogrammed after every
+*				interrupt to fire at the next expiry only, so
+*				an idle wheel costs no interrupts
+*
+* Timer handlers run in the timer interrupt and may arm and cancel timers,
+* including their own.
+******************************************************************************/
+
+#ifndef TIMER_WHEEL_H		/* prevent circular inclusions */
+#define TIMER_WHEEL_H
+
+/***************************** Include Files *********************************/
+
+#include "xil_types.h"
+#include "xtmrctr.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Wheel geometry: 64 slots per level, each level 64 times coarser */
+#define TIMER_WHEEL_SLOT_BITS		6U
+#define TIMER_WHEEL_SLOTS		(1U << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_LEVELS		4U
+
+/* Longest delay the wheel resolves, longer ones are cascaded again */
+#define TIMER_WHEEL_RANGE \
+	(1ULL << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS))
+
+/* Modes for TimerWheel_Initialize */
+#define TIMER_WHEEL_PERIODIC		0U
+#define TIMER_WHEEL_TICKLESS		1U
+
+/*
+ * Shortest and longest counter 0 interval in tickless mode, timer clocks.
+ * The longest keeps the 64-bit extension of the timestamp counter exact.
+ */
+#define TIMER_WHEEL_MIN_SLEEP		100U
+#define TIMER_WHEEL_MAX_SLEEP		0x7FFFFFFFU
+
+/* TimerWheel_Timer.Slot of a timer that is not armed */
+#define TIMER_WHEEL_IDLE		0xFFFFU
+
+/* No timer armed, see TimerWheel_NextExpiry */
+#define TIMER_WHEEL_NEVER		(~0ULL)
+
+/**************************** Type Definitions *******************************/
+
+typedef void (*TimerWheel_Handler)(void *CallBackRef);
+
+typedef struct TimerWheel_Node {
+	struct TimerWheel_Node *Next;
+	struct TimerWheel_Node *Prev;
+} TimerWheel_Node;
+
+typedef struct {
+	TimerWheel_Node Node;		/**< Slot list link, must be first */
+	u64 Expires;			/**< Tick the timer is due */
+	u32 Period;			/**< Reload in ticks, 0 for one-shot */
+	u16 Slot;			/**< Level * 64 + index, or _IDLE */
+	TimerWheel_Handler Handler;
+	void *CallBackRef;
+} TimerWheel_Timer;
+
+typedef struct {
+	u32 Interrupts;			/**< Counter 0 interrupts taken */
+	u32 Expired;			/**< Timer handlers called */
+	u32 Cascaded;			/**< Timers moved to a finer level */
+	u32 Programs;			/**< Counter 0 reprogrammed, tickless */
+} TimerWheel_Stats;
+
+typedef struct {
+	XTmrCtr *TmrCtrPtr;
+	u8 TmrCtrNumber;
+	u32 Mode;			/**< TIMER_WHEEL_PERIODIC or _TICKLESS */
+	u32 TickClocks;			/**< Timer clocks per tick */
+	u64 Base;			/**< Next tick to process */
+	u64 Programmed;			/**< Tick counter 0 fires at, tickless */
+	u64 Clock;			/**< Timestamp extended to 64 bits */
+	u64 Origin;			/**< Clock at tick 0 */
+	u32 LastStamp;			/**< Timestamp_Now folded into Clock */
+	u32 InHandler;			/**< Interrupt handler running */
+	u64 Pending[TIMER_WHEEL_LEVELS];	/**< Non-empty slot bitmaps */
+	TimerWheel_Node Slot[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+	TimerWheel_Stats Stats;
+} TimerWheel;
+
+/************************** Function Prototypes ******************************/
+
+int TimerWheel_Initialize(TimerWheel *WheelPtr, XTmrCtr *TmrCtrPtr,
+			  u8 TmrCtrNumber, u32 TickUs, u32 Mode);
+void TimerWheel_Start(TimerWheel *WheelPtr);
+void TimerWheel_InitTimer(TimerWheel_Timer *TimerPtr,
+			  TimerWheel_Handler Handler, void *CallBackRef);
+void TimerWheel_Arm(TimerWheel *WheelPtr, TimerWheel_Timer *TimerPtr,
+		    u32 Delay, u32 Period);
+int TimerWheel_Cancel(TimerWheel *WheelPtr, TimerWheel_Timer *TimerPtr);
+u64 TimerWheel_Now(TimerWheel *WheelPtr);
+u64 TimerWheel_NextExpiry(TimerWheel *WheelPtr);
+void TimerWheel_GetStats(TimerWheel *WheelPtr, TimerWheel_Stats *StatsPtr);
+void TimerWheel_InterruptHandler(void *CallBackRef, u8 TmrCtrNumber);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/*****************************************************************************/
+/**
+*
+* Tells whether a timer is armed.
+*
+* @param	TimerPtr is a pointer to the timer.
+*
+* @return	TRUE if the timer is waiting to expire, FALSE otherwise.
+*
+******************************************************************************/
+static inline int TimerWheel_IsArmed(TimerWheel_Timer *TimerPtr)
+{
+	return (TimerPtr->Slot != TIMER_WHEEL_IDLE) ? TRUE : FALSE;
+}
+
+#endif	/* end of protection macro */
@@ -0,0 +1,51 @@
+/******************************************************************************
+* Free-running timestamp counter
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "timestamp.h"
+
+/************************** Variable Definitions *****************************/
+
+UINTPTR Timestamp_CounterAddr;
+u32 Timestamp_ClockHz;
+
+/*****************************************************************************/
+/**
+*
+* Starts counter 1 of the timer as a free-running up counter with auto
+* reload from zero and no interrupt.
+*
+* @param	TmrCtrPtr is a pointer to an initialized XTmrCtr instance.
+*		Counter 0 of the instance is not touched.
+*
+* @return	None.
+*
+******************************************************************************/
+void Timestamp_Initialize(XTmrCtr *TmrCtrPtr)
+{
+	XTmrCtr_SetOptions(TmrCtrPtr, TIMESTAMP_COUNTER, XTC_AUTO_RELOAD_OPTION);
+	XTmrCtr_SetResetValue(TmrCtrPtr, TIMESTAMP_COUNTER, 0U);
+	XTmrCtr_Start(TmrCtrPtr, TIMESTAMP_COUNTER);
+
+	Timestamp_ClockHz = TmrCtrPtr->Config.SysClockFreqHz;
+	Timestamp_CounterAddr = TmrCtrPtr->BaseAddress +
+				XTmrCtr_Offsets[TIMESTAMP_COUNTER] +
+				XTC_TCR_OFFSET;
+}
+
+/*****************************************************************************/
+/**
+*
+* Converts a timestamp difference to nanoseconds.
+*
+* @param	Ticks is a difference of two Timestamp_Now values.
+*
+* @return	The interval in nanoseconds.
+*
+******************************************************************************/
+u64 Timestamp_TicksToNs(u32 Ticks)
+{
+	return ((u64)Ticks * 1000000000ULL) / Timestamp_ClockHz;
+}
@@ -0,0 +1,62 @@
+/******************************************************************************
+* Free-running timestamp counter
+*
+* Runs counter 1 of an AXI Timer as a free-running 32-bit up counter at the
+* timer clock, so that any code can take a timestamp with a single AXI read
+* and no driver call. Counter 0 of the same timer stays available to the
+* application, e.g. for the periodic interrupt of intrrupt.cpp.
+*
+* At 100 MHz the counter wraps after about 42.9 s. Differences of two
+* timestamps are computed in unsigned 32-bit arithmetic and so are correct
+* across one wrap; intervals longer than that cannot be measured.
+*
+* On a board with a cascaded system clock, MonoClock_Initialize of
+* mono_clock.h sets up Timestamp_Now in place of Timestamp_Initialize and
+* both counters of this timer stay free; timestamps are then the low word
+* of the 64-bit clock.
+******************************************************************************/
+
+#ifndef TIMESTAMP_H		/* prevent circular inclusions */
+#define TIMESTAMP_H
+
+/***************************** Include Files *********************************/
+
+#include "xil_types.h"
+#include "xil_io.h"
+#include "xtmrctr.h"
+
+/************************** Constant Definitions *****************************/
+
+/* The counter of the AXI Timer used for timestamps */
+#define TIMESTAMP_COUNTER		1U
+
+/************************** Variable Definitions *****************************/
+
+/*
+ * Address of the TCR of the timestamp counter, set by Timestamp_Initialize
+ * or MonoClock_Initialize
+ */
+extern UINTPTR Timestamp_CounterAddr;
+extern u32 Timestamp_ClockHz;
+
+/************************** Function Prototypes ******************************/
+
+void Timestamp_Initialize(XTmrCtr *TmrCtrPtr);
+u64 Timestamp_TicksToNs(u32 Ticks);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/*****************************************************************************/
+/**
+*
+* Reads the timestamp counter.
+*
+* @return	The current count, in timer clock ticks.
+*
+******************************************************************************/
+static inline u32 Timestamp_Now(void)
+{
+	return Xil_In32(Timestamp_CounterAddr);
+}
+
+#endif	/* end of protection macro */
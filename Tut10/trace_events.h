@@ -0,0 +1,39 @@
+/******************************************************************************
+* Trace log event table
+*
+* One line per event: identifier, number of arguments used (0 to 2) and the
+* xil_printf format the idle loop prints it with. The table is expanded by
+* trace_log.h into the event identifiers and by trace_log.cpp and the host
+* decoder (HostSim/tools/trace_decode.cpp) into the format table, so the
+* firmware and the decoder always agree.
+*
+* Identifiers are the position in the table and appear in binary traces.
+* Append new events at the end so older captures stay readable.
+*
+* No include guard: this file is included once per expansion.
+******************************************************************************/
+
+/* Trace infrastructure */
+TRACE_EVENT(TRACE_EV_CLOCK,		1, "trace clock %d Hz")
+TRACE_EVENT(TRACE_EV_DROPPED,		1, "%d trace events dropped")
+
+/* intrrupt.cpp */
+TRACE_EVENT(TRACE_EV_TIMER_TICK,	1, "Timer interrupt occurred! Count: %d")
+TRACE_EVENT(TRACE_EV_TIMER_STOP,	1, "Stopping timer after %d interrupts")
+
+/* Can_code.cpp, ErrorHandler */
+TRACE_EVENT(TRACE_EV_CAN_ACK_ERROR,	0, "Received ACK Error")
+TRACE_EVENT(TRACE_EV_CAN_BIT_ERROR,	0, "Received Bit Error")
+TRACE_EVENT(TRACE_EV_CAN_STUFF_ERROR,	0, "Received Stuff Error")
+TRACE_EVENT(TRACE_EV_CAN_FORM_ERROR,	0, "Received Form Error")
+TRACE_EVENT(TRACE_EV_CAN_CRC_ERROR,	0, "Received CRC Error")
+
+/* Can_code.cpp, EventHandler */
+TRACE_EVENT(TRACE_EV_CAN_BUS_OFF,	0, "Bus Off event")
+TRACE_EVENT(TRACE_EV_CAN_RX_OVERFLOW,	1, "RX FIFO Overflow event, %d so far")
+TRACE_EVENT(TRACE_EV_CAN_WAKE_UP,	0, "Wake up event")
+TRACE_EVENT(TRACE_EV_CAN_SLEEP,		0, "Sleep event")
+TRACE_EVENT(TRACE_EV_CAN_ARB_LOST,	0, "Arbitration lost event")
+
+/* intrrupt.cpp, timer wheel jobs */
+TRACE_EVENT(TRACE_EV_TIMER_ONESHOT,	2, "One-shot timer fired at tick %d, background job ran %d times")
@@ -0,0 +1,156 @@
+/******************************************************************************
+* Deferred binary trace log
+*
+* The recording fast path is inline in trace_log.h. This file holds the
+* consumer side, which only runs in the idle loop.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xil_printf.h"
+#include "trace_log.h"
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 NumArgs;
+	const char8 *Format;
+} TraceLog_Format;
+
+/************************** Variable Definitions *****************************/
+
+TraceLog TraceLog_Instance;
+
+static const TraceLog_Format TraceLog_Formats[TRACE_EV_COUNT] = {
+#define TRACE_EVENT(Id, NumArgs, Format)	{ NumArgs, Format },
+#include "trace_events.h"
+#undef TRACE_EVENT
+};
+
+/************************** Function Prototypes ******************************/
+
+static void TraceLog_Output(u32 Tag, u32 Stamp, u32 Arg0, u32 Arg1);
+
+/*****************************************************************************/
+/**
+*
+* Empties the log and records TRACE_EV_CLOCK. Timestamp_Initialize or
+* MonoClock_Initialize must have been called first.
+*
+* @param	Mode is TRACE_LOG_TEXT to print events with their formats or
+*		TRACE_LOG_BINARY to write raw records for the host decoder.
+*
+* @return	None.
+*
+******************************************************************************/
+void TraceLog_Init(u32 Mode)
+{
+	TraceLog *LogPtr = &TraceLog_Instance;
+	u32 Index;
+
+	for (Index = 0U; Index < TRACE_LOG_SIZE; Index++) {
+		LogPtr->Record[Index].Tag.store(0U, std::memory_order_relaxed);
+	}
+	LogPtr->Head.store(0U, std::memory_order_relaxed);
+	LogPtr->Tail.store(0U, std::memory_order_relaxed);
+	LogPtr->Dropped.store(0U, std::memory_order_relaxed);
+	LogPtr->Reported = 0U;
+	LogPtr->Mode = Mode;
+
+	TraceLog_Event(TRACE_EV_CLOCK, Timestamp_ClockHz, 0U);
+}
+
+/*****************************************************************************/
+/**
+*
+* Outputs every published event in the log, oldest first, then reports
+* events dropped since the last call. Call it from the idle loop only.
+*
+* @param	None.
+*
+* @return	None.
+*
+******************************************************************************/
+void TraceLog_Flush(void)
+{
+	TraceLog *LogPtr = &TraceLog_Instance;
+	TraceLog_Record *RecordPtr;
+	u32 Tail = LogPtr->Tail.load(std::memory_order_relaxed);
+	u32 Dropped;
+	u32 Tag;
+
+	for (;;) {
+		RecordPtr = &LogPtr->Record[Tail & (TRACE_LOG_SIZE - 1U)];
+		Tag = RecordPtr->Tag.load(std::memory_order_acquire);
+
+		/* Reserved but not yet published, or nothing logged */
+		if ((Tag & 0xFFU) != TRACE_LOG_SYNC ||
+		    (Tag >> 16) != (Tail & 0xFFFFU)) {
+			break;
+		}
+
+		TraceLog_Output(Tag, RecordPtr->Stamp, RecordPtr->Arg[0],
+				RecordPtr->Arg[1]);
+
+		Tail++;
+		LogPtr->Tail.store(Tail, std::memory_order_release);
+	}
+
+	Dropped = LogPtr->Dropped.load(std::memory_order_relaxed);
+	if (Dropped != LogPtr->Reported) {
+		TraceLog_Output(TRACE_LOG_TAG(TRACE_EV_DROPPED, Tail & 0xFFFFU),
+				Timestamp_Now(), Dropped - LogPtr->Reported,
+				0U);
+		LogPtr->Reported = Dropped;
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the number of events dropped because the log was full since
+* TraceLog_Init.
+*
+* @param	None.
+*
+* @return	The number of events.
+*
+******************************************************************************/
+u32 TraceLog_GetDropped(void)
+{
+	return TraceLog_Instance.Dropped.load(std::memory_order_relaxed);
+}
+
+/*****************************************************************************/
+/**
+*
+* Outputs one record in the mode selected by TraceLog_Init.
+*
+******************************************************************************/
+static void TraceLog_Output(u32 Tag, u32 Stamp, u32 Arg0, u32 Arg1)
+{
+	const TraceLog_Format *FormatPtr;
+	u32 Word[4];
+	u32 Id = (Tag >> 8) & 0xFFU;
+	u32 Index;
+
+	if (TraceLog_Instance.Mode == TRACE_LOG_BINARY) {
+		Word[0] = Tag;
+		Word[1] = Stamp;
+		Word[2] = Arg0;
+		Word[3] = Arg1;
+		for (Index = 0U; Index < 16U; Index++) {
+			outbyte((char8)(Word[Index / 4U] >> ((Index % 4U) * 8U)));
+		}
+		return;
+	}
+
+	xil_printf("[%10d us] ", (int)(Timestamp_TicksToNs(Stamp) / 1000U));
+	if (Id >= TRACE_EV_COUNT) {
+		xil_printf("unknown event %d\r\n", (int)Id);
+		return;
+	}
+	FormatPtr = &TraceLog_Formats[Id];
+	xil_printf(FormatPtr->Format, (int)Arg0, (int)Arg1);
+	xil_printf("\r\n");
+}
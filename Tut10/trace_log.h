@@ -0,0 +1,138 @@
+/******************************************************************************
+* Deferred binary trace log
+*
+* Interrupt handlers must not format text: xil_printf to the UART takes
+* milliseconds and blocks every other interrupt meanwhile. Instead a
+* handler records a fixed-size binary event, an identifier from
+* trace_events.h, a Timestamp_Now value and up to two arguments, in a few
+* cycles:
+*
+*	TraceLog_Event(TRACE_EV_TIMER_TICK, InterruptCounter, 0);
+*
+* and the idle loop formats and outputs whatever has accumulated:
+*
+*	while (1) {
+*		TraceLog_Flush();
+*	}
+*
+* TraceLog_Flush either prints each event with its format from
+* trace_events.h (TRACE_LOG_TEXT) or writes the raw records to the STDOUT
+* UART (TRACE_LOG_BINARY), leaving the formatting to the host decoder
+* HostSim/tools/trace_decode.
+*
+* The log is a ring of TRACE_LOG_SIZE records with any number of producers,
+* including nested interrupts, and a single consumer, the idle loop. A
+* producer reserves a record by advancing Head and publishes it by writing
+* its tag word last. When the ring is full new events are dropped and
+* counted rather than overwriting records the consumer has not seen.
+*
+* Binary record layout, little-endian, 16 bytes:
+*
+*	Word 0	tag: TRACE_LOG_SYNC (bits 7:0), event id (15:8) and the low
+*		16 bits of the record sequence number (31:16)
+*	Word 1	timestamp, Timestamp_Now ticks
+*	Word 2	argument 0
+*	Word 3	argument 1
+*
+* The first record after TraceLog_Init is TRACE_EV_CLOCK, with the timestamp
+* clock frequency as argument 0, so a capture is self-describing.
+******************************************************************************/
+
+#ifndef TRACE_LOG_H		/* prevent circular inclusions */
+#define TRACE_LOG_H
+
+/***************************** Include Files *********************************/
+
+#include <atomic>
+
+#include "xil_types.h"
+#include "timestamp.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Records held by the log, must be a power of two */
+#define TRACE_LOG_SIZE			256U
+
+/* Low byte of every record tag, never a printable character */
+#define TRACE_LOG_SYNC			0xA5U
+
+/* Output formats for TraceLog_Init */
+#define TRACE_LOG_TEXT			0U
+#define TRACE_LOG_BINARY		1U
+
+/* Event identifiers */
+enum {
+#define TRACE_EVENT(Id, NumArgs, Format)	Id,
+#include "trace_events.h"
+#undef TRACE_EVENT
+	TRACE_EV_COUNT
+};
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	std::atomic<u32> Tag;		/**< Written last, publishes the record */
+	u32 Stamp;
+	u32 Arg[2];
+} TraceLog_Record;
+
+typedef struct {
+	TraceLog_Record Record[TRACE_LOG_SIZE];
+	std::atomic<u32> Head;		/**< Next record to reserve */
+	std::atomic<u32> Tail;		/**< Next record to output */
+	std::atomic<u32> Dropped;	/**< Events lost to a full log */
+	u32 Reported;			/**< Dropped count last reported */
+	u32 Mode;			/**< TRACE_LOG_TEXT or _BINARY */
+} TraceLog;
+
+/************************** Variable Definitions *****************************/
+
+extern TraceLog TraceLog_Instance;
+
+/************************** Function Prototypes ******************************/
+
+void TraceLog_Init(u32 Mode);
+void TraceLog_Flush(void);
+u32 TraceLog_GetDropped(void);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+#define TRACE_LOG_TAG(Id, Seq) \
+	(TRACE_LOG_SYNC | ((u32)(Id) << 8) | ((u32)(Seq) << 16))
+
+/*****************************************************************************/
+/**
+*
+* Records an event. Safe from any context, including nested interrupts.
+*
+* @param	Id is the event identifier from trace_events.h.
+* @param	Arg0 is the first argument of the event format.
+* @param	Arg1 is the second argument of the event format.
+*
+* @return	None.
+*
+******************************************************************************/
+static inline void TraceLog_Event(u32 Id, u32 Arg0, u32 Arg1)
+{
+	TraceLog *LogPtr = &TraceLog_Instance;
+	TraceLog_Record *RecordPtr;
+	u32 Head = LogPtr->Head.load(std::memory_order_relaxed);
+
+	do {
+		if ((Head - LogPtr->Tail.load(std::memory_order_acquire)) >=
+		    TRACE_LOG_SIZE) {
+			LogPtr->Dropped.fetch_add(1U, std::memory_order_relaxed);
+			return;
+		}
+	} while (!LogPtr->Head.compare_exchange_weak(Head, Head + 1U,
+			std::memory_order_relaxed));
+
+	RecordPtr = &LogPtr->Record[Head & (TRACE_LOG_SIZE - 1U)];
+	RecordPtr->Stamp = Timestamp_Now();
+	RecordPtr->Arg[0] = Arg0;
+	RecordPtr->Arg[1] = Arg1;
+	RecordPtr->Tag.store(TRACE_LOG_TAG(Id, Head & 0xFFFFU),
+			     std::memory_order_release);
+}
+
+#endif	/* end of protection macro */
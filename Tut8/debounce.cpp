@@ -0,0 +1,45 @@
+/******************************************************************************
+* Bit-parallel input debouncer
+*
+* The per-tick update and the event queue are inline in debounce.h.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "debounce.h"
+
+/*****************************************************************************/
+/**
+*
+* Initializes a debouncer with every input settled.
+*
+* @param	DebouncePtr is a pointer to the debouncer.
+* @param	Initial is the debounced level to start from, normally a
+*		first raw read of the inputs.
+*
+* @return	None.
+*
+******************************************************************************/
+void Debounce_Init(Debounce *DebouncePtr, u32 Initial)
+{
+	DebouncePtr->State = Initial;
+	DebouncePtr->Count0 = 0U;
+	DebouncePtr->Count1 = 0U;
+}
+
+/*****************************************************************************/
+/**
+*
+* Initializes an empty event queue.
+*
+* @param	QueuePtr is a pointer to the queue.
+*
+* @return	None.
+*
+******************************************************************************/
+void Debounce_QueueInit(Debounce_Queue *QueuePtr)
+{
+	QueuePtr->Head.store(0U, std::memory_order_relaxed);
+	QueuePtr->Tail.store(0U, std::memory_order_relaxed);
+	QueuePtr->Overflows = 0U;
+}
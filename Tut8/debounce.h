@@ -0,0 +1,190 @@
+/******************************************************************************
+* Bit-parallel input debouncer
+*
+* Debounces all 32 bits of a GPIO channel at once with a 2-bit vertical
+* counter per bit: bit n of Count0 and Count1 together count how many
+* consecutive ticks input n has differed from its debounced level. A bit
+* whose raw level matches again is reset; one that differs for
+* DEBOUNCE_SAMPLES ticks in a row flips. The whole update is seven logic
+* operations on 32-bit words, whatever the number of inputs:
+*
+*	Tick:	Changed = Debounce_Sample(&Switches, XGpio_DiscreteRead(..));
+*		if (Changed) Debounce_Post(&Events, Changed, Switches.State);
+*
+*	Task:	while (Debounce_Get(&Events, &Event)) { ... }
+*
+* Debounced edges are delivered as an event stream of bitmasks: each event
+* holds the inputs that changed on one tick and the new debounced level of
+* all of them, so rising edges are Changed & State and falling edges
+* Changed & ~State. The event queue has one producer, the tick interrupt,
+* and one consumer, the task context.
+******************************************************************************/
+
+#ifndef DEBOUNCE_H		/* prevent circular inclusions */
+#define DEBOUNCE_H
+
+/***************************** Include Files *********************************/
+
+#include <atomic>
+
+#include "xil_types.h"
+
+/************************** Constant Definitions *****************************/
+
+/*
+ * Consecutive ticks an input must hold a new level before it is accepted,
+ * fixed by the width of the vertical counter of Debounce_Sample
+ */
+#define DEBOUNCE_SAMPLES		4U
+
+static_assert(DEBOUNCE_SAMPLES == 4U,
+	      "the 2-bit vertical counter counts 4 samples");
+
+/* Events held by the queue, must be a power of two */
+#define DEBOUNCE_QUEUE_SIZE		16U
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 State;			/**< Debounced level of every input */
+	u32 Count0;			/**< Vertical counter, low bits */
+	u32 Count1;			/**< Vertical counter, high bits */
+} Debounce;
+
+typedef struct {
+	u32 Changed;			/**< Inputs that changed on this tick */
+	u32 State;			/**< Debounced level after the change */
+} Debounce_Event;
+
+typedef struct {
+	Debounce_Event Event[DEBOUNCE_QUEUE_SIZE];
+	std::atomic<u32> Head;		/**< Next event to post (tick) */
+	std::atomic<u32> Tail;		/**< Next event to get (task) */
+	u32 Overflows;			/**< Events lost to a full queue */
+} Debounce_Queue;
+
+/************************** Function Prototypes ******************************/
+
+void Debounce_Init(Debounce *DebouncePtr, u32 Initial);
+void Debounce_QueueInit(Debounce_Queue *QueuePtr);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/*****************************************************************************/
+/**
+*
+* Feeds one sample of the raw inputs to the debouncer. Call it every tick.
+*
+* @param	DebouncePtr is a pointer to the debouncer.
+* @param	Raw is the raw level of the inputs.
+*
+* @return	Mask of the inputs whose debounced level changed on this tick.
+*
+******************************************************************************/
+static inline u32 Debounce_Sample(Debounce *DebouncePtr, u32 Raw)
+{
+	u32 Delta = Raw ^ DebouncePtr->State;
+	u32 Changed;
+
+	/* Count up the differing bits, reset the others: 00 01 10 11 00 */
+	DebouncePtr->Count1 = (DebouncePtr->Count1 ^ DebouncePtr->Count0) & Delta;
+	DebouncePtr->Count0 = ~DebouncePtr->Count0 & Delta;
+
+	/* A differing bit whose counter wrapped back to 00 has settled */
+	Changed = Delta & ~(DebouncePtr->Count0 | DebouncePtr->Count1);
+	DebouncePtr->State ^= Changed;
+
+	return Changed;
+}
+
+/*****************************************************************************/
+/**
+*
+* Tells whether any input is still being counted. Once idle, the debouncer
+* only needs new samples after a raw input changes.
+*
+* @param	DebouncePtr is a pointer to the debouncer.
+*
+* @return	TRUE if some input differs from its debounced level.
+*
+******************************************************************************/
+static inline int Debounce_IsBusy(Debounce *DebouncePtr)
+{
+	return ((DebouncePtr->Count0 | DebouncePtr->Count1) != 0U) ? TRUE :
+								     FALSE;
+}
+
+/*****************************************************************************/
+/**
+*
+* Posts an event to the queue. Tick interrupt only.
+*
+* @param	QueuePtr is a pointer to the queue.
+* @param	Changed is the mask returned by Debounce_Sample.
+* @param	State is the debounced level after the change.
+*
+* @return	None. The event is counted in Overflows and dropped if the
+*		queue is full.
+*
+******************************************************************************/
+static inline void Debounce_Post(Debounce_Queue *QueuePtr, u32 Changed,
+				 u32 State)
+{
+	u32 Head = QueuePtr->Head.load(std::memory_order_relaxed);
+	Debounce_Event *EventPtr;
+
+	if ((Head - QueuePtr->Tail.load(std::memory_order_acquire)) ==
+	    DEBOUNCE_QUEUE_SIZE) {
+		QueuePtr->Overflows++;
+		return;
+	}
+
+	EventPtr = &QueuePtr->Event[Head & (DEBOUNCE_QUEUE_SIZE - 1U)];
+	EventPtr->Changed = Changed;
+	EventPtr->State = State;
+	QueuePtr->Head.store(Head + 1U, std::memory_order_release);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the number of events waiting. Task context only.
+*
+* @param	QueuePtr is a pointer to the queue.
+*
+* @return	The number of events Debounce_Get would return.
+*
+******************************************************************************/
+static inline u32 Debounce_Pending(Debounce_Queue *QueuePtr)
+{
+	return QueuePtr->Head.load(std::memory_order_acquire) -
+	       QueuePtr->Tail.load(std::memory_order_relaxed);
+}
+
+/*****************************************************************************/
+/**
+*
+* Takes the oldest event from the queue. Task context only.
+*
+* @param	QueuePtr is a pointer to the queue.
+* @param	EventPtr is where the event is returned.
+*
+* @return	TRUE if an event was returned, FALSE if the queue is empty.
+*
+******************************************************************************/
+static inline int Debounce_Get(Debounce_Queue *QueuePtr,
+			       Debounce_Event *EventPtr)
+{
+	u32 Tail = QueuePtr->Tail.load(std::memory_order_relaxed);
+
+	if (Tail == QueuePtr->Head.load(std::memory_order_acquire)) {
+		return FALSE;
+	}
+
+	*EventPtr = QueuePtr->Event[Tail & (DEBOUNCE_QUEUE_SIZE - 1U)];
+	QueuePtr->Tail.store(Tail + 1U, std::memory_order_release);
+
+	return TRUE;
+}
+
+#endif	/* end of protection macro */
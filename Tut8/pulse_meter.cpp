@@ -0,0 +1,428 @@
+/******************************************************************************
+* Frequency, period and duty cycle meter on the AXI Timer capture inputs
+*
+* See pulse_meter.h for the design.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xstatus.h"
+#include "pulse_meter.h"
+
+/************************** Function Prototypes ******************************/
+
+static void PulseMeter_ResetWindow(PulseMeter *MeterPtr);
+static void PulseMeter_Rise(PulseMeter *MeterPtr, u32 Capture);
+static void PulseMeter_Fall(PulseMeter *MeterPtr, u32 Capture);
+static void PulseMeter_Publish(PulseMeter *MeterPtr);
+static u64 PulseMeter_AverageNs(u64 SumClocks, u32 Periods, u32 ClockHz);
+
+/*****************************************************************************/
+/**
+*
+* Initializes a meter on an AXI Timer reserved for it. The counters are not
+* started until PulseMeter_Start.
+*
+* @param	MeterPtr is a pointer to the meter.
+* @param	TmrCtrPtr is a pointer to the initialized XTmrCtr instance.
+*		Its interrupt must be connected to PulseMeter_InterruptHandler
+*		with MeterPtr as the callback reference.
+* @param	Window is the number of periods averaged in each result.
+*
+* @return
+*		- XST_SUCCESS if the meter was initialized
+*		- XST_INVALID_PARAM if Window is 0 or above
+*		PULSE_METER_MAX_WINDOW
+*
+******************************************************************************/
+int PulseMeter_Initialize(PulseMeter *MeterPtr, XTmrCtr *TmrCtrPtr,
+			  u32 Window)
+{
+	if ((Window == 0U) || (Window > PULSE_METER_MAX_WINDOW)) {
+		return XST_INVALID_PARAM;
+	}
+
+	MeterPtr->TmrCtrPtr = TmrCtrPtr;
+	MeterPtr->Window = Window;
+	MeterPtr->LastEdge = 0U;
+	MeterPtr->LastRise = 0U;
+	MeterPtr->LastFall = 0U;
+	MeterPtr->HaveRise = FALSE;
+	MeterPtr->FallSeen = FALSE;
+	MeterPtr->Skip = FALSE;
+	PulseMeter_ResetWindow(MeterPtr);
+
+	MeterPtr->Sequence.store(0U, std::memory_order_relaxed);
+	MeterPtr->Result = MeterPtr->Acc;
+
+	MeterPtr->Stats.Interrupts = 0U;
+	MeterPtr->Stats.Edges = 0U;
+	MeterPtr->Stats.Missed = 0U;
+	MeterPtr->Stats.Windows = 0U;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Loads both counters with 0 and starts them on the same clock in capture
+* mode, with capture interrupts. The first period is complete at the second
+* rising edge.
+*
+* @param	MeterPtr is a pointer to the meter.
+*
+* @return	None.
+*
+******************************************************************************/
+void PulseMeter_Start(PulseMeter *MeterPtr)
+{
+	UINTPTR BaseAddress = MeterPtr->TmrCtrPtr->BaseAddress;
+	u32 Csr = XTC_CSR_CAPTURE_MODE_MASK | XTC_CSR_EXT_CAPTURE_MASK |
+		  XTC_CSR_ENABLE_INT_MASK;
+
+	MeterPtr->HaveRise = FALSE;
+	MeterPtr->FallSeen = FALSE;
+	MeterPtr->Skip = FALSE;
+
+	XTmrCtr_SetLoadReg(BaseAddress, PULSE_METER_RISE_COUNTER, 0U);
+	XTmrCtr_SetLoadReg(BaseAddress, PULSE_METER_FALL_COUNTER, 0U);
+	XTmrCtr_SetControlStatusReg(BaseAddress, PULSE_METER_RISE_COUNTER,
+				    XTC_CSR_LOAD_MASK |
+				    XTC_CSR_INT_OCCURED_MASK);
+	XTmrCtr_SetControlStatusReg(BaseAddress, PULSE_METER_FALL_COUNTER,
+				    XTC_CSR_LOAD_MASK |
+				    XTC_CSR_INT_OCCURED_MASK);
+
+	/* ENALL in one TCSR enables both counters at once */
+	XTmrCtr_SetControlStatusReg(BaseAddress, PULSE_METER_FALL_COUNTER,
+				    Csr);
+	XTmrCtr_SetControlStatusReg(BaseAddress, PULSE_METER_RISE_COUNTER,
+				    Csr | XTC_CSR_ENABLE_ALL_MASK);
+}
+
+/*****************************************************************************/
+/**
+*
+* Stops both counters. The last published result stays readable.
+*
+* @param	MeterPtr is a pointer to the meter.
+*
+* @return	None.
+*
+******************************************************************************/
+void PulseMeter_Stop(PulseMeter *MeterPtr)
+{
+	UINTPTR BaseAddress = MeterPtr->TmrCtrPtr->BaseAddress;
+
+	XTmrCtr_SetControlStatusReg(BaseAddress, PULSE_METER_RISE_COUNTER,
+				    XTC_CSR_INT_OCCURED_MASK);
+	XTmrCtr_SetControlStatusReg(BaseAddress, PULSE_METER_FALL_COUNTER,
+				    XTC_CSR_INT_OCCURED_MASK);
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the last complete window if it is newer than the one the caller
+* saw last. Task context; never masks interrupts.
+*
+* @param	MeterPtr is a pointer to the meter.
+* @param	ResultPtr is where the window is returned.
+* @param	SeenPtr holds the sequence of the window the caller saw last,
+*		0 initially, and is updated when a new one is returned.
+*
+* @return	TRUE if a new window was returned, FALSE otherwise.
+*
+******************************************************************************/
+int PulseMeter_GetResult(PulseMeter *MeterPtr, PulseMeter_Result *ResultPtr,
+			 u32 *SeenPtr)
+{
+	u32 Before;
+	u32 After;
+
+	do {
+		Before = MeterPtr->Sequence.load(std::memory_order_acquire);
+		if (Before == *SeenPtr) {
+			return FALSE;
+		}
+		*ResultPtr = MeterPtr->Result;
+		std::atomic_signal_fence(std::memory_order_acquire);
+		After = MeterPtr->Sequence.load(std::memory_order_relaxed);
+	} while ((Before != After) || ((Before & 1U) != 0U));
+
+	*SeenPtr = After;
+
+	return TRUE;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the meter statistics.
+*
+* @param	MeterPtr is a pointer to the meter.
+* @param	StatsPtr is where the statistics are returned.
+*
+* @return	None.
+*
+******************************************************************************/
+void PulseMeter_GetStats(PulseMeter *MeterPtr, PulseMeter_Stats *StatsPtr)
+{
+	*StatsPtr = MeterPtr->Stats;
+}
+
+/*****************************************************************************/
+/**
+*
+* Capture interrupt handler. Reads the pending captures of both counters,
+* then releases them, and processes them in the order the edges came: when
+* both are pending, the one closer after the previous edge is first.
+*
+* @param	CallBackRef is a pointer to the meter.
+*
+* @return	None.
+*
+******************************************************************************/
+void PulseMeter_InterruptHandler(void *CallBackRef)
+{
+	PulseMeter *MeterPtr = (PulseMeter *)CallBackRef;
+	UINTPTR BaseAddress = MeterPtr->TmrCtrPtr->BaseAddress;
+	u32 RiseCsr;
+	u32 FallCsr;
+	u32 Rise = 0U;
+	u32 Fall = 0U;
+	int RisePending;
+	int FallPending;
+
+	MeterPtr->Stats.Interrupts++;
+
+	RiseCsr = XTmrCtr_GetControlStatusReg(BaseAddress,
+					      PULSE_METER_RISE_COUNTER);
+	FallCsr = XTmrCtr_GetControlStatusReg(BaseAddress,
+					      PULSE_METER_FALL_COUNTER);
+	RisePending = (RiseCsr & XTC_CSR_INT_OCCURED_MASK) != 0U;
+	FallPending = (FallCsr & XTC_CSR_INT_OCCURED_MASK) != 0U;
+
+	/* Writing the TCSR back clears TINT and frees the held capture */
+	if (RisePending) {
+		Rise = XTmrCtr_GetLoadReg(BaseAddress,
+					  PULSE_METER_RISE_COUNTER);
+		XTmrCtr_SetControlStatusReg(BaseAddress,
+					    PULSE_METER_RISE_COUNTER, RiseCsr);
+	}
+	if (FallPending) {
+		Fall = XTmrCtr_GetLoadReg(BaseAddress,
+					  PULSE_METER_FALL_COUNTER);
+		XTmrCtr_SetControlStatusReg(BaseAddress,
+					    PULSE_METER_FALL_COUNTER, FallCsr);
+	}
+
+	if (RisePending && FallPending &&
+	    ((Fall - MeterPtr->LastEdge) < (Rise - MeterPtr->LastEdge))) {
+		PulseMeter_Fall(MeterPtr, Fall);
+		FallPending = FALSE;
+	}
+	if (RisePending) {
+		PulseMeter_Rise(MeterPtr, Rise);
+	}
+	if (FallPending) {
+		PulseMeter_Fall(MeterPtr, Fall);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Average frequency of a window.
+*
+* @param	ResultPtr is a pointer to the window.
+*
+* @return	The frequency in mHz, 0 for an empty window.
+*
+******************************************************************************/
+u64 PulseMeter_FrequencyMilliHz(const PulseMeter_Result *ResultPtr)
+{
+	if (ResultPtr->PeriodClocks == 0U) {
+		return 0U;
+	}
+
+	return ((u64)ResultPtr->Periods * ResultPtr->ClockHz * 1000U) /
+	       ResultPtr->PeriodClocks;
+}
+
+/*****************************************************************************/
+/**
+*
+* Average period of a window.
+*
+* @param	ResultPtr is a pointer to the window.
+*
+* @return	The period in ns, 0 for an empty window.
+*
+******************************************************************************/
+u64 PulseMeter_PeriodNs(const PulseMeter_Result *ResultPtr)
+{
+	return PulseMeter_AverageNs(ResultPtr->PeriodClocks,
+				    ResultPtr->Periods, ResultPtr->ClockHz);
+}
+
+/*****************************************************************************/
+/**
+*
+* Average high time of a window.
+*
+* @param	ResultPtr is a pointer to the window.
+*
+* @return	The high time in ns, 0 for an empty window.
+*
+******************************************************************************/
+u64 PulseMeter_HighNs(const PulseMeter_Result *ResultPtr)
+{
+	return PulseMeter_AverageNs(ResultPtr->HighClocks,
+				    ResultPtr->Periods, ResultPtr->ClockHz);
+}
+
+/*****************************************************************************/
+/**
+*
+* Duty cycle of a window, the high time over the period.
+*
+* @param	ResultPtr is a pointer to the window.
+*
+* @return	The duty cycle in parts per million, 0 for an empty window.
+*
+******************************************************************************/
+u32 PulseMeter_DutyPpm(const PulseMeter_Result *ResultPtr)
+{
+	u64 High = ResultPtr->HighClocks;
+	u64 Period = ResultPtr->PeriodClocks;
+
+	/* Scale both down until High * 10^6 fits in 64 bits */
+	while (High > (~0ULL / 1000000U)) {
+		High >>= 1;
+		Period >>= 1;
+	}
+	if (Period == 0U) {
+		return 0U;
+	}
+
+	return (u32)((High * 1000000U) / Period);
+}
+
+/*****************************************************************************/
+/*
+ * Starts an empty window
+ */
+static void PulseMeter_ResetWindow(PulseMeter *MeterPtr)
+{
+	MeterPtr->Acc.Periods = 0U;
+	MeterPtr->Acc.PeriodClocks = 0U;
+	MeterPtr->Acc.HighClocks = 0U;
+	MeterPtr->Acc.MinPeriod = ~0U;
+	MeterPtr->Acc.MaxPeriod = 0U;
+	MeterPtr->Acc.Missed = 0U;
+	MeterPtr->Acc.ClockHz = MeterPtr->TmrCtrPtr->Config.SysClockFreqHz;
+}
+
+/*****************************************************************************/
+/*
+ * A rising edge closes the period started by the previous one. The period
+ * counts only if exactly one falling edge was seen in it.
+ */
+static void PulseMeter_Rise(PulseMeter *MeterPtr, u32 Capture)
+{
+	PulseMeter_Result *AccPtr = &MeterPtr->Acc;
+	u32 Period;
+
+	MeterPtr->Stats.Edges++;
+
+	if (MeterPtr->HaveRise) {
+		if (MeterPtr->FallSeen && !MeterPtr->Skip) {
+			Period = Capture - MeterPtr->LastRise;
+			AccPtr->Periods++;
+			AccPtr->PeriodClocks += Period;
+			AccPtr->HighClocks += MeterPtr->LastFall -
+					      MeterPtr->LastRise;
+			if (Period < AccPtr->MinPeriod) {
+				AccPtr->MinPeriod = Period;
+			}
+			if (Period > AccPtr->MaxPeriod) {
+				AccPtr->MaxPeriod = Period;
+			}
+			if (AccPtr->Periods == MeterPtr->Window) {
+				PulseMeter_Publish(MeterPtr);
+			}
+		} else if (!MeterPtr->Skip) {
+			/* The falling edge of this period was lost */
+			AccPtr->Missed++;
+			MeterPtr->Stats.Missed++;
+		}
+	}
+
+	MeterPtr->LastEdge = Capture;
+	MeterPtr->LastRise = Capture;
+	MeterPtr->HaveRise = TRUE;
+	MeterPtr->FallSeen = FALSE;
+	MeterPtr->Skip = FALSE;
+}
+
+/*
+ * A falling edge ends the high time of the current period. A second one in
+ * the same period means a rising edge was lost in between.
+ */
+static void PulseMeter_Fall(PulseMeter *MeterPtr, u32 Capture)
+{
+	MeterPtr->Stats.Edges++;
+	MeterPtr->LastEdge = Capture;
+
+	if (!MeterPtr->HaveRise || MeterPtr->Skip) {
+		return;
+	}
+
+	if (MeterPtr->FallSeen) {
+		MeterPtr->Acc.Missed++;
+		MeterPtr->Stats.Missed++;
+		MeterPtr->Skip = TRUE;
+		return;
+	}
+
+	MeterPtr->LastFall = Capture;
+	MeterPtr->FallSeen = TRUE;
+}
+
+/*
+ * Publishes the window just completed and starts the next one
+ */
+static void PulseMeter_Publish(PulseMeter *MeterPtr)
+{
+	u32 Sequence = MeterPtr->Sequence.load(std::memory_order_relaxed);
+
+	MeterPtr->Sequence.store(Sequence + 1U, std::memory_order_relaxed);
+	std::atomic_signal_fence(std::memory_order_release);
+	MeterPtr->Result = MeterPtr->Acc;
+	MeterPtr->Sequence.store(Sequence + 2U, std::memory_order_release);
+
+	MeterPtr->Stats.Windows++;
+	PulseMeter_ResetWindow(MeterPtr);
+}
+
+/*
+ * Average of a sum of Periods times in clocks, in ns, without overflowing
+ * 64 bits for any window
+ */
+static u64 PulseMeter_AverageNs(u64 SumClocks, u32 Periods, u32 ClockHz)
+{
+	u64 Whole;
+	u64 Part;
+
+	if ((Periods == 0U) || (ClockHz == 0U)) {
+		return 0U;
+	}
+
+	Whole = SumClocks / Periods;
+	Part = SumClocks % Periods;
+
+	return ((Whole * 1000000000U) + ((Part * 1000000000U) / Periods)) /
+	       ClockHz;
+}
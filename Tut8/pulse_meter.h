@@ -0,0 +1,108 @@
+/******************************************************************************
+* Frequency, period and duty cycle meter on the AXI Timer capture inputs
+*
+* Measures a digital signal with both counters of an AXI Timer in capture
+* mode, instead of sampling it with GPIO reads in a loop. The signal drives
+* CAPTURETRIG0 and CAPTURETRIG1; the second input is configured active low
+* in the hardware design (C_TRIG1_ASSERT = 0), so counter 0 latches the
+* timer count on every rising edge and counter 1 on every falling edge. Both
+* counters are loaded and started together with ENALL and count the same
+* clock, so their captures are timestamps on one timebase, exact to one
+* timer clock whatever the CPU is doing:
+*
+*	PulseMeter_Initialize(&Meter, &CaptureTimer, 4000);
+*	XScuGic_Connect(&Gic, Id, PulseMeter_InterruptHandler, &Meter);
+*	PulseMeter_Start(&Meter);
+*	...
+*	if (PulseMeter_GetResult(&Meter, &Result, &Seen)) {
+*		PulseMeter_FrequencyMilliHz(&Result) ...
+*	}
+*
+* Each edge costs one short interrupt and nothing runs between edges. The
+* interrupt turns rising edges into periods and falling edges into high
+* times and sums them over a window of Window periods; the averages of the
+* last complete window are published for the task. Captures are held
+* (ARHT clear) until the interrupt has read them, so an edge that comes
+* while the previous one is still pending is lost rather than overwriting
+* it; the meter notices from two edges of the same kind in a row and drops
+* that period, counting it in Missed.
+*
+* The window is read with a sequence count: the interrupt makes it odd
+* while it writes a result and the reader retries if it saw a write, so
+* neither side ever masks interrupts.
+******************************************************************************/
+
+#ifndef PULSE_METER_H		/* prevent circular inclusions */
+#define PULSE_METER_H
+
+/***************************** Include Files *********************************/
+
+#include <atomic>
+
+#include "xil_types.h"
+#include "xtmrctr.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Counters latching the rising and the falling edges */
+#define PULSE_METER_RISE_COUNTER	0U
+#define PULSE_METER_FALL_COUNTER	1U
+
+/* Longest window, keeps the sums of a window within 64 bits */
+#define PULSE_METER_MAX_WINDOW		0x10000U
+
+/**************************** Type Definitions *******************************/
+
+/*
+ * Sums over one window. Times are in timer clocks; the helpers below turn
+ * them into averages.
+ */
+typedef struct {
+	u32 Periods;			/**< Periods in the sums */
+	u64 PeriodClocks;		/**< Sum of the periods */
+	u64 HighClocks;			/**< Sum of the high times */
+	u32 MinPeriod;			/**< Shortest period */
+	u32 MaxPeriod;			/**< Longest period */
+	u32 Missed;			/**< Periods dropped for a lost edge */
+	u32 ClockHz;			/**< Timer clock */
+} PulseMeter_Result;
+
+typedef struct {
+	u32 Interrupts;			/**< Capture interrupts taken */
+	u32 Edges;			/**< Captures read */
+	u32 Missed;			/**< Periods dropped, all windows */
+	u32 Windows;			/**< Results published */
+} PulseMeter_Stats;
+
+typedef struct {
+	XTmrCtr *TmrCtrPtr;
+	u32 Window;			/**< Periods per result */
+	u32 LastEdge;			/**< Capture of the last edge */
+	u32 LastRise;			/**< Capture of the last rising edge */
+	u32 LastFall;			/**< Capture of the last falling edge */
+	u32 HaveRise;			/**< A rising edge was seen */
+	u32 FallSeen;			/**< Falling edge since LastRise */
+	u32 Skip;			/**< Current period lost an edge */
+	PulseMeter_Result Acc;		/**< Window being summed, interrupt */
+	std::atomic<u32> Sequence;	/**< Odd while Result is written */
+	PulseMeter_Result Result;	/**< Last complete window */
+	PulseMeter_Stats Stats;
+} PulseMeter;
+
+/************************** Function Prototypes ******************************/
+
+int PulseMeter_Initialize(PulseMeter *MeterPtr, XTmrCtr *TmrCtrPtr,
+			  u32 Window);
+void PulseMeter_Start(PulseMeter *MeterPtr);
+void PulseMeter_Stop(PulseMeter *MeterPtr);
+int PulseMeter_GetResult(PulseMeter *MeterPtr, PulseMeter_Result *ResultPtr,
+			 u32 *SeenPtr);
+void PulseMeter_GetStats(PulseMeter *MeterPtr, PulseMeter_Stats *StatsPtr);
+void PulseMeter_InterruptHandler(void *CallBackRef);
+
+u64 PulseMeter_FrequencyMilliHz(const PulseMeter_Result *ResultPtr);
+u64 PulseMeter_PeriodNs(const PulseMeter_Result *ResultPtr);
+u64 PulseMeter_HighNs(const PulseMeter_Result *ResultPtr);
+u32 PulseMeter_DutyPpm(const PulseMeter_Result *ResultPtr);
+
+#endif	/* end of protection macro */
@@ -0,0 +1,435 @@
+/******************************************************************************
+* PWM generator on the two counters of an AXI Timer
+*
+* See pwm_timer.h for the design.
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xstatus.h"
+#include "xil_exception.h"
+#include "pwm_timer.h"
+
+/************************** Function Prototypes ******************************/
+
+static void PwmTimer_Lock(PwmTimer *PwmPtr);
+static void PwmTimer_Unlock(PwmTimer *PwmPtr);
+static u32 PwmTimer_HighLoad(u32 PeriodClocks, u32 DutyPpm);
+static void PwmTimer_Post(PwmTimer *PwmPtr);
+static void PwmTimer_SetInterrupt(PwmTimer *PwmPtr, u32 Enable);
+static void PwmTimer_RampStep(PwmTimer *PwmPtr);
+
+/*****************************************************************************/
+/**
+*
+* Initializes a PWM generator on an AXI Timer reserved for it and takes
+* over the interrupt handler of the timer instance. The output does not
+* run until PwmTimer_Start.
+*
+* @param	PwmPtr is a pointer to the PWM generator.
+* @param	TmrCtrPtr is a pointer to the initialized XTmrCtr instance.
+*		Its interrupt must be connected to XTmrCtr_InterruptHandler.
+* @param	FrequencyHz is the PWM frequency.
+* @param	DutyPpm is the duty cycle, in parts per million.
+*
+* @return
+*		- XST_SUCCESS if the generator was initialized
+*		- XST_INVALID_PARAM if the period is shorter than
+*		PWM_TIMER_MIN_PERIOD timer clocks
+*
+******************************************************************************/
+int PwmTimer_Initialize(PwmTimer *PwmPtr, XTmrCtr *TmrCtrPtr,
+			u32 FrequencyHz, u32 DutyPpm)
+{
+	PwmPtr->TmrCtrPtr = TmrCtrPtr;
+	PwmPtr->Started = FALSE;
+	PwmPtr->Armed = FALSE;
+	PwmPtr->Pending = FALSE;
+	PwmPtr->Ramp = NULL;
+	PwmPtr->RampSteps = 0U;
+	PwmPtr->RampPeriods = 0U;
+	PwmPtr->RampLoop = FALSE;
+	PwmPtr->RampIndex = 0U;
+	PwmPtr->RampLeft = 0U;
+	PwmPtr->DutyPpm = DutyPpm;
+
+	PwmPtr->Stats.Interrupts = 0U;
+	PwmPtr->Stats.Updates = 0U;
+	PwmPtr->Stats.RampSteps = 0U;
+
+	if (PwmTimer_SetFrequency(PwmPtr, FrequencyHz) != XST_SUCCESS) {
+		return XST_INVALID_PARAM;
+	}
+
+	XTmrCtr_SetHandler(TmrCtrPtr, PwmTimer_InterruptHandler, PwmPtr);
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Loads both counters and starts them together in PWM mode. PWM0 goes high
+* at the end of the first period.
+*
+* @param	PwmPtr is a pointer to the PWM generator.
+*
+* @return	None.
+*
+******************************************************************************/
+void PwmTimer_Start(PwmTimer *PwmPtr)
+{
+	UINTPTR BaseAddress = PwmPtr->TmrCtrPtr->BaseAddress;
+	u32 Csr = XTC_CSR_ENABLE_PWM_MASK | XTC_CSR_EXT_GENERATE_MASK |
+		  XTC_CSR_AUTO_RELOAD_MASK | XTC_CSR_DOWN_COUNT_MASK;
+
+	XTmrCtr_SetLoadReg(BaseAddress, PWM_TIMER_PERIOD_COUNTER,
+			   PwmPtr->PeriodLoad);
+	XTmrCtr_SetLoadReg(BaseAddress, PWM_TIMER_HIGH_COUNTER,
+			   PwmPtr->HighLoad);
+	XTmrCtr_SetControlStatusReg(BaseAddress, PWM_TIMER_PERIOD_COUNTER,
+				    XTC_CSR_LOAD_MASK |
+				    XTC_CSR_INT_OCCURED_MASK);
+	XTmrCtr_SetControlStatusReg(BaseAddress, PWM_TIMER_HIGH_COUNTER,
+				    XTC_CSR_LOAD_MASK |
+				    XTC_CSR_INT_OCCURED_MASK);
+
+	/* ENALL in one TCSR enables both counters at once */
+	XTmrCtr_SetControlStatusReg(BaseAddress, PWM_TIMER_HIGH_COUNTER, Csr);
+	XTmrCtr_SetControlStatusReg(BaseAddress, PWM_TIMER_PERIOD_COUNTER,
+				    Csr | XTC_CSR_ENABLE_ALL_MASK);
+
+	PwmPtr->Pending = FALSE;
+	PwmPtr->Armed = FALSE;
+	PwmPtr->Started = TRUE;
+
+	/* A ramp started before the output runs from the first boundary */
+	if (PwmPtr->RampSteps != 0U) {
+		PwmTimer_Lock(PwmPtr);
+		PwmTimer_SetInterrupt(PwmPtr, TRUE);
+		PwmTimer_Unlock(PwmPtr);
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Stops both counters, which leaves PWM0 low, and any running ramp.
+*
+* @param	PwmPtr is a pointer to the PWM generator.
+*
+* @return	None.
+*
+******************************************************************************/
+void PwmTimer_Stop(PwmTimer *PwmPtr)
+{
+	UINTPTR BaseAddress = PwmPtr->TmrCtrPtr->BaseAddress;
+
+	PwmTimer_Lock(PwmPtr);
+	XTmrCtr_SetControlStatusReg(BaseAddress, PWM_TIMER_PERIOD_COUNTER,
+				    XTC_CSR_INT_OCCURED_MASK);
+	XTmrCtr_SetControlStatusReg(BaseAddress, PWM_TIMER_HIGH_COUNTER,
+				    XTC_CSR_INT_OCCURED_MASK);
+	PwmPtr->Armed = FALSE;
+	PwmPtr->Pending = FALSE;
+	PwmPtr->RampSteps = 0U;
+	PwmTimer_Unlock(PwmPtr);
+
+	PwmPtr->Started = FALSE;
+}
+
+/*****************************************************************************/
+/**
+*
+* Changes the PWM frequency, keeping the duty cycle. The new period starts
+* at the second period boundary from now at the latest.
+*
+* @param	PwmPtr is a pointer to the PWM generator.
+* @param	FrequencyHz is the PWM frequency.
+*
+* @return
+*		- XST_SUCCESS if the frequency was set
+*		- XST_INVALID_PARAM if the period is shorter than
+*		PWM_TIMER_MIN_PERIOD timer clocks, the frequency is left
+*
+******************************************************************************/
+int PwmTimer_SetFrequency(PwmTimer *PwmPtr, u32 FrequencyHz)
+{
+	u32 ClockHz = PwmPtr->TmrCtrPtr->Config.SysClockFreqHz;
+	u32 PeriodClocks;
+
+	if ((FrequencyHz == 0U) ||
+	    ((ClockHz / FrequencyHz) < PWM_TIMER_MIN_PERIOD)) {
+		return XST_INVALID_PARAM;
+	}
+	PeriodClocks = (ClockHz + (FrequencyHz / 2U)) / FrequencyHz;
+
+	PwmTimer_Lock(PwmPtr);
+	PwmPtr->PeriodClocks = PeriodClocks;
+	PwmPtr->PeriodLoad = PeriodClocks - 2U;
+	PwmPtr->HighLoad = PwmTimer_HighLoad(PeriodClocks, PwmPtr->DutyPpm);
+	PwmTimer_Post(PwmPtr);
+	PwmTimer_Unlock(PwmPtr);
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Changes the duty cycle and stops any running ramp. The new high time
+* starts at the second period boundary from now at the latest.
+*
+* @param	PwmPtr is a pointer to the PWM generator.
+* @param	DutyPpm is the duty cycle, in parts per million.
+*
+* @return	None.
+*
+******************************************************************************/
+void PwmTimer_SetDuty(PwmTimer *PwmPtr, u32 DutyPpm)
+{
+	PwmTimer_Lock(PwmPtr);
+	PwmPtr->RampSteps = 0U;
+	PwmPtr->DutyPpm = DutyPpm;
+	PwmPtr->HighLoad = PwmTimer_HighLoad(PwmPtr->PeriodClocks, DutyPpm);
+	PwmTimer_Post(PwmPtr);
+	PwmTimer_Unlock(PwmPtr);
+}
+
+/*****************************************************************************/
+/**
+*
+* Starts a ramp, replacing any running one. Each entry of the table is
+* applied for PeriodsPerStep periods, the first one from the next period
+* boundary on. The table is read by the interrupt handler and must stay
+* valid while the ramp runs.
+*
+* @param	PwmPtr is a pointer to the PWM generator.
+* @param	DutyTable is the table of duty cycles, in parts per million.
+* @param	Steps is the number of entries in the table.
+* @param	PeriodsPerStep is how many periods each entry lasts.
+* @param	Loop is TRUE to start over after the last entry, FALSE to
+*		stop there and keep its duty cycle.
+*
+* @return
+*		- XST_SUCCESS if the ramp was started
+*		- XST_INVALID_PARAM if the table or the step length is empty
+*
+******************************************************************************/
+int PwmTimer_StartRamp(PwmTimer *PwmPtr, const u32 *DutyTable, u32 Steps,
+		       u32 PeriodsPerStep, u32 Loop)
+{
+	if ((DutyTable == NULL) || (Steps == 0U) || (PeriodsPerStep == 0U)) {
+		return XST_INVALID_PARAM;
+	}
+
+	PwmTimer_Lock(PwmPtr);
+	PwmPtr->Ramp = DutyTable;
+	PwmPtr->RampSteps = Steps;
+	PwmPtr->RampPeriods = PeriodsPerStep;
+	PwmPtr->RampLoop = Loop;
+	PwmPtr->RampIndex = 0U;
+	PwmPtr->RampLeft = PeriodsPerStep + 1U;
+	PwmPtr->DutyPpm = DutyTable[0];
+	PwmPtr->HighLoad = PwmTimer_HighLoad(PwmPtr->PeriodClocks,
+					     DutyTable[0]);
+	PwmTimer_Post(PwmPtr);
+	PwmTimer_Unlock(PwmPtr);
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Stops a running ramp at the entry it has reached.
+*
+* @param	PwmPtr is a pointer to the PWM generator.
+*
+* @return	None.
+*
+******************************************************************************/
+void PwmTimer_StopRamp(PwmTimer *PwmPtr)
+{
+	PwmTimer_Lock(PwmPtr);
+	PwmPtr->RampSteps = 0U;
+	PwmTimer_Unlock(PwmPtr);
+}
+
+/*****************************************************************************/
+/**
+*
+* Tells whether the last ramp has finished or been stopped.
+*
+* @param	PwmPtr is a pointer to the PWM generator.
+*
+* @return	TRUE if no ramp runs, FALSE otherwise.
+*
+******************************************************************************/
+int PwmTimer_IsRampDone(PwmTimer *PwmPtr)
+{
+	return (PwmPtr->RampSteps == 0U) ? TRUE : FALSE;
+}
+
+/*****************************************************************************/
+/**
+*
+* Returns the generator statistics.
+*
+* @param	PwmPtr is a pointer to the PWM generator.
+* @param	StatsPtr is where the statistics are returned.
+*
+* @return	None.
+*
+******************************************************************************/
+void PwmTimer_GetStats(PwmTimer *PwmPtr, PwmTimer_Stats *StatsPtr)
+{
+	PwmTimer_Lock(PwmPtr);
+	*StatsPtr = PwmPtr->Stats;
+	PwmTimer_Unlock(PwmPtr);
+}
+
+/*****************************************************************************/
+/**
+*
+* Period interrupt handler, set with XTmrCtr_SetHandler. Runs just after a
+* period boundary: steps the ramp, writes the loads for the next period
+* and turns itself off when nothing is left to apply.
+*
+* @param	CallBackRef is a pointer to the PWM generator.
+* @param	TmrCtrNumber is the counter that interrupted.
+*
+* @return	None.
+*
+******************************************************************************/
+void PwmTimer_InterruptHandler(void *CallBackRef, u8 TmrCtrNumber)
+{
+	PwmTimer *PwmPtr = (PwmTimer *)CallBackRef;
+	UINTPTR BaseAddress = PwmPtr->TmrCtrPtr->BaseAddress;
+
+	if (TmrCtrNumber != PWM_TIMER_PERIOD_COUNTER) {
+		return;
+	}
+
+	PwmPtr->Stats.Interrupts++;
+
+	if ((PwmPtr->RampSteps != 0U) && (--PwmPtr->RampLeft == 0U)) {
+		PwmTimer_RampStep(PwmPtr);
+	}
+
+	if (PwmPtr->Pending) {
+		XTmrCtr_SetLoadReg(BaseAddress, PWM_TIMER_PERIOD_COUNTER,
+				   PwmPtr->PeriodLoad);
+		XTmrCtr_SetLoadReg(BaseAddress, PWM_TIMER_HIGH_COUNTER,
+				   PwmPtr->HighLoad);
+		PwmPtr->Pending = FALSE;
+		PwmPtr->Stats.Updates++;
+	}
+
+	if (PwmPtr->RampSteps == 0U) {
+		PwmTimer_SetInterrupt(PwmPtr, FALSE);
+	}
+}
+
+/*****************************************************************************/
+/*
+ * Masks interrupts around an update from task context, once the counters
+ * run; before that the interrupt handler cannot run
+ */
+static void PwmTimer_Lock(PwmTimer *PwmPtr)
+{
+	if (PwmPtr->Started) {
+		Xil_ExceptionDisable();
+	}
+}
+
+static void PwmTimer_Unlock(PwmTimer *PwmPtr)
+{
+	if (PwmPtr->Started) {
+		Xil_ExceptionEnable();
+	}
+}
+
+/*
+ * TLR1 for a duty cycle. The high time is (TLR1 + 2) clocks; one longer
+ * than the period keeps PWM0 high.
+ */
+static u32 PwmTimer_HighLoad(u32 PeriodClocks, u32 DutyPpm)
+{
+	u64 HighClocks;
+
+	if (DutyPpm >= PWM_TIMER_DUTY_FULL) {
+		return PeriodClocks - 1U;
+	}
+
+	HighClocks = ((u64)PeriodClocks * DutyPpm) / PWM_TIMER_DUTY_FULL;
+	if (HighClocks < 2U) {
+		HighClocks = 2U;
+	}
+
+	return (u32)HighClocks - 2U;
+}
+
+/*
+ * Hands the loads to the interrupt handler for the next boundary. Before
+ * the start they are simply written by PwmTimer_Start.
+ */
+static void PwmTimer_Post(PwmTimer *PwmPtr)
+{
+	if (!PwmPtr->Started) {
+		return;
+	}
+
+	PwmPtr->Pending = TRUE;
+	PwmTimer_SetInterrupt(PwmPtr, TRUE);
+}
+
+/*
+ * Turns the period interrupt on or off. Turning it on also clears the
+ * interrupt status left by earlier periods, in the same store, so the
+ * first interrupt comes at the next boundary with a whole period ahead.
+ */
+static void PwmTimer_SetInterrupt(PwmTimer *PwmPtr, u32 Enable)
+{
+	UINTPTR BaseAddress = PwmPtr->TmrCtrPtr->BaseAddress;
+	u32 Csr;
+
+	if (PwmPtr->Armed == Enable) {
+		return;
+	}
+
+	Csr = XTmrCtr_GetControlStatusReg(BaseAddress,
+					  PWM_TIMER_PERIOD_COUNTER);
+	if (Enable) {
+		Csr |= XTC_CSR_ENABLE_INT_MASK | XTC_CSR_INT_OCCURED_MASK;
+	} else {
+		Csr &= ~(XTC_CSR_ENABLE_INT_MASK | XTC_CSR_INT_OCCURED_MASK);
+	}
+	XTmrCtr_SetControlStatusReg(BaseAddress, PWM_TIMER_PERIOD_COUNTER,
+				    Csr);
+	PwmPtr->Armed = Enable;
+}
+
+/*
+ * Moves the ramp to its next entry, or ends it after the last one
+ */
+static void PwmTimer_RampStep(PwmTimer *PwmPtr)
+{
+	u32 Index = PwmPtr->RampIndex + 1U;
+
+	if (Index == PwmPtr->RampSteps) {
+		if (!PwmPtr->RampLoop) {
+			PwmPtr->RampSteps = 0U;
+			return;
+		}
+		Index = 0U;
+	}
+
+	PwmPtr->RampIndex = Index;
+	PwmPtr->RampLeft = PwmPtr->RampPeriods;
+	PwmPtr->DutyPpm = PwmPtr->Ramp[Index];
+	PwmPtr->HighLoad = PwmTimer_HighLoad(PwmPtr->PeriodClocks,
+					     PwmPtr->DutyPpm);
+	PwmPtr->Pending = TRUE;
+	PwmPtr->Stats.RampSteps++;
+}
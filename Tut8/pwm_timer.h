@@ -0,0 +1,98 @@
+/******************************************************************************
+* PWM generator on the two counters of an AXI Timer
+*
+* Runs both counters of an AXI Timer in PWM mode (PWMA), so the timer
+* drives its PWM0 pin by itself and the CPU does nothing per cycle:
+* counter 0 counts the period and counter 1 the high time, both counting
+* down with GENERATEOUT on, started together with ENALL:
+*
+*	PwmTimer_Initialize(&Pwm, &TmrCtr, 20000, 250000);	20 kHz, 25 %
+*	PwmTimer_Start(&Pwm);
+*	PwmTimer_SetDuty(&Pwm, 500000);
+*	PwmTimer_StartRamp(&Pwm, Fade, FADE_STEPS, 100, TRUE);
+*
+* The hardware samples TLR0 and TLR1 when counter 0 reloads, at the start
+* of each period. The setters never write them directly, where the period
+* boundary could fall between the two stores and give one period of the
+* new frequency with the old high time. They post the new values and turn
+* on the counter 0 interrupt. The interrupt comes just after a boundary
+* and writes both registers well before the next one, so they take effect
+* together at the next boundary. The interrupt is turned off again when
+* there is nothing left to apply, so a steady PWM costs no interrupts.
+*
+* A ramp is a table of duty cycles applied one after the other, each for
+* a number of periods, optionally looping, e.g. an LED fade or a motor
+* soft start. The interrupt steps through it at period boundaries without
+* the task, taking one interrupt per period while a ramp runs.
+*
+* Duty cycles are in parts per million of the period. The high time is at
+* least 2 timer clocks, the hardware minimum, so 0 gives a 2 clock pulse.
+* PWM_TIMER_DUTY_FULL and above keep PWM0 high. The setters are for task
+* context and mask interrupts briefly.
+******************************************************************************/
+
+#ifndef PWM_TIMER_H		/* prevent circular inclusions */
+#define PWM_TIMER_H
+
+/***************************** Include Files *********************************/
+
+#include "xil_types.h"
+#include "xtmrctr.h"
+
+/************************** Constant Definitions *****************************/
+
+/* Counters setting the period and the high time */
+#define PWM_TIMER_PERIOD_COUNTER	0U
+#define PWM_TIMER_HIGH_COUNTER		1U
+
+/* Duty cycle of a PWM0 held high, parts per million */
+#define PWM_TIMER_DUTY_FULL		1000000U
+
+/*
+ * Shortest period, in timer clocks. The interrupt must write the next
+ * values within one period of its boundary.
+ */
+#define PWM_TIMER_MIN_PERIOD		1000U
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 Interrupts;			/**< Period interrupts taken */
+	u32 Updates;			/**< Register updates at a boundary */
+	u32 RampSteps;			/**< Ramp steps applied */
+} PwmTimer_Stats;
+
+typedef struct {
+	XTmrCtr *TmrCtrPtr;
+	u32 Started;			/**< Counters running */
+	u32 Armed;			/**< Period interrupt enabled */
+	u32 PeriodClocks;		/**< Current period */
+	u32 DutyPpm;			/**< Current duty cycle */
+	u32 PeriodLoad;			/**< TLR0 for the period */
+	u32 HighLoad;			/**< TLR1 for the high time */
+	u32 Pending;			/**< Loads waiting for a boundary */
+	const u32 *Ramp;		/**< Duty table of the ramp */
+	u32 RampSteps;			/**< Entries, 0 if no ramp runs */
+	u32 RampPeriods;		/**< Periods per entry */
+	u32 RampLoop;			/**< Start over after the last entry */
+	u32 RampIndex;			/**< Entry applied last */
+	u32 RampLeft;			/**< Boundaries until the next entry */
+	PwmTimer_Stats Stats;
+} PwmTimer;
+
+/************************** Function Prototypes ******************************/
+
+int PwmTimer_Initialize(PwmTimer *PwmPtr, XTmrCtr *TmrCtrPtr,
+			u32 FrequencyHz, u32 DutyPpm);
+void PwmTimer_Start(PwmTimer *PwmPtr);
+void PwmTimer_Stop(PwmTimer *PwmPtr);
+int PwmTimer_SetFrequency(PwmTimer *PwmPtr, u32 FrequencyHz);
+void PwmTimer_SetDuty(PwmTimer *PwmPtr, u32 DutyPpm);
+int PwmTimer_StartRamp(PwmTimer *PwmPtr, const u32 *DutyTable, u32 Steps,
+		       u32 PeriodsPerStep, u32 Loop);
+void PwmTimer_StopRamp(PwmTimer *PwmPtr);
+int PwmTimer_IsRampDone(PwmTimer *PwmPtr);
+void PwmTimer_GetStats(PwmTimer *PwmPtr, PwmTimer_Stats *StatsPtr);
+void PwmTimer_InterruptHandler(void *CallBackRef, u8 TmrCtrNumber);
+
+#endif	/* end of protection macro */
@@ -2,21 +2,180 @@
 #include "xparameters.h"
 #include "xil_types.h"
 #include "xgpio.h"
+#include "xtmrctr.h"
 #include "xil_io.h"
 #include "xil_exception.h"
+#include "xscugic.h"
+#include "xpseudo_asm.h"
+#include "debounce.h"
 //#include <stdio.h>      // for C programs
 #include <iostream>        // for C++ programs
 
 #define AXI_GPIO_Example_ID XPAR_GPIO_0_DEVICE_ID
+#define INTC_DEVICE_ID      XPAR_PS7_SCUGIC_0_DEVICE_ID
+#define GPIO_INTERRUPT_ID   XPAR_FABRIC_AXI_GPIO_0_IP2INTC_IRPT_INTR
+#define TIMER_DEVICE_ID     XPAR_AXI_TIMER_0_DEVICE_ID
+#define TIMER_INTERRUPT_ID  XPAR_FABRIC_AXI_TIMER_0_INTERRUPT_INTR
+#define TIMER_COUNTER_0     0
+
+#define LED_CHANNEL         1
+#define SWITCH_CHANNEL      2
+#define SWITCH_MASK         0x07
+
+/*
+ * Debounce tick: a switch must hold a new position for DEBOUNCE_SAMPLES
+ * ticks, 20 ms, before the LEDs follow it
+ */
+#define DEBOUNCE_TICK_US    5000
+
+/*
+ * Switch input path:
+ * INPUT_INTERRUPT sleeps in WFI. A change on the switch channel interrupt
+ * starts the debounce tick, which runs only until the switches are stable
+ * again, and the LEDs are updated from the debounced edge events.
+ * INPUT_POLLING is the original busy loop, which reads the switches and
+ * rewrites the LEDs continuously. The host simulator builds it as q1_poll
+ * for comparison.
+ */
+#define INPUT_POLLING       0
+#define INPUT_INTERRUPT     1
+
+#ifndef INPUT_MODE
+#define INPUT_MODE          INPUT_INTERRUPT
+#endif
 
 using namespace std;
 
+static XGpio GPIOInstance_Ptr;
+static XTmrCtr TimerInstance;
+static XScuGic InterruptController;
+
+// debounced switches and the edges found by the tick, read by main
+static Debounce Switches;
+static Debounce_Queue SwitchEvents;
+
+u32 SwitchesToLeds(u32 read_switch);
+void Gpio_InterruptHandler(void *CallBackRef);
+void Debounce_TickHandler(void *CallBackRef, u8 TmrCtrNumber);
+int SetUpGpioInterrupt(XGpio *GpioPtr);
+
+/*
+ * Maps the 3-bit switch value to the LED pattern: one LED per binary value,
+ * 000 -> LED 0 up to 111 -> LED 7
+ */
+u32 SwitchesToLeds(u32 read_switch)
+{
+    return 1U << (read_switch & SWITCH_MASK);
+}
+
+/*
+ * GPIO interrupt handler: any change on the switch channel sets its bit in
+ * the interrupt status register. The channel interrupt is turned off and
+ * the debounce tick started; the tick turns it back on once the switches
+ * have settled, so contact bounce costs no further interrupts.
+ */
+void Gpio_InterruptHandler(void *CallBackRef)
+{
+    XGpio *GpioPtr = (XGpio *)CallBackRef;
+
+    if ((XGpio_InterruptGetStatus(GpioPtr) & XGPIO_IR_CH2_MASK) == 0) {
+        return;
+    }
+    XGpio_InterruptDisable(GpioPtr, XGPIO_IR_CH2_MASK);
+    XGpio_InterruptClear(GpioPtr, XGPIO_IR_CH2_MASK);
+
+    XTmrCtr_Start(&TimerInstance, TIMER_COUNTER_0);
+}
+
+/*
+ * Debounce tick handler: samples all switches in one read and posts the
+ * debounced edges. When nothing is left to count the tick stops and the
+ * GPIO interrupt is re-armed; a change that slipped in before re-arming is
+ * caught by the final read, which keeps the tick going.
+ */
+void Debounce_TickHandler(void *CallBackRef, u8 TmrCtrNumber)
+{
+    XTmrCtr *TmrCtrPtr = (XTmrCtr *)CallBackRef;
+    u32 Changed;
+
+    Changed = Debounce_Sample(&Switches,
+                              XGpio_DiscreteRead(&GPIOInstance_Ptr,
+                                                 SWITCH_CHANNEL));
+    if (Changed) {
+        Debounce_Post(&SwitchEvents, Changed, Switches.State);
+    }
+
+    if (Debounce_IsBusy(&Switches)) {
+        return;
+    }
+
+    // drop the status the bounce left behind, it is toggle-on-write
+    XTmrCtr_Stop(TmrCtrPtr, TmrCtrNumber);
+    if (XGpio_InterruptGetStatus(&GPIOInstance_Ptr) & XGPIO_IR_CH2_MASK) {
+        XGpio_InterruptClear(&GPIOInstance_Ptr, XGPIO_IR_CH2_MASK);
+    }
+    XGpio_InterruptEnable(&GPIOInstance_Ptr, XGPIO_IR_CH2_MASK);
+    if (XGpio_DiscreteRead(&GPIOInstance_Ptr, SWITCH_CHANNEL) !=
+        Switches.State) {
+        XGpio_InterruptDisable(&GPIOInstance_Ptr, XGPIO_IR_CH2_MASK);
+        XTmrCtr_Start(TmrCtrPtr, TmrCtrNumber);
+    }
+}
+
+/*
+ * Connects the GPIO and debounce timer interrupts through the SCUGIC and
+ * enables the GPIO interrupt for the switch channel only
+ */
+int SetUpGpioInterrupt(XGpio *GpioPtr)
+{
+    XScuGic_Config *GicConfig;
+    int xStatus;
+
+    GicConfig = XScuGic_LookupConfig(INTC_DEVICE_ID);
+    if (GicConfig == NULL) {
+        return XST_FAILURE;
+    }
+
+    xStatus = XScuGic_CfgInitialize(&InterruptController, GicConfig,
+                                    GicConfig->CpuBaseAddress);
+    if (xStatus != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+
+    Xil_ExceptionInit();
+    Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT,
+                                 (Xil_ExceptionHandler)XScuGic_InterruptHandler,
+                                 &InterruptController);
+
+    xStatus = XScuGic_Connect(&InterruptController, GPIO_INTERRUPT_ID,
+                              (Xil_ExceptionHandler)Gpio_InterruptHandler,
+                              GpioPtr);
+    if (xStatus != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+
+    xStatus = XScuGic_Connect(&InterruptController, TIMER_INTERRUPT_ID,
+                              (Xil_ExceptionHandler)XTmrCtr_InterruptHandler,
+                              &TimerInstance);
+    if (xStatus != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+
+    XGpio_InterruptEnable(GpioPtr, XGPIO_IR_CH2_MASK);
+    XGpio_InterruptGlobalEnable(GpioPtr);
+    XScuGic_Enable(&InterruptController, GPIO_INTERRUPT_ID);
+    XScuGic_Enable(&InterruptController, TIMER_INTERRUPT_ID);
+
+    Xil_ExceptionEnable();
+
+    return XST_SUCCESS;
+}
+
 int main()
 {
     // step 2.1: variables
-    static XGpio GPIOInstance_Ptr;
     int xStatus;
-    
+
     //Step-2.2: AXI GPIO Initialization
     xStatus = XGpio_Initialize(&GPIOInstance_Ptr, AXI_GPIO_Example_ID);
     if(xStatus != XST_SUCCESS)
@@ -24,48 +183,71 @@ int main()
         cout << "GPIO A Initialization FAILED" << endl;
         return 1;
     }
-    
+
     //Step-2.3: AXI GPIO Set the Direction
-    //channel 0 to connect to the LEDs
-    XGpio_SetDataDirection(&GPIOInstance_Ptr, 1, 0x00);
-    
-    // channel 1 to be connected to the switches (3 bits)
-    XGpio_SetDataDirection(&GPIOInstance_Ptr, 0, 0x07);
-    
+    //channel 1 to connect to the LEDs
+    XGpio_SetDataDirection(&GPIOInstance_Ptr, LED_CHANNEL, 0x00);
+
+    // channel 2 to be connected to the switches (3 bits)
+    XGpio_SetDataDirection(&GPIOInstance_Ptr, SWITCH_CHANNEL, SWITCH_MASK);
+
+#if INPUT_MODE == INPUT_INTERRUPT
+    // debounce tick on counter 0, started and stopped by the handlers
+    xStatus = XTmrCtr_Initialize(&TimerInstance, TIMER_DEVICE_ID);
+    if(xStatus != XST_SUCCESS)
+    {
+        cout << "TIMER INIT FAILED" << endl;
+        return 1;
+    }
+    XTmrCtr_SetHandler(&TimerInstance, Debounce_TickHandler, &TimerInstance);
+    XTmrCtr_SetOptions(&TimerInstance, TIMER_COUNTER_0,
+                       XTC_INT_MODE_OPTION | XTC_AUTO_RELOAD_OPTION |
+                       XTC_DOWN_COUNT_OPTION);
+    XTmrCtr_SetResetValue(&TimerInstance, TIMER_COUNTER_0,
+                          (u32)((u64)TimerInstance.Config.SysClockFreqHz *
+                                DEBOUNCE_TICK_US / 1000000) - 2);
+
+    // show the initial switch position, later changes come as events
+    Debounce_Init(&Switches, XGpio_DiscreteRead(&GPIOInstance_Ptr,
+                                                SWITCH_CHANNEL));
+    Debounce_QueueInit(&SwitchEvents);
+    XGpio_DiscreteWrite(&GPIOInstance_Ptr, LED_CHANNEL,
+                        SwitchesToLeds(Switches.State));
+
+    xStatus = SetUpGpioInterrupt(&GPIOInstance_Ptr);
+    if(xStatus != XST_SUCCESS)
+    {
+        cout << "GPIO interrupt setup FAILED" << endl;
+        return 1;
+    }
+
+    // the core sleeps until a debounced switch edge arrives. IRQs are
+    // masked around the check so an edge posted just before the WFI still
+    // wakes it: the core leaves WFI on a pending IRQ even while masked
     while (1) {
-        u32 read_switch = XGpio_DiscreteRead(GPIOInstance_Ptr, 1);
-        
-        switch(read_switch)
-        {
-            case 0:  // Binary 000 -> BCD 0000
-                XGpio_DiscreteWrite(GPIOInstance_Ptr, 1, 0x01);
-                break;
-            case 1:  // Binary 001 -> BCD 0001
-                XGpio_DiscreteWrite(GPIOInstance_Ptr, 1, 0x02);
-                break;
-            case 2:  // Binary 010 -> BCD 0010
-                XGpio_DiscreteWrite(GPIOInstance_Ptr, 1, 0x04);
-                break;
-            case 3:  // Binary 011 -> BCD 0011
-                XGpio_DiscreteWrite(GPIOInstance_Ptr, 1, 0x08);
-                break;
-            case 4:  // Binary 100 -> BCD 0100
-                XGpio_DiscreteWrite(GPIOInstance_Ptr, 1, 0x10);
-                break;
-            case 5:  // Binary 101 -> BCD 0101
-                XGpio_DiscreteWrite(GPIOInstance_Ptr, 1, 0x20);
-                break;
-            case 6:  // Binary 110 -> BCD 0110
-                XGpio_DiscreteWrite(GPIOInstance_Ptr, 1, 0x40);
-                break;
-            case 7:  // Binary 111 -> BCD 0111
-                XGpio_DiscreteWrite(GPIOInstance_Ptr, 1, 0x80);
-                break;
-            default:
-                XGpio_DiscreteWrite(GPIOInstance_Ptr, 1, 0x00);
-                break;
+        Debounce_Event Event;
+
+        Xil_ExceptionDisable();
+        if (Debounce_Pending(&SwitchEvents) == 0) {
+            wfi();
+        }
+        Xil_ExceptionEnable();
+
+        while (Debounce_Get(&SwitchEvents, &Event)) {
+            if (Event.Changed & SWITCH_MASK) {
+                XGpio_DiscreteWrite(&GPIOInstance_Ptr, LED_CHANNEL,
+                                    SwitchesToLeds(Event.State));
+            }
         }
     }
-    
+#else
+    while (1) {
+        u32 read_switch = XGpio_DiscreteRead(&GPIOInstance_Ptr, SWITCH_CHANNEL);
+
+        XGpio_DiscreteWrite(&GPIOInstance_Ptr, LED_CHANNEL,
+                            SwitchesToLeds(read_switch));
+    }
+#endif
+
     return 0;
 }
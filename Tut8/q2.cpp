@@ -1,62 +1,181 @@
 #include "stdbool.h"
 #include "xparameters.h"
 #include "xil_types.h"
-#include "xgpio.h"
 #include "xil_io.h"
 #include "xil_exception.h"
 #include "xtmrctr.h"
+#include "xscugic.h"
+#include "xpseudo_asm.h"
+#include "pulse_meter.h"
+#include "pwm_timer.h"
 #include <iostream>
+#include <iomanip>
 
-#define CHANNEL0 0
-#define CHANNEL1 1
-#define AXI_GPIO_Example_ID XPAR_GPIO_0_DEVICE_ID
+#define INTC_DEVICE_ID          XPAR_PS7_SCUGIC_0_DEVICE_ID
+#define PWM_INTERRUPT_ID        XPAR_FABRIC_TMRCTR_0_VEC_ID
+#define CAPTURE_TIMER_ID        XPAR_TMRCTR_1_DEVICE_ID
+#define CAPTURE_INTERRUPT_ID    XPAR_FABRIC_TMRCTR_1_VEC_ID
+
+/*
+ * The LED is driven by the PWM0 pin of the first timer, at the genout
+ * rate of the original design: 25000 clocks at 100 MHz. It fades in and
+ * out with a gamma corrected ramp, 32 steps each way of 125 periods,
+ * two seconds for the whole cycle.
+ */
+#define PWM_FREQUENCY_HZ        4000
+#define FADE_HALF_STEPS         32
+#define FADE_STEPS              (2 * FADE_HALF_STEPS)
+#define FADE_PERIODS_PER_STEP   125
+
+/*
+ * PWM0 is measured by the second AXI timer, whose capture inputs are wired
+ * to it in Vivado (CAPTURETRIG1 active low), averaging over a quarter
+ * second of periods
+ */
+#define MEASURE_WINDOW          1000
 
 using namespace std;
 
+static XTmrCtr TimerInstance;
+static XTmrCtr CaptureTimer;
+static XScuGic InterruptController;
+static PwmTimer LedPwm;
+static PulseMeter LedMeter;
+static u32 FadeTable[FADE_STEPS];
+
+void BuildFadeTable(void);
+int SetUpInterrupts(PulseMeter *MeterPtr);
+void PrintMeasurement(const PulseMeter_Result *ResultPtr);
+
+/*
+ * Duty cycles of the fade, in ppm: squares of the step for an even
+ * perceived brightness, up and back down. The top stays just short of
+ * fully on, so every period keeps its edges for the meter.
+ */
+void BuildFadeTable(void)
+{
+    for (u32 Step = 0; Step < FADE_HALF_STEPS; Step++) {
+        u32 Duty = (u32)(((u64)Step * Step * PWM_TIMER_DUTY_FULL) /
+                         (FADE_HALF_STEPS * FADE_HALF_STEPS));
+
+        FadeTable[Step] = Duty;
+        FadeTable[FADE_STEPS - 1 - Step] = Duty;
+    }
+}
+
+/*
+ * Connects the PWM timer interrupt to the driver, which calls the PWM
+ * handler, and the capture timer interrupt to the meter, through the
+ * SCUGIC
+ */
+int SetUpInterrupts(PulseMeter *MeterPtr)
+{
+    XScuGic_Config *GicConfig;
+    int xStatus;
+
+    GicConfig = XScuGic_LookupConfig(INTC_DEVICE_ID);
+    if (GicConfig == NULL) {
+        return XST_FAILURE;
+    }
+
+    xStatus = XScuGic_CfgInitialize(&InterruptController, GicConfig,
+                                    GicConfig->CpuBaseAddress);
+    if (xStatus != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+
+    Xil_ExceptionInit();
+    Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT,
+                                 (Xil_ExceptionHandler)XScuGic_InterruptHandler,
+                                 &InterruptController);
+
+    xStatus = XScuGic_Connect(&InterruptController, PWM_INTERRUPT_ID,
+                              (Xil_ExceptionHandler)XTmrCtr_InterruptHandler,
+                              &TimerInstance);
+    if (xStatus != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+    XScuGic_Enable(&InterruptController, PWM_INTERRUPT_ID);
+
+    xStatus = XScuGic_Connect(&InterruptController, CAPTURE_INTERRUPT_ID,
+                              (Xil_ExceptionHandler)PulseMeter_InterruptHandler,
+                              MeterPtr);
+    if (xStatus != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+    XScuGic_Enable(&InterruptController, CAPTURE_INTERRUPT_ID);
+
+    Xil_ExceptionEnable();
+
+    return XST_SUCCESS;
+}
+
+/*
+ * Prints the averages of one window: frequency, period, high time and duty
+ */
+void PrintMeasurement(const PulseMeter_Result *ResultPtr)
+{
+    u64 MilliHz = PulseMeter_FrequencyMilliHz(ResultPtr);
+    u32 DutyPpm = PulseMeter_DutyPpm(ResultPtr);
+
+    cout << "pwm0: " << MilliHz / 1000 << "." << setfill('0') << setw(3)
+         << MilliHz % 1000 << " Hz, period "
+         << PulseMeter_PeriodNs(ResultPtr) << " ns (min "
+         << ResultPtr->MinPeriod << ", max " << ResultPtr->MaxPeriod
+         << " clocks), high " << PulseMeter_HighNs(ResultPtr)
+         << " ns, duty " << DutyPpm / 10000 << "." << setw(4)
+         << DutyPpm % 10000 << " %, missed " << ResultPtr->Missed << endl;
+}
+
 int main()
 {
     // step 2.1: variables
-    XTmrCtr TimerInstancePtr;
-    int xStatus1;
-    
-    static XGpio GPIOInstance_Ptr;
     int xStatus2;
     
-    //Step-2.2: AXI GPIO Initialization
-    xStatus1= XGpio_Initialize(&GPIOInstance_Ptr, AXI_GPIO_Example_ID);
-    if(xStatus1 != XST_SUCCESS)
+    xStatus2 = XTmrCtr_Initialize(&TimerInstance, XPAR_AXI_TIMER_0_DEVICE_ID);
+    if(xStatus2 != XST_SUCCESS)
     {
-        cout << "GPIO A Initialization FAILED" << endl;
+        cout << "TIMER INIT FAILED" << endl;
         return 1;
     }
     
-    // pin 0: input pin to be connected to the generate out signal
-    XGpio_SetDataDirection(&Gpio, CHANNEL0, 0x01);
-    
-    // pin 0 to be connected to the LED
-    XGpio_SetDataDirection(&Gpio, CHANNEL1, 0x00);
-    XTmrCtr_SetResetValue(&TimerInstancePtr, 0, 0x61A6);
-    
-    // alternative to set the option
-    //XTmrCtr_SetOptions(&TimerInstancePtr, XPAR_AXI_TIMER_0_DEVICE_ID, XTC_GENERATE_MODE_OPTION);
-    
-    u32 TmrCtr_Ptr = (u32*) XPAR_TMRCTR_0_BASEADDR; //defined in xparameter header file
-    int offset = 0; //offset is set to 0 to get access to the TCSR0
-    *(TmrCtr_Ptr + offset) = 0x000B6; //write to the TCSR0
-    // (timer/counter control/status register of the timer 0)
+    // both counters of the timer make the LED waveform in PWM mode, so
+    // the CPU no longer copies genout to the LED
+    BuildFadeTable();
+    PwmTimer_Initialize(&LedPwm, &TimerInstance, PWM_FREQUENCY_HZ, 0);
     
+    // PWM0 is timed by the capture timer, the CPU sleeps in between
+    xStatus2 = XTmrCtr_Initialize(&CaptureTimer, CAPTURE_TIMER_ID);
+    if(xStatus2 != XST_SUCCESS)
+    {
+        cout << "CAPTURE TIMER INIT FAILED" << endl;
+        return 1;
+    }
+    PulseMeter_Initialize(&LedMeter, &CaptureTimer, MEASURE_WINDOW);
+    if (SetUpInterrupts(&LedMeter) != XST_SUCCESS)
+    {
+        cout << "Interrupt setup FAILED" << endl;
+        return 1;
+    }
+    PulseMeter_Start(&LedMeter);
+
+    // the fade runs from the PWM interrupt, on its own from here on
+    PwmTimer_Start(&LedPwm);
+    PwmTimer_StartRamp(&LedPwm, FadeTable, FADE_STEPS, FADE_PERIODS_PER_STEP,
+                       TRUE);
+
+    u32 Seen = 0;
+
     while (1) {
-        XTmrCtr_Start(&TimerInstancePtr, 0); //start the timer
-        
-        //genout signal must be connected to the GPIO input pin
-        //in the hardware development phase in Vivado
-        u32 ReadGenOut = XGpio_DiscreteRead(&GPIOInstance_Ptr, CHANNEL1);
-        
-        if (ReadGenOut)
-            XGpio_DiscreteWrite(&GPIOInstance_Ptr, CHANNEL2, 1);
-        else
-            XGpio_DiscreteWrite(&GPIOInstance_Ptr, CHANNEL2, 0);
+        PulseMeter_Result Result;
+
+        // sleep through the interrupts until a measurement completes
+        wfi();
+
+        if (PulseMeter_GetResult(&LedMeter, &Result, &Seen)) {
+            PrintMeasurement(&Result);
+        }
     }
-    
+
     return 0;
 }
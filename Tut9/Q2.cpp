@@ -5,11 +5,15 @@
 #include "xil_io.h"
 #include "xil_exception.h"
 #include "xtmrctr.h"
+#include "axi_timer_regs.h"
 #include <iostream>
 
 using namespace std;
 
-// define Timer0 0
+#define TIMER0 0
+
+// counter 0 of the AXI timer, register by register
+using Timer0 = AxiTimer_Counter<XPAR_TMRCTR_0_BASEADDR, TIMER0>;
 
 int main()
 {
@@ -25,14 +29,11 @@ int main()
     }
     // reset value
     //count up configuration
-    XTmrCtr_SetResetValue(&TimerInstancePtr, Timer0, 0xFFD23941);
-    
-    u32  TmrCtr_Ptr = (u32*) XPAR_TMRCTR_0_BASEADDR ; //defined in xparameter header file
+    XTmrCtr_SetResetValue(&TimerInstancePtr, TIMER0, 0xFFD23941);
     
-    int offset = 0 ; //offset is set to 0 to get access to the TCSR0
     //write to the TCSR0,
-    //activate GENT0, and load bit
-    *(TmrCtr_Ptr +offset) = 0x0024 ;
+    //activate GENT0, and load bit (0x0024), one store
+    Timer0::TCSR::Write<TCSR_GENT | TCSR_LOAD>();
     
     //start the timer
     XTmrCtr_Start(&TimerInstancePtr, TIMER0);